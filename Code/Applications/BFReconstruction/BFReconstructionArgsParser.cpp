@@ -47,6 +47,8 @@
 #include "MBIRLib/Common/allocate.h"
 #include "MBIRLib/IOFilters/MRCHeader.h"
 #include "MBIRLib/IOFilters/MRCReader.h"
+#include "MBIRLib/IOFilters/ReconstructionCheckpoint.h"
+#include "MBIRLib/IOFilters/ReconstructionSnapshotWriter.h"
 #include "MBIRLib/Reconstruction/ReconstructionConstants.h"
 #include "MBIRLib/BrightField/BFConstants.h"
 
@@ -115,7 +117,11 @@ int parseUnknownArray(const std::string& values, const char* format, std::vector
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
-BFReconstructionArgsParser::BFReconstructionArgsParser()
+BFReconstructionArgsParser::BFReconstructionArgsParser() :
+  m_PlanOnly(false),
+  m_Workers(1),
+  m_Rank(-1),
+  m_SocketDirectory("")
 {
 
 }
@@ -182,6 +188,9 @@ int BFReconstructionArgsParser::parseArguments(int argc, char** argv, BFMultiRes
   TCLAP::ValueArg<double> bfOffset("", "bf_offset", "value of offset in the BF data", false, 0.0, "0");
   cmd.add(bfOffset);
 
+  TCLAP::SwitchArg implicitWeights("", "implicit_weights", "Recompute the measurement weights from the counts instead of storing them", false);
+  cmd.add(implicitWeights);
+
   TCLAP::SwitchArg interpolateInitialRecontruction ("", "interpolate_initial_recon", "Interpolate Initial Reconstruction Value", false);
   cmd.add(interpolateInitialRecontruction);
   TCLAP::ValueArg<int> outerIterations("", "outer_iterations", "Outer Iterations to use", false, 600, "600");
@@ -196,10 +205,22 @@ int BFReconstructionArgsParser::parseArguments(int argc, char** argv, BFMultiRes
   cmd.add(defaultVariance);
   TCLAP::ValueArg<double> defaultInitialRecon("", "default_recon_value", "Default initial value of reconstruction", false, 0.0, "0");
   cmd.add(defaultInitialRecon);
+  TCLAP::ValueArg<int> sirtIterations("", "sirt_iterations", "Number of SIRT iterations used to initialize the coarsest resolution", false, 0, "0");
+  cmd.add(sirtIterations);
   TCLAP::SwitchArg extendObject("", "extend_object", "To extend the object or not", false);
   cmd.add(extendObject);
   TCLAP::SwitchArg m_DeleteTempFiles ("", "delete_tmp_files", "Delete all the Temp files that are created", false);
   cmd.add(m_DeleteTempFiles);
+  TCLAP::SwitchArg writeIntermediateFiles ("", "write_intermediate_files", "Write the volume and nuisance parameters of every resolution to the temp directory", false);
+  cmd.add(writeIntermediateFiles);
+  TCLAP::ValueArg<std::string> snapshotPolicy("", "snapshot_policy", "Which intermediate volumes to write for display: none, every, iterations, seconds or latest", false, "every", "every");
+  cmd.add(snapshotPolicy);
+  TCLAP::ValueArg<double> snapshotInterval("", "snapshot_interval", "Iterations (iterations policy) or seconds (seconds policy) between intermediate volumes", false, 1.0, "1");
+  cmd.add(snapshotInterval);
+  TCLAP::ValueArg<double> checkpointInterval("", "checkpoint_interval", "Seconds between checkpoints of the reconstruction state. 0 only writes one when cancelled, -1 disables them", false, -1.0, "-1");
+  cmd.add(checkpointInterval);
+  TCLAP::ValueArg<std::string> resumeFile("", "resume", "Checkpoint to restart the reconstruction from", false, "", "");
+  cmd.add(resumeFile);
 
 
   TCLAP::ValueArg<std::string> initialReconstructionPath("i", "initial_recon_file", "Initial Reconstruction to initialize algorithm", false, "", "");
@@ -226,6 +247,23 @@ int BFReconstructionArgsParser::parseArguments(int argc, char** argv, BFMultiRes
   TCLAP::ValueArg<std::string> viewMask("", "exclude_views", "Comma separated list of tilts to exclude by index", false, "", "");
   cmd.add(viewMask);
 
+  TCLAP::ValueArg<double> memoryBudget("", "memory_budget", "Memory in GB the reconstruction may use. 0 does not limit it", false, 0.0, "0");
+  cmd.add(memoryBudget);
+  TCLAP::ValueArg<int> ySlabs("", "y_slabs", "Reconstruct the detector rows in this many slabs, one at a time. 0 picks the fewest that fit the memory budget", false, 1, "1");
+  cmd.add(ySlabs);
+  TCLAP::ValueArg<int> workers("", "workers", "Number of processes that each reconstruct one Y slab and talk over local sockets", false, 1, "1");
+  cmd.add(workers);
+  TCLAP::ValueArg<int> rank("", "rank", "Rank of this worker. Without it the first worker starts the others", false, -1, "-1");
+  cmd.add(rank);
+  TCLAP::ValueArg<std::string> socketDir("", "socket_dir", "Directory for the sockets of the workers. Defaults to the temp directory", false, "", "");
+  cmd.add(socketDir);
+  TCLAP::ValueArg<std::string> memoryReport("", "memory_report", "JSON file the memory used by every named array and resolution is written to", false, "", "");
+  cmd.add(memoryReport);
+  TCLAP::SwitchArg planOnly("", "plan", "Print the memory every resolution needs and exit without reconstructing", false);
+  cmd.add(planOnly);
+  TCLAP::SwitchArg trackCost("", "track_cost", "Track the cost through the voxel updates and warn when it increases", false);
+  cmd.add(trackCost);
+
 
   if(argc < 2)
   {
@@ -262,6 +300,7 @@ int BFReconstructionArgsParser::parseArguments(int argc, char** argv, BFMultiRes
     m_MultiResSOC->setBraggThreshold(braggThreshold.getValue());
     m_MultiResSOC->setBraggDelta(braggDelta.getValue());
     m_MultiResSOC->setBfOffset(bfOffset.getValue());
+    m_MultiResSOC->setImplicitWeights(implicitWeights.getValue());
     m_MultiResSOC->setStopThreshold(stopThreshold.getValue());
     m_MultiResSOC->setOuterIterations(outerIterations.getValue());
     m_MultiResSOC->setInnerIterations(innerIterations.getValue());
@@ -277,11 +316,49 @@ int BFReconstructionArgsParser::parseArguments(int argc, char** argv, BFMultiRes
     //    m_MultiResSOC->setExtendObject(extendObject.getValue());
     m_MultiResSOC->setDefaultVariance(defaultVariance.getValue());
     m_MultiResSOC->setInitialReconstructionValue(defaultInitialRecon.getValue());
+    m_MultiResSOC->setSIRTIterations(sirtIterations.getValue());
 
     m_MultiResSOC->setInterpolateInitialReconstruction(interpolateInitialRecontruction.getValue());
     m_MultiResSOC->setDeleteTempFiles(m_DeleteTempFiles.getValue());
+    m_MultiResSOC->setWriteIntermediateFiles(writeIntermediateFiles.getValue());
+    int policy = ReconstructionSnapshotWriter::PolicyFromString(snapshotPolicy.getValue());
+    if(policy < 0)
+    {
+      std::cout << "Unknown snapshot policy '" << snapshotPolicy.getValue() << "'. It should be one of none, every, iterations, seconds or latest" << std::endl;
+      return -1;
+    }
+    m_MultiResSOC->setSnapshotPolicy(policy);
+    if(memoryBudget.getValue() < 0.0)
+    {
+      std::cout << "The memory budget can not be negative" << std::endl;
+      return -1;
+    }
+    m_MultiResSOC->setMemoryBudget(static_cast<uint64_t>(memoryBudget.getValue() * 1073741824.0));
+    m_MultiResSOC->setYSlabs(ySlabs.getValue());
+    m_MultiResSOC->setMemoryReportFile(memoryReport.getValue());
+    m_PlanOnly = planOnly.getValue();
+    if(workers.getValue() < 1 || rank.getValue() >= workers.getValue())
+    {
+      std::cout << "There must be at least one worker and the rank must be below the number of workers" << std::endl;
+      return -1;
+    }
+    m_Workers = workers.getValue();
+    m_Rank = rank.getValue();
+    m_SocketDirectory = socketDir.getValue();
+    m_MultiResSOC->setSnapshotInterval(snapshotInterval.getValue());
+    if((checkpointInterval.getValue() >= 0 || resumeFile.getValue().empty() == false) && ReconstructionCheckpoint::IsSupported() == false)
+    {
+      std::cout << "Checkpoints need HDF5 support which this build does not have" << std::endl;
+      return -1;
+    }
+    m_MultiResSOC->setCheckpointInterval(checkpointInterval.getValue());
+    m_MultiResSOC->setResumeFile(MXADir::toNativeSeparators(resumeFile.getValue()));
     AdvancedParametersPtr advParams = AdvancedParametersPtr(new AdvancedParameters);
     BFReconstructionEngine::InitializeAdvancedParams(advParams);
+    if(trackCost.getValue() == true)
+    {
+      advParams->TRACK_COST = 1;
+    }
     m_MultiResSOC->setAdvParams(advParams);
 
     int subvolumeValues[6];
@@ -384,6 +461,7 @@ void BFReconstructionArgsParser::printInputs(TomoInputsPtr inputs, std::ostream&
   PRINT_VAR(out, inputs, extendObject);
   PRINT_VAR(out, inputs, interpolateFactor);
   PRINT_VAR(out, inputs, defaultInitialRecon);
+  PRINT_VAR(out, inputs, NumSIRTIter);
   PRINT_VAR(out, inputs, sinoFile);
   PRINT_VAR(out, inputs, initialReconFile);
   PRINT_VAR(out, inputs, gainsInputFile);
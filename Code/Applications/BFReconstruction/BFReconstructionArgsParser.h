@@ -56,6 +56,16 @@ class BFReconstructionArgsParser
 
     void printInputs(TomoInputsPtr inputs, std::ostream& out);
 
+    /* Only print the memory plan instead of reconstructing (--plan) */
+    MXA_INSTANCE_PROPERTY(bool, PlanOnly)
+
+    /* Number of worker processes that share the reconstruction (--workers),
+     * the rank of this one or -1 to start the others (--rank) and where their
+     * sockets go (--socket_dir) */
+    MXA_INSTANCE_PROPERTY(int, Workers)
+    MXA_INSTANCE_PROPERTY(int, Rank)
+    MXA_INSTANCE_STRING_PROPERTY(SocketDirectory)
+
   private:
     uint64_t startm;
     uint64_t stopm;
@@ -35,6 +35,13 @@
 
 #include <string>
 #include <iostream>
+#include <vector>
+
+#if !defined (_MSC_VER)
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 
 // MXA Includes
@@ -42,12 +49,32 @@
 #include "MXA/Utilities/MXAFileInfo.h"
 
 #include "MBIRLib/MBIRLibVersion.h"
+#include "MBIRLib/Common/LocalSocketTransport.h"
 #include "MBIRLib/Reconstruction/ReconstructionStructures.h"
 #include "MBIRLib/BrightField/BFReconstructionEngine.h"
 #include "MBIRLib/BrightField/BFMultiResolutionReconstruction.h"
 #include "BFReconstructionArgsParser.h"
 
 
+#if !defined (_MSC_VER)
+/**
+ * @brief Stops the workers this process started and waits for them so none
+ * are left behind when the reconstruction can not start
+ */
+void stopWorkers(const std::vector<pid_t>& children)
+{
+  for (size_t i = 0; i < children.size(); ++i)
+  {
+    ::kill(children[i], SIGTERM);
+  }
+  for (size_t i = 0; i < children.size(); ++i)
+  {
+    int childStatus = 0;
+    ::waitpid(children[i], &childStatus, 0);
+  }
+}
+#endif
+
 int main(int argc, char** argv)
 {
   std::cout << "Starting MBIR Reconstruction Version " << MBIRLib::Version::Complete() << std::endl;
@@ -64,6 +91,19 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
+  // A dry run only reports whether the reconstruction fits
+  if(argParser.getPlanOnly() == true)
+  {
+    MemoryPlanner::Pointer plan = engine->planMemory();
+    if(NULL == plan.get())
+    {
+      std::cout << "Could not plan the memory of '" << engine->getInputFile() << "'. Only MRC files can be planned." << std::endl;
+      return EXIT_FAILURE;
+    }
+    plan->printPlan(std::cout);
+    return (plan->getFeasible() == true) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
 
 
 #if 0
@@ -95,16 +135,78 @@ int main(int argc, char** argv)
 
   std::stringstream ss;
 
+  // A distributed reconstruction runs one worker per Y slab. Unless the
+  // workers were started by hand with --rank the first one starts the others.
+#if !defined (_MSC_VER)
+  std::vector<pid_t> children;
+#endif
+  if(argParser.getWorkers() > 1)
+  {
+#if defined (_MSC_VER)
+    std::cout << "Distributed reconstructions are not available on Windows" << std::endl;
+    return EXIT_FAILURE;
+#else
+    int rank = argParser.getRank();
+    if(rank < 0)
+    {
+      rank = 0;
+      for (int r = 1; r < argParser.getWorkers(); ++r)
+      {
+        std::cout.flush();
+        pid_t pid = fork();
+        if(pid < 0)
+        {
+          std::cout << "Could not start worker " << r << std::endl;
+          stopWorkers(children);
+          return EXIT_FAILURE;
+        }
+        if(pid == 0)
+        {
+          rank = r;
+          children.clear();
+          break;
+        }
+        children.push_back(pid);
+      }
+    }
+    LocalSocketTransport::Pointer transport = LocalSocketTransport::New();
+    transport->setSocketDirectory(argParser.getSocketDirectory().empty() ? parentPath : argParser.getSocketDirectory());
+    transport->setRankAndSize(rank, argParser.getWorkers());
+    if(transport->connect() < 0)
+    {
+      std::cout << "Error connecting the workers: " << transport->getErrorMessage() << std::endl;
+      stopWorkers(children);
+      return EXIT_FAILURE;
+    }
+    engine->setTransport(transport);
+#endif
+  }
 
   // Run the reconstruction
   engine->execute();
+  int status = EXIT_SUCCESS;
   if(engine->getErrorCondition() < 0)
   {
     std::cout << "Error Reconstructing the Data" << std::endl;
-    return EXIT_FAILURE;
+    status = EXIT_FAILURE;
   }
-  std::cout << "Completed MBIR Reconstruction Run" << std::endl;
+  engine->setTransport(SlabTransport::NullPointer());
 
-  return EXIT_SUCCESS;
+#if !defined (_MSC_VER)
+  // The first worker only succeeds if all the others did
+  for (size_t i = 0; i < children.size(); ++i)
+  {
+    int childStatus = 0;
+    if(waitpid(children[i], &childStatus, 0) < 0 || WIFEXITED(childStatus) == 0 || WEXITSTATUS(childStatus) != 0)
+    {
+      status = EXIT_FAILURE;
+    }
+  }
+#endif
+  if(status == EXIT_SUCCESS)
+  {
+    std::cout << "Completed MBIR Reconstruction Run" << std::endl;
+  }
+  return status;
 }
 
@@ -48,6 +48,7 @@ class LayersDockWidget;
 class GainsOffsetsTableModel;
 class ReconstructionArea;
 class MRCInfoWidget;
+class QLabel;
 
 //-- UIC generated Header
 #include "ui_BrightFieldGui.h"
@@ -185,7 +186,8 @@ class BrightFieldGui :  public QMainWindow, private Ui::BrightFieldGui, public O
     void on_actionLayers_Palette_triggered();
 
     /**
-     * @brief Calculate the estimated memory needed to run the reconstruction
+     * @brief Predicts the memory the full reconstruction needs and shows it in
+     * the status bar
      */
     void memCalculate();
 
@@ -477,6 +479,7 @@ class BrightFieldGui :  public QMainWindow, private Ui::BrightFieldGui, public O
     qreal                 m_CachedSigmaX;
     bool                  m_UpdateCachedSigmaX;
     QVector<QString>      m_TempFilesToDelete;
+    QLabel*               m_MemoryLabel;
 
     BrightFieldGui(const BrightFieldGui&); // Copy Constructor Not Implemented
     void operator=(const BrightFieldGui&); // Operator '=' Not Implemented
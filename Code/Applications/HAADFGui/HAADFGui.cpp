@@ -57,6 +57,7 @@
 #include <QtGui/QLineEdit>
 #include <QtGui/QDoubleValidator>
 #include <QtGui/QImage>
+#include <QtGui/QLabel>
 
 // Our Project wide includes
 #include "QtSupport/ApplicationAboutBoxDialog.h"
@@ -70,6 +71,7 @@
 #include "MBIRLib/Reconstruction/ReconstructionConstants.h"
 #include "MBIRLib/Reconstruction/ReconstructionStructures.h"
 #include "MBIRLib/HAADF/HAADF_ReconstructionEngine.h"
+#include "MBIRLib/HAADF/HAADF_MultiResolutionReconstruction.h"
 #include "MBIRLib/IOFilters/MRCHeader.h"
 #include "MBIRLib/IOFilters/MRCReader.h"
 #include "MBIRLib/IOFilters/GainsOffsetsReader.h"
@@ -137,7 +139,8 @@ HAADFGui::HAADFGui(QWidget* parent) :
   m_MultiResSOC(NULL),
   m_SingleSliceReconstructionActive(false),
   m_FullReconstrucionActive(false),
-  m_UpdateCachedSigmaX(true)
+  m_UpdateCachedSigmaX(true),
+  m_MemoryLabel(NULL)
 {
   m_OpenDialogLastDirectory = QDir::homePath();
   setupUi(this);
@@ -439,6 +442,10 @@ void HAADFGui::setupGui()
   reconstructedVolumeFileName->setText("");
   m_ReconstructedDisplayWidget->disableVOISelection();
 
+  // The predicted memory of the reconstruction is always shown in the status bar
+  m_MemoryLabel = new QLabel(this);
+  statusBar()->addPermanentWidget(m_MemoryLabel);
+
 
   connect(m_MRCDisplayWidget->graphicsView(), SIGNAL(fireImageFileLoaded(const QString&)),
           this, SLOT(mrcInputFileLoaded(const QString&)), Qt::QueuedConnection);
@@ -2102,80 +2109,73 @@ void HAADFGui::on_removeResolution_clicked()
 // -----------------------------------------------------------------------------
 void HAADFGui::memCalculate()
 {
+  ReconstructionArea* reconArea = m_MRCDisplayWidget->graphicsView()->reconstructionArea();
+  if (NULL == reconArea || NULL == m_GainsOffsetsTableModel || NULL == m_MemoryLabel)
+  {
+    return;
+  }
   bool ok = false;
-  float GeomN_x, GeomN_y, GeomN_z;
-
   int x_min = 0;
   int x_max = 0;
-  ReconstructionArea* reconArea = m_MRCDisplayWidget->graphicsView()->reconstructionArea();
-  if (NULL == reconArea)
+  reconArea->getXMinMax(x_min, x_max);
+  quint16 y_min = yMin->text().toUShort(&ok);
+  quint16 y_max = yMax->text().toUShort(&ok);
+  if (y_max <= y_min || x_max <= x_min || m_nTilts == 0)
   {
+    m_MemoryLabel->setText("");
     return;
   }
-  reconArea->getXMinMax(x_min, x_max);
-
-  float SinoN_r = x_max - x_min + 1;
-  float SinoN_t = yMax->text().toInt(&ok) - yMin->text().toInt(&ok) + 1;
-  float SinoNtheta = m_nTilts - 0 + 1;
-
-  float sample_thickness = sampleThickness->text().toFloat(&ok);
-  int final_resolution = finalResolution->value();
-  int num_resolutions = numResolutions->text().toInt(&ok);
-  float interpolate_factor = powf((float)2, (float)num_resolutions - 1) * final_resolution;
-  float delta_r = m_CachedPixelSize * 1.0e9;
-  float delta_xz = delta_r * final_resolution;
-  AdvancedParametersPtr advancedParams = AdvancedParametersPtr(new AdvancedParameters);
-  HAADF_ReconstructionEngine::InitializeAdvancedParams(advancedParams);
 
-  //std::cout<<"Advaced params"<<advancedParams->Z_STRETCH<<std::endl;
-
-  if(extendObject->isChecked() == true)
+  // Plan with the same settings the full reconstruction is started with
+  HAADF_MultiResolutionReconstruction::Pointer multiRes = HAADF_MultiResolutionReconstruction::New();
+  multiRes->setInputFile(QDir::toNativeSeparators(inputMRCFilePath->text()).toStdString());
+  multiRes->setNumberResolutions(numResolutions->value());
+  multiRes->setFinalResolution(finalResolution->value());
+  multiRes->setSampleThickness(sampleThickness->text().toFloat(&ok));
+  multiRes->setDefaultPixelSize(m_CachedPixelSize);
+  multiRes->setExtendObject(extendObject->isChecked());
+  if(tiltSelection->currentIndex() == 0)
   {
-    float maxTilt = m_CachedLargestAngle;
-    //    float LengthZ = sample_thickness * advancedParams->Z_STRETCH;
-    float temp = advancedParams->X_SHRINK_FACTOR * ((SinoN_r * delta_r) / cos(maxTilt * M_PI / 180)) + sample_thickness * tan(maxTilt * M_PI / 180);
-    temp /= (interpolate_factor * delta_r);
-    float GeomLengthX = floor(temp + 0.5) * interpolate_factor * delta_r;
-    GeomN_x = floor(GeomLengthX / delta_xz);
+    multiRes->setTilts(m_GainsOffsetsTableModel->getATilts().toStdVector());
   }
   else
   {
-    GeomN_x = SinoN_r / final_resolution;
+    multiRes->setTilts(m_GainsOffsetsTableModel->getBTilts().toStdVector());
   }
+  AdvancedParametersPtr advParams = AdvancedParametersPtr(new AdvancedParameters);
+  HAADF_ReconstructionEngine::InitializeAdvancedParams(advParams);
+  multiRes->setAdvParams(advParams);
 
-  GeomN_y = SinoN_t / final_resolution;
-  GeomN_z = advancedParams->Z_STRETCH * (sample_thickness / (final_resolution * delta_r)); // TODO: need to access Sinogram_deltar and z_stretch.
-  //This is wrong currently. Need to multiply m_FinalResolution by size of voxel in nm
+  std::vector<uint16_t> subvolume(6);
+  subvolume[0] = x_min;
+  subvolume[1] = y_min;
+  subvolume[2] = 0;
+  subvolume[3] = x_max;
+  subvolume[4] = y_max - 1;
+  subvolume[5] = m_nTilts - 1;
+  multiRes->setSubvolume(subvolume);
 
-  float dataTypeMem = sizeof(Real_t);
-  float ObjectMem = GeomN_x * GeomN_y * GeomN_z * dataTypeMem;
-  float SinogramMem = SinoN_r * SinoN_t * SinoNtheta * dataTypeMem;
-  float ErroSinoMem = SinogramMem;
-  float WeightMem = SinogramMem; //Weight matrix
-  float A_MatrixMem;
-  if(extendObject->isChecked() == true)
-  {
-    A_MatrixMem = GeomN_x * GeomN_z * (final_resolution * 3 * (dataTypeMem + 4) * SinoNtheta); // 4 is the bytes to store the counts
-    //*+4 correspodns to bytes to store a single double and a unsigned into to
-    //store the offset. 3*m_FinalRes is the approximate number of detector elements hit per voxel
-  }
-  else
+  std::vector<uint8_t> viewMasks;
+  QVector<bool> excludedViews = m_GainsOffsetsTableModel->getExcludedTilts();
+  for (int i = 0; i < excludedViews.size(); ++i)
   {
-    A_MatrixMem = GeomN_x * GeomN_z * (final_resolution * (dataTypeMem + 4) * SinoNtheta); //Since we are reconstructing a larger region there are several voxels with no projection data. so instead of each voxel hitting 3*m_FinalRes det entries we aproximate it by m_FinalRes
+    if(excludedViews[i] == true)
+    {
+      viewMasks.push_back(i);
+    }
   }
-  float NuisanceParamMem = SinoNtheta * dataTypeMem * 3; //3 is for gains offsets and noise var
+  multiRes->setViewMasks(viewMasks);
 
-  if(inputBrightFieldFilePath->text().isEmpty() == false)
+  MemoryPlanner::Pointer plan = multiRes->planMemory();
+  if (NULL == plan.get())
   {
-    SinogramMem *= 2;
+    m_MemoryLabel->setText("");
+    return;
   }
-
-  float TotalMem = ObjectMem + SinogramMem + ErroSinoMem + WeightMem + A_MatrixMem + NuisanceParamMem; //in bytes
-
-  TotalMem /= (1e9); //To get answer in Gb
-
-  //memoryUse->setText(QString::number(TotalMem));
-
+  std::stringstream ss;
+  plan->printPlan(ss);
+  m_MemoryLabel->setText(QString("Estimated Memory: ") + QString::fromStdString(MemoryPlanner::FormatBytes(plan->getPeakBytes())));
+  m_MemoryLabel->setToolTip(QString::fromStdString(ss.str()));
 }
 
 
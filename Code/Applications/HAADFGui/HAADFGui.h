@@ -48,6 +48,7 @@ class LayersDockWidget;
 class GainsOffsetsTableModel;
 class ReconstructionArea;
 class MRCInfoWidget;
+class QLabel;
 
 //-- UIC generated Header
 #include "ui_HAADFGui.h"
@@ -182,7 +183,8 @@ class HAADFGui :  public QMainWindow, private Ui::HAADFGui, public Observer
     void on_actionLayers_Palette_triggered();
 
     /**
-     * @brief Calculate the estimated memory needed to run the reconstruction
+     * @brief Predicts the memory the full reconstruction needs and shows it in
+     * the status bar
      */
     void memCalculate();
 
@@ -451,6 +453,7 @@ class HAADFGui :  public QMainWindow, private Ui::HAADFGui, public Observer
     qreal                 m_CachedSigmaX;
     bool                  m_UpdateCachedSigmaX;
     QVector<QString>      m_TempFilesToDelete;
+    QLabel*               m_MemoryLabel;
 
     HAADFGui(const HAADFGui&); // Copy Constructor Not Implemented
     void operator=(const HAADFGui&); // Operator '=' Not Implemented
@@ -0,0 +1,395 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "HAADFBatchReconstruction.h"
+
+#include <stdlib.h>
+
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <set>
+#include <sstream>
+
+#include "MXA/Utilities/MXADir.h"
+#include "MXA/Utilities/MXAFileInfo.h"
+
+#include "MBIRLib/Common/EIMTime.h"
+#include "MBIRLib/GenericFilters/MemoryPlanner.h"
+
+#include "HAADFReconstructionArgsParser.h"
+
+namespace Detail
+{
+  /* "--name" or a single dash followed by a letter. Values like -0.5 are not flags. */
+  bool isFlag(const std::string& arg)
+  {
+    if(arg.size() > 2 && arg[0] == '-' && arg[1] == '-')
+    {
+      return true;
+    }
+    return (arg.size() == 2 && arg[0] == '-' && isalpha(static_cast<unsigned char>(arg[1])) != 0);
+  }
+
+  /* The flag and the values that follow it up to the next flag */
+  void groupArguments(const std::vector<std::string>& args, std::vector<std::vector<std::string> >& groups)
+  {
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+      if(isFlag(args[i]) == true || groups.empty() == true)
+      {
+        groups.push_back(std::vector<std::string>());
+      }
+      groups.back().push_back(args[i]);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADFBatchReconstruction::HAADFBatchReconstruction() :
+  m_ConcurrentJobs(1)
+{
+  m_PrecomputeCache = HAADF_PrecomputeCache::New();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADFBatchReconstruction::~HAADFBatchReconstruction()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADFBatchReconstruction::parseArguments(int argc, char** argv)
+{
+  bool batch = false;
+  m_BaseArguments.clear();
+  m_ProgramName = (argc > 0) ? std::string(argv[0]) : std::string("HAADFReconstruction");
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg(argv[i]);
+    if(arg.compare("--batch") == 0 || arg.compare("--batch_jobs") == 0)
+    {
+      if(i + 1 >= argc)
+      {
+        std::cout << arg << " needs a value" << std::endl;
+        return -1;
+      }
+      std::string value(argv[++i]);
+      if(arg.compare("--batch") == 0)
+      {
+        m_ManifestFile = value;
+        batch = true;
+      }
+      else
+      {
+        m_ConcurrentJobs = atoi(value.c_str());
+        if(m_ConcurrentJobs < 1)
+        {
+          std::cout << "--batch_jobs needs a value of at least 1" << std::endl;
+          return -1;
+        }
+      }
+      continue;
+    }
+    m_BaseArguments.push_back(arg);
+  }
+  return (batch == true) ? 1 : 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::vector<std::string> HAADFBatchReconstruction::SplitLine(const std::string& line)
+{
+  std::vector<std::string> tokens;
+  std::string current;
+  bool inQuotes = false;
+  bool hasToken = false;
+  for (size_t i = 0; i < line.size(); ++i)
+  {
+    char c = line[i];
+    if(c == '"')
+    {
+      inQuotes = !inQuotes;
+      hasToken = true;
+    }
+    else if(inQuotes == false && (c == ' ' || c == '\t' || c == '\r' || c == '\n'))
+    {
+      if(hasToken == true)
+      {
+        tokens.push_back(current);
+        current.clear();
+        hasToken = false;
+      }
+    }
+    else
+    {
+      current.push_back(c);
+      hasToken = true;
+    }
+  }
+  if(hasToken == true)
+  {
+    tokens.push_back(current);
+  }
+  return tokens;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::vector<std::string> HAADFBatchReconstruction::MergeArguments(const std::vector<std::string>& base,
+                                                                  const std::vector<std::string>& overrides)
+{
+  std::vector<std::vector<std::string> > baseGroups;
+  std::vector<std::vector<std::string> > overrideGroups;
+  Detail::groupArguments(base, baseGroups);
+  Detail::groupArguments(overrides, overrideGroups);
+
+  for (size_t i = 0; i < overrideGroups.size(); ++i)
+  {
+    bool replaced = false;
+    for (size_t j = 0; j < baseGroups.size(); ++j)
+    {
+      if(baseGroups[j].front().compare(overrideGroups[i].front()) == 0)
+      {
+        baseGroups[j] = overrideGroups[i];
+        replaced = true;
+      }
+    }
+    if(replaced == false)
+    {
+      baseGroups.push_back(overrideGroups[i]);
+    }
+  }
+
+  std::vector<std::string> merged;
+  for (size_t j = 0; j < baseGroups.size(); ++j)
+  {
+    merged.insert(merged.end(), baseGroups[j].begin(), baseGroups[j].end());
+  }
+  return merged;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADFBatchReconstruction::readManifest()
+{
+  std::ifstream in(m_ManifestFile.c_str());
+  if(in.is_open() == false)
+  {
+    std::cout << "Could not open the batch manifest '" << m_ManifestFile << "'" << std::endl;
+    return -1;
+  }
+
+  m_Jobs.clear();
+  std::string line;
+  size_t lineNumber = 0;
+  while(std::getline(in, line))
+  {
+    ++lineNumber;
+    std::vector<std::string> overrides = SplitLine(line);
+    if(overrides.empty() == true || overrides.front()[0] == '#')
+    {
+      continue;
+    }
+    HAADFBatchJob job;
+    job.Line = lineNumber;
+    job.Arguments = MergeArguments(m_BaseArguments, overrides);
+    job.PlanOnly = false;
+    job.ErrorCondition = 0;
+    job.Milliseconds = 0;
+    m_Jobs.push_back(job);
+  }
+  if(m_Jobs.empty() == true)
+  {
+    std::cout << "The batch manifest '" << m_ManifestFile << "' does not list any jobs" << std::endl;
+    return -1;
+  }
+
+  // Parse every job up front so a mistake in the last line does not surface
+  // after all the others have run
+  std::set<std::string> outputFiles;
+  std::map<std::string, size_t> tempDirs;
+  for (size_t i = 0; i < m_Jobs.size(); ++i)
+  {
+    HAADFBatchJob& job = m_Jobs[i];
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(m_ProgramName.c_str()));
+    for (size_t a = 0; a < job.Arguments.size(); ++a)
+    {
+      argv.push_back(const_cast<char*>(job.Arguments[a].c_str()));
+    }
+
+    job.Reconstruction = HAADF_MultiResolutionReconstruction::New();
+    HAADFReconstructionArgsParser argParser;
+    if(argParser.parseArguments(static_cast<int>(argv.size()), &(argv.front()), job.Reconstruction) < 0)
+    {
+      std::cout << "Error Parsing the arguments of line " << job.Line << " of the batch manifest" << std::endl;
+      return -1;
+    }
+    job.PlanOnly = argParser.getPlanOnly();
+    job.Reconstruction->setPrecomputeCache(m_PrecomputeCache);
+
+    if(outputFiles.insert(job.Reconstruction->getOutputFile()).second == false)
+    {
+      std::cout << "Line " << job.Line << " of the batch manifest writes '" << job.Reconstruction->getOutputFile()
+                << "' which an earlier line already writes" << std::endl;
+      return -1;
+    }
+    tempDirs[job.Reconstruction->getTempDir()]++;
+  }
+
+  // The temporary files have fixed names so jobs that write next to each other
+  // get a directory of their own
+  for (size_t i = 0; i < m_Jobs.size(); ++i)
+  {
+    HAADF_MultiResolutionReconstruction::Pointer reconstruction = m_Jobs[i].Reconstruction;
+    if(tempDirs[reconstruction->getTempDir()] > 1)
+    {
+      std::string dir = reconstruction->getTempDir() + MXADir::getSeparator()
+                        + MXAFileInfo::fileNameWithOutExtension(reconstruction->getOutputFile());
+      reconstruction->setTempDir(dir);
+    }
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADFBatchReconstruction::runJob(size_t index)
+{
+  HAADFBatchJob& job = m_Jobs[index];
+  HAADF_MultiResolutionReconstruction::Pointer reconstruction = job.Reconstruction;
+  unsigned long long start = EIMTOMO_getMilliSeconds();
+
+  std::stringstream ss;
+  ss << "Batch job " << index + 1 << " of " << m_Jobs.size() << " (line " << job.Line << "): "
+     << reconstruction->getInputFile() << " -> " << reconstruction->getOutputFile() << std::endl;
+  std::cout << ss.str();
+
+  if(job.PlanOnly == true)
+  {
+    MemoryPlanner::Pointer plan = reconstruction->planMemory();
+    if(NULL == plan.get())
+    {
+      job.ErrorCondition = -1;
+    }
+    else
+    {
+      ss.str("");
+      plan->printPlan(ss);
+      std::cout << ss.str();
+      job.ErrorCondition = (plan->getFeasible() == true) ? 0 : -1;
+    }
+  }
+  else if(MXADir::exists(reconstruction->getTempDir()) == false && MXADir::mkdir(reconstruction->getTempDir(), true) == false)
+  {
+    std::cout << "Error creating the output directory '" << reconstruction->getTempDir() << "'" << std::endl;
+    job.ErrorCondition = -1;
+  }
+  else
+  {
+    reconstruction->execute();
+    job.ErrorCondition = reconstruction->getErrorCondition();
+  }
+  job.Milliseconds = EIMTOMO_getMilliSeconds() - start;
+
+  // Only the timing is kept. The volumes of a finished job go away with it.
+  job.Reconstruction = HAADF_MultiResolutionReconstruction::NullPointer();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADFBatchReconstruction::execute()
+{
+  unsigned long long start = EIMTOMO_getMilliSeconds();
+
+  runJobs(m_Jobs.size(), m_ConcurrentJobs, "batch jobs");
+
+  printReport(EIMTOMO_getMilliSeconds() - start, std::cout);
+
+  for (size_t i = 0; i < m_Jobs.size(); ++i)
+  {
+    if(m_Jobs[i].ErrorCondition < 0)
+    {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADFBatchReconstruction::printReport(unsigned long long wallMilliseconds, std::ostream& out)
+{
+  unsigned long long total = 0;
+  int failed = 0;
+  out << "Batch Summary for '" << m_ManifestFile << "'" << std::endl;
+  out << "  " << std::setw(6) << "Job" << std::setw(6) << "Line" << std::setw(12) << "Seconds" << "  Status" << std::endl;
+  for (size_t i = 0; i < m_Jobs.size(); ++i)
+  {
+    const HAADFBatchJob& job = m_Jobs[i];
+    total += job.Milliseconds;
+    out << "  " << std::setw(6) << i + 1 << std::setw(6) << job.Line
+        << std::setw(12) << std::fixed << std::setprecision(2) << job.Milliseconds / 1000.0 << "  ";
+    if(job.ErrorCondition < 0)
+    {
+      out << "Failed (" << job.ErrorCondition << ")";
+      ++failed;
+    }
+    else
+    {
+      out << "Completed";
+    }
+    out << std::endl;
+  }
+  out << "  Jobs: " << m_Jobs.size() << "  Failed: " << failed << std::endl;
+  out << "  Sum of job times: " << std::fixed << std::setprecision(2) << total / 1000.0
+      << " s  Wall time: " << wallMilliseconds / 1000.0 << " s" << std::endl;
+  out << "  Precomputation cache: " << m_PrecomputeCache->getNumberOfSinograms() << " sinograms, "
+      << m_PrecomputeCache->getNumberOfEntries() << " geometries, "
+      << m_PrecomputeCache->getHits() << " hits, " << m_PrecomputeCache->getMisses() << " misses" << std::endl;
+}
@@ -0,0 +1,139 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _HAADFBatchReconstruction_H_
+#define _HAADFBatchReconstruction_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/HAADF/HAADF_MultiResolutionReconstruction.h"
+#include "MBIRLib/HAADF/HAADF_PrecomputeCache.h"
+
+#include "HAADFJobRunner.h"
+
+/**
+ * @brief One line of a batch manifest
+ */
+typedef struct
+{
+  size_t Line; // Line of the manifest the job came from
+  std::vector<std::string> Arguments; // The base arguments with the overrides of the line applied
+  HAADF_MultiResolutionReconstruction::Pointer Reconstruction;
+  bool PlanOnly; // Only print the memory plan of this job (--plan)
+  int ErrorCondition;
+  unsigned long long Milliseconds;
+} HAADFBatchJob;
+
+/**
+ * @class HAADFBatchReconstruction HAADFBatchReconstruction.h HAADFReconstruction/HAADFBatchReconstruction.h
+ * @brief Runs one HAADF reconstruction per line of a manifest file in a single
+ * process. The lines hold arguments that override the ones given on the
+ * command line next to --batch, so
+ *
+ *   HAADFReconstruction --batch jobs.txt --thickness 300 --sigma_x 1.2 ...
+ *
+ * with a jobs.txt of
+ *
+ *   -s tilt_a.mrc --outputfile out/a.mrc
+ *   -s tilt_b.mrc --outputfile out/b.mrc --sigma_x 0.8
+ *
+ * reconstructs both datasets. Empty lines and lines starting with '#' are skipped.
+ *
+ * All jobs share a HAADF_PrecomputeCache so datasets with the same geometry
+ * compute the detector response and the A matrix only once. The first job runs
+ * on its own to fill the cache, the others run back to back or, with
+ * --batch_jobs N, N at a time with an equal share of the threads each.
+ */
+class HAADFBatchReconstruction : public HAADFJobRunner
+{
+  public:
+    HAADFBatchReconstruction();
+    virtual ~HAADFBatchReconstruction();
+
+    MXA_INSTANCE_STRING_PROPERTY(ProgramName)
+    MXA_INSTANCE_STRING_PROPERTY(ManifestFile)
+    MXA_INSTANCE_PROPERTY(std::vector<std::string>, BaseArguments)
+    MXA_INSTANCE_PROPERTY(int, ConcurrentJobs)
+
+    /**
+     * @brief Takes --batch and --batch_jobs out of the command line
+     * @return 1 if this is a batch run, 0 if it is not and -1 if the arguments are wrong
+     */
+    int parseArguments(int argc, char** argv);
+
+    /**
+     * @brief Reads the manifest and parses the arguments of every job so
+     * mistakes are reported before the first reconstruction starts
+     * @return Error condition
+     */
+    int readManifest();
+
+    /**
+     * @brief Runs all the jobs and prints their timing
+     * @return Error condition. Negative if any of the jobs failed
+     */
+    int execute();
+
+    void printReport(unsigned long long wallMilliseconds, std::ostream& out);
+
+    /**
+     * @brief Splits a manifest line at white space. Double quotes keep an argument with spaces together.
+     */
+    static std::vector<std::string> SplitLine(const std::string& line);
+
+    /**
+     * @brief Applies the overrides to the base arguments. A flag of the overrides
+     * replaces the same flag of the base together with its values, new flags are appended.
+     */
+    static std::vector<std::string> MergeArguments(const std::vector<std::string>& base,
+                                                   const std::vector<std::string>& overrides);
+
+  protected:
+    void runJob(size_t index);
+
+  private:
+    std::vector<HAADFBatchJob> m_Jobs;
+    HAADF_PrecomputeCache::Pointer m_PrecomputeCache;
+
+    HAADFBatchReconstruction(const HAADFBatchReconstruction&); // Copy Constructor Not Implemented
+    void operator=(const HAADFBatchReconstruction&); // Operator '=' Not Implemented
+};
+
+#endif /* _HAADFBatchReconstruction_H_ */
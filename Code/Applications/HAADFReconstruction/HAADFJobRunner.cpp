@@ -0,0 +1,162 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "HAADFJobRunner.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_scheduler_init.h>
+#include <tbb/tbb_thread.h>
+#endif
+
+namespace Detail
+{
+  /**
+   * @brief Runs queued jobs on its own thread. The task scheduler it creates
+   * limits the reconstructions of the thread to their share of the cores.
+   */
+  class JobWorker
+  {
+    public:
+      JobWorker(HAADFJobRunner* runner, int numThreads) :
+        m_Runner(runner),
+        m_NumThreads(numThreads)
+      {
+      }
+
+      virtual ~JobWorker() {}
+
+      void operator()() const
+      {
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+        tbb::task_scheduler_init init(m_NumThreads);
+#endif
+        m_Runner->runQueuedJobs();
+      }
+
+    private:
+      HAADFJobRunner* m_Runner;
+      int m_NumThreads;
+  };
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADFJobRunner::HAADFJobRunner() :
+  m_NumJobs(0),
+  m_NextJob(0)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADFJobRunner::~HAADFJobRunner()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADFJobRunner::runJobs(size_t numJobs, int concurrentJobs, const std::string& jobName)
+{
+  m_NumJobs = numJobs;
+  if(m_NumJobs == 0)
+  {
+    return;
+  }
+
+  // The first job fills the precomputation cache for the ones after it
+  m_NextJob = 1;
+  runJob(0);
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  size_t remaining = m_NumJobs - 1;
+  size_t numWorkers = std::min(static_cast<size_t>(concurrentJobs), remaining);
+  if(numWorkers > 1)
+  {
+    int threadsPerJob = tbb::task_scheduler_init::default_num_threads() / static_cast<int>(numWorkers);
+    if(threadsPerJob < 1)
+    {
+      threadsPerJob = 1;
+    }
+    std::cout << "Running " << remaining << " " << jobName << " " << numWorkers << " at a time with "
+              << threadsPerJob << " threads each" << std::endl;
+    std::vector<tbb::tbb_thread*> workers(numWorkers, NULL);
+    for (size_t i = 0; i < numWorkers; ++i)
+    {
+      workers[i] = new tbb::tbb_thread(Detail::JobWorker(this, threadsPerJob));
+    }
+    for (size_t i = 0; i < numWorkers; ++i)
+    {
+      workers[i]->join();
+      delete workers[i];
+    }
+    return;
+  }
+#endif
+  runQueuedJobs();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADFJobRunner::runQueuedJobs()
+{
+  while(true)
+  {
+    size_t index = 0;
+    {
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+      tbb::spin_mutex::scoped_lock lock(m_QueueMutex);
+#endif
+      index = m_NextJob;
+      if(m_NextJob < m_NumJobs)
+      {
+        ++m_NextJob;
+      }
+    }
+    if(index >= m_NumJobs)
+    {
+      return;
+    }
+    runJob(index);
+  }
+}
@@ -0,0 +1,91 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _HAADFJobRunner_H_
+#define _HAADFJobRunner_H_
+
+#include <string>
+
+#include "MBIRLib/MBIRLib.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/spin_mutex.h>
+#endif
+
+/**
+ * @class HAADFJobRunner HAADFJobRunner.h HAADFReconstruction/HAADFJobRunner.h
+ * @brief Runs the reconstructions of a batch or a sweep. The first job runs on
+ * its own so it can fill the precomputation cache the others share. The rest
+ * run back to back or, with more than one concurrent job, on that many threads
+ * that each get an equal share of the cores.
+ */
+class HAADFJobRunner
+{
+  public:
+    HAADFJobRunner();
+    virtual ~HAADFJobRunner();
+
+    /**
+     * @brief Runs jobs until none are left. Called by every worker thread.
+     */
+    void runQueuedJobs();
+
+  protected:
+    /**
+     * @brief Runs jobs 0 to numJobs - 1
+     * @param concurrentJobs Jobs that may run at the same time after the first one
+     * @param jobName What the jobs are called in the progress message
+     */
+    void runJobs(size_t numJobs, int concurrentJobs, const std::string& jobName);
+
+    /**
+     * @brief Runs one job. Jobs that run at the same time are called from
+     * different threads.
+     */
+    virtual void runJob(size_t index) = 0;
+
+  private:
+    size_t m_NumJobs;
+    size_t m_NextJob;
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    tbb::spin_mutex m_QueueMutex;
+#endif
+
+    HAADFJobRunner(const HAADFJobRunner&); // Copy Constructor Not Implemented
+    void operator=(const HAADFJobRunner&); // Operator '=' Not Implemented
+};
+
+#endif /* _HAADFJobRunner_H_ */
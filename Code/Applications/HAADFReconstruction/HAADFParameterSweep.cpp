@@ -0,0 +1,405 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "HAADFParameterSweep.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "MXA/Utilities/MXADir.h"
+#include "MXA/Utilities/MXAFileInfo.h"
+
+#include "MBIRLib/Common/EIMTime.h"
+
+#include "HAADFBatchReconstruction.h"
+#include "HAADFReconstructionArgsParser.h"
+
+namespace Detail
+{
+  bool numericLess(const std::string& a, const std::string& b)
+  {
+    return strtod(a.c_str(), NULL) < strtod(b.c_str(), NULL);
+  }
+
+  /* Splits a comma separated list of numbers */
+  int parseSweepValues(const std::string& arg, const std::string& list, std::vector<std::string>& values)
+  {
+    values.clear();
+    std::stringstream ss(list);
+    std::string value;
+    while(std::getline(ss, value, ','))
+    {
+      char* end = NULL;
+      strtod(value.c_str(), &end);
+      if(value.empty() == true || *end != '\0')
+      {
+        std::cout << arg << " needs a comma separated list of numbers. '" << value << "' is not a number" << std::endl;
+        return -1;
+      }
+      if(std::find(values.begin(), values.end(), value) == values.end())
+      {
+        values.push_back(value);
+      }
+    }
+    std::stable_sort(values.begin(), values.end(), numericLess);
+    return values.empty() ? -1 : 0;
+  }
+
+  /* Orders the settings by their distance from the one that is started first */
+  class SweepOrder
+  {
+    public:
+      SweepOrder(const std::vector<size_t>& distances) : m_Distances(distances) {}
+      virtual ~SweepOrder() {}
+
+      bool operator()(size_t a, size_t b) const
+      {
+        if(m_Distances[a] != m_Distances[b])
+        {
+          return m_Distances[a] < m_Distances[b];
+        }
+        return a < b;
+      }
+
+    private:
+      std::vector<size_t> m_Distances;
+  };
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADFParameterSweep::HAADFParameterSweep() :
+  m_ConcurrentJobs(1)
+{
+  m_PrecomputeCache = HAADF_PrecomputeCache::New();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADFParameterSweep::~HAADFParameterSweep()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADFParameterSweep::parseArguments(int argc, char** argv)
+{
+  m_BaseArguments.clear();
+  m_SigmaXValues.clear();
+  m_DiffusenessValues.clear();
+  m_ProgramName = (argc > 0) ? std::string(argv[0]) : std::string("HAADFReconstruction");
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg(argv[i]);
+    if(arg.compare("--sweep_sigma_x") != 0 && arg.compare("--sweep_diffuseness") != 0 && arg.compare("--sweep_jobs") != 0)
+    {
+      m_BaseArguments.push_back(arg);
+      continue;
+    }
+    if(i + 1 >= argc)
+    {
+      std::cout << arg << " needs a value" << std::endl;
+      return -1;
+    }
+    std::string value(argv[++i]);
+    if(arg.compare("--sweep_jobs") == 0)
+    {
+      m_ConcurrentJobs = atoi(value.c_str());
+      if(m_ConcurrentJobs < 1)
+      {
+        std::cout << "--sweep_jobs needs a value of at least 1" << std::endl;
+        return -1;
+      }
+    }
+    else if(Detail::parseSweepValues(arg, value, (arg.compare("--sweep_sigma_x") == 0) ? m_SigmaXValues : m_DiffusenessValues) < 0)
+    {
+      return -1;
+    }
+  }
+  return (m_SigmaXValues.empty() == false || m_DiffusenessValues.empty() == false) ? 1 : 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADFParameterSweep::initialize()
+{
+  std::string outputFile;
+  for (size_t i = 0; i + 1 < m_BaseArguments.size(); ++i)
+  {
+    if(m_BaseArguments[i].compare("--outputfile") == 0)
+    {
+      outputFile = m_BaseArguments[i + 1];
+    }
+  }
+  if(outputFile.empty() == true)
+  {
+    std::cout << "A sweep needs --outputfile to name the files of its settings" << std::endl;
+    return -1;
+  }
+  std::string parent = MXAFileInfo::parentPath(outputFile);
+  std::string base = (parent.empty() ? std::string("") : parent + MXADir::getSeparator()) + MXAFileInfo::fileNameWithOutExtension(outputFile);
+  std::string extension = MXAFileInfo::extension(outputFile);
+  if(extension.empty() == true)
+  {
+    extension = "mrc";
+  }
+  m_TableFile = base + "_sweep.txt";
+
+  // A parameter that is not swept keeps the value of the base arguments
+  std::vector<std::string> sigmaX = m_SigmaXValues;
+  std::vector<std::string> diffuseness = m_DiffusenessValues;
+  if(sigmaX.empty() == true) { sigmaX.push_back(""); }
+  if(diffuseness.empty() == true) { diffuseness.push_back(""); }
+
+  m_Settings.clear();
+  for (size_t a = 0; a < sigmaX.size(); ++a)
+  {
+    for (size_t b = 0; b < diffuseness.size(); ++b)
+    {
+      HAADFSweepSetting setting;
+      setting.SigmaXIndex = a;
+      setting.DiffusenessIndex = b;
+      setting.WarmStartFrom = -1;
+      setting.Completed = false;
+      setting.ErrorCondition = 0;
+      setting.FinalCost = 0.0;
+      setting.VoxelUpdatePasses = 0;
+      setting.Milliseconds = 0;
+
+      std::vector<std::string> overrides;
+      std::string label;
+      if(sigmaX[a].empty() == false)
+      {
+        overrides.push_back("--sigma_x");
+        overrides.push_back(sigmaX[a]);
+        label += "_sx" + sigmaX[a];
+      }
+      if(diffuseness[b].empty() == false)
+      {
+        overrides.push_back("--diffuseness");
+        overrides.push_back(diffuseness[b]);
+        label += "_d" + diffuseness[b];
+      }
+      setting.OutputFile = base + label + "." + extension;
+      overrides.push_back("--outputfile");
+      overrides.push_back(setting.OutputFile);
+
+      std::vector<std::string> args = HAADFBatchReconstruction::MergeArguments(m_BaseArguments, overrides);
+      std::vector<char*> argv;
+      argv.push_back(const_cast<char*>(m_ProgramName.c_str()));
+      for (size_t i = 0; i < args.size(); ++i)
+      {
+        argv.push_back(const_cast<char*>(args[i].c_str()));
+      }
+      setting.Reconstruction = HAADF_MultiResolutionReconstruction::New();
+      HAADFReconstructionArgsParser argParser;
+      if(argParser.parseArguments(static_cast<int>(argv.size()), &(argv.front()), setting.Reconstruction) < 0)
+      {
+        std::cout << "Error Parsing the arguments of the sweep" << std::endl;
+        return -1;
+      }
+      if(argParser.getPlanOnly() == true)
+      {
+        std::cout << "--plan can not be combined with a sweep" << std::endl;
+        return -1;
+      }
+      setting.Reconstruction->setPrecomputeCache(m_PrecomputeCache);
+      // Every setting keeps its temporary files apart from the others
+      setting.Reconstruction->setTempDir(MXAFileInfo::parentPath(setting.Reconstruction->getOutputFile()) + MXADir::getSeparator()
+                                         + MXAFileInfo::fileNameWithOutExtension(setting.Reconstruction->getOutputFile()));
+      m_Settings.push_back(setting);
+    }
+  }
+
+  // The middle of the grid first, then outwards so every setting has a
+  // converged neighbour close by
+  size_t seed = (sigmaX.size() / 2) * diffuseness.size() + diffuseness.size() / 2;
+  std::vector<size_t> distances(m_Settings.size());
+  m_Order.resize(m_Settings.size());
+  for (size_t i = 0; i < m_Settings.size(); ++i)
+  {
+    distances[i] = distance(i, seed);
+    m_Order[i] = i;
+  }
+  std::sort(m_Order.begin(), m_Order.end(), Detail::SweepOrder(distances));
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+size_t HAADFParameterSweep::distance(size_t a, size_t b)
+{
+  const HAADFSweepSetting& sa = m_Settings[a];
+  const HAADFSweepSetting& sb = m_Settings[b];
+  size_t dx = (sa.SigmaXIndex > sb.SigmaXIndex) ? sa.SigmaXIndex - sb.SigmaXIndex : sb.SigmaXIndex - sa.SigmaXIndex;
+  size_t dy = (sa.DiffusenessIndex > sb.DiffusenessIndex) ? sa.DiffusenessIndex - sb.DiffusenessIndex : sb.DiffusenessIndex - sa.DiffusenessIndex;
+  return dx + dy;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADFParameterSweep::runSetting(size_t index)
+{
+  HAADFSweepSetting& setting = m_Settings[index];
+  HAADF_MultiResolutionReconstruction::Pointer reconstruction = setting.Reconstruction;
+  {
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    tbb::spin_mutex::scoped_lock lock(m_Mutex);
+#endif
+    // The nearest setting that has converged so far
+    for (size_t i = 0; i < m_Settings.size(); ++i)
+    {
+      if(m_Settings[i].Completed == false || m_Settings[i].ErrorCondition < 0)
+      {
+        continue;
+      }
+      if(setting.WarmStartFrom < 0 || distance(i, index) < distance(static_cast<size_t>(setting.WarmStartFrom), index))
+      {
+        setting.WarmStartFrom = static_cast<int>(i);
+      }
+    }
+  }
+
+  std::stringstream ss;
+  ss << "Sweep setting sigma_x=" << reconstruction->getSigmaX() << " diffuseness=" << reconstruction->getMRFShapeParameter();
+  if(setting.WarmStartFrom >= 0)
+  {
+    HAADF_MultiResolutionReconstruction::Pointer neighbour = m_Settings[setting.WarmStartFrom].Reconstruction;
+    reconstruction->setWarmStartGeometry(neighbour->getFinalGeometry());
+    reconstruction->setWarmStartForwardModel(neighbour->getFinalForwardModel());
+    ss << " starting from sigma_x=" << neighbour->getSigmaX() << " diffuseness=" << neighbour->getMRFShapeParameter();
+  }
+  std::cout << ss.str() << std::endl;
+
+  unsigned long long start = EIMTOMO_getMilliSeconds();
+  if(MXADir::exists(reconstruction->getTempDir()) == false && MXADir::mkdir(reconstruction->getTempDir(), true) == false)
+  {
+    std::cout << "Error creating the output directory '" << reconstruction->getTempDir() << "'" << std::endl;
+    setting.ErrorCondition = -1;
+  }
+  else
+  {
+    reconstruction->execute();
+    setting.ErrorCondition = reconstruction->getErrorCondition();
+    setting.FinalCost = reconstruction->getFinalCost();
+    setting.VoxelUpdatePasses = reconstruction->getFinalVoxelUpdatePasses();
+  }
+  setting.Milliseconds = EIMTOMO_getMilliSeconds() - start;
+  reconstruction->setWarmStartGeometry(GeometryPtr());
+  reconstruction->setWarmStartForwardModel(HAADF_ForwardModel::NullPointer());
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  tbb::spin_mutex::scoped_lock lock(m_Mutex);
+#endif
+  setting.Completed = true;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADFParameterSweep::runJob(size_t index)
+{
+  runSetting(m_Order[index]);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADFParameterSweep::execute()
+{
+  // The first setting reads the data and fills the precomputation cache
+  runJobs(m_Order.size(), m_ConcurrentJobs, "sweep settings");
+
+  printTable(std::cout);
+  std::ofstream table(m_TableFile.c_str());
+  if(table.is_open() == false)
+  {
+    std::cout << "Could not write the sweep table to '" << m_TableFile << "'" << std::endl;
+    return -1;
+  }
+  printTable(table);
+
+  for (size_t i = 0; i < m_Settings.size(); ++i)
+  {
+    if(m_Settings[i].ErrorCondition < 0)
+    {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADFParameterSweep::printTable(std::ostream& out)
+{
+  out << std::left << std::setw(12) << "SigmaX" << std::setw(12) << "Diffuseness" << std::setw(26) << "Start"
+      << std::right << std::setw(8) << "Passes" << std::setw(18) << "Final Cost" << std::setw(10) << "Seconds"
+      << "  " << std::left << std::setw(10) << "Status" << "Output" << std::endl;
+  for (size_t o = 0; o < m_Order.size(); ++o)
+  {
+    const HAADFSweepSetting& setting = m_Settings[m_Order[o]];
+    std::stringstream start;
+    if(setting.WarmStartFrom < 0)
+    {
+      start << "cold";
+    }
+    else
+    {
+      HAADF_MultiResolutionReconstruction::Pointer neighbour = m_Settings[setting.WarmStartFrom].Reconstruction;
+      start << neighbour->getSigmaX() << "," << neighbour->getMRFShapeParameter();
+    }
+    out << std::left << std::setw(12) << setting.Reconstruction->getSigmaX()
+        << std::setw(12) << setting.Reconstruction->getMRFShapeParameter()
+        << std::setw(26) << start.str() << std::right << std::setw(8) << setting.VoxelUpdatePasses
+        << std::setw(18) << std::scientific << std::setprecision(8) << setting.FinalCost
+        << std::setw(10) << std::fixed << std::setprecision(2) << setting.Milliseconds / 1000.0 << "  " << std::left
+        << std::setw(10) << ((setting.ErrorCondition < 0) ? "Failed" : "Completed") << setting.OutputFile << std::endl;
+    out.unsetf(std::ios::floatfield);
+    out << std::setprecision(6);
+  }
+}
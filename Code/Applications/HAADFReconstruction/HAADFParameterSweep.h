@@ -0,0 +1,144 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _HAADFParameterSweep_H_
+#define _HAADFParameterSweep_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/HAADF/HAADF_MultiResolutionReconstruction.h"
+#include "MBIRLib/HAADF/HAADF_PrecomputeCache.h"
+
+#include "HAADFJobRunner.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/spin_mutex.h>
+#endif
+
+/**
+ * @brief One combination of prior parameters of a sweep
+ */
+typedef struct
+{
+  size_t SigmaXIndex;
+  size_t DiffusenessIndex;
+  std::string OutputFile;
+  HAADF_MultiResolutionReconstruction::Pointer Reconstruction;
+  int WarmStartFrom; // Index of the setting this one started from. -1 for a cold start
+  bool Completed;
+  int ErrorCondition;
+  Real_t FinalCost;
+  int VoxelUpdatePasses;
+  unsigned long long Milliseconds;
+} HAADFSweepSetting;
+
+/**
+ * @class HAADFParameterSweep HAADFParameterSweep.h HAADFReconstruction/HAADFParameterSweep.h
+ * @brief Reconstructs one dataset for every combination of the sigma_x and
+ * diffuseness values given with --sweep_sigma_x and --sweep_diffuseness (comma
+ * separated). The other arguments are the ones of a single reconstruction.
+ *
+ * The sinogram is read and the A matrix of every resolution is computed once
+ * for all settings through a shared HAADF_PrecomputeCache. The setting in the
+ * middle of the grid is reconstructed first through all resolutions. Every
+ * other setting, in order of its distance from it, only reconstructs the final
+ * resolution starting from the volume and nuisance parameters of the nearest
+ * setting that has converged. With --sweep_jobs N, N settings run at a time.
+ *
+ * Every setting writes <output>_sx<sigma_x>_d<diffuseness>.mrc next to the
+ * output file, and <output>_sweep.txt gets the cost, passes and time of each.
+ * The results of finished settings stay in memory as warm starts until the
+ * sweep is done.
+ */
+class HAADFParameterSweep : public HAADFJobRunner
+{
+  public:
+    HAADFParameterSweep();
+    virtual ~HAADFParameterSweep();
+
+    MXA_INSTANCE_STRING_PROPERTY(ProgramName)
+    MXA_INSTANCE_PROPERTY(std::vector<std::string>, BaseArguments)
+    MXA_INSTANCE_PROPERTY(std::vector<std::string>, SigmaXValues)
+    MXA_INSTANCE_PROPERTY(std::vector<std::string>, DiffusenessValues)
+    MXA_INSTANCE_PROPERTY(int, ConcurrentJobs)
+
+    /**
+     * @brief Takes the --sweep_* arguments out of the command line
+     * @return 1 if this is a sweep, 0 if it is not and -1 if the arguments are wrong
+     */
+    int parseArguments(int argc, char** argv);
+
+    /**
+     * @brief Parses the arguments of every setting before anything is reconstructed
+     * @return Error condition
+     */
+    int initialize();
+
+    /**
+     * @brief Runs all the settings and writes the table
+     * @return Error condition. Negative if any of the settings failed
+     */
+    int execute();
+
+    void printTable(std::ostream& out);
+
+  protected:
+    /**
+     * @brief Runs the setting that is started index-th
+     */
+    void runJob(size_t index);
+
+  private:
+    std::vector<HAADFSweepSetting> m_Settings;
+    std::vector<size_t> m_Order; // Settings in the order they are started
+    std::string m_TableFile;
+    HAADF_PrecomputeCache::Pointer m_PrecomputeCache;
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    tbb::spin_mutex m_Mutex;
+#endif
+
+    size_t distance(size_t a, size_t b);
+    void runSetting(size_t index);
+
+    HAADFParameterSweep(const HAADFParameterSweep&); // Copy Constructor Not Implemented
+    void operator=(const HAADFParameterSweep&); // Operator '=' Not Implemented
+};
+
+#endif /* _HAADFParameterSweep_H_ */
@@ -46,6 +46,8 @@
 #include "MBIRLib/Common/EIMMath.h"
 #include "MBIRLib/Common/allocate.h"
 #include "MBIRLib/IOFilters/MRCReader.h"
+#include "MBIRLib/IOFilters/ReconstructionSnapshotWriter.h"
+#include "MBIRLib/IOFilters/ReconstructionCheckpoint.h"
 #include "MBIRLib/IOFilters/MRCHeader.h"
 #include "MBIRLib/HAADF/HAADFConstants.h"
 
@@ -113,7 +115,9 @@ int parseUnknownArray(const std::string& values, const char* format, std::vector
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
-HAADFReconstructionArgsParser::HAADFReconstructionArgsParser()
+HAADFReconstructionArgsParser::HAADFReconstructionArgsParser() :
+  m_PlanOnly(false),
+  m_ExitOnError(true)
 {
 
 }
@@ -139,6 +143,7 @@ int HAADFReconstructionArgsParser::parseArguments(int argc, char** argv, HAADF_M
   }
 
   TCLAP::CmdLine cmd("", ' ', MBIRLib::Version::Complete());
+  cmd.setExceptionHandling(m_ExitOnError);
 
   TCLAP::ValueArg<std::string> in_MRCFile("s", "sinofile", "The Sinogram File", true, "", "");
   cmd.add(in_MRCFile);
@@ -180,10 +185,22 @@ int HAADFReconstructionArgsParser::parseArguments(int argc, char** argv, HAADF_M
   cmd.add(defaultVariance);
   TCLAP::ValueArg<double> defaultInitialRecon("", "default_recon_value", "Default initial value of reconstruction", false, 0.0, "");
   cmd.add(defaultInitialRecon);
+  TCLAP::ValueArg<int> sirtIterations("", "sirt_iterations", "Number of SIRT iterations used to initialize the coarsest resolution", false, 0, "0");
+  cmd.add(sirtIterations);
   TCLAP::SwitchArg extendObject("", "extend_object", "To extend the object or not", false);
   cmd.add(extendObject);
   TCLAP::SwitchArg m_DeleteTempFiles ("", "delete_tmp_files", "Delete all the Temp files that are created", false);
   cmd.add(m_DeleteTempFiles);
+  TCLAP::SwitchArg writeIntermediateFiles ("", "write_intermediate_files", "Write the volume and nuisance parameters of every resolution to the temp directory", false);
+  cmd.add(writeIntermediateFiles);
+  TCLAP::ValueArg<std::string> snapshotPolicy("", "snapshot_policy", "Which intermediate volumes to write for display: none, every, iterations, seconds or latest", false, "every", "every");
+  cmd.add(snapshotPolicy);
+  TCLAP::ValueArg<double> snapshotInterval("", "snapshot_interval", "Iterations (iterations policy) or seconds (seconds policy) between intermediate volumes", false, 1.0, "1");
+  cmd.add(snapshotInterval);
+  TCLAP::ValueArg<double> checkpointInterval("", "checkpoint_interval", "Seconds between checkpoints of the reconstruction state. 0 only writes one when cancelled, -1 disables them", false, -1.0, "-1");
+  cmd.add(checkpointInterval);
+  TCLAP::ValueArg<std::string> resumeFile("", "resume", "Checkpoint to restart the reconstruction from", false, "", "");
+  cmd.add(resumeFile);
 
 
   TCLAP::ValueArg<std::string> initialReconstructionPath("i", "initial_recon_file", "Initial Reconstruction to initialize algorithm", false, "", "");
@@ -210,7 +227,20 @@ int HAADFReconstructionArgsParser::parseArguments(int argc, char** argv, HAADF_M
   TCLAP::ValueArg<std::string> viewMask("", "exclude_views", "Comma separated list of tilts to exclude by index", false, "", "");
   cmd.add(viewMask);
 
+  TCLAP::ValueArg<double> memoryBudget("", "memory_budget", "Memory in GB the reconstruction may use. 0 does not limit it", false, 0.0, "0");
+  cmd.add(memoryBudget);
+  TCLAP::ValueArg<std::string> memoryReport("", "memory_report", "JSON file the memory used by every named array and resolution is written to", false, "", "");
+  cmd.add(memoryReport);
+  TCLAP::SwitchArg planOnly("", "plan", "Print the memory every resolution needs and exit without reconstructing", false);
+  cmd.add(planOnly);
+  TCLAP::SwitchArg trackCost("", "track_cost", "Track the cost through the voxel updates and warn when it increases", false);
+  cmd.add(trackCost);
 
+
+  if(argc < 2 && m_ExitOnError == false)
+  {
+    return -1;
+  }
   if(argc < 2)
   {
     std::cout << "Scale Offset Correction Command Line Version " << cmd.getVersion() << std::endl;
@@ -258,11 +288,40 @@ int HAADFReconstructionArgsParser::parseArguments(int argc, char** argv, HAADF_M
     m_MultiResSOC->setExtendObject(extendObject.getValue());
     m_MultiResSOC->setDefaultVariance(defaultVariance.getValue());
     m_MultiResSOC->setInitialReconstructionValue(defaultInitialRecon.getValue());
+    m_MultiResSOC->setSIRTIterations(sirtIterations.getValue());
 
     m_MultiResSOC->setInterpolateInitialReconstruction(interpolateInitialRecontruction.getValue());
     m_MultiResSOC->setDeleteTempFiles(m_DeleteTempFiles.getValue());
+    m_MultiResSOC->setWriteIntermediateFiles(writeIntermediateFiles.getValue());
+    int policy = ReconstructionSnapshotWriter::PolicyFromString(snapshotPolicy.getValue());
+    if(policy < 0)
+    {
+      std::cout << "Unknown snapshot policy '" << snapshotPolicy.getValue() << "'. It should be one of none, every, iterations, seconds or latest" << std::endl;
+      return -1;
+    }
+    m_MultiResSOC->setSnapshotPolicy(policy);
+    if(memoryBudget.getValue() < 0.0)
+    {
+      std::cout << "The memory budget can not be negative" << std::endl;
+      return -1;
+    }
+    m_MultiResSOC->setMemoryBudget(static_cast<uint64_t>(memoryBudget.getValue() * 1073741824.0));
+    m_MultiResSOC->setMemoryReportFile(memoryReport.getValue());
+    m_PlanOnly = planOnly.getValue();
+    m_MultiResSOC->setSnapshotInterval(snapshotInterval.getValue());
+    if((checkpointInterval.getValue() >= 0 || resumeFile.getValue().empty() == false) && ReconstructionCheckpoint::IsSupported() == false)
+    {
+      std::cout << "Checkpoints need HDF5 support which this build does not have" << std::endl;
+      return -1;
+    }
+    m_MultiResSOC->setCheckpointInterval(checkpointInterval.getValue());
+    m_MultiResSOC->setResumeFile(MXADir::toNativeSeparators(resumeFile.getValue()));
     AdvancedParametersPtr advParams = AdvancedParametersPtr(new AdvancedParameters);
     HAADF_ReconstructionEngine::InitializeAdvancedParams(advParams);
+    if(trackCost.getValue() == true)
+    {
+      advParams->TRACK_COST = 1;
+    }
     m_MultiResSOC->setAdvParams(advParams);
 
     int subvolumeValues[6];
@@ -327,6 +386,11 @@ int HAADFReconstructionArgsParser::parseArguments(int argc, char** argv, HAADF_M
     std::cout << "** Unknown Arguments. Displaying help listing instead. **" << std::endl;
     return -1;
   }
+  catch (TCLAP::ExitException& e)
+  {
+    // Only thrown when ExitOnError is false, e.g. for --help or --version
+    return -1;
+  }
   return 0;
 }
 
@@ -364,6 +428,7 @@ void HAADFReconstructionArgsParser::printInputs(TomoInputsPtr inputs, std::ostre
   PRINT_VAR(out, inputs, useDefaultOffset);
   PRINT_VAR(out, inputs, defaultOffset);
   PRINT_VAR(out, inputs, defaultInitialRecon);
+  PRINT_VAR(out, inputs, NumSIRTIter);
   PRINT_VAR(out, inputs, defaultVariance);
 
   PRINT_VAR(out, inputs, sinoFile);
@@ -56,6 +56,12 @@ class HAADFReconstructionArgsParser
 
     void printInputs(TomoInputsPtr inputs, std::ostream& out);
 
+    /* Only print the memory plan instead of reconstructing (--plan) */
+    MXA_INSTANCE_PROPERTY(bool, PlanOnly)
+
+    /* When false a bad argument or --help returns -1 instead of exiting the process */
+    MXA_INSTANCE_PROPERTY(bool, ExitOnError)
+
   private:
     uint64_t startm;
     uint64_t stopm;
@@ -0,0 +1,177 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "HAADFServerSubmission.h"
+
+#include <stdlib.h>
+
+#include <iostream>
+
+#include "MXA/Utilities/MXADir.h"
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADFServerSubmission::HAADFServerSubmission() :
+  m_SocketPath(""),
+  m_Priority(0)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADFServerSubmission::~HAADFServerSubmission()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADFServerSubmission::parseArguments(int argc, char** argv)
+{
+  bool server = false;
+  m_Arguments.clear();
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg(argv[i]);
+    if(arg.compare("--server") == 0 || arg.compare("--priority") == 0)
+    {
+      if(i + 1 >= argc)
+      {
+        std::cout << arg << " needs a value" << std::endl;
+        return -1;
+      }
+      std::string value(argv[++i]);
+      if(arg.compare("--server") == 0)
+      {
+        m_SocketPath = value;
+        server = true;
+      }
+      else
+      {
+        m_Priority = atoi(value.c_str());
+      }
+      continue;
+    }
+    m_Arguments.push_back(arg);
+  }
+  return (server == true) ? 1 : 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADFServerSubmission::execute()
+{
+  ServerConnection::Pointer connection = ServerConnection::New();
+  if(connection->connect(m_SocketPath) < 0)
+  {
+    std::cout << connection->getErrorMessage() << std::endl;
+    return -1;
+  }
+
+  ServerMessage submit;
+  submit.setString("command", "submit");
+  submit.setStrings("arguments", m_Arguments);
+  submit.setNumber("priority", m_Priority);
+  submit.setString("client", "HAADFReconstruction");
+  // The server resolves relative paths against this directory
+  submit.setString("directory", MXADir::currentPath());
+  if(connection->writeMessage(submit) < 0)
+  {
+    std::cout << connection->getErrorMessage() << std::endl;
+    return -1;
+  }
+
+  ServerMessage event;
+  while (true)
+  {
+    int err = connection->readMessage(event);
+    if(err == -2)
+    {
+      continue;
+    }
+    if(err <= 0)
+    {
+      std::cout << "The server hung up before the job finished" << std::endl;
+      return -1;
+    }
+
+    std::string name = event.getString("event");
+    int job = static_cast<int>(event.getNumber("job", -1.0));
+    if(name == "queued")
+    {
+      std::cout << "Queued as job " << job << " behind " << event.getNumber("position") << " other jobs" << std::endl;
+    }
+    else if(name == "started")
+    {
+      std::cout << "Job " << job << " started: " << event.getString("input") << " -> " << event.getString("output") << std::endl;
+    }
+    else if(name == "progress")
+    {
+      std::cout << event.getNumber("value") << "%" << std::endl;
+    }
+    else if(name == "message")
+    {
+      std::string level = event.getString("level");
+      if(level == "warning")
+      {
+        std::cout << "Warning Message: ";
+      }
+      else if(level == "error")
+      {
+        std::cout << "Error Message: ";
+      }
+      std::cout << event.getString("text") << std::endl;
+    }
+    else if(name == "image")
+    {
+      std::cout << "Intermediate Output is ready: " << event.getString("path") << std::endl;
+    }
+    else if(name == "error")
+    {
+      std::cout << "Error from the server: " << event.getString("text") << std::endl;
+      return -1;
+    }
+    else if(name == "finished")
+    {
+      std::string status = event.getString("status");
+      std::cout << "Job " << job << " " << status << " after " << event.getNumber("seconds") << " seconds" << std::endl;
+      return (status == "ok") ? 0 : -1;
+    }
+  }
+}
@@ -0,0 +1,84 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _HAADFServerSubmission_H_
+#define _HAADFServerSubmission_H_
+
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/Common/ServerProtocol.h"
+
+/**
+ * @class HAADFServerSubmission HAADFServerSubmission.h HAADFReconstruction/HAADFServerSubmission.h
+ * @brief Hands the reconstruction to a running mbird server instead of
+ * running it in this process:
+ *
+ *   HAADFReconstruction --server /tmp/mbird.sock --priority 1 -s tilt.mrc --outputfile out.mrc ...
+ *
+ * The progress and messages of the job are printed as the server sends them.
+ * The job keeps running on the server if this program is stopped.
+ */
+class HAADFServerSubmission
+{
+  public:
+    HAADFServerSubmission();
+    virtual ~HAADFServerSubmission();
+
+    MXA_INSTANCE_STRING_PROPERTY(SocketPath)
+    MXA_INSTANCE_PROPERTY(int, Priority)
+    MXA_INSTANCE_PROPERTY(std::vector<std::string>, Arguments)
+
+    /**
+     * @brief Takes --server and --priority out of the command line
+     * @return 1 if the job goes to a server, 0 if it does not and -1 if the arguments are wrong
+     */
+    int parseArguments(int argc, char** argv);
+
+    /**
+     * @brief Submits the job and prints its events until it finished
+     * @return Error condition. Negative if the job did not finish successfully
+     */
+    int execute();
+
+  private:
+    HAADFServerSubmission(const HAADFServerSubmission&); // Copy Constructor Not Implemented
+    void operator=(const HAADFServerSubmission&); // Operator '=' Not Implemented
+};
+
+#endif /* _HAADFServerSubmission_H_ */
@@ -0,0 +1,198 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "HAADFStreamingReconstruction.h"
+
+#include <stdlib.h>
+
+#include <iostream>
+
+#if defined (_MSC_VER)
+#include <windows.h>
+#define MBIR_STREAMING_SLEEP(ms) Sleep(ms)
+#else
+#include <unistd.h>
+#define MBIR_STREAMING_SLEEP(ms) ::usleep((ms) * 1000)
+#endif
+
+#include "MXA/Utilities/MXADir.h"
+#include "MXA/Utilities/MXAFileInfo.h"
+
+#include "MBIRLib/Common/EIMTime.h"
+#include "MBIRLib/HAADF/HAADF_MultiResolutionReconstruction.h"
+#include "MBIRLib/HAADF/HAADF_StreamingReconstruction.h"
+
+#include "HAADFReconstructionArgsParser.h"
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADFStreamingReconstruction::HAADFStreamingReconstruction() :
+  m_MinimumTilts(3),
+  m_ExpectedTilts(0),
+  m_IdleTimeout(600.0f),
+  m_PollInterval(2.0f)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADFStreamingReconstruction::~HAADFStreamingReconstruction()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADFStreamingReconstruction::parseArguments(int argc, char** argv)
+{
+  bool stream = false;
+  m_BaseArguments.clear();
+  m_ProgramName = (argc > 0) ? std::string(argv[0]) : std::string("HAADFReconstruction");
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg(argv[i]);
+    if(arg.compare("--stream") == 0)
+    {
+      stream = true;
+      continue;
+    }
+    if(arg.compare("--stream_min_tilts") == 0 || arg.compare("--stream_expected_tilts") == 0
+        || arg.compare("--stream_idle_timeout") == 0 || arg.compare("--stream_poll") == 0)
+    {
+      if(i + 1 >= argc)
+      {
+        std::cout << arg << " needs a value" << std::endl;
+        return -1;
+      }
+      std::string value(argv[++i]);
+      if(arg.compare("--stream_min_tilts") == 0)
+      {
+        m_MinimumTilts = atoi(value.c_str());
+      }
+      else if(arg.compare("--stream_expected_tilts") == 0)
+      {
+        m_ExpectedTilts = atoi(value.c_str());
+      }
+      else if(arg.compare("--stream_idle_timeout") == 0)
+      {
+        m_IdleTimeout = static_cast<float>(atof(value.c_str()));
+      }
+      else
+      {
+        m_PollInterval = static_cast<float>(atof(value.c_str()));
+      }
+      continue;
+    }
+    m_BaseArguments.push_back(arg);
+  }
+  if(m_MinimumTilts < 1 || m_ExpectedTilts < 0 || m_IdleTimeout < 0.0f || m_PollInterval <= 0.0f)
+  {
+    std::cout << "--stream_min_tilts must be at least 1, --stream_poll positive and the others can not be negative" << std::endl;
+    return -1;
+  }
+  return (stream == true) ? 1 : 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADFStreamingReconstruction::execute()
+{
+  std::string inputFile;
+  int tiltSelection = 0;
+  for (size_t i = 0; i + 1 < m_BaseArguments.size(); ++i)
+  {
+    if(m_BaseArguments[i].compare("-s") == 0 || m_BaseArguments[i].compare("--sinofile") == 0)
+    {
+      inputFile = m_BaseArguments[i + 1];
+    }
+    else if(m_BaseArguments[i].compare("--tilt_selection") == 0)
+    {
+      tiltSelection = atoi(m_BaseArguments[i + 1].c_str());
+    }
+  }
+
+  // The arguments can only be parsed once the header of the stack is there
+  if(inputFile.empty() == false)
+  {
+    std::cout << "Waiting for " << inputFile << std::endl;
+    unsigned long long start = EIMTOMO_getMilliSeconds();
+    while (MXAFileInfo::exists(inputFile) == false || MXAFileInfo::fileSize(inputFile) < 1024)
+    {
+      if(m_IdleTimeout > 0.0f && EIMTOMO_getMilliSeconds() - start > static_cast<unsigned long long>(m_IdleTimeout * 1000.0f))
+      {
+        std::cout << inputFile << " did not show up within " << m_IdleTimeout << " s" << std::endl;
+        return -1;
+      }
+      MBIR_STREAMING_SLEEP(static_cast<unsigned int>(m_PollInterval * 1000.0f));
+    }
+  }
+
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>(m_ProgramName.c_str()));
+  for (size_t a = 0; a < m_BaseArguments.size(); ++a)
+  {
+    argv.push_back(const_cast<char*>(m_BaseArguments[a].c_str()));
+  }
+  HAADF_MultiResolutionReconstruction::Pointer reconstruction = HAADF_MultiResolutionReconstruction::New();
+  HAADFReconstructionArgsParser argParser;
+  if(argParser.parseArguments(static_cast<int>(argv.size()), &(argv.front()), reconstruction) < 0)
+  {
+    std::cout << "Error Parsing the arguments." << std::endl;
+    return -1;
+  }
+  if(argParser.getPlanOnly() == true)
+  {
+    std::cout << "--plan can not be combined with --stream" << std::endl;
+    return -1;
+  }
+  if(MXADir::exists(reconstruction->getTempDir()) == false && MXADir::mkdir(reconstruction->getTempDir(), true) == false)
+  {
+    std::cout << "Error creating the output directory '" << reconstruction->getTempDir() << "'" << std::endl;
+    return -1;
+  }
+
+  HAADF_StreamingReconstruction::Pointer streaming = HAADF_StreamingReconstruction::New();
+  streaming->setReconstruction(reconstruction);
+  streaming->setTiltSelection(tiltSelection);
+  streaming->setMinimumTilts(m_MinimumTilts);
+  streaming->setExpectedTilts(m_ExpectedTilts);
+  streaming->setIdleTimeout(m_IdleTimeout);
+  streaming->setPollInterval(m_PollInterval);
+  return streaming->execute();
+}
@@ -0,0 +1,85 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _HAADFStreamingReconstruction_H_
+#define _HAADFStreamingReconstruction_H_
+
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+/**
+ * @class HAADFStreamingReconstruction HAADFStreamingReconstruction.h HAADFReconstruction/HAADFStreamingReconstruction.h
+ * @brief Reconstructs a tilt series while the microscope is still writing it
+ * (--stream). The input file may not exist yet when this starts. Every time
+ * new tilts are complete the output file is replaced by a reconstruction that
+ * includes them, warm started from the one before (see HAADF_StreamingReconstruction).
+ *
+ * The stream ends when --stream_expected_tilts tilts are reconstructed or no
+ * tilt arrived for --stream_idle_timeout seconds.
+ */
+class HAADFStreamingReconstruction
+{
+  public:
+    HAADFStreamingReconstruction();
+    virtual ~HAADFStreamingReconstruction();
+
+    MXA_INSTANCE_STRING_PROPERTY(ProgramName)
+    MXA_INSTANCE_PROPERTY(std::vector<std::string>, BaseArguments)
+    MXA_INSTANCE_PROPERTY(int, MinimumTilts)
+    MXA_INSTANCE_PROPERTY(int, ExpectedTilts)
+    MXA_INSTANCE_PROPERTY(float, IdleTimeout)
+    MXA_INSTANCE_PROPERTY(float, PollInterval)
+
+    /**
+     * @brief Takes --stream and the --stream_* arguments out of the command line
+     * @return 1 if this is a streaming run, 0 if it is not and -1 if the arguments are wrong
+     */
+    int parseArguments(int argc, char** argv);
+
+    /**
+     * @brief Waits for the input file, then reconstructs rounds until the stream ends
+     * @return Error condition
+     */
+    int execute();
+
+  private:
+    HAADFStreamingReconstruction(const HAADFStreamingReconstruction&); // Copy Constructor Not Implemented
+    void operator=(const HAADFStreamingReconstruction&); // Operator '=' Not Implemented
+};
+
+#endif /* _HAADFStreamingReconstruction_H_ */
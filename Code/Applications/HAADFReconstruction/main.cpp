@@ -46,6 +46,10 @@
 #include "MBIRLib/HAADF/HAADF_ReconstructionEngine.h"
 #include "MBIRLib/HAADF/HAADF_MultiResolutionReconstruction.h"
 #include "HAADFReconstructionArgsParser.h"
+#include "HAADFBatchReconstruction.h"
+#include "HAADFParameterSweep.h"
+#include "HAADFServerSubmission.h"
+#include "HAADFStreamingReconstruction.h"
 
 int main(int argc, char** argv)
 {
@@ -53,6 +57,66 @@ int main(int argc, char** argv)
 
 
 
+  // --server hands the job to a running mbird
+  HAADFServerSubmission submission;
+  int serverMode = submission.parseArguments(argc, argv);
+  if(serverMode < 0)
+  {
+    std::cout << "Error Parsing the arguments." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if(serverMode > 0)
+  {
+    return (submission.execute() < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+  }
+
+  // --stream reconstructs a tilt series while it is being acquired
+  HAADFStreamingReconstruction streaming;
+  int streamMode = streaming.parseArguments(argc, argv);
+  if(streamMode < 0)
+  {
+    std::cout << "Error Parsing the arguments." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if(streamMode > 0)
+  {
+    return (streaming.execute() < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+  }
+
+  // --sweep_sigma_x and --sweep_diffuseness reconstruct a grid of prior parameters
+  HAADFParameterSweep sweep;
+  int sweepMode = sweep.parseArguments(argc, argv);
+  if(sweepMode < 0)
+  {
+    std::cout << "Error Parsing the arguments." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if(sweepMode > 0)
+  {
+    if(sweep.initialize() < 0)
+    {
+      return EXIT_FAILURE;
+    }
+    return (sweep.execute() < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+  }
+
+  // --batch runs every line of a manifest in this process
+  HAADFBatchReconstruction batch;
+  int batchMode = batch.parseArguments(argc, argv);
+  if(batchMode < 0)
+  {
+    std::cout << "Error Parsing the arguments." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if(batchMode > 0)
+  {
+    if(batch.readManifest() < 0)
+    {
+      return EXIT_FAILURE;
+    }
+    return (batch.execute() < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+  }
+
   HAADF_MultiResolutionReconstruction::Pointer engine = HAADF_MultiResolutionReconstruction::New();
 
   HAADFReconstructionArgsParser argParser;
@@ -63,6 +127,19 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
+  // A dry run only reports whether the reconstruction fits
+  if(argParser.getPlanOnly() == true)
+  {
+    MemoryPlanner::Pointer plan = engine->planMemory();
+    if(NULL == plan.get())
+    {
+      std::cout << "Could not plan the memory of '" << engine->getInputFile() << "'. Only MRC files can be planned." << std::endl;
+      return EXIT_FAILURE;
+    }
+    plan->printPlan(std::cout);
+    return (plan->getFeasible() == true) ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
 
 #if 0
   char path1[MAXPATHLEN]; // This is a buffer for the text
@@ -0,0 +1,938 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "MBIRServer.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <sstream>
+
+#if defined (_MSC_VER)
+#include <windows.h>
+#define MBIR_SERVER_SLEEP(ms) Sleep(ms)
+#else
+#define MBIR_SERVER_SLEEP(ms) ::usleep((ms) * 1000)
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+#include <tclap/CmdLine.h>
+#include <tclap/ValueArg.h>
+
+#include "MXA/Utilities/MXADir.h"
+#include "MXA/Utilities/MXAFileInfo.h"
+
+#include "MBIRLib/MBIRLibVersion.h"
+#include "MBIRLib/Common/EIMTime.h"
+#include "MBIRLib/GenericFilters/MemoryPlanner.h"
+
+#include "HAADFReconstructionArgsParser.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_scheduler_init.h>
+#include <tbb/tbb_thread.h>
+#define MBIR_SERVER_LOCK tbb::spin_mutex::scoped_lock serverLock(m_Mutex);
+#define MBIR_SERVER_PARSE_LOCK tbb::spin_mutex::scoped_lock parseLock(m_ParseMutex);
+#else
+#define MBIR_SERVER_LOCK
+#define MBIR_SERVER_PARSE_LOCK
+#endif
+
+namespace Detail
+{
+  /**
+   * @brief A reconstruction that sends its notifications to the client that
+   * submitted it instead of printing them
+   */
+  class ServedReconstruction : public HAADF_MultiResolutionReconstruction
+  {
+    public:
+      MXA_SHARED_POINTERS(ServedReconstruction)
+      MXA_TYPE_MACRO_SUPER(ServedReconstruction, HAADF_MultiResolutionReconstruction)
+      MXA_STATIC_NEW_MACRO(ServedReconstruction)
+
+      virtual ~ServedReconstruction() {}
+
+      void setJob(ServerConnection::Pointer connection, int job)
+      {
+        m_Connection = connection;
+        m_Job = job;
+      }
+
+      virtual void updateProgressAndMessage(const char* message, int progress)
+      {
+        pipelineProgress(progress);
+        pipelineProgressMessage(message);
+      }
+
+      virtual void updateProgressAndMessage(const std::string& msg, int progress)
+      {
+        updateProgressAndMessage(msg.c_str(), progress);
+      }
+
+      virtual void pipelineProgress(int value)
+      {
+        ServerMessage event;
+        event.setString("event", "progress");
+        event.setNumber("value", value);
+        MBIRServer::SendJobEvent(m_Connection, m_Job, event);
+      }
+
+      virtual void pipelineProgressMessage(const char* message)
+      {
+        sendMessage("info", message);
+      }
+
+      virtual void pipelineProgressMessage(const std::string& msg)
+      {
+        sendMessage("info", msg);
+      }
+
+      virtual void pipelineWarningMessage(const char* message)
+      {
+        sendMessage("warning", message);
+      }
+
+      virtual void pipelineWarningMessage(const std::string& msg)
+      {
+        sendMessage("warning", msg);
+      }
+
+      virtual void pipelineErrorMessage(const char* message)
+      {
+        sendMessage("error", message);
+      }
+
+      virtual void pipelineErrorMessage(const std::string& msg)
+      {
+        sendMessage("error", msg);
+      }
+
+      virtual void updateIntermediateImage(const std::string& filepath)
+      {
+        ServerMessage event;
+        event.setString("event", "image");
+        event.setString("path", filepath);
+        MBIRServer::SendJobEvent(m_Connection, m_Job, event);
+      }
+
+    protected:
+      ServedReconstruction() : HAADF_MultiResolutionReconstruction(), m_Job(-1) {}
+
+      void sendMessage(const std::string& level, const std::string& text)
+      {
+        ServerMessage event;
+        event.setString("event", "message");
+        event.setString("level", level);
+        event.setString("text", text);
+        MBIRServer::SendJobEvent(m_Connection, m_Job, event);
+      }
+
+    private:
+      ServerConnection::Pointer m_Connection;
+      int m_Job;
+
+      ServedReconstruction(const ServedReconstruction&); // Copy Constructor Not Implemented
+      void operator=(const ServedReconstruction&); // Operator '=' Not Implemented
+  };
+
+  /**
+   * @brief Serves one client on its own thread
+   */
+  class ClientWorker
+  {
+    public:
+      ClientWorker(MBIRServer* server, ServerConnection::Pointer connection) :
+        m_Server(server),
+        m_Connection(connection)
+      {
+      }
+
+      virtual ~ClientWorker() {}
+
+      void operator()() const
+      {
+        m_Server->serveClient(m_Connection);
+      }
+
+    private:
+      MBIRServer* m_Server;
+      ServerConnection::Pointer m_Connection;
+  };
+
+  /**
+   * @brief Runs queued jobs on its own thread. The task scheduler it creates
+   * limits the reconstructions of the thread to their share of the pool.
+   */
+  class JobWorker
+  {
+    public:
+      JobWorker(MBIRServer* server, int numThreads) :
+        m_Server(server),
+        m_NumThreads(numThreads)
+      {
+      }
+
+      virtual ~JobWorker() {}
+
+      void operator()() const
+      {
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+        tbb::task_scheduler_init init(m_NumThreads);
+#endif
+        m_Server->runQueuedJobs();
+      }
+
+    private:
+      MBIRServer* m_Server;
+      int m_NumThreads;
+  };
+
+  /* The arguments of HAADFReconstruction whose value is a file */
+  bool isPathFlag(const std::string& arg)
+  {
+    static const char* flags[] = { "-s", "--sinofile", "--brightfield", "--outputfile", "-i", "--initial_recon_file",
+                                   "--gains", "--offsets", "--variance", NULL };
+    for (int i = 0; flags[i] != NULL; ++i)
+    {
+      if(arg == flags[i])
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /* Relative paths of a client are relative to its working directory, not the one of the server */
+  void resolvePaths(std::vector<std::string>& args, const std::string& directory)
+  {
+    if(directory.empty() == true)
+    {
+      return;
+    }
+    for (size_t i = 0; i + 1 < args.size(); ++i)
+    {
+      if(isPathFlag(args[i]) == true && args[i + 1].empty() == false && MXAFileInfo::isRelativePath(args[i + 1]) == true)
+      {
+        args[i + 1] = directory + MXADir::getSeparator() + args[i + 1];
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MBIRServer::MBIRServer() :
+  m_ProgramName("mbird"),
+  m_SocketPath(""),
+  m_ConcurrentJobs(1),
+  m_NumberOfThreads(0),
+  m_NextJobId(1),
+  m_ListenSocket(-1),
+  m_Shutdown(false),
+  m_ActiveClients(0)
+{
+  m_PrecomputeCache = HAADF_PrecomputeCache::New();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MBIRServer::~MBIRServer()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MBIRServer::parseArguments(int argc, char** argv)
+{
+  TCLAP::CmdLine cmd("", ' ', MBIRLib::Version::Complete());
+
+  TCLAP::ValueArg<std::string> socketPath("", "socket", "The UNIX domain socket to listen on", false, "/tmp/mbird.sock", "/tmp/mbird.sock");
+  cmd.add(socketPath);
+  TCLAP::ValueArg<int> concurrentJobs("", "jobs", "Reconstructions that run at the same time", false, 1, "1");
+  cmd.add(concurrentJobs);
+  TCLAP::ValueArg<int> numThreads("", "threads", "Threads shared by all reconstructions. 0 uses every core", false, 0, "0");
+  cmd.add(numThreads);
+
+  try
+  {
+    cmd.parse(argc, argv);
+    m_ProgramName = argv[0];
+    m_SocketPath = socketPath.getValue();
+    m_ConcurrentJobs = concurrentJobs.getValue();
+    m_NumberOfThreads = numThreads.getValue();
+    if(m_ConcurrentJobs < 1 || m_NumberOfThreads < 0)
+    {
+      std::cout << "--jobs must be at least 1 and --threads can not be negative" << std::endl;
+      return -1;
+    }
+  }
+  catch (TCLAP::ArgException& e)
+  {
+    std::cerr << " error: " << e.error() << " for arg " << e.argId() << std::endl;
+    return -1;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MBIRServer::SendJobEvent(ServerConnection::Pointer connection, int job, ServerMessage& event)
+{
+  if(NULL == connection.get())
+  {
+    return;
+  }
+  event.setNumber("job", job);
+  // A client that went away does not stop its job
+  connection->writeMessage(event);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MBIRServer::sendError(ServerConnection::Pointer connection, const std::string& text)
+{
+  ServerMessage event;
+  event.setString("event", "error");
+  event.setString("text", text);
+  connection->writeMessage(event);
+}
+
+#if defined (_MSC_VER)
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MBIRServer::listen()
+{
+  std::cout << "The reconstruction server is not available on Windows" << std::endl;
+  return -1;
+}
+
+#else
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MBIRServer::listen()
+{
+  struct sockaddr_un address;
+  ::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if(m_SocketPath.size() >= sizeof(address.sun_path))
+  {
+    std::cout << "The socket path is too long: " << m_SocketPath << std::endl;
+    return -1;
+  }
+  ::strncpy(address.sun_path, m_SocketPath.c_str(), sizeof(address.sun_path) - 1);
+
+  m_ListenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if(m_ListenSocket < 0)
+  {
+    std::cout << "Could not create a socket (" << strerror(errno) << ")" << std::endl;
+    return -1;
+  }
+  ::unlink(m_SocketPath.c_str());
+  if(::bind(m_ListenSocket, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0
+      || ::listen(m_ListenSocket, 16) != 0)
+  {
+    std::cout << "Could not listen on " << m_SocketPath << " (" << strerror(errno) << ")" << std::endl;
+    ::close(m_ListenSocket);
+    m_ListenSocket = -1;
+    return -1;
+  }
+  // Jobs read and write files as the user running the server
+  ::chmod(m_SocketPath.c_str(), S_IRUSR | S_IWUSR);
+  return 0;
+}
+
+#endif
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MBIRServer::execute()
+{
+  if(listen() < 0)
+  {
+    return -1;
+  }
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  int numThreads = m_NumberOfThreads;
+  if(numThreads == 0)
+  {
+    numThreads = tbb::task_scheduler_init::default_num_threads();
+  }
+  // Keeps the worker threads of the pool alive between jobs
+  tbb::task_scheduler_init init(numThreads);
+  int threadsPerJob = numThreads / m_ConcurrentJobs;
+  if(threadsPerJob < 1)
+  {
+    threadsPerJob = 1;
+  }
+  std::vector<tbb::tbb_thread*> workers(m_ConcurrentJobs, NULL);
+  for (int i = 0; i < m_ConcurrentJobs; ++i)
+  {
+    workers[i] = new tbb::tbb_thread(Detail::JobWorker(this, threadsPerJob));
+  }
+  std::cout << "mbird " << MBIRLib::Version::Complete() << " listening on " << m_SocketPath << ", running "
+            << m_ConcurrentJobs << " jobs at a time with " << threadsPerJob << " threads each" << std::endl;
+#else
+  std::cout << "mbird " << MBIRLib::Version::Complete() << " listening on " << m_SocketPath
+            << ", serving one client at a time" << std::endl;
+#endif
+
+#if !defined (_MSC_VER)
+  while (true)
+  {
+    {
+      MBIR_SERVER_LOCK
+      if(m_Shutdown == true)
+      {
+        break;
+      }
+    }
+    // Wake up now and then to notice a shutdown
+    struct pollfd pfd;
+    pfd.fd = m_ListenSocket;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    if(::poll(&pfd, 1, 250) <= 0)
+    {
+      continue;
+    }
+    int s = ::accept(m_ListenSocket, NULL, NULL);
+    if(s < 0)
+    {
+      continue;
+    }
+    ServerConnection::Pointer connection = ServerConnection::New();
+    connection->attach(s);
+    {
+      MBIR_SERVER_LOCK
+      m_Connections.push_back(connection);
+      ++m_ActiveClients;
+    }
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    tbb::tbb_thread* client = new tbb::tbb_thread(Detail::ClientWorker(this, connection));
+    client->detach();
+    delete client;
+#else
+    serveClient(connection);
+#endif
+  }
+
+  ::close(m_ListenSocket);
+  ::unlink(m_SocketPath.c_str());
+  m_ListenSocket = -1;
+#endif
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  // The running jobs finish before the clients are sent away
+  for (int i = 0; i < m_ConcurrentJobs; ++i)
+  {
+    workers[i]->join();
+    delete workers[i];
+  }
+#endif
+  std::vector<ServerConnection::Pointer> connections;
+  {
+    MBIR_SERVER_LOCK
+    connections = m_Connections;
+  }
+  for (size_t i = 0; i < connections.size(); ++i)
+  {
+    connections[i]->close();
+  }
+  while (true)
+  {
+    {
+      MBIR_SERVER_LOCK
+      if(m_ActiveClients == 0)
+      {
+        break;
+      }
+    }
+    MBIR_SERVER_SLEEP(100);
+  }
+  std::cout << "mbird stopped" << std::endl;
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MBIRServer::serveClient(ServerConnection::Pointer connection)
+{
+  ServerMessage command;
+  while (true)
+  {
+    int err = connection->readMessage(command);
+    if(err == 0 || err == -1)
+    {
+      break;
+    }
+    if(err == -2)
+    {
+      sendError(connection, connection->getErrorMessage());
+      continue;
+    }
+
+    std::string name = command.getString("command");
+    if(name == "submit")
+    {
+      submit(connection, command);
+#if !defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+      while (runNextJob() == true)
+      {
+      }
+#endif
+    }
+    else if(name == "status")
+    {
+      sendStatus(connection);
+    }
+    else if(name == "cancel")
+    {
+      cancel(connection, command);
+    }
+    else if(name == "clear_cache")
+    {
+      m_PrecomputeCache->clear();
+      ServerMessage event;
+      event.setString("event", "cache_cleared");
+      connection->writeMessage(event);
+    }
+    else if(name == "shutdown")
+    {
+      shutdown(connection);
+      break;
+    }
+    else
+    {
+      sendError(connection, "Unknown command '" + name + "'");
+    }
+  }
+
+  connection->close();
+  MBIR_SERVER_LOCK
+  for (std::vector<ServerConnection::Pointer>::iterator iter = m_Connections.begin(); iter != m_Connections.end(); ++iter)
+  {
+    if((*iter).get() == connection.get())
+    {
+      m_Connections.erase(iter);
+      break;
+    }
+  }
+  --m_ActiveClients;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MBIRServer::submit(ServerConnection::Pointer connection, const ServerMessage& command)
+{
+  std::vector<std::string> arguments = command.getStrings("arguments");
+  if(arguments.empty() == true)
+  {
+    sendError(connection, "A submit needs the arguments of the reconstruction");
+    return -1;
+  }
+  Detail::resolvePaths(arguments, command.getString("directory"));
+
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>(m_ProgramName.c_str()));
+  for (size_t a = 0; a < arguments.size(); ++a)
+  {
+    argv.push_back(const_cast<char*>(arguments[a].c_str()));
+  }
+
+  Detail::ServedReconstruction::Pointer reconstruction = Detail::ServedReconstruction::New();
+  HAADFReconstructionArgsParser argParser;
+  argParser.setExitOnError(false);
+  int err = 0;
+  {
+    // TCLAP keeps some state in statics
+    MBIR_SERVER_PARSE_LOCK
+    err = argParser.parseArguments(static_cast<int>(argv.size()), &(argv.front()), reconstruction);
+  }
+  if(err < 0)
+  {
+    sendError(connection, "The arguments could not be parsed. The log of the server has the details.");
+    return -1;
+  }
+  reconstruction->setPrecomputeCache(m_PrecomputeCache);
+
+  MBIRServerJob job;
+  job.Priority = static_cast<int>(command.getNumber("priority", 0.0));
+  job.Client = command.getString("client", "anonymous");
+  job.Connection = connection;
+  job.Reconstruction = reconstruction;
+  job.PlanOnly = argParser.getPlanOnly();
+  job.Running = false;
+
+  std::stringstream ss;
+  int position = 0;
+  {
+    MBIR_SERVER_LOCK
+    if(m_Shutdown == true)
+    {
+      ss << "The server is shutting down";
+    }
+    bool sharedTempDir = false;
+    for (std::map<int, MBIRServerJob>::iterator iter = m_Jobs.begin(); iter != m_Jobs.end(); ++iter)
+    {
+      HAADF_MultiResolutionReconstruction::Pointer other = (*iter).second.Reconstruction;
+      if(job.PlanOnly == false && (*iter).second.PlanOnly == false && other->getOutputFile() == reconstruction->getOutputFile())
+      {
+        ss << "Job " << (*iter).first << " already writes '" << reconstruction->getOutputFile() << "'";
+      }
+      sharedTempDir |= (other->getTempDir() == reconstruction->getTempDir());
+      if((*iter).second.Running == false && (*iter).second.Priority >= job.Priority)
+      {
+        ++position;
+      }
+    }
+    if(ss.str().empty() == true)
+    {
+      job.Id = m_NextJobId++;
+      // The temporary files have fixed names so jobs that write next to each
+      // other get a directory of their own
+      if(sharedTempDir == true)
+      {
+        std::stringstream dir;
+        dir << reconstruction->getTempDir() << MXADir::getSeparator() << "job" << job.Id;
+        reconstruction->setTempDir(dir.str());
+      }
+      reconstruction->setJob(connection, job.Id);
+      m_Jobs[job.Id] = job;
+    }
+  }
+  if(ss.str().empty() == false)
+  {
+    sendError(connection, ss.str());
+    return -1;
+  }
+
+  ServerMessage event;
+  event.setString("event", "queued");
+  event.setNumber("position", position);
+  SendJobEvent(connection, job.Id, event);
+  std::cout << "Job " << job.Id << " from " << job.Client << " queued with priority " << job.Priority << ": "
+            << reconstruction->getInputFile() << " -> " << reconstruction->getOutputFile() << std::endl;
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MBIRServer::sendStatus(ServerConnection::Pointer connection)
+{
+  std::vector<std::string> running;
+  std::vector<std::string> queued;
+  {
+    MBIR_SERVER_LOCK
+    for (std::map<int, MBIRServerJob>::iterator iter = m_Jobs.begin(); iter != m_Jobs.end(); ++iter)
+    {
+      std::stringstream ss;
+      ss << (*iter).first;
+      if((*iter).second.Running == true)
+      {
+        running.push_back(ss.str());
+      }
+      else
+      {
+        queued.push_back(ss.str());
+      }
+    }
+  }
+  ServerMessage event;
+  event.setString("event", "status");
+  event.setStrings("running", running);
+  event.setStrings("queued", queued);
+  event.setNumber("geometries", static_cast<double>(m_PrecomputeCache->getNumberOfEntries()));
+  event.setNumber("sinograms", static_cast<double>(m_PrecomputeCache->getNumberOfSinograms()));
+  event.setNumber("hits", static_cast<double>(m_PrecomputeCache->getHits()));
+  event.setNumber("misses", static_cast<double>(m_PrecomputeCache->getMisses()));
+  connection->writeMessage(event);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MBIRServer::cancel(ServerConnection::Pointer connection, const ServerMessage& command)
+{
+  int id = static_cast<int>(command.getNumber("job", -1.0));
+  ServerConnection::Pointer owner;
+  bool found = false;
+  {
+    MBIR_SERVER_LOCK
+    std::map<int, MBIRServerJob>::iterator iter = m_Jobs.find(id);
+    if(iter != m_Jobs.end())
+    {
+      found = true;
+      if((*iter).second.Running == true)
+      {
+        // runJob() reports it once the reconstruction stopped
+        (*iter).second.Reconstruction->setCancel(true);
+      }
+      else
+      {
+        owner = (*iter).second.Connection;
+        m_Jobs.erase(iter);
+      }
+    }
+  }
+  if(found == false)
+  {
+    std::stringstream ss;
+    ss << "There is no job " << id;
+    sendError(connection, ss.str());
+    return;
+  }
+
+  ServerMessage event;
+  event.setString("event", "cancelling");
+  SendJobEvent(connection, id, event);
+  if(NULL != owner.get())
+  {
+    ServerMessage finished;
+    finished.setString("event", "finished");
+    finished.setString("status", "cancelled");
+    finished.setNumber("seconds", 0.0);
+    SendJobEvent(owner, id, finished);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MBIRServer::shutdown(ServerConnection::Pointer connection)
+{
+  std::vector<std::pair<int, ServerConnection::Pointer> > dropped;
+  int running = 0;
+  {
+    MBIR_SERVER_LOCK
+    m_Shutdown = true;
+    std::map<int, MBIRServerJob>::iterator iter = m_Jobs.begin();
+    while (iter != m_Jobs.end())
+    {
+      if((*iter).second.Running == true)
+      {
+        ++running;
+        ++iter;
+      }
+      else
+      {
+        dropped.push_back(std::make_pair((*iter).first, (*iter).second.Connection));
+        m_Jobs.erase(iter++);
+      }
+    }
+  }
+  for (size_t i = 0; i < dropped.size(); ++i)
+  {
+    ServerMessage finished;
+    finished.setString("event", "finished");
+    finished.setString("status", "cancelled");
+    finished.setNumber("seconds", 0.0);
+    SendJobEvent(dropped[i].second, dropped[i].first, finished);
+  }
+  ServerMessage event;
+  event.setString("event", "shutting_down");
+  event.setNumber("running", running);
+  connection->writeMessage(event);
+  std::cout << "Shutting down after " << running << " running jobs" << std::endl;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MBIRServer::takeNextJob()
+{
+  MBIR_SERVER_LOCK
+  int best = -1;
+  // The map is ordered by id so the first of equal jobs was submitted first
+  for (std::map<int, MBIRServerJob>::iterator iter = m_Jobs.begin(); iter != m_Jobs.end(); ++iter)
+  {
+    const MBIRServerJob& job = (*iter).second;
+    if(job.Running == true)
+    {
+      continue;
+    }
+    if(best < 0)
+    {
+      best = (*iter).first;
+      continue;
+    }
+    const MBIRServerJob& current = m_Jobs[best];
+    if(job.Priority > current.Priority
+        || (job.Priority == current.Priority && m_StartedJobs[job.Client] < m_StartedJobs[current.Client]))
+    {
+      best = (*iter).first;
+    }
+  }
+  if(best >= 0)
+  {
+    m_Jobs[best].Running = true;
+    m_StartedJobs[m_Jobs[best].Client]++;
+  }
+  return best;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool MBIRServer::runNextJob()
+{
+  int id = takeNextJob();
+  if(id < 0)
+  {
+    return false;
+  }
+  runJob(id);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MBIRServer::runQueuedJobs()
+{
+  while (true)
+  {
+    if(runNextJob() == true)
+    {
+      continue;
+    }
+    {
+      MBIR_SERVER_LOCK
+      if(m_Shutdown == true)
+      {
+        return;
+      }
+    }
+    MBIR_SERVER_SLEEP(100);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MBIRServer::runJob(int id)
+{
+  MBIRServerJob job;
+  {
+    MBIR_SERVER_LOCK
+    job = m_Jobs[id];
+  }
+  HAADF_MultiResolutionReconstruction::Pointer reconstruction = job.Reconstruction;
+  unsigned long long start = EIMTOMO_getMilliSeconds();
+
+  ServerMessage event;
+  event.setString("event", "started");
+  event.setString("input", reconstruction->getInputFile());
+  event.setString("output", reconstruction->getOutputFile());
+  SendJobEvent(job.Connection, id, event);
+  std::cout << "Job " << id << " started" << std::endl;
+
+  int err = 0;
+  if(job.PlanOnly == true)
+  {
+    MemoryPlanner::Pointer plan = reconstruction->planMemory();
+    if(NULL == plan.get())
+    {
+      reconstruction->pipelineErrorMessage("Only MRC files can be planned");
+      err = -1;
+    }
+    else
+    {
+      std::stringstream ss;
+      plan->printPlan(ss);
+      reconstruction->pipelineProgressMessage(ss.str());
+      err = (plan->getFeasible() == true) ? 0 : -1;
+    }
+  }
+  else if(MXADir::exists(reconstruction->getTempDir()) == false && MXADir::mkdir(reconstruction->getTempDir(), true) == false)
+  {
+    reconstruction->pipelineErrorMessage("Could not create the output directory '" + reconstruction->getTempDir() + "'");
+    err = -1;
+  }
+  else
+  {
+    reconstruction->execute();
+    err = reconstruction->getErrorCondition();
+  }
+
+  std::string status = "ok";
+  if(reconstruction->getCancel() == true)
+  {
+    status = "cancelled";
+  }
+  else if(err < 0)
+  {
+    status = "failed";
+  }
+  double seconds = static_cast<double>(EIMTOMO_getMilliSeconds() - start) / 1000.0;
+
+  ServerMessage finished;
+  finished.setString("event", "finished");
+  finished.setString("status", status);
+  finished.setNumber("seconds", seconds);
+  if(status == "ok" && job.PlanOnly == false)
+  {
+    finished.setString("output", reconstruction->getOutputFile());
+    finished.setNumber("cost", reconstruction->getFinalCost());
+  }
+  SendJobEvent(job.Connection, id, finished);
+  std::cout << "Job " << id << " " << status << " after " << seconds << " s" << std::endl;
+
+  // The volumes of a finished job go away with it. The cache keeps what the
+  // next job of the same geometry needs.
+  MBIR_SERVER_LOCK
+  m_Jobs.erase(id);
+}
@@ -0,0 +1,177 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _MBIRServer_H_
+#define _MBIRServer_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/Common/ServerProtocol.h"
+#include "MBIRLib/HAADF/HAADF_MultiResolutionReconstruction.h"
+#include "MBIRLib/HAADF/HAADF_PrecomputeCache.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/spin_mutex.h>
+#endif
+
+/**
+ * @brief A reconstruction submitted to the server
+ */
+typedef struct
+{
+  int Id;
+  int Priority; // Higher runs first
+  std::string Client; // Name the submitting client gave itself
+  ServerConnection::Pointer Connection; // Where the events of the job go
+  HAADF_MultiResolutionReconstruction::Pointer Reconstruction;
+  bool PlanOnly; // Only send the memory plan (--plan)
+  bool Running;
+} MBIRServerJob;
+
+/**
+ * @class MBIRServer MBIRServer.h MBIRServer/MBIRServer.h
+ * @brief Keeps a HAADF reconstruction process running and takes jobs from
+ * clients over a UNIX domain socket. Jobs of all clients share one
+ * HAADF_PrecomputeCache, so tilt series and A matrices that were loaded once
+ * stay in memory, and one thread pool.
+ *
+ * Every message is one line of flat JSON (see ServerMessage). Clients send
+ * commands:
+ *
+ *   {"command":"submit","arguments":["-s","tilt.mrc","--outputfile","out.mrc",...],
+ *    "priority":0,"client":"gui","directory":"/home/me/data"}
+ *   {"command":"status"}
+ *   {"command":"cancel","job":3}
+ *   {"command":"clear_cache"}
+ *   {"command":"shutdown"}
+ *
+ * The arguments are those of HAADFReconstruction. Relative paths are taken
+ * from "directory". The server answers with events:
+ *
+ *   {"event":"queued","job":3,"position":1}
+ *   {"event":"started","job":3,"input":...,"output":...}
+ *   {"event":"progress","job":3,"value":40}
+ *   {"event":"message","job":3,"level":"info","text":...}
+ *   {"event":"image","job":3,"path":...}
+ *   {"event":"finished","job":3,"status":"ok","seconds":81.5}
+ *   {"event":"status",...}, {"event":"error","text":...}
+ *
+ * The status of a finished job is ok, failed or cancelled. The highest
+ * priority runs first. Between jobs of the same priority the client that had
+ * the fewest jobs started goes first, then the one submitted first.
+ * A job keeps running when its client hangs up; its events are dropped.
+ *
+ * Without OpenMBIR_USE_PARALLEL_ALGORITHMS the server serves one client at a
+ * time and runs each job as soon as it is submitted.
+ */
+class MBIRServer
+{
+  public:
+    MBIRServer();
+    virtual ~MBIRServer();
+
+    MXA_INSTANCE_STRING_PROPERTY(ProgramName)
+    MXA_INSTANCE_STRING_PROPERTY(SocketPath)
+    /* Reconstructions that run at the same time */
+    MXA_INSTANCE_PROPERTY(int, ConcurrentJobs)
+    /* Threads of the pool shared by all jobs. 0 uses every core */
+    MXA_INSTANCE_PROPERTY(int, NumberOfThreads)
+
+    /**
+     * @brief Parses the command line of mbird
+     * @return Error condition
+     */
+    int parseArguments(int argc, char** argv);
+
+    /**
+     * @brief Listens on the socket and serves clients until one sends shutdown
+     * @return Error condition
+     */
+    int execute();
+
+    /**
+     * @brief Reads and answers the commands of one client until it hangs up
+     */
+    void serveClient(ServerConnection::Pointer connection);
+
+    /**
+     * @brief Runs queued jobs until the server shuts down. Called by every worker thread.
+     */
+    void runQueuedJobs();
+
+    /**
+     * @brief Sends an event of a job to the client that submitted it
+     */
+    static void SendJobEvent(ServerConnection::Pointer connection, int job, ServerMessage& event);
+
+  private:
+    std::map<int, MBIRServerJob> m_Jobs;
+    std::map<std::string, int> m_StartedJobs; // Per client
+    std::vector<ServerConnection::Pointer> m_Connections;
+    HAADF_PrecomputeCache::Pointer m_PrecomputeCache;
+    int m_NextJobId;
+    int m_ListenSocket;
+    bool m_Shutdown;
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    tbb::spin_mutex m_Mutex;
+    tbb::spin_mutex m_ParseMutex;
+#endif
+    int m_ActiveClients;
+
+    int listen();
+    int submit(ServerConnection::Pointer connection, const ServerMessage& command);
+    void sendStatus(ServerConnection::Pointer connection);
+    void cancel(ServerConnection::Pointer connection, const ServerMessage& command);
+    void shutdown(ServerConnection::Pointer connection);
+    void sendError(ServerConnection::Pointer connection, const std::string& text);
+
+    /**
+     * @brief Takes the queued job that should run next
+     * @return The id of the job or -1 if nothing is queued
+     */
+    int takeNextJob();
+    bool runNextJob();
+    void runJob(int id);
+
+    MBIRServer(const MBIRServer&); // Copy Constructor Not Implemented
+    void operator=(const MBIRServer&); // Operator '=' Not Implemented
+};
+
+#endif /* _MBIRServer_H_ */
@@ -34,24 +34,36 @@
  *
  * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
 #include <limits>
 #include <iostream>
+#include <sstream>
+#include <vector>
 
 #include <tclap/CmdLine.h>
 #include <tclap/ValueArg.h>
 
 //-- MXA Includes
 #include "MXA/MXA.h"
-#include "MXA/Common/MXAEndian.h"
-#include "MXA/Common/IO/MXAFileWriter64.h"
 #include "MXA/Utilities/MXAFileInfo.h"
 #include "MXA/Utilities/MXADir.h"
 
 #include "MBIRLib/MBIRLibVersion.h"
+#include "MBIRLib/IOFilters/MRCFile.h"
 #include "MBIRLib/IOFilters/MRCReader.h"
-#include "MBIRLib/IOFilters/MRCWriter.h"
+#include "MBIRLib/IOFilters/MRCStatisticsIndex.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_group.h>
+#include <tbb/tbb_thread.h>
+#endif
 
+/* Number of sections processed together. One batch is written while the next is processed */
+#define MRCSUBSET_BATCH_SIZE 16
 
 
 /**
@@ -83,77 +95,246 @@ int parseValues(const std::string& values, const char* format, T* output)
   return 0;
 }
 
-
+/**
+ * @brief Parses unknown number of numeric values from a delimited string and places
+ * the values into the output variable.
+ * @param values The string to be parsed
+ * @param format The stdio format specifier to use (%f for floats, %d for integers
+ * @param output The output location to store the parsed values
+ * @return Error condition
+ */
 template<typename T>
-int copyData(MRCHeader& header, int* voxelMin, int* voxelMax, int* subsetValues,
-             int typeSize, const std::string filepath, MXAFileWriter64& writer)
+int parseUnknownArray(const std::string& values, const char* format, std::vector<T>& output)
 {
-  float mean = 0.0;
-  float min = std::numeric_limits<float>::max();
-  float max = std::numeric_limits<float>::min();
-  size_t count = 0;
-  int err = 0;
-  // Read each slice
-  for (int z = 0; z < header.nz; ++z)
+  std::string::size_type pos = values.find(",", 0);
+  T t;
+  int n = sscanf(values.substr(0, pos).c_str(), format, &t);
+  if(n != 1)
   {
-    MRCReader::Pointer mrcTiltDataReader = MRCReader::New(true);
-    std::cout << "Reading Section " << z << " out of " << header.nz << std::endl;
-    voxelMin[2] = z;
-    voxelMax[2] = z;
-    err = mrcTiltDataReader->read(filepath, voxelMin, voxelMax);
+    return -1;
+  }
+  output.push_back(t);
 
-    if(err < 0)
-    {
-      std::cout << "Error Code from Reading: " << err << std::endl;
-      return err;
-    }
-    uint8_t* inputData = reinterpret_cast<uint8_t*>(mrcTiltDataReader->getDataPointer());
-    uint8_t* src = NULL;
-    //Copy the data, scan line by scan line from the source to the destination
-    size_t outWidth = subsetValues[1] - subsetValues[0];
+  while (pos != std::string::npos && pos != values.size() - 1)
+  {
+    n = sscanf(values.substr(pos + 1).c_str(), format, &(t));
+    output.push_back(t);
+    pos = values.find(",", pos + 1);
+  }
+  return 0;
+}
 
-    for (int row = subsetValues[2]; row < subsetValues[3]; ++row)
-    {
-      // Calculate the destination pointer
-      //  dest = dataPtr + ((row - subsetValues[2]) * outWidth * typeSize);
-      // Place the pointer to the start of the row that we want
-      src = inputData + typeSize * ((header.nx * row) + subsetValues[0]);
+/**
+ * @brief What to do to each section on its way to the output file
+ */
+typedef struct
+{
+  int XYMin[2];  // INCLUSIVE region of the input section to keep
+  int XYMax[2];
+  int Bin;       // Bin x Bin input pixels are averaged into one output pixel
+  int OutWidth;  // Output section size after binning
+  int OutHeight;
+} SubsetOptions;
+
+namespace Detail
+{
+  /**
+   * @brief Reads the region of one input section, bins it, converts it to the
+   * output type and computes the statistics of the result.
+   */
+  template<typename T, typename O>
+  class ProcessSection
+  {
+    public:
+      ProcessSection(MRCFile* mrcFile, const SubsetOptions* options, int z, int outMode,
+                     O* output, MRCSectionStatistics* stats, int* error) :
+        m_MRCFile(mrcFile), m_Options(options), m_Z(z), m_OutMode(outMode),
+        m_Output(output), m_Stats(stats), m_Error(error)
+      {}
+
+      void operator()() const
+      {
+        const SubsetOptions& opt = *m_Options;
+        size_t inWidth = opt.XYMax[0] - opt.XYMin[0] + 1;
+        size_t inHeight = opt.XYMax[1] - opt.XYMin[1] + 1;
+        size_t outCount = static_cast<size_t>(opt.OutWidth) * opt.OutHeight;
+        std::vector<T> section(inWidth * inHeight);
+        *m_Error = m_MRCFile->readSectionRegion(m_Z, opt.XYMin, opt.XYMax, &(section.front()));
+        if(*m_Error < 0)
+        {
+          return;
+        }
+        if(opt.Bin == 1)
+        {
+          for (size_t i = 0; i < outCount; ++i)
+          {
+            m_Output[i] = static_cast<O>(section[i]);
+          }
+        }
+        else
+        {
+          // Integer outputs are rounded to the nearest value
+          double rounding = (std::numeric_limits<O>::is_integer) ? 0.5 : 0.0;
+          double norm = 1.0 / (opt.Bin * opt.Bin);
+          for (int y = 0; y < opt.OutHeight; ++y)
+          {
+            O* outRow = m_Output + static_cast<size_t>(y) * opt.OutWidth;
+            for (int x = 0; x < opt.OutWidth; ++x)
+            {
+              double sum = 0.0;
+              for (int j = 0; j < opt.Bin; ++j)
+              {
+                const T* inRow = &(section[(static_cast<size_t>(y) * opt.Bin + j) * inWidth + x * opt.Bin]);
+                for (int i = 0; i < opt.Bin; ++i)
+                {
+                  sum += inRow[i];
+                }
+              }
+              double mean = sum * norm;
+              outRow[x] = static_cast<O>(mean < 0 ? mean - rounding : mean + rounding);
+            }
+          }
+        }
+        MRCHeader* header = m_MRCFile->getHeader();
+        *m_Error = MRCStatisticsIndex::ComputeSectionStatistics(m_Output, outCount, m_OutMode,
+                   header->imodFlags == 1, false, 0.0, *m_Stats);
+      }
 
-      // Write the scan line to the output file
-      writer.write(reinterpret_cast<char*>(src), typeSize * outWidth);
+    private:
+      MRCFile* m_MRCFile;
+      const SubsetOptions* m_Options;
+      int m_Z;
+      int m_OutMode;
+      O* m_Output;
+      MRCSectionStatistics* m_Stats;
+      int* m_Error;
+  };
+
+  /**
+   * @brief Appends a batch of processed sections to the output file
+   */
+  class WriteSections
+  {
+    public:
+      WriteSections(FILE* f, const void* data, size_t numBytes, int* error) :
+        m_File(f), m_Data(data), m_NumBytes(numBytes), m_Error(error)
+      {}
 
-      T* data = reinterpret_cast<T*>(src);
-      for(size_t w = 0; w < outWidth; ++w)
+      void operator()() const
       {
-        mean += data[w];
-        if (data[w] < min) { min = data[w]; }
-        if (data[w] > max) { max = data[w]; }
-
+        *m_Error = (fwrite(m_Data, 1, m_NumBytes, m_File) == m_NumBytes) ? 0 : -1;
       }
-      count += outWidth;
 
+    private:
+      FILE* m_File;
+      const void* m_Data;
+      size_t m_NumBytes;
+      int* m_Error;
+  };
+}
+
+/**
+ * @brief Processes the kept tilts a batch at a time, each section of a batch in
+ * parallel. While one batch is being processed the previous one is written
+ * by a separate thread so the sections reach the file in order without the
+ * processing waiting on the disk.
+ */
+template<typename T, typename O>
+int copyData(MRCFile::Pointer mrcFile, const SubsetOptions& options, int outMode,
+             const std::vector<int>& tilts, FILE* f,
+             std::vector<MRCSectionStatistics>& stats)
+{
+  size_t outCount = static_cast<size_t>(options.OutWidth) * options.OutHeight;
+  size_t numTilts = tilts.size();
+  stats.resize(numTilts);
+  std::vector<int> errors(numTilts, 0);
+  std::vector<O> buffers[2];
+  int writeError = 0;
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  tbb::tbb_thread* writer = NULL;
+#endif
+  int err = 0;
+  for (size_t start = 0; start < numTilts && err >= 0; start += MRCSUBSET_BATCH_SIZE)
+  {
+    size_t count = std::min(numTilts - start, static_cast<size_t>(MRCSUBSET_BATCH_SIZE));
+    std::vector<O>& buffer = buffers[(start / MRCSUBSET_BATCH_SIZE) % 2];
+    buffer.resize(count * outCount);
+    std::cout << "Processing Sections " << start << " to " << start + count - 1 << " out of " << numTilts << std::endl;
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    tbb::task_group* g = new tbb::task_group;
+    for (size_t i = 0; i < count; ++i)
+    {
+      g->run(Detail::ProcessSection<T, O>(mrcFile.get(), &options, tilts[start + i], outMode,
+                                          &(buffer[i * outCount]), &(stats[start + i]), &(errors[start + i])));
+    }
+    g->wait(); // Wait for all the threads to complete before moving on.
+    delete g;
+#else
+    for (size_t i = 0; i < count; ++i)
+    {
+      Detail::ProcessSection<T, O> process(mrcFile.get(), &options, tilts[start + i], outMode,
+                                           &(buffer[i * outCount]), &(stats[start + i]), &(errors[start + i]));
+      process();
+    }
+#endif
+    for (size_t i = 0; i < count; ++i)
+    {
+      if(errors[start + i] < 0)
+      {
+        std::cout << "Error Code from Reading Section " << tilts[start + i] << ": " << errors[start + i] << std::endl;
+        err = errors[start + i];
+      }
     }
 
+    // The previous batch has to be on its way to the disk before this one is queued
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    if(NULL != writer)
+    {
+      writer->join();
+      delete writer;
+      writer = NULL;
+    }
+#endif
+    if(writeError < 0 || err < 0)
+    {
+      err = (err < 0) ? err : writeError;
+      break;
+    }
+    Detail::WriteSections write(f, &(buffer.front()), sizeof(O) * buffer.size(), &writeError);
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    writer = new tbb::tbb_thread(write);
+#else
+    write();
+#endif
   }
-
-  // Calculate the mean value
-  mean = mean / count;
-
-  std::cout << "min:" << min << std::endl;
-  std::cout << "max:" << max << std::endl;
-  std::cout << "mean:" << mean << std::endl;
-
-
-  // Update the values in the file
-  writer.setFilePointer64(76); // Set the position to the "amin" header entry
-  writer.writeValue(&min);
-  writer.writeValue(&max);
-  writer.writeValue(&mean);
-  return 0;
-
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  if(NULL != writer)
+  {
+    writer->join();
+    delete writer;
+  }
+#endif
+  if(err >= 0 && writeError < 0)
+  {
+    std::cout << "Error writing the output file" << std::endl;
+    err = writeError;
+  }
+  return err;
 }
 
-
+/**
+ * @brief Picks the output type for an input type
+ */
+template<typename T>
+int copyData(MRCFile::Pointer mrcFile, const SubsetOptions& options, bool toFloat,
+             const std::vector<int>& tilts, FILE* f, std::vector<MRCSectionStatistics>& stats)
+{
+  if(toFloat)
+  {
+    return copyData<T, float>(mrcFile, options, 2, tilts, f, stats);
+  }
+  return copyData<T, T>(mrcFile, options, mrcFile->getHeader()->mode, tilts, f, stats);
+}
 
 
 // -----------------------------------------------------------------------------
@@ -170,11 +351,21 @@ int main(int argc, char** argv)
   TCLAP::ValueArg<std::string> outputFile("", "outputfile", "Output MRC FIle", true, "", "");
   cmd.add(outputFile);
 
-  TCLAP::ValueArg<std::string> subset("", "subset", "Subset to Reconstruct in the form xmin,xmax,ymin,ymax", true, "", "");
+  TCLAP::ValueArg<std::string> subset("", "subset", "Subset to Reconstruct in the form xmin,xmax,ymin,ymax. Defaults to the whole section", false, "", "");
   cmd.add(subset);
 
+  TCLAP::ValueArg<int> binning("", "bin", "Average bin x bin pixels into one output pixel (1, 2 or 4)", false, 1, "");
+  cmd.add(binning);
+
+  TCLAP::SwitchArg toFloat("", "float", "Write the output as 32 bit floats", false);
+  cmd.add(toFloat);
+
+  TCLAP::ValueArg<std::string> viewMask("", "exclude_views", "Comma separated list of tilts to exclude by index", false, "", "");
+  cmd.add(viewMask);
+
   int subsetValues[6];
   ::memset(subsetValues, 0, 6 * sizeof(int));
+  std::vector<int> excludedViews;
 
   try
   {
@@ -185,11 +376,16 @@ int main(int argc, char** argv)
       int err = parseValues(subset.getValue(), "%d", subsetValues);
       if(err < 0)
       {
-        std::cout << "Error Parsing the Subvolume Dimensions. They should be entered as --subvolume 64,128,256,80,150,280" << std::endl;
+        std::cout << "Error Parsing the Subvolume Dimensions. They should be entered as --subset 64,128,256,280" << std::endl;
         return -1;
       }
 
     }
+    if(viewMask.getValue().length() != 0 && parseUnknownArray(viewMask.getValue(), "%d", excludedViews) < 0)
+    {
+      std::cout << "Error Parsing the Excluded Views. They should be entered as --exclude_views 0,1,20" << std::endl;
+      return -1;
+    }
   }
   catch (TCLAP::ArgException& e)
   {
@@ -199,96 +395,169 @@ int main(int argc, char** argv)
   }
 
   std::string filepath = inputFile.getValue();
-  MRCReader::Pointer reader = MRCReader::New(true);
-  MRCHeader header;
-  int err = reader->readHeader(filepath.c_str(), &header);
+  MRCFile::Pointer mrcFile = MRCFile::New();
+  mrcFile->setReadAheadSections(MRCSUBSET_BATCH_SIZE);
+  int err = mrcFile->open(filepath);
   if(err < 0)
   {
     std::cout << "Error reading header from file '" << inputFile.getValue() << "'" << std::endl;
     return EXIT_FAILURE;
   }
+  MRCHeader& header = *(mrcFile->getHeader());
 
-  // Get the full extended header from the file
-  std::vector<uint8_t> extendedHeader = reader->extendedHeader();
-
+  MRCReader::Pointer reader = MRCReader::New(true);
   reader->printHeader(&header, std::cout);
 
-  int voxelMin[3] =
-  { 0, 0, 0 };
-  int voxelMax[3] =
-  { header.nx - 1, header.ny - 1, 0 };
+  if(subset.getValue().length() == 0)
+  {
+    subsetValues[1] = header.nx;
+    subsetValues[3] = header.ny;
+  }
+  if(subsetValues[0] < 0 || subsetValues[2] < 0 || subsetValues[1] > header.nx || subsetValues[3] > header.ny
+      || subsetValues[0] >= subsetValues[1] || subsetValues[2] >= subsetValues[3])
+  {
+    std::cout << "The subset is outside of the " << header.nx << " x " << header.ny << " sections" << std::endl;
+    return EXIT_FAILURE;
+  }
+  int bin = binning.getValue();
+  if(bin != 1 && bin != 2 && bin != 4)
+  {
+    std::cout << "The binning must be 1, 2 or 4" << std::endl;
+    return EXIT_FAILURE;
+  }
 
   // Get the subset of the image as a dimension
-  int nx = subsetValues[1] - subsetValues[0];
-  int ny = subsetValues[3] - subsetValues[2];
+  SubsetOptions options;
+  options.XYMin[0] = subsetValues[0];
+  options.XYMin[1] = subsetValues[2];
+  options.XYMax[0] = subsetValues[1] - 1;
+  options.XYMax[1] = subsetValues[3] - 1;
+  options.Bin = bin;
+  options.OutWidth = (subsetValues[1] - subsetValues[0]) / bin;
+  options.OutHeight = (subsetValues[3] - subsetValues[2]) / bin;
+  if(options.OutWidth == 0 || options.OutHeight == 0)
+  {
+    std::cout << "The subset is smaller than the binning" << std::endl;
+    return EXIT_FAILURE;
+  }
+  // The binned pixels only cover the part of the subset that divides evenly
+  options.XYMax[0] = options.XYMin[0] + options.OutWidth * bin - 1;
+  options.XYMax[1] = options.XYMin[1] + options.OutHeight * bin - 1;
+
+  std::vector<int> tilts;
+  for (int z = 0; z < header.nz; ++z)
+  {
+    if(std::find(excludedViews.begin(), excludedViews.end(), z) == excludedViews.end())
+    {
+      tilts.push_back(z);
+    }
+  }
 
   // Create a new header that we can use to write out the output MRC file
   MRCHeader outHeader;
   ::memcpy(&outHeader, &header, sizeof(MRCHeader));
-  outHeader.feiHeaders = header.feiHeaders; // The FEI Headers stay the same
-  outHeader.nx = nx;
-  outHeader.ny = ny;
-  outHeader.mx = nx;
-  outHeader.my = ny;
-  outHeader.xlen = nx;
-  outHeader.ylen = ny;
-
-  MXAFileWriter64 writer(outputFile.getValue());
-  bool success = writer.initWriter();
-  std::stringstream ss;
-  if(false == success)
+  outHeader.feiHeaders = NULL;
+  outHeader.nx = options.OutWidth;
+  outHeader.ny = options.OutHeight;
+  outHeader.nz = static_cast<int>(tilts.size());
+  outHeader.mx = outHeader.nx;
+  outHeader.my = outHeader.ny;
+  outHeader.mz = outHeader.nz;
+  outHeader.xlen = outHeader.nx;
+  outHeader.ylen = outHeader.ny;
+  outHeader.zlen = outHeader.nz;
+  if(toFloat.getValue() == true)
   {
-    ss.str("");
-    ss << "MRCSubset: Error opening output file for writing. '" << outputFile.getValue() << "'";
-    return EXIT_FAILURE;
+    outHeader.mode = 2;
   }
 
-  // Write the output header
-  writer.write(reinterpret_cast<char*>(&outHeader), 1024);
-//  std::cout << "File Pointer: " << writer.getFilePointer64() << std::endl;
-
-  writer.writeArray(&(extendedHeader.front()), header.next);
-
-  // Write the FEI extended headers
-//  for(uint16_t i = 0; i < header.nz; ++i)
-//  {
-//    writer.write(reinterpret_cast<char*>( &(outHeader.feiHeaders[i])), sizeof(FEIHeader));
-//  }
-//  std::cout << "File Pointer: " << writer.getFilePointer64() << std::endl;
+  // The FEI extended header has one record per tilt which follows its tilt
+  std::vector<uint8_t> extendedHeader = mrcFile->getExtendedHeader();
+  std::vector<uint8_t> kept;
+  if(MRCReader::subsetFEIHeaders(&header, extendedHeader, tilts, static_cast<float>(bin), kept) >= 0)
+  {
+    extendedHeader.swap(kept);
+  }
+  else if(excludedViews.empty() == false && extendedHeader.empty() == false)
+  {
+    std::cout << "The extended header is not one FEI record per tilt and is copied unchanged" << std::endl;
+  }
 
   std::string path = MXAFileInfo::parentPath(outputFile.getValue());
   MXADir::mkdir(path, true);
 
-  size_t typeSize = 0;
+  FILE* f = fopen(outputFile.getValue().c_str(), "wb");
+  if(NULL == f)
+  {
+    std::cout << "MRCSubset: Error opening output file for writing. '" << outputFile.getValue() << "'" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // The statistics are filled in once all the sections have been written
+  fwrite(&outHeader, 1, 1024, f);
+  if(extendedHeader.empty() == false)
+  {
+    fwrite(&(extendedHeader.front()), 1, extendedHeader.size(), f);
+  }
 
+  std::vector<MRCSectionStatistics> stats;
+  err = -1;
   switch(header.mode)
   {
     case 0:
-      typeSize = 1;
-      copyData<uint8_t>(header, voxelMin, voxelMax, subsetValues, typeSize, filepath, writer);
+      err = copyData<uint8_t>(mrcFile, options, toFloat.getValue(), tilts, f, stats);
       break;
     case 1:
-      typeSize = 2;
-      copyData<int16_t>(header, voxelMin, voxelMax, subsetValues, typeSize, filepath, writer);
+      err = copyData<int16_t>(mrcFile, options, toFloat.getValue(), tilts, f, stats);
       break;
     case 2:
-      typeSize = 4;
-      copyData<float>(header, voxelMin, voxelMax, subsetValues, typeSize, filepath, writer);
-      break;
-    case 3:
-      break;
-    case 4:
+      err = copyData<float>(mrcFile, options, toFloat.getValue(), tilts, f, stats);
       break;
     case 6:
-      typeSize = 2;
-      copyData<uint16_t>(header, voxelMin, voxelMax, subsetValues, typeSize, filepath, writer);
+      err = copyData<uint16_t>(mrcFile, options, toFloat.getValue(), tilts, f, stats);
       break;
-    case 16:
+    default:
+      std::cout << "MRC mode " << header.mode << " is not supported" << std::endl;
       break;
   }
 
+  if(err >= 0)
+  {
+    // Calculate the range and mean value of the whole file
+    float min = std::numeric_limits<float>::max();
+    float max = -std::numeric_limits<float>::max();
+    double sum = 0.0;
+    for (size_t z = 0; z < stats.size(); ++z)
+    {
+      if (stats[z].Min < min) { min = stats[z].Min; }
+      if (stats[z].Max > max) { max = stats[z].Max; }
+      sum += stats[z].Mean;
+    }
+    float mean = (stats.size() > 0) ? static_cast<float>(sum / stats.size()) : 0.0f;
+
+    std::cout << "min:" << min << std::endl;
+    std::cout << "max:" << max << std::endl;
+    std::cout << "mean:" << mean << std::endl;
+
+    // Update the values in the header of the file
+    fseek(f, 76, SEEK_SET); // Set the position to the "amin" header entry
+    fwrite(&min, sizeof(float), 1, f);
+    fwrite(&max, sizeof(float), 1, f);
+    fwrite(&mean, sizeof(float), 1, f);
+  }
+  if(fclose(f) != 0 || err < 0)
+  {
+    std::cout << "Error Subsetting MRC File" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Leave the statistics of the new file in its sidecar for whatever opens it next
+  int xyMin[2] = { 0, 0 };
+  int xyMax[2] = { outHeader.nx - 1, outHeader.ny - 1 };
+  MRCStatisticsIndex::Pointer index = MRCStatisticsIndex::New();
+  index->insert(xyMin, xyMax, false, 0.0, stats);
+  index->save(outputFile.getValue());
 
   std::cout << "Done Subsetting MRC File" << std::endl;
   return EXIT_SUCCESS;
 }
-
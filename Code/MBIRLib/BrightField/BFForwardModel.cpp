@@ -43,6 +43,7 @@
 #include <errno.h>
 
 // C++ Includes
+#include <algorithm>
 #include <limits>
 #include <iostream>
 
@@ -62,6 +63,8 @@
 #include "MBIRLib/IOFilters/NuisanceParamReader.h"
 #include "MBIRLib/GenericFilters/ComputeInitialOffsets.h"
 #include "MBIRLib/IOFilters/SinogramBinWriter.h"
+#include "MBIRLib/Reconstruction/SinogramStatistics.h"
+#include "MBIRLib/Common/RadixQuantile.h"
 
 
 #if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
@@ -72,6 +75,30 @@
 
 
 
+namespace Detail
+{
+  /**
+   * @brief Supplies e*e*w for every measurement to RadixQuantile
+   */
+  class BraggRatioSource
+  {
+    public:
+      BraggRatioSource(const BFForwardModel* model, const Real_t* counts, const Real_t* errorSino, size_t tiltSize) :
+        m_Model(model), m_Counts(counts), m_ErrorSino(errorSino), m_TiltSize(tiltSize) {}
+
+      double operator()(size_t idx) const
+      {
+        uint16_t i_theta = static_cast<uint16_t>(idx / m_TiltSize);
+        return m_ErrorSino[idx] * m_ErrorSino[idx] * m_Model->measurementWeight(m_Counts, idx, i_theta);
+      }
+    private:
+      const BFForwardModel* m_Model;
+      const Real_t* m_Counts;
+      const Real_t* m_ErrorSino;
+      size_t m_TiltSize;
+  };
+}
+
 #define MAKE_OUTPUT_FILE(Fp, outdir, filename)\
   {\
     std::string filepath(outdir);\
@@ -90,7 +117,8 @@
 // Contains all the computations and initializations related to forward model
 // -----------------------------------------------------------------------------
 BFForwardModel::BFForwardModel() :
-  m_Verbose(false), m_VeryVerbose(false), m_ErrorCondition(0), m_Cancel(false), m_UseDefaultOffset(false)
+  m_Verbose(false), m_VeryVerbose(false), m_ErrorCondition(0), m_Cancel(false), m_UseDefaultOffset(false),
+  m_ImplicitWeights(false)
 {
 
 
@@ -124,6 +152,8 @@ BFForwardModel::BFForwardModel() :
   m_TargetGain = 0.0;
   m_InitialGain = RealArrayType::NullPointer();
   m_InitialOffset = RealArrayType::NullPointer();
+  m_ImplicitWeight.Function = &BFForwardModel::countsToWeight;
+  m_ImplicitWeight.TiltScale = NULL;
 }
 
 // -----------------------------------------------------------------------------
@@ -311,11 +341,25 @@ void BFForwardModel::gainAndOffsetInitialization(uint16_t nTheta)
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
-void BFForwardModel::weightInitialization(size_t dims[3])
+void BFForwardModel::weightInitialization(SinogramPtr sinogram, size_t dims[3])
 {
-  m_Weight = RealVolumeType::New(dims, "Weight");
+  //A binned sinogram carries weights that can not be recomputed from its counts
+  if(m_ImplicitWeights && NULL == sinogram->weights.get())
+  {
+    //Only the per tilt factor is stored. The weights are recomputed from the counts
+    m_Weight = RealVolumeType::NullPointer();
+    size_t scaleDims[1] = { dims[0] };
+    m_WeightScale = RealArrayType::New(scaleDims, "WeightScale");
+    m_ImplicitWeight.TiltScale = m_WeightScale->d;
+  }
+  else
+  {
+    m_Weight = RealVolumeType::New(dims, "Weight");
+    m_WeightScale = RealArrayType::NullPointer();
+    m_ImplicitWeight.TiltScale = NULL;
+  }
   //This variable selects which entries to retain in the sinogram
-  m_Selector = UInt8VolumeType::New(dims, "Selector");
+  m_Selector = BitVolume::New(dims, "Selector");
 
 }
 
@@ -332,12 +376,17 @@ void BFForwardModel::calculateMeasurementWeight(SinogramPtr sinogram, RealVolume
   std::string indent("  ");
   Real_t checksum = 0;
   START_TIMER;
+  m_Selector->setAll(true); //By default all enties are chosen
   for (int16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++) //slice index
   {
     if(m_AdvParams->NOISE_ESTIMATION)
     {
       m_Alpha->d[i_theta] = m_InitialVariance->d[i_theta]; //Initialize the refinement parameters from any previous run
     } //Noise model
+    if(NULL != m_WeightScale.get())
+    {
+      m_WeightScale->d[i_theta] = (m_AdvParams->NOISE_ESTIMATION) ? 1.0 / m_Alpha->d[i_theta] : 1.0;
+    }
 
     checksum = 0;
     for (int16_t i_r = 0; i_r < sinogram->N_r; i_r++)
@@ -345,34 +394,36 @@ void BFForwardModel::calculateMeasurementWeight(SinogramPtr sinogram, RealVolume
       for (uint16_t i_t = 0; i_t < sinogram->N_t; i_t++)
       {
         size_t counts_idx = sinogram->counts->calcIndex(i_theta, i_r, i_t);
-        size_t weight_idx = m_Weight->calcIndex(i_theta, i_r, i_t);
         size_t yest_idx = yEstimate->calcIndex(i_theta, i_r, i_t);
         size_t error_idx = errorSinogram->calcIndex(i_theta, i_r, i_t);
 
         errorSinogram->d[error_idx] = sinogram->counts->d[counts_idx] - yEstimate->d[yest_idx] - m_Mu->d[i_theta];
 
-
-#ifndef IDENTITY_NOISE_MODEL
-        //If its a bright field recon just over ride the weights
-        m_Weight->d[weight_idx] = BF_MAX / exp(sinogram->counts->d[counts_idx]);
-#else
-        m_Weight->d[weight_idx] = 1.0;
-#endif //IDENTITY_NOISE_MODEL endif
-
-        m_Selector->d[weight_idx] = 1; //By default all enties are chosen
-
 #ifdef FORWARD_PROJECT_MODE
         temp = yEstimate->d[i_theta][i_r][i_t] / m_I_0->d[i_theta];
         fwrite(&temp, sizeof(Real_t), 1, Fp6);
 #endif
 
-
-        if(m_AdvParams->NOISE_ESTIMATION)
+        if(NULL != m_Weight.get())
         {
-          m_Weight->d[weight_idx] /= m_Alpha->d[i_theta];
-        } // NOISE_MODEL
+          size_t weight_idx = m_Weight->calcIndex(i_theta, i_r, i_t);
+          //If its a bright field recon just over ride the weights
+          if(NULL != sinogram->weights.get())
+          {
+            m_Weight->d[weight_idx] = sinogram->weights->d[counts_idx];
+          }
+          else
+          {
+            m_Weight->d[weight_idx] = countsToWeight(sinogram->counts->d[counts_idx]);
+          }
+
+          if(m_AdvParams->NOISE_ESTIMATION)
+          {
+            m_Weight->d[weight_idx] /= m_Alpha->d[i_theta];
+          } // NOISE_MODEL
+        }
 
-        checksum += m_Weight->d[weight_idx];
+        checksum += measurementWeight(sinogram->counts->d, counts_idx, i_theta);
       }
     }
     if(getVerbose())
@@ -387,47 +438,32 @@ void BFForwardModel::calculateMeasurementWeight(SinogramPtr sinogram, RealVolume
 // -----------------------------------------------------------------------------
 // Estimation of the unknown dosage parameter
 // -----------------------------------------------------------------------------
-void BFForwardModel::jointEstimation(SinogramPtr sinogram, RealVolumeType::Pointer errorSinogram, RealVolumeType::Pointer yEstimate, CostData::Pointer cost)
+int BFForwardModel::jointEstimation(SinogramPtr sinogram, RealVolumeType::Pointer errorSinogram, CostData::Pointer cost)
 {
   std::stringstream ss;
   std::string indent("  ");
 
+  std::vector<TiltMoments> moments;
+  SinogramStatistics::computeTiltMoments(sinogram, errorSinogram, m_Weight, RealArrayType::NullPointer(),
+                                         RealArrayType::NullPointer(), m_Selector, moments, &m_ImplicitWeight);
+  Real_t numMeasurements = 0;
+  if(reduceTiltMoments(moments, numMeasurements) < 0)
+  {
+    return -1;
+  }
+  std::vector<Real_t> countsCoeff(sinogram->N_theta, 0.0);
+  std::vector<Real_t> errorCoeff(sinogram->N_theta, 1.0);
+  std::vector<Real_t> constant(sinogram->N_theta);
+  Real_t braggScale = m_BraggThreshold * m_BraggDelta;
   for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
   {
     //Estimate unknown offset (log{dosage}) parameter
-    Real_t num_sum = 0;
-    Real_t den_sum = 0;
-    Real_t alpha = 0;
-    for (uint16_t i_r = 0; i_r < sinogram->N_r; i_r++)
-    {
-      for (uint16_t i_t = 0; i_t < sinogram->N_t; i_t++)
-      {
-        if(m_Selector->getValue(i_theta, i_r, i_t) == 1)
-        {
-          num_sum += (errorSinogram->getValue(i_theta, i_r, i_t) * m_Weight->getValue(i_theta, i_r, i_t));
-          den_sum += m_Weight->getValue(i_theta, i_r, i_t);
-        }
-        else
-        {
-          num_sum += (m_BraggThreshold * m_BraggDelta * errorSinogram->getValue(i_theta, i_r, i_t) / fabs(errorSinogram->getValue(i_theta, i_r, i_t))) * sqrt(m_Weight->getValue(i_theta, i_r, i_t));
-          den_sum += ((m_BraggThreshold * m_BraggDelta * sqrt(m_Weight->getValue(i_theta, i_r, i_t))) / fabs(errorSinogram->getValue(i_theta, i_r, i_t)));
-        }
-
-      }
-    }
-    //}
-    alpha = num_sum / den_sum;
+    const TiltMoments& m = moments[i_theta];
+    Real_t num_sum = m.SumSelectedWE + braggScale * m.SumRejectedSignSqrtW;
+    Real_t den_sum = m.SumSelectedW + braggScale * m.SumRejectedSqrtWOverAbsE;
+    Real_t alpha = num_sum / den_sum;
 
-    //Update error sinogram
-    //for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
-    //{
-    for (uint16_t i_r = 0; i_r < sinogram->N_r; i_r++)
-    {
-      for (uint16_t i_t = 0; i_t < sinogram->N_t; i_t++)
-      {
-        errorSinogram->deleteFromValue(alpha, i_theta, i_r, i_t);
-      }
-    }
+    constant[i_theta] = -alpha;
     m_Mu->d[i_theta] += alpha;
 
     if(getVeryVerbose()) //Display the estimated offset
@@ -436,66 +472,77 @@ void BFForwardModel::jointEstimation(SinogramPtr sinogram, RealVolumeType::Point
     }
   }
 
-
-
+  //Update error sinogram
+  SinogramStatistics::affineErrorUpdate(sinogram, errorSinogram, countsCoeff, errorCoeff, constant);
+  return 0;
 }
 
 
 // -----------------------------------------------------------------------------
 // Updating the Weights for Noise Model
 // -----------------------------------------------------------------------------
-void BFForwardModel::updateWeights(SinogramPtr sinogram, RealVolumeType::Pointer ErrorSino)
+int BFForwardModel::updateWeights(SinogramPtr sinogram, RealVolumeType::Pointer ErrorSino)
 {
-  for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
-  {
-    //Factoring out the variance parameter from the Weight matrix
-    for (uint16_t i_r = 0; i_r < sinogram->N_r; i_r++)
-    {
-      for (uint16_t i_t = 0; i_t < sinogram->N_t; i_t++)
-      {
-        size_t weight_idx = m_Weight->calcIndex(i_theta, i_r, i_t);
+  //Factoring out the variance parameter from the Weight matrix is done on the
+  //moments rather than on the weights themselves
+  std::vector<TiltMoments> moments;
 #ifndef IDENTITY_NOISE_MODEL
-        //TODO Just assign this once
-        m_Weight->d[weight_idx] *= m_Alpha->d[i_theta];
-        //m_Weight->d[weight_idx] = BF_MAX/exp(sinogram->counts->d[counts_idx]);
+  SinogramStatistics::computeTiltMoments(sinogram, ErrorSino, m_Weight, RealArrayType::NullPointer(),
+                                         RealArrayType::NullPointer(), m_Selector, moments, &m_ImplicitWeight);
 #else
-        m_Weight->d[weight_idx] = 1.0;
+  SinogramStatistics::computeTiltMoments(sinogram, ErrorSino, RealVolumeType::NullPointer(), RealArrayType::NullPointer(),
+                                         RealArrayType::NullPointer(), m_Selector, moments);
 #endif//Identity noise Model
-      }
-    }
+  Real_t numMeasurements = static_cast<Real_t>(sinogram->N_theta) * sinogram->N_r * sinogram->N_t;
+  if(reduceTiltMoments(moments, numMeasurements) < 0)
+  {
+    return -1;
   }
 
   Real_t sum1 = 0, sum2 = 0, update;
-  for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
-    for (uint16_t i_r = 0; i_r < sinogram->N_r; i_r++)
-      for (uint16_t i_t = 0; i_t < sinogram->N_t; i_t++)
-      {
-        size_t weight_idx = m_Weight->calcIndex(i_theta, i_r, i_t);
-        if(m_Selector->d[weight_idx] == 1)
-        { sum1 += (ErrorSino->d[weight_idx] * ErrorSino->d[weight_idx] * m_Weight->d[weight_idx]); }
-        else
-        { sum2 += fabs(ErrorSino->d[weight_idx]) * sqrt(m_Alpha->d[i_theta] * m_Weight->d[weight_idx]); }
-      }
-  update = (sum1 + (m_BraggDelta * m_BraggThreshold) * sum2) / (sinogram->N_theta * sinogram->N_r * sinogram->N_t);
-
   for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
   {
-    m_Alpha->d[i_theta] = update;
+#ifndef IDENTITY_NOISE_MODEL
+    sum1 += m_Alpha->d[i_theta] * moments[i_theta].SumSelectedWEE;
+    sum2 += m_Alpha->d[i_theta] * moments[i_theta].SumRejectedAbsESqrtW;
+#else
+    sum1 += moments[i_theta].SumSelectedWEE;
+    sum2 += sqrt(m_Alpha->d[i_theta]) * moments[i_theta].SumRejectedAbsESqrtW;
+#endif//Identity noise Model
   }
+  update = (sum1 + (m_BraggDelta * m_BraggThreshold) * sum2) / numMeasurements;
 
   //Update the weights back for future iterations by appropriately scaling it
   //by m_Alpha's
+  std::vector<Real_t> scale(sinogram->N_theta);
   for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
-    for (uint16_t i_r = 0; i_r < sinogram->N_r; i_r++)
-      for (uint16_t i_t = 0; i_t < sinogram->N_t; i_t++)
-      {
-        size_t weight_idx = m_Weight->calcIndex(i_theta, i_r, i_t);
+  {
 #ifndef IDENTITY_NOISE_MODEL
-        m_Weight->d[weight_idx] /= m_Alpha->d[i_theta]; //Scales the weight appropriately
+    scale[i_theta] = m_Alpha->d[i_theta] / update; //Scales the weight appropriately
 #else
-        m_Weight->d[weight_idx] = 1.0 / m_Alpha->d[i_theta];
+    scale[i_theta] = 1.0 / update;
 #endif //IDENTITY_NOISE_MODEL
-      }
+    m_Alpha->d[i_theta] = update;
+  }
+  if(NULL != m_WeightScale.get())
+  {
+    for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
+    {
+#ifndef IDENTITY_NOISE_MODEL
+      m_WeightScale->d[i_theta] *= scale[i_theta];
+#else
+      m_WeightScale->d[i_theta] = scale[i_theta];
+#endif //IDENTITY_NOISE_MODEL
+    }
+  }
+  else
+  {
+#ifndef IDENTITY_NOISE_MODEL
+    SinogramStatistics::scaleTilts(m_Weight, scale);
+#else
+    SinogramStatistics::fillTilts(m_Weight, scale);
+#endif //IDENTITY_NOISE_MODEL
+  }
 
   if(getVeryVerbose())
   {
@@ -508,6 +555,83 @@ void BFForwardModel::updateWeights(SinogramPtr sinogram, RealVolumeType::Pointer
   }
 
   notify("Update Weights Complete", 0, Observable::UpdateProgressMessage);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int BFForwardModel::reduceTiltMoments(std::vector<TiltMoments>& moments, Real_t& numMeasurements)
+{
+  if(NULL == m_SlabTransport.get() || m_SlabTransport->getSize() < 2)
+  {
+    return 0;
+  }
+  const size_t k_SumsPerTilt = 6;
+  std::vector<Real_t> sums(moments.size() * k_SumsPerTilt + 1);
+  size_t index = 0;
+  for (size_t i = 0; i < moments.size(); ++i)
+  {
+    sums[index++] = moments[i].SumSelectedW;
+    sums[index++] = moments[i].SumSelectedWE;
+    sums[index++] = moments[i].SumSelectedWEE;
+    sums[index++] = moments[i].SumRejectedSignSqrtW;
+    sums[index++] = moments[i].SumRejectedSqrtWOverAbsE;
+    sums[index++] = moments[i].SumRejectedAbsESqrtW;
+  }
+  sums[index] = numMeasurements;
+  if(m_SlabTransport->allReduceSum(sums) < 0)
+  {
+    std::stringstream ss;
+    ss << "Could not add up the nuisance parameter statistics of the other workers: " << m_SlabTransport->getErrorMessage();
+    setErrorCondition(-1);
+    notify(ss.str(), 0, Observable::UpdateErrorMessage);
+    return -1;
+  }
+  index = 0;
+  for (size_t i = 0; i < moments.size(); ++i)
+  {
+    moments[i].SumSelectedW = sums[index++];
+    moments[i].SumSelectedWE = sums[index++];
+    moments[i].SumSelectedWEE = sums[index++];
+    moments[i].SumRejectedSignSqrtW = sums[index++];
+    moments[i].SumRejectedSqrtWOverAbsE = sums[index++];
+    moments[i].SumRejectedAbsESqrtW = sums[index++];
+  }
+  numMeasurements = sums[index];
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int BFForwardModel::shareGainsAndOffsets(uint16_t nTheta, Real_t rows)
+{
+  if(NULL == m_SlabTransport.get() || m_SlabTransport->getSize() < 2)
+  {
+    return 0;
+  }
+  std::vector<Real_t> sums(2 * nTheta + 1);
+  for (uint16_t k = 0; k < nTheta; k++)
+  {
+    sums[k] = rows * m_I_0->d[k];
+    sums[nTheta + k] = rows * m_Mu->d[k];
+  }
+  sums[2 * nTheta] = rows;
+  if(m_SlabTransport->allReduceSum(sums) < 0)
+  {
+    std::stringstream ss;
+    ss << "Could not share the initial gains and offsets with the other workers: " << m_SlabTransport->getErrorMessage();
+    setErrorCondition(-1);
+    notify(ss.str(), 0, Observable::UpdateErrorMessage);
+    return -1;
+  }
+  for (uint16_t k = 0; k < nTheta; k++)
+  {
+    m_I_0->d[k] = sums[k] / sums[2 * nTheta];
+    m_Mu->d[k] = sums[nTheta + k] / sums[2 * nTheta];
+  }
+  return 0;
 }
 
 
@@ -517,16 +641,26 @@ void BFForwardModel::updateWeights(SinogramPtr sinogram, RealVolumeType::Pointer
 void BFForwardModel::updateSelector(SinogramPtr sinogram,
                                     RealVolumeType::Pointer ErrorSino)
 {
-  for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
-    for (uint16_t i_r = 0; i_r < sinogram->N_r; i_r++)
-      for (uint16_t i_t = 0; i_t < sinogram->N_t; i_t++)
+  //The selector is rebuilt a whole word at a time
+  size_t tiltSize = sinogram->N_r * sinogram->N_t;
+  size_t numElements = m_Selector->getNumberOfElements();
+  size_t numWords = m_Selector->getNumberOfWords();
+  Real_t threshold = m_BraggThreshold * m_BraggThreshold;
+  for (size_t w = 0; w < numWords; w++)
+  {
+    BitVolume::WordType word = 0;
+    size_t start = w * BitVolume::k_BitsPerWord;
+    size_t end = std::min(start + BitVolume::k_BitsPerWord, numElements);
+    for (size_t idx = start; idx < end; idx++)
+    {
+      uint16_t i_theta = static_cast<uint16_t>(idx / tiltSize);
+      if(ErrorSino->d[idx] * ErrorSino->d[idx] * measurementWeight(sinogram->counts->d, idx, i_theta) < threshold)
       {
-        size_t idx = m_Weight->calcIndex(i_theta, i_r, i_t);
-        if(ErrorSino->d[idx] * ErrorSino->d[idx] * m_Weight->d[idx] < m_BraggThreshold * m_BraggThreshold)
-        { m_Selector->d[idx] = 1; }
-        else
-        { m_Selector->d[idx] = 0; }
+        word |= static_cast<BitVolume::WordType>(1) << (idx - start);
       }
+    }
+    m_Selector->setWord(w, word);
+  }
 
 }
 
@@ -538,7 +672,9 @@ void BFForwardModel::writeNuisanceParameters(SinogramPtr sinogram)
   NuisanceParamWriter::Pointer nuisanceBinWriter = NuisanceParamWriter::New();
   nuisanceBinWriter->setNtheta(sinogram->N_theta);
 
-  if(m_AdvParams->JOINT_ESTIMATION)
+  // The output files are optional. The multi resolution driver hands the values
+  // to the next resolution in memory.
+  if(m_AdvParams->JOINT_ESTIMATION && m_TomoInputs->gainsOutputFile.empty() == false)
   {
     nuisanceBinWriter->setFileName(m_TomoInputs->gainsOutputFile);
     nuisanceBinWriter->setDataToWrite(NuisanceParamWriter::Nuisance_I_O);
@@ -549,7 +685,10 @@ void BFForwardModel::writeNuisanceParameters(SinogramPtr sinogram)
       setErrorCondition(-1);
       notify(nuisanceBinWriter->getErrorMessage().c_str(), 100, Observable::UpdateErrorMessage);
     }
+  }
 
+  if(m_AdvParams->JOINT_ESTIMATION && m_TomoInputs->offsetsOutputFile.empty() == false)
+  {
     nuisanceBinWriter->setFileName(m_TomoInputs->offsetsOutputFile);
     nuisanceBinWriter->setDataToWrite(NuisanceParamWriter::Nuisance_mu);
     nuisanceBinWriter->setData(m_Mu);
@@ -561,7 +700,7 @@ void BFForwardModel::writeNuisanceParameters(SinogramPtr sinogram)
     }
   }
 
-  if(m_AdvParams->NOISE_ESTIMATION)
+  if(m_AdvParams->NOISE_ESTIMATION && m_TomoInputs->varianceOutputFile.empty() == false)
   {
     nuisanceBinWriter->setFileName(m_TomoInputs->varianceOutputFile);
     nuisanceBinWriter->setDataToWrite(NuisanceParamWriter::Nuisance_alpha);
@@ -637,12 +776,13 @@ int BFForwardModel::createInitialGainsData(SinogramPtr sinogram)
   size_t gains_dims[1] =
   { sinogram->N_theta };
   m_InitialGain = RealArrayType::New(gains_dims, "sinogram->InitialGain");
-  if(m_TomoInputs->gainsInputFile.empty() == false)
+  if(NULL != m_TomoInputs->initialGains.get() || m_TomoInputs->gainsInputFile.empty() == false)
   {
-    // Read the initial Gains from a File
+    // Read the initial Gains from a File or the previous resolution
     NuisanceParamReader::Pointer gainsInitializer = NuisanceParamReader::New();
     gainsInitializer->setFileName(m_TomoInputs->gainsInputFile);
     gainsInitializer->setData(m_InitialGain);
+    gainsInitializer->setSourceData(m_TomoInputs->initialGains);
     gainsInitializer->setSinogram(sinogram);
     gainsInitializer->setAdvParams(m_AdvParams);
     gainsInitializer->setTomoInputs(m_TomoInputs);
@@ -686,12 +826,13 @@ int BFForwardModel::createInitialOffsetsData(SinogramPtr sinogram)
   size_t offsets_dims[1] =
   { sinogram->N_theta };
   m_InitialOffset = RealArrayType::New(offsets_dims, "sinogram->InitialOffset");
-  if(m_TomoInputs->offsetsInputFile.empty() == false)
+  if(NULL != m_TomoInputs->initialOffsets.get() || m_TomoInputs->offsetsInputFile.empty() == false)
   {
-    // Read the initial offsets from a File
+    // Read the initial offsets from a File or the previous resolution
     NuisanceParamReader::Pointer offsetsInitializer = NuisanceParamReader::New();
     offsetsInitializer->setFileName(m_TomoInputs->offsetsInputFile);
     offsetsInitializer->setData(m_InitialOffset);
+    offsetsInitializer->setSourceData(m_TomoInputs->initialOffsets);
     offsetsInitializer->setSinogram(sinogram);
     offsetsInitializer->setAdvParams(m_AdvParams);
     offsetsInitializer->setTomoInputs(m_TomoInputs);
@@ -767,12 +908,13 @@ int BFForwardModel::createInitialVariancesData(SinogramPtr sinogram)
   size_t variance_dims[1] =
   { sinogram->N_theta };
   m_InitialVariance = RealArrayType::New(variance_dims, "sinogram->InitialVariance");
-  if(m_TomoInputs->varianceInputFile.empty() == false)
+  if(NULL != m_TomoInputs->initialVariances.get() || m_TomoInputs->varianceInputFile.empty() == false)
   {
-    // Read the initial variances from a File
+    // Read the initial variances from a File or the previous resolution
     NuisanceParamReader::Pointer variancesInitializer = NuisanceParamReader::New();
     variancesInitializer->setFileName(m_TomoInputs->varianceInputFile);
     variancesInitializer->setData(m_InitialVariance);
+    variancesInitializer->setSourceData(m_TomoInputs->initialVariances);
     variancesInitializer->setSinogram(sinogram);
     variancesInitializer->setTomoInputs(m_TomoInputs);
 
@@ -812,23 +954,17 @@ int BFForwardModel::createInitialVariancesData(SinogramPtr sinogram)
 Real_t BFForwardModel::forwardCost(SinogramPtr sinogram, RealVolumeType::Pointer ErrorSino)
 {
   Real_t cost = 0, temp = 0;
-  Real_t errSinoValue = 0.0;
 
   //Data Mismatch Error
-
+  std::vector<TiltMoments> moments;
+  SinogramStatistics::computeTiltMoments(sinogram, ErrorSino, m_Weight, RealArrayType::NullPointer(),
+                                         RealArrayType::NullPointer(), m_Selector, moments, &m_ImplicitWeight);
   for (int16_t i = 0; i < sinogram->N_theta; i++)
   {
-    for (int16_t j = 0; j < sinogram->N_r; j++)
-    {
-      for (int16_t k = 0; k < sinogram->N_t; k++)
-      {
-        errSinoValue = ErrorSino->getValue(i, j, k);
-        if(m_Selector->getValue(i, j, k) == 1)
-        { cost += (errSinoValue * errSinoValue * m_Weight->getValue(i, j, k)); }
-        else
-        { cost += (2 * m_BraggThreshold * m_BraggDelta * fabs(errSinoValue) * sqrt(m_Weight->getValue(i, j, k)) + m_BraggThreshold * m_BraggThreshold * (1 - 2 * m_BraggDelta)); }
-      }
-    }
+    const TiltMoments& m = moments[i];
+    cost += m.SumSelectedWEE
+            + 2 * m_BraggThreshold * m_BraggDelta * m.SumRejectedAbsESqrtW
+            + m.NumRejected * m_BraggThreshold * m_BraggThreshold * (1 - 2 * m_BraggDelta);
   }
 
   cost /= 2;
@@ -871,19 +1007,20 @@ void BFForwardModel::computeTheta(size_t Index,
     {
 
       size_t error_idx = ErrorSino->calcIndex(i_theta, i_r, i_t);
-      if(m_Selector->d[error_idx] == 1)
+      Real_t weight = measurementWeight(sinogram->counts->d, error_idx, i_theta);
+      if(m_Selector->getBit(error_idx))
       {
         Real_t ProjectionEntry = kConst0 * VoxelLineResponse[xzSliceIdx]->values[VoxelLineAccessCounter];
-        Thetas->d[1] += (ProjectionEntry * ProjectionEntry * m_Weight->d[error_idx]);
-        Thetas->d[0] += (ErrorSino->d[error_idx] * ProjectionEntry * m_Weight->d[error_idx]);
+        Thetas->d[1] += (ProjectionEntry * ProjectionEntry * weight);
+        Thetas->d[0] += (ErrorSino->d[error_idx] * ProjectionEntry * weight);
         VoxelLineAccessCounter++;
       }
       else
       {
-        Real_t QuadCoeff = (m_BraggDelta * m_BraggThreshold) / (fabs(ErrorSino->d[error_idx]) * sqrt(m_Weight->d[error_idx]));
+        Real_t QuadCoeff = (m_BraggDelta * m_BraggThreshold) / (fabs(ErrorSino->d[error_idx]) * sqrt(weight));
         Real_t ProjectionEntry = kConst0 * VoxelLineResponse[xzSliceIdx]->values[VoxelLineAccessCounter];
-        Thetas->d[1] += QuadCoeff * (ProjectionEntry * ProjectionEntry * m_Weight->d[error_idx]);
-        Thetas->d[0] += QuadCoeff * (ErrorSino->d[error_idx] * ProjectionEntry * m_Weight->d[error_idx]);
+        Thetas->d[1] += QuadCoeff * (ProjectionEntry * ProjectionEntry * weight);
+        Thetas->d[0] += QuadCoeff * (ErrorSino->d[error_idx] * ProjectionEntry * weight);
         VoxelLineAccessCounter++;
       }
     }
@@ -921,12 +1058,8 @@ void BFForwardModel::updateErrorSinogram(Real_t ChangeInVoxelValue,
 
       VoxelLineAccessCounter++;
       // Update the selector variable
-      if(fabs(ErrorSino->d[error_idx]*sqrt(m_Weight->d[error_idx])) < m_BraggThreshold)
-      { m_Selector->d[error_idx] = 1; }
-      else
-      {
-        m_Selector->d[error_idx] = 0;
-      }
+      Real_t weight = measurementWeight(sinogram->counts->d, error_idx, i_theta);
+      m_Selector->setBit(error_idx, fabs(ErrorSino->d[error_idx] * sqrt(weight)) < m_BraggThreshold);
     }
   }
 }
@@ -938,35 +1071,27 @@ void BFForwardModel::updateErrorSinogram(Real_t ChangeInVoxelValue,
 // -----------------------------------------------------------------------------
 void BFForwardModel::processRawCounts(SinogramPtr sinogram)
 {
-  Real_t mean = 0, maxval = -std::numeric_limits<Real_t>::infinity(); // -INFINITY;
-  for (int16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++) //slice index
+  // The MRC reader applies the transform while reading and leaves the per
+  // tilt statistics behind. Other readers leave the raw counts.
+  if(sinogram->logStatistics.size() != sinogram->N_theta)
   {
-    for (int16_t i_r = 0; i_r < sinogram->N_r; i_r++)
+    size_t numNegative = SinogramStatistics::logTransformCounts(sinogram, m_BfOffset, BF_MAX);
+    if(numNegative > 0)
     {
-      for (uint16_t i_t = 0; i_t < sinogram->N_t; i_t++)
-      {
-        size_t counts_idx = sinogram->counts->calcIndex(i_theta, i_r, i_t);
-        sinogram->counts->d[counts_idx] += m_BfOffset;//;BF_OFFSET;
-
-        if(sinogram->counts->d[counts_idx] < 0)
-        {
-          std::cout << "Error: Negative counts! The offset value is not correctly set" << std::endl;
-          break;
-        }
-
-        sinogram->counts->d[counts_idx] = -log(sinogram->counts->d[counts_idx] / BF_MAX);
-
-        // if(sinogram->counts->d[counts_idx] < 0 ) //Clip the log data to be positive
-        //     sinogram->counts->d[counts_idx] = 0;
-
-        //Debug/Sanity checks
-        mean += sinogram->counts->d[counts_idx];
-        if(fabs(sinogram->counts->d[counts_idx]) > maxval)
-        { maxval = sinogram->counts->d[counts_idx]; }
-      }
+      std::cout << "Error: Negative counts! The offset value is not correctly set (" << numNegative << " entries)" << std::endl;
     }
   }
-  mean /= (sinogram->N_theta * sinogram->N_r * sinogram->N_t);
+
+  //Debug/Sanity checks
+  Real_t mean = 0, maxval = -std::numeric_limits<Real_t>::infinity(); // -INFINITY;
+  for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
+  {
+    const TiltCountStatistics& stats = sinogram->logStatistics[i_theta];
+    mean += stats.Mean;
+    if(fabs(stats.Max) > maxval) { maxval = stats.Max; }
+    if(fabs(stats.Min) > maxval) { maxval = stats.Min; }
+  }
+  mean /= sinogram->N_theta;
   std::cout << "Mean log value =" << mean << std::endl;
   std::cout << "Max -log value =" << maxval << std::endl;
 }
@@ -977,17 +1102,10 @@ void BFForwardModel::processRawCounts(SinogramPtr sinogram)
 void BFForwardModel::printRatioSelected(SinogramPtr sinogram)
 {
   Real_t sum = 0;
+  size_t tiltSize = sinogram->N_r * sinogram->N_t;
   for (int16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++) //slice index
   {
-    Real_t sum_k = 0; //Sum for each tilt
-    for (int16_t i_r = 0; i_r < sinogram->N_r; i_r++)
-    {
-      for (uint16_t i_t = 0; i_t < sinogram->N_t; i_t++)
-      {
-        size_t counts_idx = sinogram->counts->calcIndex(i_theta, i_r, i_t);
-        sum_k += m_Selector->d[counts_idx];
-      }
-    }
+    Real_t sum_k = static_cast<Real_t>(m_Selector->countSetBits(i_theta * tiltSize, tiltSize)); //Sum for each tilt
     if(getVeryVerbose())
     {
       std::cout << "Ratio of sinogram at tilt :" << i_theta << " " << sum_k / (sinogram->N_r * sinogram->N_t) << std::endl;
@@ -1000,25 +1118,26 @@ void BFForwardModel::printRatioSelected(SinogramPtr sinogram)
 
 void BFForwardModel::writeSelectorMrc(const std::string& file, SinogramPtr sinogram, GeometryPtr geometry, RealVolumeType::Pointer ErrorSino)
 {
-  //const std::string mrcFile="Selector.mrc";
-  geometry->N_x = sinogram->N_r;
-  geometry->N_y = sinogram->N_t;
-  geometry->N_z = sinogram->N_theta;
-  geometry->Object = sinogram->counts;
-  for(uint32_t i_theta = 0; i_theta <  geometry->N_z; i_theta++)
+  if (file.empty() == true)
   {
-    for(uint32_t i_r = 0; i_r < geometry->N_x; i_r++)
-      for(uint32_t i_t = 0; i_t < geometry->N_y; i_t++)
-      {
-        size_t counts_idx = sinogram->counts->calcIndex(i_theta, i_r, i_t);
-        Real_t value = m_Selector->d[counts_idx];//exp(-sinogram->counts->d[counts_idx]+ErrorSino->d[counts_idx]);
-        //value -= BF_OFFSET;
-        counts_idx = sinogram->counts->calcIndex(i_theta, i_r, i_t);
-        geometry->Object->d[counts_idx] = value;
-      }
+    return;
+  }
+  // The selector is written through its own geometry and volume so the
+  // reconstruction and the counts stay intact for the next resolution
+  GeometryPtr selectorGeometry = GeometryPtr(new Geometry);
+  *selectorGeometry = *geometry;
+  selectorGeometry->N_x = sinogram->N_r;
+  selectorGeometry->N_y = sinogram->N_t;
+  selectorGeometry->N_z = sinogram->N_theta;
+  size_t dims[3] = { sinogram->N_theta, sinogram->N_r, sinogram->N_t };
+  selectorGeometry->Object = RealVolumeType::New(dims, "Selector");
+  size_t numElements = dims[0] * dims[1] * dims[2];
+  for (size_t counts_idx = 0; counts_idx < numElements; counts_idx++)
+  {
+    selectorGeometry->Object->d[counts_idx] = m_Selector->getBit(counts_idx) ? 1.0 : 0.0;
   }
   uint16_t cropStart = 0;
-  uint16_t cropEnd = geometry->N_x;
+  uint16_t cropEnd = selectorGeometry->N_x;
   /* Write the output to the MRC File */
   std::stringstream ss;
   ss.str("");
@@ -1028,11 +1147,11 @@ void BFForwardModel::writeSelectorMrc(const std::string& file, SinogramPtr sinog
   MRCWriter::Pointer mrcWriter = MRCWriter::New();
   //  mrcWriter->setOutputFile(mrcFile);
   mrcWriter->setOutputFile(file);
-  mrcWriter->setGeometry(geometry);
+  mrcWriter->setGeometry(selectorGeometry);
   mrcWriter->setAdvParams(m_AdvParams);
   mrcWriter->setXDims(cropStart, cropEnd);
-  mrcWriter->setYDims(0, geometry->N_y);
-  mrcWriter->setZDims(0, geometry->N_z);
+  mrcWriter->setYDims(0, selectorGeometry->N_y);
+  mrcWriter->setZDims(0, selectorGeometry->N_z);
   mrcWriter->setObservers(getObservers());
   mrcWriter->execute();
   if(mrcWriter->getErrorCondition() < 0)
@@ -1044,31 +1163,30 @@ void BFForwardModel::writeSelectorMrc(const std::string& file, SinogramPtr sinog
   }
 }
 
-//This function is REDUNDANT - Not used in current version
+// -----------------------------------------------------------------------------
+// Returns the threshold T such that a fraction "percentage" of the measurements
+// have |e|*sqrt(w) >= T and so would be rejected by the selector. The order
+// statistic is found on e*e*w without copying it out of the sinogram.
+// -----------------------------------------------------------------------------
 Real_t BFForwardModel::estimateBraggThreshold(SinogramPtr sinogram, RealVolumeType::Pointer ErrorSino, Real_t percentage)
 {
+  size_t NumElts = sinogram->N_theta * sinogram->N_r * sinogram->N_t;
+  size_t NumEltsReject = static_cast<size_t>(percentage * NumElts);
+  if(NumElts == 0)
+  {
+    return 0.0;
+  }
+  size_t rank = (NumEltsReject < NumElts) ? NumElts - NumEltsReject : NumElts - 1;
 
-  Real_t EstBraggThresh = 0.0;
-  uint32_t NumElts = sinogram->N_theta * sinogram->N_r * sinogram->N_t;
-  uint32_t NumEltsReject = percentage * NumElts; //Find the Error*Weight
-  //corresponding to this order statistic
-  RealArrayType::Pointer Ratio;
-  size_t dims[1] = {NumElts};
-  Ratio = RealArrayType::New(dims, "Ratio of error to noise variance");
-  uint32_t counts = 0;
-  for(uint32_t i_theta = 0; i_theta <  sinogram->N_theta; i_theta++)
-    for(uint32_t i_r = 0; i_r < sinogram->N_r; i_r++)
-      for(uint32_t i_t = 0; i_t < sinogram->N_t; i_t++)
-      {
-        size_t counts_idx = sinogram->counts->calcIndex(i_theta, i_r, i_t);
-        Ratio->d[counts] = ErrorSino->d[counts_idx] * m_Weight->d[counts_idx];
-        Ratio->d[counts] *= ErrorSino->d[counts_idx];
-        counts++;
-      }
-  std::cout << "Num Elts" << counts << std::endl;
-  std::cout << "Num Elts to reject =" << NumEltsReject << std::endl;
+  Detail::BraggRatioSource source(this, sinogram->counts->d, ErrorSino->d, sinogram->N_r * sinogram->N_t);
+  Real_t EstBraggThresh = sqrt(RadixQuantile::select(source, NumElts, rank));
 
-  std::cout << "Bragg Thresh estimated using Randomized select" << EstBraggThresh << std::endl;
+  if(getVeryVerbose())
+  {
+    std::cout << "Num Elts " << NumElts << std::endl;
+    std::cout << "Num Elts to reject = " << NumEltsReject << std::endl;
+    std::cout << "Bragg Thresh estimated = " << EstBraggThresh << std::endl;
+  }
 
   return EstBraggThresh;
 }
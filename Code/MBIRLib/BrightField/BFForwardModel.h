@@ -80,6 +80,10 @@
 #include "MBIRLib/BrightField/BFConstants.h"
 #include "MBIRLib/BrightField/BF_QGGMRFPriorModel.h"
 #include "MBIRLib/Common/AMatrixCol.h"
+#include "MBIRLib/Common/BitVolume.h"
+#include "MBIRLib/Common/EIMMath.h"
+#include "MBIRLib/Common/SlabTransport.h"
+#include "MBIRLib/Reconstruction/SinogramStatistics.h"
 
 
 /**
@@ -131,7 +135,48 @@ class BFForwardModel : public Observable
     MXA_INSTANCE_PROPERTY(RealArrayType::Pointer, Alpha) //Noise variance refinement factor
 
     MXA_INSTANCE_PROPERTY(RealVolumeType::Pointer, Weight) //This contains weights for each measurement = The diagonal covariance matrix in the Cost Func formulation
-    MXA_INSTANCE_PROPERTY(UInt8VolumeType::Pointer, Selector) //This contains weights for each measurement = The diagonal covariance matrix in the Cost Func formulation
+    MXA_INSTANCE_PROPERTY(BitVolume::Pointer, Selector) //One bit per measurement. Set if the measurement is not rejected as a Bragg outlier
+
+    /* Set when the sinogram is one Y slab of a distributed reconstruction. The
+     * per view sums behind the gain, offset and variance updates are then added
+     * up over all workers so every slab ends up with the same estimates. Halo
+     * rows are counted by both of the slabs that hold them. */
+    MXA_INSTANCE_PROPERTY(SlabTransport::Pointer, SlabTransport)
+
+    /* If set the Weight volume is not allocated and each weight is recomputed
+     * from the counts when it is needed (see measurementWeight) */
+    MXA_INSTANCE_PROPERTY(bool, ImplicitWeights)
+
+    /**
+     * @brief The weight of a measurement before the noise variance refinement is applied
+     */
+    static inline Real_t countsToWeight(Real_t counts)
+    {
+#ifndef IDENTITY_NOISE_MODEL
+      return BF_MAX / exp(counts);
+#else
+      return 1.0;
+#endif //IDENTITY_NOISE_MODEL endif
+    }
+
+    /**
+     * @brief Returns the weight of measurement idx which belongs to tilt i_theta
+     * whether the weights are stored or implicit
+     */
+    inline Real_t measurementWeight(const Real_t* counts, size_t idx, uint16_t i_theta) const
+    {
+      if(NULL != m_Weight.get())
+      {
+        return m_Weight->d[idx];
+      }
+      return countsToWeight(counts[idx]) * m_WeightScale->d[i_theta];
+    }
+
+    /**
+     * @brief Returns the per tilt factor of the implicit weights, NULL if the
+     * weights are stored
+     */
+    RealArrayType::Pointer getWeightScale() { return m_WeightScale; }
 
     void setQGGMRFValues(QGGMRF::QGGMRF_Values* qggmrf_values);
 
@@ -146,7 +191,7 @@ class BFForwardModel : public Observable
 
     void gainAndOffsetInitialization(uint16_t N_theta);
 
-    void weightInitialization(size_t dims[3]);
+    void weightInitialization(SinogramPtr sinogram, size_t dims[3]);
 
     int createNuisanceParameters(SinogramPtr sinogram);
 
@@ -181,15 +226,22 @@ class BFForwardModel : public Observable
      *
      * @param sinogram
      * @param errorSinogram
-     * @param yEstimate
      * @param cost
      * @return
      */
-    void jointEstimation(SinogramPtr sinogram,
-                         RealVolumeType::Pointer errorSinogram,
-                         RealVolumeType::Pointer yEstimate, CostData::Pointer cost);
-    void updateWeights(SinogramPtr sinogram,
-                       RealVolumeType::Pointer errorSinogram);
+    int jointEstimation(SinogramPtr sinogram,
+                        RealVolumeType::Pointer errorSinogram,
+                        CostData::Pointer cost);
+    int updateWeights(SinogramPtr sinogram,
+                      RealVolumeType::Pointer errorSinogram);
+
+    /**
+     * @brief Replaces the initial gains and offsets of every worker of a
+     * distributed reconstruction with their mean weighted by the given number
+     * of rows. Does nothing without a SlabTransport.
+     * @return Negative on Error.
+     */
+    int shareGainsAndOffsets(uint16_t nTheta, Real_t rows);
 
     void updateSelector(SinogramPtr sinogram,
                         RealVolumeType::Pointer errorSinogram);
@@ -198,6 +250,10 @@ class BFForwardModel : public Observable
 
     void writeSelectorMrc(const std::string& file, SinogramPtr sinogram, GeometryPtr geometry, RealVolumeType::Pointer ErrorSino);
 
+    /**
+     * @brief Estimates the Bragg threshold that rejects the given fraction of
+     * the measurements
+     */
     Real_t estimateBraggThreshold(SinogramPtr sinogram, RealVolumeType::Pointer ErrorSino, Real_t percentage);
 
 
@@ -233,6 +289,13 @@ class BFForwardModel : public Observable
   protected:
     BFForwardModel();
 
+    /**
+     * @brief Adds the per view sums and the measurement count up over the
+     * workers of a distributed reconstruction. Does nothing without a SlabTransport.
+     * @return Negative on Error.
+     */
+    int reduceTiltMoments(std::vector<TiltMoments>& moments, Real_t& numMeasurements);
+
   private:
     RealImageType::Pointer m_QuadraticParameters; //holds the coefficients of N_theta quadratic equations. This will be initialized inside the MAPICDREconstruct function
     RealImageType::Pointer m_QkCost;
@@ -241,6 +304,9 @@ class BFForwardModel : public Observable
     RealArrayType::Pointer m_D1;
     RealArrayType::Pointer m_D2; //hold the intermediate values needed to compute optimal mu_k
 
+    RealArrayType::Pointer m_WeightScale; //Per tilt factor of the implicit weights
+    ImplicitWeight m_ImplicitWeight;
+
     Real_t k_HammingWindow[5][5];
     Real_t Theta[2]; //Theta1 and Theta2 in the optimization
 
@@ -42,11 +42,20 @@
 
 #include <iostream>
 
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_scheduler_init.h>
+#endif
+
 #include "MXA/Utilities/MXADir.h"
 #include "MXA/Utilities/MXAFileInfo.h"
 #include "MXA/Utilities/StringUtils.h"
 #include "MBIRLib/Common/EIMMath.h"
+#include "MBIRLib/Common/MemoryRegistry.h"
 #include "MBIRLib/BrightField/BFForwardModel.h"
+#include "MBIRLib/GenericFilters/MRCSinogramInitializer.h"
+#include "MBIRLib/IOFilters/MRCReader.h"
+#include "MBIRLib/IOFilters/ReconstructionCheckpoint.h"
+#include "MBIRLib/Reconstruction/SinogramStatistics.h"
 
 
 // -----------------------------------------------------------------------------
@@ -61,6 +70,10 @@ BFMultiResolutionReconstruction::BFMultiResolutionReconstruction() :
   m_BrightFieldFile(""),
   m_InitialReconstructionFile(""),
   m_DeleteTempFiles(false),
+  m_WriteIntermediateFiles(false),
+  m_SnapshotPolicy(MBIR::SnapshotPolicy::EveryIteration),
+  m_SnapshotInterval(1),
+  m_CheckpointInterval(-1),
   m_NumberResolutions(1),
   m_SampleThickness(100.0f),
   m_TargetGain(0.0f),
@@ -76,7 +89,12 @@ BFMultiResolutionReconstruction::BFMultiResolutionReconstruction() :
   m_InterpolateInitialReconstruction(false),
   m_DefaultVariance(1.0f),
   m_InitialReconstructionValue(0.0f),
+  m_SIRTIterations(0),
   m_DefaultPixelSize(1.0),
+  m_ImplicitWeights(false),
+  m_MemoryBudget(0),
+  m_YSlabs(1),
+  m_MemoryReportFile(""),
   m_Cancel(false)
 {
 
@@ -123,6 +141,7 @@ void BFMultiResolutionReconstruction::printInputs(TomoInputsPtr inputs, std::ost
   PRINT_VAR(out, inputs, extendObject);
   PRINT_VAR(out, inputs, interpolateFactor);
   PRINT_VAR(out, inputs, defaultInitialRecon);
+  PRINT_VAR(out, inputs, NumSIRTIter);
 
 #if 0
   PRINT_VAR(out, inputs, targetGain);
@@ -183,17 +202,203 @@ void BFMultiResolutionReconstruction::execute()
   pipelineProgressMessage(ss.str());
   ss.str("");
 
-  TomoInputsPtr prevInputs = TomoInputsPtr(new TomoInputs);
-  BFReconstructionEngine::InitializeTomoInputs(prevInputs);
+  // A resumed reconstruction starts at the resolution its checkpoint was taken at
+  int resumeResolution = 0;
+  if(m_ResumeFile.empty() == false)
+  {
+    std::map<std::string, Real_t> counters;
+    if(ReconstructionCheckpoint::ReadCounters(m_ResumeFile, counters) < 0 || counters.find("Resolution") == counters.end())
+    {
+      ss.str("");
+      ss << "Could not read the checkpoint to resume from: " << m_ResumeFile << std::endl;
+      setErrorCondition(-1);
+      pipelineErrorMessage(ss.str());
+      return;
+    }
+    resumeResolution = static_cast<int>(counters["Resolution"]);
+    ss.str("");
+    ss << "-- Resuming at resolution " << resumeResolution << " from " << m_ResumeFile;
+    pipelineProgressMessage(ss.str());
+  }
 
+  // A worker of a distributed reconstruction owns the Y slab of its rank
+  int workers = (NULL != m_Transport.get()) ? m_Transport->getSize() : 1;
 
-  for (int i = 0; i < m_NumberResolutions; ++i)
+  // Find out if the reconstruction fits before anything is allocated
+  MemoryPlanner::Pointer plan = planMemory();
+  if(NULL != plan.get())
+  {
+    ss.str("");
+    plan->printPlan(ss);
+    pipelineProgressMessage(ss.str());
+    if(plan->getFeasible() == false)
+    {
+      ss.str("");
+      ss << "The reconstruction needs " << MemoryPlanner::FormatBytes(plan->getPeakBytes()) << " which is more than the memory budget of "
+         << MemoryPlanner::FormatBytes(m_MemoryBudget) << std::endl;
+      setErrorCondition(-1);
+      pipelineErrorMessage(ss.str());
+      return;
+    }
+    if(plan->getPlannedImplicitWeights() != m_ImplicitWeights)
+    {
+      m_ImplicitWeights = plan->getPlannedImplicitWeights();
+      pipelineProgressMessage("-- Implicit weights are turned on to fit the memory budget");
+    }
+  }
+  else if(m_YSlabs != 1 || workers > 1)
+  {
+    setErrorCondition(-1);
+    pipelineErrorMessage("Reconstructing in Y slabs needs an MRC input file\n");
+    return;
+  }
+
+  int slabs = (NULL != plan.get()) ? plan->getPlannedYSlabs() : 1;
+  if(workers > 1 && slabs != workers)
+  {
+    ss.str("");
+    ss << "The region has too few rows to split between " << workers << " workers" << std::endl;
+    setErrorCondition(-1);
+    pipelineErrorMessage(ss.str());
+    return;
+  }
+  if(slabs > 1)
+  {
+    if(m_ResumeFile.empty() == false || m_InitialReconstructionFile.empty() == false)
+    {
+      setErrorCondition(-1);
+      pipelineErrorMessage("A reconstruction in Y slabs can not be resumed or start from an initial reconstruction file\n");
+      return;
+    }
+
+    // Every slab reconstructs its rows of the region the planner resolved and
+    // a halo into its neighbours, then writes its own rows of the output
+    TomoInputsPtr region = plan->getTomoInputs();
+    uint16_t rows = region->yEnd - region->yStart + 1;
+    std::vector<YSlab> layout;
+    MemoryPlanner::SplitYSlabs(rows, MemoryPlanner::YSlabAlignment(m_NumberResolutions, m_FinalResolution), slabs, layout);
+    BFForwardModel::Pointer sharedNuisance;
+    if(workers == 1 && getOuterIterations() > 1 && (m_AdvParams->JOINT_ESTIMATION || m_AdvParams->NOISE_ESTIMATION))
+    {
+      err = estimateSlabNuisanceParameters(region, layout, tempFiles, sharedNuisance);
+      if(err < 0)
+      {
+        writeMemoryReport();
+        setErrorCondition(err);
+        return;
+      }
+    }
+    for (size_t s = 0; s < layout.size(); ++s)
+    {
+      if(workers > 1 && static_cast<int>(s) != m_Transport->getRank())
+      {
+        continue;
+      }
+      ss.str("");
+      ss << "-- Y slab " << (s + 1) << " of " << layout.size() << ": rows " << (region->yStart + layout[s].CoreStart)
+         << " to " << (region->yStart + layout[s].CoreEnd - 1);
+      pipelineProgressMessage(ss.str());
+
+      std::vector<uint16_t> subvolume(6, 0);
+      subvolume[0] = region->xStart;
+      subvolume[1] = region->yStart + layout[s].Start;
+      subvolume[2] = region->zStart;
+      subvolume[3] = region->xEnd;
+      subvolume[4] = region->yStart + layout[s].End - 1;
+      subvolume[5] = region->zEnd;
+      std::string slabDir = m_TempDir + MXADir::Separator + "slab_" + StringUtils::numToString(static_cast<int>(s));
+      err = reconstructRegion(subvolume, slabDir, 0, &(layout[s]), rows, sharedNuisance, NULL, tempFiles);
+      if(err < 0)
+      {
+        writeMemoryReport();
+        setErrorCondition(err);
+        return;
+      }
+      tempFiles.push_back(slabDir);
+    }
+  }
+  else
+  {
+    err = reconstructRegion(m_Subvolume, m_TempDir, resumeResolution, NULL, 0, BFForwardModel::NullPointer(), NULL, tempFiles);
+    if(err < 0)
+    {
+      writeMemoryReport();
+      setErrorCondition(err);
+      return;
+    }
+  }
+  writeMemoryReport();
+
+
+  if (getDeleteTempFiles() == true)
+  {
+    for(size_t i = 0; i < tempFiles.size(); ++i)
+    {
+      // std::cout << "Removing: " << tempFiles[i] << std::endl;
+      if(MXADir::isDirectory(tempFiles[i]) == true )
+      {
+        errno = 0;
+        if (false == MXADir::rmdir(tempFiles[i], false) )
+        {
+          std::cout << errno << " - Could NOT remove Directory: " << tempFiles[i] << std::endl;
+          std::vector<std::string> dirList = MXADir::entryList(tempFiles[i]);
+          for(size_t i = 0; i < dirList.size(); ++i)
+          {
+            std::cout << "   " << dirList[i] << std::endl;
+          }
+        }
+      }
+      else
+      {
+        MXADir::remove(tempFiles[i]);
+      }
+    }
+  }
+
+  updateProgressAndMessage("MultiResolution SOC Complete", 100);
+  setErrorCondition(err);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int BFMultiResolutionReconstruction::reconstructRegion(const std::vector<uint16_t>& subvolume, const std::string& tempDir,
+                                                       int resumeResolution, const YSlab* slab, uint16_t regionRows,
+                                                       BFForwardModel::Pointer sharedNuisance, BFForwardModel::Pointer* nuisanceEstimate,
+                                                       std::vector<std::string>& tempFiles)
+{
+  int err = 0;
+  std::stringstream ss;
+
+  // The full resolution sinogram is read once and every resolution runs
+  // against a copy of it that is binned to match its voxel size
+  TomoInputsPtr fullInputs;
+  SinogramPtr fullSinogram;
+
+  // The results of each resolution are handed to the next one in memory
+  GeometryPtr prevGeometry;
+  BFForwardModel::Pointer prevForwardModel;
+
+  // The engines of all resolutions share one pool so a finer resolution gets
+  // the sinogram buffers of the coarser one back instead of new allocations
+  SinogramBufferPool::Pointer bufferPool = SinogramBufferPool::New();
+
+  // The slab is one of several that other workers reconstruct at the same time
+  bool distributed = (NULL != slab && NULL != m_Transport.get() && m_Transport->getSize() > 1);
+
+  // Estimating the nuisance parameters only needs the coarsest resolution
+  int numResolutions = (NULL != nuisanceEstimate) ? 1 : m_NumberResolutions;
+
+  for (int i = 0; i < numResolutions; ++i)
   {
     BFForwardModel::Pointer forwardModel = BFForwardModel::New();
     if(getCancel() == true)
     {
-      setErrorCondition(-999);
-      return;
+      return -999;
+    }
+    if(i < resumeResolution)
+    {
+      continue;
     }
 
     TomoInputsPtr inputs = TomoInputsPtr(new TomoInputs);
@@ -205,17 +410,37 @@ void BFMultiResolutionReconstruction::execute()
     ss << "Extend Object Flag" << inputs->extendObject << std::endl;
     pipelineProgressMessage(ss.str());
 
-    /* Get our input files from the last resolution iteration */
-    inputs->gainsInputFile = prevInputs->gainsOutputFile;
-    inputs->offsetsInputFile = prevInputs->offsetsOutputFile;
-    inputs->varianceInputFile = prevInputs->varianceOutputFile;
+    /* Get our inputs from the last resolution iteration */
     if(i == 0)
     {
       inputs->initialReconFile = getInitialReconstructionFile();
     }
-    else
+    else if(NULL != prevGeometry.get())
+    {
+      inputs->initialRecon = prevGeometry->Object;
+      if(m_AdvParams->JOINT_ESTIMATION)
+      {
+        inputs->initialGains = prevForwardModel->getI_0();
+        inputs->initialOffsets = prevForwardModel->getMu();
+      }
+      if(m_AdvParams->NOISE_ESTIMATION)
+      {
+        inputs->initialVariances = prevForwardModel->getAlpha();
+      }
+    }
+    if(NULL != sharedNuisance.get())
     {
-      inputs->initialReconFile = prevInputs->reconstructedOutputFile;
+      // The slab starts from and keeps the parameters estimated over all the slabs
+      inputs->fixedNuisanceParameters = true;
+      if(m_AdvParams->JOINT_ESTIMATION)
+      {
+        inputs->initialGains = sharedNuisance->getI_0();
+        inputs->initialOffsets = sharedNuisance->getMu();
+      }
+      if(m_AdvParams->NOISE_ESTIMATION)
+      {
+        inputs->initialVariances = sharedNuisance->getAlpha();
+      }
     }
 
     if(i == 0)
@@ -231,7 +456,35 @@ void BFMultiResolutionReconstruction::execute()
 
     /* Now set the input files for this resolution */
     inputs->sinoFile = m_InputFile;
-    inputs->tempDir = m_TempDir + MXADir::Separator + StringUtils::numToString(inputs->interpolateFactor / static_cast<int>(powf(2.0f, i))) + std::string("x");
+    inputs->snapshotPolicy = m_SnapshotPolicy;
+    inputs->snapshotInterval = m_SnapshotInterval;
+    inputs->checkpointInterval = m_CheckpointInterval;
+    inputs->resolution = i;
+    if(NULL != slab)
+    {
+      // Counted in voxels of this resolution
+      unsigned int voxelRows = static_cast<unsigned int>(powf(2.0f, getNumberResolutions() - i - 1)) * m_FinalResolution;
+      inputs->slabHaloStart = (slab->CoreStart - slab->Start) / voxelRows;
+      inputs->slabHaloEnd = (slab->End - slab->CoreEnd) / voxelRows;
+      inputs->slabOutputY = slab->CoreStart / voxelRows;
+      inputs->slabOutputNy = regionRows / voxelRows;
+    }
+    if(i == resumeResolution)
+    {
+      inputs->resumeFile = m_ResumeFile;
+    }
+    std::string resolutionName = StringUtils::numToString(inputs->interpolateFactor / static_cast<int>(powf(2.0f, i))) + std::string("x");
+    inputs->tempDir = tempDir + MXADir::Separator + resolutionName;
+
+    // The memory of every named array is accounted to the resolution
+    ss.str("");
+    ss << "resolution " << resolutionName;
+    if(NULL != slab)
+    {
+      ss << " of the Y slab of rows " << slab->CoreStart << " to " << (slab->CoreEnd - 1);
+    }
+    MemoryRegistry::Instance()->beginLevel(ss.str());
+    ss.str("");
 
     //Make sure the directory is created:
     bool success = MXADir::mkdir(inputs->tempDir, true);
@@ -239,13 +492,12 @@ void BFMultiResolutionReconstruction::execute()
     {
       ss.str("");
       ss << "Could not create path: " << inputs->tempDir << std::endl;
-      setErrorCondition(-1);
       pipelineErrorMessage(ss.str());
-      return;
+      return -1;
     }
 
     // Only write the mrc and vtk files on the last iteration
-    if(m_NumberResolutions - 1 == i) // Last Iteration
+    if(m_NumberResolutions - 1 == i && NULL == nuisanceEstimate) // Last Iteration
     {
       inputs->vtkOutputFile = MXAFileInfo::parentPath(m_OutputFile) + MXADir::Separator + MXAFileInfo::fileNameWithOutExtension(m_OutputFile) + ".vtk";
       inputs->avizoOutputFile = MXAFileInfo::parentPath(m_OutputFile) + MXADir::Separator + MXAFileInfo::fileNameWithOutExtension(m_OutputFile) + ".am";
@@ -253,10 +505,6 @@ void BFMultiResolutionReconstruction::execute()
     }
     else
     {
-      ss.str("");
-      ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::ReconstructedObjectFile;
-      inputs->reconstructedOutputFile = ss.str();
-
       inputs->vtkOutputFile = "";
       inputs->mrcOutputFile = "";
       inputs->avizoOutputFile = "";
@@ -265,24 +513,24 @@ void BFMultiResolutionReconstruction::execute()
     // Line up all the temp files that we are going to delete
     ss.str("");
     ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::FinalGainParametersFile;
-    inputs->gainsOutputFile = ss.str();
+    if(m_WriteIntermediateFiles) { inputs->gainsOutputFile = ss.str(); }
     tempFiles.push_back(ss.str());
 
     ss.str("");
     ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::FinalOffsetParametersFile;
-    inputs->offsetsOutputFile = ss.str();
+    if(m_WriteIntermediateFiles) { inputs->offsetsOutputFile = ss.str(); }
     tempFiles.push_back(ss.str());
 
     ss.str("");
     ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::FinalVariancesFile;
-    inputs->varianceOutputFile = ss.str();
+    if(m_WriteIntermediateFiles) { inputs->varianceOutputFile = ss.str(); }
     tempFiles.push_back(ss.str());
 
 
     //initialize the Bragg selector file
     ss.str("");
     ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::BraggSelectorFile;
-    inputs->braggSelectorFile = ss.str();
+    if(m_WriteIntermediateFiles) { inputs->braggSelectorFile = ss.str(); }
     tempFiles.push_back(ss.str());
 
     // Create the paths for all the temp files that we want to delete
@@ -300,6 +548,7 @@ void BFMultiResolutionReconstruction::execute()
 
     ss.str("");
     ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::ReconstructedObjectFile;
+    if(m_WriteIntermediateFiles) { inputs->reconstructedOutputFile = ss.str(); }
     tempFiles.push_back(ss.str());
 
     ss.str("");
@@ -307,15 +556,16 @@ void BFMultiResolutionReconstruction::execute()
     tempFiles.push_back(ss.str());
 
     ss.str("");
-    ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::UpsampledBinFile;
+    ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::FilteredMagMapFile;
     tempFiles.push_back(ss.str());
 
     ss.str("");
-    ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::FilteredMagMapFile;
+    ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::MagnitudeMapFile;
     tempFiles.push_back(ss.str());
 
     ss.str("");
-    ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::MagnitudeMapFile;
+    ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::CheckpointFile;
+    inputs->checkpointFile = ss.str();
     tempFiles.push_back(ss.str());
 
     inputs->NumOuterIter = getOuterIterations();
@@ -341,6 +591,7 @@ void BFMultiResolutionReconstruction::execute()
     if(i == 0)
     {
       inputs->defaultInitialRecon = getInitialReconstructionValue();
+      inputs->NumSIRTIter = getSIRTIterations();
       forwardModel->setDefaultVariance(getDefaultVariance());
     }
     inputs->delta_xy = powf(2.0f, getNumberResolutions() - i - 1) * static_cast<Real_t>(m_FinalResolution);
@@ -357,17 +608,18 @@ void BFMultiResolutionReconstruction::execute()
     forwardModel->setBraggDelta(getBraggDelta()); //Set the Bragg function Delta value
     forwardModel->setBraggThreshold(getBraggThreshold());
     forwardModel->setBfOffset(getBfOffset());
+    forwardModel->setImplicitWeights(getImplicitWeights());
 
     inputs->tilts = m_Tilts;
-    if(m_Subvolume.size() > 0)
+    if(subvolume.size() > 0)
     {
       inputs->useSubvolume = true;
-      inputs->xStart = m_Subvolume[0];
-      inputs->xEnd = m_Subvolume[3];
-      inputs->yStart = m_Subvolume[1];
-      inputs->yEnd = m_Subvolume[4];
-      inputs->zStart = m_Subvolume[2];
-      inputs->zEnd = m_Subvolume[5];
+      inputs->xStart = subvolume[0];
+      inputs->xEnd = subvolume[3];
+      inputs->yStart = subvolume[1];
+      inputs->yEnd = subvolume[4];
+      inputs->zStart = subvolume[2];
+      inputs->zEnd = subvolume[5];
 
     }
 
@@ -386,14 +638,65 @@ void BFMultiResolutionReconstruction::execute()
     sinogram->delta_r = getDefaultPixelSize();
     sinogram->delta_t = getDefaultPixelSize();
 
-    //Calculate approximate memory required
-    memCalculate(inputs);
+    if(NULL == fullSinogram.get() && MXAFileInfo::extension(inputs->sinoFile).compare("bin") != 0)
+    {
+      fullSinogram = SinogramPtr(new Sinogram);
+      *fullSinogram = *sinogram;
+      err = readFullSinogram(inputs, fullSinogram, forwardModel->getBfOffset());
+      if(err < 0)
+      {
+        return err;
+      }
+      fullInputs = inputs;
+    }
+
+    if(NULL != fullSinogram.get())
+    {
+      // The counts are already log transformed so the engine skips reading.
+      // The subvolume the reader settled on is carried over.
+      unsigned int binning = detectorBinning(fullSinogram, i);
+      if(binning > 1)
+      {
+        // The binned sinogram carries the weights aggregated from the full
+        // resolution measurements. The A matrix and the detector response
+        // follow the binned delta_r and delta_t.
+        sinogram = SinogramStatistics::binDetector(fullSinogram, binning, &BFForwardModel::countsToWeight);
+      }
+      else
+      {
+        *sinogram = *fullSinogram;
+      }
+      inputs->xStart = fullInputs->xStart;
+      inputs->xEnd = fullInputs->xEnd;
+      inputs->yStart = fullInputs->yStart;
+      inputs->yEnd = fullInputs->yEnd;
+      inputs->zStart = fullInputs->zStart;
+      inputs->zEnd = fullInputs->zEnd;
+      inputs->fileXSize = fullInputs->fileXSize;
+      inputs->fileYSize = fullInputs->fileYSize;
+      inputs->fileZSize = fullInputs->fileZSize;
+      inputs->goodViews = fullInputs->goodViews;
+
+      // The voxel sizes and the interpolation factor are multiples of delta_r
+      // so they are rescaled to keep the same physical size on the binned grid
+      inputs->delta_xy /= binning;
+      inputs->delta_xz /= binning;
+      inputs->interpolateFactor /= binning;
+
+      ss.str("");
+      ss << "Detector binning " << binning << "x" << binning << ": N_r=" << sinogram->N_r << " N_t=" << sinogram->N_t;
+      pipelineProgressMessage(ss.str());
+    }
 
     forwardModel->setAdvParams(m_AdvParams);
     forwardModel->setTomoInputs(inputs);
 
     forwardModel->addObserver(this);
-    forwardModel->setMessagePrefix(StringUtils::numToString(inputs->interpolateFactor / static_cast<int>(powf(2.0f, i))) + std::string("x: "));
+    forwardModel->setMessagePrefix(resolutionName + std::string(": "));
+    if(distributed == true)
+    {
+      forwardModel->setSlabTransport(m_Transport);
+    }
 
     forwardModel->setVerbose(false);
     forwardModel->setVeryVerbose(false);
@@ -406,22 +709,61 @@ void BFMultiResolutionReconstruction::execute()
     engine->setGeometry(geometry);
     engine->setAdvParams(m_AdvParams);
     engine->setForwardModel(forwardModel);
+    engine->setBufferPool(bufferPool);
+    if(distributed == true)
+    {
+      engine->setSlabTransport(m_Transport);
+    }
 
     engine->setVerbose(true);
     engine->setVeryVerbose(true);
 
     // We need to get messages to the gui or command line
     engine->addObserver(this);
-    engine->setMessagePrefix(StringUtils::numToString(inputs->interpolateFactor / static_cast<int>(powf(2.0f, i))) + std::string("x: "));
+    engine->setMessagePrefix(resolutionName + std::string(": "));
     ss.str("");
     ss << "Sinogram Inputs -----------------------------------------" << std::endl;
     printInputs(inputs, ss);
     pipelineProgressMessage(ss.str());
 
+    // The workers share the output files so they write them one after the other
+    bool writeInTurn = (distributed == true && m_NumberResolutions - 1 == i);
+    std::string vtkOutputFile = inputs->vtkOutputFile;
+    std::string mrcOutputFile = inputs->mrcOutputFile;
+    std::string avizoOutputFile = inputs->avizoOutputFile;
+    if(writeInTurn == true)
+    {
+      inputs->vtkOutputFile = "";
+      inputs->mrcOutputFile = "";
+      inputs->avizoOutputFile = "";
+    }
+
     engine->execute();
+    if(distributed == true && engine->getErrorCondition() < 0)
+    {
+      return engine->getErrorCondition();
+    }
+    if(writeInTurn == true)
+    {
+      inputs->vtkOutputFile = vtkOutputFile;
+      inputs->mrcOutputFile = mrcOutputFile;
+      inputs->avizoOutputFile = avizoOutputFile;
+      err = writeSlabInTurn(engine);
+      if(err < 0)
+      {
+        return err;
+      }
+    }
     engine = BFReconstructionEngine::NullPointer();
 
-    prevInputs = inputs;
+    // Only the volume that was just reconstructed is kept alive
+    inputs->initialRecon = RealVolumeType::NullPointer();
+    prevGeometry = geometry;
+    prevForwardModel = forwardModel;
+
+    // The observers get what the resolution used before the next one starts
+    reportMemory();
+    MemoryRegistry::Instance()->endLevel();
 
     // Get any tempfiles created by the process such as intermediate files for display
     // during the reconstruction
@@ -438,83 +780,259 @@ void BFMultiResolutionReconstruction::execute()
     ss << inputs->tempDir;
     tempFiles.push_back(ss.str());
   }
+  if(NULL != nuisanceEstimate)
+  {
+    *nuisanceEstimate = prevForwardModel;
+  }
+  return err;
+}
 
-
-  if (getDeleteTempFiles() == true)
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int BFMultiResolutionReconstruction::estimateSlabNuisanceParameters(TomoInputsPtr region, const std::vector<YSlab>& layout,
+                                                                    std::vector<std::string>& tempFiles,
+                                                                    BFForwardModel::Pointer& shared)
+{
+  std::stringstream ss;
+  uint16_t rows = region->yEnd - region->yStart + 1;
+  std::vector<Real_t> sums[3];
+  Real_t totalRows = 0;
+  for (size_t s = 0; s < layout.size(); ++s)
   {
-    for(size_t i = 0; i < tempFiles.size(); ++i)
+    ss.str("");
+    ss << "-- Estimating the nuisance parameters of Y slab " << (s + 1) << " of " << layout.size();
+    pipelineProgressMessage(ss.str());
+
+    std::vector<uint16_t> subvolume(6, 0);
+    subvolume[0] = region->xStart;
+    subvolume[1] = region->yStart + layout[s].Start;
+    subvolume[2] = region->zStart;
+    subvolume[3] = region->xEnd;
+    subvolume[4] = region->yStart + layout[s].End - 1;
+    subvolume[5] = region->zEnd;
+    std::string slabDir = m_TempDir + MXADir::Separator + "slab_" + StringUtils::numToString(static_cast<int>(s));
+    BFForwardModel::Pointer estimate;
+    int err = reconstructRegion(subvolume, slabDir, 0, &(layout[s]), rows, BFForwardModel::NullPointer(), &estimate, tempFiles);
+    if(err < 0)
     {
-      // std::cout << "Removing: " << tempFiles[i] << std::endl;
-      if(MXADir::isDirectory(tempFiles[i]) == true )
+      return err;
+    }
+    if(NULL == estimate.get())
+    {
+      return -1;
+    }
+
+    // Only the per view arrays are kept, not the weights of the slab
+    RealArrayType::Pointer parameters[3] = { estimate->getI_0(), estimate->getMu(), estimate->getAlpha() };
+    Real_t weight = layout[s].CoreEnd - layout[s].CoreStart;
+    for (int p = 0; p < 3; ++p)
+    {
+      if(NULL == parameters[p].get())
       {
-        errno = 0;
-        if (false == MXADir::rmdir(tempFiles[i], false) )
-        {
-          std::cout << errno << " - Could NOT remove Directory: " << tempFiles[i] << std::endl;
-          std::vector<std::string> dirList = MXADir::entryList(tempFiles[i]);
-          for(size_t i = 0; i < dirList.size(); ++i)
-          {
-            std::cout << "   " << dirList[i] << std::endl;
-          }
-        }
+        continue;
       }
-      else
+      size_t count = parameters[p]->getDims()[0];
+      sums[p].resize(count, 0.0);
+      for (size_t v = 0; v < count; ++v)
       {
-        MXADir::remove(tempFiles[i]);
+        sums[p][v] += weight * parameters[p]->d[v];
       }
     }
+    totalRows += weight;
   }
 
-  updateProgressAndMessage("MultiResolution SOC Complete", 100);
-  setErrorCondition(err);
+  shared = BFForwardModel::New();
+  const char* names[3] = { "Shared Gains", "Shared Offsets", "Shared Variances" };
+  RealArrayType::Pointer parameters[3];
+  for (int p = 0; p < 3; ++p)
+  {
+    if(sums[p].empty() == true)
+    {
+      continue;
+    }
+    size_t dims[1] = { sums[p].size() };
+    parameters[p] = RealArrayType::New(dims, names[p]);
+    for (size_t v = 0; v < sums[p].size(); ++v)
+    {
+      parameters[p]->d[v] = sums[p][v] / totalRows;
+    }
+  }
+  shared->setI_0(parameters[0]);
+  shared->setMu(parameters[1]);
+  shared->setAlpha(parameters[2]);
+  return 0;
 }
 
-void BFMultiResolutionReconstruction::memCalculate(TomoInputsPtr inputs)
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void BFMultiResolutionReconstruction::reportMemory()
 {
-  float GeomNx, GeomNy, GeomNz;
-  float SinoNr, SinoNt, SinoNtheta;
-  SinoNr = static_cast<float>(inputs->xEnd - inputs->xStart + 1);
-  SinoNt = static_cast<float>(inputs->yEnd - inputs->yStart + 1);
-  SinoNtheta = static_cast<float>(inputs->zEnd - inputs->zStart + 1);
-
-  AdvancedParametersPtr advancedParams = AdvancedParametersPtr(new AdvancedParameters);
-  BFReconstructionEngine::InitializeAdvancedParams(advancedParams);
+  std::stringstream ss;
+  MemoryRegistry::Instance()->printReport(ss);
+  pipelineProgressMessage(ss.str());
+}
 
-  if(inputs->extendObject == 1)
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void BFMultiResolutionReconstruction::writeMemoryReport()
+{
+  if(m_MemoryReportFile.empty() == true)
   {
-    GeomNx = (SinoNr / m_FinalResolution) * 4; //TODO:Need to access X_Stretch and
+    return;
   }
-  else
+  std::string file = m_MemoryReportFile;
+  if(NULL != m_Transport.get() && m_Transport->getSize() > 1)
+  {
+    file = file + "." + StringUtils::numToString(m_Transport->getRank());
+  }
+  if(MemoryRegistry::Instance()->writeJson(file) < 0)
   {
-    GeomNx = SinoNr / m_FinalResolution;
+    pipelineWarningMessage("Could not write the memory report to " + file + "\n");
   }
+}
 
-  GeomNy = SinoNt / m_FinalResolution;
-  GeomNz = advancedParams->Z_STRETCH * (m_SampleThickness / (m_FinalResolution)); // TODO: need to access Sinogram_deltar and z_stretch.
-  //This is wrong currently. Need to multiply m_FinalResolution by size of voxel in nm
-
-  float dataTypeMem = sizeof(Real_t);
-  float ObjectMem = GeomNx * GeomNy * GeomNz * dataTypeMem;
-  float SinogramMem = SinoNr * SinoNt * SinoNtheta * dataTypeMem;
-  float ErroSinoMem = SinogramMem;
-  float WeightMem = SinogramMem; //Weight matrix
-  float A_MatrixMem;
-  if(0 == inputs->extendObject)
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int BFMultiResolutionReconstruction::writeSlabInTurn(BFReconstructionEngine::Pointer engine)
+{
+  // The first worker creates the files and the others add their rows to them
+  int err = 0;
+  for (int rank = 0; rank < m_Transport->getSize(); ++rank)
   {
-    A_MatrixMem = GeomNx * GeomNz * (m_FinalResolution * 3 * (dataTypeMem + 4) * SinoNtheta); // 4 is the bytes to store the counts
-    //*+4 correspodns to bytes to store a single double and a unsigned into to
-    //store the offset. 3*m_FinalRes is the approximate number of detector elements hit per voxel
+    if(rank == m_Transport->getRank())
+    {
+      engine->writeOutputFiles();
+      err = engine->getErrorCondition();
+    }
+    if(m_Transport->barrier() < 0)
+    {
+      std::stringstream ss;
+      ss << "Lost the other workers while writing the output: " << m_Transport->getErrorMessage() << std::endl;
+      pipelineErrorMessage(ss.str());
+      return -1;
+    }
   }
-  else
+  return err;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int BFMultiResolutionReconstruction::readFullSinogram(TomoInputsPtr inputs, SinogramPtr sinogram, Real_t bfOffset)
+{
+  MRCSinogramInitializer::Pointer reader = MRCSinogramInitializer::New();
+  reader->setLogTransform(true);
+  reader->setLogOffset(bfOffset);
+  reader->setLogNormalization(BF_MAX);
+  reader->setTomoInputs(inputs);
+  reader->setSinogram(sinogram);
+  reader->setAdvParams(m_AdvParams);
+  reader->addObserver(this);
+  reader->setVerbose(true);
+  reader->setVeryVerbose(false);
+  reader->execute();
+  if(reader->getErrorCondition() < 0)
   {
-    A_MatrixMem = GeomNx * GeomNz * (m_FinalResolution * (dataTypeMem + 4) * SinoNtheta); //Since we are reconstructing a larger region there are several voxels with no projection data. so instead of each voxel hitting 3*m_FinalRes det entries we aproximate it by m_FinalRes
+    std::stringstream ss;
+    ss << "Error reading the input file: '" << inputs->sinoFile << "'";
+    pipelineErrorMessage(ss.str());
+    return reader->getErrorCondition();
   }
-  float NuisanceParamMem = SinoNtheta * dataTypeMem * 3; //3 is for gains offsets and noise var
+  return 0;
+}
 
-  float TotalMem = ObjectMem + SinogramMem * 2 + ErroSinoMem + WeightMem + A_MatrixMem + NuisanceParamMem; //in bytes
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+unsigned int BFMultiResolutionReconstruction::detectorBinning(SinogramPtr sinogram, int resolution)
+{
+  unsigned int voxelSize = static_cast<unsigned int>(powf(2.0f, getNumberResolutions() - resolution - 1)) * m_FinalResolution;
+  return MemoryPlanner::DetectorBinning(sinogram->N_r, sinogram->N_t, voxelSize);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MemoryPlanner::Pointer BFMultiResolutionReconstruction::planMemory()
+{
+  // Only the header of an MRC file is needed to size the reconstruction
+  if(MXAFileInfo::extension(m_InputFile).compare("bin") == 0 || NULL == m_AdvParams.get())
+  {
+    return MemoryPlanner::NullPointer();
+  }
+  MRCHeader header;
+  ::memset(&header, 0, sizeof(header));
+  MRCReader::Pointer reader = MRCReader::New(true);
+  if(reader->readHeader(m_InputFile, &header) < 0)
+  {
+    return MemoryPlanner::NullPointer();
+  }
 
-  TotalMem /= (1e9); //To get answer in Gb
+  // The full resolution inputs, set up the same way the resolutions are
+  TomoInputsPtr inputs = TomoInputsPtr(new TomoInputs);
+  BFReconstructionEngine::InitializeTomoInputs(inputs);
+  inputs->extendObject = getExtendObject();
+  inputs->interpolateFactor = powf((float)2, (float)getNumberResolutions() - 1) * m_FinalResolution;
+  inputs->LengthZ = m_SampleThickness;
+  inputs->NumSIRTIter = getSIRTIterations();
+  inputs->snapshotPolicy = m_SnapshotPolicy;
+  inputs->tilts = m_Tilts;
+  if(m_Subvolume.size() > 0)
+  {
+    inputs->useSubvolume = true;
+    inputs->xStart = m_Subvolume[0];
+    inputs->xEnd = m_Subvolume[3];
+    inputs->yStart = m_Subvolume[1];
+    inputs->yEnd = m_Subvolume[4];
+    inputs->zStart = m_Subvolume[2];
+    inputs->zEnd = m_Subvolume[5];
+  }
+  inputs->excludedViews = m_ViewMasks;
 
-  std::cout << "Total Max Mem needed = " << TotalMem << " Gb" << std::endl;
+  SinogramPtr sinogram = SinogramPtr(new Sinogram);
+  BFReconstructionEngine::InitializeSinogram(sinogram);
+  sinogram->delta_r = getDefaultPixelSize();
+  sinogram->delta_t = getDefaultPixelSize();
 
+  int voxelMin[3] = {0, 0, 0};
+  int voxelMax[3] = {0, 0, 0};
+  std::stringstream ss;
+  MRCSinogramInitializer::ResolveRegion(header, inputs, sinogram, voxelMin, voxelMax, ss);
+  if(NULL != header.feiHeaders)
+  {
+    free(header.feiHeaders);
+  }
+  if(inputs->tilts.size() < sinogram->N_theta)
+  {
+    return MemoryPlanner::NullPointer();
+  }
+  sinogram->angles.assign(inputs->tilts.begin(), inputs->tilts.begin() + sinogram->N_theta);
+
+  MemoryPlanner::Pointer planner = MemoryPlanner::New();
+  planner->setTomoInputs(inputs);
+  planner->setSinogram(sinogram);
+  planner->setAdvParams(m_AdvParams);
+  planner->setModality(MemoryPlanner::BrightField);
+  planner->setNumberResolutions(m_NumberResolutions);
+  planner->setFinalResolution(m_FinalResolution);
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  tbb::task_scheduler_init init;
+  planner->setNumThreads(init.default_num_threads());
+#else
+  planner->setNumThreads(1);
+#endif
+  planner->setBinDetector(true);
+  planner->setImplicitWeights(m_ImplicitWeights);
+  planner->setMemoryBudget(m_MemoryBudget);
+  planner->setYSlabs((NULL != m_Transport.get() && m_Transport->getSize() > 1) ? m_Transport->getSize() : m_YSlabs);
+  planner->execute();
+  if(planner->getErrorCondition() < 0)
+  {
+    return MemoryPlanner::NullPointer();
+  }
+  return planner;
 }
@@ -41,8 +41,10 @@
 
 #include "MBIRLib/MBIRLib.h"
 #include "MBIRLib/Common/FilterPipeline.h"
+#include "MBIRLib/Common/SlabTransport.h"
 #include "MBIRLib/Reconstruction/ReconstructionStructures.h"
 #include "MBIRLib/BrightField/BFReconstructionEngine.h"
+#include "MBIRLib/GenericFilters/MemoryPlanner.h"
 
 /**
  * @brief This class controls the multiresolution reconstruction of an input
@@ -71,6 +73,19 @@ class BFMultiResolutionReconstruction : public FilterPipeline
     MXA_INSTANCE_STRING_PROPERTY(BrightFieldFile)
     MXA_INSTANCE_STRING_PROPERTY(InitialReconstructionFile)
     MXA_INSTANCE_PROPERTY(bool, DeleteTempFiles)
+    /* Write the volume and nuisance parameters of every resolution to the temp
+     * directory. They are handed to the next resolution in memory either way. */
+    MXA_INSTANCE_PROPERTY(bool, WriteIntermediateFiles)
+    /* Which intermediate volumes are written for display (see MBIR::SnapshotPolicy)
+     * and the iterations or seconds between them */
+    MXA_INSTANCE_PROPERTY(unsigned int, SnapshotPolicy)
+    MXA_INSTANCE_PROPERTY(Real_t, SnapshotInterval)
+    /* Seconds between checkpoints of the reconstruction state. 0 only writes
+     * one when the reconstruction is cancelled, < 0 disables them */
+    MXA_INSTANCE_PROPERTY(Real_t, CheckpointInterval)
+    /* Checkpoint to restart the reconstruction from. The resolutions before
+     * the one it was taken at are skipped */
+    MXA_INSTANCE_STRING_PROPERTY(ResumeFile)
 
     MXA_INSTANCE_PROPERTY(int, NumberResolutions)
     MXA_INSTANCE_PROPERTY(float, SampleThickness)
@@ -87,6 +102,7 @@ class BFMultiResolutionReconstruction : public FilterPipeline
     MXA_INSTANCE_PROPERTY(bool, InterpolateInitialReconstruction)
     MXA_INSTANCE_PROPERTY(float, DefaultVariance)
     MXA_INSTANCE_PROPERTY(float, InitialReconstructionValue)
+    MXA_INSTANCE_PROPERTY(int, SIRTIterations)
     MXA_INSTANCE_PROPERTY(Real_t, DefaultPixelSize)
 
     MXA_INSTANCE_PROPERTY(std::vector<float>, Tilts)
@@ -106,6 +122,28 @@ class BFMultiResolutionReconstruction : public FilterPipeline
     MXA_INSTANCE_PROPERTY(float, BraggDelta)
     MXA_INSTANCE_PROPERTY(float, BfOffset)
 
+    /* Recompute the measurement weights from the counts instead of storing them */
+    MXA_INSTANCE_PROPERTY(bool, ImplicitWeights)
+
+    /* Bytes the reconstruction may use. 0 does not limit it */
+    MXA_INSTANCE_PROPERTY(uint64_t, MemoryBudget)
+
+    /* Number of slabs the detector rows are reconstructed in one after the
+     * other. Only one slab is in memory at a time. 0 lets the memory planner
+     * pick the fewest that fit the MemoryBudget */
+    MXA_INSTANCE_PROPERTY(int, YSlabs)
+
+    /* Connects the workers of a distributed reconstruction. With more than one
+     * rank the rows are split into one Y slab per worker and this process only
+     * reconstructs the slab of its rank. The engine swaps the rows of the halos
+     * with the neighbouring workers after every iteration and the nuisance
+     * parameters are estimated from the sums over all workers. */
+    MXA_INSTANCE_PROPERTY(SlabTransport::Pointer, Transport)
+
+    /* JSON file the memory used by every resolution is written to at the end.
+     * Each worker of a distributed reconstruction appends its rank. */
+    MXA_INSTANCE_STRING_PROPERTY(MemoryReportFile)
+
     /**
      * @brief
      */
@@ -120,11 +158,16 @@ class BFMultiResolutionReconstruction : public FilterPipeline
     void printInputs(TomoInputsPtr inputs, std::ostream& out);
 
     /**
-     * @brief Trys to estimate the amount of memory that will be used.
-     * @param inputs
-     * @param bf_inputs
+     * @brief Predicts the memory every resolution will use from the header of
+     * the input file alone and picks the settings that fit the MemoryBudget.
+     * @return The executed planner or a NullPointer if the input file can not be planned
      */
-    void memCalculate(TomoInputsPtr inputs);
+    MemoryPlanner::Pointer planMemory();
+
+    /**
+     * @brief Sends the memory held by every named array right now to the observers
+     */
+    void reportMemory();
 
   protected:
     BFMultiResolutionReconstruction();
@@ -135,6 +178,61 @@ class BFMultiResolutionReconstruction : public FilterPipeline
      */
     std::vector<std::string> setupTempFiles(TomoInputsPtr inputs);
 
+    /**
+     * @brief Writes the MemoryReportFile if one was asked for
+     */
+    void writeMemoryReport();
+
+    /**
+     * @brief Runs every resolution over one region of the input file.
+     * @param subvolume The region as in Subvolume, empty for the whole file
+     * @param tempDir Directory the temp files of the resolutions go under
+     * @param resumeResolution Resolutions before this one are skipped
+     * @param slab The rows of a Y slab the region covers or NULL. The output
+     * then only gets the core rows at their place among regionRows rows.
+     * @param sharedNuisance If set, the gains, offsets and variances of this
+     * forward model are used at every resolution instead of being estimated
+     * @param nuisanceEstimate If not NULL only the coarsest resolution is run,
+     * nothing is written to the output files and its forward model is returned here
+     * @return Negative on error
+     */
+    int reconstructRegion(const std::vector<uint16_t>& subvolume, const std::string& tempDir,
+                          int resumeResolution, const YSlab* slab, uint16_t regionRows,
+                          BFForwardModel::Pointer sharedNuisance, BFForwardModel::Pointer* nuisanceEstimate,
+                          std::vector<std::string>& tempFiles);
+
+    /**
+     * @brief Slabs that are reconstructed one after the other can not share
+     * their estimates while they iterate. The coarsest resolution of every slab
+     * is run first and the mean of their gains, offsets and variances,
+     * weighted by the rows of the slabs, is what all of them then use.
+     * @param shared Receives a forward model that holds the shared parameters
+     * @return Negative on error
+     */
+    int estimateSlabNuisanceParameters(TomoInputsPtr region, const std::vector<YSlab>& layout,
+                                       std::vector<std::string>& tempFiles, BFForwardModel::Pointer& shared);
+
+    /**
+     * @brief Lets the engine of every worker write its rows of the output files
+     * in the order of the ranks
+     * @return Negative on error
+     */
+    int writeSlabInTurn(BFReconstructionEngine::Pointer engine);
+
+    /**
+     * @brief Reads and log transforms the full resolution sinogram that the
+     * sinograms of every resolution are made from
+     * @return Negative on error
+     */
+    int readFullSinogram(TomoInputsPtr inputs, SinogramPtr sinogram, Real_t bfOffset);
+
+    /**
+     * @brief The number of detector pixels binned along r and along t for a
+     * resolution. This is the largest power of two that divides N_r and N_t and
+     * does not exceed the voxel size of the resolution in detector pixels.
+     */
+    unsigned int detectorBinning(SinogramPtr sinogram, int resolution);
+
   private:
     bool                 m_Cancel;
     BFReconstructionEngine::Pointer   m_CurrentEngine;
@@ -66,6 +66,8 @@
 #include "MBIRLib/IOFilters/MRCReader.h"
 #include "MBIRLib/IOFilters/MRCWriter.h"
 #include "MBIRLib/IOFilters/RawGeometryWriter.h"
+#include "MBIRLib/IOFilters/ReconstructionCheckpoint.h"
+#include "MBIRLib/IOFilters/ReconstructionSnapshotWriter.h"
 
 #include "MBIRLib/IOFilters/VTKFileWriters.hpp"
 #include "MBIRLib/IOFilters/AvizoUniformCoordinateWriter.h"
@@ -77,6 +79,7 @@
 #include "MBIRLib/GenericFilters/RawSinogramInitializer.h"
 #include "MBIRLib/GenericFilters/InitialReconstructionInitializer.h"
 #include "MBIRLib/GenericFilters/InitialReconstructionBinReader.h"
+#include "MBIRLib/GenericFilters/BackProjectionInitializer.h"
 
 
 
@@ -212,6 +215,17 @@ void BFReconstructionEngine::InitializeTomoInputs(TomoInputsPtr v)
   v->interpolateFactor = 0.0;
   v->reconstructedOutputFile = "";
   v->tempDir = "";
+  v->snapshotPolicy = MBIR::SnapshotPolicy::EveryIteration;
+  v->snapshotInterval = 1;
+  v->checkpointInterval = -1;
+  v->checkpointFile = "";
+  v->resumeFile = "";
+  v->resolution = 0;
+  v->slabHaloStart = 0;
+  v->slabHaloEnd = 0;
+  v->slabOutputY = 0;
+  v->slabOutputNy = 0;
+  v->fixedNuisanceParameters = false;
   v->NumIter = 0;
   v->NumOuterIter = 0;
   v->SigmaX = 0.0;
@@ -233,6 +247,7 @@ void BFReconstructionEngine::InitializeTomoInputs(TomoInputsPtr v)
   v->tilts.resize(0);
   v->verbose = true;
   v->veryVerbose = true;
+  v->NumSIRTIter = 0;
 }
 
 // -----------------------------------------------------------------------------
@@ -246,6 +261,7 @@ void BFReconstructionEngine::InitializeSinogram(SinogramPtr v)
   v->delta_r = 0.0;
   v->delta_t = 0.0;
   v->counts = RealVolumeType::NullPointer();
+  v->weights = RealVolumeType::NullPointer();
   v->R0 = 0.0;
   v->RMax = 0.0;
   v->T0 = 0.0;
@@ -286,6 +302,11 @@ void BFReconstructionEngine::InitializeAdvancedParams(AdvancedParametersPtr v)
   v->JOINT_ESTIMATION = 1;
   v->ZERO_SKIPPING = 1;
   v->NOISE_ESTIMATION = 1;
+#ifdef COST_CALCULATE
+  v->TRACK_COST = 1;
+#else
+  v->TRACK_COST = 0;
+#endif
 }
 
 
@@ -314,7 +335,6 @@ void BFReconstructionEngine::execute()
   RealVolumeType::Pointer h_t;
 
   RealVolumeType::Pointer y_Est; //Estimated Sinogram
-  RealVolumeType::Pointer finalSinogram; //To store and write the final sinogram resulting from our reconstruction
   RealVolumeType::Pointer errorSino; //Error Sinogram
 
   std::string indent("");
@@ -326,6 +346,11 @@ void BFReconstructionEngine::execute()
   CostData::Pointer cost = CostData::New();
   cost->initOutputFile(filepath);
   //#endif
+#ifdef COST_CALCULATE
+  cost->setResyncInterval(1); //Exact cost after every pass while debugging
+#else
+  cost->setResyncInterval(MBIR::Constants::k_CostResyncInterval);
+#endif
 
 #if OpenMBIR_USE_PARALLEL_ALGORITHMS
   tbb::task_scheduler_init init;
@@ -412,11 +437,21 @@ void BFReconstructionEngine::execute()
   dims[1] = m_Sinogram->N_r;
   dims[2] = m_Sinogram->N_t;
 
-  y_Est = RealVolumeType::New(dims, "y_Est");//y_Est = A*x_{initial}
-  errorSino = RealVolumeType::New(dims, "ErrorSino");// y - y_est
-  m_ForwardModel->weightInitialization(dims); //Initialize the \lambda matrix
-
-  finalSinogram = RealVolumeType::New(dims, "Final Sinogram"); //Debug variable to store the final A*x_{Final}
+  // The sinogram sized buffers come from the pool so a buffer another
+  // resolution is done with is reused instead of allocated again
+  if(NULL == m_BufferPool.get())
+  {
+    m_BufferPool = SinogramBufferPool::New();
+  }
+  y_Est = m_BufferPool->acquire(dims, "y_Est");//y_Est = A*x_{initial}
+  errorSino = m_BufferPool->acquire(dims, "ErrorSino");// y - y_est
+  if(NULL == y_Est.get() || NULL == errorSino.get())
+  {
+    setErrorCondition(-1);
+    notify("Error allocating the estimated and error sinograms", 100, Observable::UpdateErrorMessage);
+    return;
+  }
+  m_ForwardModel->weightInitialization(m_Sinogram, dims); //Initialize the \lambda matrix
 
   /*************** Computation of partial Amatrix *************/
 
@@ -542,6 +577,50 @@ void BFReconstructionEngine::execute()
 
   //Gain and Offset Parameters Initialization of the forward model
   m_ForwardModel->gainAndOffsetInitialization(m_Sinogram->N_theta);
+  // Each slab computed its initial offsets from its own rows
+  if(m_ForwardModel->shareGainsAndOffsets(m_Sinogram->N_theta, m_Geometry->N_y - m_TomoInputs->slabHaloStart - m_TomoInputs->slabHaloEnd) < 0)
+  {
+    setErrorCondition(m_ForwardModel->getErrorCondition());
+    return;
+  }
+
+  // A resumed reconstruction restores the volume, the error sinogram and
+  // the weights from its checkpoint further down
+  bool resume = (m_TomoInputs->resumeFile.empty() == false);
+
+  // Replace the constant starting volume with a few iterations of SIRT. y_Est and
+  // errorSino are only used as scratch space here; both are recomputed below.
+  if(resume == false && m_TomoInputs->initialReconFile.empty() == true && NULL == m_TomoInputs->initialRecon.get() && m_TomoInputs->NumSIRTIter > 0)
+  {
+    BackProjectionInitializer::Pointer bpInitializer = BackProjectionInitializer::New();
+    bpInitializer->setTomoInputs(m_TomoInputs);
+    bpInitializer->setSinogram(m_Sinogram);
+    bpInitializer->setGeometry(m_Geometry);
+    bpInitializer->setAdvParams(m_AdvParams);
+    bpInitializer->setTempCol(tempCol);
+    bpInitializer->setVoxelLineResponse(voxelLineResponse);
+    bpInitializer->setI_0(m_ForwardModel->getI_0());
+    bpInitializer->setMu(m_ForwardModel->getMu());
+    bpInitializer->setWorkSinogram(y_Est);
+    bpInitializer->setResidualSinogram(errorSino);
+    bpInitializer->setNumIterations(m_TomoInputs->NumSIRTIter);
+#ifdef POSITIVITY_CONSTRAINT
+    bpInitializer->setPositivityConstraint(true);
+#else
+    bpInitializer->setPositivityConstraint(false);
+#endif
+    bpInitializer->setObservers(getObservers());
+    bpInitializer->setVerbose(getVerbose());
+    bpInitializer->setVeryVerbose(getVeryVerbose());
+    bpInitializer->execute();
+    if(bpInitializer->getErrorCondition() == -999) { setErrorCondition(-999); return; }
+    if(bpInitializer->getErrorCondition() < 0)
+    {
+      setErrorCondition(bpInitializer->getErrorCondition());
+      notify("Error computing the SIRT initial reconstruction", 100, Observable::UpdateErrorMessage);
+      return;
+    }
+  }
 
   initializeVolume(y_Est, 0.0);
 
@@ -550,11 +629,18 @@ void BFReconstructionEngine::execute()
 
   //Forward Project Geometry->Object one slice at a time and compute the  Sinogram for each slice
   // Forward Project using the Forward Model
-  err = m_ForwardModel->forwardProject(m_Sinogram, m_Geometry, tempCol, voxelLineResponse, y_Est , errorSino);
-  if (err < 0)
+  if(resume == false)
   {
-    return;
+    err = m_ForwardModel->forwardProject(m_Sinogram, m_Geometry, tempCol, voxelLineResponse, y_Est , errorSino);
+    if (err < 0)
+    {
+      return;
+    }
   }
+  // y_Est is only needed to form the error sinogram. Giving it back and
+  // emptying the pool keeps a single sinogram sized buffer for the iterations.
+  m_BufferPool->release(y_Est);
+  m_BufferPool->clear();
   if (getCancel() == true) { setErrorCondition(-999); return; }
 
 
@@ -566,9 +652,11 @@ void BFReconstructionEngine::execute()
   QGGMRF::QGGMRF_Values QGGMRF_values;
   QGGMRF::initializePriorModel(m_TomoInputs, &QGGMRF_values, NULL);
 
-#ifdef COST_CALCULATE
-  err = calculateCost(cost, m_Sinogram, m_Geometry, errorSino, &QGGMRF_values);
-#endif //Cost calculation endif
+  //Initial exact cost that the incremental cost tracking starts from
+  if(resume == false && m_AdvParams->TRACK_COST)
+  {
+    err = calculateCost(cost, m_Sinogram, m_Geometry, errorSino, &QGGMRF_values);
+  }
 
   Real_t TempBraggValue, DesBraggValue;
 #ifdef BRAGG_CORRECTION
@@ -636,9 +724,72 @@ void BFReconstructionEngine::execute()
   uint32_t EffIterCount = 0; //Maintains number of calls to updatevoxelroutine
 
 
+  // The intermediate volumes for the GUI are written in the background
+  ReconstructionSnapshotWriter::Pointer snapshotWriter = ReconstructionSnapshotWriter::New();
+  snapshotWriter->setTomoInputs(m_TomoInputs);
+  snapshotWriter->setGeometry(m_Geometry);
+  snapshotWriter->setAdvParams(m_AdvParams);
+  snapshotWriter->setXDims(cropStart, cropEnd);
+  snapshotWriter->setObservers(getObservers());
+
+  // Everything the iterations below depend on is saved in the checkpoints. The
+  // random voxel order is seeded from the clock so the order itself is saved.
+  ReconstructionCheckpoint::Pointer checkpoint = ReconstructionCheckpoint::New();
+  checkpoint->setTomoInputs(m_TomoInputs);
+  checkpoint->setOutputFile(m_TomoInputs->checkpointFile);
+  checkpoint->setObservers(getObservers());
+  checkpoint->addVolume("Object", m_Geometry->Object);
+  checkpoint->addVolume("ErrorSinogram", errorSino);
+  if(NULL != m_ForwardModel->getWeight().get())
+  {
+    checkpoint->addVolume("Weight", m_ForwardModel->getWeight());
+  }
+  else
+  {
+    checkpoint->addArray("WeightScale", m_ForwardModel->getWeightScale());
+  }
+  checkpoint->addBitVolume("Selector", m_ForwardModel->getSelector());
+  checkpoint->addArray("I_0", m_ForwardModel->getI_0());
+  checkpoint->addArray("Mu", m_ForwardModel->getMu());
+  if(NULL != m_ForwardModel->getAlpha().get())
+  {
+    checkpoint->addArray("Alpha", m_ForwardModel->getAlpha());
+  }
+  checkpoint->addImage("MagUpdateMap", magUpdateMap);
+  checkpoint->addImage("FiltMagUpdateMap", filtMagUpdateMap);
+  checkpoint->addVoxelList("VoxelUpdateList", TempList);
+
+  int16_t startOuterIter = 0;
+  int16_t startInnerIter = 0;
+  if(resume == true)
+  {
+    if(checkpoint->restore(m_TomoInputs->resumeFile) < 0)
+    {
+      setErrorCondition(checkpoint->getErrorCondition());
+      return;
+    }
+    startOuterIter = static_cast<int16_t>(checkpoint->getCounter("OuterIteration"));
+    startInnerIter = static_cast<int16_t>(checkpoint->getCounter("InnerIteration"));
+    EffIterCount = static_cast<uint32_t>(checkpoint->getCounter("EffIterCount"));
+    listselector = static_cast<uint32_t>(checkpoint->getCounter("ListSelector"));
+    PrevMagSum = checkpoint->getCounter("PrevMagSum");
+    TempBraggValue = checkpoint->getCounter("TempBraggValue");
+    DesBraggValue = checkpoint->getCounter("DesBraggValue");
+    m_ForwardModel->setBraggThreshold(checkpoint->getCounter("BraggThreshold"));
+    status = 1; // Checkpoints are only taken while the reconstruction has not converged
+    // The tracked cost starts again from the restored error sinogram
+    if(m_AdvParams->TRACK_COST)
+    {
+      err = calculateCost(cost, m_Sinogram, m_Geometry, errorSino, &QGGMRF_values);
+    }
+    ss.str("");
+    ss << "Resuming at outer iteration " << startOuterIter << " inner iteration " << startInnerIter;
+    notify(ss.str(), 0, Observable::UpdateProgressMessage);
+  }
+
   //Loop through every voxel updating it by solving a cost function
 
-  for (int16_t reconOuterIter = 0; reconOuterIter < m_TomoInputs->NumOuterIter; reconOuterIter++)
+  for (int16_t reconOuterIter = startOuterIter; reconOuterIter < m_TomoInputs->NumOuterIter; reconOuterIter++)
   {
     ss.str(""); // Clear the string stream
     indent = "";
@@ -652,7 +803,8 @@ void BFReconstructionEngine::execute()
       m_ForwardModel->setBraggThreshold(TempBraggValue);
     }
 
-    for (int16_t reconInnerIter = 0; reconInnerIter < m_TomoInputs->NumIter; reconInnerIter++)
+    int16_t firstInnerIter = (reconOuterIter == startOuterIter) ? startInnerIter : 0;
+    for (int16_t reconInnerIter = firstInnerIter; reconInnerIter < m_TomoInputs->NumIter; reconInnerIter++)
     {
       // If at the inner most loops at the coarsest resolution donot apply Bragg
       // Only at the coarsest scale the NumIter > 1
@@ -780,15 +932,23 @@ void BFReconstructionEngine::execute()
 
       /* %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%% */
 
-      if(status == 0)
+      if(NULL != m_SlabTransport.get() && m_SlabTransport->getSize() > 1)
       {
-        break; //stop inner loop if we have hit the threshold value for x
+        int changed = synchronizeSlab(status, tempCol, errorSino, voxelLineResponse);
+        if(changed < 0)
+        {
+          return;
+        }
+        //The halo rows changed the error sinogram outside of the voxel updates
+        if(changed > 0 && m_AdvParams->TRACK_COST)
+        {
+          cost->resetTrackedCost(computeCost(m_Sinogram, m_Geometry, errorSino, &QGGMRF_values));
+        }
       }
-      // Check to see if we are canceled.
-      if (getCancel() == true)
+
+      if(status == 0)
       {
-        setErrorCondition(-999);
-        return;
+        break; //stop inner loop if we have hit the threshold value for x
       }
 
       // Write out the MRC File ; If NHICD only after half an equit do a write
@@ -796,24 +956,25 @@ void BFReconstructionEngine::execute()
       if(EffIterCount % (MBIR::Constants::k_NumNonHomogeniousIter) == 0)
 #endif //NHICD
       {
-        ss.str("");
-        ss << m_TomoInputs->tempDir << MXADir::getSeparator() << reconOuterIter << "_" << reconInnerIter << "_" << MBIR::Defaults::ReconstructedMrcFile;
-        writeMRCFile(ss.str(), cropStart, cropEnd);
-        notify(ss.str(), 0, Observable::UpdateIntermediateImage);
-        m_TomoInputs->tempFiles.push_back(ss.str());
+        snapshotWriter->snapshot(reconOuterIter, reconInnerIter);
       }
 
-#ifdef COST_CALCULATE //typically run only for debugging
       /*********************Cost Calculation*************************************/
-      int16_t err = calculateCost(cost, m_Sinogram, m_Geometry, errorSino, &QGGMRF_values);
-      if(err < 0)
+      if(m_AdvParams->TRACK_COST)
       {
-        std::cout << "Cost went up after voxel update" << std::endl;
-        return;
-        //      break;
+        int16_t err = checkTrackedCost(cost, m_Sinogram, m_Geometry, errorSino, &QGGMRF_values);
+        if(err < 0)
+        {
+#ifdef COST_CALCULATE //typically run only for debugging
+          std::cout << "Cost went up after voxel update" << std::endl;
+          return;
+          //      break;
+#else
+          notify("Cost went up after voxel update", 0, Observable::UpdateWarningMessage);
+#endif //Cost calculation endif
+        }
       }
       /**************************************************************************/
-#endif //Cost calculation endif
 
 #ifdef BRAGG_CORRECTION
       //If at the last iteration of the inner loops at coarsest resolution adjust parameters
@@ -827,6 +988,31 @@ void BFReconstructionEngine::execute()
 
 #endif //Bragg correction
 
+      // Checkpoints are taken between iterations so a resumed run starts with the next one
+      checkpoint->setCounter("Resolution", m_TomoInputs->resolution);
+      checkpoint->setCounter("OuterIteration", reconOuterIter);
+      checkpoint->setCounter("InnerIteration", reconInnerIter + 1);
+      checkpoint->setCounter("EffIterCount", EffIterCount);
+      checkpoint->setCounter("ListSelector", listselector);
+      checkpoint->setCounter("PrevMagSum", PrevMagSum);
+      checkpoint->setCounter("TempBraggValue", TempBraggValue);
+      checkpoint->setCounter("DesBraggValue", DesBraggValue);
+      checkpoint->setCounter("BraggThreshold", m_ForwardModel->getBraggThreshold());
+
+      // Check to see if we are canceled.
+      if (getCancel() == true)
+      {
+        // Keep what has been reconstructed so far so the run can be resumed
+        if(checkpoint->isEnabled() == true)
+        {
+          checkpoint->checkpoint();
+          checkpoint->finish();
+        }
+        setErrorCondition(-999);
+        return;
+      }
+      checkpoint->checkpointIfDue();
+
     } /* ++++++++++ END Inner Iteration Loop +++++++++++++++ */
 
 
@@ -842,9 +1028,14 @@ void BFReconstructionEngine::execute()
 
     if(m_TomoInputs->NumOuterIter > 1) //Dont update any parameters if we just have one outer iteration
     {
+      // Parameters estimated elsewhere are kept, the selector still follows the error sinogram
       if(m_AdvParams->JOINT_ESTIMATION)
       {
-        m_ForwardModel->jointEstimation(m_Sinogram, errorSino, y_Est, cost);
+        if(m_TomoInputs->fixedNuisanceParameters == false && m_ForwardModel->jointEstimation(m_Sinogram, errorSino, cost) < 0)
+        {
+          setErrorCondition(m_ForwardModel->getErrorCondition());
+          return;
+        }
         m_ForwardModel->updateSelector(m_Sinogram, errorSino);
 
 #ifdef COST_CALCULATE //Debug info
@@ -854,6 +1045,12 @@ void BFReconstructionEngine::execute()
           std::cout << "Cost went up after offset update" << std::endl;
           break;
         }
+#else
+        //The new gains and offsets change the cost so the tracking restarts from the exact value
+        if(m_AdvParams->TRACK_COST)
+        {
+          calculateCost(cost, m_Sinogram, m_Geometry, errorSino, &QGGMRF_values);
+        }
 #endif//cost
 
       }  //Joint estimation endif
@@ -861,7 +1058,11 @@ void BFReconstructionEngine::execute()
 
       if(m_AdvParams->NOISE_ESTIMATION)
       {
-        m_ForwardModel->updateWeights(m_Sinogram, errorSino);
+        if(m_TomoInputs->fixedNuisanceParameters == false && m_ForwardModel->updateWeights(m_Sinogram, errorSino) < 0)
+        {
+          setErrorCondition(m_ForwardModel->getErrorCondition());
+          return;
+        }
         m_ForwardModel->updateSelector(m_Sinogram, errorSino);
 #ifdef COST_CALCULATE
         //err = calculateCost(cost, Weight, errorSino);
@@ -873,6 +1074,12 @@ void BFReconstructionEngine::execute()
           return;
           //break;
         }
+#else
+        //The new weights change the cost so the tracking restarts from the exact value
+        if(m_AdvParams->TRACK_COST)
+        {
+          calculateCost(cost, m_Sinogram, m_Geometry, errorSino, &QGGMRF_values);
+        }
 #endif//cost
 
       }
@@ -882,6 +1089,11 @@ void BFReconstructionEngine::execute()
     }
 
   }/* ++++++++++ END Outer Iteration Loop +++++++++++++++ */
+  snapshotWriter->finish();
+  checkpoint->finish();
+  // The checkpoint holds on to the error sinogram, let it go so the buffer
+  // can be given back to the pool below
+  checkpoint = ReconstructionCheckpoint::NullPointer();
 
   indent = "";
 #if DEBUG_COSTS
@@ -904,7 +1116,11 @@ void BFReconstructionEngine::execute()
   m_ForwardModel->writeNuisanceParameters(m_Sinogram);
 
 
-  //Compute final value of Ax_{final}
+  //Debug : Writing out the selector array as an MRC file
+  m_ForwardModel->writeSelectorMrc(m_TomoInputs->braggSelectorFile, m_Sinogram, m_Geometry, errorSino);
+
+  //Compute final value of Ax_{final}. The error sinogram is not needed any
+  //more so the final sinogram is formed in its place.
   Real_t temp_final = 0.0;
   for (uint16_t i_theta = 0; i_theta < m_Sinogram->N_theta; i_theta++)
   {
@@ -913,41 +1129,25 @@ void BFReconstructionEngine::execute()
       for (uint16_t i_t = 0; i_t < m_Sinogram->N_t; i_t++)
       {
         temp_final = m_Sinogram->counts->getValue(i_theta, i_r, i_t) - errorSino->getValue(i_theta, i_r, i_t);
-        finalSinogram->setValue(temp_final, i_theta, i_r, i_t);
+        errorSino->setValue(temp_final, i_theta, i_r, i_t);
       }
     }
   }
 
   // This is writing the "ReconstructedSinogram.bin" file
-  m_ForwardModel->writeSinogramFile(m_Sinogram, finalSinogram); // Writes the sinogram to a file
+  m_ForwardModel->writeSinogramFile(m_Sinogram, errorSino); // Writes the sinogram to a file
+  m_BufferPool->release(errorSino);
 
   if (getCancel() == true) { setErrorCondition(-999); return; }
 
-  // Writes ReconstructedObject.bin file for next resolution
-  {
-    std::stringstream ss;
-    ss << m_TomoInputs->tempDir << MXADir::getSeparator() << MBIR::Defaults::ReconstructedObjectFile;
-    writeReconstructionFile(ss.str());
-  }
-  // Write out the VTK file
-  if (m_TomoInputs->vtkOutputFile.empty() == false)
+  // Writes ReconstructedObject.bin file. The multi resolution driver hands the
+  // volume to the next resolution in memory so this is only a debug output.
+  if (m_TomoInputs->reconstructedOutputFile.empty() == false)
   {
-    writeVtkFile(m_TomoInputs->vtkOutputFile, cropStart, cropEnd);
+    writeReconstructionFile(m_TomoInputs->reconstructedOutputFile);
   }
-  // Write out the MRC File
-  if (m_TomoInputs->mrcOutputFile.empty() == false)
-  {
-    writeMRCFile(m_TomoInputs->mrcOutputFile, cropStart, cropEnd);
-  }
-
-  //Write out avizo fire file
-  if (m_TomoInputs->avizoOutputFile.empty() == false)
-  {
-    writeAvizoFile(m_TomoInputs->avizoOutputFile, cropStart, cropEnd);
-  }
-
-  //Debug : Writing out the selector array as an MRC file
-  m_ForwardModel->writeSelectorMrc(m_TomoInputs->braggSelectorFile, m_Sinogram, m_Geometry, errorSino);
+  // Write out the VTK, MRC and Avizo files from one pass over the volume
+  writeVolumeFiles(cropStart, cropEnd);
   if (getVerbose())
   {
     std::cout << "Final Dimensions of Object: " << std::endl;
@@ -1073,6 +1273,7 @@ int BFReconstructionEngine::calculateCost(CostData::Pointer cost,
 {
   Real_t cost_value = computeCost(sinogram, geometry, ErrorSino, QGGMRF_Values);
   //std::cout << "cost_value: " << cost_value << std::endl;
+  cost->resetTrackedCost(cost_value);
   int increase = cost->addCostValue(cost_value);
   if(increase == 1)
   {
@@ -1082,6 +1283,125 @@ int BFReconstructionEngine::calculateCost(CostData::Pointer cost,
   return 0;
 }
 
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int BFReconstructionEngine::synchronizeSlab(uint8_t& status,
+                                            std::vector<AMatrixCol::Pointer>& TempCol,
+                                            RealVolumeType::Pointer ErrorSino,
+                                            std::vector<AMatrixCol::Pointer>& VoxelLineResponse)
+{
+  int rank = m_SlabTransport->getRank();
+  uint16_t haloStart = m_TomoInputs->slabHaloStart;
+  uint16_t haloEnd = m_TomoInputs->slabHaloEnd;
+  int err = 0;
+  int changed = 0;
+
+  // The halo rows take what the neighbour reconstructed for the same rows of its core
+  if(haloStart > 0)
+  {
+    err = exchangeRows(rank - 1, haloStart, 0, haloStart, TempCol, ErrorSino, VoxelLineResponse);
+    changed += (err > 0) ? err : 0;
+  }
+  if(err >= 0 && haloEnd > 0)
+  {
+    err = exchangeRows(rank + 1, m_Geometry->N_y - 2 * haloEnd, m_Geometry->N_y - haloEnd, haloEnd,
+                       TempCol, ErrorSino, VoxelLineResponse);
+    changed += (err > 0) ? err : 0;
+  }
+
+  // Every worker has to run the same number of iterations
+  std::vector<Real_t> notConverged(1, (status == 0) ? 0.0 : 1.0);
+  if(err >= 0)
+  {
+    err = m_SlabTransport->allReduceSum(notConverged);
+  }
+  if(err < 0)
+  {
+    std::stringstream ss;
+    ss << "Could not synchronize the slab with the other workers: " << m_SlabTransport->getErrorMessage();
+    setErrorCondition(-1);
+    notify(ss.str(), 0, Observable::UpdateErrorMessage);
+    return -1;
+  }
+  status = (notConverged[0] > 0.0) ? 1 : 0;
+  return changed;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int BFReconstructionEngine::exchangeRows(int peer, uint16_t sendStart, uint16_t receiveStart, uint16_t rows,
+                                         std::vector<AMatrixCol::Pointer>& TempCol,
+                                         RealVolumeType::Pointer ErrorSino,
+                                         std::vector<AMatrixCol::Pointer>& VoxelLineResponse)
+{
+  RealVolumeType::Pointer object = m_Geometry->Object;
+  std::vector<Real_t> sendRows(static_cast<size_t>(m_Geometry->N_z) * m_Geometry->N_x * rows);
+  std::vector<Real_t> receiveRows(sendRows.size());
+  size_t i = 0;
+  for (uint16_t z = 0; z < m_Geometry->N_z; ++z)
+  {
+    for (uint16_t x = 0; x < m_Geometry->N_x; ++x)
+    {
+      for (uint16_t y = 0; y < rows; ++y)
+      {
+        sendRows[i++] = object->getValue(z, x, sendStart + y);
+      }
+    }
+  }
+  int err = m_SlabTransport->sendReceive(peer, &(sendRows.front()), &(receiveRows.front()), sendRows.size() * sizeof(Real_t));
+  if(err < 0)
+  {
+    return err;
+  }
+  int changed = 0;
+  i = 0;
+  for (uint16_t z = 0; z < m_Geometry->N_z; ++z)
+  {
+    for (uint16_t x = 0; x < m_Geometry->N_x; ++x)
+    {
+      for (uint16_t y = 0; y < rows; ++y)
+      {
+        Real_t value = receiveRows[i++];
+        Real_t change = value - object->getValue(z, x, receiveStart + y);
+        if(change != 0.0)
+        {
+          object->setValue(value, z, x, receiveStart + y);
+          m_ForwardModel->updateErrorSinogram(change, z * m_Geometry->N_x + x, TempCol, receiveStart + y,
+                                              VoxelLineResponse, ErrorSino, m_Sinogram);
+          ++changed;
+        }
+      }
+    }
+  }
+  return changed;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int BFReconstructionEngine::checkTrackedCost(CostData::Pointer cost,
+                                             SinogramPtr sinogram,
+                                             GeometryPtr geometry,
+                                             RealVolumeType::Pointer ErrorSino,
+                                             QGGMRF::QGGMRF_Values* QGGMRF_Values)
+{
+  //An apparent increase may only be accumulated drift so confirm it exactly
+  if(cost->needsExactCost() || cost->getTrackedCost() > cost->getLastCostValue())
+  {
+    if(getVeryVerbose())
+    {
+      std::cout << "Tracked cost: " << cost->getTrackedCost() << std::endl;
+    }
+    return calculateCost(cost, sinogram, geometry, ErrorSino, QGGMRF_Values);
+  }
+  Real_t cost_value = cost->getTrackedCost();
+  cost->addCostValue(cost_value);
+  cost->writeCostValue(cost_value);
+  return 0;
+}
+
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
@@ -57,6 +57,8 @@
 
 #include "MBIRLib/BrightField/BFForwardModel.h"
 #include "MBIRLib/Common/AMatrixCol.h"
+#include "MBIRLib/Common/SinogramBufferPool.h"
+#include "MBIRLib/Common/SlabTransport.h"
 
 #include "MBIRLib/Common/EIMTime.h"
 #define START_TIMER uint64_t startm = EIMTOMO_getMilliSeconds();
@@ -85,6 +87,12 @@ class MBIRLib_EXPORT BFReconstructionEngine : public AbstractFilter
     MXA_INSTANCE_PROPERTY(AdvancedParametersPtr, AdvParams)
 
     MXA_INSTANCE_PROPERTY(BFForwardModel::Pointer, ForwardModel)
+    MXA_INSTANCE_PROPERTY(SinogramBufferPool::Pointer, BufferPool)
+
+    /* Set when the reconstruction is one Y slab of a distributed reconstruction.
+     * After every pass of voxel updates the halo rows are swapped with the
+     * neighbouring slabs and the workers only stop once all of them have converged. */
+    MXA_INSTANCE_PROPERTY(SlabTransport::Pointer, SlabTransport)
 
     static void InitializeTomoInputs(TomoInputsPtr);
     static void InitializeSinogram(SinogramPtr);
@@ -100,6 +108,13 @@ class MBIRLib_EXPORT BFReconstructionEngine : public AbstractFilter
      */
     void execute();
 
+    /**
+     * @brief Writes the VTK, MRC and Avizo files named in the inputs from the
+     * reconstructed volume. execute() already does this for the files named
+     * when it runs.
+     */
+    void writeOutputFiles();
+
     Real_t absMaxArray(std::vector<Real_t>& Array);
 
 
@@ -120,6 +135,18 @@ class MBIRLib_EXPORT BFReconstructionEngine : public AbstractFilter
                        RealVolumeType::Pointer errorSinogram,
                        QGGMRF::QGGMRF_Values* QGGMRF_Values);
 
+    /**
+     * @brief Records the incrementally tracked cost after a pass of voxel updates.
+     * The exact cost is only computed when the tracking needs to be resynchronized
+     * or to confirm an apparent increase in the cost.
+     * @return -1 if the cost increased, 0 otherwise
+     */
+    int checkTrackedCost(CostData::Pointer cost,
+                         SinogramPtr sinogram,
+                         GeometryPtr geometry,
+                         RealVolumeType::Pointer ErrorSino,
+                         QGGMRF::QGGMRF_Values* QGGMRF_Values);
+
     //Updating voxels
     uint8_t updateVoxels(
       int16_t OuterIter,
@@ -136,6 +163,28 @@ class MBIRLib_EXPORT BFReconstructionEngine : public AbstractFilter
       Real_t PrevMagSum,
       uint32_t EffIterCount);
 
+    /**
+     * @brief Brings the halo rows of a distributed reconstruction up to date
+     * with what the neighbouring slabs reconstructed for them, updating the
+     * error sinogram along with them, and replaces status with 0 only if every
+     * worker has converged.
+     * @return The number of halo voxels that changed or negative on Error.
+     */
+    int synchronizeSlab(uint8_t& status,
+                        std::vector<AMatrixCol::Pointer>& TempCol,
+                        RealVolumeType::Pointer ErrorSino,
+                        std::vector<AMatrixCol::Pointer>& VoxelLineResponse);
+
+    /**
+     * @brief Sends rows of the object to a peer and puts the same number of its
+     * rows in place of others
+     * @return The number of voxels that changed or negative on Error.
+     */
+    int exchangeRows(int peer, uint16_t sendStart, uint16_t receiveStart, uint16_t rows,
+                     std::vector<AMatrixCol::Pointer>& TempCol,
+                     RealVolumeType::Pointer ErrorSino,
+                     std::vector<AMatrixCol::Pointer>& VoxelLineResponse);
+
     void initializeROIMask(UInt8Image_t::Pointer Mask);
 
 
@@ -217,28 +266,12 @@ class MBIRLib_EXPORT BFReconstructionEngine : public AbstractFilter
     void writeReconstructionFile(const std::string& filepath);
 
     /**
-     * @brief
-     * @param vtkFile
-     * @param cropStart
-     * @param cropEnd
-     */
-    void writeVtkFile(const std::string& vtkFile, uint16_t cropStart, uint16_t cropEnd);
-
-    /**
-     * @brief
-     * @param mrcFile
-     * @param cropStart
-     * @param cropEnd
-     */
-    void writeMRCFile(const std::string& mrcFile, uint16_t cropStart, uint16_t cropEnd);
-
-    /**
-     * @brief
-     * @param file
+     * @brief Writes the VTK, MRC and Avizo files that were asked for in the
+     * inputs from a single conversion of the cropped volume.
      * @param cropStart
      * @param cropEnd
      */
-    void writeAvizoFile(const std::string& file, uint16_t cropStart, uint16_t cropEnd);
+    void writeVolumeFiles(uint16_t cropStart, uint16_t cropEnd);
 
 
     uint32_t Partition(RealArrayType::Pointer A, uint32_t p, uint32_t r);
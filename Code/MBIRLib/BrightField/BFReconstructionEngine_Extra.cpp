@@ -54,9 +54,9 @@
 #include "MBIRLib/GenericFilters/RawSinogramInitializer.h"
 #include "MBIRLib/GenericFilters/InitialReconstructionInitializer.h"
 #include "MBIRLib/GenericFilters/InitialReconstructionBinReader.h"
+#include "MBIRLib/GenericFilters/InitialReconstructionUpsampler.h"
 #include "MBIRLib/IOFilters/RawGeometryWriter.h"
-#include "MBIRLib/IOFilters/VTKFileWriters.hpp"
-#include "MBIRLib/IOFilters/AvizoUniformCoordinateWriter.h"
+#include "MBIRLib/IOFilters/VolumeExporter.h"
 
 
 #define START_TIMER uint64_t startm = EIMTOMO_getMilliSeconds();
@@ -69,6 +69,13 @@
 // -----------------------------------------------------------------------------
 int BFReconstructionEngine::readInputData()
 {
+  // The multi resolution driver passes in the sinogram it read (and binned)
+  // for this resolution. The counts are already log transformed.
+  if (NULL != m_Sinogram->counts.get())
+  {
+    return 0;
+  }
+
   TomoFilter::Pointer dataReader = TomoFilter::NullPointer();
   std::string extension = MXAFileInfo::extension(m_TomoInputs->sinoFile);
 
@@ -82,7 +89,13 @@ int BFReconstructionEngine::readInputData()
     // We are going to assume that the user has selected a valid MRC file to get this far so we are just going to try
     // to read the file as an MRC file which may really cause issues but there does not seem to be any standard file
     // extensions for MRC files.
-    dataReader = MRCSinogramInitializer::NewTomoFilter();
+    MRCSinogramInitializer::Pointer mrcReader = MRCSinogramInitializer::New();
+    // The offset is known up front so the log transform is applied while the
+    // tilts are read instead of in a separate pass over the counts.
+    mrcReader->setLogTransform(true);
+    mrcReader->setLogOffset(m_ForwardModel->getBfOffset());
+    mrcReader->setLogNormalization(BF_MAX);
+    dataReader = mrcReader;
   }
 
   //  {
@@ -117,7 +130,12 @@ int BFReconstructionEngine::initializeRoughReconstructionData()
 {
   InitialReconstructionInitializer::Pointer geomInitializer = InitialReconstructionInitializer::NullPointer();
   std::string extension = MXAFileInfo::extension(m_TomoInputs->initialReconFile);
-  if (m_TomoInputs->initialReconFile.empty() == true)
+  if (NULL != m_TomoInputs->initialRecon.get())
+  {
+    // Upsample the volume of the previous resolution that is still in memory
+    geomInitializer = InitialReconstructionUpsampler::NewInitialReconstructionInitializer();
+  }
+  else if (m_TomoInputs->initialReconFile.empty() == true)
   {
     // This will just initialize all the values to Zero (0) or a DefaultValue Set by user
     geomInitializer = InitialReconstructionInitializer::New();
@@ -238,16 +256,7 @@ void BFReconstructionEngine::initializeHt(RealVolumeType::Pointer H_t, Real_t Of
 // -----------------------------------------------------------------------------
 void BFReconstructionEngine::initializeVolume(RealVolumeType::Pointer Y_Est, double value)
 {
-  for (uint16_t i = 0; i < m_Sinogram->N_theta; i++)
-  {
-    for (uint16_t j = 0; j < m_Sinogram->N_r; j++)
-    {
-      for (uint16_t k = 0; k < m_Sinogram->N_t; k++)
-      {
-        Y_Est->setValue(value, i, j, k);
-      }
-    }
-  }
+  Y_Est->fill(value);
 }
 
 // -----------------------------------------------------------------------------
@@ -364,109 +373,38 @@ void BFReconstructionEngine::writeReconstructionFile(const std::string& filepath
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
-void BFReconstructionEngine::writeVtkFile(const std::string& vtkFile, uint16_t cropStart, uint16_t cropEnd)
-{
-  std::stringstream ss;
-  ss << "Writing VTK file to '" << vtkFile << "'";
-  notify(ss.str(), 0, Observable::UpdateProgressMessage);
-
-  VTKStructuredPointsFileWriter vtkWriter;
-  vtkWriter.setWriteBinaryFiles(true);
-
-
-  DimsAndRes dimsAndRes;
-  dimsAndRes.xStart = cropStart;
-  dimsAndRes.xEnd = cropEnd;
-  dimsAndRes.yStart = 0;
-  dimsAndRes.yEnd = m_Geometry->N_y;
-  dimsAndRes.zStart = 0;
-  dimsAndRes.zEnd = m_Geometry->N_z;
-  dimsAndRes.resx = 1.0f;
-  dimsAndRes.resy = 1.0f;
-  dimsAndRes.resz = 1.0f;
-
-  std::vector<VtkScalarWriter*> scalarsToWrite;
-
-  VtkScalarWriter* w0 = static_cast<VtkScalarWriter*>(new TomoOutputScalarWriter(m_Geometry.get()));
-  w0->setXDims(cropStart, cropEnd);
-  w0->setYDims(0, m_Geometry->N_y);
-  w0->setZDims(0, m_Geometry->N_z);
-  w0->setWriteBinaryFiles(true);
-  scalarsToWrite.push_back(w0);
-
-  int error = vtkWriter.write<DimsAndRes>(vtkFile, &dimsAndRes, scalarsToWrite);
-  if(error < 0)
-  {
-    ss.str("");
-    ss << "Error writing vtk file\n    '" << vtkFile << "'" << std::endl;
-    setErrorCondition(-12);
-    notify(ss.str(), 0, Observable::UpdateErrorMessage);
-  }
-  delete w0;
-}
-
-// -----------------------------------------------------------------------------
-//
-// -----------------------------------------------------------------------------
-void BFReconstructionEngine::writeMRCFile(const std::string& mrcFile, uint16_t cropStart, uint16_t cropEnd)
+void BFReconstructionEngine::writeOutputFiles()
 {
-  /* Write the output to the MRC File */
-  std::stringstream ss;
-  ss.str("");
-  ss << "Writing MRC file to '" << mrcFile << "'";
-  notify(ss.str(), 0, Observable::UpdateProgressMessage);
-
-  MRCWriter::Pointer mrcWriter = MRCWriter::New();
-  mrcWriter->setOutputFile(mrcFile);
-  mrcWriter->setGeometry(m_Geometry);
-  mrcWriter->setAdvParams(m_AdvParams);
-  mrcWriter->setXDims(cropStart, cropEnd);
-  mrcWriter->setYDims(0, m_Geometry->N_y);
-  mrcWriter->setZDims(0, m_Geometry->N_z);
-  mrcWriter->setObservers(getObservers());
-  mrcWriter->execute();
-  if(mrcWriter->getErrorCondition() < 0)
-  {
-    ss.str("");
-    ss << "Error writing MRC file\n    '" << mrcFile << "'" << std::endl;
-    setErrorCondition(mrcWriter->getErrorCondition());
-    notify(ss.str(), 0, Observable::UpdateErrorMessage);
-  }
-
+  uint16_t cropStart = 0;
+  uint16_t cropEnd = m_Geometry->N_x;
+  computeOriginalXDims(cropStart, cropEnd);
+  writeVolumeFiles(cropStart, cropEnd);
 }
 
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
-void BFReconstructionEngine::writeAvizoFile(const std::string& file, uint16_t cropStart, uint16_t cropEnd)
+void BFReconstructionEngine::writeVolumeFiles(uint16_t cropStart, uint16_t cropEnd)
 {
-  //  std::cout << "Writing Avizo file " << file << std::endl;
-
-  /* Write the output to the Avizo File */
-  std::stringstream ss;
-  ss.str("");
-  ss << "Writing Avizo file to '" << file << "'";
-  notify(ss.str(), 0, Observable::UpdateProgressMessage);
-
-  AvizoUniformCoordinateWriter::Pointer writer = AvizoUniformCoordinateWriter::New();
-  writer->setOutputFile(file);
-  writer->setGeometry(m_Geometry);
-  writer->setAdvParams(m_AdvParams);
-  writer->setTomoInputs(m_TomoInputs);
-  writer->setXDims(cropStart, cropEnd);
-  writer->setYDims(0, m_Geometry->N_y);
-  writer->setZDims(0, m_Geometry->N_z);
-  writer->setObservers(getObservers());
-  writer->setWriteBinaryFile(true);
-  writer->execute();
-  if(writer->getErrorCondition() < 0)
+  VolumeExporter::Pointer exporter = VolumeExporter::New();
+  exporter->setGeometry(m_Geometry);
+  exporter->setTomoInputs(m_TomoInputs);
+  exporter->setAdvParams(m_AdvParams);
+  exporter->setVtkOutputFile(m_TomoInputs->vtkOutputFile);
+  exporter->setMRCOutputFile(m_TomoInputs->mrcOutputFile);
+  exporter->setAvizoOutputFile(m_TomoInputs->avizoOutputFile);
+  exporter->setXDims(cropStart, cropEnd);
+  // The halo of a Y slab is left out and the rest goes to its rows of the output
+  exporter->setYDims(m_TomoInputs->slabHaloStart, m_Geometry->N_y - m_TomoInputs->slabHaloEnd);
+  exporter->setOutputYOffset(m_TomoInputs->slabOutputY);
+  exporter->setOutputYSize(m_TomoInputs->slabOutputNy);
+  exporter->setZDims(0, m_Geometry->N_z);
+  exporter->setObservers(getObservers());
+  exporter->execute();
+  if(exporter->getErrorCondition() < 0)
   {
-    ss.str("");
-    ss << "Error writing Avizo file\n    '" << file << "'" << std::endl;
-    setErrorCondition(writer->getErrorCondition());
-    notify(ss.str(), 0, Observable::UpdateErrorMessage);
+    setErrorCondition(exporter->getErrorCondition());
   }
-
 }
 
 // -----------------------------------------------------------------------------
@@ -551,6 +489,7 @@ uint8_t BFReconstructionEngine::updateVoxels(int16_t OuterIter,
 
   Real_t NH_Threshold = 0.0;
   int totalLoops = m_TomoInputs->NumOuterIter * m_TomoInputs->NumIter;
+  Real_t TotalCostChange = 0.0; //Change in cost over all the sub iterations
 
 #ifdef DEBUG
   if (getVeryVerbose())
@@ -656,6 +595,8 @@ uint8_t BFReconstructionEngine::updateVoxels(int16_t OuterIter,
     ::memset(averageUpdate.get(), 0, sizeof(Real_t) * m_NumThreads);
     boost::shared_array<Real_t> averageMagnitudeOfRecon(new Real_t[m_NumThreads]);
     ::memset(averageMagnitudeOfRecon.get(), 0, sizeof(Real_t) * m_NumThreads);
+    boost::shared_array<Real_t> costChange(new Real_t[m_NumThreads]);
+    ::memset(costChange.get(), 0, sizeof(Real_t) * m_NumThreads);
 
     size_t dims[3];
     //Initialize individual magnitude maps for the separate threads
@@ -704,6 +645,7 @@ uint8_t BFReconstructionEngine::updateVoxels(int16_t OuterIter,
                                                          magUpdateMask, updateType,
                                                          averageUpdate.get() + t,
                                                          averageMagnitudeOfRecon.get() + t,
+                                                         (m_AdvParams->TRACK_COST) ? costChange.get() + t : NULL,
                                                          m_AdvParams->ZERO_SKIPPING,
                                                          BFQGGMRF_values, NewList[t] );
       taskList.push_back(a);
@@ -730,7 +672,9 @@ uint8_t BFReconstructionEngine::updateVoxels(int16_t OuterIter,
 #endif //Debug
       AverageUpdate += averageUpdate[t];
       AverageMagnitudeOfRecon += averageMagnitudeOfRecon[t];
+      TotalCostChange += costChange[t];
     }
+    costChange.reset();
     averageUpdate.reset(); // We are forcing the array to be deallocated, we could wait till the current scope terminates then the arrays would be automatically cleaned up
     averageMagnitudeOfRecon.reset(); // We are forcing the array to be deallocated, we could wait till the current scope terminates then the arrays would be automatically cleaned up
     NewList.resize(0); // Frees all the pointers
@@ -778,6 +722,7 @@ uint8_t BFReconstructionEngine::updateVoxels(int16_t OuterIter,
                                                  magUpdateMask, updateType,
                                                  averageUpdate,
                                                  averageMagnitudeOfRecon,
+                                                 (m_AdvParams->TRACK_COST) ? &TotalCostChange : NULL,
                                                  m_AdvParams->ZERO_SKIPPING,
                                                  BFQGGMRF_values, NewList);
 
@@ -819,6 +764,8 @@ uint8_t BFReconstructionEngine::updateVoxels(int16_t OuterIter,
 
   }
 
+  cost->addTrackedCostChange(TotalCostChange);
+
   //Stopping criteria code
   exit_status = stopCriteria(magUpdateMap, magUpdateMask, PrevMagSum, EffIterCount);
 
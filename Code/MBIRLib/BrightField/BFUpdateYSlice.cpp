@@ -85,6 +85,7 @@ BFUpdateYSlice::BFUpdateYSlice(uint16_t yStart, uint16_t yEnd,
                                unsigned int voxelUpdateType,
                                Real_t* averageUpdate,
                                Real_t* averageMagnitudeOfRecon,
+                               Real_t* costChange,
                                unsigned int zeroSkipping,
                                QGGMRF::QGGMRF_Values* qggmrf_values,
                                VoxelUpdateList::Pointer voxelUpdateList) :
@@ -106,6 +107,7 @@ BFUpdateYSlice::BFUpdateYSlice(uint16_t yStart, uint16_t yEnd,
   m_CurrentVoxelValue(0.0),
   m_AverageUpdate(averageUpdate),
   m_AverageMagnitudeOfRecon(averageMagnitudeOfRecon),
+  m_CostChange(costChange),
   m_ZeroSkipping(zeroSkipping),
   m_QggmrfValues(qggmrf_values),
   m_VoxelUpdateList(voxelUpdateList)
@@ -311,6 +313,16 @@ BFUpdateYSlice::execute()
             *m_AverageMagnitudeOfRecon += fabs(m_CurrentVoxelValue); //computing the percentage update =(Change in mag/Initial magnitude)
           }
 #endif //ROI
+          //Change in cost: the data term follows from THETA1/THETA2 and the
+          //prior term is local to the neighborhood
+          if(NULL != m_CostChange)
+          {
+            Real_t delta = UpdatedVoxelValue - m_CurrentVoxelValue;
+            *m_CostChange += m_Theta1 * delta + 0.5 * m_Theta2 * delta * delta;
+            *m_CostChange += QGGMRF::LocalCostChange(m_CurrentVoxelValue, UpdatedVoxelValue,
+                                                     m_BoundaryFlag, m_Filter, m_Neighborhood, m_QggmrfValues);
+          }
+
           //Update the ErrorSinogram and Bragg selector
           m_ForwardModel->updateErrorSinogram(UpdatedVoxelValue - m_CurrentVoxelValue, Index, m_TempCol, i, m_VoxelLineResponse, m_ErrorSino, m_Sinogram);
         }
@@ -104,6 +104,7 @@ class BFUpdateYSlice
     * @param voxelUpdateType
     * @param averageUpdate
     * @param averageMagnitudeOfRecon
+    * @param costChange Accumulates the change in the cost caused by the updates. NULL skips it
     * @param zeroSkipping
     * @param qggmrf_values
     */
@@ -120,6 +121,7 @@ class BFUpdateYSlice
                    unsigned int voxelUpdateType,
                    Real_t* averageUpdate,
                    Real_t* averageMagnitudeOfRecon,
+                   Real_t* costChange,
                    unsigned int zeroSkipping,
                    QGGMRF::QGGMRF_Values* qggmrf_values,
                    VoxelUpdateList::Pointer voxelUpdateList);
@@ -173,6 +175,7 @@ class BFUpdateYSlice
     Real_t* m_AverageUpdate;
     Real_t* m_AverageMagnitudeOfRecon;
 #endif
+    Real_t* m_CostChange;
     unsigned int m_ZeroSkipping;
 
     QGGMRF::QGGMRF_Values* m_QggmrfValues;
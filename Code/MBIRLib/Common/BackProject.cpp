@@ -0,0 +1,112 @@
+/* ============================================================================
+ * Copyright (c) 2012 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2012 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "BackProject.h"
+
+#include <sstream>
+
+#include "MBIRLib/Common/EIMMath.h"
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+BackProject::BackProject(Sinogram* sinogram,
+                         Geometry* geometry,
+                         std::vector<AMatrixCol::Pointer>& tempCol,
+                         std::vector<AMatrixCol::Pointer>& voxelLineResponse,
+                         RealArrayType::Pointer i_0,
+                         RealVolumeType::Pointer input,
+                         RealVolumeType::Pointer output,
+                         uint16_t slice,
+                         Observable* obs) :
+  m_Sinogram(sinogram),
+  m_Geometry(geometry),
+  TempCol(tempCol),
+  VoxelLineResponse(voxelLineResponse),
+  I_0(i_0),
+  m_Input(input),
+  m_Output(output),
+  m_Slice(slice),
+  m_Observable(obs)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+BackProject::~BackProject()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void BackProject::operator()() const
+{
+  if (NULL != m_Observable)
+  {
+    std::stringstream ss;
+    ss << "Back projecting Z-Slice " << m_Slice << "/" << m_Geometry->N_z;
+    m_Observable->notify(ss.str(), 0, Observable::UpdateProgressMessage);
+  }
+
+  uint32_t z = m_Slice;
+  for (uint32_t x = 0; x < m_Geometry->N_x; x++)
+  {
+    uint32_t Index = z * m_Geometry->N_x + x;
+    AMatrixCol* col = TempCol[Index].get();
+    for (uint32_t y = 0; y < m_Geometry->N_y; y++)
+    {
+      AMatrixCol* vlr = VoxelLineResponse[y].get();
+      Real_t sum = 0.0;
+      for (uint32_t q = 0; q < col->count; q++)
+      {
+        uint16_t i_theta = col->index[q] / m_Sinogram->N_r;
+        uint16_t i_r = col->index[q] % m_Sinogram->N_r;
+        Real_t kConst0 = I_0->d[i_theta] * col->values[q];
+        // The t entries for a fixed (theta, r) are contiguous in memory
+        Real_t* data = m_Input->d + m_Input->calcIndex(i_theta, i_r, vlr->index[0]);
+        Real_t lineSum = 0.0;
+        for (uint32_t c = 0; c < vlr->count; c++)
+        {
+          lineSum += vlr->values[c] * data[c];
+        }
+        sum += kConst0 * lineSum;
+      }
+      m_Output->setValue(sum, z, x, y);
+    }
+  }
+}
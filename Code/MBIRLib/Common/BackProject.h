@@ -0,0 +1,97 @@
+/* ============================================================================
+ * Copyright (c) 2012 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2012 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _BACKPROJECT_H_
+#define _BACKPROJECT_H_
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/Observable.h"
+#include "MBIRLib/Common/AMatrixCol.h"
+#include "MBIRLib/Reconstruction/ReconstructionStructures.h"
+
+/**
+ * @class BackProject BackProject.h MBIRLib/Common/BackProject.h
+ * @brief Applies the transpose of the forward projector (A^T) to a sinogram
+ * sized array for a single Z slice of the geometry. The A matrix is never
+ * formed explicitly; the same partial columns (TempCol) and voxel line responses
+ * that are used by the forward projectors are traversed in the opposite direction.
+ * Each instance only writes voxels in its own Z slice so instances for different
+ * slices can safely be run concurrently.
+ * @author Michael A. Jackson for BlueQuartz Software
+ * @author Singanallur Venkatakrishnan (Purdue University)
+ * @version 1.0
+ */
+class MBIRLib_EXPORT BackProject
+{
+  public:
+    /**
+     * @param sinogram The sinogram structure holding the dimensions of the data
+     * @param geometry The geometry structure holding the dimensions of the volume
+     * @param tempCol The partial A matrix columns for each (z,x) voxel line
+     * @param voxelLineResponse The detector response for each y slice
+     * @param i_0 The gain for each tilt
+     * @param input The sinogram sized array to back project
+     * @param output The volume that receives A^T * input for this slice
+     * @param slice The Z slice to compute
+     * @param obs An optional observable to send progress messages through
+     */
+    BackProject(Sinogram* sinogram,
+                Geometry* geometry,
+                std::vector<AMatrixCol::Pointer>& tempCol,
+                std::vector<AMatrixCol::Pointer>& voxelLineResponse,
+                RealArrayType::Pointer i_0,
+                RealVolumeType::Pointer input,
+                RealVolumeType::Pointer output,
+                uint16_t slice,
+                Observable* obs);
+
+    virtual ~BackProject();
+
+    void operator()() const;
+
+  private:
+    Sinogram* m_Sinogram;
+    Geometry* m_Geometry;
+    std::vector<AMatrixCol::Pointer> TempCol;
+    std::vector<AMatrixCol::Pointer> VoxelLineResponse;
+    RealArrayType::Pointer I_0;
+    RealVolumeType::Pointer m_Input;
+    RealVolumeType::Pointer m_Output;
+    uint16_t m_Slice;
+    Observable* m_Observable;
+};
+
+#endif /* _BACKPROJECT_H_ */
@@ -0,0 +1,137 @@
+/* ============================================================================
+ * Copyright (c) 2012 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2012 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "BitVolume.h"
+
+namespace Detail
+{
+  // -----------------------------------------------------------------------------
+  //
+  // -----------------------------------------------------------------------------
+  inline size_t PopCount(BitVolume::WordType word)
+  {
+#if defined (_MSC_VER)
+    return __popcnt(word);
+#else
+    return __builtin_popcount(word);
+#endif
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+BitVolume::BitVolume(size_t* dims, const std::string& name) :
+  m_Name(name),
+  m_NumElements(1)
+{
+  for (int i = 0; i < 3; i++)
+  {
+    m_Dims[i] = dims[i];
+    m_NumElements *= dims[i];
+  }
+  m_Words.resize((m_NumElements + k_BitsPerWord - 1) / k_BitsPerWord, 0);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+BitVolume::~BitVolume()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+BitVolume::Pointer BitVolume::New(size_t* dims, const std::string& name)
+{
+  Pointer ptr(new BitVolume(dims, name));
+  return ptr;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void BitVolume::setAll(bool value)
+{
+  WordType fill = value ? ~static_cast<WordType>(0) : 0;
+  for (size_t i = 0; i < m_Words.size(); i++)
+  {
+    m_Words[i] = fill;
+  }
+  clearUnusedBits();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+size_t BitVolume::countSetBits(size_t start, size_t count) const
+{
+  size_t total = 0;
+  size_t end = start + count;
+  size_t index = start;
+  //Leading partial word
+  while (index < end && (index % k_BitsPerWord) != 0)
+  {
+    total += getBit(index) ? 1 : 0;
+    index++;
+  }
+  //Whole words
+  while (index + k_BitsPerWord <= end)
+  {
+    total += Detail::PopCount(m_Words[index / k_BitsPerWord]);
+    index += k_BitsPerWord;
+  }
+  //Trailing partial word
+  while (index < end)
+  {
+    total += getBit(index) ? 1 : 0;
+    index++;
+  }
+  return total;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void BitVolume::clearUnusedBits()
+{
+  size_t used = m_NumElements % k_BitsPerWord;
+  if (used != 0 && m_Words.size() > 0)
+  {
+    m_Words[m_Words.size() - 1] &= (static_cast<WordType>(1) << used) - 1;
+  }
+}
@@ -0,0 +1,147 @@
+/* ============================================================================
+ * Copyright (c) 2012 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2012 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _BitVolume_H_
+#define _BitVolume_H_
+
+#include <string>
+#include <vector>
+
+#if defined (_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+
+/**
+ * @class BitVolume BitVolume.h MBIRLib/Common/BitVolume.h
+ * @brief A 3D volume of boolean values packed 32 to a word. The elements are laid
+ * out in the same order as a TomoArray with the same dimensions so the same
+ * linear index can be used for both. Single bit writes are atomic on the word
+ * when the parallel algorithms are enabled so concurrent writes to neighboring
+ * bits from different threads do not lose each other's updates.
+ * @author Michael A. Jackson for BlueQuartz Software
+ * @author Singanallur Venkatakrishnan (Purdue University)
+ * @version 1.0
+ */
+class MBIRLib_EXPORT BitVolume
+{
+  public:
+    MXA_SHARED_POINTERS(BitVolume)
+    MXA_TYPE_MACRO(BitVolume)
+
+    typedef uint32_t WordType;
+    static const size_t k_BitsPerWord = 32;
+
+    /**
+     * @brief Creates a new volume with every bit cleared
+     * @param dims The 3 dimensions of the volume, slowest first
+     * @param name
+     */
+    static Pointer New(size_t* dims, const std::string& name);
+
+    virtual ~BitVolume();
+
+    MXA_INSTANCE_STRING_PROPERTY(Name)
+
+    size_t* getDims() { return m_Dims; }
+
+    size_t getNumberOfElements() { return m_NumElements; }
+
+    size_t getNumberOfWords() { return m_Words.size(); }
+
+    size_t calcIndex(size_t z, size_t y, size_t x)
+    {
+      return (m_Dims[1] * m_Dims[2] * z) + (m_Dims[2] * y) + (x);
+    }
+
+    inline bool getBit(size_t index) const
+    {
+      return ((m_Words[index / k_BitsPerWord] >> (index % k_BitsPerWord)) & 1) != 0;
+    }
+
+    inline void setBit(size_t index, bool value)
+    {
+      WordType* word = &(m_Words[index / k_BitsPerWord]);
+      WordType mask = static_cast<WordType>(1) << (index % k_BitsPerWord);
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#if defined (_MSC_VER)
+      if (value) { _InterlockedOr(reinterpret_cast<volatile long*>(word), static_cast<long>(mask)); }
+      else { _InterlockedAnd(reinterpret_cast<volatile long*>(word), static_cast<long>(~mask)); }
+#else
+      if (value) { __sync_fetch_and_or(word, mask); }
+      else { __sync_fetch_and_and(word, ~mask); }
+#endif
+#else
+      if (value) { *word |= mask; }
+      else { *word &= ~mask; }
+#endif
+    }
+
+    /**
+     * @brief Whole word access for word level operations. The unused high bits
+     * of the last word are always kept cleared.
+     */
+    inline WordType getWord(size_t wordIndex) const { return m_Words[wordIndex]; }
+    inline void setWord(size_t wordIndex, WordType value) { m_Words[wordIndex] = value; }
+
+    /**
+     * @brief Sets or clears every bit
+     */
+    void setAll(bool value);
+
+    /**
+     * @brief Counts the set bits in [start, start + count)
+     */
+    size_t countSetBits(size_t start, size_t count) const;
+
+  protected:
+    BitVolume(size_t* dims, const std::string& name);
+
+  private:
+    size_t m_Dims[3];
+    size_t m_NumElements;
+    std::vector<WordType> m_Words;
+
+    void clearUnusedBits();
+
+    BitVolume(const BitVolume&); // Copy Constructor Not Implemented
+    void operator=(const BitVolume&); // Operator '=' Not Implemented
+};
+
+#endif /* _BitVolume_H_ */
@@ -0,0 +1,344 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "LocalSocketTransport.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include <sstream>
+
+#if !defined (_MSC_VER)
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include "MBIRLib/Common/EIMTime.h"
+
+#if defined (MSG_NOSIGNAL)
+#define MBIR_SOCKET_FLAGS MSG_NOSIGNAL
+#else
+#define MBIR_SOCKET_FLAGS 0
+#endif
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+LocalSocketTransport::LocalSocketTransport() :
+  SlabTransport(),
+  m_SocketDirectory(""),
+  m_ConnectTimeout(120),
+  m_Rank(0),
+  m_Size(1),
+  m_ListenSocket(-1)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+LocalSocketTransport::~LocalSocketTransport()
+{
+  close();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void LocalSocketTransport::setRankAndSize(int rank, int size)
+{
+  m_Rank = rank;
+  m_Size = size;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int LocalSocketTransport::getRank()
+{
+  return m_Rank;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int LocalSocketTransport::getSize()
+{
+  return m_Size;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::string LocalSocketTransport::socketPath(int rank)
+{
+  std::stringstream ss;
+  ss << m_SocketDirectory << "/mbir_rank_" << rank << ".sock";
+  return ss.str();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int LocalSocketTransport::fail(const std::string& message)
+{
+  std::stringstream ss;
+  ss << "Rank " << m_Rank << ": " << message;
+  if(errno != 0)
+  {
+    ss << " (" << strerror(errno) << ")";
+  }
+  setErrorMessage(ss.str());
+  return -1;
+}
+
+#if defined (_MSC_VER)
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int LocalSocketTransport::connect()
+{
+  setErrorMessage("Local socket transports are not available on Windows");
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void LocalSocketTransport::close()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int LocalSocketTransport::send(int peer, const void* data, size_t bytes)
+{
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int LocalSocketTransport::receive(int peer, void* data, size_t bytes)
+{
+  return -1;
+}
+
+#else
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int LocalSocketTransport::connect()
+{
+  close();
+  errno = 0;
+  if(m_Rank < 0 || m_Rank >= m_Size)
+  {
+    return fail("The rank is not between 0 and the number of workers");
+  }
+  struct sockaddr_un address;
+  ::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if(socketPath(m_Size).size() >= sizeof(address.sun_path))
+  {
+    return fail("The socket directory path is too long: " + m_SocketDirectory);
+  }
+  m_Sockets.assign(m_Size, -1);
+
+  // Listen first so lower ranks can already queue up
+  m_ListenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if(m_ListenSocket < 0)
+  {
+    return fail("Could not create a socket");
+  }
+  std::string path = socketPath(m_Rank);
+  ::unlink(path.c_str());
+  ::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  if(::bind(m_ListenSocket, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0
+      || ::listen(m_ListenSocket, m_Size) != 0)
+  {
+    return fail("Could not listen on " + path);
+  }
+
+  // Connect to every lower rank and tell it who we are
+  for (int peer = 0; peer < m_Rank; ++peer)
+  {
+    path = socketPath(peer);
+    ::memset(address.sun_path, 0, sizeof(address.sun_path));
+    ::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    unsigned long long start = EIMTOMO_getMilliSeconds();
+    while (true)
+    {
+      int s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+      if(s < 0)
+      {
+        return fail("Could not create a socket");
+      }
+      if(::connect(s, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == 0)
+      {
+        m_Sockets[peer] = s;
+        break;
+      }
+      ::close(s);
+      if(EIMTOMO_getMilliSeconds() - start > static_cast<unsigned long long>(m_ConnectTimeout) * 1000)
+      {
+        return fail("Timed out connecting to " + path);
+      }
+      ::usleep(100000);
+    }
+    int32_t rank = m_Rank;
+    if(send(peer, &rank, sizeof(rank)) < 0)
+    {
+      return -1;
+    }
+  }
+
+  // Accept every higher rank
+  for (int i = m_Rank + 1; i < m_Size; ++i)
+  {
+    int s = ::accept(m_ListenSocket, NULL, NULL);
+    if(s < 0)
+    {
+      return fail("Could not accept a connection");
+    }
+    int32_t rank = -1;
+    size_t received = 0;
+    while (received < sizeof(rank))
+    {
+      ssize_t n = ::recv(s, reinterpret_cast<char*>(&rank) + received, sizeof(rank) - received, 0);
+      if(n <= 0)
+      {
+        ::close(s);
+        return fail("A worker hung up while connecting");
+      }
+      received += static_cast<size_t>(n);
+    }
+    if(rank <= m_Rank || rank >= m_Size || m_Sockets[rank] >= 0)
+    {
+      ::close(s);
+      return fail("A worker connected with an unexpected rank");
+    }
+    m_Sockets[rank] = s;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void LocalSocketTransport::close()
+{
+  for (size_t i = 0; i < m_Sockets.size(); ++i)
+  {
+    if(m_Sockets[i] >= 0)
+    {
+      ::close(m_Sockets[i]);
+    }
+  }
+  m_Sockets.clear();
+  if(m_ListenSocket >= 0)
+  {
+    ::close(m_ListenSocket);
+    ::unlink(socketPath(m_Rank).c_str());
+    m_ListenSocket = -1;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int LocalSocketTransport::send(int peer, const void* data, size_t bytes)
+{
+  if(peer < 0 || peer >= static_cast<int>(m_Sockets.size()) || m_Sockets[peer] < 0)
+  {
+    errno = 0;
+    return fail("Not connected to the worker");
+  }
+  const char* p = reinterpret_cast<const char*>(data);
+  while (bytes > 0)
+  {
+    ssize_t n = ::send(m_Sockets[peer], p, bytes, MBIR_SOCKET_FLAGS);
+    if(n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if(n <= 0)
+    {
+      return fail("Could not send to a worker");
+    }
+    p += n;
+    bytes -= static_cast<size_t>(n);
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int LocalSocketTransport::receive(int peer, void* data, size_t bytes)
+{
+  if(peer < 0 || peer >= static_cast<int>(m_Sockets.size()) || m_Sockets[peer] < 0)
+  {
+    errno = 0;
+    return fail("Not connected to the worker");
+  }
+  char* p = reinterpret_cast<char*>(data);
+  while (bytes > 0)
+  {
+    ssize_t n = ::recv(m_Sockets[peer], p, bytes, 0);
+    if(n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if(n <= 0)
+    {
+      if(n == 0)
+      {
+        errno = 0;
+      }
+      return fail("A worker hung up");
+    }
+    p += n;
+    bytes -= static_cast<size_t>(n);
+  }
+  return 0;
+}
+
+#endif
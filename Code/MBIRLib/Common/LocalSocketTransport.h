@@ -0,0 +1,109 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _LocalSocketTransport_H_
+#define _LocalSocketTransport_H_
+
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/SlabTransport.h"
+
+/**
+ * @class LocalSocketTransport LocalSocketTransport.h MBIRLib/Common/LocalSocketTransport.h
+ * @brief Connects the worker processes on one machine with UNIX domain
+ * sockets. Every rank listens on a socket named after it in SocketDirectory
+ * and connects to every lower rank, so any two ranks share one connection.
+ * The workers may be started in any order; connect() waits up to
+ * ConnectTimeout seconds for the others to show up.
+ *
+ * This is not available on Windows.
+ */
+class MBIRLib_EXPORT LocalSocketTransport : public SlabTransport
+{
+  public:
+    MXA_SHARED_POINTERS(LocalSocketTransport)
+    MXA_TYPE_MACRO_SUPER(LocalSocketTransport, SlabTransport)
+    MXA_STATIC_NEW_MACRO(LocalSocketTransport)
+
+    virtual ~LocalSocketTransport();
+
+    MXA_INSTANCE_STRING_PROPERTY(SocketDirectory)
+    MXA_INSTANCE_PROPERTY(int, ConnectTimeout)
+
+    /**
+     * @brief Sets the rank of this process and the number of processes
+     */
+    void setRankAndSize(int rank, int size);
+
+    virtual int getRank();
+    virtual int getSize();
+
+    /**
+     * @brief Connects to every other rank. Must be called by every rank before
+     * anything is sent.
+     * @return Negative on Error.
+     */
+    int connect();
+
+    /**
+     * @brief Closes the connections and removes the socket of this rank
+     */
+    void close();
+
+    virtual int send(int peer, const void* data, size_t bytes);
+    virtual int receive(int peer, void* data, size_t bytes);
+
+  protected:
+    LocalSocketTransport();
+
+    std::string socketPath(int rank);
+    int fail(const std::string& message);
+
+  private:
+    int m_Rank;
+    int m_Size;
+    int m_ListenSocket;
+    std::vector<int> m_Sockets;
+
+    LocalSocketTransport(const LocalSocketTransport&); // Copy Constructor Not Implemented
+    void operator=(const LocalSocketTransport&); // Operator '=' Not Implemented
+};
+
+#endif /* _LocalSocketTransport_H_ */
@@ -0,0 +1,178 @@
+/* ============================================================================
+ * Copyright (c) 2012 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2012 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "MemoryMappedFile.h"
+
+#if defined (_MSC_VER)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MemoryMappedFile::MemoryMappedFile() :
+  m_Data(NULL),
+  m_Size(0),
+#if defined (_MSC_VER)
+  m_FileHandle(INVALID_HANDLE_VALUE),
+  m_MappingHandle(NULL)
+#else
+  m_FileDescriptor(-1)
+#endif
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MemoryMappedFile::~MemoryMappedFile()
+{
+  close();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MemoryMappedFile::open(const std::string& filepath)
+{
+  close();
+#if defined (_MSC_VER)
+  m_FileHandle = ::CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (m_FileHandle == INVALID_HANDLE_VALUE)
+  {
+    return -1;
+  }
+  LARGE_INTEGER size;
+  if (::GetFileSizeEx(m_FileHandle, &size) == 0)
+  {
+    close();
+    return -2;
+  }
+  m_Size = static_cast<uint64_t>(size.QuadPart);
+  if (m_Size == 0)
+  {
+    close();
+    return -3;
+  }
+  m_MappingHandle = ::CreateFileMappingA(m_FileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (m_MappingHandle == NULL)
+  {
+    close();
+    return -4;
+  }
+  m_Data = reinterpret_cast<const uint8_t*>(::MapViewOfFile(m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+  if (m_Data == NULL)
+  {
+    close();
+    return -4;
+  }
+#else
+  m_FileDescriptor = ::open(filepath.c_str(), O_RDONLY);
+  if (m_FileDescriptor < 0)
+  {
+    return -1;
+  }
+  struct stat st;
+  if (::fstat(m_FileDescriptor, &st) != 0)
+  {
+    close();
+    return -2;
+  }
+  m_Size = static_cast<uint64_t>(st.st_size);
+  if (m_Size == 0)
+  {
+    close();
+    return -3;
+  }
+  void* data = ::mmap(NULL, m_Size, PROT_READ, MAP_SHARED, m_FileDescriptor, 0);
+  if (data == MAP_FAILED)
+  {
+    close();
+    return -4;
+  }
+  m_Data = reinterpret_cast<const uint8_t*>(data);
+#endif
+  m_FilePath = filepath;
+  return 1;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryMappedFile::close()
+{
+#if defined (_MSC_VER)
+  if (NULL != m_Data) { ::UnmapViewOfFile(m_Data); }
+  if (NULL != m_MappingHandle) { ::CloseHandle(m_MappingHandle); }
+  if (m_FileHandle != INVALID_HANDLE_VALUE) { ::CloseHandle(m_FileHandle); }
+  m_MappingHandle = NULL;
+  m_FileHandle = INVALID_HANDLE_VALUE;
+#else
+  if (NULL != m_Data) { ::munmap(const_cast<uint8_t*>(m_Data), m_Size); }
+  if (m_FileDescriptor >= 0) { ::close(m_FileDescriptor); }
+  m_FileDescriptor = -1;
+#endif
+  m_Data = NULL;
+  m_Size = 0;
+  m_FilePath.clear();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryMappedFile::willNeed(uint64_t offset, uint64_t length) const
+{
+  if (NULL == m_Data || offset >= m_Size)
+  {
+    return;
+  }
+  if (offset + length > m_Size)
+  {
+    length = m_Size - offset;
+  }
+#if !defined (_MSC_VER)
+  // madvise wants a page aligned start address
+  uint64_t pageSize = static_cast<uint64_t>(::sysconf(_SC_PAGESIZE));
+  uint64_t alignedOffset = offset - (offset % pageSize);
+  ::madvise(const_cast<uint8_t*>(m_Data + alignedOffset), length + (offset - alignedOffset), MADV_WILLNEED);
+#endif
+}
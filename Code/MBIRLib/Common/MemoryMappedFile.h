@@ -0,0 +1,110 @@
+/* ============================================================================
+ * Copyright (c) 2012 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2012 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _MemoryMappedFile_H_
+#define _MemoryMappedFile_H_
+
+#include <string>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+
+/**
+ * @class MemoryMappedFile MemoryMappedFile.h MBIRLib/Common/MemoryMappedFile.h
+ * @brief Maps an entire file read only into the address space of the process
+ * so that it can be read through a pointer without any intermediate buffers.
+ * The pages are brought in by the operating system as they are touched.
+ * @author Michael A. Jackson for BlueQuartz Software
+ * @author Singanallur Venkatakrishnan (Purdue University)
+ * @version 1.0
+ */
+class MBIRLib_EXPORT MemoryMappedFile
+{
+  public:
+    MXA_SHARED_POINTERS(MemoryMappedFile)
+    MXA_TYPE_MACRO(MemoryMappedFile)
+    MXA_STATIC_NEW_MACRO(MemoryMappedFile)
+
+    virtual ~MemoryMappedFile();
+
+    /**
+     * @brief Maps the file. Any previously mapped file is unmapped first.
+     * @return Negative on Error.
+     */
+    int open(const std::string& filepath);
+
+    /**
+     * @brief Unmaps the file. Any pointers into the mapping become invalid.
+     */
+    void close();
+
+    bool isOpen() const { return NULL != m_Data; }
+
+    const std::string& getFilePath() const { return m_FilePath; }
+
+    /**
+     * @brief Returns the first byte of the file or NULL if nothing is mapped
+     */
+    const uint8_t* getData() const { return m_Data; }
+
+    uint64_t getSize() const { return m_Size; }
+
+    /**
+     * @brief Tells the operating system that the given byte range is going to
+     * be read soon so it can start bringing the pages in. This is only a hint.
+     */
+    void willNeed(uint64_t offset, uint64_t length) const;
+
+  protected:
+    MemoryMappedFile();
+
+  private:
+    std::string m_FilePath;
+    const uint8_t* m_Data;
+    uint64_t m_Size;
+#if defined (_MSC_VER)
+    void* m_FileHandle;
+    void* m_MappingHandle;
+#else
+    int m_FileDescriptor;
+#endif
+
+    MemoryMappedFile(const MemoryMappedFile&); // Copy Constructor Not Implemented
+    void operator=(const MemoryMappedFile&); // Operator '=' Not Implemented
+};
+
+#endif /* _MemoryMappedFile_H_ */
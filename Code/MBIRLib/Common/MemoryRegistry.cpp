@@ -0,0 +1,461 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "MemoryRegistry.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#if defined (__linux__)
+#include <unistd.h>
+#elif !defined (_MSC_VER)
+#include <sys/resource.h>
+#endif
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#define MEMORY_REGISTRY_LOCK tbb::spin_mutex::scoped_lock registryLock(m_Mutex);
+#else
+#define MEMORY_REGISTRY_LOCK
+#endif
+
+namespace Detail
+{
+  /* Largest level peak first so the structures that matter head the report */
+  bool levelPeakGreater(const std::pair<std::string, MemoryRegistryEntry>& a,
+                        const std::pair<std::string, MemoryRegistryEntry>& b)
+  {
+    return a.second.LevelPeakBytes > b.second.LevelPeakBytes;
+  }
+
+  void printEntries(const std::map<std::string, MemoryRegistryEntry>& entries, std::ostream& out)
+  {
+    std::vector<std::pair<std::string, MemoryRegistryEntry> > sorted(entries.begin(), entries.end());
+    std::stable_sort(sorted.begin(), sorted.end(), levelPeakGreater);
+    out << "  " << std::left << std::setw(36) << "Name" << std::right << std::setw(12) << "Live"
+        << std::setw(12) << "Level peak" << std::setw(12) << "Peak" << std::setw(8) << "Count" << std::endl;
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+      const MemoryRegistryEntry& e = sorted[i].second;
+      if(e.LevelPeakBytes == 0 && e.LiveBytes == 0)
+      {
+        continue;
+      }
+      out << "  " << std::left << std::setw(36) << (sorted[i].first.empty() ? std::string("(unnamed)") : sorted[i].first)
+          << std::right << std::setw(12) << MemoryRegistry::FormatBytes(e.LiveBytes)
+          << std::setw(12) << MemoryRegistry::FormatBytes(e.LevelPeakBytes)
+          << std::setw(12) << MemoryRegistry::FormatBytes(e.PeakBytes)
+          << std::setw(8) << e.Allocations << std::endl;
+    }
+  }
+
+  std::string jsonString(const std::string& value)
+  {
+    std::string quoted("\"");
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+      char c = value[i];
+      if(c == '"' || c == '\\')
+      {
+        quoted += '\\';
+        quoted += c;
+      }
+      else if(static_cast<unsigned char>(c) < 0x20)
+      {
+        char buf[8];
+        snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(c)));
+        quoted += buf;
+      }
+      else
+      {
+        quoted += c;
+      }
+    }
+    quoted += "\"";
+    return quoted;
+  }
+
+  void writeJsonEntries(const std::map<std::string, MemoryRegistryEntry>& entries, std::ostream& out, const std::string& indent)
+  {
+    out << "{";
+    bool first = true;
+    for (std::map<std::string, MemoryRegistryEntry>::const_iterator iter = entries.begin(); iter != entries.end(); ++iter)
+    {
+      const MemoryRegistryEntry& e = (*iter).second;
+      out << (first ? "\n" : ",\n") << indent << "  " << jsonString((*iter).first) << ": { "
+          << "\"live_bytes\": " << e.LiveBytes << ", "
+          << "\"level_peak_bytes\": " << e.LevelPeakBytes << ", "
+          << "\"peak_bytes\": " << e.PeakBytes << ", "
+          << "\"allocations\": " << e.Allocations << ", "
+          << "\"live_allocations\": " << e.LiveAllocations << " }";
+      first = false;
+    }
+    out << "\n" << indent << "}";
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MemoryRegistry::MemoryRegistry() :
+  m_Level(""),
+  m_LiveBytes(0),
+  m_PeakBytes(0),
+  m_LevelPeakBytes(0)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MemoryRegistry::~MemoryRegistry()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MemoryRegistry* MemoryRegistry::Instance()
+{
+  static MemoryRegistry registry;
+  return &registry;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::string MemoryRegistry::FormatBytes(uint64_t bytes)
+{
+  const char* units[5] = { "B", "KB", "MB", "GB", "TB" };
+  double value = static_cast<double>(bytes);
+  int unit = 0;
+  while(value >= 1024.0 && unit < 4)
+  {
+    value /= 1024.0;
+    unit++;
+  }
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(unit == 0 ? 0 : 2) << value << " " << units[unit];
+  return ss.str();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+uint64_t MemoryRegistry::GetResidentBytes()
+{
+#if defined (__linux__)
+  unsigned long size = 0;
+  unsigned long resident = 0;
+  FILE* f = fopen("/proc/self/statm", "r");
+  if(NULL == f)
+  {
+    return 0;
+  }
+  int count = fscanf(f, "%lu %lu", &size, &resident);
+  fclose(f);
+  if(count != 2)
+  {
+    return 0;
+  }
+  return static_cast<uint64_t>(resident) * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 0;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+uint64_t MemoryRegistry::GetPeakResidentBytes()
+{
+#if defined (__linux__)
+  FILE* f = fopen("/proc/self/status", "r");
+  if(NULL == f)
+  {
+    return 0;
+  }
+  char line[256];
+  unsigned long kb = 0;
+  while(fgets(line, sizeof(line), f) != NULL)
+  {
+    if(sscanf(line, "VmHWM: %lu kB", &kb) == 1)
+    {
+      break;
+    }
+  }
+  fclose(f);
+  return static_cast<uint64_t>(kb) * 1024;
+#elif defined (__APPLE__)
+  struct rusage usage;
+  if(getrusage(RUSAGE_SELF, &usage) != 0)
+  {
+    return 0;
+  }
+  return static_cast<uint64_t>(usage.ru_maxrss); // Bytes on OS X
+#else
+  return 0;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryRegistry::add(const std::string& name, uint64_t bytes, bool newAllocation)
+{
+  std::map<std::string, MemoryRegistryEntry>::iterator iter = m_Entries.find(name);
+  if(iter == m_Entries.end())
+  {
+    MemoryRegistryEntry entry;
+    entry.LiveBytes = 0;
+    entry.PeakBytes = 0;
+    entry.LevelPeakBytes = 0;
+    entry.Allocations = 0;
+    entry.LiveAllocations = 0;
+    iter = m_Entries.insert(std::make_pair(name, entry)).first;
+  }
+  MemoryRegistryEntry& e = (*iter).second;
+  e.LiveBytes += bytes;
+  e.LiveAllocations++;
+  if(newAllocation == true)
+  {
+    e.Allocations++;
+  }
+  e.PeakBytes = std::max(e.PeakBytes, e.LiveBytes);
+  e.LevelPeakBytes = std::max(e.LevelPeakBytes, e.LiveBytes);
+  m_LiveBytes += bytes;
+  m_PeakBytes = std::max(m_PeakBytes, m_LiveBytes);
+  m_LevelPeakBytes = std::max(m_LevelPeakBytes, m_LiveBytes);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryRegistry::remove(const std::string& name, uint64_t bytes)
+{
+  std::map<std::string, MemoryRegistryEntry>::iterator iter = m_Entries.find(name);
+  if(iter == m_Entries.end())
+  {
+    return;
+  }
+  MemoryRegistryEntry& e = (*iter).second;
+  bytes = std::min(bytes, e.LiveBytes);
+  e.LiveBytes -= bytes;
+  if(e.LiveAllocations > 0)
+  {
+    e.LiveAllocations--;
+  }
+  m_LiveBytes -= std::min(bytes, m_LiveBytes);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryRegistry::allocated(const std::string& name, uint64_t bytes)
+{
+  MEMORY_REGISTRY_LOCK
+  add(name, bytes, true);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryRegistry::released(const std::string& name, uint64_t bytes)
+{
+  MEMORY_REGISTRY_LOCK
+  remove(name, bytes);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryRegistry::renamed(const std::string& from, const std::string& to, uint64_t bytes)
+{
+  MEMORY_REGISTRY_LOCK
+  remove(from, bytes);
+  add(to, bytes, false);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryRegistry::beginLevel(const std::string& label)
+{
+  MEMORY_REGISTRY_LOCK
+  m_Level = label;
+  m_LevelPeakBytes = m_LiveBytes;
+  for (std::map<std::string, MemoryRegistryEntry>::iterator iter = m_Entries.begin(); iter != m_Entries.end(); ++iter)
+  {
+    (*iter).second.LevelPeakBytes = (*iter).second.LiveBytes;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryRegistry::endLevel()
+{
+  MemoryRegistryLevel level;
+  level.ResidentBytes = GetResidentBytes();
+  level.PeakResidentBytes = GetPeakResidentBytes();
+  MEMORY_REGISTRY_LOCK
+  level.Label = m_Level;
+  level.PeakBytes = m_LevelPeakBytes;
+  level.EndBytes = m_LiveBytes;
+  level.Entries = m_Entries;
+  m_Levels.push_back(level);
+  m_Level = "";
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+uint64_t MemoryRegistry::getLiveBytes()
+{
+  MEMORY_REGISTRY_LOCK
+  return m_LiveBytes;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+uint64_t MemoryRegistry::getPeakBytes()
+{
+  MEMORY_REGISTRY_LOCK
+  return m_PeakBytes;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryRegistry::getEntries(std::map<std::string, MemoryRegistryEntry>& entries)
+{
+  MEMORY_REGISTRY_LOCK
+  entries = m_Entries;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryRegistry::getLevels(std::vector<MemoryRegistryLevel>& levels)
+{
+  MEMORY_REGISTRY_LOCK
+  levels = m_Levels;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryRegistry::printReport(std::ostream& out)
+{
+  MemoryRegistryLevel current;
+  current.ResidentBytes = GetResidentBytes();
+  current.PeakResidentBytes = GetPeakResidentBytes();
+  {
+    MEMORY_REGISTRY_LOCK
+    current.Label = m_Level;
+    current.PeakBytes = m_LevelPeakBytes;
+    current.EndBytes = m_LiveBytes;
+    current.Entries = m_Entries;
+  }
+  out << "Memory in use" << (current.Label.empty() ? std::string("") : std::string(" during ") + current.Label) << ": "
+      << FormatBytes(current.EndBytes) << " tracked, level peak " << FormatBytes(current.PeakBytes)
+      << ", resident " << FormatBytes(current.ResidentBytes) << " (peak " << FormatBytes(current.PeakResidentBytes) << ")" << std::endl;
+  Detail::printEntries(current.Entries, out);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryRegistry::PrintLevel(const MemoryRegistryLevel& level, std::ostream& out)
+{
+  out << "Memory used by " << level.Label << ": peak " << FormatBytes(level.PeakBytes) << " tracked, "
+      << FormatBytes(level.EndBytes) << " still alive at the end, resident " << FormatBytes(level.ResidentBytes)
+      << " (peak " << FormatBytes(level.PeakResidentBytes) << ")" << std::endl;
+  Detail::printEntries(level.Entries, out);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MemoryRegistry::writeJson(const std::string& file)
+{
+  std::vector<MemoryRegistryLevel> levels;
+  std::map<std::string, MemoryRegistryEntry> entries;
+  uint64_t liveBytes = 0;
+  uint64_t peakBytes = 0;
+  {
+    MEMORY_REGISTRY_LOCK
+    levels = m_Levels;
+    entries = m_Entries;
+    liveBytes = m_LiveBytes;
+    peakBytes = m_PeakBytes;
+  }
+
+  std::ofstream out(file.c_str(), std::ios::out | std::ios::trunc);
+  if(out.is_open() == false)
+  {
+    return -1;
+  }
+  out << "{\n";
+  out << "  \"live_bytes\": " << liveBytes << ",\n";
+  out << "  \"peak_bytes\": " << peakBytes << ",\n";
+  out << "  \"resident_bytes\": " << GetResidentBytes() << ",\n";
+  out << "  \"peak_resident_bytes\": " << GetPeakResidentBytes() << ",\n";
+  out << "  \"levels\": [";
+  for (size_t l = 0; l < levels.size(); ++l)
+  {
+    const MemoryRegistryLevel& level = levels[l];
+    out << (l == 0 ? "\n" : ",\n") << "    {\n";
+    out << "      \"label\": " << Detail::jsonString(level.Label) << ",\n";
+    out << "      \"peak_bytes\": " << level.PeakBytes << ",\n";
+    out << "      \"end_bytes\": " << level.EndBytes << ",\n";
+    out << "      \"resident_bytes\": " << level.ResidentBytes << ",\n";
+    out << "      \"peak_resident_bytes\": " << level.PeakResidentBytes << ",\n";
+    out << "      \"allocations\": ";
+    Detail::writeJsonEntries(level.Entries, out, "      ");
+    out << "\n    }";
+  }
+  out << (levels.empty() ? "],\n" : "\n  ],\n");
+  out << "  \"allocations\": ";
+  Detail::writeJsonEntries(entries, out, "  ");
+  out << "\n}\n";
+  out.close();
+  return (out.fail() == true) ? -1 : 0;
+}
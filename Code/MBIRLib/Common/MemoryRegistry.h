@@ -0,0 +1,179 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _MemoryRegistry_H_
+#define _MemoryRegistry_H_
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "MBIRLib/MBIRLib.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/spin_mutex.h>
+#endif
+
+/**
+ * @brief The bytes held under one allocation name
+ */
+typedef struct
+{
+  uint64_t LiveBytes;
+  uint64_t PeakBytes;      // Highest LiveBytes since the process started
+  uint64_t LevelPeakBytes; // Highest LiveBytes since the current level began
+  uint32_t Allocations;    // Allocations ever made under the name
+  uint32_t LiveAllocations;
+} MemoryRegistryEntry;
+
+/**
+ * @brief What a level (one resolution of a reconstruction) used when it ended
+ */
+typedef struct
+{
+  std::string Label;
+  uint64_t PeakBytes;     // Highest total of the tracked allocations during the level
+  uint64_t EndBytes;      // Tracked bytes still alive when the level ended
+  uint64_t ResidentBytes; // Process RSS when the level ended
+  uint64_t PeakResidentBytes;
+  std::map<std::string, MemoryRegistryEntry> Entries;
+} MemoryRegistryLevel;
+
+/**
+ * @class MemoryRegistry MemoryRegistry.h MBIRLib/Common/MemoryRegistry.h
+ * @brief Process wide accounting of the memory held by TomoArrays. Every array
+ * reports its bytes under the name it was created with, so a report shows which
+ * structure uses the memory without running under a memory profiler.
+ *
+ * The multi resolution driver marks each resolution as a level. The per level
+ * peaks are kept after the level ends for the report and the JSON dump. All the
+ * methods may be called from any thread.
+ */
+class MBIRLib_EXPORT MemoryRegistry
+{
+  public:
+    /**
+     * @brief The registry of the process
+     */
+    static MemoryRegistry* Instance();
+
+    /**
+     * @brief Formats a byte count with a binary unit (KB, MB, ...)
+     */
+    static std::string FormatBytes(uint64_t bytes);
+
+    /**
+     * @brief The resident set size of the process, 0 where it is not known
+     */
+    static uint64_t GetResidentBytes();
+
+    /**
+     * @brief The highest resident set size of the process, 0 where it is not known
+     */
+    static uint64_t GetPeakResidentBytes();
+
+    void allocated(const std::string& name, uint64_t bytes);
+    void released(const std::string& name, uint64_t bytes);
+
+    /**
+     * @brief Moves the bytes of a live allocation to another name
+     */
+    void renamed(const std::string& from, const std::string& to, uint64_t bytes);
+
+    /**
+     * @brief Starts a level. The level peaks restart from what is alive now.
+     */
+    void beginLevel(const std::string& label);
+
+    /**
+     * @brief Ends the current level and keeps its peaks
+     */
+    void endLevel();
+
+    uint64_t getLiveBytes();
+    uint64_t getPeakBytes();
+
+    /**
+     * @brief Copies the entries of all the names
+     */
+    void getEntries(std::map<std::string, MemoryRegistryEntry>& entries);
+
+    /**
+     * @brief Copies the levels that have ended
+     */
+    void getLevels(std::vector<MemoryRegistryLevel>& levels);
+
+    /**
+     * @brief Prints what is alive now and the peaks of the current level
+     */
+    void printReport(std::ostream& out);
+
+    /**
+     * @brief Prints the peaks of a level that has ended
+     */
+    static void PrintLevel(const MemoryRegistryLevel& level, std::ostream& out);
+
+    /**
+     * @brief Writes the ended levels and the current state as JSON
+     * @return 0 on success, a negative value if the file could not be written
+     */
+    int writeJson(const std::string& file);
+
+    virtual ~MemoryRegistry();
+
+  protected:
+    MemoryRegistry();
+
+  private:
+    std::map<std::string, MemoryRegistryEntry> m_Entries;
+    std::vector<MemoryRegistryLevel> m_Levels;
+    std::string m_Level;
+    uint64_t m_LiveBytes;
+    uint64_t m_PeakBytes;
+    uint64_t m_LevelPeakBytes;
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    tbb::spin_mutex m_Mutex;
+#endif
+
+    void add(const std::string& name, uint64_t bytes, bool newAllocation);
+    void remove(const std::string& name, uint64_t bytes);
+
+    MemoryRegistry(const MemoryRegistry&); // Copy Constructor Not Implemented
+    void operator=(const MemoryRegistry&); // Operator '=' Not Implemented
+};
+
+#endif /* _MemoryRegistry_H_ */
@@ -0,0 +1,100 @@
+/* ============================================================================
+ * Copyright (c) 2012 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2012 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "RadixQuantile.h"
+
+#include <string.h>
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_scheduler_init.h>
+#endif
+
+namespace Detail
+{
+  const RadixQuantile::KeyType k_SignBit = static_cast<RadixQuantile::KeyType>(1) << 63;
+  const size_t k_MinChunkSize = 65536;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+RadixQuantile::RadixQuantile()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+RadixQuantile::~RadixQuantile()
+{
+}
+
+// -----------------------------------------------------------------------------
+// Positive values get the sign bit set, negative values have every bit flipped
+// so that both the sign and the magnitude order come out right
+// -----------------------------------------------------------------------------
+RadixQuantile::KeyType RadixQuantile::encode(double value)
+{
+  KeyType bits;
+  ::memcpy(&bits, &value, sizeof(bits));
+  return (bits & Detail::k_SignBit) ? ~bits : (bits | Detail::k_SignBit);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+double RadixQuantile::decode(KeyType key)
+{
+  KeyType bits = (key & Detail::k_SignBit) ? (key & ~Detail::k_SignBit) : ~key;
+  double value;
+  ::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// -----------------------------------------------------------------------------
+// One chunk per thread, but never so many that a chunk's histogram is larger
+// than the data it covers
+// -----------------------------------------------------------------------------
+size_t RadixQuantile::getNumberOfChunks(size_t count)
+{
+  size_t numChunks = 1;
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  tbb::task_scheduler_init init;
+  numChunks = init.default_num_threads();
+#endif
+  numChunks = std::min(numChunks, count / Detail::k_MinChunkSize);
+  return std::max(numChunks, static_cast<size_t>(1));
+}
@@ -0,0 +1,254 @@
+/* ============================================================================
+ * Copyright (c) 2012 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2012 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _RadixQuantile_H_
+#define _RadixQuantile_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "MBIRLib/MBIRLib.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_group.h>
+#endif
+
+/**
+ * @class RadixQuantile RadixQuantile.h MBIRLib/Common/RadixQuantile.h
+ * @brief Finds an order statistic of a large set of values without copying the
+ * values. The doubles are mapped to order preserving 64 bit keys and the key is
+ * resolved 16 bits at a time with a histogram of the values that match the
+ * digits found so far. As soon as the matching values are few enough they are
+ * gathered and the exact value is selected from them, so the usual case is two
+ * passes over the data. Memory is bounded by one histogram per chunk of the
+ * data plus k_MaxCandidates values.
+ *
+ * The values are supplied by a Source, any copyable object with
+ * double operator()(size_t index) const. It is called concurrently from
+ * several threads when the parallel algorithms are enabled.
+ * @author Michael A. Jackson for BlueQuartz Software
+ * @author Singanallur Venkatakrishnan (Purdue University)
+ * @version 1.0
+ */
+class MBIRLib_EXPORT RadixQuantile
+{
+  public:
+    typedef uint64_t KeyType;
+    static const unsigned int k_DigitBits = 16;
+    static const size_t k_NumBins = 65536;
+    static const size_t k_MaxCandidates = 65536;
+
+    virtual ~RadixQuantile();
+
+    /**
+     * @brief Returns the value that would be at position rank if the count values
+     * of the source were sorted in ascending order. rank is clamped to count - 1.
+     * Returns 0 if count is 0.
+     */
+    template<typename Source>
+    static double select(const Source& source, size_t count, size_t rank)
+    {
+      if (count == 0) { return 0.0; }
+      if (rank >= count) { rank = count - 1; }
+
+      size_t numChunks = getNumberOfChunks(count);
+      KeyType prefix = 0;
+      KeyType prefixMask = 0;
+      std::vector<std::vector<size_t> > histograms(numChunks);
+      for (int shift = 64 - k_DigitBits; shift >= 0; shift -= k_DigitBits)
+      {
+        std::vector<HistogramTask<Source> > tasks;
+        for (size_t c = 0; c < numChunks; c++)
+        {
+          histograms[c].assign(k_NumBins, 0);
+          tasks.push_back(HistogramTask<Source>(&source, chunkStart(c, numChunks, count), chunkStart(c + 1, numChunks, count),
+                                                prefix, prefixMask, shift, &(histograms[c])));
+        }
+        runTasks(tasks);
+
+        // Find the digit whose bin holds the rank
+        size_t digit = 0;
+        size_t binCount = 0;
+        for (digit = 0; digit < k_NumBins; digit++)
+        {
+          binCount = 0;
+          for (size_t c = 0; c < numChunks; c++) { binCount += histograms[c][digit]; }
+          if (rank < binCount) { break; }
+          rank -= binCount;
+        }
+        prefix |= static_cast<KeyType>(digit) << shift;
+        prefixMask |= static_cast<KeyType>(k_NumBins - 1) << shift;
+        if (shift == 0) { break; }
+
+        if (binCount <= k_MaxCandidates)
+        {
+          std::vector<std::vector<KeyType> > candidates(numChunks);
+          std::vector<CollectTask<Source> > collectors;
+          for (size_t c = 0; c < numChunks; c++)
+          {
+            collectors.push_back(CollectTask<Source>(&source, chunkStart(c, numChunks, count), chunkStart(c + 1, numChunks, count),
+                                                     prefix, prefixMask, &(candidates[c])));
+          }
+          runTasks(collectors);
+          std::vector<KeyType> keys;
+          keys.reserve(binCount);
+          for (size_t c = 0; c < numChunks; c++)
+          {
+            keys.insert(keys.end(), candidates[c].begin(), candidates[c].end());
+          }
+          std::nth_element(keys.begin(), keys.begin() + rank, keys.end());
+          return decode(keys[rank]);
+        }
+      }
+      return decode(prefix);
+    }
+
+    /**
+     * @brief Returns the value below which the given fraction (0 to 1) of the
+     * count values of the source lie.
+     */
+    template<typename Source>
+    static double quantile(const Source& source, size_t count, double fraction)
+    {
+      if (fraction < 0.0) { fraction = 0.0; }
+      size_t rank = static_cast<size_t>(fraction * count);
+      return select(source, count, rank);
+    }
+
+    /**
+     * @brief Maps a double to an unsigned key with the same ordering
+     */
+    static KeyType encode(double value);
+
+    /**
+     * @brief Inverse of encode
+     */
+    static double decode(KeyType key);
+
+  protected:
+    RadixQuantile();
+
+  private:
+    template<typename Source>
+    class HistogramTask
+    {
+      public:
+        HistogramTask(const Source* source, size_t start, size_t end, KeyType prefix, KeyType prefixMask,
+                      int shift, std::vector<size_t>* histogram) :
+          m_Source(source), m_Start(start), m_End(end), m_Prefix(prefix), m_PrefixMask(prefixMask),
+          m_Shift(shift), m_Histogram(histogram) {}
+
+        void operator()() const
+        {
+          size_t* bins = &((*m_Histogram)[0]);
+          for (size_t i = m_Start; i < m_End; i++)
+          {
+            KeyType key = encode((*m_Source)(i));
+            if ((key & m_PrefixMask) == m_Prefix)
+            {
+              bins[(key >> m_Shift) & (k_NumBins - 1)]++;
+            }
+          }
+        }
+      private:
+        const Source* m_Source;
+        size_t m_Start;
+        size_t m_End;
+        KeyType m_Prefix;
+        KeyType m_PrefixMask;
+        int m_Shift;
+        std::vector<size_t>* m_Histogram;
+    };
+
+    template<typename Source>
+    class CollectTask
+    {
+      public:
+        CollectTask(const Source* source, size_t start, size_t end, KeyType prefix, KeyType prefixMask,
+                    std::vector<KeyType>* keys) :
+          m_Source(source), m_Start(start), m_End(end), m_Prefix(prefix), m_PrefixMask(prefixMask), m_Keys(keys) {}
+
+        void operator()() const
+        {
+          for (size_t i = m_Start; i < m_End; i++)
+          {
+            KeyType key = encode((*m_Source)(i));
+            if ((key & m_PrefixMask) == m_Prefix)
+            {
+              m_Keys->push_back(key);
+            }
+          }
+        }
+      private:
+        const Source* m_Source;
+        size_t m_Start;
+        size_t m_End;
+        KeyType m_Prefix;
+        KeyType m_PrefixMask;
+        std::vector<KeyType>* m_Keys;
+    };
+
+    template<typename Task>
+    static void runTasks(const std::vector<Task>& tasks)
+    {
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+      tbb::task_group* g = new tbb::task_group;
+      for (size_t i = 0; i < tasks.size(); i++)
+      {
+        g->run(tasks[i]);
+      }
+      g->wait(); // Wait for all the threads to complete before moving on.
+      delete g;
+#else
+      for (size_t i = 0; i < tasks.size(); i++)
+      {
+        tasks[i]();
+      }
+#endif
+    }
+
+    static size_t getNumberOfChunks(size_t count);
+
+    static size_t chunkStart(size_t chunk, size_t numChunks, size_t count)
+    {
+      return (count / numChunks) * chunk + std::min(chunk, count % numChunks);
+    }
+
+    RadixQuantile(const RadixQuantile&); // Copy Constructor Not Implemented
+    void operator=(const RadixQuantile&); // Operator '=' Not Implemented
+};
+
+#endif /* _RadixQuantile_H_ */
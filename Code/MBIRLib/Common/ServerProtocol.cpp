@@ -0,0 +1,769 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "ServerProtocol.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iomanip>
+#include <sstream>
+
+#if !defined (_MSC_VER)
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#endif
+
+#if defined (MSG_NOSIGNAL)
+#define MBIR_SOCKET_FLAGS MSG_NOSIGNAL
+#else
+#define MBIR_SOCKET_FLAGS 0
+#endif
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#define SERVER_CONNECTION_LOCK tbb::spin_mutex::scoped_lock connectionLock(m_WriteMutex);
+#else
+#define SERVER_CONNECTION_LOCK
+#endif
+
+/* Longest line a peer may send before the connection is dropped */
+#define MBIR_MAX_MESSAGE_BYTES (1024 * 1024)
+
+namespace Detail
+{
+  // -----------------------------------------------------------------------------
+  //
+  // -----------------------------------------------------------------------------
+  void writeJsonString(std::ostream& out, const std::string& value)
+  {
+    out << '"';
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+      unsigned char c = static_cast<unsigned char>(value[i]);
+      switch(c)
+      {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        case '\r': out << "\\r"; break;
+        case '\t': out << "\\t"; break;
+        default:
+          if(c < 0x20)
+          {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned int>(c));
+            out << buf;
+          }
+          else
+          {
+            out << value[i];
+          }
+      }
+    }
+    out << '"';
+  }
+
+  /**
+   * @brief Reads the few parts of JSON a ServerMessage is made of
+   */
+  class JsonReader
+  {
+    public:
+      JsonReader(const std::string& text) : m_Text(text), m_Pos(0) {}
+
+      void skipSpace()
+      {
+        while (m_Pos < m_Text.size() && (m_Text[m_Pos] == ' ' || m_Text[m_Pos] == '\t'
+                                         || m_Text[m_Pos] == '\r' || m_Text[m_Pos] == '\n'))
+        {
+          ++m_Pos;
+        }
+      }
+
+      bool atEnd()
+      {
+        skipSpace();
+        return m_Pos >= m_Text.size();
+      }
+
+      char peek()
+      {
+        skipSpace();
+        return (m_Pos < m_Text.size()) ? m_Text[m_Pos] : '\0';
+      }
+
+      bool expect(char c)
+      {
+        if(peek() != c)
+        {
+          return false;
+        }
+        ++m_Pos;
+        return true;
+      }
+
+      bool literal(const char* word)
+      {
+        skipSpace();
+        size_t n = strlen(word);
+        if(m_Text.compare(m_Pos, n, word) != 0)
+        {
+          return false;
+        }
+        m_Pos += n;
+        return true;
+      }
+
+      bool readString(std::string& value)
+      {
+        if(expect('"') == false)
+        {
+          return false;
+        }
+        value.clear();
+        while (m_Pos < m_Text.size())
+        {
+          char c = m_Text[m_Pos++];
+          if(c == '"')
+          {
+            return true;
+          }
+          if(c != '\\')
+          {
+            value.push_back(c);
+            continue;
+          }
+          if(m_Pos >= m_Text.size())
+          {
+            return false;
+          }
+          c = m_Text[m_Pos++];
+          switch(c)
+          {
+            case '"': value.push_back('"'); break;
+            case '\\': value.push_back('\\'); break;
+            case '/': value.push_back('/'); break;
+            case 'b': value.push_back('\b'); break;
+            case 'f': value.push_back('\f'); break;
+            case 'n': value.push_back('\n'); break;
+            case 'r': value.push_back('\r'); break;
+            case 't': value.push_back('\t'); break;
+            case 'u':
+            {
+              if(m_Pos + 4 > m_Text.size())
+              {
+                return false;
+              }
+              unsigned int code = 0;
+              if(sscanf(m_Text.substr(m_Pos, 4).c_str(), "%4x", &code) != 1)
+              {
+                return false;
+              }
+              m_Pos += 4;
+              // UTF-8 encode the code point. Surrogate pairs are not combined.
+              if(code < 0x80)
+              {
+                value.push_back(static_cast<char>(code));
+              }
+              else if(code < 0x800)
+              {
+                value.push_back(static_cast<char>(0xC0 | (code >> 6)));
+                value.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+              }
+              else
+              {
+                value.push_back(static_cast<char>(0xE0 | (code >> 12)));
+                value.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+                value.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+              }
+              break;
+            }
+            default:
+              return false;
+          }
+        }
+        return false;
+      }
+
+      bool readNumber(double& value)
+      {
+        skipSpace();
+        const char* start = m_Text.c_str() + m_Pos;
+        char* end = NULL;
+        value = strtod(start, &end);
+        if(end == start)
+        {
+          return false;
+        }
+        m_Pos += static_cast<size_t>(end - start);
+        return true;
+      }
+
+    private:
+      const std::string& m_Text;
+      size_t m_Pos;
+  };
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+ServerMessage::ServerMessage()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+ServerMessage::~ServerMessage()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+ServerMessage::Value& ServerMessage::insert(const std::string& key, ValueType type)
+{
+  if(m_Values.find(key) == m_Values.end())
+  {
+    m_Keys.push_back(key);
+  }
+  Value& v = m_Values[key];
+  v.type = type;
+  v.text.clear();
+  v.number = 0.0;
+  v.strings.clear();
+  return v;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ServerMessage::setString(const std::string& key, const std::string& value)
+{
+  insert(key, StringValue).text = value;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ServerMessage::setNumber(const std::string& key, double value)
+{
+  insert(key, NumberValue).number = value;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ServerMessage::setBool(const std::string& key, bool value)
+{
+  insert(key, BoolValue).number = value ? 1.0 : 0.0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ServerMessage::setStrings(const std::string& key, const std::vector<std::string>& values)
+{
+  insert(key, StringArrayValue).strings = values;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool ServerMessage::has(const std::string& key) const
+{
+  return m_Values.find(key) != m_Values.end();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::string ServerMessage::getString(const std::string& key, const std::string& fallback) const
+{
+  std::map<std::string, Value>::const_iterator iter = m_Values.find(key);
+  if(iter == m_Values.end() || (*iter).second.type != StringValue)
+  {
+    return fallback;
+  }
+  return (*iter).second.text;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+double ServerMessage::getNumber(const std::string& key, double fallback) const
+{
+  std::map<std::string, Value>::const_iterator iter = m_Values.find(key);
+  if(iter == m_Values.end() || (*iter).second.type != NumberValue)
+  {
+    return fallback;
+  }
+  return (*iter).second.number;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool ServerMessage::getBool(const std::string& key, bool fallback) const
+{
+  std::map<std::string, Value>::const_iterator iter = m_Values.find(key);
+  if(iter == m_Values.end() || (*iter).second.type != BoolValue)
+  {
+    return fallback;
+  }
+  return (*iter).second.number != 0.0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::vector<std::string> ServerMessage::getStrings(const std::string& key) const
+{
+  std::map<std::string, Value>::const_iterator iter = m_Values.find(key);
+  if(iter == m_Values.end() || (*iter).second.type != StringArrayValue)
+  {
+    return std::vector<std::string>();
+  }
+  return (*iter).second.strings;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::string ServerMessage::toJson() const
+{
+  std::stringstream ss;
+  ss << std::setprecision(15) << "{";
+  for (size_t k = 0; k < m_Keys.size(); ++k)
+  {
+    const Value& v = (*m_Values.find(m_Keys[k])).second;
+    if(k > 0)
+    {
+      ss << ",";
+    }
+    Detail::writeJsonString(ss, m_Keys[k]);
+    ss << ":";
+    switch(v.type)
+    {
+      case StringValue:
+        Detail::writeJsonString(ss, v.text);
+        break;
+      case NumberValue:
+        ss << v.number;
+        break;
+      case BoolValue:
+        ss << (v.number != 0.0 ? "true" : "false");
+        break;
+      case StringArrayValue:
+        ss << "[";
+        for (size_t i = 0; i < v.strings.size(); ++i)
+        {
+          if(i > 0)
+          {
+            ss << ",";
+          }
+          Detail::writeJsonString(ss, v.strings[i]);
+        }
+        ss << "]";
+        break;
+    }
+  }
+  ss << "}";
+  return ss.str();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int ServerMessage::FromJson(const std::string& line, ServerMessage& message)
+{
+  message = ServerMessage();
+  Detail::JsonReader reader(line);
+  if(reader.expect('{') == false)
+  {
+    return -1;
+  }
+  if(reader.expect('}') == true)
+  {
+    return reader.atEnd() ? 0 : -1;
+  }
+  while (true)
+  {
+    std::string key;
+    if(reader.readString(key) == false || reader.expect(':') == false)
+    {
+      return -1;
+    }
+    char c = reader.peek();
+    if(c == '"')
+    {
+      std::string value;
+      if(reader.readString(value) == false)
+      {
+        return -1;
+      }
+      message.setString(key, value);
+    }
+    else if(c == '[')
+    {
+      // Arrays hold strings. Numbers are kept as they were written.
+      reader.expect('[');
+      std::vector<std::string> values;
+      if(reader.expect(']') == false)
+      {
+        while (true)
+        {
+          std::string value;
+          double number = 0.0;
+          if(reader.peek() == '"')
+          {
+            if(reader.readString(value) == false)
+            {
+              return -1;
+            }
+          }
+          else if(reader.readNumber(number) == true)
+          {
+            std::stringstream ss;
+            ss << std::setprecision(15) << number;
+            value = ss.str();
+          }
+          else
+          {
+            return -1;
+          }
+          values.push_back(value);
+          if(reader.expect(']') == true)
+          {
+            break;
+          }
+          if(reader.expect(',') == false)
+          {
+            return -1;
+          }
+        }
+      }
+      message.setStrings(key, values);
+    }
+    else if(reader.literal("true") == true)
+    {
+      message.setBool(key, true);
+    }
+    else if(reader.literal("false") == true)
+    {
+      message.setBool(key, false);
+    }
+    else if(reader.literal("null") == true)
+    {
+      // A null value is the same as a missing key
+    }
+    else
+    {
+      double number = 0.0;
+      if(reader.readNumber(number) == false)
+      {
+        return -1;
+      }
+      message.setNumber(key, number);
+    }
+
+    if(reader.expect('}') == true)
+    {
+      break;
+    }
+    if(reader.expect(',') == false)
+    {
+      return -1;
+    }
+  }
+  return reader.atEnd() ? 0 : -1;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+ServerConnection::ServerConnection() :
+  m_ErrorMessage(""),
+  m_SendTimeout(10),
+  m_Socket(-1)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int ServerConnection::fail(const std::string& message)
+{
+  std::stringstream ss;
+  ss << message;
+  if(errno != 0)
+  {
+    ss << " (" << strerror(errno) << ")";
+  }
+  setErrorMessage(ss.str());
+  return -1;
+}
+
+#if defined (_MSC_VER)
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+ServerConnection::~ServerConnection()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int ServerConnection::connect(const std::string& path)
+{
+  setErrorMessage("The reconstruction server is not available on Windows");
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ServerConnection::attach(int socket)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ServerConnection::close()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool ServerConnection::isOpen()
+{
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int ServerConnection::writeMessage(const ServerMessage& message)
+{
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int ServerConnection::readMessage(ServerMessage& message)
+{
+  return -1;
+}
+
+#else
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+ServerConnection::~ServerConnection()
+{
+  if(m_Socket >= 0)
+  {
+    ::close(m_Socket);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int ServerConnection::connect(const std::string& path)
+{
+  errno = 0;
+  struct sockaddr_un address;
+  ::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if(path.size() >= sizeof(address.sun_path))
+  {
+    return fail("The socket path is too long: " + path);
+  }
+  ::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  int s = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if(s < 0)
+  {
+    return fail("Could not create a socket");
+  }
+  if(::connect(s, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0)
+  {
+    fail("Could not connect to " + path);
+    ::close(s);
+    return -1;
+  }
+  attach(s);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ServerConnection::attach(int socket)
+{
+  if(m_Socket >= 0)
+  {
+    ::close(m_Socket);
+  }
+  m_Socket = socket;
+  m_ReadBuffer.clear();
+  // A client that stops reading must not stall the reconstruction writing to it
+  struct timeval timeout;
+  timeout.tv_sec = m_SendTimeout;
+  timeout.tv_usec = 0;
+  ::setsockopt(m_Socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ServerConnection::close()
+{
+  SERVER_CONNECTION_LOCK
+  if(m_Socket >= 0)
+  {
+    // The descriptor stays valid until the destructor so a thread blocked in
+    // readMessage() wakes up instead of reading from a reused descriptor.
+    ::shutdown(m_Socket, SHUT_RDWR);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool ServerConnection::isOpen()
+{
+  return m_Socket >= 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int ServerConnection::writeMessage(const ServerMessage& message)
+{
+  std::string line = message.toJson();
+  line.push_back('\n');
+  SERVER_CONNECTION_LOCK
+  if(m_Socket < 0)
+  {
+    errno = 0;
+    return fail("Not connected");
+  }
+  const char* p = line.c_str();
+  size_t bytes = line.size();
+  while (bytes > 0)
+  {
+    ssize_t n = ::send(m_Socket, p, bytes, MBIR_SOCKET_FLAGS);
+    if(n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if(n <= 0)
+    {
+      fail("Could not send a message");
+      ::shutdown(m_Socket, SHUT_RDWR);
+      return -1;
+    }
+    p += n;
+    bytes -= static_cast<size_t>(n);
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int ServerConnection::readMessage(ServerMessage& message)
+{
+  if(m_Socket < 0)
+  {
+    errno = 0;
+    return fail("Not connected");
+  }
+  while (true)
+  {
+    std::string::size_type end = m_ReadBuffer.find('\n');
+    if(end != std::string::npos)
+    {
+      std::string line = m_ReadBuffer.substr(0, end);
+      m_ReadBuffer.erase(0, end + 1);
+      if(line.find_first_not_of(" \t\r") == std::string::npos)
+      {
+        continue;
+      }
+      if(ServerMessage::FromJson(line, message) < 0)
+      {
+        errno = 0;
+        fail("Could not parse the message: " + line);
+        return -2;
+      }
+      return 1;
+    }
+    if(m_ReadBuffer.size() > MBIR_MAX_MESSAGE_BYTES)
+    {
+      errno = 0;
+      return fail("The message is too long");
+    }
+    char buf[4096];
+    ssize_t n = ::recv(m_Socket, buf, sizeof(buf), 0);
+    if(n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if(n == 0)
+    {
+      return 0;
+    }
+    if(n < 0)
+    {
+      return fail("Could not receive a message");
+    }
+    m_ReadBuffer.append(buf, static_cast<size_t>(n));
+  }
+}
+
+#endif
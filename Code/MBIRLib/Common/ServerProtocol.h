@@ -0,0 +1,178 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _ServerProtocol_H_
+#define _ServerProtocol_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/spin_mutex.h>
+#endif
+
+/**
+ * @class ServerMessage ServerProtocol.h MBIRLib/Common/ServerProtocol.h
+ * @brief One message of the reconstruction server protocol. A message is a
+ * flat JSON object whose values are strings, numbers, booleans or arrays of
+ * strings, written on a single line. Nested objects are not supported.
+ */
+class MBIRLib_EXPORT ServerMessage
+{
+  public:
+    ServerMessage();
+    virtual ~ServerMessage();
+
+    void setString(const std::string& key, const std::string& value);
+    void setNumber(const std::string& key, double value);
+    void setBool(const std::string& key, bool value);
+    void setStrings(const std::string& key, const std::vector<std::string>& values);
+
+    bool has(const std::string& key) const;
+
+    /* The getters return the fallback if the key is missing or has a different type */
+    std::string getString(const std::string& key, const std::string& fallback = std::string("")) const;
+    double getNumber(const std::string& key, double fallback = 0.0) const;
+    bool getBool(const std::string& key, bool fallback = false) const;
+    std::vector<std::string> getStrings(const std::string& key) const;
+
+    /**
+     * @brief Writes the message as one line of JSON without the line break
+     */
+    std::string toJson() const;
+
+    /**
+     * @brief Parses one line of JSON into message
+     * @return Negative if the line is not a flat JSON object
+     */
+    static int FromJson(const std::string& line, ServerMessage& message);
+
+  private:
+    enum ValueType
+    {
+      StringValue,
+      NumberValue,
+      BoolValue,
+      StringArrayValue
+    };
+
+    struct Value
+    {
+      ValueType type;
+      std::string text;
+      double number;
+      std::vector<std::string> strings;
+    };
+
+    Value& insert(const std::string& key, ValueType type);
+
+    std::vector<std::string> m_Keys;
+    std::map<std::string, Value> m_Values;
+};
+
+/**
+ * @class ServerConnection ServerProtocol.h MBIRLib/Common/ServerProtocol.h
+ * @brief One end of a UNIX domain socket connection that carries
+ * ServerMessages, one per line. Several threads may write to the same
+ * connection; only one thread may read from it.
+ *
+ * This is not available on Windows.
+ */
+class MBIRLib_EXPORT ServerConnection
+{
+  public:
+    MXA_SHARED_POINTERS(ServerConnection)
+    MXA_TYPE_MACRO(ServerConnection)
+    MXA_STATIC_NEW_MACRO(ServerConnection)
+
+    virtual ~ServerConnection();
+
+    MXA_INSTANCE_STRING_PROPERTY(ErrorMessage)
+    /* Seconds a write may block on a client that does not read */
+    MXA_INSTANCE_PROPERTY(int, SendTimeout)
+
+    /**
+     * @brief Connects to the server listening on path
+     * @return Negative on Error.
+     */
+    int connect(const std::string& path);
+
+    /**
+     * @brief Takes ownership of a socket that was already accepted
+     */
+    void attach(int socket);
+
+    /**
+     * @brief Shuts the socket down. Later reads and writes fail.
+     */
+    void close();
+    bool isOpen();
+
+    /**
+     * @brief Sends one message. A failed write closes the connection.
+     * @return Negative on Error.
+     */
+    int writeMessage(const ServerMessage& message);
+
+    /**
+     * @brief Blocks until a complete message arrived
+     * @return 1 if message was read, 0 if the peer hung up, -2 if the line was
+     * not a valid message and -1 if the connection failed
+     */
+    int readMessage(ServerMessage& message);
+
+  protected:
+    ServerConnection();
+
+    int fail(const std::string& message);
+
+  private:
+    int m_Socket;
+    std::string m_ReadBuffer;
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    tbb::spin_mutex m_WriteMutex;
+#endif
+
+    ServerConnection(const ServerConnection&); // Copy Constructor Not Implemented
+    void operator=(const ServerConnection&); // Operator '=' Not Implemented
+};
+
+#endif /* _ServerProtocol_H_ */
@@ -0,0 +1,137 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "SinogramBufferPool.h"
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+SinogramBufferPool::SinogramBufferPool()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+SinogramBufferPool::~SinogramBufferPool()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+RealVolumeType::Pointer SinogramBufferPool::acquire(size_t* dims, const std::string& name)
+{
+  size_t total = dims[0] * dims[1] * dims[2];
+
+  // The smallest buffer that is large enough, otherwise the largest one grows
+  // so the pool never holds a buffer next to its replacement
+  size_t best = m_Buffers.size();
+  for (size_t i = 0; i < m_Buffers.size(); ++i)
+  {
+    size_t capacity = m_Buffers[i]->getCapacity();
+    if(best == m_Buffers.size())
+    {
+      best = i;
+      continue;
+    }
+    size_t bestCapacity = m_Buffers[best]->getCapacity();
+    bool fits = (capacity >= total);
+    bool bestFits = (bestCapacity >= total);
+    if((fits == true && (bestFits == false || capacity < bestCapacity))
+        || (fits == false && bestFits == false && capacity > bestCapacity))
+    {
+      best = i;
+    }
+  }
+
+  RealVolumeType::Pointer buffer;
+  if(best < m_Buffers.size())
+  {
+    buffer = m_Buffers[best];
+    m_Buffers.erase(m_Buffers.begin() + best);
+    // Named first so the memory a growing buffer takes is accounted to its new user
+    buffer->setName(name);
+    if(buffer->reshape(dims) == false)
+    {
+      return RealVolumeType::NullPointer();
+    }
+  }
+  else
+  {
+    buffer = RealVolumeType::New(dims, name);
+    if(NULL == buffer->d)
+    {
+      return RealVolumeType::NullPointer();
+    }
+  }
+  return buffer;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void SinogramBufferPool::release(RealVolumeType::Pointer& buffer)
+{
+  if(NULL != buffer.get() && buffer.unique() == true)
+  {
+    // The memory report shows what the pool holds on to under its own name
+    buffer->setName("SinogramBufferPool");
+    m_Buffers.push_back(buffer);
+  }
+  buffer = RealVolumeType::NullPointer();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void SinogramBufferPool::clear()
+{
+  m_Buffers.clear();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+uint64_t SinogramBufferPool::getPooledBytes()
+{
+  uint64_t bytes = 0;
+  for (size_t i = 0; i < m_Buffers.size(); ++i)
+  {
+    bytes += static_cast<uint64_t>(m_Buffers[i]->getCapacity()) * sizeof(Real_t);
+  }
+  return bytes;
+}
@@ -0,0 +1,99 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _SinogramBufferPool_H_
+#define _SinogramBufferPool_H_
+
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/TomoArray.hpp"
+
+/**
+ * @class SinogramBufferPool SinogramBufferPool.h MBIRLib/Common/SinogramBufferPool.h
+ * @brief Keeps sinogram sized buffers that are done with so the next user of
+ * a buffer gets the memory back instead of a new allocation. The multi
+ * resolution driver shares one pool between the engines of all resolutions.
+ *
+ * A buffer is handed out by acquire() and given back by release(). Buffers in
+ * the pool stay allocated until clear() is called, which an engine does once
+ * it holds everything it needs so the pool never adds to its peak.
+ */
+class MBIRLib_EXPORT SinogramBufferPool
+{
+  public:
+    MXA_SHARED_POINTERS(SinogramBufferPool)
+    MXA_TYPE_MACRO(SinogramBufferPool)
+    MXA_STATIC_NEW_MACRO(SinogramBufferPool)
+
+    virtual ~SinogramBufferPool();
+
+    /**
+     * @brief Hands out a buffer with the given dimensions. The values are undefined.
+     * @return The buffer or a NullPointer if the memory could not be allocated
+     */
+    RealVolumeType::Pointer acquire(size_t* dims, const std::string& name);
+
+    /**
+     * @brief Gives a buffer back to the pool and clears the pointer. A buffer
+     * that is still referenced elsewhere is only let go of.
+     */
+    void release(RealVolumeType::Pointer& buffer);
+
+    /**
+     * @brief Frees the buffers in the pool
+     */
+    void clear();
+
+    /**
+     * @brief The bytes held by the buffers in the pool
+     */
+    uint64_t getPooledBytes();
+
+  protected:
+    SinogramBufferPool();
+
+  private:
+    std::vector<RealVolumeType::Pointer> m_Buffers;
+
+    SinogramBufferPool(const SinogramBufferPool&); // Copy Constructor Not Implemented
+    void operator=(const SinogramBufferPool&); // Operator '=' Not Implemented
+};
+
+#endif /* _SinogramBufferPool_H_ */
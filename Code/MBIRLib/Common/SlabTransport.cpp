@@ -0,0 +1,148 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "SlabTransport.h"
+
+#include <algorithm>
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+SlabTransport::SlabTransport() :
+  m_ErrorMessage("")
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+SlabTransport::~SlabTransport()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int SlabTransport::sendReceive(int peer, const void* sendData, void* receiveData, size_t bytes)
+{
+  int err = 0;
+  if(getRank() < peer)
+  {
+    err = send(peer, sendData, bytes);
+    if(err >= 0)
+    {
+      err = receive(peer, receiveData, bytes);
+    }
+  }
+  else
+  {
+    err = receive(peer, receiveData, bytes);
+    if(err >= 0)
+    {
+      err = send(peer, sendData, bytes);
+    }
+  }
+  return err;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int SlabTransport::barrier()
+{
+  std::vector<Real_t> nothing;
+  return allReduceSum(nothing);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int SlabTransport::allReduceSum(std::vector<Real_t>& values)
+{
+  int size = getSize();
+  if(size < 2)
+  {
+    return 0;
+  }
+  // An empty message still has to go through so a barrier waits for everyone
+  size_t count = values.size();
+  size_t bytes = count * sizeof(Real_t);
+  std::vector<Real_t> buffer(count + 1, 0.0);
+  int err = 0;
+  // The sum is built aside so a failed transfer leaves the values untouched
+  if(getRank() == 0)
+  {
+    std::vector<Real_t> sum(values);
+    for (int peer = 1; peer < size; ++peer)
+    {
+      err = receive(peer, &(buffer.front()), bytes + sizeof(Real_t));
+      if(err < 0)
+      {
+        return err;
+      }
+      for (size_t i = 0; i < count; ++i)
+      {
+        sum[i] += buffer[i];
+      }
+    }
+    std::copy(sum.begin(), sum.end(), buffer.begin());
+    for (int peer = 1; peer < size; ++peer)
+    {
+      err = send(peer, &(buffer.front()), bytes + sizeof(Real_t));
+      if(err < 0)
+      {
+        return err;
+      }
+    }
+    values.swap(sum);
+  }
+  else
+  {
+    std::copy(values.begin(), values.end(), buffer.begin());
+    err = send(0, &(buffer.front()), bytes + sizeof(Real_t));
+    if(err < 0)
+    {
+      return err;
+    }
+    err = receive(0, &(buffer.front()), bytes + sizeof(Real_t));
+    if(err < 0)
+    {
+      return err;
+    }
+    std::copy(buffer.begin(), buffer.begin() + count, values.begin());
+  }
+  return 0;
+}
@@ -0,0 +1,107 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _SlabTransport_H_
+#define _SlabTransport_H_
+
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Reconstruction/ReconstructionConstants.h"
+
+/**
+ * @class SlabTransport SlabTransport.h MBIRLib/Common/SlabTransport.h
+ * @brief Moves data between the worker processes of a distributed
+ * reconstruction. Every worker has a rank from 0 to getSize() - 1 and owns the
+ * Y slab with the same index. Subclasses only move bytes between two ranks.
+ * The collective operations are built on that with rank 0 in the middle and
+ * can be replaced by a subclass that has faster ones, such as one over MPI.
+ *
+ * All calls block and return a negative value on error, in which case
+ * getErrorMessage() says what went wrong.
+ */
+class MBIRLib_EXPORT SlabTransport
+{
+  public:
+    MXA_SHARED_POINTERS(SlabTransport)
+    MXA_TYPE_MACRO(SlabTransport)
+
+    virtual ~SlabTransport();
+
+    MXA_INSTANCE_STRING_PROPERTY(ErrorMessage)
+
+    virtual int getRank() = 0;
+    virtual int getSize() = 0;
+
+    /**
+     * @brief Sends bytes to one rank. Returns once they are handed to the transport.
+     */
+    virtual int send(int peer, const void* data, size_t bytes) = 0;
+
+    /**
+     * @brief Waits for bytes from one rank
+     */
+    virtual int receive(int peer, void* data, size_t bytes) = 0;
+
+    /**
+     * @brief Swaps equally sized buffers with one rank. The lower rank sends
+     * first so two ranks calling this for each other do not wait on each other.
+     */
+    virtual int sendReceive(int peer, const void* sendData, void* receiveData, size_t bytes);
+
+    /**
+     * @brief Returns once every rank has called it
+     */
+    virtual int barrier();
+
+    /**
+     * @brief Replaces the values on every rank with their sum over all ranks.
+     * The values are left as they were if a transfer fails.
+     */
+    virtual int allReduceSum(std::vector<Real_t>& values);
+
+  protected:
+    SlabTransport();
+
+  private:
+    SlabTransport(const SlabTransport&); // Copy Constructor Not Implemented
+    void operator=(const SlabTransport&); // Operator '=' Not Implemented
+};
+
+#endif /* _SlabTransport_H_ */
@@ -7,18 +7,29 @@
 set (MBIRLib_Common_SRCS
     ${MBIRLib_SOURCE_DIR}/Common/allocate.c
     ${MBIRLib_SOURCE_DIR}/Common/AMatrixCol.cpp
+    ${MBIRLib_SOURCE_DIR}/Common/BackProject.cpp
+    ${MBIRLib_SOURCE_DIR}/Common/BitVolume.cpp
     ${MBIRLib_SOURCE_DIR}/Common/EIMTime.c
     ${MBIRLib_SOURCE_DIR}/Common/EIMImage.cpp
     ${MBIRLib_SOURCE_DIR}/Common/AbstractFilter.cpp
     ${MBIRLib_SOURCE_DIR}/Common/FilterPipeline.cpp
+    ${MBIRLib_SOURCE_DIR}/Common/LocalSocketTransport.cpp
+    ${MBIRLib_SOURCE_DIR}/Common/MemoryMappedFile.cpp
+    ${MBIRLib_SOURCE_DIR}/Common/MemoryRegistry.cpp
     ${MBIRLib_SOURCE_DIR}/Common/Observer.cpp
     ${MBIRLib_SOURCE_DIR}/Common/Observable.cpp
+    ${MBIRLib_SOURCE_DIR}/Common/RadixQuantile.cpp
+    ${MBIRLib_SOURCE_DIR}/Common/ServerProtocol.cpp
+    ${MBIRLib_SOURCE_DIR}/Common/SinogramBufferPool.cpp
+    ${MBIRLib_SOURCE_DIR}/Common/SlabTransport.cpp
     ${MBIRLib_SOURCE_DIR}/Common/VoxelUpdateList.cpp
 )
 
 set (MBIRLib_Common_HDRS
     ${MBIRLib_SOURCE_DIR}/Common/allocate.h
     ${MBIRLib_SOURCE_DIR}/Common/AMatrixCol.h
+    ${MBIRLib_SOURCE_DIR}/Common/BackProject.h
+    ${MBIRLib_SOURCE_DIR}/Common/BitVolume.h
     ${MBIRLib_SOURCE_DIR}/Common/MBIRLibDLLExport.h
     ${MBIRLib_SOURCE_DIR}/Common/MSVCDefines.h
     ${MBIRLib_SOURCE_DIR}/Common/EIMImage.h
@@ -26,8 +37,15 @@ set (MBIRLib_Common_HDRS
     ${MBIRLib_SOURCE_DIR}/Common/EIMMath.h
     ${MBIRLib_SOURCE_DIR}/Common/AbstractFilter.h
     ${MBIRLib_SOURCE_DIR}/Common/FilterPipeline.h
+    ${MBIRLib_SOURCE_DIR}/Common/LocalSocketTransport.h
+    ${MBIRLib_SOURCE_DIR}/Common/MemoryMappedFile.h
+    ${MBIRLib_SOURCE_DIR}/Common/MemoryRegistry.h
     ${MBIRLib_SOURCE_DIR}/Common/Observer.h
     ${MBIRLib_SOURCE_DIR}/Common/Observable.h
+    ${MBIRLib_SOURCE_DIR}/Common/RadixQuantile.h
+    ${MBIRLib_SOURCE_DIR}/Common/ServerProtocol.h
+    ${MBIRLib_SOURCE_DIR}/Common/SinogramBufferPool.h
+    ${MBIRLib_SOURCE_DIR}/Common/SlabTransport.h
     ${MBIRLib_SOURCE_DIR}/Common/CE_ConstraintEquation.hpp
     ${MBIRLib_SOURCE_DIR}/Common/DerivOfCostFunc.hpp
     ${MBIRLib_SOURCE_DIR}/Common/TomoArray.hpp
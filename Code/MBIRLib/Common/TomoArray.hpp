@@ -36,11 +36,188 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <boost/shared_ptr.hpp>
 
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/allocate.h"
+#include "MBIRLib/Common/MemoryRegistry.h"
 #include "MBIRLib/Reconstruction/ReconstructionConstants.h"
 
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_group.h>
+#endif
+
+/**
+ * @brief The element wise kernels behind the bulk operations of TomoArray. Each
+ * one works on a plain contiguous range so the compiler can vectorize it, and
+ * code that already splits its work (the per tilt kernels for example) can call
+ * them on its own part of an array.
+ */
+namespace TomoArrayBulk
+{
+  enum Operation
+  {
+    Fill,
+    Copy,
+    Scale,
+    Axpy,
+    Sum,
+    Min,
+    Max
+  };
+
+  /* Elements handled by one task. Blocks start at multiples of this from the
+   * aligned start of an array so every block stays aligned as well. */
+  const size_t k_BlockSize = 65536;
+
+  template<typename T>
+  inline void fill(T* __restrict d, size_t n, T value)
+  {
+    for (size_t i = 0; i < n; i++) { d[i] = value; }
+  }
+
+  template<typename T>
+  inline void copy(T* __restrict d, const T* __restrict x, size_t n)
+  {
+    ::memcpy(d, x, n * sizeof(T));
+  }
+
+  template<typename T>
+  inline void scale(T* __restrict d, size_t n, T a)
+  {
+    for (size_t i = 0; i < n; i++) { d[i] *= a; }
+  }
+
+  /* d = d + a * x */
+  template<typename T>
+  inline void axpy(T* __restrict d, const T* __restrict x, size_t n, T a)
+  {
+    for (size_t i = 0; i < n; i++) { d[i] += a * x[i]; }
+  }
+
+  /* Four partial sums so the additions do not wait on each other */
+  template<typename T>
+  inline double sum(const T* __restrict d, size_t n)
+  {
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+      s0 += d[i];
+      s1 += d[i + 1];
+      s2 += d[i + 2];
+      s3 += d[i + 3];
+    }
+    for (; i < n; i++) { s0 += d[i]; }
+    return (s0 + s1) + (s2 + s3);
+  }
+
+  template<typename T>
+  inline T minValue(const T* __restrict d, size_t n)
+  {
+    T v = d[0];
+    for (size_t i = 1; i < n; i++) { v = (d[i] < v) ? d[i] : v; }
+    return v;
+  }
+
+  template<typename T>
+  inline T maxValue(const T* __restrict d, size_t n)
+  {
+    T v = d[0];
+    for (size_t i = 1; i < n; i++) { v = (d[i] > v) ? d[i] : v; }
+    return v;
+  }
+
+  /**
+   * @brief Runs one operation on a range. The reductions return their value,
+   * every other operation returns 0.
+   */
+  template<typename T>
+  inline double apply(Operation op, T* d, const T* x, T a, size_t n)
+  {
+    switch(op)
+    {
+      case Fill: fill(d, n, a); break;
+      case Copy: copy(d, x, n); break;
+      case Scale: scale(d, n, a); break;
+      case Axpy: axpy(d, x, n, a); break;
+      case Sum: return sum(d, n);
+      case Min: return static_cast<double>(minValue(d, n));
+      case Max: return static_cast<double>(maxValue(d, n));
+    }
+    return 0.0;
+  }
+
+  /**
+   * @brief Runs an operation on one block of an array
+   */
+  template<typename T>
+  class BlockTask
+  {
+    public:
+      BlockTask(Operation op, T* d, const T* x, T a, size_t n, double* result) :
+        m_Op(op), m_D(d), m_X(x), m_A(a), m_N(n), m_Result(result)
+      {}
+
+      void operator()() const
+      {
+        *m_Result = apply(m_Op, m_D, m_X, m_A, m_N);
+      }
+
+    private:
+      Operation m_Op;
+      T* m_D;
+      const T* m_X;
+      T m_A;
+      size_t m_N;
+      double* m_Result;
+  };
+
+  /**
+   * @brief Runs an operation over n elements, one task per block. The partial
+   * results of a reduction are combined in block order so the result does not
+   * depend on the number of threads. A reduction needs n > 0.
+   */
+  template<typename T>
+  double run(Operation op, T* d, const T* x, T a, size_t n)
+  {
+    size_t numBlocks = (n + k_BlockSize - 1) / k_BlockSize;
+    if (numBlocks < 2)
+    {
+      return apply(op, d, x, a, n);
+    }
+    std::vector<double> partial(numBlocks, 0.0);
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    tbb::task_group* g = new tbb::task_group;
+#endif
+    for (size_t b = 0; b < numBlocks; b++)
+    {
+      size_t begin = b * k_BlockSize;
+      size_t count = (n - begin < k_BlockSize) ? n - begin : k_BlockSize;
+      const T* xBlock = (NULL == x) ? NULL : x + begin;
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+      g->run(BlockTask<T>(op, d + begin, xBlock, a, count, &(partial[b])));
+#else
+      partial[b] = apply(op, d + begin, xBlock, a, count);
+#endif
+    }
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    g->wait(); // Wait for all the threads to complete before moving on.
+    delete g;
+#endif
+    double result = partial[0];
+    for (size_t b = 1; b < numBlocks; b++)
+    {
+      if (op == Sum) { result += partial[b]; }
+      else if (op == Min && partial[b] < result) { result = partial[b]; }
+      else if (op == Max && partial[b] > result) { result = partial[b]; }
+    }
+    return result;
+  }
+}
+
 /**
  * @brief Creates a new Array by allocating memory in a contiguous space
  * @param dims The dimensions of your data with the SLOWEST moving dimension
@@ -129,8 +306,7 @@ class TomoArray
     {
       //assert(SIZE < 4);
 
-      Pointer sharedPtr(new TomoArray<T, Ptr, SIZE>(dims));
-      sharedPtr->setName(name);
+      Pointer sharedPtr(new TomoArray<T, Ptr, SIZE>(dims, name));
       return sharedPtr;
     }
 
@@ -142,9 +318,10 @@ class TomoArray
         std::cout << "Deallocating TomoArray " << m_Name << std::endl;
       }
 #endif
+      MemoryRegistry::Instance()->released(m_Name, getAllocatedBytes());
       if (SIZE == 1 || SIZE == 2 || SIZE == 3)
       {
-        free(d);
+        free_aligned(d);
       }
       else
       {
@@ -157,19 +334,73 @@ class TomoArray
       size_t count = 1;
       for(int i = 0; i < SIZE; ++i)
       {
-        count += m_Dims[i];
+        count *= m_Dims[i];
       }
       return count;
     }
 
     inline void initializeWithZeros()
     {
-      size_t count = 1;
-      for(int i = 0; i < SIZE; ++i)
+      fill(static_cast<T>(0));
+    }
+
+    /* ******* Bulk operations over the whole of a contiguous (1D-3D) array ******* */
+    inline void fill(T value)
+    {
+      TomoArrayBulk::run<T>(TomoArrayBulk::Fill, d, NULL, value, numElements());
+    }
+
+    /**
+     * @brief Copies the values of an array with the same number of elements
+     * @return false if the number of elements differ
+     */
+    inline bool copyFrom(Pointer source)
+    {
+      if (source->numElements() != numElements())
+      {
+        return false;
+      }
+      TomoArrayBulk::run<T>(TomoArrayBulk::Copy, d, source->d, static_cast<T>(0), numElements());
+      return true;
+    }
+
+    inline void scale(T a)
+    {
+      TomoArrayBulk::run<T>(TomoArrayBulk::Scale, d, NULL, a, numElements());
+    }
+
+    /**
+     * @brief this = this + a * x
+     * @return false if the number of elements differ
+     */
+    inline bool axpy(T a, Pointer x)
+    {
+      if (x->numElements() != numElements())
       {
-        count += m_Dims[i];
+        return false;
       }
-      ::memset(d, 0, count * sizeof(T));
+      TomoArrayBulk::run<T>(TomoArrayBulk::Axpy, d, x->d, a, numElements());
+      return true;
+    }
+
+    /**
+     * @brief The sum of the values, accumulated in double precision
+     */
+    inline double sum()
+    {
+      return TomoArrayBulk::run<T>(TomoArrayBulk::Sum, d, NULL, static_cast<T>(0), numElements());
+    }
+
+    inline T minValue()
+    {
+      if (numElements() == 0) { return static_cast<T>(0); }
+      return static_cast<T>(TomoArrayBulk::run<T>(TomoArrayBulk::Min, d, NULL, static_cast<T>(0), numElements()));
+    }
+
+    inline T maxValue()
+    {
+      if (numElements() == 0) { return static_cast<T>(0); }
+      return static_cast<T>(TomoArrayBulk::run<T>(TomoArrayBulk::Max, d, NULL, static_cast<T>(0), numElements()));
     }
 
     /* ******************* These are 3D array methods ********************* */
@@ -258,14 +489,72 @@ class TomoArray
     }
 
 
-    void setName(const std::string& name) { m_Name = name;}
+    /**
+     * @brief Gives a contiguous array new dimensions. The memory is only
+     * allocated again when it has to grow and the values are undefined after.
+     * @return false if the array is not contiguous or could not grow
+     */
+    bool reshape(size_t* dims)
+    {
+      if (SIZE != 1 && SIZE != 2 && SIZE != 3)
+      {
+        return false;
+      }
+      size_t total = 1;
+      for(size_t i = 0; i < SIZE; ++i)
+      {
+        total *= dims[i];
+      }
+      if (total > m_Capacity)
+      {
+        // Nothing is kept so the old memory goes before the new is taken
+        MemoryRegistry::Instance()->released(m_Name, getAllocatedBytes());
+        free_aligned(d);
+        d = reinterpret_cast<Ptr>(get_aligned(sizeof(T) * total));
+        if (NULL == d)
+        {
+          m_Capacity = 0;
+          return false;
+        }
+        m_Capacity = total;
+        MemoryRegistry::Instance()->allocated(m_Name, getAllocatedBytes());
+      }
+      for(size_t i = 0; i < SIZE; ++i)
+      {
+        m_Dims[i] = dims[i];
+      }
+      return true;
+    }
+
+    /**
+     * @brief The number of elements the array can hold without allocating again
+     */
+    size_t getCapacity() { return m_Capacity; }
+
+    /**
+     * @brief The bytes of the values the array holds memory for
+     */
+    uint64_t getAllocatedBytes() { return static_cast<uint64_t>(m_Capacity) * sizeof(T); }
+
+    /**
+     * @brief Renames the array. Its memory is accounted to the new name from now on.
+     */
+    void setName(const std::string& name)
+    {
+      if (name != m_Name)
+      {
+        MemoryRegistry::Instance()->renamed(m_Name, name, getAllocatedBytes());
+        m_Name = name;
+      }
+    }
     Ptr getPointer() { return d; }
     size_t* getDims() {return m_Dims; }
     int getNDims() { return m_NDims; }
     int getTypeSize() { return sizeof(T); }
 
   protected:
-    TomoArray(size_t* dims)
+    TomoArray(size_t* dims, const std::string& name) :
+      m_Name(name)
     {
       size_t total = 1;
       for(size_t i = 0; i < SIZE; ++i)
@@ -275,18 +564,22 @@ class TomoArray
       }
       if (SIZE == 1 || SIZE == 2 || SIZE == 3)
       {
-        d = reinterpret_cast<Ptr>(malloc(sizeof(T) * total));
+        // Aligned so the bulk operations below vectorize on whole cache lines
+        d = reinterpret_cast<Ptr>(get_aligned(sizeof(T) * total));
       }
       else
       {
         d = reinterpret_cast<Ptr>(allocate(sizeof(T), SIZE, m_Dims));
       }
       m_NDims = SIZE;
+      m_Capacity = (NULL == d) ? 0 : total;
+      MemoryRegistry::Instance()->allocated(m_Name, getAllocatedBytes());
     }
 
   private:
     size_t m_Dims[SIZE];
     int  m_NDims;
+    size_t m_Capacity;
     std::string m_Name;
 
 
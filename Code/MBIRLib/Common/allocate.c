@@ -40,6 +40,12 @@
 #include <stdarg.h>
 #include <assert.h>
 
+#if defined (_MSC_VER)
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
 #include "allocate.h"
 
 
@@ -205,3 +211,56 @@ void multifree(void* r, int d)
 
 
 
+/* Whether large blocks from get_aligned are backed by huge pages */
+static int s_UseHugePages = 1;
+
+void set_huge_pages(int enable)
+{
+  s_UseHugePages = enable;
+}
+
+int get_huge_pages(void)
+{
+  return s_UseHugePages;
+}
+
+void* get_aligned(size_t size)
+{
+  void* pt = NULL;
+  size_t alignment = MBIR_ALIGNMENT;
+  int hugePages = (s_UseHugePages != 0 && size >= MBIR_HUGE_PAGE_THRESHOLD);
+  if (size == 0)
+  {
+    size = MBIR_ALIGNMENT;
+  }
+  if (hugePages != 0)
+  {
+    /* Starting on a huge page boundary lets the whole block be mapped by them */
+    alignment = MBIR_HUGE_PAGE_SIZE;
+  }
+#if defined (_MSC_VER)
+  pt = _aligned_malloc(size, alignment);
+#else
+  if (posix_memalign(&pt, alignment, size) != 0)
+  {
+    return NULL;
+  }
+#if defined (MADV_HUGEPAGE)
+  if (hugePages != 0)
+  {
+    /* Only a hint, the block is usable whether the kernel honours it or not */
+    madvise(pt, size - size % MBIR_HUGE_PAGE_SIZE, MADV_HUGEPAGE);
+  }
+#endif
+#endif
+  return pt;
+}
+
+void free_aligned(void* pt)
+{
+#if defined (_MSC_VER)
+  _aligned_free(pt);
+#else
+  free(pt);
+#endif
+}
@@ -60,6 +60,21 @@ void free_3D(void** *pt);
 void* multialloc(size_t s, int d, ...);
 void multifree(void* r, int d);
 
+/* Alignment of every block handed out by get_aligned, one cache line */
+#define MBIR_ALIGNMENT 64
+/* Blocks of at least this many bytes are backed by transparent huge pages */
+#define MBIR_HUGE_PAGE_THRESHOLD (32 * 1024 * 1024)
+#define MBIR_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+/* get_aligned returns a block aligned to MBIR_ALIGNMENT, or NULL if the memory
+ * is not available. Large blocks are aligned to a huge page and the kernel is
+ * asked to back them with huge pages unless set_huge_pages(0) was called.
+ * The block must be given back with free_aligned. */
+MBIRLib_EXPORT void* get_aligned(size_t size);
+MBIRLib_EXPORT void free_aligned(void* pt);
+MBIRLib_EXPORT void set_huge_pages(int enable);
+MBIRLib_EXPORT int get_huge_pages(void);
+
 #ifdef __cplusplus
 }
 #endif
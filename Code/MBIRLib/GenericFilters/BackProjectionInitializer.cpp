@@ -0,0 +1,258 @@
+/* ============================================================================
+ * Copyright (c) 2012 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2012 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "BackProjectionInitializer.h"
+
+#include <string.h>
+
+#include <sstream>
+
+#include "MBIRLib/Common/EIMMath.h"
+#include "MBIRLib/Common/BackProject.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_group.h>
+#endif
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+BackProjectionInitializer::BackProjectionInitializer() :
+  m_NumIterations(1),
+  m_PositivityConstraint(true)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+BackProjectionInitializer::~BackProjectionInitializer()
+{
+}
+
+// -----------------------------------------------------------------------------
+// out += scale * A * x. The voxel lines of neighboring slices hit the same
+// detector entries so this is run serially.
+// -----------------------------------------------------------------------------
+void BackProjectionInitializer::forwardProject(RealVolumeType::Pointer out, Real_t scale, bool unitVolume)
+{
+  SinogramPtr sinogram = getSinogram();
+  GeometryPtr geometry = getGeometry();
+
+  for (uint32_t z = 0; z < geometry->N_z; z++)
+  {
+    for (uint32_t x = 0; x < geometry->N_x; x++)
+    {
+      AMatrixCol* col = m_TempCol[z * geometry->N_x + x].get();
+      if(col->count == 0)
+      {
+        continue;
+      }
+      for (uint32_t y = 0; y < geometry->N_y; y++)
+      {
+        Real_t voxel = (unitVolume == true) ? 1.0 : geometry->Object->getValue(z, x, y);
+        if(voxel == 0.0)
+        {
+          continue;
+        }
+        AMatrixCol* vlr = m_VoxelLineResponse[y].get();
+        for (uint32_t q = 0; q < col->count; q++)
+        {
+          uint16_t i_theta = col->index[q] / sinogram->N_r;
+          uint16_t i_r = col->index[q] % sinogram->N_r;
+          Real_t kConst0 = scale * m_I_0->d[i_theta] * col->values[q] * voxel;
+          Real_t* data = out->d + out->calcIndex(i_theta, i_r, vlr->index[0]);
+          for (uint32_t c = 0; c < vlr->count; c++)
+          {
+            data[c] += kConst0 * vlr->values[c];
+          }
+        }
+      }
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void BackProjectionInitializer::backProject(RealVolumeType::Pointer in, RealVolumeType::Pointer out)
+{
+  SinogramPtr sinogram = getSinogram();
+  GeometryPtr geometry = getGeometry();
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  tbb::task_group* g = new tbb::task_group;
+#endif
+  for (uint16_t z = 0; z < geometry->N_z; z++)
+  {
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    g->run(BackProject(sinogram.get(), geometry.get(), m_TempCol, m_VoxelLineResponse, m_I_0, in, out, z, NULL));
+#else
+    BackProject bp(sinogram.get(), geometry.get(), m_TempCol, m_VoxelLineResponse, m_I_0, in, out, z, NULL);
+    bp();
+#endif
+  }
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  g->wait(); // Wait for all the threads to complete before moving on.
+  delete g;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void BackProjectionInitializer::execute()
+{
+  SinogramPtr sinogram = getSinogram();
+  GeometryPtr geometry = getGeometry();
+  std::stringstream ss;
+
+  if(NULL == geometry.get() || NULL == geometry->Object.get() || NULL == sinogram.get() || NULL == sinogram->counts.get())
+  {
+    setErrorCondition(-1);
+    notify("BackProjectionInitializer: The Sinogram and Geometry must be initialized before back projecting.", 100, Observable::UpdateErrorMessage);
+    return;
+  }
+  if(m_TempCol.size() != static_cast<size_t>(geometry->N_z * geometry->N_x) || m_VoxelLineResponse.size() != geometry->N_y)
+  {
+    setErrorCondition(-1);
+    notify("BackProjectionInitializer: The A Matrix does not match the Geometry.", 100, Observable::UpdateErrorMessage);
+    return;
+  }
+  if(NULL == m_I_0.get() || NULL == m_Mu.get() || NULL == m_WorkSinogram.get() || NULL == m_ResidualSinogram.get())
+  {
+    setErrorCondition(-1);
+    notify("BackProjectionInitializer: The Gains, Offsets and scratch sinograms must all be set.", 100, Observable::UpdateErrorMessage);
+    return;
+  }
+
+  size_t numSinoElements = sinogram->N_theta * sinogram->N_r * sinogram->N_t;
+
+  // Row normalization of SIRT: 1 / (A * 1) for every detector entry
+  m_WorkSinogram->fill(0.0);
+  forwardProject(m_WorkSinogram, 1.0, true);
+  for (size_t i = 0; i < numSinoElements; i++)
+  {
+    m_WorkSinogram->d[i] = (m_WorkSinogram->d[i] > 0.0) ? 1.0 / m_WorkSinogram->d[i] : 0.0;
+  }
+
+  // Column normalization of SIRT: (1^T * A) for every voxel. The A matrix is the
+  // product of an (x,z) footprint and a y line response so the column sums are
+  // separable and do not need a full volume.
+  std::vector<Real_t> columnSumXZ(geometry->N_z * geometry->N_x, 0.0);
+  for (size_t i = 0; i < columnSumXZ.size(); i++)
+  {
+    AMatrixCol* col = m_TempCol[i].get();
+    for (uint32_t q = 0; q < col->count; q++)
+    {
+      columnSumXZ[i] += m_I_0->d[col->index[q] / sinogram->N_r] * col->values[q];
+    }
+  }
+  std::vector<Real_t> columnSumY(geometry->N_y, 0.0);
+  for (uint16_t y = 0; y < geometry->N_y; y++)
+  {
+    for (uint32_t c = 0; c < m_VoxelLineResponse[y]->count; c++)
+    {
+      columnSumY[y] += m_VoxelLineResponse[y]->values[c];
+    }
+  }
+
+  size_t dims[3] = { geometry->N_z, geometry->N_x, geometry->N_y };
+  RealVolumeType::Pointer update = RealVolumeType::New(dims, "BackProjection Update");
+
+  for (uint16_t iter = 0; iter < m_NumIterations; iter++)
+  {
+    if (getCancel() == true) { setErrorCondition(-999); return; }
+
+    ss.str("");
+    ss << "SIRT Initialization Iteration " << iter + 1 << "/" << m_NumIterations;
+    notify(ss.str(), 0, Observable::UpdateProgressMessage);
+
+    // Residual = (y - mu) - A * x, normalized by the row sums
+    for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
+    {
+      size_t start = m_ResidualSinogram->calcIndex(i_theta, 0, 0);
+      size_t end = start + sinogram->N_r * sinogram->N_t;
+      for (size_t i = start; i < end; i++)
+      {
+        m_ResidualSinogram->d[i] = sinogram->counts->d[i] - m_Mu->d[i_theta];
+      }
+    }
+    forwardProject(m_ResidualSinogram, -1.0, false);
+    Real_t residualNorm = 0.0;
+    for (size_t i = 0; i < numSinoElements; i++)
+    {
+      residualNorm += m_ResidualSinogram->d[i] * m_ResidualSinogram->d[i] * m_WorkSinogram->d[i];
+      m_ResidualSinogram->d[i] *= m_WorkSinogram->d[i];
+    }
+    if(getVerbose())
+    {
+      std::cout << "SIRT Iteration " << iter << " normalized residual: " << residualNorm << std::endl;
+    }
+
+    backProject(m_ResidualSinogram, update);
+
+    // x = x + C * A^T * R * (y - A * x)
+    for (uint16_t z = 0; z < geometry->N_z; z++)
+    {
+      for (uint16_t x = 0; x < geometry->N_x; x++)
+      {
+        Real_t colXZ = columnSumXZ[z * geometry->N_x + x];
+        for (uint16_t y = 0; y < geometry->N_y; y++)
+        {
+          Real_t colSum = colXZ * columnSumY[y];
+          if(colSum <= 0.0)
+          {
+            continue;
+          }
+          size_t idx = geometry->Object->calcIndex(z, x, y);
+          Real_t value = geometry->Object->d[idx] + update->d[idx] / colSum;
+          if(m_PositivityConstraint == true && value < 0.0)
+          {
+            value = 0.0;
+          }
+          geometry->Object->d[idx] = value;
+        }
+      }
+    }
+  }
+
+  setErrorCondition(0);
+  setErrorMessage("");
+  ss.str("");
+  ss << getNameOfClass() << " Complete";
+  notify(ss.str(), 0, UpdateProgressMessage);
+}
@@ -0,0 +1,106 @@
+/* ============================================================================
+ * Copyright (c) 2012 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2012 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef BACKPROJECTIONINITIALIZER_H_
+#define BACKPROJECTIONINITIALIZER_H_
+
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/AMatrixCol.h"
+#include "MBIRLib/GenericFilters/TomoFilter.h"
+#include "MBIRLib/Reconstruction/ReconstructionStructures.h"
+
+
+/**
+ * @class BackProjectionInitializer BackProjectionInitializer.h MBIRLib/GenericFilters/BackProjectionInitializer.h
+ * @brief Refines the initial estimate of Geometry->Object with a few iterations
+ * of SIRT (Simultaneous Iterative Reconstruction Technique) so that ICD does
+ * not have to start from a constant volume. A single iteration starting from
+ * a zero volume is a row/column normalized (weighted) back projection.
+ *
+ * The filter must be run after the partial A matrix (TempCol and
+ * VoxelLineResponse) and the gains/offsets have been computed. The two scratch
+ * sinograms are overwritten so the engines can lend their Y_Est and ErrorSino
+ * arrays before the initial forward projection fills them.
+ * @author Michael A. Jackson for BlueQuartz Software
+ * @author Singanallur Venkatakrishnan (Purdue University)
+ * @version 1.0
+ */
+class MBIRLib_EXPORT BackProjectionInitializer : public TomoFilter
+{
+  public:
+    MXA_SHARED_POINTERS(BackProjectionInitializer)
+    MXA_STATIC_NEW_MACRO(BackProjectionInitializer);
+    MXA_STATIC_NEW_SUPERCLASS(TomoFilter, BackProjectionInitializer);
+    MXA_TYPE_MACRO_SUPER(BackProjectionInitializer, TomoFilter)
+
+    virtual ~BackProjectionInitializer();
+
+    MXA_INSTANCE_PROPERTY(std::vector<AMatrixCol::Pointer>, TempCol)
+    MXA_INSTANCE_PROPERTY(std::vector<AMatrixCol::Pointer>, VoxelLineResponse)
+    MXA_INSTANCE_PROPERTY(RealArrayType::Pointer, I_0)
+    MXA_INSTANCE_PROPERTY(RealArrayType::Pointer, Mu)
+    MXA_INSTANCE_PROPERTY(RealVolumeType::Pointer, WorkSinogram)
+    MXA_INSTANCE_PROPERTY(RealVolumeType::Pointer, ResidualSinogram)
+    MXA_INSTANCE_PROPERTY(uint16_t, NumIterations)
+    MXA_INSTANCE_PROPERTY(bool, PositivityConstraint)
+
+    virtual void execute();
+
+  protected:
+    BackProjectionInitializer();
+
+    /**
+     * @brief Computes out += scale * A * Object. If unitVolume is true the
+     * Object is taken to be all ones which gives the row sums of A.
+     */
+    void forwardProject(RealVolumeType::Pointer out, Real_t scale, bool unitVolume);
+
+    /**
+     * @brief Computes out = A^T * in, one Z slice per task.
+     */
+    void backProject(RealVolumeType::Pointer in, RealVolumeType::Pointer out);
+
+  private:
+    BackProjectionInitializer(const BackProjectionInitializer&); // Copy Constructor Not Implemented
+    void operator=(const BackProjectionInitializer&); // Operator '=' Not Implemented
+};
+
+
+#endif /* BACKPROJECTIONINITIALIZER_H_ */
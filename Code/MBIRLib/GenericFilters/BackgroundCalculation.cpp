@@ -30,6 +30,10 @@
 
 #include "BackgroundCalculation.h"
 
+#include <vector>
+
+#include "MBIRLib/IOFilters/MRCStatisticsIndex.h"
+
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
@@ -95,25 +99,47 @@ template<class T> double BackgroundCalculation::computeMean(void* ptr, int numVo
 // -----------------------------------------------------------------------------
 double BackgroundCalculation::getMeanValue(std::string filePath, int x, int y, int width, int height, int tiltNum)
 {
-  MRCReader::Pointer m_Reader = MRCReader::New();
-  MRCHeader* header = new MRCHeader();
-
-
-  if ( !m_Reader->readHeader(filePath, header) )
+  MRCFile::Pointer mrcFile = MRCFile::New();
+  if (mrcFile->open(filePath) < 0)
   {
-    std::cout << "m_Reader did not read header from filepath correctly!\n";
+    std::cout << "BackgroundCalculation could not open " << filePath << std::endl;
     return 0.0;
   }
+  return getMeanValue(mrcFile, x, y, width, height, tiltNum);
+}
 
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+double BackgroundCalculation::getMeanValue(MRCFile::Pointer mrcFile, int x, int y, int width, int height, int tiltNum)
+{
+  if (NULL == mrcFile.get() || false == mrcFile->isOpen() || width <= 0 || height <= 0)
+  {
+    return 0.0;
+  }
+  MRCHeader* header = mrcFile->getHeader();
   int mode = header->mode;
 
-  int min[3] = {x, y, tiltNum};
-  int max[3] = {x + width, y + height, tiltNum};
+  int min[2] = {x, y};
+  int max[2] = {x + width - 1, y + height - 1};
   int nVoxels = width * height;
 
-  if ( !m_Reader->read(filePath, min, max) )
+  // Use the statistics sidecar if it already holds this region
+  MRCStatisticsIndex::Pointer index = MRCStatisticsIndex::New();
+  if (index->load(mrcFile->getFilePath()) >= 0)
   {
-    std::cout << "m_Reader did not read filepath correctly!\n";
+    const std::vector<MRCSectionStatistics>* stats = index->find(min, max);
+    if (NULL != stats && tiltNum >= 0 && tiltNum < static_cast<int>(stats->size()))
+    {
+      return (*stats)[tiltNum].Mean;
+    }
+  }
+
+  std::vector<uint8_t> buffer(nVoxels * mrcFile->getTypeSize());
+  void* data = &(buffer.front());
+  if (mrcFile->readSectionRegion(tiltNum, min, max, data) < 0)
+  {
+    std::cout << "BackgroundCalculation could not read the region from " << mrcFile->getFilePath() << std::endl;
     return 0.0;
   }
 
@@ -126,30 +152,27 @@ double BackgroundCalculation::getMeanValue(std::string filePath, int x, int y, i
       if (header->imodFlags == 1)
       {
         // Signed bytes
-        mean = computeMean<signed char>(m_Reader->getDataPointer(), nVoxels, TYPE_SIGNED_BYTES);
+        mean = computeMean<signed char>(data, nVoxels, TYPE_SIGNED_BYTES);
       }
       else
       {
         // Unsigned bytes
-        mean = computeMean<unsigned char>(m_Reader->getDataPointer(), nVoxels, TYPE_UNSIGNED_BYTES);
+        mean = computeMean<unsigned char>(data, nVoxels, TYPE_UNSIGNED_BYTES);
       }
       break;
     }
     case TYPE_SIGNED_SHORT_INT:
     {
-      mean = computeMean<signed short int>(m_Reader->getDataPointer(), nVoxels, TYPE_SIGNED_SHORT_INT);
+      mean = computeMean<signed short int>(data, nVoxels, TYPE_SIGNED_SHORT_INT);
       break;
     }
     case TYPE_FLOAT:
     {
-      mean = computeMean<float>(m_Reader->getDataPointer(), nVoxels, TYPE_FLOAT);
+      mean = computeMean<float>(data, nVoxels, TYPE_FLOAT);
       break;
     }
   }
 
-  delete header;
-  header = NULL;
-
   return mean;
 }
 
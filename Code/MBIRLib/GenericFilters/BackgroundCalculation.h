@@ -34,7 +34,7 @@
 #include <iostream>
 #include <string>
 
-#include "MBIRLib/IOFilters/MRCReader.h"
+#include "MBIRLib/IOFilters/MRCFile.h"
 
 enum Type
 {
@@ -53,6 +53,12 @@ class BackgroundCalculation
 
     static double getMeanValue(std::string filePath, int x, int y, int width, int height, int tiltNum);
 
+    /**
+     * @brief Same as above but reads from an already open file so repeated
+     * calls do not reopen the file and reparse the header.
+     */
+    static double getMeanValue(MRCFile::Pointer mrcFile, int x, int y, int width, int height, int tiltNum);
+
   protected:
     BackgroundCalculation();
     template<class T> static double computeMean(void* ptr, int numVoxels, Type type);
@@ -91,17 +91,27 @@ void ComputeInitialOffsets::execute()
 
   Real_t LS_Estimates[2] = {0, 0};
 
+  // The reader may have already computed the mean of each tilt. Once the counts
+  // have been log transformed those statistics are the only copy of the raw means.
+  bool haveRawStatistics = (sinogram->rawStatistics.size() == sinogram->N_theta);
   for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
   {
     Real_t sum = 0;
-    for (uint16_t i_r = 0; i_r < sinogram->N_r; i_r++)
+    if (haveRawStatistics)
     {
-      for (uint16_t i_t = 0; i_t < sinogram->N_t; i_t++)
+      sum = sinogram->rawStatistics[i_theta].Mean;
+    }
+    else
+    {
+      for (uint16_t i_r = 0; i_r < sinogram->N_r; i_r++)
       {
-        sum += sinogram->counts->getValue(i_theta, i_r, i_t);
+        for (uint16_t i_t = 0; i_t < sinogram->N_t; i_t++)
+        {
+          sum += sinogram->counts->getValue(i_theta, i_r, i_t);
+        }
       }
+      sum /= (sinogram->N_r * sinogram->N_t);
     }
-    sum /= (sinogram->N_r * sinogram->N_t);
     AverageGain[i_theta] = sum;
     TargetGain[i_theta] = 1.0 / cos(sinogram->angles[i_theta] * M_PI / 180); //Set to 1/cos(tilt_angle)
     LS_Matrix->setValue(TargetGain[i_theta], i_theta, 0);
@@ -30,12 +30,19 @@
 
 #include "CostData.h"
 
+#include <limits>
+#include <iostream>
+
 
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
 CostData::CostData() :
-  m_File(NULL)
+  m_ResyncInterval(1),
+  m_File(NULL),
+  m_TrackedCost(0.0),
+  m_TrackedCostValid(false),
+  m_TrackedUpdates(0)
 {
 }
 
@@ -58,6 +65,18 @@ int CostData::numberOfCosts()
   return m_Cost.size();
 }
 
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+Real_t CostData::getLastCostValue()
+{
+  if (m_Cost.size() == 0)
+  {
+    return std::numeric_limits<Real_t>::infinity();
+  }
+  return m_Cost[m_Cost.size() - 1];
+}
+
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
@@ -89,6 +108,10 @@ int CostData::initOutputFile(const std::string& filepath)
 int CostData::addCostValue(Real_t value)
 {
   m_Cost.push_back(value);
+  if (m_Cost.size() < 2)
+  {
+    return 0;
+  }
   if(m_Cost[m_Cost.size() - 1] - m_Cost[m_Cost.size() - 2] > 0)
   {
     std::cout << "Increase of cost =" << m_Cost[m_Cost.size() - 1] - m_Cost[m_Cost.size() - 2] << std::endl;
@@ -114,3 +137,38 @@ int CostData::writeCostValue(Real_t value)
   }
   return -1;
 }
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void CostData::resetTrackedCost(Real_t exactCost)
+{
+  m_TrackedCost = exactCost;
+  m_TrackedCostValid = true;
+  m_TrackedUpdates = 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void CostData::addTrackedCostChange(Real_t delta)
+{
+  m_TrackedCost += delta;
+  m_TrackedUpdates++;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool CostData::needsExactCost()
+{
+  return (m_TrackedCostValid == false || m_TrackedUpdates >= m_ResyncInterval);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+Real_t CostData::getTrackedCost()
+{
+  return m_TrackedCost;
+}
@@ -60,14 +60,48 @@ class MBIRLib_EXPORT CostData
 
     int numberOfCosts();
 
+    /**
+     * @brief Returns the most recently added cost value or +infinity if no cost
+     * has been added yet.
+     */
+    Real_t getLastCostValue();
+
     void printCosts(std::ostream& out);
 
+    /* Incremental cost tracking. The voxel updates report the change in cost
+     * they cause and the tracked cost is resynchronized from an exact (full
+     * volume) computation every ResyncInterval updates, or whenever anything
+     * outside of the voxel updates (nuisance parameters, weights) changes the cost.
+     */
+    MXA_INSTANCE_PROPERTY(int, ResyncInterval)
+
+    /**
+     * @brief Restarts the tracking from an exactly computed cost value
+     */
+    void resetTrackedCost(Real_t exactCost);
+
+    /**
+     * @brief Adds the change in cost accumulated over a pass of voxel updates
+     */
+    void addTrackedCostChange(Real_t delta);
+
+    /**
+     * @brief Returns true when the tracked cost is stale or ResyncInterval
+     * updates have been accumulated since the last exact computation
+     */
+    bool needsExactCost();
+
+    Real_t getTrackedCost();
+
   protected:
     CostData();
 
   private:
     std::vector<Real_t>  m_Cost;
     FILE* m_File;
+    Real_t m_TrackedCost;
+    bool m_TrackedCostValid;
+    int m_TrackedUpdates;
 
     CostData(const CostData&); // Copy Constructor Not Implemented
     void operator=(const CostData&); // Operator '=' Not Implemented
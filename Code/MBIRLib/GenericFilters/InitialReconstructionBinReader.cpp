@@ -37,10 +37,12 @@
 #include "InitialReconstructionBinReader.h"
 
 #include <sstream>
+#include <vector>
 
 #include "MXA/Utilities/MXADir.h"
 
 #include "MBIRLib/Common/EIMMath.h"
+#include "MBIRLib/GenericFilters/InitialReconstructionUpsampler.h"
 
 
 // -----------------------------------------------------------------------------
@@ -75,13 +77,10 @@ void InitialReconstructionBinReader::initializeData()
   std::stringstream ss;
   TomoInputsPtr input = getTomoInputs();
   GeometryPtr geometry = getGeometry();
-//  uint16_t INTERP_FACTOR=2;
   //Read the Initial Reconstruction data into a 3-D matrix
   //If Interpolate flag is set then the input has only half the
   //number of voxels along each dimension as the output
-
-  std::stringstream outPath;
-  outPath << input->tempDir << MXADir::Separator << MBIR::Defaults::UpsampledBinFile;
+  unsigned int factor = (1 == input->InterpFlag) ? 2 : 1;
 
   FILE* Fp = fopen(input->initialReconFile.c_str(), "rb");
   if (getVeryVerbose()) { std::cout << "Reading Geom from File: " << input->initialReconFile << std::endl;}
@@ -91,79 +90,33 @@ void InitialReconstructionBinReader::initializeData()
     notify(ss.str(), 0, Observable::UpdateErrorMessage);
     return;
   }
-  FILE* Fp2 = fopen(outPath.str().c_str(), "wb");
-  if(NULL == Fp2)
-  {
-    ss << "Error opening Output file '" << input->initialReconFile << "'";
-    notify(ss.str(), 0, Observable::UpdateErrorMessage);
-    return;
-  }
 
-  //If we need to interpolate
-  std::cout << input->InterpFlag << std::endl;
-  if(1 == input->InterpFlag)
+  // The file is written with y slowest and z fastest. Each y plane is read
+  // with a single call and scattered into a (z,x,y) volume.
+  size_t dims[3] = { geometry->N_z / factor, geometry->N_x / factor, geometry->N_y / factor };
+  RealVolumeType::Pointer source = RealVolumeType::New(dims, "InitialReconstruction");
+  std::vector<Real_t> plane(dims[0] * dims[1]);
+  for (size_t y = 0; y < dims[2]; y++)
   {
-    if (getVeryVerbose()) { std::cout << "Interpolating the initial input file by a factor of 2" << std::endl; }
-    uint16_t yEnd = geometry->N_y / 2;
-    uint16_t xEnd = geometry->N_x / 2;
-    uint16_t zEnd = geometry->N_z / 2;
-
-    geometry->Object->initializeWithZeros();
-
-    for (uint16_t y = 0; y < yEnd; y++)
+    size_t nItems = plane.empty() ? 0 : fread(&(plane.front()), sizeof(Real_t), plane.size(), Fp);
+    if (nItems != plane.size())
     {
-      for (uint16_t x = 0; x < xEnd; x++)
-      {
-        for (uint16_t z = 0; z < zEnd; z++)
-        {
-          Real_t buffer;
-          fread((unsigned char*)(&buffer), sizeof(Real_t), 1, Fp);
-          //Voxel replicate
-          for (uint16_t p = 0; p < 2; p++)
-          {
-            for (uint16_t q = 0; q < 2; q++)
-            {
-              for (uint16_t r = 0; r < 2; r++)
-              {
-                geometry->Object->setValue(buffer, 2 * z + p, 2 * x + q, 2 * y + r);
-              }
-            }
-          }
-        }
-      }
+      fclose(Fp);
+      ss << "Error reading the initial reconstruction from '" << input->initialReconFile << "'";
+      notify(ss.str(), 0, Observable::UpdateErrorMessage);
+      return;
     }
-  }
-  else
-  {
-    for (uint16_t i = 0; i < geometry->N_y; i++)
+    for (size_t x = 0; x < dims[1]; x++)
     {
-      for (uint16_t j = 0; j < geometry->N_x; j++)
+      for (size_t z = 0; z < dims[0]; z++)
       {
-        for (uint16_t k = 0; k < geometry->N_z; k++)
-        {
-          Real_t buffer;
-          fread((unsigned char*)(&buffer), sizeof(Real_t), 1, Fp);
-          geometry->Object->setValue(buffer, k, j, i);
-//          geometry->Object->d[k][j][i] = buffer;
-        }
+        source->setValue(plane[x * dims[0] + z], z, x, y);
       }
     }
   }
-  double buffer = 0.0;
   fclose(Fp);
-  notify("Done Reading Initial Reconstruction. Writing Upsampled File....", 0, UpdateProgressMessage);
-  for (uint16_t i = 0; i < geometry->N_y; i++)
-  {
-    for (uint16_t j = 0; j < geometry->N_x; j++)
-    {
-      for (uint16_t k = 0; k < geometry->N_z; k++)
-      {
-//        Real_t buffer = geometry->Object->d[k][j][i];
-        buffer = geometry->Object->getValue(k, j, i);
-        fwrite(&buffer, sizeof(double), 1, Fp2);
-      }
-    }
-  }
-  fclose(Fp2);
-}
 
+  if (1 == input->InterpFlag && getVeryVerbose()) { std::cout << "Interpolating the initial input file by a factor of 2" << std::endl; }
+  InitialReconstructionUpsampler::upsample(source, geometry->Object, factor);
+  notify("Done Reading Initial Reconstruction", 0, UpdateProgressMessage);
+}
@@ -95,15 +95,10 @@ void InitialReconstructionInitializer::initializeData()
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
-void InitialReconstructionInitializer::execute()
+void InitialReconstructionInitializer::ComputeGeometry(SinogramPtr sinogram, TomoInputsPtr input,
+                                                       AdvancedParametersPtr advParams, GeometryPtr geometry)
 {
-
-  SinogramPtr sinogram = getSinogram();
-  TomoInputsPtr input = getTomoInputs();
-  GeometryPtr geometry = getGeometry();
-  AdvancedParametersPtr advParams = getAdvParams();
-
-  Real_t sum = 0, max;
+  Real_t max;
 
 #ifndef FORWARD_PROJECT_MODE
   input->delta_xz = sinogram->delta_r * input->delta_xz;
@@ -139,12 +134,34 @@ void InitialReconstructionInitializer::execute()
   geometry->LengthX = ((sinogram->N_r * sinogram->delta_r));
 #endif//Forward projector mode end if
 //  Geometry->LengthY = (Geometry->EndSlice- Geometry->StartSlice)*Geometry->delta_xy;
-  geometry->LengthY = (input->yEnd - input->yStart + 1) * sinogram->delta_t;
+  geometry->LengthY = sinogram->N_t * sinogram->delta_t;
 
   geometry->N_x = floor(geometry->LengthX / input->delta_xz); //Number of voxels in x direction
   geometry->N_z = floor(input->LengthZ / input->delta_xz); //Number of voxels in z direction
   geometry->N_y = floor(geometry->LengthY / input->delta_xy); //Number of measurements in y direction
 
+//Coordinates of the left corner of the x-z object
+  geometry->x0 = -geometry->LengthX / 2;
+  geometry->z0 = -input->LengthZ / 2;
+  // Geometry->y0 = -(sinogram->N_t * sinogram->delta_t)/2 + Geometry->StartSlice*Geometry->delta_xy;
+  geometry->y0 = -(geometry->LengthY) / 2;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void InitialReconstructionInitializer::execute()
+{
+
+  SinogramPtr sinogram = getSinogram();
+  TomoInputsPtr input = getTomoInputs();
+  GeometryPtr geometry = getGeometry();
+  AdvancedParametersPtr advParams = getAdvParams();
+
+  Real_t sum = 0;
+
+  ComputeGeometry(sinogram, input, advParams, geometry);
+
   std::stringstream ss;
 
   ss << "Geometry->LengthX=" << geometry->LengthX << " nm"  << std::endl;
@@ -160,11 +177,6 @@ void InitialReconstructionInitializer::execute()
   geometry->Object = RealVolumeType::New(dims, "Geometry.Object");
 
   // geometry->Object = (DATA_TYPE ***)get_3D(geometry->N_z, geometry->N_x, geometry->N_y, sizeof(DATA_TYPE));//Allocate space for the 3-D object
-//Coordinates of the left corner of the x-z object
-  geometry->x0 = -geometry->LengthX / 2;
-  geometry->z0 = -input->LengthZ / 2;
-  // Geometry->y0 = -(sinogram->N_t * sinogram->delta_t)/2 + Geometry->StartSlice*Geometry->delta_xy;
-  geometry->y0 = -(geometry->LengthY) / 2;
 
   ss << "Geometry->X0=" << geometry->x0 << std::endl;
   ss << "Geometry->Y0=" << geometry->y0 << std::endl;
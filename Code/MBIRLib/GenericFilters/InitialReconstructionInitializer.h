@@ -61,7 +61,17 @@ class MBIRLib_EXPORT InitialReconstructionInitializer : public TomoFilter
 
     virtual ~InitialReconstructionInitializer();
 
-    Real_t absMaxArray(std::vector<Real_t>& Array);
+    static Real_t absMaxArray(std::vector<Real_t>& Array);
+
+    /**
+     * @brief Sizes the volume for a sinogram: sets the lengths, the number of
+     * voxels and the corner of the geometry. The voxel sizes of the inputs are
+     * converted from detector pixels to nm and the sample thickness is
+     * stretched and rounded to the coarsest voxel, which is why the inputs
+     * are modified. The volume itself is not allocated.
+     */
+    static void ComputeGeometry(SinogramPtr sinogram, TomoInputsPtr input,
+                                AdvancedParametersPtr advParams, GeometryPtr geometry);
 
     virtual void execute();
 
@@ -0,0 +1,169 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "InitialReconstructionUpsampler.h"
+
+#include <string.h>
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_group.h>
+#endif
+
+namespace Detail
+{
+  /**
+   * @brief Fills one z plane of the upsampled volume
+   */
+  class UpsamplePlane
+  {
+    public:
+      UpsamplePlane(RealVolumeType* source, RealVolumeType* dest, unsigned int factor, size_t z) :
+        m_Source(source), m_Dest(dest), m_Factor(factor), m_Z(z)
+      {}
+
+      void operator()() const
+      {
+        const size_t* srcDims = m_Source->getDims();
+        const size_t* dstDims = m_Dest->getDims();
+        size_t dstRowSize = dstDims[2];
+        Real_t* plane = m_Dest->d + m_Z * dstDims[1] * dstRowSize;
+        size_t srcZ = m_Z / m_Factor;
+        if (srcZ >= srcDims[0])
+        {
+          ::memset(plane, 0, sizeof(Real_t) * dstDims[1] * dstRowSize);
+          return;
+        }
+        // Number of destination y values that have a source voxel
+        size_t yCount = srcDims[2] * m_Factor;
+        if (yCount > dstRowSize) { yCount = dstRowSize; }
+
+        for (size_t x = 0; x < dstDims[1]; x++)
+        {
+          Real_t* row = plane + x * dstRowSize;
+          size_t srcX = x / m_Factor;
+          if (srcX >= srcDims[1])
+          {
+            ::memset(row, 0, sizeof(Real_t) * dstRowSize);
+            continue;
+          }
+          // Consecutive x that map onto the same source row get a copy of the first one
+          if (x % m_Factor != 0)
+          {
+            ::memcpy(row, row - dstRowSize, sizeof(Real_t) * dstRowSize);
+            continue;
+          }
+          const Real_t* srcRow = m_Source->d + (srcZ * srcDims[1] + srcX) * srcDims[2];
+          for (size_t y = 0; y < yCount; y++)
+          {
+            row[y] = srcRow[y / m_Factor];
+          }
+          for (size_t y = yCount; y < dstRowSize; y++)
+          {
+            row[y] = 0.0;
+          }
+        }
+      }
+
+    private:
+      RealVolumeType* m_Source;
+      RealVolumeType* m_Dest;
+      unsigned int m_Factor;
+      size_t m_Z;
+  };
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+InitialReconstructionUpsampler::InitialReconstructionUpsampler()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+InitialReconstructionUpsampler::~InitialReconstructionUpsampler()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void InitialReconstructionUpsampler::upsample(RealVolumeType::Pointer source, RealVolumeType::Pointer dest, unsigned int factor)
+{
+  // Without a change of size the volume is only copied
+  const size_t* srcDims = source->getDims();
+  const size_t* dstDims = dest->getDims();
+  if (factor == 1 && srcDims[0] == dstDims[0] && srcDims[1] == dstDims[1] && srcDims[2] == dstDims[2])
+  {
+    dest->copyFrom(source);
+    return;
+  }
+  size_t numPlanes = dest->getDims()[0];
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  tbb::task_group* g = new tbb::task_group;
+#endif
+  for (size_t z = 0; z < numPlanes; z++)
+  {
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    g->run(Detail::UpsamplePlane(source.get(), dest.get(), factor, z));
+#else
+    Detail::UpsamplePlane plane(source.get(), dest.get(), factor, z);
+    plane();
+#endif
+  }
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  g->wait(); // Wait for all the threads to complete before moving on.
+  delete g;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void InitialReconstructionUpsampler::initializeData()
+{
+  TomoInputsPtr input = getTomoInputs();
+  GeometryPtr geometry = getGeometry();
+  if (NULL == input->initialRecon.get())
+  {
+    setErrorCondition(-1);
+    notify("InitialReconstructionUpsampler: There is no volume from a previous resolution to upsample", 0, Observable::UpdateErrorMessage);
+    return;
+  }
+  if (getVeryVerbose()) { std::cout << "Upsampling the previous resolution by a factor of " << (1 == input->InterpFlag ? 2 : 1) << std::endl; }
+  upsample(input->initialRecon, geometry->Object, (1 == input->InterpFlag) ? 2 : 1);
+}
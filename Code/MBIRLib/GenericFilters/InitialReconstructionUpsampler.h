@@ -0,0 +1,83 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef INITIALRECONSTRUCTIONUPSAMPLER_H_
+#define INITIALRECONSTRUCTIONUPSAMPLER_H_
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/GenericFilters/InitialReconstructionInitializer.h"
+#include "MBIRLib/Reconstruction/ReconstructionStructures.h"
+
+
+/*
+ * Initializes the reconstruction from the volume of the previous resolution
+ * held in memory (TomoInputs::initialRecon). If the InterpFlag is set each
+ * voxel is replicated 2x2x2, otherwise the volume is copied as is.
+ */
+class MBIRLib_EXPORT InitialReconstructionUpsampler : public InitialReconstructionInitializer
+{
+  public:
+    MXA_SHARED_POINTERS(InitialReconstructionUpsampler)
+    MXA_STATIC_NEW_MACRO(InitialReconstructionUpsampler);
+    MXA_STATIC_NEW_SUPERCLASS(InitialReconstructionInitializer, InitialReconstructionUpsampler);
+    MXA_TYPE_MACRO_SUPER(InitialReconstructionUpsampler, InitialReconstructionInitializer)
+
+    virtual ~InitialReconstructionUpsampler();
+
+    virtual void initializeData();
+
+    /**
+     * @brief Fills dest(z,x,y) with source(z/factor, x/factor, y/factor). Voxels
+     * that fall outside of the source are set to zero. One task is run per z
+     * plane of the destination.
+     * @param source The (N_z, N_x, N_y) volume of the coarser resolution
+     * @param dest The (N_z, N_x, N_y) volume to fill
+     * @param factor The ratio of the resolutions, 1 for a straight copy
+     */
+    static void upsample(RealVolumeType::Pointer source, RealVolumeType::Pointer dest, unsigned int factor);
+
+  protected:
+    InitialReconstructionUpsampler();
+
+  private:
+    InitialReconstructionUpsampler(const InitialReconstructionUpsampler&); // Copy Constructor Not Implemented
+    void operator=(const InitialReconstructionUpsampler&); // Operator '=' Not Implemented
+};
+
+
+#endif /* INITIALRECONSTRUCTIONUPSAMPLER_H_ */
@@ -39,12 +39,16 @@
 #include "MBIRLib/Common/allocate.h"
 #include "MBIRLib/IOFilters/MRCHeader.h"
 #include "MBIRLib/IOFilters/MRCReader.h"
+#include "MBIRLib/Reconstruction/SinogramStatistics.h"
 
 
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
-MRCSinogramInitializer::MRCSinogramInitializer()
+MRCSinogramInitializer::MRCSinogramInitializer() :
+  m_LogTransform(false),
+  m_LogOffset(0.0),
+  m_LogNormalization(1.0)
 {
 
 }
@@ -56,59 +60,145 @@ MRCSinogramInitializer::~MRCSinogramInitializer()
 {
 }
 
+namespace Detail
+{
+  // Edge length of the square tiles the transpose works on. A tile of the
+  // destination is 32 columns of 32 Real_t which stays resident in L1.
+  static const uint16_t k_TransposeTileSize = 32;
+
+  /**
+   * @brief Copies one tilt of the MRC view into the sinogram. The file stores
+   * a tilt as rows of x while the sinogram stores it as columns of t (y) so the
+   * data is transposed a tile at a time. Each finished destination column of a
+   * tile is still in cache when the statistics and the optional log transform
+   * are applied to it.
+   */
+  template<typename T>
+  class TiltTransposeKernel
+  {
+    public:
+      TiltTransposeKernel(const MRCView<T>* view, const int* dataZOffsets, Real_t* counts,
+                          uint16_t N_r, uint16_t N_t,
+                          bool logTransform, Real_t offset, Real_t normalization,
+                          TiltCountStatistics* rawStats, TiltCountStatistics* logStats,
+                          size_t* numNegative) :
+        m_View(view), m_DataZOffsets(dataZOffsets), m_Counts(counts),
+        m_N_r(N_r), m_N_t(N_t),
+        m_LogTransform(logTransform), m_Offset(offset), m_Normalization(normalization),
+        m_RawStats(rawStats), m_LogStats(logStats), m_NumNegative(numNegative)
+      {}
+
+      void operator()(uint16_t i_theta) const
+      {
+        Real_t* tilt = m_Counts + static_cast<size_t>(i_theta) * m_N_r * m_N_t;
+        int z = m_DataZOffsets[i_theta];
+        const T* rows[k_TransposeTileSize];
+        TiltCountAccumulator raw;
+        TiltCountAccumulator logged;
+        size_t numNegative = 0;
+
+        for (uint16_t y0 = 0; y0 < m_N_t; y0 += k_TransposeTileSize)
+        {
+          uint16_t yCount = m_N_t - y0;
+          if(yCount > k_TransposeTileSize) { yCount = k_TransposeTileSize; }
+          for (uint16_t j = 0; j < yCount; j++)
+          {
+            rows[j] = m_View->getRow(y0 + j, z);
+          }
+          for (uint16_t x0 = 0; x0 < m_N_r; x0 += k_TransposeTileSize)
+          {
+            uint16_t xEnd = x0 + k_TransposeTileSize;
+            if(xEnd > m_N_r) { xEnd = m_N_r; }
+            for (uint16_t x = x0; x < xEnd; x++)
+            {
+              Real_t* column = tilt + static_cast<size_t>(x) * m_N_t + y0;
+              for (uint16_t j = 0; j < yCount; j++)
+              {
+                column[j] = static_cast<Real_t>(rows[j][x]);
+              }
+              for (uint16_t j = 0; j < yCount; j++)
+              {
+                raw.add(column[j]);
+              }
+              if(m_LogTransform)
+              {
+                for (uint16_t j = 0; j < yCount; j++)
+                {
+                  if(column[j] + m_Offset < 0) { numNegative++; }
+                  column[j] = SinogramStatistics::logCount(column[j], m_Offset, m_Normalization);
+                  logged.add(column[j]);
+                }
+              }
+            }
+          }
+        }
+        m_RawStats[i_theta] = raw.getStatistics();
+        if(m_LogTransform)
+        {
+          m_LogStats[i_theta] = logged.getStatistics();
+          m_NumNegative[i_theta] = numNegative;
+        }
+      }
+
+    private:
+      const MRCView<T>* m_View;
+      const int* m_DataZOffsets;
+      Real_t* m_Counts;
+      uint16_t m_N_r;
+      uint16_t m_N_t;
+      bool m_LogTransform;
+      Real_t m_Offset;
+      Real_t m_Normalization;
+      TiltCountStatistics* m_RawStats;
+      TiltCountStatistics* m_LogStats;
+      size_t* m_NumNegative;
+  };
+}
+
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
 template<typename T>
-void copyInputData(T* data, SinogramPtr sinogram, int dataZOffset, uint16_t z)
+size_t copyInputData(const MRCView<T>& view, SinogramPtr sinogram, const std::vector<int>& dataZOffsets,
+                     bool logTransform, Real_t offset, Real_t normalization)
 {
-  // std::cout << "data_z_index: " << inputs->goodViews[z] << "  dataZOffset: " << dataZOffset << "   counts offset: " << z << std::endl;
-  for (uint16_t y = 0; y < sinogram->N_t; y++)
+  sinogram->rawStatistics.resize(sinogram->N_theta);
+  sinogram->logStatistics.resize(logTransform ? sinogram->N_theta : 0);
+  std::vector<size_t> numNegative(sinogram->N_theta, 0);
+  Detail::TiltTransposeKernel<T> kernel(&view, &(dataZOffsets.front()), sinogram->counts->d,
+                                        sinogram->N_r, sinogram->N_t,
+                                        logTransform, offset, normalization,
+                                        &(sinogram->rawStatistics.front()),
+                                        logTransform ? &(sinogram->logStatistics.front()) : NULL,
+                                        &(numNegative.front()));
+  SinogramStatistics::forEachTilt(sinogram->N_theta, kernel);
+
+  size_t total = 0;
+  for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
   {
-    for (uint16_t x = 0; x < sinogram->N_r; x++)
-    {
-      size_t index = (dataZOffset * sinogram->N_r * sinogram->N_t) + (y * sinogram->N_r) + x;
-      sinogram->counts->setValue(data[index], z, x, y);
-    }
+    total += numNegative[i_theta];
   }
+  return total;
 }
 
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
-void MRCSinogramInitializer::execute()
+void MRCSinogramInitializer::ResolveRegion(const MRCHeader& header, TomoInputsPtr inputs, SinogramPtr sinogram,
+                                           int* voxelMin, int* voxelMax, std::ostream& out)
 {
-  std::stringstream ss;
-  SinogramPtr sinogram = getSinogram();
-  TomoInputsPtr inputs = getTomoInputs();
-  // int16_t i,j,k;
-  // uint16_t TotalNumMaskedViews;
-
-  Real_t sum = 0;
-
-  MRCReader::Pointer reader = MRCReader::New(true);
-  MRCHeader header;
-  ::memset(&header, 0, 1024);
-  header.feiHeaders = NULL;
-  int err = reader->readHeader(inputs->sinoFile, &header);
-  //reader->printHeader(&header, std::cout);
-  if (err < 0)
-  {
-    FREE_FEI_HEADERS( header.feiHeaders )
-    setErrorCondition(err);
-    notify("Error opening MRC File for reading", 100, UpdateErrorMessage);
-    return;
-  }
-
-  int voxelMin[3] = {0, 0, 0};
-  int voxelMax[3] = {header.nx - 1, header.ny - 1, header.nz - 1};
+  voxelMin[0] = 0;
+  voxelMin[1] = 0;
+  voxelMin[2] = 0;
+  voxelMax[0] = header.nx - 1;
+  voxelMax[1] = header.ny - 1;
+  voxelMax[2] = header.nz - 1;
   inputs->fileXSize = header.nx;
   inputs->fileYSize = header.ny;
   inputs->fileZSize = header.nz;
 
   Real_t CenterOfRot = header.nx / 2;
-  ss.str("");
-  ss << "Center of rotation in this data set is " << CenterOfRot << std::endl;
+  out << "Center of rotation in this data set is " << CenterOfRot << std::endl;
 
   if (inputs->useSubvolume == true)
   {
@@ -140,7 +230,7 @@ void MRCSinogramInitializer::execute()
 
     if(LeftLength != RightLength)
     {
-      ss << "The subvolume is not symmetric about the center. Adjusting.." << std::endl;
+      out << "The subvolume is not symmetric about the center. Adjusting.." << std::endl;
       if(LeftLength < RightLength)
       {
         Real_t tempx = CenterOfRot + LeftLength - 1;
@@ -149,7 +239,7 @@ void MRCSinogramInitializer::execute()
 
         voxelMax[0] = tempx;
         inputs->xEnd = voxelMax[0];
-        ss << "New xEnd : " << voxelMax[0] << std::endl;
+        out << "New xEnd : " << voxelMax[0] << std::endl;
       }
       else
       {
@@ -159,7 +249,7 @@ void MRCSinogramInitializer::execute()
 
         voxelMin[0] = tempx;
         inputs->xStart = voxelMin[0];
-        ss << "New xStart : " << voxelMin[0] << std::endl;
+        out << "New xStart : " << voxelMin[0] << std::endl;
       }
     }
 
@@ -168,15 +258,15 @@ void MRCSinogramInitializer::execute()
 
     //Adjusting the volume along the y-directions so we dont have
     //  issues with pixelation
-    ss << "Current y ROI: " << "yStart=" << inputs->yStart << " " << "yEnd=" << inputs->yEnd << std::endl;
+    out << "Current y ROI: " << "yStart=" << inputs->yStart << " " << "yEnd=" << inputs->yEnd << std::endl;
     int16_t disty = inputs->yEnd - inputs->yStart + 1;
-    ss << "Interpolate Factor=" << inputs->interpolateFactor << std::endl;
+    out << "Interpolate Factor=" << inputs->interpolateFactor << std::endl;
     //3*iterpFactor is to account for the prior which operates on
     //26 point 3-D neighborhood which needs 3 x-z slices at the least
     int16_t rem_temp = disty % ((int16_t)inputs->interpolateFactor * 3);
     if(rem_temp != 0)
     {
-      ss << "The number of y-pixels is not a proper multiple for multi-res" << std::endl;
+      out << "The number of y-pixels is not a proper multiple for multi-res" << std::endl;
       int16_t remainder = static_cast<int16_t>((inputs->interpolateFactor * 3) - (rem_temp));
 
       //Make sure the adjustment does not overrun the size of the data
@@ -186,12 +276,12 @@ void MRCSinogramInitializer::execute()
         inputs->yEnd = header.ny - 1;
       }
 
-      ss << "New yEnd " << inputs->yEnd << std::endl;
+      out << "New yEnd " << inputs->yEnd << std::endl;
     }
 
     voxelMax[1] = inputs->yEnd;
-    ss << "xStart=" << inputs->xStart << " " << "xEnd=" << inputs->xEnd << std::endl;
-    ss << "yStart=" << inputs->yStart << " " << "yEnd=" << inputs->yEnd << std::endl;
+    out << "xStart=" << inputs->xStart << " " << "xEnd=" << inputs->xEnd << std::endl;
+    out << "yStart=" << inputs->yStart << " " << "yEnd=" << inputs->yEnd << std::endl;
     /************************************************************/
   }
   else
@@ -238,17 +328,71 @@ void MRCSinogramInitializer::execute()
 
   // The number of views is the size of the vector
   sinogram->N_theta = inputs->goodViews.size();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MRCSinogramInitializer::execute()
+{
+  std::stringstream ss;
+  SinogramPtr sinogram = getSinogram();
+  TomoInputsPtr inputs = getTomoInputs();
+  // int16_t i,j,k;
+  // uint16_t TotalNumMaskedViews;
+
+  Real_t sum = 0;
 
-  // Read the subvolume of the MRC file which may contain extra views
-  err = reader->read(inputs->sinoFile, voxelMin, voxelMax);
+  // The file is mapped and its header parsed once. The voxel data is read
+  // straight out of the mapped pages below.
+  MRCReader::Pointer reader = MRCReader::New(true);
+  int err = reader->openMapped(inputs->sinoFile);
   if (err < 0)
   {
-    FREE_FEI_HEADERS( header.feiHeaders )
-    setErrorMessage("Error Code from Reading MRC File");
     setErrorCondition(err);
+    notify("Error opening MRC File for reading", 100, UpdateErrorMessage);
+    return;
+  }
+  const MRCHeader& header = *(reader->getHeader());
+  //reader->printHeader(reader->getHeader(), std::cout);
+
+  int voxelMin[3] = {0, 0, 0};
+  int voxelMax[3] = {0, 0, 0};
+  ResolveRegion(header, inputs, sinogram, voxelMin, voxelMax, ss);
+
+  // Views of the subvolume of the MRC file which may contain extra views
+  MRCView<int16_t> int16View;
+  MRCView<float> floatView;
+  MRCView<uint16_t> uint16View;
+  bool validView = false;
+  switch(header.mode)
+  {
+    case 1:
+      int16View = reader->getView<int16_t>(voxelMin, voxelMax);
+      validView = int16View.isValid();
+      break;
+    case 2:
+      floatView = reader->getView<float>(voxelMin, voxelMax);
+      validView = floatView.isValid();
+      break;
+    case 6:
+      uint16View = reader->getView<uint16_t>(voxelMin, voxelMax);
+      validView = uint16View.isValid();
+      break;
+    default:
+      setErrorMessage("The data type of the MRC file was not either 1 (signed 16 Bit Ints), 2 (32 bit floats) or 6 (unsigned 16 Bit Ints)");
+      setErrorCondition(-1);
+      notify(getErrorMessage().c_str(), 0, UpdateErrorMessage);
+      return;
+  }
+  if (false == validView)
+  {
+    setErrorMessage("The requested subvolume lies outside of the MRC File");
+    setErrorCondition(-2);
     notify(getErrorMessage().c_str(), 0, UpdateErrorMessage);
     return;
   }
+  reader->prefetchSections(voxelMin[2], voxelMax[2]);
 
   //Allocate a 3-D matrix to store the singoram in the form of a N_y X N_theta X N_x  matrix
   // Here in the actual data, Z is the slowest, then X, then Y (The Fastest) so we
@@ -262,43 +406,44 @@ void MRCSinogramInitializer::execute()
 
   sinogram->angles.resize(sinogram->N_theta);
 
-  // This data is read as a Z,Y,X array where X is the fastest moving variable and Z is the slowest
-  void* data = reader->getDataPointer();
-
+  // The data is laid out as a Z,Y,X array where X is the fastest moving variable and Z is the slowest
+  std::vector<int> dataZOffsets(sinogram->N_theta, 0);
   for (uint16_t z = 0; z < sinogram->N_theta; z++)
   {
-    int dataZOffset = inputs->goodViews[z] - voxelMin[2];
+    dataZOffsets[z] = inputs->goodViews[z] - voxelMin[2];
     // Copy the value of the tilt angle into the sinogram->angles vector. The angles should have
     // already been set into the inputs structure before this is ever called. This allows a user
     // to use manually specified angles for the reconstruction if the file does not have any angles
     // encoded in the .mrc file
     sinogram->angles[z] = inputs->tilts[z];
-    // Copy the data from the input into the Sinogram Data
+  }
+
+  // Copy the data from the input into the Sinogram Data
+  size_t numNegative = 0;
+  if (sinogram->N_theta > 0)
+  {
     switch(header.mode)
     {
       case 1:
-        copyInputData(reinterpret_cast<int16_t*>(data), sinogram, dataZOffset, z);
+        numNegative = copyInputData(int16View, sinogram, dataZOffsets, m_LogTransform, m_LogOffset, m_LogNormalization);
         break;
       case 2:
-        copyInputData(reinterpret_cast<float*>(data), sinogram, dataZOffset, z);
+        numNegative = copyInputData(floatView, sinogram, dataZOffsets, m_LogTransform, m_LogOffset, m_LogNormalization);
         break;
       case 6:
-        copyInputData(reinterpret_cast<uint16_t*>(data), sinogram, dataZOffset, z);
+        numNegative = copyInputData(uint16View, sinogram, dataZOffsets, m_LogTransform, m_LogOffset, m_LogNormalization);
         break;
       default:
-        FREE_FEI_HEADERS( header.feiHeaders );
-        setErrorMessage("The data type of the MRC file was not either 1 (signed 16 Bit Ints), 2 (32 bit floats) or 6 (unsigned 16 Bit Ints)");
-        setErrorCondition(err);
-        notify(getErrorMessage().c_str(), 0, UpdateErrorMessage);
-        return;
+        break;
     }
-
+  }
+  if (numNegative > 0)
+  {
+    std::cout << "Error: Negative counts! The offset value is not correctly set (" << numNegative << " entries)" << std::endl;
   }
 
-  // Clean up all the memory associated with the MRC Reader
-  reader->setDeleteMemory(true);
+  // Unmap the file. The header goes with the reader.
   reader = MRCReader::NullPointer();
-  FREE_FEI_HEADERS( header.feiHeaders )
   sinogram->R0 = -(sinogram->N_r * sinogram->delta_r) / 2;
   sinogram->RMax = (sinogram->N_r * sinogram->delta_r) / 2;
   sinogram->T0 =  -(sinogram->N_t * sinogram->delta_t) / 2;
@@ -320,14 +465,7 @@ void MRCSinogramInitializer::execute()
     //check sum calculation
     for (uint16_t i = 0; i < sinogram->N_theta; i++)
     {
-      sum = 0;
-      for (uint16_t j = 0; j < sinogram->N_r; j++)
-      {
-        for (uint16_t k = 0; k < sinogram->N_t; k++)
-        {
-          sum += sinogram->counts->getValue(i, j, k);
-        }
-      }
+      sum = sinogram->rawStatistics[i].Mean * sinogram->N_r * sinogram->N_t;
       ss << "Sinogram Checksum " << i << ":" << sum << std::endl;
     }
     std::cout << ss.str() << std::endl;
@@ -37,15 +37,23 @@
 #ifndef MRCSINOGRAMINITIALIZER_H_
 #define MRCSINOGRAMINITIALIZER_H_
 
+#include <iostream>
+
 #include "MXA/Common/MXASetGetMacros.h"
 
 #include "MBIRLib/MBIRLib.h"
 #include "MBIRLib/GenericFilters/TomoFilter.h"
+#include "MBIRLib/IOFilters/MRCHeader.h"
 #include "MBIRLib/Reconstruction/ReconstructionStructures.h"
 
 
 /*
- *
+ * Reads the tilts of an MRC file into the sinogram. Each tilt is transposed
+ * from the (y,x) order of the file into the (r,t) order of the sinogram in
+ * cache sized tiles, one task per tilt. The per tilt statistics of the counts
+ * are computed in the same pass and stored in sinogram->rawStatistics. When
+ * LogTransform is set the bright field log transform is applied in that pass
+ * as well and sinogram->logStatistics is filled.
  */
 class MBIRLib_EXPORT MRCSinogramInitializer : public TomoFilter
 {
@@ -57,8 +65,24 @@ class MBIRLib_EXPORT MRCSinogramInitializer : public TomoFilter
 
     virtual ~MRCSinogramInitializer();
 
+    MXA_INSTANCE_PROPERTY(bool, LogTransform)
+    MXA_INSTANCE_PROPERTY(Real_t, LogOffset)
+    MXA_INSTANCE_PROPERTY(Real_t, LogNormalization)
+
     virtual void execute();
 
+    /**
+     * @brief Settles the region of the file that is read from the header alone:
+     * the subvolume is made symmetric about the center of rotation and its
+     * height a multiple of the coarsest voxel, the good views are collected and
+     * N_r, N_t, N_theta and the pixel size of the sinogram are set.
+     * @param voxelMin Receives the first (x,y,tilt) of the region in the file
+     * @param voxelMax Receives the last (x,y,tilt) of the region in the file
+     * @param out Receives the adjustments that were made
+     */
+    static void ResolveRegion(const MRCHeader& header, TomoInputsPtr inputs, SinogramPtr sinogram,
+                              int* voxelMin, int* voxelMax, std::ostream& out);
+
   protected:
     MRCSinogramInitializer();
 
@@ -0,0 +1,470 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "MemoryPlanner.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "MBIRLib/Common/EIMMath.h"
+#include "MBIRLib/Common/AMatrixCol.h"
+#include "MBIRLib/Common/BitVolume.h"
+#include "MBIRLib/Common/MemoryRegistry.h"
+#include "MBIRLib/GenericFilters/InitialReconstructionInitializer.h"
+
+namespace Detail
+{
+  /* Bookkeeping of one shared TomoArray besides its values: the array object,
+   * the boost::shared_ptr control block and the allocator headers of both */
+  const uint64_t k_ArrayOverhead = sizeof(RealArrayType) + 8 * sizeof(void*);
+
+  void addAllocation(MemoryPlanLevel& level, const std::string& name, uint64_t bytes, bool setup, bool iterations)
+  {
+    MemoryPlanAllocation allocation;
+    allocation.Name = name;
+    allocation.Bytes = bytes;
+    allocation.Setup = setup;
+    allocation.Projection = iterations;
+    allocation.Iterations = iterations;
+    level.Allocations.push_back(allocation);
+  }
+
+  /* An allocation that only lives while the initial volume is forward projected */
+  void addProjectionAllocation(MemoryPlanLevel& level, const std::string& name, uint64_t bytes)
+  {
+    addAllocation(level, name, bytes, false, false);
+    level.Allocations.back().Projection = true;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MemoryPlanner::MemoryPlanner() :
+  m_Modality(BrightField),
+  m_NumberResolutions(1),
+  m_FinalResolution(1),
+  m_NumThreads(1),
+  m_BinDetector(false),
+  m_ImplicitWeights(false),
+  m_YSlabs(1),
+  m_MemoryBudget(0),
+  m_PeakBytes(0),
+  m_Feasible(false),
+  m_PlannedImplicitWeights(false),
+  m_PlannedYSlabs(1)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MemoryPlanner::~MemoryPlanner()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+unsigned int MemoryPlanner::DetectorBinning(uint16_t N_r, uint16_t N_t, unsigned int voxelSize)
+{
+  unsigned int binning = 1;
+  while(binning * 2 <= voxelSize && N_r % (binning * 2) == 0 && N_t % (binning * 2) == 0)
+  {
+    binning *= 2;
+  }
+  return binning;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::string MemoryPlanner::FormatBytes(uint64_t bytes)
+{
+  return MemoryRegistry::FormatBytes(bytes);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryPlanner::SplitYSlabs(uint16_t rows, unsigned int alignment, int slabs, std::vector<YSlab>& layout)
+{
+  layout.clear();
+  if(alignment < 1)
+  {
+    alignment = 1;
+  }
+  int blocks = (rows + alignment - 1) / alignment;
+  slabs = std::max(1, std::min(slabs, blocks));
+  for (int s = 0; s < slabs; ++s)
+  {
+    YSlab slab;
+    slab.CoreStart = static_cast<uint16_t>((s * blocks / slabs) * alignment);
+    slab.CoreEnd = static_cast<uint16_t>(std::min<unsigned int>(((s + 1) * blocks / slabs) * alignment, rows));
+    slab.Start = (s > 0) ? slab.CoreStart - alignment : slab.CoreStart;
+    slab.End = (s < slabs - 1) ? std::min<unsigned int>(slab.CoreEnd + alignment, rows) : slab.CoreEnd;
+    layout.push_back(slab);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+unsigned int MemoryPlanner::YSlabAlignment(int numberResolutions, int finalResolution)
+{
+  return 3 * static_cast<unsigned int>(powf(2.0f, numberResolutions - 1)) * finalResolution;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MemoryPlanLevel MemoryPlanner::planLevel(int resolution, bool implicitWeights, uint16_t rows, const MemoryPlanLevel* previous)
+{
+  TomoInputsPtr fullInputs = getTomoInputs();
+  SinogramPtr fullSinogram = getSinogram();
+  AdvancedParametersPtr advParams = getAdvParams();
+
+  MemoryPlanLevel level;
+  level.Resolution = resolution;
+  level.PeakBytes = 0;
+
+  // The voxel size of the resolution in pixels of the full resolution detector
+  unsigned int voxelSize = static_cast<unsigned int>(powf(2.0f, m_NumberResolutions - resolution - 1)) * m_FinalResolution;
+  level.Binning = (m_BinDetector == true) ? DetectorBinning(fullSinogram->N_r, rows, voxelSize) : 1;
+
+  // Size the volume on copies of the inputs the same way the reconstruction does
+  TomoInputsPtr inputs = TomoInputsPtr(new TomoInputs);
+  *inputs = *fullInputs;
+  inputs->interpolateFactor = powf(2.0f, m_NumberResolutions - 1) * m_FinalResolution / level.Binning;
+  inputs->delta_xz = static_cast<Real_t>(voxelSize) / level.Binning;
+  inputs->delta_xy = inputs->delta_xz;
+
+  SinogramPtr sinogram = SinogramPtr(new Sinogram);
+  *sinogram = *fullSinogram;
+  sinogram->N_r = fullSinogram->N_r / level.Binning;
+  sinogram->N_t = rows / level.Binning;
+  sinogram->delta_r = fullSinogram->delta_r * level.Binning;
+  sinogram->delta_t = fullSinogram->delta_t * level.Binning;
+
+  GeometryPtr geometry = GeometryPtr(new Geometry);
+  InitialReconstructionInitializer::ComputeGeometry(sinogram, inputs, advParams, geometry);
+
+  level.N_r = sinogram->N_r;
+  level.N_t = sinogram->N_t;
+  level.N_theta = sinogram->N_theta;
+  level.N_x = geometry->N_x;
+  level.N_y = geometry->N_y;
+  level.N_z = geometry->N_z;
+
+  const uint64_t realSize = sizeof(Real_t);
+  const uint64_t sinogramElements = static_cast<uint64_t>(level.N_theta) * level.N_r * level.N_t;
+  const uint64_t volumeElements = static_cast<uint64_t>(level.N_z) * level.N_x * level.N_y;
+  const uint64_t planeElements = static_cast<uint64_t>(level.N_z) * level.N_x;
+  const uint64_t sinogramBytes = sinogramElements * realSize;
+
+  // Measurements. The full resolution sinogram is kept for all the resolutions
+  // and a resolution that bins the detector runs against a binned copy of it
+  // with the weights aggregated from the full resolution measurements.
+  bool binnedWeights = false;
+  if(m_BinDetector == true)
+  {
+    uint64_t fullElements = static_cast<uint64_t>(fullSinogram->N_theta) * fullSinogram->N_r * rows;
+    Detail::addAllocation(level, "Full resolution sinogram", fullElements * realSize, true, true);
+    if(level.Binning > 1)
+    {
+      Detail::addAllocation(level, "Binned sinogram", sinogramBytes, true, true);
+      Detail::addAllocation(level, "Binned sinogram weights", sinogramBytes, true, true);
+      binnedWeights = true;
+    }
+  }
+  else
+  {
+    Detail::addAllocation(level, "Sinogram", sinogramBytes, true, true);
+  }
+
+  // Only bright field weights that follow from the counts can be recomputed
+  if(m_Modality == BrightField && implicitWeights == true && binnedWeights == false)
+  {
+    Detail::addAllocation(level, "Weight scale", level.N_theta * realSize, false, true);
+  }
+  else
+  {
+    Detail::addAllocation(level, "Weight", sinogramBytes, false, true);
+  }
+  if(m_Modality == BrightField)
+  {
+    // The bright field engine gives y_Est back once the error sinogram is
+    // formed and computes the final sinogram in place of the error sinogram
+    Detail::addProjectionAllocation(level, "y_Est", sinogramBytes);
+    Detail::addAllocation(level, "ErrorSino", sinogramBytes, false, true);
+  }
+  else
+  {
+    Detail::addAllocation(level, "y_Est", sinogramBytes, false, true);
+    Detail::addAllocation(level, "ErrorSino", sinogramBytes, false, true);
+    Detail::addAllocation(level, "Final sinogram", sinogramBytes, false, true);
+  }
+  if(m_Modality == BrightField)
+  {
+    uint64_t words = (sinogramElements + BitVolume::k_BitsPerWord - 1) / BitVolume::k_BitsPerWord;
+    Detail::addAllocation(level, "Bragg selector", words * sizeof(BitVolume::WordType), false, true);
+  }
+  // I_0, mu, alpha and their initial values
+  Detail::addAllocation(level, "Nuisance parameters", 6 * level.N_theta * realSize, true, true);
+
+  // Volumes
+  Detail::addAllocation(level, "Object", volumeElements * realSize, true, true);
+  if(NULL != previous)
+  {
+    // Handed over in memory and kept until this resolution is done
+    uint64_t previousElements = static_cast<uint64_t>(previous->N_z) * previous->N_x * previous->N_y;
+    Detail::addAllocation(level, "Previous resolution Object", previousElements * realSize, true, true);
+  }
+  else if(inputs->NumSIRTIter > 0)
+  {
+    Detail::addAllocation(level, "SIRT update", volumeElements * realSize, true, false);
+  }
+  if(inputs->snapshotPolicy != MBIR::SnapshotPolicy::None)
+  {
+    // One buffer is filled while the other one is written
+    Detail::addAllocation(level, "Snapshot buffers", 2 * volumeElements * realSize, false, true);
+  }
+
+  // Forward model. Each voxel line of the x-z plane stores the detector
+  // elements within reach of the detector response for every tilt that sees
+  // it. The part of a tilt that sees the volume is the detector width over the
+  // width of the projected x-z plane.
+  const Real_t reach = std::min(inputs->delta_xz, inputs->delta_xz / sqrt(3.0) + sinogram->delta_r / 2);
+  const Real_t entriesPerTilt = floor(2 * reach / sinogram->delta_r) + 1;
+  const Real_t detectorWidth = sinogram->N_r * sinogram->delta_r;
+  Real_t entriesPerColumn = 0;
+  for (uint16_t i = 0; i < level.N_theta; i++)
+  {
+    Real_t theta = sinogram->angles[i] * M_PI / 180.0;
+    Real_t projectedWidth = fabs(cos(theta)) * geometry->LengthX + fabs(sin(theta)) * inputs->LengthZ;
+    entriesPerColumn += (projectedWidth > detectorWidth) ? entriesPerTilt * detectorWidth / projectedWidth : entriesPerTilt;
+  }
+  const uint64_t entrySize = realSize + sizeof(uint32_t);
+  const uint64_t columnOverhead = sizeof(AMatrixCol) + 2 * Detail::k_ArrayOverhead;
+  uint64_t columnBytes = static_cast<uint64_t>(ceil(entriesPerColumn)) * entrySize + columnOverhead;
+  Detail::addAllocation(level, "A matrix", planeElements * columnBytes, false, true);
+
+  uint64_t maxNumberOfDetectorElts = static_cast<uint16_t>((inputs->delta_xy / sinogram->delta_t) + 2);
+  Detail::addAllocation(level, "Voxel line response", level.N_y * (maxNumberOfDetectorElts * entrySize + columnOverhead), false, true);
+
+  uint64_t detectorModel = (2 * static_cast<uint64_t>(advParams->DETECTOR_RESPONSE_BINS) + advParams->PROFILE_RESOLUTION) * level.N_theta;
+  Detail::addAllocation(level, "Detector response and voxel profile", detectorModel * realSize, false, true);
+
+  // Update magnitude maps, masks and the voxel line update order
+  Detail::addAllocation(level, "Update maps", planeElements * (2 * realSize + 2 + 2 * sizeof(int32_t)), false, true);
+
+  // Every thread shuffles its own copy of the update order and keeps its own
+  // magnitude map and visit counter
+  std::stringstream ss;
+  ss << "Per thread buffers (" << m_NumThreads << " threads)";
+  Detail::addAllocation(level, ss.str(), m_NumThreads * planeElements * (realSize + 3 * sizeof(int32_t)), false, true);
+
+  uint64_t setup = 0;
+  uint64_t projection = 0;
+  uint64_t iterations = 0;
+  for (size_t i = 0; i < level.Allocations.size(); ++i)
+  {
+    if(level.Allocations[i].Setup == true) { setup += level.Allocations[i].Bytes; }
+    if(level.Allocations[i].Projection == true) { projection += level.Allocations[i].Bytes; }
+    if(level.Allocations[i].Iterations == true) { iterations += level.Allocations[i].Bytes; }
+  }
+  level.PeakBytes = std::max(setup, std::max(projection, iterations));
+  return level;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+uint64_t MemoryPlanner::planLevels(bool implicitWeights, int slabs, std::vector<MemoryPlanLevel>& levels)
+{
+  std::vector<YSlab> layout;
+  unsigned int alignment = YSlabAlignment(m_NumberResolutions, m_FinalResolution);
+  SplitYSlabs(getSinogram()->N_t, alignment, slabs, layout);
+  uint16_t rows = 0;
+  for (size_t s = 0; s < layout.size(); ++s)
+  {
+    rows = std::max<uint16_t>(rows, layout[s].End - layout[s].Start);
+  }
+
+  uint64_t peak = 0;
+  levels.clear();
+  for (int i = 0; i < m_NumberResolutions; ++i)
+  {
+    MemoryPlanLevel level = planLevel(i, implicitWeights, rows, (i == 0) ? NULL : &(levels.back()));
+    peak = std::max(peak, level.PeakBytes);
+    levels.push_back(level);
+  }
+  return peak;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryPlanner::execute()
+{
+  TomoInputsPtr inputs = getTomoInputs();
+  SinogramPtr sinogram = getSinogram();
+  m_Levels.clear();
+  m_PeakBytes = 0;
+  m_Feasible = false;
+  m_PlannedImplicitWeights = m_ImplicitWeights;
+  m_PlannedYSlabs = std::max(m_YSlabs, 1);
+
+  if(NULL == inputs.get() || NULL == sinogram.get() || NULL == getAdvParams().get())
+  {
+    setErrorCondition(-1);
+    setErrorMessage("The memory planner needs the TomoInputs, the Sinogram and the AdvancedParameters");
+    notify(getErrorMessage(), 0, UpdateErrorMessage);
+    return;
+  }
+  if(sinogram->N_theta == 0 || sinogram->N_r == 0 || sinogram->N_t == 0
+      || sinogram->angles.size() < sinogram->N_theta || m_NumberResolutions < 1 || m_FinalResolution < 1)
+  {
+    setErrorCondition(-2);
+    setErrorMessage("The memory planner was given an empty sinogram or no resolutions");
+    notify(getErrorMessage(), 0, UpdateErrorMessage);
+    return;
+  }
+
+  // A slab is at least one aligned block of rows
+  unsigned int alignment = YSlabAlignment(m_NumberResolutions, m_FinalResolution);
+  int maxSlabs = (sinogram->N_t + alignment - 1) / alignment;
+  m_PlannedYSlabs = std::min(m_PlannedYSlabs, maxSlabs);
+
+  std::vector<MemoryPlanLevel> levels;
+  m_PeakBytes = planLevels(m_PlannedImplicitWeights, m_PlannedYSlabs, levels);
+
+  // Recomputing the weights from the counts saves a sinogram at every
+  // resolution that runs against the full detector
+  if(m_MemoryBudget > 0 && m_PeakBytes > m_MemoryBudget && m_Modality == BrightField && m_PlannedImplicitWeights == false)
+  {
+    std::vector<MemoryPlanLevel> implicitLevels;
+    uint64_t peak = planLevels(true, m_PlannedYSlabs, implicitLevels);
+    if(peak < m_PeakBytes)
+    {
+      levels.swap(implicitLevels);
+      m_PeakBytes = peak;
+      m_PlannedImplicitWeights = true;
+    }
+  }
+
+  // Every Y slab only holds its own rows of the sinograms and the volumes. The
+  // A matrix does not shrink with them so the split is dropped if it never fits.
+  if(m_MemoryBudget > 0 && m_PeakBytes > m_MemoryBudget && m_YSlabs == 0)
+  {
+    for (int slabs = 2; slabs <= maxSlabs; ++slabs)
+    {
+      std::vector<MemoryPlanLevel> slabLevels;
+      uint64_t peak = planLevels(m_PlannedImplicitWeights, slabs, slabLevels);
+      if(peak <= m_MemoryBudget)
+      {
+        levels.swap(slabLevels);
+        m_PeakBytes = peak;
+        m_PlannedYSlabs = slabs;
+        break;
+      }
+    }
+  }
+
+  m_Levels = levels;
+  m_Feasible = (m_MemoryBudget == 0 || m_PeakBytes <= m_MemoryBudget);
+
+  std::stringstream ss;
+  ss << "Predicted peak memory " << FormatBytes(m_PeakBytes);
+  if(m_MemoryBudget > 0)
+  {
+    ss << " of a " << FormatBytes(m_MemoryBudget) << " budget";
+  }
+  setErrorCondition(0);
+  setErrorMessage("");
+  notify(ss.str(), 0, UpdateProgressMessage);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MemoryPlanner::printPlan(std::ostream& out)
+{
+  out << "Memory plan: " << m_NumberResolutions << " resolution(s), " << m_NumThreads << " thread(s), "
+      << sizeof(Real_t) << " byte reals" << std::endl;
+  for (size_t l = 0; l < m_Levels.size(); ++l)
+  {
+    const MemoryPlanLevel& level = m_Levels[l];
+    out << "Resolution " << level.Resolution << ": sinogram " << level.N_theta << " x " << level.N_r << " x " << level.N_t
+        << " (tilts x r x t";
+    if(level.Binning > 1)
+    {
+      out << ", detector binned " << level.Binning << "x";
+    }
+    out << "), volume " << level.N_z << " x " << level.N_x << " x " << level.N_y << " (z x x x y)" << std::endl;
+    for (size_t i = 0; i < level.Allocations.size(); ++i)
+    {
+      out << "  " << std::left << std::setw(40) << level.Allocations[i].Name
+          << std::right << std::setw(12) << FormatBytes(level.Allocations[i].Bytes) << std::endl;
+    }
+    out << "  " << std::left << std::setw(40) << "Peak" << std::right << std::setw(12) << FormatBytes(level.PeakBytes) << std::endl;
+  }
+  out << "Peak over all resolutions: " << FormatBytes(m_PeakBytes);
+  if(m_MemoryBudget > 0)
+  {
+    out << " of a " << FormatBytes(m_MemoryBudget) << " budget: " << ((m_Feasible == true) ? "fits" : "does NOT fit");
+  }
+  out << std::endl;
+  if(m_Modality == BrightField)
+  {
+    out << "Implicit weights: " << ((m_PlannedImplicitWeights == true) ? "on" : "off");
+    if(m_PlannedImplicitWeights != m_ImplicitWeights)
+    {
+      out << " (turned on to fit the budget)";
+    }
+    out << std::endl;
+  }
+  if(m_PlannedYSlabs > 1)
+  {
+    out << "Y slabs: " << m_PlannedYSlabs << ", each resolution above is the largest slab";
+    if(m_YSlabs == 0)
+    {
+      out << " (split to fit the budget)";
+    }
+    out << std::endl;
+  }
+}
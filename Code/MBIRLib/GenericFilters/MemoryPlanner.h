@@ -0,0 +1,198 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _MemoryPlanner_H_
+#define _MemoryPlanner_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/GenericFilters/TomoFilter.h"
+#include "MBIRLib/Reconstruction/ReconstructionStructures.h"
+
+
+/**
+ * @brief One allocation of a resolution and the phases it is alive in
+ */
+typedef struct
+{
+  std::string Name;
+  uint64_t Bytes;
+  bool Setup;      // Alive while the sinogram and the initial volume are prepared
+  bool Projection; // Alive while the initial volume is forward projected
+  bool Iterations; // Alive while the voxels are updated
+} MemoryPlanAllocation;
+
+/**
+ * @brief The sizes and the allocations of one resolution of a reconstruction
+ */
+typedef struct
+{
+  int Resolution;
+  unsigned int Binning; // Detector binning the resolution runs against
+  uint16_t N_r;
+  uint16_t N_t;
+  uint16_t N_theta;
+  uint16_t N_x;
+  uint16_t N_y;
+  uint16_t N_z;
+  std::vector<MemoryPlanAllocation> Allocations;
+  uint64_t PeakBytes;
+} MemoryPlanLevel;
+
+
+/**
+ * @brief Detector rows of one Y slab, counted from the first row of the region
+ * that is reconstructed. The core rows go to the output. The halo rows around
+ * them tie the slab to its neighbours through the prior and are dropped.
+ */
+typedef struct
+{
+  uint16_t Start; // First row, halo included
+  uint16_t End; // One past the last row, halo included
+  uint16_t CoreStart;
+  uint16_t CoreEnd;
+} YSlab;
+
+
+/**
+ * @class MemoryPlanner MemoryPlanner.h MBIRLib/GenericFilters/MemoryPlanner.h
+ * @brief Predicts the memory a multi resolution reconstruction needs before
+ * anything is allocated. The volume of each resolution is sized the same way
+ * the reconstruction sizes it (InitialReconstructionInitializer::ComputeGeometry)
+ * and every sinogram, volume, A matrix and per thread buffer the engine
+ * allocates is added up for the phase it is alive in. The A matrix is
+ * estimated from the footprint of a voxel on the detector.
+ *
+ * The inputs describe the full resolution problem: the TomoInputs carry the
+ * region of the file (see MRCSinogramInitializer::ResolveRegion), the sample
+ * thickness in LengthZ and the snapshot and SIRT settings, the Sinogram its
+ * N_r, N_t, N_theta, pixel size and the angles of the good views.
+ *
+ * When a MemoryBudget is given and the reconstruction does not fit, the
+ * settings that trade speed for memory are turned on until it does: implicit
+ * weights first, then, if YSlabs is 0, more and more Y slabs. The chosen
+ * settings are in the Planned* outputs.
+ */
+class MBIRLib_EXPORT MemoryPlanner : public TomoFilter
+{
+  public:
+    MXA_SHARED_POINTERS(MemoryPlanner)
+    MXA_STATIC_NEW_MACRO(MemoryPlanner)
+    MXA_STATIC_NEW_SUPERCLASS(TomoFilter, MemoryPlanner)
+    MXA_TYPE_MACRO_SUPER(MemoryPlanner, TomoFilter)
+
+    virtual ~MemoryPlanner();
+
+    enum Modality
+    {
+      BrightField = 0,
+      HAADF = 1
+    };
+
+    // Inputs
+    MXA_INSTANCE_PROPERTY(int, Modality)
+    MXA_INSTANCE_PROPERTY(int, NumberResolutions)
+    MXA_INSTANCE_PROPERTY(int, FinalResolution)
+    MXA_INSTANCE_PROPERTY(int, NumThreads)
+    /* Every resolution runs against a binned copy of the full resolution sinogram */
+    MXA_INSTANCE_PROPERTY(bool, BinDetector)
+    MXA_INSTANCE_PROPERTY(bool, ImplicitWeights)
+    /* Number of Y slabs the rows are reconstructed in. 0 picks the fewest that fit the budget */
+    MXA_INSTANCE_PROPERTY(int, YSlabs)
+    /* Bytes available to the reconstruction. 0 plans without a limit */
+    MXA_INSTANCE_PROPERTY(uint64_t, MemoryBudget)
+
+    // Outputs
+    MXA_INSTANCE_PROPERTY(std::vector<MemoryPlanLevel>, Levels)
+    MXA_INSTANCE_PROPERTY(uint64_t, PeakBytes)
+    MXA_INSTANCE_PROPERTY(bool, Feasible)
+    MXA_INSTANCE_PROPERTY(bool, PlannedImplicitWeights)
+    MXA_INSTANCE_PROPERTY(int, PlannedYSlabs)
+
+    virtual void execute();
+
+    /**
+     * @brief Writes the allocations of every resolution and the chosen settings
+     */
+    void printPlan(std::ostream& out);
+
+    /**
+     * @brief Largest power of two binning, up to the voxel size in detector
+     * pixels, that divides both detector dimensions
+     */
+    static unsigned int DetectorBinning(uint16_t N_r, uint16_t N_t, unsigned int voxelSize);
+
+    static std::string FormatBytes(uint64_t bytes);
+
+    /**
+     * @brief Splits rows into slabs whose bounds are multiples of alignment.
+     * Every slab is extended by alignment rows into each neighbour.
+     */
+    static void SplitYSlabs(uint16_t rows, unsigned int alignment, int slabs, std::vector<YSlab>& layout);
+
+    /**
+     * @brief Detector rows the bounds of a Y slab are multiples of. The sinogram
+     * reader wants three voxels of the coarsest resolution for the prior.
+     */
+    static unsigned int YSlabAlignment(int numberResolutions, int finalResolution);
+
+  protected:
+    MemoryPlanner();
+
+    /**
+     * @brief Sizes one resolution over the given number of full resolution
+     * detector rows. previous is the resolution before it, whose volume is
+     * still alive while this one is set up, or NULL.
+     */
+    MemoryPlanLevel planLevel(int resolution, bool implicitWeights, uint16_t rows, const MemoryPlanLevel* previous);
+
+    /**
+     * @brief Plans every resolution of the largest of the given number of Y
+     * slabs and returns the peak
+     */
+    uint64_t planLevels(bool implicitWeights, int slabs, std::vector<MemoryPlanLevel>& levels);
+
+  private:
+    MemoryPlanner(const MemoryPlanner&); // Copy Constructor Not Implemented
+    void operator=(const MemoryPlanner&); // Operator '=' Not Implemented
+};
+
+#endif /* _MemoryPlanner_H_ */
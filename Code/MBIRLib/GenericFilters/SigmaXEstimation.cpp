@@ -42,64 +42,12 @@
 
 #include "MBIRLib/Common/EIMMath.h"
 #include "MBIRLib/IOFilters/MRCHeader.h"
-#include "MBIRLib/IOFilters/MRCReader.h"
+#include "MBIRLib/IOFilters/MRCFile.h"
+#include "MBIRLib/IOFilters/MRCStatisticsIndex.h"
 
 namespace Detail
 {
   const float DegToRad = 0.017453292519943f;
-
-  template<typename T>
-  void calcMinMax(T* data, int total, Real_t& min, Real_t& max, Real_t& sum2)
-  {
-    for (int i = 0; i < total; i++)
-    {
-      if(data[i] > max) { max = data[i]; }
-      if(data[i] < min) { min = data[i]; }
-      sum2 += (data[i]);
-    }
-  }
-
-  template<typename T>
-  void calcAvgDeviation(T* data, int32_t total, Real_t& dev)
-  {
-    dev = 0;
-    Real_t mean = 0;
-    for (int32_t i = 0; i < total; i++)
-    {
-      mean += data[i];
-    }
-    mean /= total;
-    for (int32_t i = 0; i < total; i++)
-    {
-      dev += fabs(data[i] - mean);
-    }
-    dev /= total;
-  }
-
-  template<typename T>
-  void calcBFAvgDeviation(T* data, int32_t total, Real_t& dev, double bf_offset)
-  {
-    dev = 0;
-    Real_t mean = 0;
-    for (int32_t i = 0; i < total; i++)
-    {
-      Real_t temp = data[i] + bf_offset;
-      if(temp > 0)
-      { mean += log(temp); }
-    }
-    mean /= total;
-    std::cout<<"Mean value = "<<mean<<std::endl;
-    
-    for (int32_t i = 0; i < total; i++)
-    {
-      Real_t temp = data[i] + bf_offset;
-      if(temp > 0)
-      { dev += fabs(log(temp) - mean); }
-    }
-    dev /= total;
-    std::cout<<"Mean absolute deviation = "<<dev<<std::endl;
-  }
-
 }
 
 
@@ -136,18 +84,16 @@ SigmaXEstimation::~SigmaXEstimation()
 // -----------------------------------------------------------------------------
 void SigmaXEstimation::execute()
 {
-  MRCHeader header;
-  ::memset(&header, 0, 1024);
-  header.feiHeaders = NULL;
-  MRCReader::Pointer reader = MRCReader::New(true);
-  int err = reader->readHeader(m_InputFile, &header);
+  // The header is only read once and the file stays open while the statistics are gathered
+  MRCFile::Pointer mrcFile = MRCFile::New();
+  int err = mrcFile->open(m_InputFile);
   if (err < 0)
   {
-    FREE_FEI_HEADERS( header.feiHeaders )
     notify("Error reading the MRC input file", 0, Observable::UpdateErrorMessage);
     setErrorCondition(-1);
     return;
   }
+  const MRCHeader& header = *(mrcFile->getHeader());
 
   //Make sure min/max have been set otherwise just use the dimensions of the data from the header
   if (m_XDims[0] < 0) { m_XDims[0] = 0; }
@@ -155,61 +101,27 @@ void SigmaXEstimation::execute()
   if (m_YDims[0] < 0) { m_YDims[0] = 0;}
   if (m_YDims[1] < 0) { m_YDims[1] = header.ny;}
 
-  int voxelMin[3] = { m_XDims[0], m_YDims[0], 0};
-  int voxelMax[3] = { m_XDims[1], m_YDims[1], 0};
+  // The X and Y ranges exclude their maximum
+  int xyMin[2] = { m_XDims[0], m_YDims[0] };
+  int xyMax[2] = { m_XDims[1] - 1, m_YDims[1] - 1 };
   Real_t sum1 = 0;
-  //    Real_t targetMin = std::numeric_limits<Real_t>::max();
-  //   Real_t targetMax = std::numeric_limits<Real_t>::min();
-  //    Real_t min = std::numeric_limits<Real_t>::max();
-  //    Real_t max = std::numeric_limits<Real_t>::min();
 
+  // The mean absolute deviation of each tilt comes from the statistics sidecar
+  // of the file and is only computed if this region has not been seen before
+  notify("Estimating Target Gain and Sigma X from Data. ", 0, Observable::UpdateProgressValueAndMessage);
+  std::vector<MRCSectionStatistics> stats;
+  MRCStatisticsIndex::Pointer index = MRCStatisticsIndex::New();
+  err = index->getStatistics(mrcFile, xyMin, xyMax, stats, m_UseBFOffset, m_BfOffset);
+  if (err < 0)
+  {
+    notify("Error computing the statistics of the MRC input file", 0, Observable::UpdateErrorMessage);
+    setErrorCondition(-1);
+    return;
+  }
   std::vector<Real_t> sum2s(header.nz);
-  int32_t voxelCount = (m_XDims[1] - m_XDims[0]) * (m_YDims[1] - m_YDims[0]);
-  float progress = 0.0;
-  // Loop over each tilt angle to compute the Target Gain Estimation
   for(int i_theta = 0; i_theta < header.nz; ++i_theta)
   {
-    voxelMin[2] = i_theta;
-    voxelMax[2] = i_theta;
-    err = reader->read(m_InputFile, voxelMin, voxelMax); // This should read the subvolume define by voxelMin and voxelMax
-    if(err < 0)
-    {
-      break;
-    }
-    progress = (i_theta / header.nz) * 100.0f;
-
-
-    Real_t sum2 = 0;
-    switch(header.mode)
-    {
-      case 0:
-        if(m_UseBFOffset) { Detail::calcBFAvgDeviation<uint8_t>(static_cast<uint8_t*>(reader->getDataPointer()), voxelCount, sum2, m_BfOffset); }
-        else {  Detail::calcAvgDeviation<uint8_t>(static_cast<uint8_t*>(reader->getDataPointer()), voxelCount, sum2); }
-        break;
-      case 1:
-        if(m_UseBFOffset) { Detail::calcBFAvgDeviation<int16_t>(static_cast<int16_t*>(reader->getDataPointer()), voxelCount, sum2, m_BfOffset); }
-        else {  Detail::calcAvgDeviation<int16_t>(static_cast<int16_t*>(reader->getDataPointer()), voxelCount, sum2); }
-        break;
-      case 2:
-        if(m_UseBFOffset) { Detail::calcBFAvgDeviation<float>(static_cast<float*>(reader->getDataPointer()), voxelCount, sum2, m_BfOffset); }
-        else {  Detail::calcAvgDeviation<float>(static_cast<float*>(reader->getDataPointer()), voxelCount, sum2); }
-        break;
-      case 3:
-        break;
-      case 4:
-        break;
-      case 6:
-        if(m_UseBFOffset) { Detail::calcBFAvgDeviation<uint16_t>(static_cast<uint16_t*>(reader->getDataPointer()), voxelCount, sum2, m_BfOffset); }
-        else {  Detail::calcAvgDeviation<uint16_t>(static_cast<uint16_t*>(reader->getDataPointer()), voxelCount, sum2); }
-        break;
-      case 16:
-        break;
-    }
-    //        if (min < targetMin) { targetMin = min; }
-    //        if (max > targetMax) { targetMax = max; }
-    sum2s[i_theta] = sum2;
-
-    notify("Estimating Target Gain and Sigma X from Data. ", (int)progress, Observable::UpdateProgressValueAndMessage);
+    sum2s[i_theta] = stats[i_theta].AbsDeviation;
   }
 
   //modify it based on any knowledge they have about the tx. attenuation
@@ -225,7 +137,6 @@ void SigmaXEstimation::execute()
   }
 
   m_SigmaXEstimate = sum1 / header.nz; ///10.0;
-  FREE_FEI_HEADERS( header.feiHeaders );
 
   //  std::cout << "Estimated Target Gain: " << m_TargetGainEstimate << std::endl;
   //  std::cout << "Estimated Sigma X: " << m_SigmaXEstimate << std::endl;
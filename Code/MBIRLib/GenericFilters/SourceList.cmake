@@ -6,6 +6,7 @@
 #--////////////////////////////////////////////////////////////////////////////
 set (MBIRLib_GenericFilters_SRCS
     ${MBIRLib_SOURCE_DIR}/GenericFilters/BackgroundCalculation.cpp
+    ${MBIRLib_SOURCE_DIR}/GenericFilters/BackProjectionInitializer.cpp
     ${MBIRLib_SOURCE_DIR}/GenericFilters/CalculateAMatrixColumn.cpp
     ${MBIRLib_SOURCE_DIR}/GenericFilters/ComputeInitialOffsets.cpp
     ${MBIRLib_SOURCE_DIR}/GenericFilters/CostData.cpp
@@ -13,6 +14,8 @@ set (MBIRLib_GenericFilters_SRCS
     ${MBIRLib_SOURCE_DIR}/GenericFilters/DetectorResponse.cpp
     ${MBIRLib_SOURCE_DIR}/GenericFilters/InitialReconstructionBinReader.cpp
     ${MBIRLib_SOURCE_DIR}/GenericFilters/InitialReconstructionInitializer.cpp
+    ${MBIRLib_SOURCE_DIR}/GenericFilters/InitialReconstructionUpsampler.cpp
+    ${MBIRLib_SOURCE_DIR}/GenericFilters/MemoryPlanner.cpp
     ${MBIRLib_SOURCE_DIR}/GenericFilters/MRCSinogramInitializer.cpp
     ${MBIRLib_SOURCE_DIR}/GenericFilters/RawSinogramInitializer.cpp
     ${MBIRLib_SOURCE_DIR}/GenericFilters/SigmaXEstimation.cpp
@@ -22,6 +25,7 @@ set (MBIRLib_GenericFilters_SRCS
 
 set (MBIRLib_GenericFilters_HDRS
     ${MBIRLib_SOURCE_DIR}/GenericFilters/BackgroundCalculation.h
+    ${MBIRLib_SOURCE_DIR}/GenericFilters/BackProjectionInitializer.h
     ${MBIRLib_SOURCE_DIR}/GenericFilters/CalculateAMatrixColumn.h
     ${MBIRLib_SOURCE_DIR}/GenericFilters/ComputeInitialOffsets.h
     ${MBIRLib_SOURCE_DIR}/GenericFilters/CostData.h
@@ -29,6 +33,8 @@ set (MBIRLib_GenericFilters_HDRS
     ${MBIRLib_SOURCE_DIR}/GenericFilters/DetectorResponse.h
     ${MBIRLib_SOURCE_DIR}/GenericFilters/InitialReconstructionBinReader.h
     ${MBIRLib_SOURCE_DIR}/GenericFilters/InitialReconstructionInitializer.h
+    ${MBIRLib_SOURCE_DIR}/GenericFilters/InitialReconstructionUpsampler.h
+    ${MBIRLib_SOURCE_DIR}/GenericFilters/MemoryPlanner.h
     ${MBIRLib_SOURCE_DIR}/GenericFilters/MRCSinogramInitializer.h
     ${MBIRLib_SOURCE_DIR}/GenericFilters/RawSinogramInitializer.h
     ${MBIRLib_SOURCE_DIR}/GenericFilters/SigmaXEstimation.h
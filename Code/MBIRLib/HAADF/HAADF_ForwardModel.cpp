@@ -5,8 +5,7 @@
 #include "MBIRLib/IOFilters/RawGeometryWriter.h"
 #include "MBIRLib/IOFilters/NuisanceParamWriter.h"
 #include "MBIRLib/IOFilters/SinogramBinWriter.h"
-#include "MBIRLib/IOFilters/VTKFileWriters.hpp"
-#include "MBIRLib/IOFilters/AvizoUniformCoordinateWriter.h"
+#include "MBIRLib/IOFilters/VolumeExporter.h"
 
 #include "MBIRLib/IOFilters/NuisanceParamReader.h"
 #include "MBIRLib/IOFilters/GainsOffsetsReader.h"
@@ -36,7 +35,9 @@ void HAADF_ForwardModel::writeNuisanceParameters(SinogramPtr sinogram)
   NuisanceParamWriter::Pointer nuisanceBinWriter = NuisanceParamWriter::New();
   nuisanceBinWriter->setNtheta(sinogram->N_theta);
 
-  if(m_AdvParams->JOINT_ESTIMATION)
+  // The output files are optional. The multi resolution driver hands the values
+  // to the next resolution in memory.
+  if(m_AdvParams->JOINT_ESTIMATION && m_TomoInputs->gainsOutputFile.empty() == false)
   {
     nuisanceBinWriter->setFileName(m_TomoInputs->gainsOutputFile);
     nuisanceBinWriter->setDataToWrite(NuisanceParamWriter::Nuisance_I_O);
@@ -47,7 +48,10 @@ void HAADF_ForwardModel::writeNuisanceParameters(SinogramPtr sinogram)
       setErrorCondition(-1);
       notify(nuisanceBinWriter->getErrorMessage().c_str(), 100, Observable::UpdateErrorMessage);
     }
+  }
 
+  if(m_AdvParams->JOINT_ESTIMATION && m_TomoInputs->offsetsOutputFile.empty() == false)
+  {
     nuisanceBinWriter->setFileName(m_TomoInputs->offsetsOutputFile);
     nuisanceBinWriter->setDataToWrite(NuisanceParamWriter::Nuisance_mu);
     nuisanceBinWriter->setData(m_Mu);
@@ -59,7 +63,7 @@ void HAADF_ForwardModel::writeNuisanceParameters(SinogramPtr sinogram)
     }
   }
 
-  if(m_AdvParams->NOISE_ESTIMATION)
+  if(m_AdvParams->NOISE_ESTIMATION && m_TomoInputs->varianceOutputFile.empty() == false)
   {
     nuisanceBinWriter->setFileName(m_TomoInputs->varianceOutputFile);
     nuisanceBinWriter->setDataToWrite(NuisanceParamWriter::Nuisance_alpha);
@@ -136,109 +140,24 @@ void HAADF_ForwardModel::writeReconstructionFile(const std::string& filepath)
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
-void HAADF_ForwardModel::writeVtkFile(const std::string& vtkFile, uint16_t cropStart, uint16_t cropEnd)
-{
-  std::stringstream ss;
-  ss << "Writing VTK file to '" << vtkFile << "'";
-  notify(ss.str(), 0, Observable::UpdateProgressMessage);
-
-  VTKStructuredPointsFileWriter vtkWriter;
-  vtkWriter.setWriteBinaryFiles(true);
-
-
-  DimsAndRes dimsAndRes;
-  dimsAndRes.xStart = cropStart;
-  dimsAndRes.xEnd = cropEnd;
-  dimsAndRes.yStart = 0;
-  dimsAndRes.yEnd = m_Geometry->N_y;
-  dimsAndRes.zStart = 0;
-  dimsAndRes.zEnd = m_Geometry->N_z;
-  dimsAndRes.resx = 1.0f;
-  dimsAndRes.resy = 1.0f;
-  dimsAndRes.resz = 1.0f;
-
-  std::vector<VtkScalarWriter*> scalarsToWrite;
-
-  VtkScalarWriter* w0 = static_cast<VtkScalarWriter*>(new TomoOutputScalarWriter(m_Geometry.get()));
-  w0->setXDims(cropStart, cropEnd);
-  w0->setYDims(0, m_Geometry->N_y);
-  w0->setZDims(0, m_Geometry->N_z);
-  w0->setWriteBinaryFiles(true);
-  scalarsToWrite.push_back(w0);
-
-  int error = vtkWriter.write<DimsAndRes>(vtkFile, &dimsAndRes, scalarsToWrite);
-  if(error < 0)
-  {
-    ss.str("");
-    ss << "Error writing vtk file\n    '" << vtkFile << "'" << std::endl;
-    setErrorCondition(-12);
-    notify(ss.str(), 0, Observable::UpdateErrorMessage);
-  }
-  delete w0;
-}
-
-// -----------------------------------------------------------------------------
-//
-// -----------------------------------------------------------------------------
-void HAADF_ForwardModel::writeMRCFile(const std::string& mrcFile, uint16_t cropStart, uint16_t cropEnd)
-{
-  /* Write the output to the MRC File */
-  std::stringstream ss;
-  ss.str("");
-  ss << "Writing MRC file to '" << mrcFile << "'";
-  notify(ss.str(), 0, Observable::UpdateProgressMessage);
-
-  MRCWriter::Pointer mrcWriter = MRCWriter::New();
-  mrcWriter->setOutputFile(mrcFile);
-  mrcWriter->setGeometry(m_Geometry);
-  mrcWriter->setAdvParams(m_AdvParams);
-  mrcWriter->setXDims(cropStart, cropEnd);
-  mrcWriter->setYDims(0, m_Geometry->N_y);
-  mrcWriter->setZDims(0, m_Geometry->N_z);
-  mrcWriter->setObservers(getObservers());
-  mrcWriter->execute();
-  if(mrcWriter->getErrorCondition() < 0)
-  {
-    ss.str("");
-    ss << "Error writing MRC file\n    '" << mrcFile << "'" << std::endl;
-    setErrorCondition(mrcWriter->getErrorCondition());
-    notify(ss.str(), 0, Observable::UpdateErrorMessage);
-  }
-
-}
-
-// -----------------------------------------------------------------------------
-//
-// -----------------------------------------------------------------------------
-void HAADF_ForwardModel::writeAvizoFile(const std::string& file, uint16_t cropStart, uint16_t cropEnd)
+void HAADF_ForwardModel::writeVolumeFiles(uint16_t cropStart, uint16_t cropEnd)
 {
-  //  std::cout << "Writing Avizo file " << file << std::endl;
-
-  /* Write the output to the Avizo File */
-  std::stringstream ss;
-  ss.str("");
-  ss << "Writing Avizo file to '" << file << "'";
-  notify(ss.str(), 0, Observable::UpdateProgressMessage);
-
-  AvizoUniformCoordinateWriter::Pointer writer = AvizoUniformCoordinateWriter::New();
-  writer->setOutputFile(file);
-  writer->setGeometry(m_Geometry);
-  writer->setAdvParams(m_AdvParams);
-  writer->setTomoInputs(m_TomoInputs);
-  writer->setXDims(cropStart, cropEnd);
-  writer->setYDims(0, m_Geometry->N_y);
-  writer->setZDims(0, m_Geometry->N_z);
-  writer->setObservers(getObservers());
-  writer->setWriteBinaryFile(true);
-  writer->execute();
-  if(writer->getErrorCondition() < 0)
+  VolumeExporter::Pointer exporter = VolumeExporter::New();
+  exporter->setGeometry(m_Geometry);
+  exporter->setTomoInputs(m_TomoInputs);
+  exporter->setAdvParams(m_AdvParams);
+  exporter->setVtkOutputFile(m_TomoInputs->vtkOutputFile);
+  exporter->setMRCOutputFile(m_TomoInputs->mrcOutputFile);
+  exporter->setAvizoOutputFile(m_TomoInputs->avizoOutputFile);
+  exporter->setXDims(cropStart, cropEnd);
+  exporter->setYDims(0, m_Geometry->N_y);
+  exporter->setZDims(0, m_Geometry->N_z);
+  exporter->setObservers(getObservers());
+  exporter->execute();
+  if(exporter->getErrorCondition() < 0)
   {
-    ss.str("");
-    ss << "Error writing Avizo file\n    '" << file << "'" << std::endl;
-    setErrorCondition(writer->getErrorCondition());
-    notify(ss.str(), 0, Observable::UpdateErrorMessage);
+    setErrorCondition(exporter->getErrorCondition());
   }
-
 }
 
 
@@ -252,12 +171,13 @@ int HAADF_ForwardModel::createInitialGainsData()
   size_t gains_dims[1] =
   { m_Sinogram->N_theta };
   m_InitialGain = RealArrayType::New(gains_dims, "sinogram->InitialGain");
-  if(m_TomoInputs->gainsInputFile.empty() == false)
+  if(NULL != m_TomoInputs->initialGains.get() || m_TomoInputs->gainsInputFile.empty() == false)
   {
-    // Read the initial Gains from a File
+    // Read the initial Gains from a File or the previous resolution
     NuisanceParamReader::Pointer gainsInitializer = NuisanceParamReader::New();
     gainsInitializer->setFileName(m_TomoInputs->gainsInputFile);
     gainsInitializer->setData(m_InitialGain);
+    gainsInitializer->setSourceData(m_TomoInputs->initialGains);
     gainsInitializer->setSinogram(m_Sinogram);
     gainsInitializer->setAdvParams(m_AdvParams);
     gainsInitializer->setTomoInputs(m_TomoInputs);
@@ -303,12 +223,13 @@ int HAADF_ForwardModel::createInitialOffsetsData()
   size_t offsets_dims[1] =
   { m_Sinogram->N_theta };
   m_InitialOffset = RealArrayType::New(offsets_dims, "sinogram->InitialOffset");
-  if(m_TomoInputs->offsetsInputFile.empty() == false)
+  if(NULL != m_TomoInputs->initialOffsets.get() || m_TomoInputs->offsetsInputFile.empty() == false)
   {
-    // Read the initial offsets from a File
+    // Read the initial offsets from a File or the previous resolution
     NuisanceParamReader::Pointer offsetsInitializer = NuisanceParamReader::New();
     offsetsInitializer->setFileName(m_TomoInputs->offsetsInputFile);
     offsetsInitializer->setData(m_InitialOffset);
+    offsetsInitializer->setSourceData(m_TomoInputs->initialOffsets);
     offsetsInitializer->setSinogram(m_Sinogram);
     offsetsInitializer->setAdvParams(m_AdvParams);
     offsetsInitializer->setTomoInputs(m_TomoInputs);
@@ -363,12 +284,13 @@ int HAADF_ForwardModel::createInitialVariancesData()
   size_t variance_dims[1] =
   { m_Sinogram->N_theta };
   m_InitialVariance = RealArrayType::New(variance_dims, "sinogram->InitialVariance");
-  if(m_TomoInputs->varianceInputFile.empty() == false)
+  if(NULL != m_TomoInputs->initialVariances.get() || m_TomoInputs->varianceInputFile.empty() == false)
   {
-    // Read the initial variances from a File
+    // Read the initial variances from a File or the previous resolution
     NuisanceParamReader::Pointer variancesInitializer = NuisanceParamReader::New();
     variancesInitializer->setFileName(m_TomoInputs->varianceInputFile);
     variancesInitializer->setData(m_InitialVariance);
+    variancesInitializer->setSourceData(m_TomoInputs->initialVariances);
     variancesInitializer->setSinogram(m_Sinogram);
     variancesInitializer->setTomoInputs(m_TomoInputs);
     variancesInitializer->setGeometry(m_Geometry);
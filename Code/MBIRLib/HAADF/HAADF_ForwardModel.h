@@ -107,14 +107,24 @@ class HAADF_ForwardModel : public Observable
     MXA_INSTANCE_PROPERTY(RealArrayType::Pointer, Mu) //Offset
     MXA_INSTANCE_PROPERTY(RealArrayType::Pointer, Alpha) //Noise variance refinement factor
 
+    /**
+     * @brief The weight of a measurement before the noise variance refinement is applied
+     */
+    static inline Real_t countsToWeight(Real_t counts)
+    {
+#ifndef IDENTITY_NOISE_MODEL
+      return (counts != 0) ? 1.0 / counts : 1e-10;
+#else
+      return 1.0;
+#endif //IDENTITY_NOISE_MODEL endif
+    }
+
 
     void writeNuisanceParameters(SinogramPtr sinogram);
     void writeSinogramFile(SinogramPtr sinogram,
                            RealVolumeType::Pointer Final_Sinogram);
     void writeReconstructionFile(const std::string& filepath);
-    void writeVtkFile(const std::string& vtkFile, uint16_t cropStart, uint16_t cropEnd);
-    void writeMRCFile(const std::string& mrcFile, uint16_t cropStart, uint16_t cropEnd);
-    void writeAvizoFile(const std::string& file, uint16_t cropStart, uint16_t cropEnd);
+    void writeVolumeFiles(uint16_t cropStart, uint16_t cropEnd);
 
     int createInitialGainsData();
     int createInitialOffsetsData();
@@ -42,11 +42,20 @@
 
 #include <iostream>
 
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_scheduler_init.h>
+#endif
+
 #include "MXA/Utilities/MXADir.h"
 #include "MXA/Utilities/MXAFileInfo.h"
 #include "MXA/Utilities/StringUtils.h"
 #include "MBIRLib/Common/EIMMath.h"
+#include "MBIRLib/Common/MemoryRegistry.h"
+#include "MBIRLib/GenericFilters/MRCSinogramInitializer.h"
+#include "MBIRLib/IOFilters/MRCReader.h"
+#include "MBIRLib/IOFilters/ReconstructionCheckpoint.h"
 #include "MBIRLib/Reconstruction/ReconstructionConstants.h"
+#include "MBIRLib/Reconstruction/SinogramStatistics.h"
 
 
 // -----------------------------------------------------------------------------
@@ -61,6 +70,10 @@ HAADF_MultiResolutionReconstruction::HAADF_MultiResolutionReconstruction() :
   m_BrightFieldFile(""),
   m_InitialReconstructionFile(""),
   m_DeleteTempFiles(false),
+  m_WriteIntermediateFiles(false),
+  m_SnapshotPolicy(MBIR::SnapshotPolicy::EveryIteration),
+  m_SnapshotInterval(1),
+  m_CheckpointInterval(-1),
   m_NumberResolutions(1),
   m_SampleThickness(100.0f),
   m_TargetGain(0.0f),
@@ -76,7 +89,12 @@ HAADF_MultiResolutionReconstruction::HAADF_MultiResolutionReconstruction() :
   m_InterpolateInitialReconstruction(false),
   m_DefaultVariance(1.0f),
   m_InitialReconstructionValue(0.0f),
+  m_SIRTIterations(0),
   m_DefaultPixelSize(1.0),
+  m_MemoryBudget(0),
+  m_MemoryReportFile(""),
+  m_FinalCost(0.0),
+  m_FinalVoxelUpdatePasses(0),
   m_Cancel(false)
 {
 
@@ -123,6 +141,7 @@ void HAADF_MultiResolutionReconstruction::printInputs(TomoInputsPtr inputs, std:
   PRINT_VAR(out, inputs, extendObject);
   PRINT_VAR(out, inputs, interpolateFactor);
   PRINT_VAR(out, inputs, defaultInitialRecon);
+  PRINT_VAR(out, inputs, NumSIRTIter);
 
 
   PRINT_VAR(out, inputs, targetGain);
@@ -183,19 +202,80 @@ void HAADF_MultiResolutionReconstruction::execute()
   pipelineProgressMessage(ss.str());
   ss.str("");
 
+  // A resumed reconstruction starts at the resolution its checkpoint was taken at
+  int resumeResolution = 0;
+  if(m_ResumeFile.empty() == false)
+  {
+    std::map<std::string, Real_t> counters;
+    if(ReconstructionCheckpoint::ReadCounters(m_ResumeFile, counters) < 0 || counters.find("Resolution") == counters.end())
+    {
+      ss.str("");
+      ss << "Could not read the checkpoint to resume from: " << m_ResumeFile << std::endl;
+      setErrorCondition(-1);
+      pipelineErrorMessage(ss.str());
+      return;
+    }
+    resumeResolution = static_cast<int>(counters["Resolution"]);
+    ss.str("");
+    ss << "-- Resuming at resolution " << resumeResolution << " from " << m_ResumeFile;
+    pipelineProgressMessage(ss.str());
+  }
+
   TomoInputsPtr prevInputs = TomoInputsPtr(new TomoInputs);
   HAADF_ReconstructionEngine::InitializeTomoInputs(prevInputs);
 
+  // The results of each resolution are handed to the next one in memory
+  GeometryPtr prevGeometry;
+  HAADF_ForwardModel::Pointer prevForwardModel;
+
+  // The sinogram is read once and the counts are shared by every resolution
+  TomoInputsPtr fullInputs;
+  SinogramPtr fullSinogram;
+
   TomoInputsPtr bf_inputs = TomoInputsPtr(new TomoInputs);
   HAADF_ReconstructionEngine::InitializeTomoInputs(bf_inputs);
 
-  for (int i = 0; i < m_NumberResolutions; ++i)
+  // Find out if the reconstruction fits before anything is allocated
+  MemoryPlanner::Pointer plan = planMemory();
+  if(NULL != plan.get())
+  {
+    ss.str("");
+    plan->printPlan(ss);
+    pipelineProgressMessage(ss.str());
+    if(plan->getFeasible() == false)
+    {
+      ss.str("");
+      ss << "The reconstruction needs " << MemoryPlanner::FormatBytes(plan->getPeakBytes()) << " which is more than the memory budget of "
+         << MemoryPlanner::FormatBytes(m_MemoryBudget) << std::endl;
+      setErrorCondition(-1);
+      pipelineErrorMessage(ss.str());
+      return;
+    }
+  }
+
+  // A warm start replaces the coarser resolutions
+  int firstResolution = 0;
+  if(NULL != m_WarmStartGeometry.get() && NULL != m_WarmStartForwardModel.get())
+  {
+    firstResolution = m_NumberResolutions - 1;
+    prevGeometry = m_WarmStartGeometry;
+    prevForwardModel = m_WarmStartForwardModel;
+    pipelineProgressMessage("-- Starting the final resolution from a converged reconstruction");
+  }
+  m_FinalGeometry = GeometryPtr();
+  m_FinalForwardModel = HAADF_ForwardModel::NullPointer();
+
+  for (int i = firstResolution; i < m_NumberResolutions; ++i)
   {
     if(getCancel() == true)
     {
       setErrorCondition(-999);
       return;
     }
+    if(i < resumeResolution)
+    {
+      continue;
+    }
 
     TomoInputsPtr inputs = TomoInputsPtr(new TomoInputs);
     HAADF_ReconstructionEngine::InitializeTomoInputs(inputs);
@@ -208,20 +288,30 @@ void HAADF_MultiResolutionReconstruction::execute()
     ss << "Extend Object Flag" << inputs->extendObject << std::endl;
     pipelineProgressMessage(ss.str());
 
-    /* Get our input files from the last resolution iteration */
-    inputs->gainsInputFile = prevInputs->gainsOutputFile;
-    inputs->offsetsInputFile = prevInputs->offsetsOutputFile;
-    inputs->varianceInputFile = prevInputs->varianceOutputFile;
-    if(i == 0)
+    /* Get our inputs from the last resolution iteration */
+    if(NULL == prevGeometry.get())
     {
       inputs->initialReconFile = getInitialReconstructionFile();
     }
     else
     {
-      inputs->initialReconFile = prevInputs->reconstructedOutputFile;
+      inputs->initialRecon = prevGeometry->Object;
+      if(m_AdvParams->JOINT_ESTIMATION)
+      {
+        inputs->initialGains = prevForwardModel->getI_0();
+        inputs->initialOffsets = prevForwardModel->getMu();
+      }
+      if(m_AdvParams->NOISE_ESTIMATION)
+      {
+        inputs->initialVariances = prevForwardModel->getAlpha();
+      }
     }
 
-    if(i == 0)
+    if(i == firstResolution && NULL != prevGeometry.get())
+    {
+      inputs->InterpFlag = 0; // A warm start is already at this resolution
+    }
+    else if(i == 0)
     {
       inputs->InterpFlag = (getInterpolateInitialReconstruction() == false) ? 0 : 1;
     }
@@ -234,7 +324,17 @@ void HAADF_MultiResolutionReconstruction::execute()
 
     /* Now set the input files for this resolution */
     inputs->sinoFile = m_InputFile;
-    inputs->tempDir = m_TempDir + MXADir::Separator + StringUtils::numToString(inputs->interpolateFactor / static_cast<int>(powf(2.0f, i))) + std::string("x");
+    inputs->snapshotPolicy = m_SnapshotPolicy;
+    inputs->snapshotInterval = m_SnapshotInterval;
+    inputs->checkpointInterval = m_CheckpointInterval;
+    inputs->resolution = i;
+    if(i == resumeResolution)
+    {
+      inputs->resumeFile = m_ResumeFile;
+    }
+    std::string resolutionName = StringUtils::numToString(inputs->interpolateFactor / static_cast<int>(powf(2.0f, i))) + std::string("x");
+    inputs->tempDir = m_TempDir + MXADir::Separator + resolutionName;
+    MemoryRegistry::Instance()->beginLevel("resolution " + resolutionName);
 
     //Make sure the directory is created:
     bool success = MXADir::mkdir(inputs->tempDir, true);
@@ -244,6 +344,7 @@ void HAADF_MultiResolutionReconstruction::execute()
       ss << "Could not create path: " << inputs->tempDir << std::endl;
       setErrorCondition(-1);
       pipelineErrorMessage(ss.str());
+      writeMemoryReport();
       return;
     }
 
@@ -256,10 +357,6 @@ void HAADF_MultiResolutionReconstruction::execute()
     }
     else
     {
-      ss.str("");
-      ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::ReconstructedObjectFile;
-      inputs->reconstructedOutputFile = ss.str();
-
       inputs->vtkOutputFile = "";
       inputs->mrcOutputFile = "";
       inputs->avizoOutputFile = "";
@@ -268,24 +365,29 @@ void HAADF_MultiResolutionReconstruction::execute()
     // Line up all the temp files that we are going to delete
     ss.str("");
     ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::FinalGainParametersFile;
-    inputs->gainsOutputFile = ss.str();
+    if(m_WriteIntermediateFiles) { inputs->gainsOutputFile = ss.str(); }
     tempFiles.push_back(ss.str());
 
     ss.str("");
     ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::FinalOffsetParametersFile;
-    inputs->offsetsOutputFile = ss.str();
+    if(m_WriteIntermediateFiles) { inputs->offsetsOutputFile = ss.str(); }
     tempFiles.push_back(ss.str());
 
     ss.str("");
     ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::FinalVariancesFile;
-    inputs->varianceOutputFile = ss.str();
+    if(m_WriteIntermediateFiles) { inputs->varianceOutputFile = ss.str(); }
+    tempFiles.push_back(ss.str());
+
+    ss.str("");
+    ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::CheckpointFile;
+    inputs->checkpointFile = ss.str();
     tempFiles.push_back(ss.str());
 
 
     //initialize the Bragg selector file
     ss.str("");
     ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::BraggSelectorFile;
-    inputs->braggSelectorFile = ss.str();
+    if(m_WriteIntermediateFiles) { inputs->braggSelectorFile = ss.str(); }
     tempFiles.push_back(ss.str());
 
     // Create the paths for all the temp files that we want to delete
@@ -303,16 +405,13 @@ void HAADF_MultiResolutionReconstruction::execute()
 
     ss.str("");
     ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::ReconstructedObjectFile;
+    if(m_WriteIntermediateFiles) { inputs->reconstructedOutputFile = ss.str(); }
     tempFiles.push_back(ss.str());
 
     ss.str("");
     ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::VoxelProfileFile;
     tempFiles.push_back(ss.str());
 
-    ss.str("");
-    ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::UpsampledBinFile;
-    tempFiles.push_back(ss.str());
-
     ss.str("");
     ss << inputs->tempDir << MXADir::Separator << MBIR::Defaults::FilteredMagMapFile;
     tempFiles.push_back(ss.str());
@@ -344,6 +443,7 @@ void HAADF_MultiResolutionReconstruction::execute()
     if(i == 0)
     {
       inputs->defaultInitialRecon = getInitialReconstructionValue();
+      inputs->NumSIRTIter = getSIRTIterations();
       inputs->defaultVariance = getDefaultVariance();
     }
     inputs->delta_xy = powf(2.0f, getNumberResolutions() - i - 1) * static_cast<Real_t>(m_FinalResolution);
@@ -403,8 +503,62 @@ void HAADF_MultiResolutionReconstruction::execute()
     sinogram->delta_r = getDefaultPixelSize();
     sinogram->delta_t = getDefaultPixelSize();
 
-    //Calculate approximate memory required
-    memCalculate(inputs);
+    // The engine never writes the HAADF counts so they are not copied. The
+    // bright field counts are offset in place and are still read per resolution
+    // by the engine at the full detector size, so the detector is only binned
+    // without them.
+    if(NULL == fullSinogram.get() && MXAFileInfo::extension(inputs->sinoFile).compare("bin") != 0)
+    {
+      fullSinogram = SinogramPtr(new Sinogram);
+      *fullSinogram = *sinogram;
+      err = readFullSinogram(inputs, fullSinogram);
+      if(err < 0)
+      {
+        break;
+      }
+      fullInputs = inputs;
+    }
+    if(NULL != fullSinogram.get())
+    {
+      // The subvolume the reader settled on is carried over
+      unsigned int binning = 1;
+      if(getBrightFieldFile().empty() == true)
+      {
+        binning = detectorBinning(fullSinogram, i);
+      }
+      if(binning > 1)
+      {
+        // The binned sinogram carries the weights aggregated from the full
+        // resolution measurements. The A matrix and the detector response
+        // follow the binned delta_r and delta_t.
+        sinogram = SinogramStatistics::binDetector(fullSinogram, binning, &HAADF_ForwardModel::countsToWeight);
+        forwardModel->setSinogram(sinogram);
+      }
+      else
+      {
+        *sinogram = *fullSinogram;
+      }
+      inputs->xStart = fullInputs->xStart;
+      inputs->xEnd = fullInputs->xEnd;
+      inputs->yStart = fullInputs->yStart;
+      inputs->yEnd = fullInputs->yEnd;
+      inputs->zStart = fullInputs->zStart;
+      inputs->zEnd = fullInputs->zEnd;
+      inputs->fileXSize = fullInputs->fileXSize;
+      inputs->fileYSize = fullInputs->fileYSize;
+      inputs->fileZSize = fullInputs->fileZSize;
+      inputs->goodViews = fullInputs->goodViews;
+
+      // The voxel sizes and the interpolation factor are multiples of delta_r
+      // so they are rescaled to keep the same physical size on the binned grid
+      inputs->delta_xy /= binning;
+      inputs->delta_xz /= binning;
+      inputs->interpolateFactor /= binning;
+
+      ss.str("");
+      ss << "Detector binning " << binning << "x" << binning << ": N_r=" << sinogram->N_r << " N_t=" << sinogram->N_t;
+      pipelineProgressMessage(ss.str());
+    }
 
     //Create an Engine and initialize all the structures
     HAADF_ReconstructionEngine::Pointer engine = HAADF_ReconstructionEngine::New();
@@ -421,9 +575,10 @@ void HAADF_MultiResolutionReconstruction::execute()
     engine->setBFTomoInputs(bf_inputs);
     engine->setBFSinogram(bf_sinogram);
     engine->setForwardModel(forwardModel);
+    engine->setPrecomputeCache(m_PrecomputeCache);
     // We need to get messages to the gui or command line
     engine->addObserver(this);
-    engine->setMessagePrefix(StringUtils::numToString(inputs->interpolateFactor / static_cast<int>(powf(2.0f, i))) + std::string("x: "));
+    engine->setMessagePrefix(resolutionName + std::string(": "));
     ss.str("");
     ss << "Sinogram Inputs -----------------------------------------" << std::endl;
     printInputs(inputs, ss);
@@ -434,9 +589,27 @@ void HAADF_MultiResolutionReconstruction::execute()
     pipelineProgressMessage(ss.str());
 
     engine->execute();
+    m_FinalCost = engine->getFinalCost();
+    m_FinalVoxelUpdatePasses = engine->getVoxelUpdatePasses();
+    if(engine->getErrorCondition() < 0)
+    {
+      err = engine->getErrorCondition();
+    }
     engine = HAADF_ReconstructionEngine::NullPointer();
 
+    // The observers get what the resolution used before the next one starts
+    reportMemory();
+    MemoryRegistry::Instance()->endLevel();
+    if(err < 0)
+    {
+      break;
+    }
+
+    // Only the volume that was just reconstructed is kept alive
+    inputs->initialRecon = RealVolumeType::NullPointer();
     prevInputs = inputs;
+    prevGeometry = geometry;
+    prevForwardModel = forwardModel;
 
     // Get any tempfiles created by the process such as intermediate files for display
     // during the reconstruction
@@ -453,6 +626,12 @@ void HAADF_MultiResolutionReconstruction::execute()
     ss << inputs->tempDir;
     tempFiles.push_back(ss.str());
   }
+  if(err >= 0)
+  {
+    m_FinalGeometry = prevGeometry;
+    m_FinalForwardModel = prevForwardModel;
+  }
+  writeMemoryReport();
 
 
   if (getDeleteTempFiles() == true)
@@ -484,52 +663,158 @@ void HAADF_MultiResolutionReconstruction::execute()
   setErrorCondition(err);
 }
 
-void HAADF_MultiResolutionReconstruction::memCalculate(TomoInputsPtr inputs)
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADF_MultiResolutionReconstruction::reportMemory()
 {
-  float GeomNx, GeomNy, GeomNz;
-  float SinoNr, SinoNt, SinoNtheta;
-  SinoNr = static_cast<float>(inputs->xEnd - inputs->xStart + 1);
-  SinoNt = static_cast<float>(inputs->yEnd - inputs->yStart + 1);
-  SinoNtheta = static_cast<float>(inputs->zEnd - inputs->zStart + 1);
-
-  AdvancedParametersPtr advancedParams = AdvancedParametersPtr(new AdvancedParameters);
-  HAADF_ReconstructionEngine::InitializeAdvancedParams(advancedParams);
+  std::stringstream ss;
+  MemoryRegistry::Instance()->printReport(ss);
+  pipelineProgressMessage(ss.str());
+}
 
-  if(inputs->extendObject == 1)
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADF_MultiResolutionReconstruction::writeMemoryReport()
+{
+  if(m_MemoryReportFile.empty() == true)
+  {
+    return;
+  }
+  if(MemoryRegistry::Instance()->writeJson(m_MemoryReportFile) < 0)
   {
-    GeomNx = (SinoNr / m_FinalResolution) * 4; //TODO:Need to access X_Stretch and
+    pipelineWarningMessage("Could not write the memory report to " + m_MemoryReportFile + "\n");
   }
-  else
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADF_MultiResolutionReconstruction::readFullSinogram(TomoInputsPtr inputs, SinogramPtr sinogram)
+{
+  // Reconstructions that share a cache (batch, sweep, server) read the file once between them
+  std::string key;
+  if(NULL != m_PrecomputeCache.get())
   {
-    GeomNx = SinoNr / m_FinalResolution;
+    key = HAADF_PrecomputeCache::MakeSinogramKey(inputs, sinogram);
+    if(m_PrecomputeCache->findSinogram(key, inputs, sinogram) == true)
+    {
+      pipelineProgressMessage("Reusing the sinogram of an earlier reconstruction");
+      return 0;
+    }
   }
 
-  GeomNy = SinoNt / m_FinalResolution;
-  GeomNz = advancedParams->Z_STRETCH * (m_SampleThickness / (m_FinalResolution)); // TODO: need to access Sinogram_deltar and z_stretch.
-  //This is wrong currently. Need to multiply m_FinalResolution by size of voxel in nm
-
-  float dataTypeMem = sizeof(Real_t);
-  float ObjectMem = GeomNx * GeomNy * GeomNz * dataTypeMem;
-  float SinogramMem = SinoNr * SinoNt * SinoNtheta * dataTypeMem;
-  float ErroSinoMem = SinogramMem;
-  float WeightMem = SinogramMem; //Weight matrix
-  float A_MatrixMem;
-  if(0 == inputs->extendObject)
+  MRCSinogramInitializer::Pointer reader = MRCSinogramInitializer::New();
+  reader->setTomoInputs(inputs);
+  reader->setSinogram(sinogram);
+  reader->setAdvParams(m_AdvParams);
+  reader->addObserver(this);
+  reader->setVerbose(false);
+  reader->setVeryVerbose(false);
+  reader->execute();
+  if(reader->getErrorCondition() < 0)
   {
-    A_MatrixMem = GeomNx * GeomNz * (m_FinalResolution * 3 * (dataTypeMem + 4) * SinoNtheta); // 4 is the bytes to store the counts
-    //*+4 correspodns to bytes to store a single double and a unsigned into to
-    //store the offset. 3*m_FinalRes is the approximate number of detector elements hit per voxel
+    std::stringstream ss;
+    ss << "Error reading the input file: '" << inputs->sinoFile << "'";
+    setErrorCondition(reader->getErrorCondition());
+    pipelineErrorMessage(ss.str());
+    return reader->getErrorCondition();
   }
-  else
+  if(key.empty() == false)
   {
-    A_MatrixMem = GeomNx * GeomNz * (m_FinalResolution * (dataTypeMem + 4) * SinoNtheta); //Since we are reconstructing a larger region there are several voxels with no projection data. so instead of each voxel hitting 3*m_FinalRes det entries we aproximate it by m_FinalRes
+    m_PrecomputeCache->insertSinogram(key, inputs, sinogram);
   }
-  float NuisanceParamMem = SinoNtheta * dataTypeMem * 3; //3 is for gains offsets and noise var
+  return 0;
+}
 
-  float TotalMem = ObjectMem + SinogramMem * 2 + ErroSinoMem + WeightMem + A_MatrixMem + NuisanceParamMem; //in bytes
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+unsigned int HAADF_MultiResolutionReconstruction::detectorBinning(SinogramPtr sinogram, int resolution)
+{
+  unsigned int voxelSize = static_cast<unsigned int>(powf(2.0f, getNumberResolutions() - resolution - 1)) * m_FinalResolution;
+  return MemoryPlanner::DetectorBinning(sinogram->N_r, sinogram->N_t, voxelSize);
+}
 
-  TotalMem /= (1e9); //To get answer in Gb
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MemoryPlanner::Pointer HAADF_MultiResolutionReconstruction::planMemory()
+{
+  // Only the header of an MRC file is needed to size the reconstruction
+  if(MXAFileInfo::extension(m_InputFile).compare("bin") == 0 || NULL == m_AdvParams.get())
+  {
+    return MemoryPlanner::NullPointer();
+  }
+  MRCHeader header;
+  ::memset(&header, 0, sizeof(header));
+  MRCReader::Pointer reader = MRCReader::New(true);
+  if(reader->readHeader(m_InputFile, &header) < 0)
+  {
+    return MemoryPlanner::NullPointer();
+  }
 
-  std::cout << "Total Max Mem needed = " << TotalMem << " Gb" << std::endl;
+  // The full resolution inputs, set up the same way the resolutions are
+  TomoInputsPtr inputs = TomoInputsPtr(new TomoInputs);
+  HAADF_ReconstructionEngine::InitializeTomoInputs(inputs);
+  inputs->extendObject = getExtendObject();
+  inputs->interpolateFactor = powf((float)2, (float)getNumberResolutions() - 1) * m_FinalResolution;
+  inputs->LengthZ = m_SampleThickness;
+  inputs->NumSIRTIter = getSIRTIterations();
+  inputs->snapshotPolicy = m_SnapshotPolicy;
+  inputs->tilts = m_Tilts;
+  if(m_Subvolume.size() > 0)
+  {
+    inputs->useSubvolume = true;
+    inputs->xStart = m_Subvolume[0];
+    inputs->xEnd = m_Subvolume[3];
+    inputs->yStart = m_Subvolume[1];
+    inputs->yEnd = m_Subvolume[4];
+    inputs->zStart = m_Subvolume[2];
+    inputs->zEnd = m_Subvolume[5];
+  }
+  inputs->excludedViews = m_ViewMasks;
+
+  SinogramPtr sinogram = SinogramPtr(new Sinogram);
+  HAADF_ReconstructionEngine::InitializeSinogram(sinogram);
+  sinogram->delta_r = getDefaultPixelSize();
+  sinogram->delta_t = getDefaultPixelSize();
 
+  int voxelMin[3] = {0, 0, 0};
+  int voxelMax[3] = {0, 0, 0};
+  std::stringstream ss;
+  MRCSinogramInitializer::ResolveRegion(header, inputs, sinogram, voxelMin, voxelMax, ss);
+  if(NULL != header.feiHeaders)
+  {
+    free(header.feiHeaders);
+  }
+  if(inputs->tilts.size() < sinogram->N_theta)
+  {
+    return MemoryPlanner::NullPointer();
+  }
+  sinogram->angles.assign(inputs->tilts.begin(), inputs->tilts.begin() + sinogram->N_theta);
+
+  MemoryPlanner::Pointer planner = MemoryPlanner::New();
+  planner->setTomoInputs(inputs);
+  planner->setSinogram(sinogram);
+  planner->setAdvParams(m_AdvParams);
+  planner->setModality(MemoryPlanner::HAADF);
+  planner->setNumberResolutions(m_NumberResolutions);
+  planner->setFinalResolution(m_FinalResolution);
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  tbb::task_scheduler_init init;
+  planner->setNumThreads(init.default_num_threads());
+#else
+  planner->setNumThreads(1);
+#endif
+  planner->setBinDetector(getBrightFieldFile().empty());
+  planner->setImplicitWeights(false);
+  planner->setMemoryBudget(m_MemoryBudget);
+  planner->execute();
+  if(planner->getErrorCondition() < 0)
+  {
+    return MemoryPlanner::NullPointer();
+  }
+  return planner;
 }
@@ -43,6 +43,7 @@
 #include "MBIRLib/Common/FilterPipeline.h"
 #include "MBIRLib/Reconstruction/ReconstructionStructures.h"
 #include "MBIRLib/HAADF/HAADF_ReconstructionEngine.h"
+#include "MBIRLib/GenericFilters/MemoryPlanner.h"
 
 /**
  * @brief This class controls the multiresolution reconstruction of an input
@@ -71,6 +72,19 @@ class HAADF_MultiResolutionReconstruction : public FilterPipeline
     MXA_INSTANCE_STRING_PROPERTY(BrightFieldFile)
     MXA_INSTANCE_STRING_PROPERTY(InitialReconstructionFile)
     MXA_INSTANCE_PROPERTY(bool, DeleteTempFiles)
+    /* Write the volume and nuisance parameters of every resolution to the temp
+     * directory. They are handed to the next resolution in memory either way. */
+    MXA_INSTANCE_PROPERTY(bool, WriteIntermediateFiles)
+    /* Which intermediate volumes are written for display (see MBIR::SnapshotPolicy)
+     * and the iterations or seconds between them */
+    MXA_INSTANCE_PROPERTY(unsigned int, SnapshotPolicy)
+    MXA_INSTANCE_PROPERTY(Real_t, SnapshotInterval)
+    /* Seconds between checkpoints of the reconstruction state. 0 only writes
+     * one when the reconstruction is cancelled, < 0 disables them */
+    MXA_INSTANCE_PROPERTY(Real_t, CheckpointInterval)
+    /* Checkpoint to restart the reconstruction from. The resolutions before
+     * the one it was taken at are skipped */
+    MXA_INSTANCE_STRING_PROPERTY(ResumeFile)
 
     MXA_INSTANCE_PROPERTY(int, NumberResolutions)
     MXA_INSTANCE_PROPERTY(float, SampleThickness)
@@ -87,6 +101,7 @@ class HAADF_MultiResolutionReconstruction : public FilterPipeline
     MXA_INSTANCE_PROPERTY(bool, InterpolateInitialReconstruction)
     MXA_INSTANCE_PROPERTY(float, DefaultVariance)
     MXA_INSTANCE_PROPERTY(float, InitialReconstructionValue)
+    MXA_INSTANCE_PROPERTY(int, SIRTIterations)
     MXA_INSTANCE_PROPERTY(Real_t, DefaultPixelSize)
 
     MXA_INSTANCE_PROPERTY(std::vector<float>, Tilts)
@@ -101,6 +116,29 @@ class HAADF_MultiResolutionReconstruction : public FilterPipeline
 
     MXA_INSTANCE_PROPERTY(std::vector<uint8_t>, ViewMasks)
 
+    /* Bytes the reconstruction may use. 0 does not limit it */
+    MXA_INSTANCE_PROPERTY(uint64_t, MemoryBudget)
+
+    /* JSON file the memory used by every resolution is written to at the end */
+    MXA_INSTANCE_STRING_PROPERTY(MemoryReportFile)
+
+    /* Shared with the engines of every resolution. The batch driver hands the
+     * same cache to all of its jobs */
+    MXA_INSTANCE_PROPERTY(HAADF_PrecomputeCache::Pointer, PrecomputeCache)
+
+    /* The final resolution volume and nuisance parameters of a converged
+     * reconstruction of the same data. When set only the final resolution is
+     * reconstructed, starting from them. */
+    MXA_INSTANCE_PROPERTY(GeometryPtr, WarmStartGeometry)
+    MXA_INSTANCE_PROPERTY(HAADF_ForwardModel::Pointer, WarmStartForwardModel)
+
+    /* The final resolution results of the last execute(). They can be handed
+     * to another reconstruction as its warm start. */
+    MXA_INSTANCE_PROPERTY(GeometryPtr, FinalGeometry)
+    MXA_INSTANCE_PROPERTY(HAADF_ForwardModel::Pointer, FinalForwardModel)
+    MXA_INSTANCE_PROPERTY(Real_t, FinalCost)
+    MXA_INSTANCE_PROPERTY(int, FinalVoxelUpdatePasses)
+
     /**
      * @brief
      */
@@ -115,21 +153,45 @@ class HAADF_MultiResolutionReconstruction : public FilterPipeline
     void printInputs(TomoInputsPtr inputs, std::ostream& out);
 
     /**
-     * @brief Trys to estimate the amount of memory that will be used.
-     * @param inputs
-     * @param bf_inputs
+     * @brief Predicts the memory every resolution will use from the header of
+     * the input file alone.
+     * @return The executed planner or a NullPointer if the input file can not be planned
      */
-    void memCalculate(TomoInputsPtr inputs);
+    MemoryPlanner::Pointer planMemory();
+
+    /**
+     * @brief Sends the memory held by every named array right now to the observers
+     */
+    void reportMemory();
 
   protected:
     HAADF_MultiResolutionReconstruction();
 
+    /**
+     * @brief Writes the MemoryReportFile if one was asked for
+     */
+    void writeMemoryReport();
+
     /**
      * @brief setupTempFiles This funtion setups up all the paths to the temp files tha need to be deleted
      * @return
      */
     std::vector<std::string> setupTempFiles(TomoInputsPtr inputs);
 
+    /**
+     * @brief Reads the sinogram that every resolution shares, or takes it from
+     * the PrecomputeCache if an earlier reconstruction read it
+     * @return Negative on error
+     */
+    int readFullSinogram(TomoInputsPtr inputs, SinogramPtr sinogram);
+
+    /**
+     * @brief The number of detector pixels binned along r and along t for a
+     * resolution. This is the largest power of two that divides N_r and N_t and
+     * does not exceed the voxel size of the resolution in detector pixels.
+     */
+    unsigned int detectorBinning(SinogramPtr sinogram, int resolution);
+
   private:
     bool                 m_Cancel;
     HAADF_ReconstructionEngine::Pointer   m_CurrentEngine;
@@ -0,0 +1,315 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "HAADF_PrecomputeCache.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#define PRECOMPUTE_CACHE_LOCK tbb::spin_mutex::scoped_lock cacheLock(m_Mutex);
+#else
+#define PRECOMPUTE_CACHE_LOCK
+#endif
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADF_PrecomputeEntry::HAADF_PrecomputeEntry() :
+  nonZeroEntries(0.0)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADF_PrecomputeEntry::~HAADF_PrecomputeEntry()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADF_PrecomputeCache::HAADF_PrecomputeCache() :
+  m_Hits(0),
+  m_Misses(0)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADF_PrecomputeCache::~HAADF_PrecomputeCache()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::string HAADF_PrecomputeCache::MakeKey(SinogramPtr sinogram, TomoInputsPtr inputs,
+                                           GeometryPtr geometry, AdvancedParametersPtr advParams)
+{
+  std::stringstream ss;
+  ss << std::setprecision(17);
+  ss << MakeGeometryKey(sinogram, inputs, geometry, advParams) << "|" << sinogram->N_theta << "|";
+  for (size_t i = 0; i < sinogram->angles.size(); ++i)
+  {
+    ss << sinogram->angles[i] << " ";
+  }
+  return ss.str();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::string HAADF_PrecomputeCache::MakeGeometryKey(SinogramPtr sinogram, TomoInputsPtr inputs,
+                                                   GeometryPtr geometry, AdvancedParametersPtr advParams)
+{
+  // Every value besides the views the voxel profile, the detector response,
+  // H_t and the A matrix read. The precision keeps doubles that differ in the
+  // last bit apart.
+  std::stringstream ss;
+  ss << std::setprecision(17);
+  ss << sinogram->N_r << " " << sinogram->N_t << " "
+     << sinogram->delta_r << " " << sinogram->delta_t << " "
+     << sinogram->R0 << " " << sinogram->RMax << " " << sinogram->T0 << " " << sinogram->TMax << "|"
+     << geometry->N_x << " " << geometry->N_y << " " << geometry->N_z << " "
+     << geometry->x0 << " " << geometry->y0 << " " << geometry->z0 << "|"
+     << inputs->delta_xz << " " << inputs->delta_xy << "|"
+     << advParams->DETECTOR_RESPONSE_BINS << " " << advParams->PROFILE_RESOLUTION << " "
+     << advParams->BEAM_RESOLUTION << " " << advParams->AREA_WEIGHTED;
+  return ss.str();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADF_PrecomputeEntry::Pointer HAADF_PrecomputeCache::find(const std::string& key)
+{
+  PRECOMPUTE_CACHE_LOCK
+  std::map<std::string, HAADF_PrecomputeEntry::Pointer>::iterator iter = m_Entries.find(key);
+  if(iter == m_Entries.end())
+  {
+    ++m_Misses;
+    return HAADF_PrecomputeEntry::NullPointer();
+  }
+  ++m_Hits;
+  return iter->second;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADF_PrecomputeCache::insert(const std::string& key, HAADF_PrecomputeEntry::Pointer entry)
+{
+  PRECOMPUTE_CACHE_LOCK
+  if(m_Entries.find(key) == m_Entries.end())
+  {
+    m_Entries[key] = entry;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADF_PrecomputeCache::insert(const std::string& key, const std::string& geometryKey, HAADF_PrecomputeEntry::Pointer entry)
+{
+  PRECOMPUTE_CACHE_LOCK
+  if(m_Entries.find(key) == m_Entries.end())
+  {
+    m_Entries[key] = entry;
+  }
+  m_LastEntries[geometryKey] = m_Entries[key];
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADF_PrecomputeEntry::Pointer HAADF_PrecomputeCache::findFirstViews(const std::string& geometryKey, const std::vector<Real_t>& angles)
+{
+  PRECOMPUTE_CACHE_LOCK
+  std::map<std::string, HAADF_PrecomputeEntry::Pointer>::iterator iter = m_LastEntries.find(geometryKey);
+  if(iter == m_LastEntries.end() || iter->second->angles.size() > angles.size())
+  {
+    return HAADF_PrecomputeEntry::NullPointer();
+  }
+  const std::vector<Real_t>& cached = iter->second->angles;
+  if(std::equal(cached.begin(), cached.end(), angles.begin()) == false)
+  {
+    return HAADF_PrecomputeEntry::NullPointer();
+  }
+  return iter->second;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::string HAADF_PrecomputeCache::MakeSinogramKey(TomoInputsPtr inputs, SinogramPtr sinogram)
+{
+  // Everything MRCSinogramInitializer reads besides the file itself
+  std::stringstream ss;
+  ss << std::setprecision(17);
+  ss << inputs->sinoFile << "|" << inputs->useSubvolume << " "
+     << inputs->xStart << " " << inputs->xEnd << " " << inputs->yStart << " " << inputs->yEnd << " "
+     << inputs->zStart << " " << inputs->zEnd << " " << inputs->interpolateFactor << "|";
+  for (size_t i = 0; i < inputs->excludedViews.size(); ++i)
+  {
+    ss << static_cast<int>(inputs->excludedViews[i]) << " ";
+  }
+  ss << "|";
+  for (size_t i = 0; i < inputs->tilts.size(); ++i)
+  {
+    ss << inputs->tilts[i] << " ";
+  }
+  ss << "|" << sinogram->delta_r << " " << sinogram->delta_t;
+  return ss.str();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool HAADF_PrecomputeCache::findSinogram(const std::string& key, TomoInputsPtr inputs, SinogramPtr sinogram)
+{
+  PRECOMPUTE_CACHE_LOCK
+  std::map<std::string, std::pair<TomoInputsPtr, SinogramPtr> >::iterator iter = m_Sinograms.find(key);
+  if(iter == m_Sinograms.end())
+  {
+    ++m_Misses;
+    return false;
+  }
+  ++m_Hits;
+  TomoInputsPtr cachedInputs = iter->second.first;
+  inputs->fileXSize = cachedInputs->fileXSize;
+  inputs->fileYSize = cachedInputs->fileYSize;
+  inputs->fileZSize = cachedInputs->fileZSize;
+  inputs->xStart = cachedInputs->xStart;
+  inputs->xEnd = cachedInputs->xEnd;
+  inputs->yStart = cachedInputs->yStart;
+  inputs->yEnd = cachedInputs->yEnd;
+  inputs->zStart = cachedInputs->zStart;
+  inputs->zEnd = cachedInputs->zEnd;
+  inputs->goodViews = cachedInputs->goodViews;
+  *sinogram = *(iter->second.second);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADF_PrecomputeCache::insertSinogram(const std::string& key, TomoInputsPtr inputs, SinogramPtr sinogram)
+{
+  TomoInputsPtr cachedInputs = TomoInputsPtr(new TomoInputs(*inputs));
+  SinogramPtr cachedSinogram = SinogramPtr(new Sinogram(*sinogram));
+  PRECOMPUTE_CACHE_LOCK
+  if(m_Sinograms.find(key) == m_Sinograms.end())
+  {
+    m_Sinograms[key] = std::make_pair(cachedInputs, cachedSinogram);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADF_PrecomputeCache::clear()
+{
+  PRECOMPUTE_CACHE_LOCK
+  m_Entries.clear();
+  m_LastEntries.clear();
+  m_Sinograms.clear();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADF_PrecomputeCache::trim()
+{
+  PRECOMPUTE_CACHE_LOCK
+  std::map<std::string, HAADF_PrecomputeEntry::Pointer>::iterator iter = m_Entries.begin();
+  while (iter != m_Entries.end())
+  {
+    bool last = false;
+    for (std::map<std::string, HAADF_PrecomputeEntry::Pointer>::iterator lastIter = m_LastEntries.begin(); lastIter != m_LastEntries.end(); ++lastIter)
+    {
+      last |= (lastIter->second == iter->second);
+    }
+    if(last == true)
+    {
+      ++iter;
+    }
+    else
+    {
+      m_Entries.erase(iter++);
+    }
+  }
+  m_Sinograms.clear();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+size_t HAADF_PrecomputeCache::getNumberOfEntries()
+{
+  PRECOMPUTE_CACHE_LOCK
+  return m_Entries.size();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+size_t HAADF_PrecomputeCache::getNumberOfSinograms()
+{
+  PRECOMPUTE_CACHE_LOCK
+  return m_Sinograms.size();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+uint64_t HAADF_PrecomputeCache::getHits()
+{
+  PRECOMPUTE_CACHE_LOCK
+  return m_Hits;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+uint64_t HAADF_PrecomputeCache::getMisses()
+{
+  PRECOMPUTE_CACHE_LOCK
+  return m_Misses;
+}
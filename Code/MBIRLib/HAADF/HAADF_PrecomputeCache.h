@@ -0,0 +1,210 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _HAADF_PrecomputeCache_H_
+#define _HAADF_PrecomputeCache_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/AMatrixCol.h"
+#include "MBIRLib/GenericFilters/DetectorParameters.h"
+#include "MBIRLib/Reconstruction/ReconstructionStructures.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/spin_mutex.h>
+#endif
+
+/**
+ * @class HAADF_PrecomputeEntry HAADF_PrecomputeCache.h MBIRLib/HAADF/HAADF_PrecomputeCache.h
+ * @brief The parts of a HAADF reconstruction that only depend on the geometry:
+ * the detector parameters, the detector response, H_t and the partial A matrix.
+ * An entry is never changed once it is in the cache so the engines of several
+ * jobs can read it at the same time.
+ */
+class MBIRLib_EXPORT HAADF_PrecomputeEntry
+{
+  public:
+    MXA_SHARED_POINTERS(HAADF_PrecomputeEntry)
+    MXA_TYPE_MACRO(HAADF_PrecomputeEntry)
+    MXA_STATIC_NEW_MACRO(HAADF_PrecomputeEntry)
+
+    virtual ~HAADF_PrecomputeEntry();
+
+    DetectorParameters::Pointer detectorParameters;
+    RealVolumeType::Pointer detectorResponse;
+    RealVolumeType::Pointer H_t;
+    std::vector<AMatrixCol::Pointer> TempCol;
+    std::vector<AMatrixCol::Pointer> VoxelLineResponse;
+    Real_t nonZeroEntries; // Number of non zero entries of the partial A matrix
+    std::vector<Real_t> angles; // The views of the A matrix, in degrees
+
+  protected:
+    HAADF_PrecomputeEntry();
+
+  private:
+    HAADF_PrecomputeEntry(const HAADF_PrecomputeEntry&); // Copy Constructor Not Implemented
+    void operator=(const HAADF_PrecomputeEntry&); // Operator '=' Not Implemented
+};
+
+/**
+ * @class HAADF_PrecomputeCache HAADF_PrecomputeCache.h MBIRLib/HAADF/HAADF_PrecomputeCache.h
+ * @brief Holds HAADF_PrecomputeEntry objects keyed by the geometry they were
+ * computed for so datasets of a batch that share a tilt series and a grid only
+ * pay for the A matrix once. Every resolution of a multi resolution run has
+ * its own key.
+ *
+ * The column of a voxel holds its views one after the other and each view
+ * only depends on its own angle, so an A matrix of the first views of a tilt
+ * series is the start of the A matrix of the whole series. The last entry of
+ * every geometry is kept under a key without the angles and an engine that
+ * misses extends it with the views it lacks. Rounds of a streamed
+ * acquisition only compute the A matrix of the tilts that arrived since the
+ * last round this way.
+ *
+ * It also keeps the sinograms read from MRC files, keyed by the file and the
+ * part of it that is read, so reconstructions of the same data (the
+ * resolutions of a run, the settings of a parameter sweep) read it once. The
+ * counts are shared and never written by the HAADF engine.
+ *
+ * Two engines that miss on the same key at the same time both compute the
+ * entry and the one that inserts first wins; the batch driver avoids this by
+ * running its first job on its own.
+ */
+class MBIRLib_EXPORT HAADF_PrecomputeCache
+{
+  public:
+    MXA_SHARED_POINTERS(HAADF_PrecomputeCache)
+    MXA_TYPE_MACRO(HAADF_PrecomputeCache)
+    MXA_STATIC_NEW_MACRO(HAADF_PrecomputeCache)
+
+    virtual ~HAADF_PrecomputeCache();
+
+    /**
+     * @brief Builds the key for a geometry. It has to be called with the angles
+     * still in degrees, before the engine converts them.
+     */
+    static std::string MakeKey(SinogramPtr sinogram, TomoInputsPtr inputs,
+                               GeometryPtr geometry, AdvancedParametersPtr advParams);
+
+    /**
+     * @brief Builds the key of the grid and the detector a geometry has whatever
+     * its views are
+     */
+    static std::string MakeGeometryKey(SinogramPtr sinogram, TomoInputsPtr inputs,
+                                       GeometryPtr geometry, AdvancedParametersPtr advParams);
+
+    /**
+     * @brief Looks up the entry of a key and counts the hit or miss
+     * @return The entry or a NullPointer if the key is not in the cache
+     */
+    HAADF_PrecomputeEntry::Pointer find(const std::string& key);
+
+    /**
+     * @brief Adds an entry. An entry that is already in the cache for the key is kept.
+     */
+    void insert(const std::string& key, HAADF_PrecomputeEntry::Pointer entry);
+
+    /**
+     * @brief Adds an entry and makes it the last one of its geometry
+     */
+    void insert(const std::string& key, const std::string& geometryKey, HAADF_PrecomputeEntry::Pointer entry);
+
+    /**
+     * @brief Looks up the last entry of a geometry whose views are the first
+     * views of angles. The hit or miss was already counted by find().
+     * @param angles The views of the sinogram, in degrees
+     * @return The entry or a NullPointer if there is none
+     */
+    HAADF_PrecomputeEntry::Pointer findFirstViews(const std::string& geometryKey, const std::vector<Real_t>& angles);
+
+    /**
+     * @brief Builds the key of the sinogram the inputs read. It has to be called
+     * before the file is read.
+     */
+    static std::string MakeSinogramKey(TomoInputsPtr inputs, SinogramPtr sinogram);
+
+    /**
+     * @brief Fills the sinogram and the input values the reader sets from the
+     * cache. The angles are copied, the counts are shared.
+     * @return true if the sinogram was in the cache
+     */
+    bool findSinogram(const std::string& key, TomoInputsPtr inputs, SinogramPtr sinogram);
+
+    /**
+     * @brief Keeps a copy of a sinogram that was just read together with the
+     * input values the reader set
+     */
+    void insertSinogram(const std::string& key, TomoInputsPtr inputs, SinogramPtr sinogram);
+
+    /**
+     * @brief Removes all entries
+     */
+    void clear();
+
+    /**
+     * @brief Removes the sinograms and every entry that is not the last one of
+     * its geometry
+     */
+    void trim();
+
+    size_t getNumberOfEntries();
+    size_t getNumberOfSinograms();
+    uint64_t getHits();
+    uint64_t getMisses();
+
+  protected:
+    HAADF_PrecomputeCache();
+
+  private:
+    std::map<std::string, HAADF_PrecomputeEntry::Pointer> m_Entries;
+    std::map<std::string, HAADF_PrecomputeEntry::Pointer> m_LastEntries; // By geometry key
+    std::map<std::string, std::pair<TomoInputsPtr, SinogramPtr> > m_Sinograms;
+    uint64_t m_Hits;
+    uint64_t m_Misses;
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    tbb::spin_mutex m_Mutex;
+#endif
+
+    HAADF_PrecomputeCache(const HAADF_PrecomputeCache&); // Copy Constructor Not Implemented
+    void operator=(const HAADF_PrecomputeCache&); // Operator '=' Not Implemented
+};
+
+#endif /* _HAADF_PrecomputeCache_H_ */
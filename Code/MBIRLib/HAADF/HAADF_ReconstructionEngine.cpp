@@ -55,15 +55,20 @@
 #include "MBIRLib/Common/EIMTime.h"
 
 #include "MBIRLib/IOFilters/DetectorResponseWriter.h"
+#include "MBIRLib/IOFilters/ReconstructionSnapshotWriter.h"
+#include "MBIRLib/IOFilters/ReconstructionCheckpoint.h"
 #include "MBIRLib/GenericFilters/DetectorResponse.h"
 #include "MBIRLib/GenericFilters/MRCSinogramInitializer.h"
 #include "MBIRLib/GenericFilters/RawSinogramInitializer.h"
 #include "MBIRLib/GenericFilters/InitialReconstructionInitializer.h"
 #include "MBIRLib/GenericFilters/InitialReconstructionBinReader.h"
+#include "MBIRLib/GenericFilters/InitialReconstructionUpsampler.h"
+#include "MBIRLib/GenericFilters/BackProjectionInitializer.h"
 
 #include "MBIRLib/HAADF/HAADFConstants.h"
 #include "MBIRLib/HAADF/HAADF_QGGMRFPriorModel.h"
 #include "MBIRLib/Reconstruction/ReconstructionConstants.h"
+#include "MBIRLib/Reconstruction/SinogramStatistics.h"
 #include "MBIRLib/HAADF/HAADF_ForwardProject.h"
 
 #if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
@@ -134,7 +139,9 @@ namespace Detail
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
-HAADF_ReconstructionEngine::HAADF_ReconstructionEngine()
+HAADF_ReconstructionEngine::HAADF_ReconstructionEngine() :
+  m_FinalCost(0.0),
+  m_VoxelUpdatePasses(0)
 {
   initVariables();
 #if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
@@ -172,6 +179,17 @@ void HAADF_ReconstructionEngine::InitializeTomoInputs(TomoInputsPtr v)
   v->interpolateFactor = 0.0;
   v->reconstructedOutputFile = "";
   v->tempDir = "";
+  v->snapshotPolicy = MBIR::SnapshotPolicy::EveryIteration;
+  v->snapshotInterval = 1;
+  v->checkpointInterval = -1;
+  v->checkpointFile = "";
+  v->resumeFile = "";
+  v->resolution = 0;
+  v->slabHaloStart = 0;
+  v->slabHaloEnd = 0;
+  v->slabOutputY = 0;
+  v->slabOutputNy = 0;
+  v->fixedNuisanceParameters = false;
   v->NumIter = 0;
   v->NumOuterIter = 0;
   v->SigmaX = 0.0;
@@ -192,6 +210,7 @@ void HAADF_ReconstructionEngine::InitializeTomoInputs(TomoInputsPtr v)
   v->delta_xy = 0;
   v->defaultOffset = 0.0;
   v->useDefaultOffset = false;
+  v->NumSIRTIter = 0;
 }
 
 // -----------------------------------------------------------------------------
@@ -205,6 +224,7 @@ void HAADF_ReconstructionEngine::InitializeSinogram(SinogramPtr v)
   v->delta_r = 0.0;
   v->delta_t = 0.0;
   v->counts = RealVolumeType::NullPointer();
+  v->weights = RealVolumeType::NullPointer();
   v->R0 = 0.0;
   v->RMax = 0.0;
   v->T0 = 0.0;
@@ -255,6 +275,11 @@ void HAADF_ReconstructionEngine::InitializeAdvancedParams(AdvancedParametersPtr
   v->ZERO_SKIPPING = 1;
   v->NOISE_MODEL = 1;
   v->ESTIMATE_PRIOR = 0;
+#ifdef COST_CALCULATE
+  v->TRACK_COST = 1;
+#else
+  v->TRACK_COST = 0;
+#endif
 
 }
 
@@ -360,6 +385,11 @@ void HAADF_ReconstructionEngine::execute()
   CostData::Pointer cost = CostData::New();
   cost->initOutputFile(filepath);
   //#endif
+#ifdef COST_CALCULATE
+  cost->setResyncInterval(1); //Exact cost after every pass while debugging
+#else
+  cost->setResyncInterval(MBIR::Constants::k_CostResyncInterval);
+#endif
 
 #if OpenMBIR_USE_PARALLEL_ALGORITHMS
   tbb::task_scheduler_init init;
@@ -461,16 +491,42 @@ void HAADF_ReconstructionEngine::execute()
   //calculate the trapezoidal voxel profile for each angle. Also the angles in the Sinogram
   // Structure are converted to radians. Note that this initialization MUST come before the
   // calculateSinCos() and initializeBeamProfile() functions.
+  // The key has to be built while the angles are still in degrees
+  std::string precomputeKey;
+  std::string geometryKey;
+  std::vector<Real_t> precomputeAngles;
+  HAADF_PrecomputeEntry::Pointer precomputed;
+  // A miss can still start from the A matrix of the first views
+  HAADF_PrecomputeEntry::Pointer firstViews;
+  if(NULL != m_PrecomputeCache.get())
+  {
+    precomputeKey = HAADF_PrecomputeCache::MakeKey(m_Sinogram, m_TomoInputs, m_Geometry, m_AdvParams);
+    geometryKey = HAADF_PrecomputeCache::MakeGeometryKey(m_Sinogram, m_TomoInputs, m_Geometry, m_AdvParams);
+    precomputeAngles = m_Sinogram->angles;
+    precomputed = m_PrecomputeCache->find(precomputeKey);
+    if(NULL == precomputed.get())
+    {
+      firstViews = m_PrecomputeCache->findFirstViews(geometryKey, precomputeAngles);
+    }
+  }
+
   voxelProfile = calculateVoxelProfile(); //Verified with ML
 
-  //Pre compute sine and cos theta to speed up computations
-  m_DetectorParameters = DetectorParameters::New();
-  m_DetectorParameters->setOffsetR(((m_TomoInputs->delta_xz / sqrt(3.0)) + m_Sinogram->delta_r / 2) / m_AdvParams->DETECTOR_RESPONSE_BINS);
-  m_DetectorParameters->setOffsetT(((m_TomoInputs->delta_xz / 2) + m_Sinogram->delta_t / 2) / m_AdvParams->DETECTOR_RESPONSE_BINS);
-  m_DetectorParameters->setBeamWidth(m_Sinogram->delta_r);
-  m_DetectorParameters->calculateSinCos(m_Sinogram);
-  //Initialize the e-beam
-  m_DetectorParameters->initializeBeamProfile(m_Sinogram, m_AdvParams); //verified with ML
+  if(NULL != precomputed.get())
+  {
+    m_DetectorParameters = precomputed->detectorParameters;
+  }
+  else
+  {
+    //Pre compute sine and cos theta to speed up computations
+    m_DetectorParameters = DetectorParameters::New();
+    m_DetectorParameters->setOffsetR(((m_TomoInputs->delta_xz / sqrt(3.0)) + m_Sinogram->delta_r / 2) / m_AdvParams->DETECTOR_RESPONSE_BINS);
+    m_DetectorParameters->setOffsetT(((m_TomoInputs->delta_xz / 2) + m_Sinogram->delta_t / 2) / m_AdvParams->DETECTOR_RESPONSE_BINS);
+    m_DetectorParameters->setBeamWidth(m_Sinogram->delta_r);
+    m_DetectorParameters->calculateSinCos(m_Sinogram);
+    //Initialize the e-beam
+    m_DetectorParameters->initializeBeamProfile(m_Sinogram, m_AdvParams); //verified with ML
+  }
 
 #ifdef EIMTOMO_USE_QGGMRF
   // Initialize the Prior Model parameters - here we are using a QGGMRF Prior Model
@@ -508,26 +564,33 @@ void HAADF_ReconstructionEngine::execute()
   //  haadfParameters->initializeBeamProfile(m_Sinogram, m_AdvParams); //The shape of the averaging kernel for the detector
 
 
-  //calculate sine and cosine of all angles and store in the global arrays sine and cosine
-  DetectorResponse::Pointer dResponseFilter = DetectorResponse::New();
-  dResponseFilter->setTomoInputs(m_TomoInputs);
-  dResponseFilter->setSinogram(m_Sinogram);
-  dResponseFilter->setAdvParams(m_AdvParams);
-  dResponseFilter->setDetectorParameters(m_DetectorParameters);
-  dResponseFilter->setVoxelProfile(voxelProfile);
-  dResponseFilter->setObservers(getObservers());
-  dResponseFilter->setVerbose(getVerbose());
-  dResponseFilter->setVeryVerbose(getVeryVerbose());
-  dResponseFilter->execute();
-  if(dResponseFilter->getErrorCondition() < 0)
+  if(NULL != precomputed.get())
   {
-    ss.str("");
-    ss << "Error Calling function detectorResponse in file " << __FILE__ << "(" << __LINE__ << ")" << std::endl;
-    setErrorCondition(-2);
-    notify(ss.str(), 100, Observable::UpdateErrorMessage);
-    return;
+    detectorResponse = precomputed->detectorResponse;
+  }
+  else
+  {
+    //calculate sine and cosine of all angles and store in the global arrays sine and cosine
+    DetectorResponse::Pointer dResponseFilter = DetectorResponse::New();
+    dResponseFilter->setTomoInputs(m_TomoInputs);
+    dResponseFilter->setSinogram(m_Sinogram);
+    dResponseFilter->setAdvParams(m_AdvParams);
+    dResponseFilter->setDetectorParameters(m_DetectorParameters);
+    dResponseFilter->setVoxelProfile(voxelProfile);
+    dResponseFilter->setObservers(getObservers());
+    dResponseFilter->setVerbose(getVerbose());
+    dResponseFilter->setVeryVerbose(getVeryVerbose());
+    dResponseFilter->execute();
+    if(dResponseFilter->getErrorCondition() < 0)
+    {
+      ss.str("");
+      ss << "Error Calling function detectorResponse in file " << __FILE__ << "(" << __LINE__ << ")" << std::endl;
+      setErrorCondition(-2);
+      notify(ss.str(), 100, Observable::UpdateErrorMessage);
+      return;
+    }
+    detectorResponse = dResponseFilter->getResponse();
   }
-  detectorResponse = dResponseFilter->getResponse();
   // Writer the Detector Response to an output file
   DetectorResponseWriter::Pointer responseWriter = DetectorResponseWriter::New();
   responseWriter->setTomoInputs(m_TomoInputs);
@@ -578,60 +641,122 @@ void HAADF_ReconstructionEngine::execute()
 
   if (getCancel() == true) { setErrorCondition(-999); return; }
 
-  // Initialize H_t volume
-  dims[0] = 1;
-  dims[1] = m_Sinogram->N_theta;
-  dims[2] = m_AdvParams->DETECTOR_RESPONSE_BINS;
-  H_t = RealVolumeType::New(dims, "H_t");
-  m_ForwardModel->initializeHt(H_t, m_DetectorParameters->getOffsetT() );
+  std::vector<AMatrixCol::Pointer> VoxelLineResponse;
+  std::vector<AMatrixCol::Pointer> TempCol;
+  if(NULL != precomputed.get())
+  {
+    ss.str("");
+    ss << "Reusing the A Matrix of an earlier reconstruction with the same geometry";
+    notify(ss.str(), 0, Observable::UpdateProgressMessage);
+
+    H_t = precomputed->H_t;
+    VoxelLineResponse = precomputed->VoxelLineResponse;
+    TempCol = precomputed->TempCol;
+    temp = precomputed->nonZeroEntries;
+    MaxNumberOfDetectorElts = (uint16_t)((m_TomoInputs->delta_xy / m_Sinogram->delta_t) + 2);
+
+    // The object is specific to this reconstruction so lines that are never hit
+    // still have to be cleared
+    uint32_t voxel_count = 0;
+    for (uint16_t z = 0; z < m_Geometry->N_z; z++)
+    {
+      for (uint16_t x = 0; x < m_Geometry->N_x; x++)
+      {
+        if(0 == TempCol[voxel_count]->count)
+        {
+          for (uint16_t y = 0; y < m_Geometry->N_y; y++)
+          {
+            m_Geometry->Object->setValue(0.0, z, x, y);
+          }
+        }
+        voxel_count++;
+      }
+    }
+  }
+  else
+  {
+    // Initialize H_t volume
+    dims[0] = 1;
+    dims[1] = m_Sinogram->N_theta;
+    dims[2] = m_AdvParams->DETECTOR_RESPONSE_BINS;
+    H_t = RealVolumeType::New(dims, "H_t");
+    m_ForwardModel->initializeHt(H_t, m_DetectorParameters->getOffsetT() );
 
-  checksum = 0;
+    checksum = 0;
 
-  ss.str("");
-  ss << "Calculating A Matrix....";
-  notify(ss.str(), 0, Observable::UpdateProgressMessage);
+    ss.str("");
+    if(NULL != firstViews.get())
+    {
+      ss << "Calculating A Matrix of the views after the first " << firstViews->angles.size() << "....";
+    }
+    else
+    {
+      ss << "Calculating A Matrix....";
+    }
+    notify(ss.str(), 0, Observable::UpdateProgressMessage);
 
 
 
-  std::vector<AMatrixCol::Pointer> VoxelLineResponse(m_Geometry->N_y);
+    VoxelLineResponse.resize(m_Geometry->N_y);
 
-  MaxNumberOfDetectorElts = (uint16_t)((m_TomoInputs->delta_xy / m_Sinogram->delta_t) + 2);
-  dims[0] = MaxNumberOfDetectorElts;
-  for (uint16_t i = 0; i < m_Geometry->N_y; i++)
-  {
-    AMatrixCol::Pointer vlr = AMatrixCol::New(dims, 0);
-    VoxelLineResponse[i] = vlr;
-  }
+    MaxNumberOfDetectorElts = (uint16_t)((m_TomoInputs->delta_xy / m_Sinogram->delta_t) + 2);
+    dims[0] = MaxNumberOfDetectorElts;
+    for (uint16_t i = 0; i < m_Geometry->N_y; i++)
+    {
+      AMatrixCol::Pointer vlr = AMatrixCol::New(dims, 0);
+      VoxelLineResponse[i] = vlr;
+    }
 
-  //Calculating A-Matrix one column at a time
-  //For each entry the idea is to initially allocate space for Sinogram.N_theta * Sinogram.N_x
-  // And then store only the non zero entries by allocating a new array of the desired size
-  //AMatrixCol** TempCol = (AMatrixCol**)get_spc(m_Geometry->N_x * m_Geometry->N_z, sizeof(AMatrixCol*));
-  std::vector<AMatrixCol::Pointer> TempCol(m_Geometry->N_x * m_Geometry->N_z);
+    //Calculating A-Matrix one column at a time
+    //For each entry the idea is to initially allocate space for Sinogram.N_theta * Sinogram.N_x
+    // And then store only the non zero entries by allocating a new array of the desired size
+    //AMatrixCol** TempCol = (AMatrixCol**)get_spc(m_Geometry->N_x * m_Geometry->N_z, sizeof(AMatrixCol*));
+    TempCol.resize(m_Geometry->N_x * m_Geometry->N_z);
 
-  checksum = 0;
-  temp = 0;
-  uint32_t voxel_count = 0;
-  for (uint16_t z = 0; z < m_Geometry->N_z; z++)
-  {
-    for (uint16_t x = 0; x < m_Geometry->N_x; x++)
+    checksum = 0;
+    temp = 0;
+    uint32_t voxel_count = 0;
+    for (uint16_t z = 0; z < m_Geometry->N_z; z++)
     {
-      TempCol[voxel_count] = calculateAMatrixColumnPartial(z, x, 0, detectorResponse);
-      temp += TempCol[voxel_count]->count;
-      if(0 == TempCol[voxel_count]->count )
+      for (uint16_t x = 0; x < m_Geometry->N_x; x++)
       {
-        //If this line is never hit and the Object is badly initialized
-        //set it to zero
-        for (uint16_t y = 0; y < m_Geometry->N_y; y++)
+        if(NULL != firstViews.get())
+        {
+          TempCol[voxel_count] = appendViews(firstViews->TempCol[voxel_count], z, x, detectorResponse, firstViews->angles.size());
+        }
+        else
+        {
+          TempCol[voxel_count] = calculateAMatrixColumnPartial(z, x, 0, detectorResponse);
+        }
+        temp += TempCol[voxel_count]->count;
+        if(0 == TempCol[voxel_count]->count )
         {
-          m_Geometry->Object->setValue(0.0, z, x, y);
+          //If this line is never hit and the Object is badly initialized
+          //set it to zero
+          for (uint16_t y = 0; y < m_Geometry->N_y; y++)
+          {
+            m_Geometry->Object->setValue(0.0, z, x, y);
+          }
         }
+        voxel_count++;
       }
-      voxel_count++;
     }
-  }
 
-  storeVoxelResponse(H_t, VoxelLineResponse);
+    storeVoxelResponse(H_t, VoxelLineResponse);
+
+    if(NULL != m_PrecomputeCache.get())
+    {
+      HAADF_PrecomputeEntry::Pointer entry = HAADF_PrecomputeEntry::New();
+      entry->detectorParameters = m_DetectorParameters;
+      entry->detectorResponse = detectorResponse;
+      entry->H_t = H_t;
+      entry->TempCol = TempCol;
+      entry->VoxelLineResponse = VoxelLineResponse;
+      entry->nonZeroEntries = temp;
+      entry->angles = precomputeAngles;
+      m_PrecomputeCache->insert(precomputeKey, geometryKey, entry);
+    }
+  }
 
   if (getCancel() == true) { setErrorCondition(-999); return; }
 
@@ -641,54 +766,100 @@ void HAADF_ReconstructionEngine::execute()
     printf("Geometry-Z %d\n", m_Geometry->N_z);
   }
 
+  // A resumed reconstruction restores the volume, the error sinogram and
+  // the weights from its checkpoint further down
+  bool resume = (m_TomoInputs->resumeFile.empty() == false);
+
+  // Replace the constant starting volume with a few iterations of SIRT. Y_Est and
+  // ErrorSino are only used as scratch space here; both are recomputed below.
+  if(resume == false && m_TomoInputs->initialReconFile.empty() == true && NULL == m_TomoInputs->initialRecon.get()
+     && m_TomoInputs->NumSIRTIter > 0 && m_ForwardModel->getBF_Flag() == false)
+  {
+    START_TIMER;
+    BackProjectionInitializer::Pointer bpInitializer = BackProjectionInitializer::New();
+    bpInitializer->setTomoInputs(m_TomoInputs);
+    bpInitializer->setSinogram(m_Sinogram);
+    bpInitializer->setGeometry(m_Geometry);
+    bpInitializer->setAdvParams(m_AdvParams);
+    bpInitializer->setTempCol(TempCol);
+    bpInitializer->setVoxelLineResponse(VoxelLineResponse);
+    bpInitializer->setI_0(m_ForwardModel->getI_0());
+    bpInitializer->setMu(m_ForwardModel->getMu());
+    bpInitializer->setWorkSinogram(Y_Est);
+    bpInitializer->setResidualSinogram(ErrorSino);
+    bpInitializer->setNumIterations(m_TomoInputs->NumSIRTIter);
+#ifdef POSITIVITY_CONSTRAINT
+    bpInitializer->setPositivityConstraint(true);
+#else
+    bpInitializer->setPositivityConstraint(false);
+#endif
+    bpInitializer->setObservers(getObservers());
+    bpInitializer->setVerbose(getVerbose());
+    bpInitializer->setVeryVerbose(getVeryVerbose());
+    bpInitializer->execute();
+    if(bpInitializer->getErrorCondition() == -999) { setErrorCondition(-999); return; }
+    if(bpInitializer->getErrorCondition() < 0)
+    {
+      setErrorCondition(bpInitializer->getErrorCondition());
+      notify("Error computing the SIRT initial reconstruction", 100, Observable::UpdateErrorMessage);
+      return;
+    }
+    STOP_TIMER;
+    PRINT_TIME("SIRT Initialization Time");
+  }
+
   //Forward Project Geometry->Object one slice at a time and compute the  Sinogram for each slice
   //is Y_Est initailized to zero?
   initializeVolume(Y_Est, 0.0);
 
   if (getCancel() == true) { setErrorCondition(-999); return; }
 
-  notify("Starting Forward Projection", 10, Observable::UpdateProgressValueAndMessage);
-  START_TIMER;
-  // This next section looks crazy with all the #if's but this makes sure we are
-  // running the exact same code whether in parallel or serial.
+  // The error sinogram and the weights of a resumed reconstruction are restored instead
+  if(resume == false)
+  {
+    notify("Starting Forward Projection", 10, Observable::UpdateProgressValueAndMessage);
+    START_TIMER;
+    // This next section looks crazy with all the #if's but this makes sure we are
+    // running the exact same code whether in parallel or serial.
 
 #if OpenMBIR_USE_PARALLEL_ALGORITHMS
-  tbb::task_group* g = new tbb::task_group;
-  if (getVerbose())
-  {
-    std::cout << "Default Number of Threads to Use: " << init.default_num_threads() << std::endl;
-    std::cout << "Forward Projection Running in Parallel." << std::endl;
-  }
+    tbb::task_group* g = new tbb::task_group;
+    if (getVerbose())
+    {
+      std::cout << "Default Number of Threads to Use: " << init.default_num_threads() << std::endl;
+      std::cout << "Forward Projection Running in Parallel." << std::endl;
+    }
 #else
-  if(getVerbose())
-  {
-    std::cout << "Forward Projection Running in Serial." << std::endl;
-  }
+    if(getVerbose())
+    {
+      std::cout << "Forward Projection Running in Serial." << std::endl;
+    }
 #endif
-  // Queue up a thread for each z layer of the Geometry. The threads will only be
-  // run as hardware resources open up so this will not just fire up a gazillion
-  // threads.
-  for (uint16_t t = 0; t < m_Geometry->N_z; t++)
-  {
+    // Queue up a thread for each z layer of the Geometry. The threads will only be
+    // run as hardware resources open up so this will not just fire up a gazillion
+    // threads.
+    for (uint16_t t = 0; t < m_Geometry->N_z; t++)
+    {
 #if OpenMBIR_USE_PARALLEL_ALGORITHMS
-    g->run(HAADF_ForwardProject(m_Sinogram.get(), m_Geometry.get(), TempCol, VoxelLineResponse, Y_Est, m_ForwardModel.get(), t, this));
+      g->run(HAADF_ForwardProject(m_Sinogram.get(), m_Geometry.get(), TempCol, VoxelLineResponse, Y_Est, m_ForwardModel.get(), t, this));
 #else
-    HAADF_ForwardProject fp(m_Sinogram.get(), m_Geometry.get(), TempCol, VoxelLineResponse, Y_Est, m_ForwardModel.get(), t, this);
-    //fp.setObservers(getObservers());
-    fp();
+      HAADF_ForwardProject fp(m_Sinogram.get(), m_Geometry.get(), TempCol, VoxelLineResponse, Y_Est, m_ForwardModel.get(), t, this);
+      //fp.setObservers(getObservers());
+      fp();
 #endif
-  }
+    }
 #if OpenMBIR_USE_PARALLEL_ALGORITHMS
-  g->wait(); // Wait for all the threads to complete before moving on.
-  delete g;
+    g->wait(); // Wait for all the threads to complete before moving on.
+    delete g;
 #endif
 
-  STOP_TIMER;
-  PRINT_TIME("Forward Project Time");
+    STOP_TIMER;
+    PRINT_TIME("Forward Project Time");
 
-  //Calculate Error Sinogram - Can this be combined with previous loop?
-  //Also compute weights of the diagonal covariance matrix
-  calculateMeasurementWeight(Weight, ErrorSino, Y_Est);
+    //Calculate Error Sinogram - Can this be combined with previous loop?
+    //Also compute weights of the diagonal covariance matrix
+    calculateMeasurementWeight(Weight, ErrorSino, Y_Est);
+  }
 
   if (getCancel() == true) { setErrorCondition(-999); return; }
 
@@ -697,13 +868,68 @@ void HAADF_ReconstructionEngine::execute()
   return 0; //exit the program once we finish forward projecting the object
 #endif//Forward Project mode
 
-#ifdef COST_CALCULATE
-  err = calculateCost(cost, Weight, ErrorSino);
-#endif //Cost calculation endif
+  //Initial exact cost that the incremental cost tracking starts from
+  if(resume == false && m_AdvParams->TRACK_COST)
+  {
+    err = calculateCost(cost, Weight, ErrorSino);
+  }
+  m_VoxelUpdatePasses = 0;
   //  int totalLoops = m_TomoInputs->NumOuterIter * m_TomoInputs->NumIter;
 
+  // The intermediate volumes for the GUI are written in the background
+  ReconstructionSnapshotWriter::Pointer snapshotWriter = ReconstructionSnapshotWriter::New();
+  snapshotWriter->setTomoInputs(m_TomoInputs);
+  snapshotWriter->setGeometry(m_Geometry);
+  snapshotWriter->setAdvParams(m_AdvParams);
+  snapshotWriter->setXDims(cropStart, cropEnd);
+  snapshotWriter->setObservers(getObservers());
+
+  // Everything the iterations below depend on is saved in the checkpoints. The
+  // voxel order is drawn again for every pass so it is not part of them.
+  ReconstructionCheckpoint::Pointer checkpoint = ReconstructionCheckpoint::New();
+  checkpoint->setTomoInputs(m_TomoInputs);
+  checkpoint->setOutputFile(m_TomoInputs->checkpointFile);
+  checkpoint->setObservers(getObservers());
+  checkpoint->addVolume("Object", m_Geometry->Object);
+  checkpoint->addVolume("ErrorSinogram", ErrorSino);
+  checkpoint->addVolume("Weight", Weight);
+  checkpoint->addArray("I_0", m_ForwardModel->getI_0());
+  checkpoint->addArray("Mu", m_ForwardModel->getMu());
+  if(NULL != m_ForwardModel->getAlpha().get())
+  {
+    checkpoint->addArray("Alpha", m_ForwardModel->getAlpha());
+  }
+  checkpoint->addImage("MagUpdateMap", MagUpdateMap);
+  checkpoint->addImage("FiltMagUpdateMap", FiltMagUpdateMap);
+
+  int16_t startOuterIter = 0;
+  int16_t startInnerIter = 0;
+  if(resume == true)
+  {
+    if(checkpoint->restore(m_TomoInputs->resumeFile) < 0)
+    {
+      setErrorCondition(checkpoint->getErrorCondition());
+      return;
+    }
+    startOuterIter = static_cast<int16_t>(checkpoint->getCounter("OuterIteration"));
+    startInnerIter = static_cast<int16_t>(checkpoint->getCounter("InnerIteration"));
+    m_VoxelUpdatePasses = static_cast<int>(checkpoint->getCounter("VoxelUpdatePasses"));
+    // The prior follows the estimated SigmaX when ESTIMATE_PRIOR is set
+    m_TomoInputs->SigmaX = checkpoint->getCounter("SigmaX", m_TomoInputs->SigmaX);
+    QGGMRF::initializePriorModel(m_TomoInputs, &m_QGGMRF_Values);
+    status = 1; // Checkpoints are only taken while the reconstruction has not converged
+    // The tracked cost starts again from the restored error sinogram
+    if(m_AdvParams->TRACK_COST)
+    {
+      err = calculateCost(cost, Weight, ErrorSino);
+    }
+    ss.str("");
+    ss << "Resuming at outer iteration " << startOuterIter << " inner iteration " << startInnerIter;
+    notify(ss.str(), 0, Observable::UpdateProgressMessage);
+  }
+
   //Loop through every voxel updating it by solving a cost function
-  for (int16_t reconOuterIter = 0; reconOuterIter < m_TomoInputs->NumOuterIter; reconOuterIter++)
+  for (int16_t reconOuterIter = startOuterIter; reconOuterIter < m_TomoInputs->NumOuterIter; reconOuterIter++)
   {
     ss.str(""); // Clear the string stream
     indent = "";
@@ -714,7 +940,8 @@ void HAADF_ReconstructionEngine::execute()
       m_TomoInputs->NumIter = 1;
     }
 
-    for (int16_t reconInnerIter = 0; reconInnerIter < m_TomoInputs->NumIter; reconInnerIter++)
+    int16_t firstInnerIter = (reconOuterIter == startOuterIter) ? startInnerIter : 0;
+    for (int16_t reconInnerIter = firstInnerIter; reconInnerIter < m_TomoInputs->NumIter; reconInnerIter++)
     {
       ss.str("");
       ss << "Outer Iterations: " << reconOuterIter << "/" << m_TomoInputs->NumOuterIter << " Inner Iterations: " << reconInnerIter << "/" << m_TomoInputs->NumIter << std::endl;
@@ -739,13 +966,12 @@ void HAADF_ReconstructionEngine::execute()
       status =
         updateVoxels(reconOuterIter, reconInnerIter, updateType, VisitCount, TempCol, ErrorSino, Weight, VoxelLineResponse, m_ForwardModel.get(), Mask, cost);
       /* %%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%% */
+      m_VoxelUpdatePasses++;
 
       if(status == 0)
       {
         break; //stop inner loop if we have hit the threshold value for x
       }
-      // Check to see if we are canceled.
-      if (getCancel() == true) { setErrorCondition(-999); return; }
 
       // Write out the VTK file
       //    {
@@ -755,23 +981,48 @@ void HAADF_ReconstructionEngine::execute()
       //    }
       // Write out the MRC File
       {
-        ss.str("");
-        ss << m_TomoInputs->tempDir << MXADir::getSeparator() << reconOuterIter << "_" << reconInnerIter << "_" << MBIR::Defaults::ReconstructedMrcFile;
-        m_ForwardModel->writeMRCFile(ss.str(), cropStart, cropEnd);
-        notify(ss.str(), 0, Observable::UpdateIntermediateImage);
-        m_TomoInputs->tempFiles.push_back(ss.str());
+        snapshotWriter->snapshot(reconOuterIter, reconInnerIter);
+      }
+
+      // Checkpoints are taken between iterations so a resumed run starts with the next one
+      checkpoint->setCounter("Resolution", m_TomoInputs->resolution);
+      checkpoint->setCounter("OuterIteration", reconOuterIter);
+      checkpoint->setCounter("InnerIteration", reconInnerIter + 1);
+      checkpoint->setCounter("VoxelUpdatePasses", m_VoxelUpdatePasses);
+      checkpoint->setCounter("SigmaX", m_TomoInputs->SigmaX);
+
+      // Check to see if we are canceled.
+      if (getCancel() == true)
+      {
+        // Keep what has been reconstructed so far so the run can be resumed
+        if(checkpoint->isEnabled() == true)
+        {
+          checkpoint->checkpoint();
+          checkpoint->finish();
+        }
+        setErrorCondition(-999);
+        return;
       }
+      checkpoint->checkpointIfDue();
 
     } /* ++++++++++ END Inner Iteration Loop +++++++++++++++ */
 
 
     if(m_AdvParams->JOINT_ESTIMATION)
     {
-      err = jointEstimation(Weight, ErrorSino, Y_Est, cost);
+      err = jointEstimation(Weight, ErrorSino, cost);
       if(err < 0)
       {
         break;
       }
+#ifndef COST_CALCULATE
+      //The new gains and offsets change the cost so the tracking restarts from
+      //the exact value. With COST_CALCULATE jointEstimation already did this
+      if(m_AdvParams->TRACK_COST)
+      {
+        calculateCost(cost, Weight, ErrorSino);
+      }
+#endif //cost
     } //Joint estimation endif
 
     if(m_AdvParams->NOISE_MODEL)
@@ -784,6 +1035,12 @@ void HAADF_ReconstructionEngine::execute()
         std::cout << "Cost went up after variance update" << std::endl;
         break;
       }
+#else
+      //The new weights change the cost so the tracking restarts from the exact value
+      if(m_AdvParams->TRACK_COST)
+      {
+        calculateCost(cost, Weight, ErrorSino);
+      }
 #endif//cost
 
       if(0 == status && reconOuterIter >= 1) //&& VarRatio < STOPPING_THRESHOLD_Var_k && I_kRatio < STOPPING_THRESHOLD_I_k && Delta_kRatio < STOPPING_THRESHOLD_Delta_k)
@@ -813,6 +1070,10 @@ void HAADF_ReconstructionEngine::execute()
     }
 
   }/* ++++++++++ END Outer Iteration Loop +++++++++++++++ */
+  snapshotWriter->finish();
+  checkpoint->finish();
+  checkpoint = ReconstructionCheckpoint::NullPointer();
+  m_FinalCost = computeCost(ErrorSino, Weight);
 
 
 
@@ -872,34 +1133,14 @@ void HAADF_ReconstructionEngine::execute()
   // This is writing the "ReconstructedSinogram.bin" file
   m_ForwardModel->writeSinogramFile(getSinogram(), Final_Sinogram); // Writes the sinogram to a file
 
-  // Writes ReconstructedObject.bin file
-  {
-    std::stringstream ss;
-    ss << m_TomoInputs->tempDir << MXADir::getSeparator() << MBIR::Defaults::ReconstructedObjectFile;
-    m_ForwardModel->writeReconstructionFile(ss.str());
-  }
-  // Write out the VTK file
-  if (m_TomoInputs->vtkOutputFile.empty() == false)
+  // Writes ReconstructedObject.bin file. The multi resolution driver hands the
+  // volume to the next resolution in memory so this is only a debug output.
+  if (m_TomoInputs->reconstructedOutputFile.empty() == false)
   {
-    //  std::stringstream ss;
-    //  ss << m_TomoInputs->tempDir << MXADir::getSeparator() << MBIR::Defaults::ReconstructedVtkFile;
-    m_ForwardModel->writeVtkFile(m_TomoInputs->vtkOutputFile, cropStart, cropEnd);
-  }
-  // Write out the MRC File
-  if (m_TomoInputs->mrcOutputFile.empty() == false)
-  {
-    //  std::stringstream ss;
-    //  ss << m_TomoInputs->tempDir << MXADir::getSeparator() << MBIR::Defaults::ReconstructedMrcFile;
-    //TODO: Remove this HACK (+1)
-    cropEnd += 1;
-    m_ForwardModel->writeMRCFile(m_TomoInputs->mrcOutputFile, cropStart, cropEnd);
-  }
-
-  // std::cout << "Should be writing .am file....  '" << m_TomoInputs->avizoOutputFile << "'"  << std::endl;
-  if (m_TomoInputs->avizoOutputFile.empty() == false)
-  {
-    m_ForwardModel->writeAvizoFile(m_TomoInputs->avizoOutputFile, cropStart, cropEnd);
+    m_ForwardModel->writeReconstructionFile(m_TomoInputs->reconstructedOutputFile);
   }
+  // Write out the VTK, MRC and Avizo files from one pass over the volume
+  m_ForwardModel->writeVolumeFiles(cropStart, cropEnd);
 
   std::cout << "Final Dimensions of Object: " << std::endl;
   std::cout << "  Nx = " << m_Geometry->N_x << std::endl;
@@ -1148,23 +1389,18 @@ Real_t HAADF_ReconstructionEngine::computeCost(RealVolumeType::Pointer ErrorSino
 {
   Real_t cost = 0, temp = 0;
   Real_t delta;
-  Real_t errSinoValue = 0.0;
 #ifdef EIMTOMO_USE_QGGMRF
   //DATA_TYPE MRF_C_TIMES_SIGMA_P_Q= MRF_C*SIGMA_X_P_Q;
 #endif
   //  int16_t p,q,r;
 
   //Data Mismatch Error
+  std::vector<TiltMoments> moments;
+  SinogramStatistics::computeTiltMoments(m_Sinogram, ErrorSino, Weight, RealArrayType::NullPointer(),
+                                         RealArrayType::NullPointer(), BitVolume::NullPointer(), moments);
   for (int16_t i = 0; i < m_Sinogram->N_theta; i++)
   {
-    for (int16_t j = 0; j < m_Sinogram->N_r; j++)
-    {
-      for (int16_t k = 0; k < m_Sinogram->N_t; k++)
-      {
-        errSinoValue = ErrorSino->getValue(i, j, k);
-        cost += (errSinoValue * errSinoValue * Weight->getValue(i, j, k) );
-      }
-    }
+    cost += moments[i].SumWEE;
   }
 
   cost /= 2;
@@ -1367,7 +1603,7 @@ Real_t HAADF_ReconstructionEngine::computeCost(RealVolumeType::Pointer ErrorSino
 //
 // -----------------------------------------------------------------------------
 AMatrixCol::Pointer HAADF_ReconstructionEngine::calculateAMatrixColumnPartial(uint16_t row, uint16_t col, uint16_t slice,
-    RealVolumeType::Pointer DetectorResponse)
+    RealVolumeType::Pointer DetectorResponse, uint32_t firstView)
 {
   int32_t j, k, sliceidx;
   Real_t x, z, y;
@@ -1419,7 +1655,7 @@ AMatrixCol::Pointer HAADF_ReconstructionEngine::calculateAMatrixColumnPartial(ui
 
   if(m_AdvParams->AREA_WEIGHTED)
   {
-    for (uint32_t i = 0; i < m_Sinogram->N_theta; i++)
+    for (uint32_t i = firstView; i < m_Sinogram->N_theta; i++)
     {
 
       r = x * cosine->d[i] - z * sine->d[i];
@@ -1523,6 +1759,24 @@ AMatrixCol::Pointer HAADF_ReconstructionEngine::calculateAMatrixColumnPartial(ui
   return Ai;
 }
 
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+AMatrixCol::Pointer HAADF_ReconstructionEngine::appendViews(AMatrixCol::Pointer cached, uint16_t row, uint16_t col,
+                                                            RealVolumeType::Pointer DetectorResponse, uint32_t firstView)
+{
+  AMatrixCol::Pointer added = calculateAMatrixColumnPartial(row, col, 0, DetectorResponse, firstView);
+  // The entries are sorted by view so the new ones go after the cached ones
+  size_t dims[1] = { cached->count + added->count };
+  AMatrixCol::Pointer Ai = AMatrixCol::New(dims, 0);
+  ::memcpy(Ai->values, cached->values, cached->count * sizeof(Real_t));
+  ::memcpy(Ai->index, cached->index, cached->count * sizeof(uint32_t));
+  ::memcpy(Ai->values + cached->count, added->values, added->count * sizeof(Real_t));
+  ::memcpy(Ai->index + cached->count, added->index, added->count * sizeof(uint32_t));
+  Ai->setCount(cached->count + added->count);
+  return Ai;
+}
+
 #ifndef EIMTOMO_USE_QGGMRF
 // -----------------------------------------------------------------------------
 //
@@ -53,6 +53,7 @@
 #include "MBIRLib/Reconstruction/ReconstructionStructures.h"
 #include "MBIRLib/HAADF/HAADFConstants.h"
 #include "MBIRLib/HAADF/HAADF_ForwardModel.h"
+#include "MBIRLib/HAADF/HAADF_PrecomputeCache.h"
 #include "MBIRLib/Reconstruction/ReconstructionConstants.h"
 #include "MBIRLib/Reconstruction/QGGMRF_Functions.h"
 
@@ -83,6 +84,14 @@ class MBIRLib_EXPORT HAADF_ReconstructionEngine : public AbstractFilter
     MXA_INSTANCE_PROPERTY(TomoInputsPtr, BFTomoInputs)
     MXA_INSTANCE_PROPERTY(SinogramPtr, BFSinogram)
 
+    /* Optional. When set the detector response, H_t and the partial A matrix
+     * are looked up by geometry and only computed when they are not in it */
+    MXA_INSTANCE_PROPERTY(HAADF_PrecomputeCache::Pointer, PrecomputeCache)
+
+    /* Exact cost and the number of voxel update passes of the last execute() */
+    MXA_INSTANCE_PROPERTY(Real_t, FinalCost)
+    MXA_INSTANCE_PROPERTY(int, VoxelUpdatePasses)
+
     static void InitializeTomoInputs(TomoInputsPtr);
     static void InitializeSinogram(SinogramPtr);
     static void InitializeGeometry(GeometryPtr);
@@ -113,6 +122,16 @@ class MBIRLib_EXPORT HAADF_ReconstructionEngine : public AbstractFilter
     Real_t computeCost(RealVolumeType::Pointer ErrorSino,
                        RealVolumeType::Pointer Weight);
 
+    /**
+     * @brief Records the incrementally tracked cost after a pass of voxel updates.
+     * The exact cost is only computed when the tracking needs to be resynchronized
+     * or to confirm an apparent increase in the cost.
+     * @return -1 if the cost increased, 0 otherwise
+     */
+    int checkTrackedCost(CostData::Pointer cost,
+                         RealVolumeType::Pointer Weight,
+                         RealVolumeType::Pointer ErrorSino);
+
 
     /**
      *
@@ -206,7 +225,6 @@ class MBIRLib_EXPORT HAADF_ReconstructionEngine : public AbstractFilter
 
     int jointEstimation(RealVolumeType::Pointer Weight,
                         RealVolumeType::Pointer ErrorSino,
-                        RealVolumeType::Pointer Y_Est,
                         CostData::Pointer cost);
 
     void costInitialization(SinogramPtr sinogram);
@@ -308,9 +326,18 @@ class MBIRLib_EXPORT HAADF_ReconstructionEngine : public AbstractFilter
      * @param col
      * @param slice
      * @param DetectorResponse
+     * @param firstView The views before it are left out of the column
      */
     AMatrixCol::Pointer calculateAMatrixColumnPartial(uint16_t row, uint16_t col, uint16_t slice,
-                                                      RealVolumeType::Pointer DetectorResponse);
+                                                      RealVolumeType::Pointer DetectorResponse,
+                                                      uint32_t firstView = 0);
+
+    /**
+     * @brief Appends the entries of the views from firstView on to the column
+     * a cached A matrix of the first views has for the voxel line
+     */
+    AMatrixCol::Pointer appendViews(AMatrixCol::Pointer cached, uint16_t row, uint16_t col,
+                                    RealVolumeType::Pointer DetectorResponse, uint32_t firstView);
 
     /**
      * @brief
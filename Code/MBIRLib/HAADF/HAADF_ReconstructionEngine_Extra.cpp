@@ -36,14 +36,34 @@
 
 #include "HAADF_ReconstructionEngine.h"
 #include "MBIRLib/HAADF/HAADFConstants.h"
+#include "MBIRLib/Reconstruction/SinogramStatistics.h"
 
 // Read the Input data from the supplied data file
 // We are scoping here so the various readers are automatically cleaned up before
 // the code goes any farther
 int HAADF_ReconstructionEngine::readInputData()
 {
+  // The multi resolution driver passes in the sinogram it read for all the resolutions
+  if (NULL != m_Sinogram->counts.get())
+  {
+    return 0;
+  }
+
   TomoFilter::Pointer dataReader = TomoFilter::NullPointer();
   std::string extension = MXAFileInfo::extension(m_TomoInputs->sinoFile);
+
+  // An MRC sinogram that an earlier reconstruction read is taken from the cache
+  std::string sinogramKey;
+  if(NULL != m_PrecomputeCache.get() && extension.compare("bin") != 0)
+  {
+    sinogramKey = HAADF_PrecomputeCache::MakeSinogramKey(m_TomoInputs, m_Sinogram);
+    if(m_PrecomputeCache->findSinogram(sinogramKey, m_TomoInputs, m_Sinogram) == true)
+    {
+      notify("Reusing the sinogram of an earlier reconstruction", 0, Observable::UpdateProgressMessage);
+      return 0;
+    }
+  }
+
   if(extension.compare("bin") == 0)
   {
     dataReader = RawSinogramInitializer::NewTomoFilter();
@@ -75,6 +95,10 @@ int HAADF_ReconstructionEngine::readInputData()
     setErrorCondition(dataReader->getErrorCondition());
     return -1;
   }
+  if(sinogramKey.empty() == false)
+  {
+    m_PrecomputeCache->insertSinogram(sinogramKey, m_TomoInputs, m_Sinogram);
+  }
   return 0;
 }
 
@@ -183,7 +207,12 @@ int HAADF_ReconstructionEngine::initializeRoughReconstructionData()
 {
   InitialReconstructionInitializer::Pointer geomInitializer = InitialReconstructionInitializer::NullPointer();
   std::string extension = MXAFileInfo::extension(m_TomoInputs->initialReconFile);
-  if (m_TomoInputs->initialReconFile.empty() == true)
+  if (NULL != m_TomoInputs->initialRecon.get())
+  {
+    // Upsample the volume of the previous resolution that is still in memory
+    geomInitializer = InitialReconstructionUpsampler::NewInitialReconstructionInitializer();
+  }
+  else if (m_TomoInputs->initialReconFile.empty() == true)
   {
     // This will just initialize all the values to Zero (0) or a DefaultValue Set by user
     geomInitializer = InitialReconstructionInitializer::New();
@@ -311,16 +340,7 @@ void HAADF_ReconstructionEngine::gainAndOffsetInitialization()
 // -----------------------------------------------------------------------------
 void HAADF_ReconstructionEngine::initializeVolume(RealVolumeType::Pointer Y_Est, double value)
 {
-  for (uint16_t i = 0; i < m_Sinogram->N_theta; i++)
-  {
-    for (uint16_t j = 0; j < m_Sinogram->N_r; j++)
-    {
-      for (uint16_t k = 0; k < m_Sinogram->N_t; k++)
-      {
-        Y_Est->setValue(value, i, j, k);
-      }
-    }
-  }
+  Y_Est->fill(value);
 }
 
 // -----------------------------------------------------------------------------
@@ -418,7 +438,6 @@ void HAADF_ReconstructionEngine::calculateArithmeticMean()
 // -----------------------------------------------------------------------------
 int HAADF_ReconstructionEngine::jointEstimation(RealVolumeType::Pointer Weight,
                                                 RealVolumeType::Pointer ErrorSino,
-                                                RealVolumeType::Pointer Y_Est,
                                                 CostData::Pointer cost)
 {
   std::stringstream ss;
@@ -439,52 +458,20 @@ int HAADF_ReconstructionEngine::jointEstimation(RealVolumeType::Pointer Weight,
 
     //Joint Scale And Offset Estimation
 
-    //forward project
-    for (uint16_t i_theta = 0; i_theta < m_Sinogram->N_theta; i_theta++)
-    {
-      for (uint16_t i_r = 0; i_r < m_Sinogram->N_r; i_r++)
-      {
-        for (uint16_t i_t = 0; i_t < m_Sinogram->N_t; i_t++)
-        {
-          //Y_Est->d[i_theta][i_r][i_t]=0;
-          Real_t ttmp = m_Sinogram->counts->getValue(i_theta, i_r, i_t) - ErrorSino->getValue(i_theta, i_r, i_t) - mu->d[i_theta];
-          Y_Est->setValue(ttmp, i_theta, i_r, i_t);
-          Y_Est->divideByValue(m_ForwardModel->getI_0()->d[i_theta], i_theta, i_r, i_t);
-        }
-      }
-    }
-
+    //The forward projection A*x = (y - e - mu) / I_0 is folded into the tilt
+    //moments so it never needs to be written out into Y_Est
     START_TIMER;
+    std::vector<TiltMoments> moments;
+    SinogramStatistics::computeTiltMoments(m_Sinogram, ErrorSino, Weight, I_0, mu, BitVolume::NullPointer(), moments);
     for (uint16_t i_theta = 0; i_theta < m_Sinogram->N_theta; i_theta++)
     {
-      Real_t a = 0;
-      Real_t b = 0;
-      Real_t c = 0;
-      Real_t d = 0;
-      //  DATA_TYPE e = 0;
-      Real_t numerator_sum = 0;
-      Real_t denominator_sum = 0;
-      //  DATA_TYPE temp = 0.0;
-
-      //compute the parameters of the quadratic for each view
-      for (uint16_t i_r = 0; i_r < m_Sinogram->N_r; i_r++)
-      {
-        for (uint16_t i_t = 0; i_t < m_Sinogram->N_t; i_t++)
-        {
-          size_t counts_idx = m_Sinogram->counts->calcIndex(i_theta, i_r, i_t);
-          size_t weight_idx = Weight->calcIndex(i_theta, i_r, i_t);
-          size_t yest_idx = Y_Est->calcIndex(i_theta, i_r, i_t);
-
-          numerator_sum += (m_Sinogram->counts->d[counts_idx] * Weight->d[weight_idx]);
-          denominator_sum += (Weight->d[weight_idx]);
-
-          a += (Y_Est->d[yest_idx] * Weight->d[weight_idx]);
-          b += (Y_Est->d[yest_idx] * Weight->d[weight_idx] * m_Sinogram->counts->d[counts_idx]);
-          c += (m_Sinogram->counts->d[counts_idx] * m_Sinogram->counts->d[counts_idx] * Weight->d[weight_idx]);
-          d += (Y_Est->d[yest_idx] * Y_Est->d[yest_idx] * Weight->d[weight_idx]);
-
-        }
-      }
+      const TiltMoments& m = moments[i_theta];
+      Real_t numerator_sum = m.SumWY;
+      Real_t denominator_sum = m.SumW;
+      Real_t a = m.SumWP;
+      Real_t b = m.SumWPY;
+      Real_t c = m.SumWYY;
+      Real_t d = m.SumWPP;
 
       bk_cost->setValue(numerator_sum, i_theta, 1); //yt*\lambda*1
       bk_cost->setValue(b, i_theta, 0); //yt*\lambda*(Ax)
@@ -496,35 +483,9 @@ int HAADF_ReconstructionEngine::jointEstimation(RealVolumeType::Pointer Weight,
       d1->d[i_theta] = numerator_sum / denominator_sum;
       d2->d[i_theta] = a / denominator_sum;
 
-      a = 0;
-      b = 0;
-      for (uint16_t i_r = 0; i_r < m_Sinogram->N_r; i_r++)
-      {
-        for (uint16_t i_t = 0; i_t < m_Sinogram->N_t; i_t++)
-        {
-          size_t counts_idx = m_Sinogram->counts->calcIndex(i_theta, i_r, i_t);
-          size_t weight_idx = Weight->calcIndex(i_theta, i_r, i_t);
-          size_t yest_idx = Y_Est->calcIndex(i_theta, i_r, i_t);
-
-          a += ((Y_Est->d[yest_idx] - d2->d[i_theta]) * Weight->d[weight_idx] * Y_Est->d[yest_idx]);
-          b -= ((m_Sinogram->counts->d[counts_idx] - d1->d[i_theta]) * Weight->d[weight_idx] * Y_Est->d[yest_idx]);
-        }
-      }
-      QuadraticParameters->setValue(a, i_theta, 0);
-      QuadraticParameters->setValue(b, i_theta, 1);
-
-#if 0
-      temp = (QuadraticParameters->getValue(i_theta, 1) * QuadraticParameters->getValue(i_theta, 1)) / (4 * QuadraticParameters->getValue(i_theta, 0));
-
-      if(temp > 0 && temp < high)
-      {
-        high = temp;
-      } //high holds the maximum value for the rooting operation. beyond this value discriminants become negative. Basically high = min{b^2/4*a}
-      else if(temp < 0 && temp > low)
-      {
-        low = temp;
-      }
-#endif
+      // sum((Ax - d2) * w * Ax) and -sum((y - d1) * w * Ax) expanded in terms of the moments
+      QuadraticParameters->setValue(d - d2->d[i_theta] * a, i_theta, 0);
+      QuadraticParameters->setValue(-(b - d1->d[i_theta] * a), i_theta, 1);
     }
     STOP_TIMER;
     PRINT_TIME("Joint Estimation Loops Time");
@@ -556,6 +517,8 @@ int HAADF_ReconstructionEngine::jointEstimation(RealVolumeType::Pointer Weight,
                / (Qk_cost->getValue(i_theta, 0) - Qk_cost->getValue(i_theta, 1) * d2->d[i_theta]));
     }
     Real_t LagrangeMultiplier = (-m_Sinogram->N_theta * m_ForwardModel->getTargetGain() + sum2) / sum1;
+    std::vector<Real_t> oldI_0(I_0->d, I_0->d + m_Sinogram->N_theta);
+    std::vector<Real_t> oldMu(mu->d, mu->d + m_Sinogram->N_theta);
     for (uint16_t i_theta = 0; i_theta < m_Sinogram->N_theta; i_theta++)
     {
 
@@ -597,21 +560,20 @@ int HAADF_ReconstructionEngine::jointEstimation(RealVolumeType::Pointer Weight,
     printf("The value of the data match error after updating the I and mu =%lf\n", sum);
     /*****************************************************************************************************/
 #endif //Cost calculate
-    //Reproject to compute Error Sinogram for ICD
+    //Reproject to compute Error Sinogram for ICD. With r = I_new / I_old,
+    //e_new = y - mu_new - I_new * (y - e - mu_old) / I_old
+    //      = (1 - r) * y + r * e + (r * mu_old - mu_new)
+    std::vector<Real_t> countsCoeff(m_Sinogram->N_theta);
+    std::vector<Real_t> errorCoeff(m_Sinogram->N_theta);
+    std::vector<Real_t> constant(m_Sinogram->N_theta);
     for (uint16_t i_theta = 0; i_theta < m_Sinogram->N_theta; i_theta++)
     {
-      for (uint16_t i_r = 0; i_r < m_Sinogram->N_r; i_r++)
-      {
-        for (uint16_t i_t = 0; i_t < m_Sinogram->N_t; i_t++)
-        {
-          size_t counts_idx = m_Sinogram->counts->calcIndex(i_theta, i_r, i_t);
-          size_t yest_idx = Y_Est->calcIndex(i_theta, i_r, i_t);
-          size_t error_idx = ErrorSino->calcIndex(i_theta, i_r, i_t);
-
-          ErrorSino->d[error_idx] = m_Sinogram->counts->d[counts_idx] - mu->d[i_theta] - (I_0->d[i_theta] * Y_Est->d[yest_idx]);
-        }
-      }
+      Real_t ratio = I_0->d[i_theta] / oldI_0[i_theta];
+      countsCoeff[i_theta] = 1.0 - ratio;
+      errorCoeff[i_theta] = ratio;
+      constant[i_theta] = ratio * oldMu[i_theta] - mu->d[i_theta];
     }
+    SinogramStatistics::affineErrorUpdate(m_Sinogram, ErrorSino, countsCoeff, errorCoeff, constant);
 
 #ifdef COST_CALCULATE
     int16_t err = calculateCost(cost, Weight, ErrorSino);
@@ -637,36 +599,23 @@ int HAADF_ReconstructionEngine::jointEstimation(RealVolumeType::Pointer Weight,
   }
   else //Only estimate the offsets
   {
-
+    std::vector<TiltMoments> moments;
+    SinogramStatistics::computeTiltMoments(m_Sinogram, ErrorSino, Weight, RealArrayType::NullPointer(),
+                                           RealArrayType::NullPointer(), BitVolume::NullPointer(), moments);
+    std::vector<Real_t> countsCoeff(m_Sinogram->N_theta, 0.0);
+    std::vector<Real_t> errorCoeff(m_Sinogram->N_theta, 1.0);
+    std::vector<Real_t> constant(m_Sinogram->N_theta);
     for (uint16_t i_theta = 0; i_theta < m_Sinogram->N_theta; i_theta++)
     {
-      Real_t num_sum = 0;
-      Real_t den_sum = 0;
-      Real_t alpha = 0;
-      for (uint16_t i_r = 0; i_r < m_Sinogram->N_r; i_r++)
-      {
-        for (uint16_t i_t = 0; i_t < m_Sinogram->N_t; i_t++)
-        {
-          num_sum += (ErrorSino->getValue(i_theta, i_r, i_t) * Weight->getValue(i_theta, i_r, i_t));
-          den_sum += Weight->getValue(i_theta, i_r, i_t);
-        }
-      }
-      alpha = num_sum / den_sum;
-
-      for (uint16_t i_r = 0; i_r < m_Sinogram->N_r; i_r++)
-      {
-        for (uint16_t i_t = 0; i_t < m_Sinogram->N_t; i_t++)
-        {
-          ErrorSino->deleteFromValue(alpha, i_theta, i_r, i_t);
-        }
-      }
-
+      Real_t alpha = moments[i_theta].SumWE / moments[i_theta].SumW;
+      constant[i_theta] = -alpha;
       mu->d[i_theta] += alpha;
       if(getVeryVerbose())
       {
         std::cout << "Theta: " << i_theta << " Mu: " << mu->d[i_theta] << std::endl;
       }
     }
+    SinogramStatistics::affineErrorUpdate(m_Sinogram, ErrorSino, countsCoeff, errorCoeff, constant);
 #ifdef COST_CALCULATE
     /*********************Cost Calculation*************************************/
     Real_t cost_value = computeCost(ErrorSino, Weight);
@@ -727,19 +676,27 @@ void HAADF_ReconstructionEngine::calculateMeasurementWeight(RealVolumeType::Poin
                                     - mu->d[i_theta];
         }
 
-#ifndef IDENTITY_NOISE_MODEL
-        if(m_Sinogram->counts->d[counts_idx] != 0)
+        if(NULL != m_Sinogram->weights.get())
         {
-          Weight->d[weight_idx] = 1.0 / m_Sinogram->counts->d[counts_idx];
+          //A binned measurement carries the weight of the mean it stands for
+          Weight->d[weight_idx] = m_Sinogram->weights->d[counts_idx];
         }
         else
         {
-          Weight->d[weight_idx] = 1e-10; //Set the weight to some small number
-          //TODO: Make this something resonable
-        }
+#ifndef IDENTITY_NOISE_MODEL
+          if(m_Sinogram->counts->d[counts_idx] != 0)
+          {
+            Weight->d[weight_idx] = 1.0 / m_Sinogram->counts->d[counts_idx];
+          }
+          else
+          {
+            Weight->d[weight_idx] = 1e-10; //Set the weight to some small number
+            //TODO: Make this something resonable
+          }
 #else
-        Weight->d[weight_idx] = 1.0;
+          Weight->d[weight_idx] = 1.0;
 #endif //IDENTITY_NOISE_MODEL endif
+        }
 #ifdef FORWARD_PROJECT_MODE
         temp = Y_Est->d[i_theta][i_r][i_t] / I_0->d[i_theta];
         fwrite(&temp, sizeof(Real_t), 1, Fp6);
@@ -780,6 +737,7 @@ int HAADF_ReconstructionEngine::calculateCost(CostData::Pointer cost,
 {
   Real_t cost_value = computeCost(ErrorSino, Weight);
   std::cout << "cost_value: " << cost_value << std::endl;
+  cost->resetTrackedCost(cost_value);
   int increase = cost->addCostValue(cost_value);
   if(increase == 1)
   {
@@ -789,6 +747,28 @@ int HAADF_ReconstructionEngine::calculateCost(CostData::Pointer cost,
   return 0;
 }
 
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADF_ReconstructionEngine::checkTrackedCost(CostData::Pointer cost,
+                                                 RealVolumeType::Pointer Weight,
+                                                 RealVolumeType::Pointer ErrorSino)
+{
+  //An apparent increase may only be accumulated drift so confirm it exactly
+  if(cost->needsExactCost() || cost->getTrackedCost() > cost->getLastCostValue())
+  {
+    if(getVeryVerbose())
+    {
+      std::cout << "Tracked cost: " << cost->getTrackedCost() << std::endl;
+    }
+    return calculateCost(cost, Weight, ErrorSino);
+  }
+  Real_t cost_value = cost->getTrackedCost();
+  cost->addCostValue(cost_value);
+  cost->writeCostValue(cost_value);
+  return 0;
+}
+
 // -----------------------------------------------------------------------------
 // Updating the Weights for Noise Model
 // -----------------------------------------------------------------------------
@@ -800,70 +780,57 @@ void HAADF_ReconstructionEngine::updateWeights(RealVolumeType::Pointer Weight,
   Real_t sum = 0;
   RealArrayType::Pointer alpha = m_ForwardModel->getAlpha();
 
+  //Factoring out the variance parameter from the Weight matrix: the variance
+  //is estimated with the unscaled weights (1/y or 1) directly from the moments.
+  //A binned sinogram carries its unscaled weights instead.
+  RealVolumeType::Pointer binnedWeights = m_Sinogram->weights;
+  std::vector<TiltMoments> moments;
+  SinogramStatistics::computeTiltMoments(m_Sinogram, ErrorSino, binnedWeights, RealArrayType::NullPointer(),
+                                         RealArrayType::NullPointer(), BitVolume::NullPointer(), moments);
+  std::vector<Real_t> newAlpha(m_Sinogram->N_theta);
   for (uint16_t i_theta = 0; i_theta < m_Sinogram->N_theta; i_theta++)
   {
-    sum = 0;
-    //Factoring out the variance parameter from the Weight matrix
-    for (uint16_t i_r = 0; i_r < m_Sinogram->N_r; i_r++)
+    if(NULL != binnedWeights.get())
+    {
+      sum = moments[i_theta].SumWEE;
+    }
+    else
     {
-      for (uint16_t i_t = 0; i_t < m_Sinogram->N_t; i_t++)
-      {
-        size_t weight_idx = Weight->calcIndex(i_theta, i_r, i_t);
-        //     size_t yest_idx = Y_Est->calcIndex(i_theta, i_r, i_t);
-        //    size_t error_idx = ErrorSino->calcIndex(i_theta, i_r, i_t);
 #ifndef IDENTITY_NOISE_MODEL
-        size_t counts_idx = m_Sinogram->counts->calcIndex(i_theta, i_r, i_t);
-        if(m_Sinogram->counts->d[counts_idx] != 0)
-        {
-          Weight->d[weight_idx] = 1.0 / m_Sinogram->counts->d[counts_idx];
-        }
-        else
-        {
-          Weight->d[weight_idx] = 1.0;
-        }
+      sum = moments[i_theta].SumEEOverY; //Changed to only account for the counts
 #else
-        Weight->d[weight_idx] = 1.0;
+      sum = moments[i_theta].SumEE;
 #endif//Identity noise Model
-      }
-    }
-
-    for (uint16_t i_r = 0; i_r < m_Sinogram->N_r; i_r++)
-    {
-      for (uint16_t i_t = 0; i_t < m_Sinogram->N_t; i_t++)
-      {
-        size_t error_idx = ErrorSino->calcIndex(i_theta, i_r, i_t);
-        size_t weight_idx = Weight->calcIndex(i_theta, i_r, i_t);
-        sum += (ErrorSino->d[error_idx] * ErrorSino->d[error_idx] * Weight->d[weight_idx]); //Changed to only account for the counts
-      }
     }
     sum /= (m_Sinogram->N_r * m_Sinogram->N_t);
 
     AverageMagVar += fabs(alpha->d[i_theta]);
     AverageVarUpdate += fabs(sum - alpha->d[i_theta]);
     alpha->d[i_theta] = sum;
-    //Update the weight for ICD updates
-    for (uint16_t i_r = 0; i_r < m_Sinogram->N_r; i_r++)
-    {
-      for (uint16_t i_t = 0; i_t < m_Sinogram->N_t; i_t++)
-      {
+    newAlpha[i_theta] = sum;
+  }
 
-        size_t weight_idx = Weight->calcIndex(i_theta, i_r, i_t);
+  //Update the weight for ICD updates
+  if(NULL != binnedWeights.get())
+  {
+    for (uint16_t i_theta = 0; i_theta < m_Sinogram->N_theta; i_theta++)
+    {
+      newAlpha[i_theta] = 1.0 / newAlpha[i_theta];
+    }
+    Weight->copyFrom(binnedWeights);
+    SinogramStatistics::scaleTilts(Weight, newAlpha);
+  }
+  else
+  {
 #ifndef IDENTITY_NOISE_MODEL
-        size_t counts_idx = m_Sinogram->counts->calcIndex(i_theta, i_r, i_t);
-        if(alpha->d[i_theta] != 0 && m_Sinogram->counts->d[counts_idx] != 0)
-        {
-          Weight->d[weight_idx] = 1.0 / (m_Sinogram->counts->d[counts_idx] * alpha->d[i_theta]);
-        }
-        else
-        {
-          Weight->d[weight_idx] = 1.0;
-        }
+    SinogramStatistics::inverseCountWeights(m_Sinogram, Weight, newAlpha, 1.0);
 #else
-        Weight->d[weight_idx] = 1.0 / alpha->d[i_theta];
-#endif //IDENTITY_NOISE_MODEL endif
-      }
+    for (uint16_t i_theta = 0; i_theta < m_Sinogram->N_theta; i_theta++)
+    {
+      newAlpha[i_theta] = 1.0 / newAlpha[i_theta];
     }
-
+    SinogramStatistics::fillTilts(Weight, newAlpha);
+#endif //IDENTITY_NOISE_MODEL endif
   }
 
   if(getVeryVerbose())
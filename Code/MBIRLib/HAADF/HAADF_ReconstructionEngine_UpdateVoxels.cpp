@@ -100,6 +100,7 @@ class UpdateYSlice
                  Real_t nh_Threshold,
                  Real_t* averageUpdate,
                  Real_t* averageMagnitudeOfRecon,
+                 Real_t* costChange,
                  unsigned int zeroSkipping) :
       m_YStart(yStart),
       m_YEnd(yEnd),
@@ -123,6 +124,7 @@ class UpdateYSlice
       m_CurrentVoxelValue(0.0),
       m_AverageUpdate(averageUpdate),
       m_AverageMagnitudeOfRecon(averageMagnitudeOfRecon),
+      m_CostChange(costChange),
       m_ZeroSkipping(zeroSkipping)
     {
       initVariables();
@@ -420,6 +422,17 @@ class UpdateYSlice
                   *m_AverageMagnitudeOfRecon += fabs(m_CurrentVoxelValue); //computing the percentage update =(Change in mag/Initial magnitude)
                 }
 #endif
+                //Change in cost: the data term follows from THETA1/THETA2 and
+                //the prior term is local to the neighborhood
+                if(NULL != m_CostChange)
+                {
+                  Real_t delta = UpdatedVoxelValue - m_CurrentVoxelValue;
+                  *m_CostChange += THETA1 * delta + 0.5 * THETA2 * delta * delta;
+#ifdef EIMTOMO_USE_QGGMRF
+                  *m_CostChange += QGGMRF::LocalCostChange(m_CurrentVoxelValue, UpdatedVoxelValue,
+                                                           BOUNDARYFLAG, FILTER, NEIGHBORHOOD, m_QggmrfValues);
+#endif //QGGMRF
+                }
                 Real_t kConst2 = 0.0;
                 // Get the current AMatrixCol to reduce function overhead in this tight loop
                 uint32_t end = voxelLineResponse->index[0] + voxelLineResponse->count;
@@ -512,6 +525,7 @@ class UpdateYSlice
     Real_t* m_AverageUpdate;
     Real_t* m_AverageMagnitudeOfRecon;
 #endif
+    Real_t* m_CostChange;
     unsigned int m_ZeroSkipping;
 
     //if 1 then this is NOT outside the support region; If 0 then that pixel should not be considered
@@ -665,6 +679,7 @@ uint8_t HAADF_ReconstructionEngine::updateVoxels(int16_t OuterIter, int16_t Iter
     Real_t AverageUpdate = 0;
     Real_t AverageMagnitudeOfRecon = 0;
 #endif
+    Real_t CostChange = 0;
 
     START_TIMER;
 #if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
@@ -685,6 +700,8 @@ uint8_t HAADF_ReconstructionEngine::updateVoxels(int16_t OuterIter, int16_t Iter
     ::memset(averageUpdate, 0, sizeof(Real_t) * m_NumThreads);
     Real_t* averageMagnitudeOfRecon = (Real_t*)(malloc(sizeof(Real_t) * m_NumThreads));
     ::memset(averageMagnitudeOfRecon, 0, sizeof(Real_t) * m_NumThreads);
+    Real_t* costChange = (Real_t*)(malloc(sizeof(Real_t) * m_NumThreads));
+    ::memset(costChange, 0, sizeof(Real_t) * m_NumThreads);
     for (int t = 0; t < m_NumThreads; ++t)
     {
       yStart = yStop;
@@ -708,6 +725,7 @@ uint8_t HAADF_ReconstructionEngine::updateVoxels(int16_t OuterIter, int16_t Iter
                                                        NH_Threshold,
                                                        averageUpdate + t,
                                                        averageMagnitudeOfRecon + t,
+                                                       (m_AdvParams->TRACK_COST) ? costChange + t : NULL,
                                                        m_AdvParams->ZERO_SKIPPING);
       taskList.push_back(a);
     }
@@ -718,9 +736,11 @@ uint8_t HAADF_ReconstructionEngine::updateVoxels(int16_t OuterIter, int16_t Iter
     {
       AverageUpdate += averageUpdate[t];
       AverageMagnitudeOfRecon += averageMagnitudeOfRecon[t];
+      CostChange += costChange[t];
     }
     free(averageUpdate);
     free(averageMagnitudeOfRecon);
+    free(costChange);
 
 #else
     uint16_t yStop = m_Geometry->N_y;
@@ -737,6 +757,7 @@ uint8_t HAADF_ReconstructionEngine::updateVoxels(int16_t OuterIter, int16_t Iter
                               NH_Threshold,
                               &AverageUpdate,
                               &AverageMagnitudeOfRecon,
+                              (m_AdvParams->TRACK_COST) ? &CostChange : NULL,
                               m_AdvParams->ZERO_SKIPPING);
 
     yVoxelUpdate.execute();
@@ -747,20 +768,21 @@ uint8_t HAADF_ReconstructionEngine::updateVoxels(int16_t OuterIter, int16_t Iter
     ss << "Inner Iter: " << Iter << " Voxel Update";
     PRINT_TIME(ss.str());
 
-#ifdef COST_CALCULATE
-
     /*********************Cost Calculation*************************************/
-    Real_t cost_value = computeCost(ErrorSino, Weight);
-    std::cout << cost_value << std::endl;
-    int increase = cost->addCostValue(cost_value);
-    if(increase == 1)
+    if(m_AdvParams->TRACK_COST)
     {
-      std::cout << "Cost just increased after ICD!" << std::endl;
-      break;
+      cost->addTrackedCostChange(CostChange);
+      if(checkTrackedCost(cost, Weight, ErrorSino) < 0)
+      {
+#ifdef COST_CALCULATE
+        std::cout << "Cost just increased after ICD!" << std::endl;
+        break;
+#else
+        notify("Cost just increased after ICD!", 0, Observable::UpdateWarningMessage);
+#endif //Cost calculation endif
+      }
     }
-    cost->writeCostValue(cost_value);
     /**************************************************************************/
-#endif //Cost calculation endif
 
 #if ROI
     if (getVerbose())
@@ -0,0 +1,416 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "HAADF_StreamingReconstruction.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+#include <sstream>
+
+#if defined (_MSC_VER)
+#include <windows.h>
+#define MBIR_STREAMING_SLEEP(ms) Sleep(ms)
+#else
+#include <unistd.h>
+#define MBIR_STREAMING_SLEEP(ms) ::usleep((ms) * 1000)
+#endif
+
+#include "MXA/Utilities/MXAFileInfo.h"
+
+#include "MBIRLib/Common/EIMTime.h"
+#include "MBIRLib/IOFilters/MRCHeader.h"
+#include "MBIRLib/IOFilters/MRCReader.h"
+#include "MBIRLib/Reconstruction/ReconstructionConstants.h"
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADF_StreamingReconstruction::HAADF_StreamingReconstruction() :
+  m_TiltSelection(0),
+  m_MinimumTilts(3),
+  m_ExpectedTilts(0),
+  m_IdleTimeout(600.0f),
+  m_PollInterval(2.0f),
+  m_ErrorCondition(0),
+  m_RoundsRun(0),
+  m_ReconstructedTilts(0),
+  m_Cancel(false),
+  m_Configured(false),
+  m_FileXSize(0),
+  m_FileYSize(0),
+  m_LastViews(0),
+  m_LastMaxAngle(0.0)
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+HAADF_StreamingReconstruction::~HAADF_StreamingReconstruction()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void HAADF_StreamingReconstruction::setCancel(bool value)
+{
+  m_Cancel = value;
+  if(NULL != m_Reconstruction.get())
+  {
+    m_Reconstruction->setCancel(value);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool HAADF_StreamingReconstruction::getCancel()
+{
+  return m_Cancel;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADF_StreamingReconstruction::availableTilts(std::vector<float>& tilts)
+{
+  tilts.clear();
+  std::string path = m_Reconstruction->getInputFile();
+  if(MXAFileInfo::exists(path) == false)
+  {
+    return 0;
+  }
+  MRCHeader header;
+  ::memset(&header, 0, sizeof(header));
+  MRCReader::Pointer reader = MRCReader::New(true);
+  if(reader->readHeader(path, &header) < 0)
+  {
+    // The acquisition has not written the complete header yet
+    FREE_FEI_HEADERS(header.feiHeaders)
+    return 0;
+  }
+  size_t typeSize = MRCReader::getTypeSize(header.mode);
+  if(NULL == header.feiHeaders || typeSize == 0)
+  {
+    FREE_FEI_HEADERS(header.feiHeaders)
+    setErrorCondition(-1);
+    m_Reconstruction->pipelineErrorMessage("Streaming needs an MRC stack of a supported mode with the tilt angles in FEI headers: " + path);
+    return -1;
+  }
+
+  // Only sections whose data is completely in the file count
+  uint64_t dataStart = 1024 + static_cast<uint64_t>(header.next);
+  uint64_t sectionBytes = static_cast<uint64_t>(header.nx) * static_cast<uint64_t>(header.ny) * typeSize;
+  uint64_t fileSize = MXAFileInfo::fileSize(path);
+  uint64_t complete = (fileSize > dataStart && sectionBytes > 0) ? (fileSize - dataStart) / sectionBytes : 0;
+  if(complete < static_cast<uint64_t>(header.nz))
+  {
+    FREE_FEI_HEADERS(header.feiHeaders)
+    return 0;
+  }
+
+  tilts.resize(header.nz, 0.0f);
+  for (int l = 0; l < header.nz; ++l)
+  {
+    tilts[l] = (m_TiltSelection == 0) ? header.feiHeaders[l].a_tilt : header.feiHeaders[l].b_tilt;
+  }
+  m_FileXSize = header.nx;
+  m_FileYSize = header.ny;
+  FREE_FEI_HEADERS(header.feiHeaders)
+  return header.nz;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::vector<int> HAADF_StreamingReconstruction::includedViews(const std::vector<uint16_t>& subvolume)
+{
+  std::vector<uint8_t> masks = m_Reconstruction->getViewMasks();
+  std::vector<int> views;
+  for (int i = subvolume[2]; i <= subvolume[5]; ++i)
+  {
+    bool excluded = false;
+    for (size_t j = 0; j < masks.size(); ++j)
+    {
+      excluded |= (masks[j] == i);
+    }
+    if(excluded == false)
+    {
+      views.push_back(i);
+    }
+  }
+  return views;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+RealArrayType::Pointer HAADF_StreamingReconstruction::ExtendParameters(RealArrayType::Pointer converged, size_t numViews, const std::string& name)
+{
+  if(NULL == converged.get())
+  {
+    return RealArrayType::NullPointer();
+  }
+  size_t numConverged = converged->getDims()[0];
+  size_t dims[1] = { numViews };
+  RealArrayType::Pointer extended = RealArrayType::New(dims, name);
+  Real_t mean = 0.0;
+  for (size_t i = 0; i < numConverged; ++i)
+  {
+    mean += converged->d[i];
+  }
+  if(numConverged > 0)
+  {
+    mean /= static_cast<Real_t>(numConverged);
+  }
+  // The stack only grows at its end so the converged views come first
+  for (size_t i = 0; i < numViews; ++i)
+  {
+    extended->d[i] = (i < numConverged) ? converged->d[i] : mean;
+  }
+  return extended;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADF_StreamingReconstruction::reconstruct(int numTilts)
+{
+  HAADF_MultiResolutionReconstruction::Pointer reconstruction = m_Reconstruction;
+  std::stringstream ss;
+  std::vector<float> tilts;
+  int available = availableTilts(tilts);
+  if(available < 0)
+  {
+    return -1;
+  }
+  if(numTilts < 1 || available < numTilts)
+  {
+    ss << "Only " << available << " tilts of " << reconstruction->getInputFile() << " are complete, " << numTilts << " were requested";
+    setErrorCondition(-1);
+    reconstruction->pipelineErrorMessage(ss.str());
+    return -1;
+  }
+  tilts.resize(numTilts);
+
+  if(m_Configured == false)
+  {
+    m_Subvolume = reconstruction->getSubvolume();
+    if(NULL == reconstruction->getPrecomputeCache().get())
+    {
+      reconstruction->setPrecomputeCache(HAADF_PrecomputeCache::New());
+    }
+    m_Configured = true;
+  }
+
+  // The sections are pinned so tilts that arrive while this round reads the
+  // file are left for the next one
+  std::vector<uint16_t> subvolume(6, 0);
+  if(m_Subvolume.size() == 6)
+  {
+    subvolume = m_Subvolume;
+    if(subvolume[2] >= numTilts)
+    {
+      ss << "The subvolume starts at tilt " << subvolume[2] << " which has not arrived yet";
+      reconstruction->pipelineProgressMessage(ss.str());
+      return 0;
+    }
+    if(subvolume[5] >= numTilts)
+    {
+      subvolume[5] = numTilts - 1;
+    }
+  }
+  else
+  {
+    subvolume[3] = m_FileXSize - 1;
+    subvolume[4] = m_FileYSize - 1;
+    subvolume[5] = numTilts - 1;
+  }
+  std::vector<int> views = includedViews(subvolume);
+  int numViews = static_cast<int>(views.size());
+  if(numViews < 1 || (m_RoundsRun > 0 && numViews == m_LastViews))
+  {
+    // Excluded views or tilts past the end of the subvolume
+    ss << "None of the new tilts up to " << numTilts << " are in the reconstruction";
+    reconstruction->pipelineProgressMessage(ss.str());
+    return 0;
+  }
+  // The sinogram takes the angle of its n-th view from the n-th tilt, so it
+  // gets the tilts of the included views only
+  std::vector<float> viewTilts(numViews);
+  Real_t maxAngle = 0.0;
+  for (int v = 0; v < numViews; ++v)
+  {
+    viewTilts[v] = tilts[views[v]];
+    maxAngle = std::max(maxAngle, static_cast<Real_t>(fabs(viewTilts[v])));
+  }
+  reconstruction->setSubvolume(subvolume);
+  reconstruction->setTilts(viewTilts);
+  if(maxAngle > MBIR::Constants::k_MaxAngleStretch)
+  {
+    maxAngle = MBIR::Constants::k_MaxAngleStretch;
+  }
+
+  bool warmStart = (NULL != m_LastGeometry.get() && NULL != m_LastForwardModel.get() && numViews >= m_LastViews);
+  if(warmStart == true && reconstruction->getExtendObject() == true && maxAngle != m_LastMaxAngle)
+  {
+    // The width of an extended object follows the widest tilt so the last
+    // volume does not fit any more
+    reconstruction->pipelineProgressMessage("The widest tilt changed the size of the extended object. Reconstructing from scratch.");
+    warmStart = false;
+  }
+  if(warmStart == true)
+  {
+    HAADF_ForwardModel::Pointer forwardModel = HAADF_ForwardModel::New();
+    forwardModel->setI_0(ExtendParameters(m_LastForwardModel->getI_0(), numViews, "Streaming.Gains"));
+    forwardModel->setMu(ExtendParameters(m_LastForwardModel->getMu(), numViews, "Streaming.Offsets"));
+    forwardModel->setAlpha(ExtendParameters(m_LastForwardModel->getAlpha(), numViews, "Streaming.Variances"));
+    reconstruction->setWarmStartGeometry(m_LastGeometry);
+    reconstruction->setWarmStartForwardModel(forwardModel);
+  }
+  else
+  {
+    reconstruction->setWarmStartGeometry(GeometryPtr());
+    reconstruction->setWarmStartForwardModel(HAADF_ForwardModel::NullPointer());
+  }
+
+  ss << "-- Streaming round " << m_RoundsRun + 1 << ": " << numTilts << " tilts, " << numViews << " views, "
+     << ((warmStart == true) ? "warm started from the last round" : "all resolutions");
+  reconstruction->pipelineProgressMessage(ss.str());
+
+  unsigned long long start = EIMTOMO_getMilliSeconds();
+  reconstruction->execute();
+  // The next round gets the result of this one instead
+  reconstruction->setWarmStartGeometry(GeometryPtr());
+  reconstruction->setWarmStartForwardModel(HAADF_ForwardModel::NullPointer());
+  if(reconstruction->getErrorCondition() < 0)
+  {
+    setErrorCondition(reconstruction->getErrorCondition());
+    return -1;
+  }
+  // The next round extends the A matrices of this one with its new views
+  reconstruction->getPrecomputeCache()->trim();
+  m_LastGeometry = reconstruction->getFinalGeometry();
+  m_LastForwardModel = reconstruction->getFinalForwardModel();
+  m_LastViews = numViews;
+  m_LastMaxAngle = maxAngle;
+  m_RoundsRun++;
+  m_ReconstructedTilts = numTilts;
+
+  ss.str("");
+  ss << "-- Streaming round " << m_RoundsRun << " wrote " << reconstruction->getOutputFile() << " from " << numTilts
+     << " tilts in " << static_cast<double>(EIMTOMO_getMilliSeconds() - start) / 1000.0 << " s, final cost "
+     << reconstruction->getFinalCost();
+  reconstruction->pipelineProgressMessage(ss.str());
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int HAADF_StreamingReconstruction::execute()
+{
+  if(NULL == m_Reconstruction.get())
+  {
+    setErrorCondition(-1);
+    return -1;
+  }
+  setErrorCondition(0);
+  std::stringstream ss;
+  ss << "-- Waiting for tilts in " << m_Reconstruction->getInputFile();
+  m_Reconstruction->pipelineProgressMessage(ss.str());
+
+  int lastSeen = m_ReconstructedTilts;
+  int lastTried = m_ReconstructedTilts;
+  unsigned long long lastArrival = EIMTOMO_getMilliSeconds();
+  while (true)
+  {
+    if(getCancel() == true)
+    {
+      setErrorCondition(-999);
+      return -1;
+    }
+    std::vector<float> tilts;
+    int available = availableTilts(tilts);
+    if(available < 0)
+    {
+      return -1;
+    }
+    if(available > lastSeen)
+    {
+      lastSeen = available;
+      lastArrival = EIMTOMO_getMilliSeconds();
+    }
+
+    if(available > lastTried && available >= m_MinimumTilts)
+    {
+      lastTried = available;
+      if(reconstruct(available) < 0)
+      {
+        return -1;
+      }
+      lastArrival = EIMTOMO_getMilliSeconds();
+      continue;
+    }
+
+    if(m_ExpectedTilts > 0 && lastTried >= m_ExpectedTilts)
+    {
+      break;
+    }
+    if(m_IdleTimeout > 0.0f && EIMTOMO_getMilliSeconds() - lastArrival > static_cast<unsigned long long>(m_IdleTimeout * 1000.0f))
+    {
+      ss.str("");
+      ss << "-- No new tilt for " << m_IdleTimeout << " s. Assuming the acquisition ended.";
+      m_Reconstruction->pipelineProgressMessage(ss.str());
+      break;
+    }
+    MBIR_STREAMING_SLEEP(static_cast<unsigned int>(m_PollInterval * 1000.0f));
+  }
+
+  if(m_RoundsRun == 0)
+  {
+    setErrorCondition(-1);
+    m_Reconstruction->pipelineErrorMessage("No tilts were reconstructed");
+    return -1;
+  }
+  ss.str("");
+  ss << "-- Streaming finished after " << m_RoundsRun << " rounds with " << m_ReconstructedTilts << " tilts";
+  m_Reconstruction->pipelineProgressMessage(ss.str());
+  return 0;
+}
@@ -0,0 +1,149 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _HAADF_StreamingReconstruction_H_
+#define _HAADF_StreamingReconstruction_H_
+
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/HAADF/HAADF_MultiResolutionReconstruction.h"
+
+/**
+ * @class HAADF_StreamingReconstruction HAADF_StreamingReconstruction.h MBIRLib/HAADF/HAADF_StreamingReconstruction.h
+ * @brief Reconstructs a tilt series while it is being acquired. The input MRC
+ * stack of the Reconstruction is expected to grow one section at a time, the
+ * way the acquisition software of the microscope writes it.
+ *
+ * Every round reconstructs the tilts that are complete at its start. The
+ * first round runs all resolutions. The later ones only run the final
+ * resolution, starting from the volume and nuisance parameters of the round
+ * before. The views that arrived since then get the mean of the converged
+ * nuisance parameters as their initial values. Tilts that arrive during a
+ * round are all picked up by the next one, so when the acquisition ends the
+ * output file is at most one warm round behind. The rounds share a
+ * HAADF_PrecomputeCache, so each only computes the A matrix of its new views.
+ *
+ * execute() polls the file for new tilts. Acquisition software that writes
+ * the stack itself can instead call reconstruct() after every section it flushed.
+ */
+class MBIRLib_EXPORT HAADF_StreamingReconstruction
+{
+  public:
+    MXA_SHARED_POINTERS(HAADF_StreamingReconstruction)
+    MXA_TYPE_MACRO(HAADF_StreamingReconstruction)
+    MXA_STATIC_NEW_MACRO(HAADF_StreamingReconstruction)
+
+    virtual ~HAADF_StreamingReconstruction();
+
+    /* The configured reconstruction of the complete tilt series. Its
+     * messages also carry the reports of the rounds. */
+    MXA_INSTANCE_PROPERTY(HAADF_MultiResolutionReconstruction::Pointer, Reconstruction)
+    /* Which tilt angle of the FEI headers to use: 0 for alpha, 1 for beta */
+    MXA_INSTANCE_PROPERTY(int, TiltSelection)
+    /* Tilts to wait for before the first round */
+    MXA_INSTANCE_PROPERTY(int, MinimumTilts)
+    /* Stop once this many tilts are reconstructed. 0 when unknown */
+    MXA_INSTANCE_PROPERTY(int, ExpectedTilts)
+    /* Stop after this many seconds without a new tilt */
+    MXA_INSTANCE_PROPERTY(float, IdleTimeout)
+    /* Seconds between looks at the input file */
+    MXA_INSTANCE_PROPERTY(float, PollInterval)
+    MXA_INSTANCE_PROPERTY(int, ErrorCondition)
+
+    /* Rounds run so far and the tilts the last one reconstructed */
+    MXA_INSTANCE_PROPERTY(int, RoundsRun)
+    MXA_INSTANCE_PROPERTY(int, ReconstructedTilts)
+
+    void setCancel(bool value);
+    bool getCancel();
+
+    /**
+     * @brief Reconstructs rounds as tilts arrive until ExpectedTilts are done,
+     * no tilt arrived for IdleTimeout seconds or the operation was cancelled
+     * @return Error condition
+     */
+    int execute();
+
+    /**
+     * @brief Reconstructs the first numTilts sections of the input file,
+     * warm started from the last round if there was one
+     * @return Error condition
+     */
+    int reconstruct(int numTilts);
+
+    /**
+     * @brief Reads the header of the input file
+     * @param tilts The tilt angles of the complete sections
+     * @return The number of complete sections, 0 while a section is being
+     * written and negative on Error
+     */
+    int availableTilts(std::vector<float>& tilts);
+
+  protected:
+    HAADF_StreamingReconstruction();
+
+    /**
+     * @brief The sections of the subvolume that are views of the sinogram
+     * once the excluded views are taken out
+     */
+    std::vector<int> includedViews(const std::vector<uint16_t>& subvolume);
+
+    /**
+     * @brief Copies the converged parameters of the first views and gives the
+     * new views their mean
+     */
+    static RealArrayType::Pointer ExtendParameters(RealArrayType::Pointer converged, size_t numViews, const std::string& name);
+
+  private:
+    bool m_Cancel;
+    bool m_Configured;
+    std::vector<uint16_t> m_Subvolume; // The one the Reconstruction was configured with
+    int m_FileXSize;
+    int m_FileYSize;
+    GeometryPtr m_LastGeometry;
+    HAADF_ForwardModel::Pointer m_LastForwardModel;
+    int m_LastViews;
+    Real_t m_LastMaxAngle;
+
+    HAADF_StreamingReconstruction(const HAADF_StreamingReconstruction&); // Copy Constructor Not Implemented
+    void operator=(const HAADF_StreamingReconstruction&); // Operator '=' Not Implemented
+};
+
+#endif /* _HAADF_StreamingReconstruction_H_ */
@@ -15,7 +15,9 @@ set (MBIRLib_HAADF_SRCS
   ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_MultiResolutionReconstruction.cpp
   ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_ForwardModel.cpp
   ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_ForwardProject.cpp
+  ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_PrecomputeCache.cpp
   ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_ReconstructionEngine.cpp
+  ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_StreamingReconstruction.cpp
   ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_ReconstructionEngine_UpdateVoxels.cpp
   ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_ReconstructionEngine_Extra.cpp
 )
@@ -26,7 +28,9 @@ set (MBIRLib_HAADF_HDRS
     ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_QGGMRFPriorModel.h
     ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_MultiResolutionReconstruction.h
     ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_ForwardProject.h
+    ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_PrecomputeCache.h
     ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_ReconstructionEngine.h
+    ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_StreamingReconstruction.h
 )
 
 set_source_files_properties( ${MBIRLib_SOURCE_DIR}/HAADF/HAADF_ReconstructionEngine_UpdateVoxels.cpp
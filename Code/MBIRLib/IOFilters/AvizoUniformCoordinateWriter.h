@@ -77,15 +77,15 @@ class AvizoUniformCoordinateWriter : public TomoFilter
 
     int write();
 
-  protected:
-    AvizoUniformCoordinateWriter();
-
     /**
      * @brief Generates the Avizo Header for this file
      * @return The header as a string
      */
     std::string generateHeader();
 
+  protected:
+    AvizoUniformCoordinateWriter();
+
     /**
      * @brief Writes the data to the Avizo file
      * @param writer The MXAFileWriter object
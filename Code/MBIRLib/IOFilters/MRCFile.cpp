@@ -0,0 +1,307 @@
+/* ============================================================================
+ * Copyright (c) 2011, Michael A. Jackson (BlueQuartz Software)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Michael A. Jackson nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "MRCFile.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined (_MSC_VER)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "MBIRLib/IOFilters/MRCReader.h"
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MRCFile::MRCFile() :
+  m_ReadAheadSections(0),
+  m_Header(NULL),
+  m_TypeSize(0),
+#if defined (_MSC_VER)
+  m_FileHandle(INVALID_HANDLE_VALUE)
+#else
+  m_FileDescriptor(-1)
+#endif
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MRCFile::~MRCFile()
+{
+  close();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MRCFile::open(const std::string& filepath)
+{
+  close();
+#if defined (_MSC_VER)
+  m_FileHandle = ::CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (m_FileHandle == INVALID_HANDLE_VALUE)
+  {
+    return -1;
+  }
+#else
+  m_FileDescriptor = ::open(filepath.c_str(), O_RDONLY);
+  if (m_FileDescriptor < 0)
+  {
+    return -1;
+  }
+#endif
+  m_Header = new MRCHeader;
+  ::memset(m_Header, 0, 1024); // Splat zeros across the entire structure
+  m_Header->feiHeaders = NULL;
+  if (false == readAt(0, m_Header, 1024))
+  {
+    close();
+    return -2;
+  }
+
+  // Now read the extended header
+  if (m_Header->next < 0)
+  {
+    close();
+    return -3;
+  }
+  m_ExtendedHeader.resize(m_Header->next, 0);
+  if (m_Header->next > 0 && false == readAt(1024, &(m_ExtendedHeader.front()), m_Header->next))
+  {
+    close();
+    return -3;
+  }
+
+  // If we have an FEI header then parse the extended header information
+  MRCReader::parseFEIHeaders(m_Header, m_ExtendedHeader);
+
+  m_TypeSize = MRCReader::getTypeSize(m_Header->mode);
+  if (m_TypeSize == 0)
+  {
+    close();
+    return -5;
+  }
+  m_FilePath = filepath;
+  return 1;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MRCFile::close()
+{
+#if defined (_MSC_VER)
+  if (m_FileHandle != INVALID_HANDLE_VALUE) { ::CloseHandle(m_FileHandle); }
+  m_FileHandle = INVALID_HANDLE_VALUE;
+#else
+  if (m_FileDescriptor >= 0) { ::close(m_FileDescriptor); }
+  m_FileDescriptor = -1;
+#endif
+  if (NULL != m_Header)
+  {
+    if (NULL != m_Header->feiHeaders)
+    {
+      free(m_Header->feiHeaders);
+    }
+    delete m_Header;
+    m_Header = NULL;
+  }
+  m_ExtendedHeader.clear();
+  m_TypeSize = 0;
+  m_FilePath.clear();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool MRCFile::isOpen() const
+{
+  return NULL != m_Header;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+size_t MRCFile::getSectionSize() const
+{
+  if (NULL == m_Header) { return 0; }
+  return static_cast<size_t>(m_Header->nx) * m_Header->ny * m_TypeSize;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+uint64_t MRCFile::sectionOffset(int z) const
+{
+  return 1024 + static_cast<uint64_t>(m_Header->next) + static_cast<uint64_t>(z) * getSectionSize();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool MRCFile::readAt(uint64_t offset, void* buffer, size_t numBytes) const
+{
+  char* dest = reinterpret_cast<char*>(buffer);
+  while (numBytes > 0)
+  {
+#if defined (_MSC_VER)
+    OVERLAPPED overlapped;
+    ::memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.Offset = static_cast<DWORD>(offset & 0xFFFFFFFF);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD chunk = (numBytes > 0x40000000) ? 0x40000000 : static_cast<DWORD>(numBytes);
+    DWORD bytesRead = 0;
+    if (::ReadFile(m_FileHandle, dest, chunk, &bytesRead, &overlapped) == 0 || bytesRead == 0)
+    {
+      return false;
+    }
+#else
+    ssize_t bytesRead = ::pread(m_FileDescriptor, dest, numBytes, static_cast<off_t>(offset));
+    if (bytesRead <= 0)
+    {
+      return false;
+    }
+#endif
+    dest += bytesRead;
+    offset += bytesRead;
+    numBytes -= bytesRead;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MRCFile::readSection(int z, void* buffer)
+{
+  int xyMin[2] = {0, 0};
+  int xyMax[2] = {m_Header->nx - 1, m_Header->ny - 1};
+  return readSectionRegion(z, xyMin, xyMax, buffer);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MRCFile::readSectionRegion(int z, const int* xyMin, const int* xyMax, void* buffer)
+{
+  if (false == isOpen())
+  {
+    return -1;
+  }
+  if (z < 0 || z >= m_Header->nz
+      || xyMin[0] < 0 || xyMin[0] > xyMax[0] || xyMax[0] >= m_Header->nx
+      || xyMin[1] < 0 || xyMin[1] > xyMax[1] || xyMax[1] >= m_Header->ny)
+  {
+    return -2;
+  }
+  size_t rowBytes = static_cast<size_t>(xyMax[0] - xyMin[0] + 1) * m_TypeSize;
+  size_t numRows = xyMax[1] - xyMin[1] + 1;
+  uint64_t start = sectionOffset(z) + (static_cast<uint64_t>(xyMin[1]) * m_Header->nx + xyMin[0]) * m_TypeSize;
+  bool success = true;
+  if (xyMin[0] == 0 && xyMax[0] == m_Header->nx - 1)
+  {
+    // Full rows are contiguous in the file so read them in one go
+    success = readAt(start, buffer, rowBytes * numRows);
+  }
+  else
+  {
+    char* dest = reinterpret_cast<char*>(buffer);
+    uint64_t fileRowBytes = static_cast<uint64_t>(m_Header->nx) * m_TypeSize;
+    for (size_t row = 0; row < numRows && success; ++row)
+    {
+      success = readAt(start + row * fileRowBytes, dest + row * rowBytes, rowBytes);
+    }
+  }
+  if (false == success)
+  {
+    return -3;
+  }
+  if (m_ReadAheadSections > 0)
+  {
+    prefetchSections(z + 1, z + m_ReadAheadSections);
+  }
+  return 1;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MRCFile::readSubVolume(const int* voxelMin, const int* voxelMax, void* buffer)
+{
+  if (false == isOpen())
+  {
+    return -1;
+  }
+  if (voxelMin[2] < 0 || voxelMin[2] > voxelMax[2] || voxelMax[2] >= m_Header->nz)
+  {
+    return -2;
+  }
+  size_t sectionBytes = static_cast<size_t>(voxelMax[0] - voxelMin[0] + 1) * (voxelMax[1] - voxelMin[1] + 1) * m_TypeSize;
+  char* dest = reinterpret_cast<char*>(buffer);
+  for (int z = voxelMin[2]; z <= voxelMax[2]; ++z)
+  {
+    int err = readSectionRegion(z, voxelMin, voxelMax, dest);
+    if (err < 0)
+    {
+      return err;
+    }
+    dest += sectionBytes;
+  }
+  return 1;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MRCFile::prefetchSections(int zStart, int zEnd) const
+{
+  if (false == isOpen())
+  {
+    return;
+  }
+  if (zStart < 0) { zStart = 0; }
+  if (zEnd >= m_Header->nz) { zEnd = m_Header->nz - 1; }
+  if (zStart > zEnd)
+  {
+    return;
+  }
+#if defined (POSIX_FADV_WILLNEED)
+  uint64_t length = static_cast<uint64_t>(zEnd - zStart + 1) * getSectionSize();
+  ::posix_fadvise(m_FileDescriptor, static_cast<off_t>(sectionOffset(zStart)), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+#endif
+}
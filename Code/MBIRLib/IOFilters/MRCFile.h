@@ -0,0 +1,147 @@
+/* ============================================================================
+ * Copyright (c) 2011, Michael A. Jackson (BlueQuartz Software)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Michael A. Jackson nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _MRCFILE_H_
+#define _MRCFILE_H_
+
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/IOFilters/MRCHeader.h"
+
+/**
+ * @class MRCFile MRCFile.h MBIRLib/IOFilters/MRCFile.h
+ * @brief Keeps an MRC file open for repeated random access to its sections.
+ * The header and extended header are read once when the file is opened. Data
+ * is read with positioned reads straight into buffers supplied by the caller,
+ * so several threads may read from the same MRCFile at once. When
+ * ReadAheadSections is greater than zero each section read asks the operating
+ * system to start loading the following sections in the background.
+ * @author Michael A. Jackson for BlueQuartz Software
+ * @version 1.0
+ */
+class MBIRLib_EXPORT MRCFile
+{
+  public:
+    MXA_SHARED_POINTERS(MRCFile)
+    MXA_TYPE_MACRO(MRCFile)
+    MXA_STATIC_NEW_MACRO(MRCFile)
+
+    virtual ~MRCFile();
+
+    /* Number of sections after the one just read to prefetch. 0 disables read ahead */
+    MXA_INSTANCE_PROPERTY(int, ReadAheadSections)
+
+    /**
+     * @brief Opens the file and reads the header and extended header. Any
+     * previously opened file is closed first.
+     * @return Negative on Error.
+     */
+    int open(const std::string& filepath);
+
+    void close();
+
+    bool isOpen() const;
+
+    const std::string& getFilePath() const { return m_FilePath; }
+
+    /**
+     * @brief Returns the cached header. This pointer is owned by this class and
+     * is valid until the file is closed.
+     */
+    MRCHeader* getHeader() { return m_Header; }
+
+    const std::vector<uint8_t>& getExtendedHeader() const { return m_ExtendedHeader; }
+
+    /**
+     * @brief Size in bytes of a single voxel, 0 if the mode is not supported
+     */
+    size_t getTypeSize() const { return m_TypeSize; }
+
+    /**
+     * @brief Size in bytes of a full nx * ny section
+     */
+    size_t getSectionSize() const;
+
+    /**
+     * @brief Reads the full section z into buffer which must hold getSectionSize() bytes
+     * @return Negative on Error.
+     */
+    int readSection(int z, void* buffer);
+
+    /**
+     * @brief Reads the box [xyMin, xyMax] (INCLUSIVE, [x, y]) of section z into
+     * buffer, row after row with no padding.
+     * @return Negative on Error.
+     */
+    int readSectionRegion(int z, const int* xyMin, const int* xyMax, void* buffer);
+
+    /**
+     * @brief Reads the box [voxelMin, voxelMax] (INCLUSIVE, [x, y, z]) into buffer
+     * with the same layout MRCReader::read produces.
+     * @return Negative on Error.
+     */
+    int readSubVolume(const int* voxelMin, const int* voxelMax, void* buffer);
+
+    /**
+     * @brief Asks the operating system to start reading sections [zStart, zEnd]
+     * into its cache. Returns immediately.
+     */
+    void prefetchSections(int zStart, int zEnd) const;
+
+  protected:
+    MRCFile();
+
+  private:
+    std::string m_FilePath;
+    MRCHeader* m_Header;
+    std::vector<uint8_t> m_ExtendedHeader;
+    size_t m_TypeSize;
+#if defined (_MSC_VER)
+    void* m_FileHandle;
+#else
+    int m_FileDescriptor;
+#endif
+
+    /**
+     * @brief Reads numBytes at the absolute file offset without moving any shared file pointer
+     */
+    bool readAt(uint64_t offset, void* buffer, size_t numBytes) const;
+
+    uint64_t sectionOffset(int z) const;
+
+    MRCFile(const MRCFile&); // Copy Constructor Not Implemented
+    void operator=(const MRCFile&); // Operator '=' Not Implemented
+};
+
+#endif /* _MRCFILE_H_ */
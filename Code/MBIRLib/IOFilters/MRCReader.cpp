@@ -81,6 +81,15 @@ MRCReader::~MRCReader()
     if (NULL != m_UInt16Data) { free(m_UInt16Data); }
     if (NULL != m_FloatData) { free(m_FloatData); }
   }
+  closeMapped();
+  deleteHeader();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MRCReader::deleteHeader()
+{
   if (NULL != m_Header)
   {
     if (NULL != m_Header->feiHeaders)
@@ -88,8 +97,70 @@ MRCReader::~MRCReader()
       free(m_Header->feiHeaders);
     }
     delete m_Header;
+    m_Header = NULL;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MRCReader::parseFEIHeaders(MRCHeader* header, const std::vector<uint8_t>& extendedHeader)
+{
+  if (NULL != header->feiHeaders)
+  {
+    free(header->feiHeaders);
+    header->feiHeaders = NULL;
+  }
+  if (false == hasFEIHeaders(header) || extendedHeader.size() < sizeof(FEIHeader) * header->nz)
+  {
+    return;
   }
+  // Allocate and copy in the data
+  header->feiHeaders = reinterpret_cast<FEIHeader*>(malloc(sizeof(FEIHeader) * header->nz));
+  ::memcpy(header->feiHeaders, &(extendedHeader.front()), sizeof(FEIHeader) * header->nz);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool MRCReader::hasFEIHeaders(const MRCHeader* header)
+{
+  std::string feiLabel(header->labels[0], 80);
+  if (feiLabel.find("tif2mrc: Converted to MRC format") != std::string::npos)
+  {
+    return false;
+  }
+  return feiLabel.find("Fei Company") != std::string::npos
+         || feiLabel.find("EIC project") != std::string::npos
+         || feiLabel.find("MCAP project, MDG, Copyright 2013") != std::string::npos;
+}
 
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MRCReader::subsetFEIHeaders(const MRCHeader* header, const std::vector<uint8_t>& extendedHeader,
+                                const std::vector<int>& sections, float pixelScale,
+                                std::vector<uint8_t>& output)
+{
+  if (false == hasFEIHeaders(header) || header->nz < 0 || header->next < 0
+      || extendedHeader.size() != static_cast<size_t>(header->next)
+      || extendedHeader.size() < sizeof(FEIHeader) * header->nz)
+  {
+    return -1;
+  }
+  output.assign(extendedHeader.size(), 0);
+  for (size_t i = 0; i < sections.size(); ++i)
+  {
+    if (sections[i] < 0 || sections[i] >= header->nz)
+    {
+      return -2;
+    }
+    FEIHeader fei;
+    ::memcpy(&fei, &(extendedHeader[sizeof(FEIHeader) * sections[i]]), sizeof(FEIHeader));
+    fei.pixelsize *= pixelScale;
+    ::memcpy(&(output[sizeof(FEIHeader) * i]), &fei, sizeof(FEIHeader));
+  }
+  return 0;
 }
 
 
@@ -121,55 +192,7 @@ int MRCReader::readHeader(const std::string& filepath, MRCHeader* header)
   }
 
   // If we have an FEI header then parse the extended header information
-  std::string feiLabel(header->labels[0], 80);
-  std::string::size_type pos = feiLabel.find("Fei Company");
-  if (pos != std::string::npos)
-  {
-    if (NULL != header->feiHeaders)
-    {
-      free(header->feiHeaders);
-      header->feiHeaders = NULL;
-    }
-    // Allocate and copy in the data
-    header->feiHeaders = reinterpret_cast<FEIHeader*>(malloc(sizeof(FEIHeader) * header->nz));
-    ::memcpy(header->feiHeaders, &(m_ExtendedHeader.front()), sizeof(FEIHeader) * header->nz);
-  }
-  pos = feiLabel.find("EIC project");
-  if (pos != std::string::npos)
-  {
-    if (NULL != header->feiHeaders)
-    {
-      free(header->feiHeaders);
-      header->feiHeaders = NULL;
-    }
-    // Allocate and copy in the data
-    header->feiHeaders = reinterpret_cast<FEIHeader*>(malloc(sizeof(FEIHeader) * header->nz));
-    ::memcpy(header->feiHeaders, &(m_ExtendedHeader.front()), sizeof(FEIHeader) * header->nz);
-  }
-  pos = feiLabel.find("MCAP project, MDG, Copyright 2013");
-  if (pos != std::string::npos)
-  {
-    if (NULL != header->feiHeaders)
-    {
-      free(header->feiHeaders);
-      header->feiHeaders = NULL;
-    }
-    // Allocate and copy in the data
-    header->feiHeaders = reinterpret_cast<FEIHeader*>(malloc(sizeof(FEIHeader) * header->nz));
-    ::memcpy(header->feiHeaders, &(m_ExtendedHeader.front()), sizeof(FEIHeader) * header->nz);
-  }
-  pos = feiLabel.find("tif2mrc: Converted to MRC format");
-  if (pos != std::string::npos)
-  {
-    if (NULL != header->feiHeaders)
-    {
-      free(header->feiHeaders);
-      header->feiHeaders = NULL;
-    }
-//     // Allocate and copy in the data
-//     header->feiHeaders = reinterpret_cast<FEIHeader*>(malloc(sizeof(FEIHeader) * header->nz));
-//     ::memcpy(header->feiHeaders, &(m_ExtendedHeader.front()), sizeof(FEIHeader) * header->nz);
-  }
+  parseFEIHeaders(header, m_ExtendedHeader);
   return 1;
 }
 
@@ -211,6 +234,7 @@ int MRCReader::read(const std::string& filepath, int* voxelMin, int* voxelMax)
   {
     return -1;
   }
+  deleteHeader();
   m_Header = new MRCHeader;
   ::memset(m_Header, 0, 1024); // Splat zeros across the entire structure
   m_Header->feiHeaders = NULL;
@@ -232,44 +256,7 @@ int MRCReader::read(const std::string& filepath, int* voxelMin, int* voxelMax)
 
   // If we have an FEI header then parse the extended header information
   m_Header->feiHeaders = NULL;
-// If we have an FEI header then parse the extended header information
-  std::string feiLabel(m_Header->labels[0], 80);
-  std::string::size_type pos = feiLabel.find("Fei Company");
-  if (pos != std::string::npos)
-  {
-    if (NULL != m_Header->feiHeaders)
-    {
-      free(m_Header->feiHeaders);
-      m_Header->feiHeaders = NULL;
-    }
-    // Allocate and copy in the data
-    m_Header->feiHeaders = reinterpret_cast<FEIHeader*>(malloc(sizeof(FEIHeader) * m_Header->nz));
-    ::memcpy(m_Header->feiHeaders, &(m_ExtendedHeader.front()), sizeof(FEIHeader) * m_Header->nz);
-  }
-  pos = feiLabel.find("EIC project");
-  if (pos != std::string::npos)
-  {
-    if (NULL != m_Header->feiHeaders)
-    {
-      free(m_Header->feiHeaders);
-      m_Header->feiHeaders = NULL;
-    }
-    // Allocate and copy in the data
-    m_Header->feiHeaders = reinterpret_cast<FEIHeader*>(malloc(sizeof(FEIHeader) * m_Header->nz));
-    ::memcpy(m_Header->feiHeaders, &(m_ExtendedHeader.front()), sizeof(FEIHeader) * m_Header->nz);
-  }
-  pos = feiLabel.find("MCAP project, MDG, Copyright 2013");
-  if (pos != std::string::npos)
-  {
-    if (NULL != m_Header->feiHeaders)
-    {
-      free(m_Header->feiHeaders);
-      m_Header->feiHeaders = NULL;
-    }
-    // Allocate and copy in the data
-    m_Header->feiHeaders = reinterpret_cast<FEIHeader*>(malloc(sizeof(FEIHeader) * m_Header->nz));
-    ::memcpy(m_Header->feiHeaders, &(m_ExtendedHeader.front()), sizeof(FEIHeader) * m_Header->nz);
-  }
+  parseFEIHeaders(m_Header, m_ExtendedHeader);
 
   size_t nVoxels = m_Header->nx * m_Header->ny * m_Header->nz;
   if ( NULL != voxelMin && NULL != voxelMax)
@@ -400,6 +387,101 @@ void* MRCReader::getDataPointer()
   return NULL;
 }
 
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MRCReader::openMapped(const std::string& filepath)
+{
+  closeMapped();
+  deleteHeader();
+  m_MappedFile = MemoryMappedFile::New();
+  int err = m_MappedFile->open(filepath);
+  if (err < 0)
+  {
+    m_MappedFile = MemoryMappedFile::NullPointer();
+    return -1;
+  }
+  if (m_MappedFile->getSize() < 1024)
+  {
+    closeMapped();
+    return -2;
+  }
+  m_Header = new MRCHeader;
+  ::memcpy(m_Header, m_MappedFile->getData(), 1024);
+  m_Header->feiHeaders = NULL;
+
+  // Now copy out the extended header
+  if (m_Header->next < 0 || m_MappedFile->getSize() < getDataOffset())
+  {
+    closeMapped();
+    return -3;
+  }
+  m_ExtendedHeader.assign(m_MappedFile->getData() + 1024, m_MappedFile->getData() + getDataOffset());
+
+  // If we have an FEI header then parse the extended header information
+  parseFEIHeaders(m_Header, m_ExtendedHeader);
+
+  size_t typeSize = getTypeSize(m_Header->mode);
+  if (typeSize == 0)
+  {
+    closeMapped();
+    return -5;
+  }
+  uint64_t nBytes = static_cast<uint64_t>(m_Header->nx) * m_Header->ny * m_Header->nz * typeSize;
+  if (m_MappedFile->getSize() < getDataOffset() + nBytes)
+  {
+    closeMapped();
+    return -4;
+  }
+  return 1;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MRCReader::closeMapped()
+{
+  if (NULL != m_MappedFile.get())
+  {
+    m_MappedFile->close();
+    m_MappedFile = MemoryMappedFile::NullPointer();
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MRCReader::prefetchSections(int zStart, int zEnd)
+{
+  if (false == isMapped() || zStart > zEnd)
+  {
+    return;
+  }
+  uint64_t sectionBytes = static_cast<uint64_t>(m_Header->nx) * m_Header->ny * getTypeSize(m_Header->mode);
+  m_MappedFile->willNeed(getDataOffset() + sectionBytes * zStart, sectionBytes * (zEnd - zStart + 1));
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+size_t MRCReader::getTypeSize(int mode)
+{
+  switch(mode)
+  {
+    case 0:
+      return 1;
+    case 1:
+      return 2;
+    case 2:
+      return 4;
+    case 6:
+      return 2;
+    default:
+      break;
+  }
+  return 0;
+}
+
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
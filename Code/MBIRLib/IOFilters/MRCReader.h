@@ -39,7 +39,9 @@
 
 
 #include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/MemoryMappedFile.h"
 #include "MBIRLib/IOFilters/MRCHeader.h"
+#include "MBIRLib/IOFilters/MRCView.h"
 
 
 /**
@@ -112,6 +114,93 @@ class MBIRLib_EXPORT MRCReader
      */
     void* getDataPointer();
 
+    /**
+     * @brief Maps the file into memory and parses the header and extended
+     * header once. Afterwards getHeader() is valid and views of the voxel data
+     * can be taken with getView() without reading or copying anything.
+     * @param filepath The path to the input file.
+     * @return Negative on Error.
+     */
+    int openMapped(const std::string& filepath);
+
+    /**
+     * @brief Unmaps the file. Any views taken from it become invalid.
+     */
+    void closeMapped();
+
+    bool isMapped() { return NULL != m_MappedFile.get() && m_MappedFile->isOpen(); }
+
+    /**
+     * @brief Returns a read only view of a box of the mapped voxel data. The
+     * ranges follow the same INCLUSIVE [x, y, z] convention as read(). NULL for
+     * both pointers selects the entire volume. The returned view is invalid if
+     * the file is not mapped, T does not match the mode of the file or the box
+     * lies outside the volume.
+     */
+    template<typename T>
+    MRCView<T> getView(int* voxelMin = NULL, int* voxelMax = NULL)
+    {
+      if (false == isMapped() || getTypeSize(m_Header->mode) != sizeof(T))
+      {
+        return MRCView<T>();
+      }
+      size_t volumeDims[3] = { static_cast<size_t>(m_Header->nx), static_cast<size_t>(m_Header->ny), static_cast<size_t>(m_Header->nz) };
+      size_t strides[3] = { 1, volumeDims[0], volumeDims[0] * volumeDims[1] };
+      const T* data = reinterpret_cast<const T*>(m_MappedFile->getData() + getDataOffset());
+      MRCView<T> volume(data, volumeDims, strides);
+      if (NULL == voxelMin || NULL == voxelMax)
+      {
+        return volume;
+      }
+      size_t vMin[3];
+      size_t vMax[3];
+      for (int i = 0; i < 3; i++)
+      {
+        if (voxelMin[i] < 0 || voxelMax[i] < 0) { return MRCView<T>(); }
+        vMin[i] = voxelMin[i];
+        vMax[i] = voxelMax[i];
+      }
+      return volume.getSubView(vMin, vMax);
+    }
+
+    /**
+     * @brief Hints to the operating system that the given sections of the
+     * mapped file will be read soon.
+     */
+    void prefetchSections(int zStart, int zEnd);
+
+    /**
+     * @brief Returns the size in bytes of one voxel of the given MRC mode or 0
+     * if the mode is not supported.
+     */
+    static size_t getTypeSize(int mode);
+
+    /**
+     * @brief Copies the FEI style per section headers out of the extended
+     * header into header->feiHeaders if the label says there are any.
+     */
+    static void parseFEIHeaders(MRCHeader* header, const std::vector<uint8_t>& extendedHeader);
+
+    /**
+     * @brief Returns true if the label of the header says that the extended
+     * header holds FEI style per section headers.
+     */
+    static bool hasFEIHeaders(const MRCHeader* header);
+
+    /**
+     * @brief Builds the extended header of a file that keeps only some of the
+     * sections. The records of the kept sections are moved to the front in the
+     * order given, their pixel size is multiplied by pixelScale and the rest of
+     * the extended header is zeroed so that it keeps its size (FEI files are
+     * often padded to a fixed number of records).
+     * @param sections The indices of the kept sections
+     * @return Negative if the extended header does not hold one FEI record per
+     * section of the header.
+     */
+    static int subsetFEIHeaders(const MRCHeader* header, const std::vector<uint8_t>& extendedHeader,
+                                const std::vector<int>& sections, float pixelScale,
+                                std::vector<uint8_t>& output);
+
     /**
      * @brief Returns the header structure. Note that this pointer is owned by
      * this class and will be deleted when this class is destroyed.
@@ -136,6 +225,7 @@ class MBIRLib_EXPORT MRCReader
 
   private:
     MRCHeader* m_Header;
+    MemoryMappedFile::Pointer m_MappedFile;
 
     uint8_t*   m_UInt8Data;
     int16_t*   m_Int16Data;
@@ -143,6 +233,13 @@ class MBIRLib_EXPORT MRCReader
     float*     m_FloatData;
     std::vector<uint8_t> m_ExtendedHeader;
 
+    void deleteHeader();
+
+    /**
+     * @brief Byte offset of the first voxel in the file
+     */
+    size_t getDataOffset() { return 1024 + static_cast<size_t>(m_Header->next); }
+
 
     MRCReader(const MRCReader&); // Copy Constructor Not Implemented
     void operator=(const MRCReader&); // Operator '=' Not Implemented
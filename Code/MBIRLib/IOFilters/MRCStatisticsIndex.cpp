@@ -0,0 +1,482 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "MRCStatisticsIndex.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <limits>
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_group.h>
+#endif
+
+#include "MXA/Utilities/MXADir.h"
+
+#include "MBIRLib/Common/EIMMath.h"
+
+#define MBIR_STATS_MAGIC "MBIRSTAT"
+#define MBIR_STATS_VERSION 1
+
+namespace Detail
+{
+  /**
+   * @brief Two passes over a section that is already in memory: the first
+   * finds the range and the mean, the second the absolute deviation and the
+   * histogram.
+   */
+  template<typename T>
+  void sectionStatistics(const T* data, size_t count, bool logTransform, double offset,
+                         MRCSectionStatistics& stats)
+  {
+    double sum = 0.0;
+    double vmin = std::numeric_limits<double>::max();
+    double vmax = -std::numeric_limits<double>::max();
+    size_t numValid = 0;
+    double v = 0.0;
+    for (size_t i = 0; i < count; i++)
+    {
+      v = data[i];
+      if(logTransform)
+      {
+        v += offset;
+        if(v <= 0) { continue; }
+        v = log(v);
+      }
+      sum += v;
+      if(v < vmin) { vmin = v; }
+      if(v > vmax) { vmax = v; }
+      numValid++;
+    }
+    if(numValid == 0)
+    {
+      vmin = 0.0;
+      vmax = 0.0;
+    }
+    double mean = (count > 0) ? sum / count : 0.0;
+
+    stats.Histogram.assign(MRCStatisticsIndex::NumBins, 0);
+    double scale = (vmax > vmin) ? MRCStatisticsIndex::NumBins / (vmax - vmin) : 0.0;
+    double dev = 0.0;
+    for (size_t i = 0; i < count; i++)
+    {
+      v = data[i];
+      if(logTransform)
+      {
+        v += offset;
+        if(v <= 0) { continue; }
+        v = log(v);
+      }
+      dev += fabs(v - mean);
+      size_t bin = static_cast<size_t>((v - vmin) * scale);
+      if(bin >= MRCStatisticsIndex::NumBins) { bin = MRCStatisticsIndex::NumBins - 1; }
+      stats.Histogram[bin]++;
+    }
+    stats.Min = static_cast<float>(vmin);
+    stats.Max = static_cast<float>(vmax);
+    stats.Mean = mean;
+    stats.AbsDeviation = (count > 0) ? dev / count : 0.0;
+  }
+
+  /**
+   * @brief Reads one section region and computes its statistics
+   */
+  class ComputeSectionStatisticsTask
+  {
+    public:
+      ComputeSectionStatisticsTask(MRCFile* mrcFile, int z, const int* xyMin, const int* xyMax,
+                                   bool logTransform, double offset,
+                                   MRCSectionStatistics* stats, int* error) :
+        m_MRCFile(mrcFile), m_Z(z), m_XYMin(xyMin), m_XYMax(xyMax),
+        m_LogTransform(logTransform), m_Offset(offset), m_Stats(stats), m_Error(error)
+      {}
+
+      void operator()() const
+      {
+        MRCHeader* header = m_MRCFile->getHeader();
+        size_t count = static_cast<size_t>(m_XYMax[0] - m_XYMin[0] + 1) * (m_XYMax[1] - m_XYMin[1] + 1);
+        std::vector<uint8_t> buffer(count * m_MRCFile->getTypeSize());
+        if(m_MRCFile->readSectionRegion(m_Z, m_XYMin, m_XYMax, &(buffer.front())) < 0)
+        {
+          *m_Error = -1;
+          return;
+        }
+        *m_Error = MRCStatisticsIndex::ComputeSectionStatistics(&(buffer.front()), count, header->mode,
+                   header->imodFlags == 1, m_LogTransform, m_Offset, *m_Stats);
+      }
+
+    private:
+      MRCFile* m_MRCFile;
+      int m_Z;
+      const int* m_XYMin;
+      const int* m_XYMax;
+      bool m_LogTransform;
+      double m_Offset;
+      MRCSectionStatistics* m_Stats;
+      int* m_Error;
+  };
+
+  /**
+   * @brief The size and modification time that a sidecar is keyed by
+   */
+  bool statisticsFileKey(const std::string& path, uint64_t& size, int64_t& mtime)
+  {
+#if defined (_MSC_VER)
+    struct _stat64 st;
+    if(::_stat64(path.c_str(), &st) != 0) { return false; }
+#else
+    struct stat st;
+    if(::stat(path.c_str(), &st) != 0) { return false; }
+#endif
+    size = static_cast<uint64_t>(st.st_size);
+    mtime = static_cast<int64_t>(st.st_mtime);
+    return true;
+  }
+
+  template<typename T>
+  bool readStatisticsValue(FILE* f, T& value)
+  {
+    return fread(&value, sizeof(T), 1, f) == 1;
+  }
+
+  template<typename T>
+  bool writeStatisticsValue(FILE* f, const T& value)
+  {
+    return fwrite(&value, sizeof(T), 1, f) == 1;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MRCStatisticsIndex::MRCStatisticsIndex()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MRCStatisticsIndex::~MRCStatisticsIndex()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+std::string MRCStatisticsIndex::SidecarPath(const std::string& mrcFile)
+{
+  return mrcFile + std::string(".stats");
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MRCStatisticsIndex::ComputeSectionStatistics(const void* data, size_t count, int mode, bool signedBytes,
+                                                 bool logTransform, double offset, MRCSectionStatistics& stats)
+{
+  switch(mode)
+  {
+    case 0:
+      if(signedBytes) { Detail::sectionStatistics<int8_t>(static_cast<const int8_t*>(data), count, logTransform, offset, stats); }
+      else { Detail::sectionStatistics<uint8_t>(static_cast<const uint8_t*>(data), count, logTransform, offset, stats); }
+      break;
+    case 1:
+      Detail::sectionStatistics<int16_t>(static_cast<const int16_t*>(data), count, logTransform, offset, stats);
+      break;
+    case 2:
+      Detail::sectionStatistics<float>(static_cast<const float*>(data), count, logTransform, offset, stats);
+      break;
+    case 6:
+      Detail::sectionStatistics<uint16_t>(static_cast<const uint16_t*>(data), count, logTransform, offset, stats);
+      break;
+    default:
+      return -1;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MRCStatisticsIndex::load(const std::string& mrcFile)
+{
+  m_Entries.clear();
+
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  if(Detail::statisticsFileKey(mrcFile, size, mtime) == false)
+  {
+    return -1;
+  }
+  FILE* f = fopen(SidecarPath(mrcFile).c_str(), "rb");
+  if(NULL == f)
+  {
+    return -1;
+  }
+
+  char magic[8];
+  uint32_t version = 0;
+  uint64_t fileSize = 0;
+  int64_t fileTime = 0;
+  uint32_t numEntries = 0;
+  bool ok = fread(magic, 1, 8, f) == 8 && ::memcmp(magic, MBIR_STATS_MAGIC, 8) == 0
+            && Detail::readStatisticsValue(f, version) && version == MBIR_STATS_VERSION
+            && Detail::readStatisticsValue(f, fileSize) && fileSize == size
+            && Detail::readStatisticsValue(f, fileTime) && fileTime == mtime
+            && Detail::readStatisticsValue(f, numEntries);
+
+  std::vector<Entry> entries(ok ? numEntries : 0);
+  for (uint32_t e = 0; ok && e < numEntries; ++e)
+  {
+    Entry& entry = entries[e];
+    uint32_t numSections = 0;
+    uint32_t numBins = 0;
+    ok = fread(entry.XYMin, sizeof(int), 2, f) == 2 && fread(entry.XYMax, sizeof(int), 2, f) == 2
+         && Detail::readStatisticsValue(f, entry.LogTransform)
+         && Detail::readStatisticsValue(f, entry.Offset)
+         && Detail::readStatisticsValue(f, numSections)
+         && Detail::readStatisticsValue(f, numBins) && numBins == NumBins;
+    if(ok)
+    {
+      entry.Sections.resize(numSections);
+    }
+    for (uint32_t z = 0; ok && z < numSections; ++z)
+    {
+      MRCSectionStatistics& s = entry.Sections[z];
+      s.Histogram.resize(NumBins);
+      ok = Detail::readStatisticsValue(f, s.Min) && Detail::readStatisticsValue(f, s.Max)
+           && Detail::readStatisticsValue(f, s.Mean) && Detail::readStatisticsValue(f, s.AbsDeviation)
+           && fread(&(s.Histogram.front()), sizeof(uint32_t), NumBins, f) == NumBins;
+    }
+  }
+  fclose(f);
+  if(false == ok)
+  {
+    return -1;
+  }
+  m_Entries.swap(entries);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MRCStatisticsIndex::save(const std::string& mrcFile)
+{
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  if(Detail::statisticsFileKey(mrcFile, size, mtime) == false)
+  {
+    return -1;
+  }
+  // Write to a temporary file first so a reader never sees a partial sidecar
+  std::string sidecar = SidecarPath(mrcFile);
+  std::string tempFile = sidecar + std::string(".tmp");
+  FILE* f = fopen(tempFile.c_str(), "wb");
+  if(NULL == f)
+  {
+    return -1;
+  }
+  uint32_t version = MBIR_STATS_VERSION;
+  uint32_t numEntries = static_cast<uint32_t>(m_Entries.size());
+  uint32_t numBins = NumBins;
+  bool ok = fwrite(MBIR_STATS_MAGIC, 1, 8, f) == 8
+            && Detail::writeStatisticsValue(f, version)
+            && Detail::writeStatisticsValue(f, size)
+            && Detail::writeStatisticsValue(f, mtime)
+            && Detail::writeStatisticsValue(f, numEntries);
+  for (size_t e = 0; ok && e < m_Entries.size(); ++e)
+  {
+    const Entry& entry = m_Entries[e];
+    uint32_t numSections = static_cast<uint32_t>(entry.Sections.size());
+    ok = fwrite(entry.XYMin, sizeof(int), 2, f) == 2 && fwrite(entry.XYMax, sizeof(int), 2, f) == 2
+         && Detail::writeStatisticsValue(f, entry.LogTransform)
+         && Detail::writeStatisticsValue(f, entry.Offset)
+         && Detail::writeStatisticsValue(f, numSections)
+         && Detail::writeStatisticsValue(f, numBins);
+    for (uint32_t z = 0; ok && z < numSections; ++z)
+    {
+      const MRCSectionStatistics& s = entry.Sections[z];
+      ok = Detail::writeStatisticsValue(f, s.Min) && Detail::writeStatisticsValue(f, s.Max)
+           && Detail::writeStatisticsValue(f, s.Mean) && Detail::writeStatisticsValue(f, s.AbsDeviation)
+           && s.Histogram.size() == NumBins
+           && fwrite(&(s.Histogram.front()), sizeof(uint32_t), NumBins, f) == NumBins;
+    }
+  }
+  if(fclose(f) != 0)
+  {
+    ok = false;
+  }
+  if(ok)
+  {
+    MXADir::remove(sidecar);
+    ok = ::rename(tempFile.c_str(), sidecar.c_str()) == 0;
+  }
+  if(false == ok)
+  {
+    MXADir::remove(tempFile);
+    return -1;
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+const std::vector<MRCSectionStatistics>* MRCStatisticsIndex::find(const int* xyMin, const int* xyMax,
+                                                                  bool logTransform, double offset) const
+{
+  int logFlag = logTransform ? 1 : 0;
+  for (size_t e = 0; e < m_Entries.size(); ++e)
+  {
+    const Entry& entry = m_Entries[e];
+    if(entry.XYMin[0] == xyMin[0] && entry.XYMin[1] == xyMin[1]
+        && entry.XYMax[0] == xyMax[0] && entry.XYMax[1] == xyMax[1]
+        && entry.LogTransform == logFlag && (logFlag == 0 || entry.Offset == offset))
+    {
+      return &(entry.Sections);
+    }
+  }
+  return NULL;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void MRCStatisticsIndex::insert(const int* xyMin, const int* xyMax, bool logTransform, double offset,
+                                const std::vector<MRCSectionStatistics>& stats)
+{
+  const std::vector<MRCSectionStatistics>* existing = find(xyMin, xyMax, logTransform, offset);
+  if(NULL != existing)
+  {
+    *(const_cast<std::vector<MRCSectionStatistics>*>(existing)) = stats;
+    return;
+  }
+  Entry entry;
+  entry.XYMin[0] = xyMin[0];
+  entry.XYMin[1] = xyMin[1];
+  entry.XYMax[0] = xyMax[0];
+  entry.XYMax[1] = xyMax[1];
+  entry.LogTransform = logTransform ? 1 : 0;
+  entry.Offset = logTransform ? offset : 0.0;
+  entry.Sections = stats;
+  m_Entries.push_back(entry);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MRCStatisticsIndex::compute(MRCFile::Pointer mrcFile, const int* xyMin, const int* xyMax,
+                                bool logTransform, double offset, std::vector<MRCSectionStatistics>& stats)
+{
+  int nz = mrcFile->getHeader()->nz;
+  stats.resize(nz);
+  std::vector<int> errors(nz, 0);
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  tbb::task_group* g = new tbb::task_group;
+  for (int z = 0; z < nz; z++)
+  {
+    g->run(Detail::ComputeSectionStatisticsTask(mrcFile.get(), z, xyMin, xyMax, logTransform, offset,
+                                                &(stats[z]), &(errors[z])));
+  }
+  g->wait(); // Wait for all the threads to complete before moving on.
+  delete g;
+#else
+  for (int z = 0; z < nz; z++)
+  {
+    Detail::ComputeSectionStatisticsTask task(mrcFile.get(), z, xyMin, xyMax, logTransform, offset,
+                                              &(stats[z]), &(errors[z]));
+    task();
+  }
+#endif
+  for (int z = 0; z < nz; z++)
+  {
+    if(errors[z] < 0)
+    {
+      return errors[z];
+    }
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int MRCStatisticsIndex::getStatistics(MRCFile::Pointer mrcFile, const int* xyMin, const int* xyMax,
+                                      std::vector<MRCSectionStatistics>& stats,
+                                      bool logTransform, double offset)
+{
+  if(NULL == mrcFile.get() || false == mrcFile->isOpen())
+  {
+    return -1;
+  }
+  MRCHeader* header = mrcFile->getHeader();
+  int regionMin[2] = { 0, 0 };
+  int regionMax[2] = { header->nx - 1, header->ny - 1 };
+  if(NULL != xyMin && NULL != xyMax)
+  {
+    regionMin[0] = xyMin[0];
+    regionMin[1] = xyMin[1];
+    regionMax[0] = xyMax[0];
+    regionMax[1] = xyMax[1];
+  }
+  if(regionMin[0] < 0 || regionMin[1] < 0 || regionMax[0] >= header->nx || regionMax[1] >= header->ny
+      || regionMin[0] > regionMax[0] || regionMin[1] > regionMax[1])
+  {
+    return -2;
+  }
+
+  // The sidecar is small so it is always read again in case the file changed
+  load(mrcFile->getFilePath());
+  const std::vector<MRCSectionStatistics>* cached = find(regionMin, regionMax, logTransform, offset);
+  if(NULL != cached && cached->size() == static_cast<size_t>(header->nz))
+  {
+    stats = *cached;
+    return 0;
+  }
+
+  int err = compute(mrcFile, regionMin, regionMax, logTransform, offset, stats);
+  if(err < 0)
+  {
+    return err;
+  }
+  insert(regionMin, regionMax, logTransform, offset, stats);
+  save(mrcFile->getFilePath());
+  return 0;
+}
@@ -0,0 +1,171 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _MRCSTATISTICSINDEX_H_
+#define _MRCSTATISTICSINDEX_H_
+
+#include <string>
+#include <vector>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/IOFilters/MRCFile.h"
+
+/**
+ * @brief Statistics of one section (tilt) of an MRC file over a region. When
+ * the statistics are of the log of the values only the values where
+ * value + offset is positive contribute to the sums, but the mean and the
+ * absolute deviation are still divided by the number of values in the region.
+ */
+typedef struct
+{
+  float Min;
+  float Max;
+  double Mean;
+  double AbsDeviation; // mean(|value - Mean|)
+  std::vector<uint32_t> Histogram; // MRCStatisticsIndex::NumBins bins spanning [Min, Max]
+} MRCSectionStatistics;
+
+/**
+ * @class MRCStatisticsIndex MRCStatisticsIndex.h MBIRLib/IOFilters/MRCStatisticsIndex.h
+ * @brief Caches per section statistics of an MRC file in a small sidecar file
+ * next to it (<file>.stats) so that the sigma x estimation, the background
+ * calculation and the image display do not have to scan the data again each
+ * time a dataset is opened. The sidecar is keyed by the size and modification
+ * time of the MRC file and is discarded when either changes. It may hold
+ * several entries, one per region and transform that has been asked for.
+ * Missing entries are computed in one streaming pass over the file with one
+ * task per section. Failing to write the sidecar (e.g. a read only directory)
+ * is not an error, the statistics are just not cached.
+ * @author Michael A. Jackson for BlueQuartz Software
+ * @version 1.0
+ */
+class MBIRLib_EXPORT MRCStatisticsIndex
+{
+  public:
+    MXA_SHARED_POINTERS(MRCStatisticsIndex)
+    MXA_TYPE_MACRO(MRCStatisticsIndex)
+    MXA_STATIC_NEW_MACRO(MRCStatisticsIndex)
+
+    virtual ~MRCStatisticsIndex();
+
+    enum
+    {
+      NumBins = 256
+    };
+
+    /**
+     * @brief Returns the path of the sidecar file for an MRC file
+     */
+    static std::string SidecarPath(const std::string& mrcFile);
+
+    /**
+     * @brief Computes the statistics of one section held in memory.
+     * @param data count values of the given MRC mode
+     * @param mode The MRC mode of the data (0, 1, 2 or 6)
+     * @param signedBytes Mode 0 data is signed (imodFlags == 1)
+     * @param logTransform Compute the statistics of log(value + offset)
+     * @return Negative if the mode is not supported
+     */
+    static int ComputeSectionStatistics(const void* data, size_t count, int mode, bool signedBytes,
+                                        bool logTransform, double offset, MRCSectionStatistics& stats);
+
+    /**
+     * @brief Reads the sidecar of the MRC file if it exists and is still
+     * valid. Any entries already held are discarded.
+     * @return Negative if there is no valid sidecar
+     */
+    int load(const std::string& mrcFile);
+
+    /**
+     * @brief Writes the entries to the sidecar of the MRC file
+     * @return Negative on Error.
+     */
+    int save(const std::string& mrcFile);
+
+    /**
+     * @brief Returns the statistics of every section over the region
+     * [xyMin, xyMax] (INCLUSIVE, [x, y]). Passing NULL for both means the whole
+     * section. The sidecar is read the first time, the statistics are computed
+     * if the sidecar does not hold them and the sidecar is then updated.
+     * @return Negative on Error.
+     */
+    int getStatistics(MRCFile::Pointer mrcFile, const int* xyMin, const int* xyMax,
+                      std::vector<MRCSectionStatistics>& stats,
+                      bool logTransform = false, double offset = 0.0);
+
+    /**
+     * @brief Looks up statistics that have already been computed or loaded
+     * without touching the data. The region must be given explicitly.
+     * @return NULL if there is no such entry
+     */
+    const std::vector<MRCSectionStatistics>* find(const int* xyMin, const int* xyMax,
+                                                  bool logTransform = false, double offset = 0.0) const;
+
+    /**
+     * @brief Adds (or replaces) an entry, e.g. from a tool that has just
+     * written the file and computed its statistics on the way.
+     */
+    void insert(const int* xyMin, const int* xyMax, bool logTransform, double offset,
+                const std::vector<MRCSectionStatistics>& stats);
+
+  protected:
+    MRCStatisticsIndex();
+
+    typedef struct
+    {
+      int XYMin[2];
+      int XYMax[2];
+      int LogTransform;
+      double Offset;
+      std::vector<MRCSectionStatistics> Sections;
+    } Entry;
+
+    /**
+     * @brief Computes the statistics of every section of the file in one pass
+     */
+    int compute(MRCFile::Pointer mrcFile, const int* xyMin, const int* xyMax,
+                bool logTransform, double offset, std::vector<MRCSectionStatistics>& stats);
+
+  private:
+    std::vector<Entry> m_Entries;
+
+    MRCStatisticsIndex(const MRCStatisticsIndex&); // Copy Constructor Not Implemented
+    void operator=(const MRCStatisticsIndex&); // Operator '=' Not Implemented
+};
+
+#endif /* _MRCSTATISTICSINDEX_H_ */
@@ -0,0 +1,112 @@
+/* ============================================================================
+ * Copyright (c) 2011, Michael A. Jackson (BlueQuartz Software)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Michael A. Jackson nor the names of its contributors may
+ * be used to endorse or promote products derived from this software without
+ * specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _MRCVIEW_H_
+#define _MRCVIEW_H_
+
+#include "MBIRLib/MBIRLib.h"
+
+/**
+ * @class MRCView MRCView.h MBIRLib/IOFilters/MRCView.h
+ * @brief A read only window onto an (x, y, section) box of the voxel data of a
+ * mapped MRC file. Nothing is copied; the view points straight at the mapped
+ * pages and steps through them with the strides of the full volume. A view is
+ * only valid for as long as the MRCReader that created it keeps the file mapped.
+ * Index 0 of each axis is the minimum voxel of the box.
+ * @author Michael A. Jackson for BlueQuartz Software
+ * @version 1.0
+ */
+template<typename T>
+class MRCView
+{
+  public:
+    MRCView() : m_Origin(NULL)
+    {
+      for (int i = 0; i < 3; i++) { m_Dims[i] = 0; m_Strides[i] = 0; }
+    }
+
+    MRCView(const T* origin, const size_t* dims, const size_t* strides) : m_Origin(origin)
+    {
+      for (int i = 0; i < 3; i++) { m_Dims[i] = dims[i]; m_Strides[i] = strides[i]; }
+    }
+
+    bool isValid() const { return NULL != m_Origin; }
+
+    /**
+     * @brief Number of voxels of the box along x, y and sections
+     */
+    size_t getDim(int axis) const { return m_Dims[axis]; }
+
+    /**
+     * @brief Distance in elements between neighboring voxels along x, y and sections
+     */
+    size_t getStride(int axis) const { return m_Strides[axis]; }
+
+    size_t getNumberOfElements() const { return m_Dims[0] * m_Dims[1] * m_Dims[2]; }
+
+    /**
+     * @brief Returns the value at (x, y, z) relative to the minimum corner of the box
+     */
+    inline T getValue(size_t x, size_t y, size_t z) const
+    {
+      return m_Origin[z * m_Strides[2] + y * m_Strides[1] + x];
+    }
+
+    /**
+     * @brief Returns the first voxel of row y of section z. The row has getDim(0)
+     * contiguous elements.
+     */
+    inline const T* getRow(size_t y, size_t z) const
+    {
+      return m_Origin + z * m_Strides[2] + y * m_Strides[1];
+    }
+
+    /**
+     * @brief Returns a view of a sub box of this view. The minimum and maximum
+     * are relative to this view and inclusive.
+     */
+    MRCView<T> getSubView(const size_t* voxelMin, const size_t* voxelMax) const
+    {
+      size_t dims[3];
+      for (int i = 0; i < 3; i++)
+      {
+        if (voxelMin[i] > voxelMax[i] || voxelMax[i] >= m_Dims[i]) { return MRCView<T>(); }
+        dims[i] = voxelMax[i] - voxelMin[i] + 1;
+      }
+      return MRCView<T>(m_Origin + voxelMin[2] * m_Strides[2] + voxelMin[1] * m_Strides[1] + voxelMin[0], dims, m_Strides);
+    }
+
+  private:
+    const T* m_Origin;
+    size_t m_Dims[3];
+    size_t m_Strides[3];
+};
+
+#endif /* _MRCVIEW_H_ */
@@ -38,6 +38,7 @@
 #include "NuisanceParamReader.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include <string>
 
@@ -94,6 +95,22 @@ void NuisanceParamReader::execute()
     return;
   }
 
+  if (NULL != m_SourceData.get())
+  {
+    if (m_SourceData->getNDims() != 1 || *(m_SourceData->getDims()) != getSinogram()->N_theta)
+    {
+      setErrorCondition(-1);
+      setErrorMessage("NuisanceParamReader: SourceData does not have the same size as the Sinogram N_theta.");
+      notify(getErrorMessage().c_str(), 0, UpdateErrorMessage);
+      return;
+    }
+    ::memcpy(m_Data->getPointer(), m_SourceData->getPointer(), m_Data->getTypeSize() * getSinogram()->N_theta);
+    setErrorCondition(0);
+    setErrorMessage("");
+    notify("Done Copying the NuisanceParameters", 0, UpdateProgressMessage);
+    return;
+  }
+
   FILE* file = fopen(m_FileName.c_str(), "rb");
   if(file == 0)
   {
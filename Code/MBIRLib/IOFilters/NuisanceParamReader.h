@@ -70,6 +70,8 @@ class MBIRLib_EXPORT NuisanceParamReader : public TomoFilter
     MXA_INSTANCE_STRING_PROPERTY(FileName);
     //  MXA_INSTANCE_PROPERTY(TargetArray, DataToRead);
     MXA_INSTANCE_PROPERTY(RealArrayType::Pointer, Data);
+    /* If set the values are copied from this array instead of read from FileName */
+    MXA_INSTANCE_PROPERTY(RealArrayType::Pointer, SourceData);
 
     void execute();
 
@@ -0,0 +1,627 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "ReconstructionCheckpoint.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <sstream>
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_group.h>
+#endif
+
+#if defined (MBIRLib_HDF5_SUPPORT)
+#include <hdf5.h>
+#endif
+
+#include "MXA/Utilities/MXADir.h"
+#include "MXA/Utilities/MXAFileInfo.h"
+
+#include "MBIRLib/Common/EIMTime.h"
+
+namespace Detail
+{
+  enum CheckpointType
+  {
+    CheckpointReal = 0,
+    CheckpointInt32 = 1,
+    CheckpointUInt32 = 2
+  };
+
+  /**
+   * @brief Returns the size in bytes of one element of the given type
+   */
+  static size_t checkpointTypeSize(int type)
+  {
+    switch(type)
+    {
+      case CheckpointInt32: return sizeof(int32_t);
+      case CheckpointUInt32: return sizeof(uint32_t);
+      default: break;
+    }
+    return sizeof(Real_t);
+  }
+
+  /**
+   * @brief Returns the number of elements of a dataset
+   */
+  static size_t checkpointNumElements(const ReconstructionCheckpoint::Dataset& dataset)
+  {
+    size_t count = 1;
+    for (size_t i = 0; i < dataset.dims.size(); i++)
+    {
+      count *= static_cast<size_t>(dataset.dims[i]);
+    }
+    return count;
+  }
+
+  /**
+   * @brief Copies one registered array into its checkpoint buffer
+   */
+  class CopyCheckpointDataset
+  {
+    public:
+      CopyCheckpointDataset(ReconstructionCheckpoint::Dataset* dataset) :
+        m_Dataset(dataset)
+      {}
+
+      void operator()() const
+      {
+        size_t numBytes = checkpointNumElements(*m_Dataset) * checkpointTypeSize(m_Dataset->type);
+        m_Dataset->buffer.resize(numBytes);
+        if(numBytes == 0)
+        {
+          return;
+        }
+        if(NULL != m_Dataset->bits.get())
+        {
+          uint32_t* words = reinterpret_cast<uint32_t*>(&(m_Dataset->buffer.front()));
+          size_t numWords = m_Dataset->bits->getNumberOfWords();
+          for (size_t w = 0; w < numWords; w++)
+          {
+            words[w] = m_Dataset->bits->getWord(w);
+          }
+        }
+        else
+        {
+          ::memcpy(&(m_Dataset->buffer.front()), m_Dataset->data, numBytes);
+        }
+      }
+
+    private:
+      ReconstructionCheckpoint::Dataset* m_Dataset;
+  };
+
+#if defined (MBIRLib_HDF5_SUPPORT)
+  /**
+   * @brief Returns the HDF5 memory type of the given type
+   */
+  static hid_t checkpointMemType(int type)
+  {
+    switch(type)
+    {
+      case CheckpointInt32: return H5T_NATIVE_INT32;
+      case CheckpointUInt32: return H5T_NATIVE_UINT32;
+      default: break;
+    }
+    return (sizeof(Real_t) == sizeof(double)) ? H5T_NATIVE_DOUBLE : H5T_NATIVE_FLOAT;
+  }
+
+  /**
+   * @brief H5Aiterate2 callback that collects the counters stored as
+   * attributes of the root group
+   */
+  static herr_t collectCheckpointCounter(hid_t loc, const char* name, const H5A_info_t* /* info */, void* opData)
+  {
+    std::map<std::string, Real_t>* counters = static_cast<std::map<std::string, Real_t>*>(opData);
+    hid_t attr = H5Aopen(loc, name, H5P_DEFAULT);
+    if(attr < 0)
+    {
+      return -1;
+    }
+    double value = 0.0;
+    herr_t err = H5Aread(attr, H5T_NATIVE_DOUBLE, &value);
+    H5Aclose(attr);
+    (*counters)[name] = static_cast<Real_t>(value);
+    return err;
+  }
+
+  /**
+   * @brief Writes one dataset. The chunks span the fastest dimensions and are
+   * about a megabyte in size.
+   */
+  static herr_t writeCheckpointDataset(hid_t fileId, const ReconstructionCheckpoint::Dataset& dataset, int compressionLevel)
+  {
+    const size_t k_ChunkBytes = 1 << 20;
+    size_t rank = dataset.dims.size();
+    std::vector<hsize_t> dims(rank);
+    std::vector<hsize_t> chunk(rank);
+    size_t chunkBytes = checkpointTypeSize(dataset.type);
+    bool full = true;
+    for (size_t i = rank; i > 0; i--)
+    {
+      dims[i - 1] = static_cast<hsize_t>(dataset.dims[i - 1]);
+      if(full == true && chunkBytes * dims[i - 1] <= k_ChunkBytes)
+      {
+        chunk[i - 1] = dims[i - 1];
+      }
+      else if(full == true)
+      {
+        chunk[i - 1] = (k_ChunkBytes / chunkBytes > 1) ? k_ChunkBytes / chunkBytes : 1;
+        full = false;
+      }
+      else
+      {
+        chunk[i - 1] = 1;
+      }
+      chunkBytes *= chunk[i - 1];
+    }
+
+    hid_t space = H5Screate_simple(static_cast<int>(rank), &(dims.front()), NULL);
+    hid_t plist = H5Pcreate(H5P_DATASET_CREATE);
+    herr_t err = H5Pset_chunk(plist, static_cast<int>(rank), &(chunk.front()));
+    if(err >= 0 && compressionLevel > 0 && H5Zfilter_avail(H5Z_FILTER_DEFLATE) > 0)
+    {
+      H5Pset_shuffle(plist);
+      err = H5Pset_deflate(plist, compressionLevel);
+    }
+    if(err >= 0)
+    {
+      hid_t memType = checkpointMemType(dataset.type);
+      hid_t dset = H5Dcreate2(fileId, dataset.name.c_str(), memType, space, H5P_DEFAULT, plist, H5P_DEFAULT);
+      err = (dset < 0) ? -1 : H5Dwrite(dset, memType, H5S_ALL, H5S_ALL, H5P_DEFAULT, &(dataset.buffer.front()));
+      if(dset >= 0)
+      {
+        H5Dclose(dset);
+      }
+    }
+    H5Pclose(plist);
+    H5Sclose(space);
+    return err;
+  }
+
+  /**
+   * @brief Writes the checkpoint buffers to an HDF5 file. This runs on the
+   * writer thread so it does not notify anyone; the result is left in *error.
+   * The file is renamed to the target once it is complete.
+   */
+  class WriteCheckpoint
+  {
+    public:
+      WriteCheckpoint(const std::vector<ReconstructionCheckpoint::Dataset>* datasets,
+                      const std::map<std::string, Real_t>* counters,
+                      const std::string& file, const std::string& target,
+                      int compressionLevel, int* error) :
+        m_Datasets(datasets), m_Counters(counters), m_File(file), m_Target(target),
+        m_CompressionLevel(compressionLevel), m_Error(error)
+      {}
+
+      void operator()() const
+      {
+        hid_t fileId = H5Fcreate(m_File.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+        if(fileId < 0)
+        {
+          *m_Error = -1;
+          return;
+        }
+        herr_t err = 0;
+        hid_t scalar = H5Screate(H5S_SCALAR);
+        for (std::map<std::string, Real_t>::const_iterator iter = m_Counters->begin(); err >= 0 && iter != m_Counters->end(); ++iter)
+        {
+          double value = static_cast<double>(iter->second);
+          hid_t attr = H5Acreate2(fileId, iter->first.c_str(), H5T_NATIVE_DOUBLE, scalar, H5P_DEFAULT, H5P_DEFAULT);
+          err = (attr < 0) ? -1 : H5Awrite(attr, H5T_NATIVE_DOUBLE, &value);
+          if(attr >= 0)
+          {
+            H5Aclose(attr);
+          }
+        }
+        H5Sclose(scalar);
+        for (size_t i = 0; err >= 0 && i < m_Datasets->size(); i++)
+        {
+          if((*m_Datasets)[i].buffer.empty() == false)
+          {
+            err = writeCheckpointDataset(fileId, (*m_Datasets)[i], m_CompressionLevel);
+          }
+        }
+        if(H5Fclose(fileId) < 0)
+        {
+          err = -1;
+        }
+        if(err < 0)
+        {
+          MXADir::remove(m_File);
+          *m_Error = -1;
+          return;
+        }
+        MXADir::remove(m_Target);
+        if(::rename(m_File.c_str(), m_Target.c_str()) != 0)
+        {
+          *m_Error = -1;
+        }
+      }
+
+    private:
+      const std::vector<ReconstructionCheckpoint::Dataset>* m_Datasets;
+      const std::map<std::string, Real_t>* m_Counters;
+      std::string m_File;
+      std::string m_Target;
+      int m_CompressionLevel;
+      int* m_Error;
+  };
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+ReconstructionCheckpoint::ReconstructionCheckpoint() :
+  TomoFilter(),
+  m_CompressionLevel(1),
+  m_Pending(false),
+  m_WriteError(0),
+  m_LastCheckpointTime(EIMTOMO_getMilliSeconds())
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  , m_Thread(NULL)
+#endif
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+ReconstructionCheckpoint::~ReconstructionCheckpoint()
+{
+  finish();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool ReconstructionCheckpoint::IsSupported()
+{
+#if defined (MBIRLib_HDF5_SUPPORT)
+  return true;
+#else
+  return false;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ReconstructionCheckpoint::addDataset(const std::string& name, int type, size_t rank, const size_t* dims, void* data, boost::shared_ptr<void> owner)
+{
+  Dataset dataset;
+  dataset.name = name;
+  dataset.type = type;
+  dataset.dims.resize(rank);
+  for (size_t i = 0; i < rank; i++)
+  {
+    dataset.dims[i] = dims[i];
+  }
+  dataset.data = data;
+  dataset.owner = owner;
+  m_Datasets.push_back(dataset);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ReconstructionCheckpoint::addVolume(const std::string& name, RealVolumeType::Pointer volume)
+{
+  addDataset(name, Detail::CheckpointReal, 3, volume->getDims(), volume->d, volume);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ReconstructionCheckpoint::addImage(const std::string& name, RealImageType::Pointer image)
+{
+  addDataset(name, Detail::CheckpointReal, 2, image->getDims(), image->d, image);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ReconstructionCheckpoint::addArray(const std::string& name, RealArrayType::Pointer array)
+{
+  addDataset(name, Detail::CheckpointReal, 1, array->getDims(), array->d, array);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ReconstructionCheckpoint::addBitVolume(const std::string& name, BitVolume::Pointer bits)
+{
+  size_t numWords = bits->getNumberOfWords();
+  addDataset(name, Detail::CheckpointUInt32, 1, &numWords, NULL, bits);
+  m_Datasets.back().bits = bits;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ReconstructionCheckpoint::addVoxelList(const std::string& name, VoxelUpdateList::Pointer list)
+{
+  // Each entry is an (x, z) pair
+  size_t dims[2] = { static_cast<size_t>(list->numElements()), 2 };
+  addDataset(name, Detail::CheckpointInt32, 2, dims, list->getArray().get(), list);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ReconstructionCheckpoint::setCounter(const std::string& name, Real_t value)
+{
+  m_Counters[name] = value;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+Real_t ReconstructionCheckpoint::getCounter(const std::string& name, Real_t defaultValue)
+{
+  std::map<std::string, Real_t>::iterator iter = m_Counters.find(name);
+  if(iter == m_Counters.end())
+  {
+    return defaultValue;
+  }
+  return iter->second;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool ReconstructionCheckpoint::isEnabled()
+{
+  return getTomoInputs()->checkpointInterval >= 0 && getOutputFile().empty() == false;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool ReconstructionCheckpoint::checkpointIfDue()
+{
+  Real_t interval = getTomoInputs()->checkpointInterval;
+  if(interval <= 0 || getOutputFile().empty() == true)
+  {
+    return false;
+  }
+  if(EIMTOMO_getMilliSeconds() - m_LastCheckpointTime < interval * 1000.0)
+  {
+    return false;
+  }
+  checkpoint();
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ReconstructionCheckpoint::checkpoint()
+{
+  finish();
+  m_LastCheckpointTime = EIMTOMO_getMilliSeconds();
+#if defined (MBIRLib_HDF5_SUPPORT)
+  // The copies are quick next to an iteration. The writer thread only sees them.
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  tbb::task_group* g = new tbb::task_group;
+  for (size_t i = 0; i < m_Datasets.size(); i++)
+  {
+    g->run(Detail::CopyCheckpointDataset(&(m_Datasets[i])));
+  }
+  g->wait(); // Wait for all the threads to complete before moving on.
+  delete g;
+#else
+  for (size_t i = 0; i < m_Datasets.size(); i++)
+  {
+    Detail::CopyCheckpointDataset copy(&(m_Datasets[i]));
+    copy();
+  }
+#endif
+  m_PendingCounters = m_Counters;
+
+  notify(std::string("Writing checkpoint to '") + getOutputFile() + std::string("'"), 0, Observable::UpdateProgressMessage);
+  m_WriteError = 0;
+  m_Pending = true;
+  Detail::WriteCheckpoint writeCheckpoint(&m_Datasets, &m_PendingCounters, getOutputFile() + std::string(".tmp"), getOutputFile(), m_CompressionLevel, &m_WriteError);
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  m_Thread = new tbb::tbb_thread(writeCheckpoint);
+#else
+  writeCheckpoint();
+  finish();
+#endif
+#else
+  setErrorCondition(-1);
+  notify("Checkpoints need HDF5 support which this build does not have", 0, Observable::UpdateErrorMessage);
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ReconstructionCheckpoint::finish()
+{
+  if(m_Pending == false)
+  {
+    return;
+  }
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  m_Thread->join();
+  delete m_Thread;
+  m_Thread = NULL;
+#endif
+  m_Pending = false;
+  // Release the copies until the next checkpoint
+  for (size_t i = 0; i < m_Datasets.size(); i++)
+  {
+    std::vector<uint8_t>().swap(m_Datasets[i].buffer);
+  }
+
+  std::stringstream ss;
+  if(m_WriteError < 0)
+  {
+    ss << "Error writing checkpoint file\n    '" << getOutputFile() << "'" << std::endl;
+    setErrorCondition(m_WriteError);
+    notify(ss.str(), 0, Observable::UpdateErrorMessage);
+    return;
+  }
+  ss << "Checkpoint written to '" << getOutputFile() << "'";
+  notify(ss.str(), 0, Observable::UpdateProgressMessage);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int ReconstructionCheckpoint::ReadCounters(const std::string& file, std::map<std::string, Real_t>& counters)
+{
+  counters.clear();
+  if(MXAFileInfo::exists(file) == false)
+  {
+    return -1;
+  }
+#if defined (MBIRLib_HDF5_SUPPORT)
+  hid_t fileId = H5Fopen(file.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  if(fileId < 0)
+  {
+    return -1;
+  }
+  herr_t err = H5Aiterate2(fileId, H5_INDEX_NAME, H5_ITER_INC, NULL, &Detail::collectCheckpointCounter, &counters);
+  H5Fclose(fileId);
+  return (err < 0) ? -1 : 0;
+#else
+  return -1;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int ReconstructionCheckpoint::restore(const std::string& file)
+{
+  std::stringstream ss;
+#if defined (MBIRLib_HDF5_SUPPORT)
+  m_Counters.clear();
+  if(ReadCounters(file, m_Counters) < 0)
+  {
+    ss << "Could not read the checkpoint file\n    '" << file << "'" << std::endl;
+    setErrorCondition(-1);
+    notify(ss.str(), 0, Observable::UpdateErrorMessage);
+    return -1;
+  }
+  hid_t fileId = H5Fopen(file.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  int err = (fileId < 0) ? -1 : 0;
+  for (size_t i = 0; err >= 0 && i < m_Datasets.size(); i++)
+  {
+    Dataset& dataset = m_Datasets[i];
+    size_t numElements = Detail::checkpointNumElements(dataset);
+    if(numElements == 0)
+    {
+      continue;
+    }
+    if(H5Lexists(fileId, dataset.name.c_str(), H5P_DEFAULT) <= 0)
+    {
+      ss << "The checkpoint does not contain '" << dataset.name << "'" << std::endl;
+      err = -2;
+      break;
+    }
+    hid_t dset = H5Dopen2(fileId, dataset.name.c_str(), H5P_DEFAULT);
+    hid_t space = H5Dget_space(dset);
+    int rank = H5Sget_simple_extent_ndims(space);
+    std::vector<hsize_t> dims(rank > 0 ? rank : 1);
+    H5Sget_simple_extent_dims(space, &(dims.front()), NULL);
+    bool match = (rank == static_cast<int>(dataset.dims.size()));
+    for (int d = 0; match == true && d < rank; d++)
+    {
+      match = (dims[d] == dataset.dims[d]);
+    }
+    if(match == false)
+    {
+      ss << "The size of '" << dataset.name << "' in the checkpoint does not match this reconstruction" << std::endl;
+      err = -3;
+    }
+    else if(NULL != dataset.bits.get())
+    {
+      std::vector<uint32_t> words(numElements);
+      err = H5Dread(dset, H5T_NATIVE_UINT32, H5S_ALL, H5S_ALL, H5P_DEFAULT, &(words.front()));
+      for (size_t w = 0; err >= 0 && w < numElements; w++)
+      {
+        dataset.bits->setWord(w, words[w]);
+      }
+    }
+    else
+    {
+      err = H5Dread(dset, Detail::checkpointMemType(dataset.type), H5S_ALL, H5S_ALL, H5P_DEFAULT, dataset.data);
+    }
+    H5Sclose(space);
+    H5Dclose(dset);
+    if(err < 0 && ss.str().empty() == true)
+    {
+      ss << "Error reading '" << dataset.name << "' from the checkpoint" << std::endl;
+    }
+  }
+  if(fileId >= 0)
+  {
+    H5Fclose(fileId);
+  }
+  if(err < 0)
+  {
+    ss << "    '" << file << "'" << std::endl;
+    setErrorCondition(err);
+    notify(ss.str(), 0, Observable::UpdateErrorMessage);
+    return err;
+  }
+  ss << "Restored the checkpoint '" << file << "'";
+  notify(ss.str(), 0, Observable::UpdateProgressMessage);
+  return 0;
+#else
+  ss << "Can not resume from '" << file << "'. Checkpoints need HDF5 support which this build does not have";
+  setErrorCondition(-1);
+  notify(ss.str(), 0, Observable::UpdateErrorMessage);
+  return -1;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ReconstructionCheckpoint::execute()
+{
+  finish();
+}
@@ -0,0 +1,188 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef RECONSTRUCTIONCHECKPOINT_H_
+#define RECONSTRUCTIONCHECKPOINT_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/BitVolume.h"
+#include "MBIRLib/Common/VoxelUpdateList.h"
+#include "MBIRLib/GenericFilters/TomoFilter.h"
+#include "MBIRLib/Reconstruction/ReconstructionStructures.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/tbb_thread.h>
+#endif
+
+/**
+ * @class ReconstructionCheckpoint ReconstructionCheckpoint.h MBIRLib/IOFilters/ReconstructionCheckpoint.h
+ * @brief Saves the state of a reconstruction to a single HDF5 file so that a
+ * cancelled or killed run can be restarted where it stopped. The engine
+ * registers the arrays that make up its state along with a set of named
+ * counters (iterations, thresholds and so on). A checkpoint copies the arrays
+ * and writes them as chunked, deflate compressed datasets on a background
+ * thread while the reconstruction carries on. The file is written next to its
+ * target and renamed once complete, so the previous checkpoint stays intact
+ * until the new one is. restore() reads a checkpoint back into the registered
+ * arrays, which must have the dimensions they were saved with.
+ *
+ * How often checkpoints are taken is set by TomoInputs::checkpointInterval.
+ * Without HDF5 support every checkpoint fails with an error.
+ */
+class MBIRLib_EXPORT ReconstructionCheckpoint : public TomoFilter
+{
+  public:
+    MXA_SHARED_POINTERS(ReconstructionCheckpoint)
+    MXA_STATIC_NEW_MACRO(ReconstructionCheckpoint);
+    MXA_TYPE_MACRO_SUPER(ReconstructionCheckpoint, TomoFilter)
+
+    virtual ~ReconstructionCheckpoint();
+
+    MXA_INSTANCE_STRING_PROPERTY(OutputFile)
+    /* Deflate level of the datasets from 0 (off) to 9 */
+    MXA_INSTANCE_PROPERTY(int, CompressionLevel)
+
+    /**
+     * @brief Returns true if the library was built with HDF5
+     */
+    static bool IsSupported();
+
+    /**
+     * @brief Registers an array that is part of the reconstruction state.
+     * Arrays are saved and restored in place so they must stay allocated.
+     */
+    void addVolume(const std::string& name, RealVolumeType::Pointer volume);
+    void addImage(const std::string& name, RealImageType::Pointer image);
+    void addArray(const std::string& name, RealArrayType::Pointer array);
+    void addBitVolume(const std::string& name, BitVolume::Pointer bits);
+    void addVoxelList(const std::string& name, VoxelUpdateList::Pointer list);
+
+    /**
+     * @brief Sets a counter that is saved with the next checkpoint
+     */
+    void setCounter(const std::string& name, Real_t value);
+
+    /**
+     * @brief Returns a counter that was set or restored, or defaultValue
+     */
+    Real_t getCounter(const std::string& name, Real_t defaultValue = 0.0);
+
+    /**
+     * @brief Returns true if checkpoints were asked for
+     */
+    bool isEnabled();
+
+    /**
+     * @brief Takes a checkpoint if TomoInputs::checkpointInterval seconds
+     * have passed since the last one
+     * @return True if a checkpoint was taken
+     */
+    bool checkpointIfDue();
+
+    /**
+     * @brief Copies the registered arrays and counters and writes them in the
+     * background. Waits for the previous checkpoint first.
+     */
+    void checkpoint();
+
+    /**
+     * @brief Waits for the checkpoint being written, if any, and reports its
+     * outcome. Called by the destructor as well.
+     */
+    void finish();
+
+    /**
+     * @brief Reads the counters and the registered arrays from a checkpoint
+     * @return Negative on error
+     */
+    int restore(const std::string& file);
+
+    /**
+     * @brief Reads only the counters of a checkpoint, e.g. to find out which
+     * resolution it belongs to
+     * @return Negative on error
+     */
+    static int ReadCounters(const std::string& file, std::map<std::string, Real_t>& counters);
+
+    /**
+     * @brief Waits for any pending checkpoint
+     */
+    virtual void execute();
+
+    /**
+     * @brief One array of the reconstruction state
+     */
+    struct Dataset
+    {
+      std::string name;
+      int type;
+      std::vector<uint64_t> dims;
+      void* data;                  // NULL for bit volumes which are copied word by word
+      BitVolume::Pointer bits;
+      boost::shared_ptr<void> owner; // Keeps the array alive while registered
+      std::vector<uint8_t> buffer; // Copy that is written on the background thread
+    };
+
+  protected:
+    ReconstructionCheckpoint();
+
+    void addDataset(const std::string& name, int type, size_t rank, const size_t* dims, void* data, boost::shared_ptr<void> owner);
+
+  private:
+    std::vector<Dataset> m_Datasets;
+    std::map<std::string, Real_t> m_Counters;
+    std::map<std::string, Real_t> m_PendingCounters;
+    bool m_Pending;
+    int m_WriteError;
+    unsigned long long int m_LastCheckpointTime;
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    tbb::tbb_thread* m_Thread;
+#endif
+
+    ReconstructionCheckpoint(const ReconstructionCheckpoint&); // Copy Constructor Not Implemented
+    void operator=(const ReconstructionCheckpoint&); // Operator '=' Not Implemented
+};
+
+
+#endif /* RECONSTRUCTIONCHECKPOINT_H_ */
@@ -0,0 +1,302 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "ReconstructionSnapshotWriter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <sstream>
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_group.h>
+#endif
+
+#include "MXA/Utilities/MXADir.h"
+
+#include "MBIRLib/Common/EIMTime.h"
+#include "MBIRLib/IOFilters/MRCWriter.h"
+
+namespace Detail
+{
+  /**
+   * @brief Copies one z plane of the volume into the snapshot buffer
+   */
+  class CopySnapshotPlane
+  {
+    public:
+      CopySnapshotPlane(const RealVolumeType* source, RealVolumeType* dest, size_t z) :
+        m_Source(source), m_Dest(dest), m_Z(z)
+      {}
+
+      void operator()() const
+      {
+        const size_t* dims = m_Dest->getDims();
+        size_t planeSize = dims[1] * dims[2];
+        ::memcpy(m_Dest->d + m_Z * planeSize, m_Source->d + m_Z * planeSize, sizeof(Real_t) * planeSize);
+      }
+
+    private:
+      const RealVolumeType* m_Source;
+      RealVolumeType* m_Dest;
+      size_t m_Z;
+  };
+
+  /**
+   * @brief Writes a snapshot to an MRC file. This runs on the writer thread so
+   * it does not notify anyone; the result is left in *error. If a target is
+   * given the file is renamed to it once complete so that a reader never sees
+   * a partially written target.
+   */
+  class WriteSnapshot
+  {
+    public:
+      WriteSnapshot(GeometryPtr geometry, AdvancedParametersPtr advParams,
+                    const std::string& file, const std::string& target,
+                    uint16_t cropStart, uint16_t cropEnd, int* error) :
+        m_Geometry(geometry), m_AdvParams(advParams), m_File(file), m_Target(target),
+        m_CropStart(cropStart), m_CropEnd(cropEnd), m_Error(error)
+      {}
+
+      void operator()() const
+      {
+        MRCWriter::Pointer mrcWriter = MRCWriter::New();
+        mrcWriter->setOutputFile(m_File);
+        mrcWriter->setGeometry(m_Geometry);
+        mrcWriter->setAdvParams(m_AdvParams);
+        mrcWriter->setXDims(m_CropStart, m_CropEnd);
+        mrcWriter->setYDims(0, m_Geometry->N_y);
+        mrcWriter->setZDims(0, m_Geometry->N_z);
+        mrcWriter->execute();
+        *m_Error = mrcWriter->getErrorCondition();
+        if(*m_Error >= 0 && m_Target.empty() == false)
+        {
+          MXADir::remove(m_Target);
+          if(::rename(m_File.c_str(), m_Target.c_str()) != 0)
+          {
+            *m_Error = -1;
+          }
+        }
+      }
+
+    private:
+      GeometryPtr m_Geometry;
+      AdvancedParametersPtr m_AdvParams;
+      std::string m_File;
+      std::string m_Target;
+      uint16_t m_CropStart;
+      uint16_t m_CropEnd;
+      int* m_Error;
+  };
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+ReconstructionSnapshotWriter::ReconstructionSnapshotWriter() :
+  TomoFilter(),
+  m_NextBuffer(0),
+  m_Pending(false),
+  m_WriteError(0),
+  m_NumCalls(0),
+  m_LastSnapshotTime(EIMTOMO_getMilliSeconds())
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  , m_Thread(NULL)
+#endif
+{
+  m_XDims[0] = 0;
+  m_XDims[1] = 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+ReconstructionSnapshotWriter::~ReconstructionSnapshotWriter()
+{
+  finish();
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int ReconstructionSnapshotWriter::PolicyFromString(const std::string& name)
+{
+  if(name.compare("none") == 0) { return MBIR::SnapshotPolicy::None; }
+  if(name.compare("every") == 0) { return MBIR::SnapshotPolicy::EveryIteration; }
+  if(name.compare("iterations") == 0) { return MBIR::SnapshotPolicy::EveryNIterations; }
+  if(name.compare("seconds") == 0) { return MBIR::SnapshotPolicy::EveryNSeconds; }
+  if(name.compare("latest") == 0) { return MBIR::SnapshotPolicy::LatestOnly; }
+  return -1;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool ReconstructionSnapshotWriter::isSnapshotDue()
+{
+  TomoInputsPtr inputs = getTomoInputs();
+  m_NumCalls++;
+  switch(inputs->snapshotPolicy)
+  {
+    case MBIR::SnapshotPolicy::None:
+      return false;
+    case MBIR::SnapshotPolicy::EveryNIterations:
+    {
+      unsigned int interval = (inputs->snapshotInterval < 1) ? 1 : static_cast<unsigned int>(inputs->snapshotInterval);
+      return (m_NumCalls % interval) == 0;
+    }
+    case MBIR::SnapshotPolicy::EveryNSeconds:
+      return (EIMTOMO_getMilliSeconds() - m_LastSnapshotTime) >= inputs->snapshotInterval * 1000.0;
+    default:
+      break;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+bool ReconstructionSnapshotWriter::snapshot(int16_t outerIteration, int16_t innerIteration)
+{
+  if(isSnapshotDue() == false)
+  {
+    return false;
+  }
+  GeometryPtr geometry = getGeometry();
+  TomoInputsPtr inputs = getTomoInputs();
+
+  // The buffer that is not being written is filled while the previous
+  // snapshot may still be on its way to the disk
+  RealVolumeType::Pointer buffer = m_Buffers[m_NextBuffer];
+  const size_t* dims = geometry->Object->getDims();
+  if(NULL == buffer.get() || ::memcmp(buffer->getDims(), dims, 3 * sizeof(size_t)) != 0)
+  {
+    size_t bufferDims[3] = { dims[0], dims[1], dims[2] };
+    buffer = RealVolumeType::New(bufferDims, "Snapshot");
+    m_Buffers[m_NextBuffer] = buffer;
+  }
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  tbb::task_group* g = new tbb::task_group;
+  for (size_t z = 0; z < dims[0]; z++)
+  {
+    g->run(Detail::CopySnapshotPlane(geometry->Object.get(), buffer.get(), z));
+  }
+  g->wait(); // Wait for all the threads to complete before moving on.
+  delete g;
+#else
+  for (size_t z = 0; z < dims[0]; z++)
+  {
+    Detail::CopySnapshotPlane copy(geometry->Object.get(), buffer.get(), z);
+    copy();
+  }
+#endif
+
+  finish();
+
+  std::stringstream ss;
+  std::string target;
+  if(inputs->snapshotPolicy == MBIR::SnapshotPolicy::LatestOnly)
+  {
+    ss << inputs->tempDir << MXADir::getSeparator() << MBIR::Defaults::ReconstructedMrcFile;
+    target = ss.str();
+    ss << ".tmp";
+  }
+  else
+  {
+    ss << inputs->tempDir << MXADir::getSeparator() << outerIteration << "_" << innerIteration << "_" << MBIR::Defaults::ReconstructedMrcFile;
+  }
+  m_PendingFile = (target.empty() == true) ? ss.str() : target;
+
+  // The MRCWriter only uses the dimensions and the volume of the geometry
+  GeometryPtr snapshotGeometry = GeometryPtr(new Geometry);
+  *snapshotGeometry = *geometry;
+  snapshotGeometry->Object = buffer;
+
+  notify(std::string("Writing MRC file to '") + m_PendingFile + std::string("'"), 0, Observable::UpdateProgressMessage);
+  m_WriteError = 0;
+  m_Pending = true;
+  m_NextBuffer = 1 - m_NextBuffer;
+  m_LastSnapshotTime = EIMTOMO_getMilliSeconds();
+  Detail::WriteSnapshot writeSnapshot(snapshotGeometry, getAdvParams(), ss.str(), target, m_XDims[0], m_XDims[1], &m_WriteError);
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  m_Thread = new tbb::tbb_thread(writeSnapshot);
+#else
+  writeSnapshot();
+  finish();
+#endif
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ReconstructionSnapshotWriter::finish()
+{
+  if(m_Pending == false)
+  {
+    return;
+  }
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  m_Thread->join();
+  delete m_Thread;
+  m_Thread = NULL;
+#endif
+  m_Pending = false;
+
+  if(m_WriteError < 0)
+  {
+    std::stringstream ss;
+    ss << "Error writing MRC file\n    '" << m_PendingFile << "'" << std::endl;
+    setErrorCondition(m_WriteError);
+    notify(ss.str(), 0, Observable::UpdateErrorMessage);
+    return;
+  }
+  notify(m_PendingFile, 0, Observable::UpdateIntermediateImage);
+  std::vector<std::string>& tempFiles = getTomoInputs()->tempFiles;
+  if(std::find(tempFiles.begin(), tempFiles.end(), m_PendingFile) == tempFiles.end())
+  {
+    tempFiles.push_back(m_PendingFile);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void ReconstructionSnapshotWriter::execute()
+{
+  finish();
+}
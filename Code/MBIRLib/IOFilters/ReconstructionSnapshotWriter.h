@@ -0,0 +1,125 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef RECONSTRUCTIONSNAPSHOTWRITER_H_
+#define RECONSTRUCTIONSNAPSHOTWRITER_H_
+
+#include <string>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/GenericFilters/TomoFilter.h"
+#include "MBIRLib/Reconstruction/ReconstructionStructures.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/tbb_thread.h>
+#endif
+
+/**
+ * @class ReconstructionSnapshotWriter ReconstructionSnapshotWriter.h MBIRLib/IOFilters/ReconstructionSnapshotWriter.h
+ * @brief Writes the intermediate MRC snapshots of the volume that the GUI
+ * displays between iterations. The volume is copied into one of two buffers
+ * and written on a background thread while the next iteration runs. A
+ * snapshot waits only for the write of the one before it. Which iterations
+ * are written is decided by TomoInputs::snapshotPolicy (see
+ * MBIR::SnapshotPolicy) and TomoInputs::snapshotInterval. Observers are
+ * notified with UpdateIntermediateImage from the calling thread once a
+ * snapshot has been written, and each file is added to TomoInputs::tempFiles.
+ * Without the parallel algorithms the snapshots are written synchronously.
+ */
+class MBIRLib_EXPORT ReconstructionSnapshotWriter : public TomoFilter
+{
+  public:
+    MXA_SHARED_POINTERS(ReconstructionSnapshotWriter)
+    MXA_STATIC_NEW_MACRO(ReconstructionSnapshotWriter);
+    MXA_TYPE_MACRO_SUPER(ReconstructionSnapshotWriter, TomoFilter)
+
+    virtual ~ReconstructionSnapshotWriter();
+
+    MXA_INSTANCE_VEC2_PROPERTY(uint16_t, XDims)
+
+    /**
+     * @brief Writes a snapshot of the geometry's volume for the given iteration
+     * if the snapshot policy asks for one.
+     * @return True if a snapshot was taken
+     */
+    bool snapshot(int16_t outerIteration, int16_t innerIteration);
+
+    /**
+     * @brief Waits for the snapshot being written, if any, and notifies the
+     * observers. Called by the destructor as well.
+     */
+    void finish();
+
+    /**
+     * @brief Waits for any pending snapshot
+     */
+    virtual void execute();
+
+    /**
+     * @brief Converts the command line name of a policy (none, every,
+     * iterations, seconds or latest) to its MBIR::SnapshotPolicy value.
+     * @return -1 if the name is not recognized
+     */
+    static int PolicyFromString(const std::string& name);
+
+  protected:
+    ReconstructionSnapshotWriter();
+
+    /**
+     * @brief Applies the snapshot policy
+     */
+    bool isSnapshotDue();
+
+  private:
+    RealVolumeType::Pointer m_Buffers[2];
+    int m_NextBuffer;
+    bool m_Pending;
+    std::string m_PendingFile;
+    int m_WriteError;
+    unsigned int m_NumCalls;
+    unsigned long long int m_LastSnapshotTime;
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+    tbb::tbb_thread* m_Thread;
+#endif
+
+    ReconstructionSnapshotWriter(const ReconstructionSnapshotWriter&); // Copy Constructor Not Implemented
+    void operator=(const ReconstructionSnapshotWriter&); // Operator '=' Not Implemented
+};
+
+
+#endif /* RECONSTRUCTIONSNAPSHOTWRITER_H_ */
@@ -9,11 +9,16 @@ set (MBIRLib_IOFilters_SRCS
     ${MBIRLib_SOURCE_DIR}/IOFilters/DetectorResponseWriter.cpp
     ${MBIRLib_SOURCE_DIR}/IOFilters/GainsOffsetsReader.cpp
     ${MBIRLib_SOURCE_DIR}/IOFilters/RawGeometryWriter.cpp
+    ${MBIRLib_SOURCE_DIR}/IOFilters/MRCFile.cpp
     ${MBIRLib_SOURCE_DIR}/IOFilters/MRCReader.cpp
+    ${MBIRLib_SOURCE_DIR}/IOFilters/MRCStatisticsIndex.cpp
     ${MBIRLib_SOURCE_DIR}/IOFilters/MRCWriter.cpp
     ${MBIRLib_SOURCE_DIR}/IOFilters/NuisanceParamWriter.cpp
     ${MBIRLib_SOURCE_DIR}/IOFilters/NuisanceParamReader.cpp
+    ${MBIRLib_SOURCE_DIR}/IOFilters/ReconstructionCheckpoint.cpp
+    ${MBIRLib_SOURCE_DIR}/IOFilters/ReconstructionSnapshotWriter.cpp
     ${MBIRLib_SOURCE_DIR}/IOFilters/SinogramBinWriter.cpp
+    ${MBIRLib_SOURCE_DIR}/IOFilters/VolumeExporter.cpp
     )
 
 set (MBIRLib_IOFilters_HDRS
@@ -23,12 +28,18 @@ set (MBIRLib_IOFilters_HDRS
     ${MBIRLib_SOURCE_DIR}/IOFilters/VTKFileWriters.hpp
     ${MBIRLib_SOURCE_DIR}/IOFilters/VTKWriterMacros.h
     ${MBIRLib_SOURCE_DIR}/IOFilters/RawGeometryWriter.h
+    ${MBIRLib_SOURCE_DIR}/IOFilters/MRCFile.h
     ${MBIRLib_SOURCE_DIR}/IOFilters/MRCReader.h
+    ${MBIRLib_SOURCE_DIR}/IOFilters/MRCStatisticsIndex.h
     ${MBIRLib_SOURCE_DIR}/IOFilters/MRCWriter.h
     ${MBIRLib_SOURCE_DIR}/IOFilters/MRCHeader.h
+    ${MBIRLib_SOURCE_DIR}/IOFilters/MRCView.h
     ${MBIRLib_SOURCE_DIR}/IOFilters/NuisanceParamWriter.h
     ${MBIRLib_SOURCE_DIR}/IOFilters/NuisanceParamReader.h
+    ${MBIRLib_SOURCE_DIR}/IOFilters/ReconstructionCheckpoint.h
+    ${MBIRLib_SOURCE_DIR}/IOFilters/ReconstructionSnapshotWriter.h
     ${MBIRLib_SOURCE_DIR}/IOFilters/SinogramBinWriter.h
+    ${MBIRLib_SOURCE_DIR}/IOFilters/VolumeExporter.h
 )
 cmp_IDE_SOURCE_PROPERTIES( "MBIRLib/IOFilters" "${MBIRLib_IOFilters_HDRS}" "${MBIRLib_IOFilters_SRCS}" "${CMP_INSTALL_FILES}")
 
@@ -0,0 +1,543 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "VolumeExporter.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_group.h>
+#endif
+
+#include "MXA/Common/MXAEndian.h"
+
+#include "MBIRLib/Reconstruction/ReconstructionConstants.h"
+#include "MBIRLib/IOFilters/MRCHeader.h"
+#include "MBIRLib/IOFilters/MRCWriter.h"
+#include "MBIRLib/IOFilters/AvizoUniformCoordinateWriter.h"
+#include "MBIRLib/IOFilters/VTKFileWriters.hpp"
+
+/* Number of floats handed to each fwrite call (16 MiB) */
+#define VOLUME_EXPORT_BLOCK_SIZE 4194304
+
+namespace Detail
+{
+  /* Positions in files larger than 2 GB */
+  int seekFile(FILE* f, int64_t offset)
+  {
+#if defined (_MSC_VER)
+    return _fseeki64(f, offset, SEEK_SET);
+#else
+    return fseeko(f, static_cast<off_t>(offset), SEEK_SET);
+#endif
+  }
+
+  int64_t tellFile(FILE* f)
+  {
+#if defined (_MSC_VER)
+    return _ftelli64(f);
+#else
+    return static_cast<int64_t>(ftello(f));
+#endif
+  }
+
+  /**
+   * @brief Converts one output plane of the cropped volume to float. Output
+   * plane p holds z = zEnd - 1 - p with y rows of x values. The statistics of
+   * the plane are left at the given addresses.
+   */
+  class ConvertExportPlane
+  {
+    public:
+      ConvertExportPlane(RealVolumeType* source, FloatVolumeType* dest, size_t plane,
+                         const uint16_t* xDims, const uint16_t* yDims, uint16_t zEnd,
+                         float* dmin, float* dmax, double* sum) :
+        m_Source(source), m_Dest(dest), m_Plane(plane),
+        m_XDims(xDims), m_YDims(yDims), m_ZEnd(zEnd),
+        m_Min(dmin), m_Max(dmax), m_Sum(sum)
+      {}
+
+      void operator()() const
+      {
+        size_t* srcDims = m_Source->getDims();
+        size_t* dims = m_Dest->getDims();
+        size_t z = m_ZEnd - 1 - m_Plane;
+        size_t nx = dims[2];
+        float* out = m_Dest->d + m_Plane * dims[1] * nx;
+        float dmin = std::numeric_limits<float>::max();
+        float dmax = -std::numeric_limits<float>::max();
+        double sum = 0.0;
+        // The source has y fastest so walk it contiguously and scatter the
+        // values into the x fastest output rows
+        for (size_t x = m_XDims[0]; x < m_XDims[1]; ++x)
+        {
+          const Real_t* src = m_Source->d + (z * srcDims[1] + x) * srcDims[2];
+          float* col = out + (x - m_XDims[0]);
+          for (size_t y = m_YDims[0]; y < m_YDims[1]; ++y)
+          {
+            float v = static_cast<float>(src[y]);
+            col[(y - m_YDims[0]) * nx] = v;
+            sum += v;
+            if(v < dmin) { dmin = v; }
+            if(v > dmax) { dmax = v; }
+          }
+        }
+        *m_Min = dmin;
+        *m_Max = dmax;
+        *m_Sum = sum;
+      }
+
+    private:
+      RealVolumeType* m_Source;
+      FloatVolumeType* m_Dest;
+      size_t m_Plane;
+      const uint16_t* m_XDims;
+      const uint16_t* m_YDims;
+      uint16_t m_ZEnd;
+      float* m_Min;
+      float* m_Max;
+      double* m_Sum;
+  };
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+VolumeExporter::VolumeExporter() :
+  TomoFilter(),
+  m_WriteBinaryVtk(true),
+  m_OutputYOffset(0),
+  m_OutputYSize(0),
+  m_Minimum(0.0f),
+  m_Maximum(0.0f),
+  m_Mean(0.0f)
+{
+  m_XDims[0] = 0;
+  m_XDims[1] = 0;
+  m_YDims[0] = 0;
+  m_YDims[1] = 0;
+  m_ZDims[0] = 0;
+  m_ZDims[1] = 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+VolumeExporter::~VolumeExporter()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void VolumeExporter::convertVolume()
+{
+  GeometryPtr geometry = getGeometry();
+  size_t dims[3] = { static_cast<size_t>(m_ZDims[1] - m_ZDims[0]),
+                     static_cast<size_t>(m_YDims[1] - m_YDims[0]),
+                     static_cast<size_t>(m_XDims[1] - m_XDims[0])
+                   };
+  m_Volume = FloatVolumeType::New(dims, "VolumeExporter.Volume");
+
+  std::vector<float> planeMin(dims[0], 0.0f);
+  std::vector<float> planeMax(dims[0], 0.0f);
+  std::vector<double> planeSum(dims[0], 0.0);
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+  tbb::task_group* g = new tbb::task_group;
+  for (size_t p = 0; p < dims[0]; p++)
+  {
+    g->run(Detail::ConvertExportPlane(geometry->Object.get(), m_Volume.get(), p, m_XDims, m_YDims, m_ZDims[1],
+                                      &(planeMin[p]), &(planeMax[p]), &(planeSum[p])));
+  }
+  g->wait(); // Wait for all the threads to complete before moving on.
+  delete g;
+#else
+  for (size_t p = 0; p < dims[0]; p++)
+  {
+    Detail::ConvertExportPlane convert(geometry->Object.get(), m_Volume.get(), p, m_XDims, m_YDims, m_ZDims[1],
+                                       &(planeMin[p]), &(planeMax[p]), &(planeSum[p]));
+    convert();
+  }
+#endif
+
+  size_t count = dims[0] * dims[1] * dims[2];
+  if(count == 0)
+  {
+    m_Minimum = 0.0f;
+    m_Maximum = 0.0f;
+    m_Mean = 0.0f;
+    return;
+  }
+  m_Minimum = *std::min_element(planeMin.begin(), planeMin.end());
+  m_Maximum = *std::max_element(planeMax.begin(), planeMax.end());
+  double sum = 0.0;
+  for (size_t p = 0; p < dims[0]; p++)
+  {
+    sum += planeSum[p];
+  }
+  m_Mean = static_cast<float>(sum / count);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+uint16_t VolumeExporter::outputRows()
+{
+  if(m_OutputYSize > 0)
+  {
+    return m_OutputYSize;
+  }
+  return m_YDims[1] - m_YDims[0];
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+FILE* VolumeExporter::openOutputFile(const std::string& filepath)
+{
+  if(m_OutputYSize > 0 && m_OutputYOffset > 0)
+  {
+    return fopen(filepath.c_str(), "r+b");
+  }
+  return fopen(filepath.c_str(), "wb");
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int VolumeExporter::writeVolume(FILE* f, bool bigEndian)
+{
+  size_t* dims = m_Volume->getDims();
+  // The whole output is one contiguous run. A slab is one run per plane that
+  // goes to its rows of the plane.
+  size_t runs = 1;
+  size_t runLength = dims[0] * dims[1] * dims[2];
+  int64_t dataStart = Detail::tellFile(f);
+  if(m_OutputYSize > 0)
+  {
+    runs = dims[0];
+    runLength = dims[1] * dims[2];
+  }
+  std::vector<float> swapped;
+#if defined (MXA_LITTLE_ENDIAN)
+  if(bigEndian == true)
+  {
+    swapped.resize(std::min(runLength, static_cast<size_t>(VOLUME_EXPORT_BLOCK_SIZE)));
+  }
+#else
+  bigEndian = false;
+#endif
+  for (size_t run = 0; run < runs; ++run)
+  {
+    if(m_OutputYSize > 0)
+    {
+      int64_t row = static_cast<int64_t>(run) * m_OutputYSize + m_OutputYOffset;
+      if(Detail::seekFile(f, dataStart + row * static_cast<int64_t>(dims[2] * sizeof(float))) != 0)
+      {
+        return -1;
+      }
+    }
+    const float* data = m_Volume->d + run * runLength;
+    for (size_t offset = 0; offset < runLength; offset += VOLUME_EXPORT_BLOCK_SIZE)
+    {
+      size_t n = std::min(runLength - offset, static_cast<size_t>(VOLUME_EXPORT_BLOCK_SIZE));
+      const float* block = data + offset;
+      if(bigEndian == true)
+      {
+        for (size_t i = 0; i < n; ++i)
+        {
+          swapped[i] = block[i];
+          MXA::Endian::FromSystemToBig::convert<float>(swapped[i]);
+        }
+        block = &(swapped.front());
+      }
+      if(fwrite(block, sizeof(float), n, f) != n)
+      {
+        return -1;
+      }
+    }
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int VolumeExporter::writeMRCFile()
+{
+  std::stringstream ss;
+  ss << "Writing MRC file to '" << m_MRCOutputFile << "'";
+  notify(ss.str(), 0, Observable::UpdateProgressMessage);
+
+  FILE* f = openOutputFile(m_MRCOutputFile);
+  if(NULL == f)
+  {
+    return -1;
+  }
+
+  // The statistics cover every slab written so far
+  float dmin = m_Minimum;
+  float dmax = m_Maximum;
+  double mean = m_Mean;
+  if(m_OutputYSize > 0 && m_OutputYOffset > 0)
+  {
+    MRCHeader previous;
+    if(fread(&previous, 1, 1024, f) != 1024)
+    {
+      fclose(f);
+      return -1;
+    }
+    double rowsBefore = m_OutputYOffset;
+    double rows = m_YDims[1] - m_YDims[0];
+    dmin = std::min(dmin, previous.amin);
+    dmax = std::max(dmax, previous.amax);
+    mean = (previous.amean * rowsBefore + m_Mean * rows) / (rowsBefore + rows);
+    rewind(f);
+  }
+
+  // The MRCWriter knows how to fill in the rest of the header
+  MRCHeader header;
+  ::memset(&header, 0, 1024);
+  MRCWriter::Pointer mrcWriter = MRCWriter::New();
+  mrcWriter->setGeometry(getGeometry());
+  mrcWriter->initializeMRCHeader(&header);
+  header.nx = (m_XDims[1] - m_XDims[0]);
+  header.ny = outputRows();
+  header.nz = (m_ZDims[1] - m_ZDims[0]);
+  header.mx = header.nx;
+  header.my = header.ny;
+  header.mz = header.nz;
+  header.xlen = header.nx;
+  header.ylen = header.ny;
+  header.zlen = header.nz;
+  header.next = sizeof(FEIHeader) * header.nz;
+  header.amin = dmin;
+  header.amax = dmax;
+  header.amean = static_cast<float>(mean);
+
+  int err = 0;
+  if(fwrite(&header, 1, 1024, f) != 1024)
+  {
+    err = -1;
+  }
+  std::vector<FEIHeader> fei(header.nz);
+  if(err >= 0 && header.nz > 0)
+  {
+    ::memset(&(fei.front()), 0, sizeof(FEIHeader) * fei.size());
+    for (size_t i = 0; i < fei.size(); ++i)
+    {
+      fei[i].pixelsize = static_cast<float>(getGeometry()->LengthX);
+    }
+    if(fwrite(&(fei.front()), sizeof(FEIHeader), fei.size(), f) != fei.size())
+    {
+      err = -1;
+    }
+  }
+  if(err >= 0)
+  {
+    err = writeVolume(f, false);
+  }
+  if(fclose(f) != 0)
+  {
+    err = -1;
+  }
+  return err;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int VolumeExporter::writeVtkFile()
+{
+  std::stringstream ss;
+  ss << "Writing VTK file to '" << m_VtkOutputFile << "'";
+  notify(ss.str(), 0, Observable::UpdateProgressMessage);
+
+  // Only fixed size binary values can be placed into the rows of a slab
+  if(m_OutputYSize > 0 && m_WriteBinaryVtk == false)
+  {
+    return -1;
+  }
+  FILE* f = openOutputFile(m_VtkOutputFile);
+  if(NULL == f)
+  {
+    return -1;
+  }
+
+  DimsAndRes dimsAndRes;
+  dimsAndRes.xStart = m_XDims[0];
+  dimsAndRes.xEnd = m_XDims[1];
+  dimsAndRes.yStart = 0;
+  dimsAndRes.yEnd = outputRows();
+  dimsAndRes.zStart = m_ZDims[0];
+  dimsAndRes.zEnd = m_ZDims[1];
+  dimsAndRes.resx = 1.0f;
+  dimsAndRes.resy = 1.0f;
+  dimsAndRes.resz = 1.0f;
+  DimsAndRes* r = &dimsAndRes;
+  if(m_WriteBinaryVtk == true)
+  {
+    WRITE_STRUCTURED_POINTS_HEADER_2("BINARY", r)
+  }
+  else
+  {
+    WRITE_STRUCTURED_POINTS_HEADER_2("ASCII", r)
+  }
+  fprintf(f, "SCALARS %s float 1\n", MBIR::Defaults::VTK::TomoVoxelScalarName.c_str());
+  fprintf(f, "LOOKUP_TABLE default\n");
+
+  int err = 0;
+  if(m_WriteBinaryVtk == true)
+  {
+    err = writeVolume(f, true);
+  }
+  else
+  {
+    // Format a whole row before handing it to the stream
+    size_t* dims = m_Volume->getDims();
+    std::string row;
+    char value[64];
+    const float* data = m_Volume->d;
+    for (size_t i = 0; i < dims[0] * dims[1] && err >= 0; ++i)
+    {
+      row.clear();
+      for (size_t x = 0; x < dims[2]; ++x)
+      {
+        int n = snprintf(value, 64, "%0.6f ", *data++);
+        row.append(value, n);
+      }
+      row.append("\n");
+      if(fwrite(row.data(), 1, row.size(), f) != row.size())
+      {
+        err = -1;
+      }
+    }
+  }
+  if(fclose(f) != 0)
+  {
+    err = -1;
+  }
+  return err;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int VolumeExporter::writeAvizoFile()
+{
+  std::stringstream ss;
+  ss << "Writing Avizo file to '" << m_AvizoOutputFile << "'";
+  notify(ss.str(), 0, Observable::UpdateProgressMessage);
+
+  FILE* f = openOutputFile(m_AvizoOutputFile);
+  if(NULL == f)
+  {
+    return -1;
+  }
+
+  AvizoUniformCoordinateWriter::Pointer avizoWriter = AvizoUniformCoordinateWriter::New();
+  avizoWriter->setTomoInputs(getTomoInputs());
+  avizoWriter->setXDims(m_XDims[0], m_XDims[1]);
+  avizoWriter->setYDims(0, outputRows());
+  avizoWriter->setZDims(m_ZDims[0], m_ZDims[1]);
+  avizoWriter->setWriteBinaryFile(true);
+  std::string header = avizoWriter->generateHeader();
+  header.append("@1\n");
+
+  int err = 0;
+  if(fwrite(header.data(), 1, header.size(), f) != header.size())
+  {
+    err = -1;
+  }
+  if(err >= 0)
+  {
+    err = writeVolume(f, false);
+  }
+  if(fclose(f) != 0)
+  {
+    err = -1;
+  }
+  return err;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void VolumeExporter::execute()
+{
+  setErrorCondition(0);
+  setErrorMessage("");
+  if(m_MRCOutputFile.empty() && m_VtkOutputFile.empty() && m_AvizoOutputFile.empty())
+  {
+    return;
+  }
+
+  convertVolume();
+
+  std::stringstream ss;
+  if(m_VtkOutputFile.empty() == false && writeVtkFile() < 0)
+  {
+    ss << "Error writing vtk file\n    '" << m_VtkOutputFile << "'" << std::endl;
+    setErrorCondition(-12);
+    notify(ss.str(), 0, Observable::UpdateErrorMessage);
+  }
+  if(m_MRCOutputFile.empty() == false && writeMRCFile() < 0)
+  {
+    ss.str("");
+    ss << "Error writing MRC file\n    '" << m_MRCOutputFile << "'" << std::endl;
+    setErrorCondition(-1);
+    notify(ss.str(), 0, Observable::UpdateErrorMessage);
+  }
+  if(m_AvizoOutputFile.empty() == false && writeAvizoFile() < 0)
+  {
+    ss.str("");
+    ss << "Error writing Avizo file\n    '" << m_AvizoOutputFile << "'" << std::endl;
+    setErrorCondition(-1);
+    notify(ss.str(), 0, Observable::UpdateErrorMessage);
+  }
+
+  // The converted volume is as large as the output files so do not hold on to it
+  m_Volume = FloatVolumeType::NullPointer();
+  if(getErrorCondition() >= 0)
+  {
+    notify("Done Writing the Output Files", 0, Observable::UpdateProgressMessage);
+  }
+}
@@ -0,0 +1,137 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef VOLUMEEXPORTER_H_
+#define VOLUMEEXPORTER_H_
+
+#include <stdio.h>
+
+#include <string>
+
+#include "MXA/Common/MXASetGetMacros.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/GenericFilters/TomoFilter.h"
+#include "MBIRLib/Reconstruction/ReconstructionStructures.h"
+
+/**
+ * @class VolumeExporter VolumeExporter.h MBIRLib/IOFilters/VolumeExporter.h
+ * @brief Writes the final reconstruction to every requested output format
+ * (MRC, VTK and Avizo) from a single pass over the volume. The cropped volume
+ * is converted to float once, one z plane per task, in the z descending, y, x
+ * order that all three formats share. The minimum, maximum and mean for the
+ * MRC header are gathered during the same pass so the header is complete
+ * before any data is written. Each file is then written as its header followed
+ * by the converted buffer in large blocks.
+ *
+ * When OutputYSize is set the volume is one Y slab of a larger output. The
+ * headers describe OutputYSize rows and the exported rows are written into
+ * every plane starting at row OutputYOffset. The slab at offset 0 creates the
+ * files and the later slabs, which must follow in order, update them.
+ */
+class MBIRLib_EXPORT VolumeExporter : public TomoFilter
+{
+  public:
+    MXA_SHARED_POINTERS(VolumeExporter)
+    MXA_STATIC_NEW_MACRO(VolumeExporter);
+    MXA_TYPE_MACRO_SUPER(VolumeExporter, TomoFilter)
+
+    virtual ~VolumeExporter();
+
+    MXA_INSTANCE_STRING_PROPERTY(MRCOutputFile)
+    MXA_INSTANCE_STRING_PROPERTY(VtkOutputFile)
+    MXA_INSTANCE_STRING_PROPERTY(AvizoOutputFile)
+    /** @brief Binary (big endian) VTK is written unless this is set to false */
+    MXA_INSTANCE_PROPERTY(bool, WriteBinaryVtk)
+    MXA_INSTANCE_VEC2_PROPERTY(uint16_t, XDims)
+    MXA_INSTANCE_VEC2_PROPERTY(uint16_t, YDims)
+    MXA_INSTANCE_VEC2_PROPERTY(uint16_t, ZDims)
+    /* Row of the output files the first exported y row goes to */
+    MXA_INSTANCE_PROPERTY(uint16_t, OutputYOffset)
+    /* Rows of the whole output files. 0 when the export is the whole output */
+    MXA_INSTANCE_PROPERTY(uint16_t, OutputYSize)
+
+    /* Statistics of the exported volume, valid after execute() */
+    MXA_INSTANCE_PROPERTY(float, Minimum)
+    MXA_INSTANCE_PROPERTY(float, Maximum)
+    MXA_INSTANCE_PROPERTY(float, Mean)
+
+    /**
+     * @brief Converts the volume and writes each output file that has been set.
+     * Nothing is converted if no output file is set.
+     */
+    virtual void execute();
+
+  protected:
+    VolumeExporter();
+
+    /**
+     * @brief Converts the cropped volume to float and computes its statistics
+     */
+    void convertVolume();
+
+    int writeMRCFile();
+    int writeVtkFile();
+    int writeAvizoFile();
+
+    /**
+     * @brief Rows of y in the output files
+     */
+    uint16_t outputRows();
+
+    /**
+     * @brief Opens an output file. A slab after the first one updates the
+     * file the first slab created.
+     */
+    FILE* openOutputFile(const std::string& filepath);
+
+    /**
+     * @brief Writes the converted volume in large blocks, optionally swapping
+     * each block to big endian on the way out. The header must already be
+     * written; the data starts at the current position of the file.
+     * @return Negative on error
+     */
+    int writeVolume(FILE* f, bool bigEndian);
+
+  private:
+    FloatVolumeType::Pointer m_Volume;
+
+    VolumeExporter(const VolumeExporter&); // Copy Constructor Not Implemented
+    void operator=(const VolumeExporter&); // Operator '=' Not Implemented
+};
+
+
+#endif /* VOLUMEEXPORTER_H_ */
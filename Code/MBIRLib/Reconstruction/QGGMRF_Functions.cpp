@@ -205,6 +205,36 @@ namespace QGGMRF
     return refValue;
   }
 
+  // -----------------------------------------------------------------------------
+  //
+  // -----------------------------------------------------------------------------
+  Real_t LocalCostChange(Real_t oldValue, Real_t newValue,
+                         uint8_t* boundaryFlag, Real_t* FILTER, Real_t* neighborhood,
+                         QGGMRF::QGGMRF_Values* qggmrf_values)
+  {
+    Real_t change = 0;
+    if(oldValue == newValue)
+    {
+      return change;
+    }
+    for (uint8_t i = 0; i < 3; i++)
+    {
+      for (uint8_t j = 0; j < 3; j++)
+      {
+        for (uint8_t k = 0; k < 3; k++)
+        {
+          if((i != 1 || j != 1 || k != 1) && boundaryFlag[INDEX_3(i, j, k)] == 1)
+          {
+            Real_t neighbor = neighborhood[INDEX_3(i, j, k)];
+            change += FILTER[INDEX_3(i, j, k)] * (QGGMRF::Value(newValue - neighbor, qggmrf_values)
+                                                  - QGGMRF::Value(oldValue - neighbor, qggmrf_values));
+          }
+        }
+      }
+    }
+    return change;
+  }
+
 
 
 } /* End Namespace */
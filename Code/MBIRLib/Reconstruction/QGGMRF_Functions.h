@@ -118,6 +118,21 @@ namespace QGGMRF
                                 Real_t THETA1, Real_t THETA2,
                                 QGGMRF_Values* qggmrf_values);
 
+  /**
+  * @brief Change in the prior model cost caused by changing a single voxel from
+  * oldValue to newValue. Only the cliques containing the voxel change so this
+  * only needs its 26 point neighborhood.
+  * @param oldValue
+  * @param newValue
+  * @param BOUNDARYFLAG
+  * @param FILTER
+  * @param NEIGHBORHOOD
+  * @param qggmrf_values
+  * @return
+  */
+  Real_t LocalCostChange(Real_t oldValue, Real_t newValue,
+                         uint8_t* BOUNDARYFLAG, Real_t* FILTER, Real_t* NEIGHBORHOOD,
+                         QGGMRF_Values* qggmrf_values);
 
 
 
@@ -71,12 +71,24 @@ namespace MBIR
 
 
 
+  namespace SnapshotPolicy
+  {
+    const unsigned int None = 0;             // No intermediate snapshots
+    const unsigned int EveryIteration = 1;   // One file per inner iteration
+    const unsigned int EveryNIterations = 2; // One file every snapshotInterval iterations
+    const unsigned int EveryNSeconds = 3;    // One file at most every snapshotInterval seconds
+    const unsigned int LatestOnly = 4;       // Every iteration, overwriting a single file
+  }
+
+
+
   namespace Constants
   {
     const unsigned int k_NumHomogeniousIter = 20;
     const unsigned int k_NumNonHomogeniousIter = 20;
     const Real_t k_QGGMRF_Gamma = 5.0;
     const Real_t k_MaxAngleStretch = 75.0;
+    const int k_CostResyncInterval = 5; //Voxel update passes between exact cost computations
   }
 
 
@@ -101,8 +113,8 @@ namespace MBIR
     const std::string ReconstructedSinogramFile("ReconstructedSinogram.bin");
     const std::string ReconstructedObjectFile("ReconstructedObject.bin");
     const std::string ReconstructedMrcFile("ReconstructedVolume.rec");
+    const std::string CheckpointFile("ReconstructionCheckpoint.h5");
 
-    const std::string UpsampledBinFile("UpsampledObject.bin");
 
     namespace VTK
     {
@@ -65,6 +65,17 @@
  Z
  */
 
+/**
+ * @brief Summary of the values of one tilt of a sinogram
+ */
+typedef struct
+{
+  Real_t Mean;
+  Real_t Min;
+  Real_t Max;
+  Real_t StdDev;
+} TiltCountStatistics;
+
 typedef struct
 {
   uint16_t N_r;//Number of measurements in x direction
@@ -74,6 +85,9 @@ typedef struct
   Real_t delta_t;//Distance between successive measurements along y
   RealVolumeType::Pointer counts;//The measured images should be stored in this once read from the input file. It will be a Ny X (Nz X Nx)
   std::vector<Real_t> angles;//Holds the angles through which the object is tilted
+  std::vector<TiltCountStatistics> rawStatistics;//Per tilt statistics of the counts as read from the file. Empty if the reader did not compute them
+  std::vector<TiltCountStatistics> logStatistics;//Per tilt statistics of the -log transformed counts. Empty until the counts have been log transformed
+  RealVolumeType::Pointer weights;//Per measurement weights of a sinogram aggregated from a finer one (see SinogramStatistics::binDetector). NULL when the weights follow from the counts
   Real_t R0;
   Real_t RMax;
   Real_t T0;
@@ -128,6 +142,7 @@ typedef struct
 
   Real_t interpolateFactor;
   Real_t defaultInitialRecon;
+  uint16_t NumSIRTIter; //Number of SIRT iterations used to refine the initial volume (0 = OFF)
 
   std::vector<float> tilts;
 
@@ -139,6 +154,13 @@ typedef struct
   std::string offsetsInputFile;
   std::string varianceInputFile;
 
+  /* In memory results of the previous resolution. When set these are used
+   * instead of the input files above */
+  RealVolumeType::Pointer initialRecon;
+  RealArrayType::Pointer initialGains;
+  RealArrayType::Pointer initialOffsets;
+  RealArrayType::Pointer initialVariances;
+
   /* These are output related files and parameters */
   std::string tempDir; // Output directory
   std::string reconstructedOutputFile;
@@ -150,6 +172,17 @@ typedef struct
   std::string avizoOutputFile;
   std::string braggSelectorFile;
   std::vector<std::string> tempFiles;
+  unsigned int snapshotPolicy; // Which intermediate volumes are written (see MBIR::SnapshotPolicy)
+  Real_t snapshotInterval; // Iterations or seconds between snapshots, depending on the policy
+  Real_t checkpointInterval; // Seconds between checkpoints. 0 only writes one when cancelled, < 0 disables them
+  std::string checkpointFile; // Where the checkpoints are written (see ReconstructionCheckpoint)
+  std::string resumeFile; // Checkpoint the reconstruction is restarted from
+  int resolution; // Index of the resolution being reconstructed, saved in the checkpoints
+  uint16_t slabHaloStart; // Leading y slices that only tie a Y slab to the slab before it through the prior
+  uint16_t slabHaloEnd; // Trailing y slices that only tie a Y slab to the slab after it through the prior
+  uint16_t slabOutputY; // First y slice of the output files the slab is written to
+  uint16_t slabOutputNy; // y slices of the whole output files. 0 when the volume is not a Y slab
+  bool fixedNuisanceParameters; // Keep the initial gains, offsets and variances instead of estimating them
 
   std::vector<uint8_t> excludedViews;// Indices of views to exclude from reconstruction
   std::vector<int> goodViews; // Contains the indices of the views to use for reconstruction
@@ -184,6 +217,9 @@ typedef struct
   unsigned int NOISE_MODEL; /* This is a parameter that the user MAY or MAY NOT
                 want turned ON. It is ON by default */
   unsigned int ESTIMATE_PRIOR;
+  unsigned int TRACK_COST; /* Tracks the cost through the voxel updates to check that it
+                              decreases. Off by default as every voxel update then evaluates
+                              its prior neighborhood a second time. On with COST_CALCULATE */
 } AdvancedParameters;
 typedef boost::shared_ptr<AdvancedParameters> AdvancedParametersPtr;
 
@@ -0,0 +1,519 @@
+/* ============================================================================
+ * Copyright (c) 2012 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2012 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include "SinogramStatistics.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "MBIRLib/Common/EIMMath.h"
+
+namespace Detail
+{
+  /**
+   * @brief Accumulates the TiltMoments of a single tilt
+   */
+  class TiltMomentsKernel
+  {
+    public:
+      TiltMomentsKernel(Real_t* counts, Real_t* error, Real_t* weight,
+                        const ImplicitWeight* implicitWeight,
+                        Real_t* i_0, Real_t* mu, BitVolume* selector,
+                        size_t sliceSize, TiltMoments* moments) :
+        m_Counts(counts), m_Error(error), m_Weight(weight),
+        m_ImplicitWeight(implicitWeight),
+        m_I_0(i_0), m_Mu(mu), m_Selector(selector),
+        m_SliceSize(sliceSize), m_Moments(moments)
+      {}
+
+      void operator()(uint16_t i_theta) const
+      {
+        size_t start = i_theta * m_SliceSize;
+        const Real_t* y = m_Counts + start;
+        const Real_t* e = m_Error + start;
+        const Real_t* w = (NULL == m_Weight) ? NULL : m_Weight + start;
+        //Implicit weights are only ever expanded one tilt at a time
+        std::vector<Real_t> tiltWeights;
+        if(NULL == w && NULL != m_ImplicitWeight)
+        {
+          tiltWeights.resize(m_SliceSize);
+          Real_t scale = m_ImplicitWeight->TiltScale[i_theta];
+          for (size_t i = 0; i < m_SliceSize; i++)
+          {
+            tiltWeights[i] = m_ImplicitWeight->Function(y[i]) * scale;
+          }
+          w = &(tiltWeights.front());
+        }
+
+        Real_t sumW = 0, sumWY = 0, sumWYY = 0, sumWE = 0, sumWEE = 0, sumEE = 0, sumEEOverY = 0;
+        Real_t sumWP = 0, sumWPY = 0, sumWPP = 0;
+        size_t numRejected = 0;
+        Real_t selW = 0, selWE = 0, selWEE = 0, rejSignSqrtW = 0, rejSqrtWOverAbsE = 0, rejAbsESqrtW = 0;
+
+        bool doProjection = (NULL != m_I_0 && NULL != m_Mu);
+        Real_t muTheta = doProjection ? m_Mu[i_theta] : 0.0;
+        Real_t invI_0 = doProjection ? 1.0 / m_I_0[i_theta] : 0.0;
+
+        for (size_t i = 0; i < m_SliceSize; i++)
+        {
+          Real_t wi = (NULL == w) ? 1.0 : w[i];
+          Real_t yi = y[i];
+          Real_t ei = e[i];
+          Real_t wy = wi * yi;
+          Real_t we = wi * ei;
+          sumW += wi;
+          sumWY += wy;
+          sumWYY += wy * yi;
+          sumWE += we;
+          sumWEE += we * ei;
+          sumEE += ei * ei;
+          sumEEOverY += (yi != 0) ? (ei * ei) / yi : ei * ei;
+
+          if(doProjection)
+          {
+            Real_t p = (yi - ei - muTheta) * invI_0;
+            Real_t wp = wi * p;
+            sumWP += wp;
+            sumWPY += wp * yi;
+            sumWPP += wp * p;
+          }
+
+          if(NULL != m_Selector)
+          {
+            if(m_Selector->getBit(start + i))
+            {
+              selW += wi;
+              selWE += we;
+              selWEE += we * ei;
+            }
+            else
+            {
+              Real_t sqrtW = sqrt(wi);
+              Real_t absE = fabs(ei);
+              numRejected++;
+              rejSignSqrtW += (ei / absE) * sqrtW;
+              rejSqrtWOverAbsE += sqrtW / absE;
+              rejAbsESqrtW += absE * sqrtW;
+            }
+          }
+        }
+
+        TiltMoments& m = m_Moments[i_theta];
+        m.SumW = sumW;
+        m.SumWY = sumWY;
+        m.SumWYY = sumWYY;
+        m.SumWE = sumWE;
+        m.SumWEE = sumWEE;
+        m.SumEE = sumEE;
+        m.SumEEOverY = sumEEOverY;
+        m.SumWP = sumWP;
+        m.SumWPY = sumWPY;
+        m.SumWPP = sumWPP;
+        m.NumRejected = numRejected;
+        m.SumSelectedW = selW;
+        m.SumSelectedWE = selWE;
+        m.SumSelectedWEE = selWEE;
+        m.SumRejectedSignSqrtW = rejSignSqrtW;
+        m.SumRejectedSqrtWOverAbsE = rejSqrtWOverAbsE;
+        m.SumRejectedAbsESqrtW = rejAbsESqrtW;
+      }
+
+    private:
+      Real_t* m_Counts;
+      Real_t* m_Error;
+      Real_t* m_Weight;
+      const ImplicitWeight* m_ImplicitWeight;
+      Real_t* m_I_0;
+      Real_t* m_Mu;
+      BitVolume* m_Selector;
+      size_t m_SliceSize;
+      TiltMoments* m_Moments;
+  };
+
+  /**
+   * @brief e = a * y + b * e + c for a single tilt
+   */
+  class AffineErrorKernel
+  {
+    public:
+      AffineErrorKernel(Real_t* counts, Real_t* error, size_t sliceSize,
+                        const Real_t* a, const Real_t* b, const Real_t* c) :
+        m_Counts(counts), m_Error(error), m_SliceSize(sliceSize), m_A(a), m_B(b), m_C(c)
+      {}
+
+      void operator()(uint16_t i_theta) const
+      {
+        size_t start = i_theta * m_SliceSize;
+        const Real_t* y = m_Counts + start;
+        Real_t* e = m_Error + start;
+        Real_t a = m_A[i_theta];
+        Real_t b = m_B[i_theta];
+        Real_t c = m_C[i_theta];
+        for (size_t i = 0; i < m_SliceSize; i++)
+        {
+          e[i] = a * y[i] + b * e[i] + c;
+        }
+      }
+
+    private:
+      Real_t* m_Counts;
+      Real_t* m_Error;
+      size_t m_SliceSize;
+      const Real_t* m_A;
+      const Real_t* m_B;
+      const Real_t* m_C;
+  };
+
+  /**
+   * @brief v = v * scale or v = value for a single tilt
+   */
+  class TiltValueKernel
+  {
+    public:
+      TiltValueKernel(Real_t* data, size_t sliceSize, const Real_t* values, bool scale) :
+        m_Data(data), m_SliceSize(sliceSize), m_Values(values), m_Scale(scale)
+      {}
+
+      void operator()(uint16_t i_theta) const
+      {
+        Real_t* v = m_Data + i_theta * m_SliceSize;
+        Real_t value = m_Values[i_theta];
+        if(m_Scale)
+        {
+          TomoArrayBulk::scale(v, m_SliceSize, value);
+        }
+        else
+        {
+          TomoArrayBulk::fill(v, m_SliceSize, value);
+        }
+      }
+
+    private:
+      Real_t* m_Data;
+      size_t m_SliceSize;
+      const Real_t* m_Values;
+      bool m_Scale;
+  };
+
+  /**
+   * @brief w = 1 / (y * alpha) for a single tilt
+   */
+  class InverseCountKernel
+  {
+    public:
+      InverseCountKernel(Real_t* counts, Real_t* weight, size_t sliceSize,
+                         const Real_t* alpha, Real_t zeroCountWeight) :
+        m_Counts(counts), m_Weight(weight), m_SliceSize(sliceSize),
+        m_Alpha(alpha), m_ZeroCountWeight(zeroCountWeight)
+      {}
+
+      void operator()(uint16_t i_theta) const
+      {
+        size_t start = i_theta * m_SliceSize;
+        const Real_t* y = m_Counts + start;
+        Real_t* w = m_Weight + start;
+        Real_t alpha = m_Alpha[i_theta];
+        for (size_t i = 0; i < m_SliceSize; i++)
+        {
+          w[i] = (alpha != 0 && y[i] != 0) ? 1.0 / (y[i] * alpha) : m_ZeroCountWeight;
+        }
+      }
+
+    private:
+      Real_t* m_Counts;
+      Real_t* m_Weight;
+      size_t m_SliceSize;
+      const Real_t* m_Alpha;
+      Real_t m_ZeroCountWeight;
+  };
+
+  /**
+   * @brief y = -log((y + offset) / normalization) for a single tilt along with
+   * the statistics of the values before and after the transform
+   */
+  class LogTransformKernel
+  {
+    public:
+      LogTransformKernel(Real_t* counts, size_t sliceSize, Real_t offset, Real_t normalization,
+                         TiltCountStatistics* rawStats, TiltCountStatistics* logStats, size_t* numNegative) :
+        m_Counts(counts), m_SliceSize(sliceSize), m_Offset(offset), m_Normalization(normalization),
+        m_RawStats(rawStats), m_LogStats(logStats), m_NumNegative(numNegative)
+      {}
+
+      void operator()(uint16_t i_theta) const
+      {
+        Real_t* y = m_Counts + i_theta * m_SliceSize;
+        TiltCountAccumulator raw;
+        TiltCountAccumulator logged;
+        size_t numNegative = 0;
+        for (size_t i = 0; i < m_SliceSize; i++)
+        {
+          if(NULL != m_RawStats) { raw.add(y[i]); }
+          if(y[i] + m_Offset < 0) { numNegative++; }
+          y[i] = SinogramStatistics::logCount(y[i], m_Offset, m_Normalization);
+          logged.add(y[i]);
+        }
+        if(NULL != m_RawStats) { m_RawStats[i_theta] = raw.getStatistics(); }
+        m_LogStats[i_theta] = logged.getStatistics();
+        m_NumNegative[i_theta] = numNegative;
+      }
+
+    private:
+      Real_t* m_Counts;
+      size_t m_SliceSize;
+      Real_t m_Offset;
+      Real_t m_Normalization;
+      TiltCountStatistics* m_RawStats;
+      TiltCountStatistics* m_LogStats;
+      size_t* m_NumNegative;
+  };
+
+  /**
+   * @brief Bins one tilt of the detector. The binned rows are accumulated one
+   * fine row at a time so the fine counts are read in memory order.
+   */
+  class DetectorBinningKernel
+  {
+    public:
+      DetectorBinningKernel(const Real_t* counts, uint16_t N_r, uint16_t N_t, unsigned int factor,
+                            Real_t (*weightFunction)(Real_t), Real_t* binnedCounts, Real_t* binnedWeights,
+                            TiltCountStatistics* logStats) :
+        m_Counts(counts), m_N_r(N_r), m_N_t(N_t), m_Factor(factor),
+        m_WeightFunction(weightFunction), m_BinnedCounts(binnedCounts), m_BinnedWeights(binnedWeights),
+        m_LogStats(logStats)
+      {}
+
+      void operator()(uint16_t i_theta) const
+      {
+        uint16_t binnedN_r = m_N_r / m_Factor;
+        uint16_t binnedN_t = m_N_t / m_Factor;
+        const Real_t* y = m_Counts + static_cast<size_t>(i_theta) * m_N_r * m_N_t;
+        Real_t* binnedY = m_BinnedCounts + static_cast<size_t>(i_theta) * binnedN_r * binnedN_t;
+        Real_t* binnedW = (NULL == m_BinnedWeights) ? NULL : m_BinnedWeights + static_cast<size_t>(i_theta) * binnedN_r * binnedN_t;
+        Real_t n = static_cast<Real_t>(m_Factor * m_Factor);
+        std::vector<Real_t> sumInverseW(binnedN_t);
+        TiltCountAccumulator logged;
+
+        for (uint16_t br = 0; br < binnedN_r; br++)
+        {
+          Real_t* rowY = binnedY + static_cast<size_t>(br) * binnedN_t;
+          ::memset(rowY, 0, binnedN_t * sizeof(Real_t));
+          std::fill(sumInverseW.begin(), sumInverseW.end(), 0.0);
+          for (unsigned int dr = 0; dr < m_Factor; dr++)
+          {
+            const Real_t* fineRow = y + static_cast<size_t>(br * m_Factor + dr) * m_N_t;
+            for (uint16_t i_t = 0; i_t < binnedN_t * m_Factor; i_t++)
+            {
+              rowY[i_t / m_Factor] += fineRow[i_t];
+              if(NULL != binnedW)
+              {
+                Real_t w = m_WeightFunction(fineRow[i_t]);
+                sumInverseW[i_t / m_Factor] += (w > 0) ? 1.0 / w : std::numeric_limits<Real_t>::infinity();
+              }
+            }
+          }
+          for (uint16_t bt = 0; bt < binnedN_t; bt++)
+          {
+            rowY[bt] /= n;
+            logged.add(rowY[bt]);
+            if(NULL != binnedW)
+            {
+              binnedW[static_cast<size_t>(br) * binnedN_t + bt] = n * n / sumInverseW[bt];
+            }
+          }
+        }
+        m_LogStats[i_theta] = logged.getStatistics();
+      }
+
+    private:
+      const Real_t* m_Counts;
+      uint16_t m_N_r;
+      uint16_t m_N_t;
+      unsigned int m_Factor;
+      Real_t (*m_WeightFunction)(Real_t);
+      Real_t* m_BinnedCounts;
+      Real_t* m_BinnedWeights;
+      TiltCountStatistics* m_LogStats;
+  };
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+SinogramStatistics::SinogramStatistics()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+SinogramStatistics::~SinogramStatistics()
+{
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void SinogramStatistics::computeTiltMoments(SinogramPtr sinogram,
+                                            RealVolumeType::Pointer errorSino,
+                                            RealVolumeType::Pointer weight,
+                                            RealArrayType::Pointer i_0,
+                                            RealArrayType::Pointer mu,
+                                            BitVolume::Pointer selector,
+                                            std::vector<TiltMoments>& moments,
+                                            const ImplicitWeight* implicitWeight)
+{
+  moments.resize(sinogram->N_theta);
+  ::memset(&(moments.front()), 0, moments.size() * sizeof(TiltMoments));
+  size_t sliceSize = sinogram->N_r * sinogram->N_t;
+  Detail::TiltMomentsKernel kernel(sinogram->counts->d,
+                                   errorSino->d,
+                                   (NULL == weight.get()) ? NULL : weight->d,
+                                   implicitWeight,
+                                   (NULL == i_0.get()) ? NULL : i_0->d,
+                                   (NULL == mu.get()) ? NULL : mu->d,
+                                   selector.get(),
+                                   sliceSize, &(moments.front()));
+  forEachTilt(sinogram->N_theta, kernel);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void SinogramStatistics::affineErrorUpdate(SinogramPtr sinogram,
+                                           RealVolumeType::Pointer errorSino,
+                                           const std::vector<Real_t>& countsCoeff,
+                                           const std::vector<Real_t>& errorCoeff,
+                                           const std::vector<Real_t>& constant)
+{
+  size_t sliceSize = sinogram->N_r * sinogram->N_t;
+  Detail::AffineErrorKernel kernel(sinogram->counts->d, errorSino->d, sliceSize,
+                                   &(countsCoeff.front()), &(errorCoeff.front()), &(constant.front()));
+  forEachTilt(sinogram->N_theta, kernel);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void SinogramStatistics::scaleTilts(RealVolumeType::Pointer volume, const std::vector<Real_t>& scale)
+{
+  size_t* dims = volume->getDims();
+  Detail::TiltValueKernel kernel(volume->d, dims[1] * dims[2], &(scale.front()), true);
+  forEachTilt(static_cast<uint16_t>(dims[0]), kernel);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void SinogramStatistics::fillTilts(RealVolumeType::Pointer volume, const std::vector<Real_t>& value)
+{
+  size_t* dims = volume->getDims();
+  Detail::TiltValueKernel kernel(volume->d, dims[1] * dims[2], &(value.front()), false);
+  forEachTilt(static_cast<uint16_t>(dims[0]), kernel);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+void SinogramStatistics::inverseCountWeights(SinogramPtr sinogram,
+                                             RealVolumeType::Pointer weight,
+                                             const std::vector<Real_t>& alpha,
+                                             Real_t zeroCountWeight)
+{
+  size_t sliceSize = sinogram->N_r * sinogram->N_t;
+  Detail::InverseCountKernel kernel(sinogram->counts->d, weight->d, sliceSize, &(alpha.front()), zeroCountWeight);
+  forEachTilt(sinogram->N_theta, kernel);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+size_t SinogramStatistics::logTransformCounts(SinogramPtr sinogram, Real_t offset, Real_t normalization)
+{
+  size_t sliceSize = sinogram->N_r * sinogram->N_t;
+  TiltCountStatistics* rawStats = NULL;
+  if(sinogram->rawStatistics.size() != sinogram->N_theta)
+  {
+    sinogram->rawStatistics.resize(sinogram->N_theta);
+    rawStats = &(sinogram->rawStatistics.front());
+  }
+  sinogram->logStatistics.resize(sinogram->N_theta);
+  std::vector<size_t> numNegative(sinogram->N_theta, 0);
+  Detail::LogTransformKernel kernel(sinogram->counts->d, sliceSize, offset, normalization,
+                                    rawStats, &(sinogram->logStatistics.front()), &(numNegative.front()));
+  forEachTilt(sinogram->N_theta, kernel);
+
+  size_t total = 0;
+  for (uint16_t i_theta = 0; i_theta < sinogram->N_theta; i_theta++)
+  {
+    total += numNegative[i_theta];
+  }
+  return total;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+SinogramPtr SinogramStatistics::binDetector(SinogramPtr sinogram, unsigned int factor, Real_t (*weightFunction)(Real_t counts))
+{
+  SinogramPtr binned = SinogramPtr(new Sinogram);
+  *binned = *sinogram;
+  binned->N_r = sinogram->N_r / factor;
+  binned->N_t = sinogram->N_t / factor;
+  binned->delta_r = sinogram->delta_r * factor;
+  binned->delta_t = sinogram->delta_t * factor;
+  binned->R0 = -(binned->N_r * binned->delta_r) / 2;
+  binned->RMax = (binned->N_r * binned->delta_r) / 2;
+  binned->T0 = -(binned->N_t * binned->delta_t) / 2;
+  binned->TMax = (binned->N_t * binned->delta_t) / 2;
+
+  size_t dims[3] = { binned->N_theta, binned->N_r, binned->N_t };
+  binned->counts = RealVolumeType::New(dims, "Binned Sinogram");
+  binned->weights = RealVolumeType::NullPointer();
+  if(NULL != weightFunction)
+  {
+    binned->weights = RealVolumeType::New(dims, "Binned Sinogram Weights");
+  }
+  binned->logStatistics.resize(binned->N_theta);
+
+  Detail::DetectorBinningKernel kernel(sinogram->counts->d, sinogram->N_r, sinogram->N_t, factor, weightFunction,
+                                       binned->counts->d,
+                                       (NULL == binned->weights.get()) ? NULL : binned->weights->d,
+                                       &(binned->logStatistics.front()));
+  forEachTilt(binned->N_theta, kernel);
+  return binned;
+}
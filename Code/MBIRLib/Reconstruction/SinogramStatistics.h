@@ -0,0 +1,288 @@
+/* ============================================================================
+ * Copyright (c) 2012 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2012 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _SinogramStatistics_H_
+#define _SinogramStatistics_H_
+
+#include <limits>
+#include <vector>
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/EIMMath.h"
+#include "MBIRLib/Common/BitVolume.h"
+#include "MBIRLib/Reconstruction/ReconstructionStructures.h"
+
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+#include <tbb/task_group.h>
+#endif
+
+/**
+ * @brief Per tilt sums over the (r,t) plane of the sinogram. y is the measured
+ * count, e the error sinogram, w the weight and p = (y - e - mu) / I_0 the
+ * current forward projection A*x. Only the sums whose inputs were supplied to
+ * SinogramStatistics::computeTiltMoments are filled in; the rest stay zero.
+ */
+typedef struct
+{
+  Real_t SumW;    // sum(w)
+  Real_t SumWY;   // sum(w*y)
+  Real_t SumWYY;  // sum(w*y*y)
+  Real_t SumWE;   // sum(w*e)
+  Real_t SumWEE;  // sum(w*e*e)
+  Real_t SumEE;   // sum(e*e)
+  Real_t SumEEOverY; // sum(e*e/y), e*e where y is zero
+
+  /* Only when I_0 and Mu are supplied */
+  Real_t SumWP;   // sum(w*p)
+  Real_t SumWPY;  // sum(w*p*y)
+  Real_t SumWPP;  // sum(w*p*p)
+
+  /* Only when a Bragg selector is supplied */
+  size_t NumRejected;          // count(selector == 0)
+  Real_t SumSelectedW;         // sum(w)           where selector == 1
+  Real_t SumSelectedWE;        // sum(w*e)         where selector == 1
+  Real_t SumSelectedWEE;       // sum(w*e*e)       where selector == 1
+  Real_t SumRejectedSignSqrtW; // sum(sign(e)*sqrt(w)) where selector == 0
+  Real_t SumRejectedSqrtWOverAbsE; // sum(sqrt(w)/|e|) where selector == 0
+  Real_t SumRejectedAbsESqrtW; // sum(|e|*sqrt(w))  where selector == 0
+} TiltMoments;
+
+
+/**
+ * @brief Describes weights that are computed from the counts when they are
+ * needed instead of being stored: w = Function(y) * TiltScale[i_theta]
+ */
+typedef struct
+{
+  Real_t (*Function)(Real_t counts);
+  const Real_t* TiltScale;
+} ImplicitWeight;
+
+
+/**
+ * @brief Single pass accumulator for TiltCountStatistics. The values are
+ * shifted by the first value added so the variance does not lose precision
+ * when the mean is large compared to the spread (e.g. offset raw counts).
+ */
+class TiltCountAccumulator
+{
+  public:
+    TiltCountAccumulator() :
+      m_Count(0), m_Shift(0), m_Sum(0), m_SumSq(0),
+      m_Min(std::numeric_limits<Real_t>::infinity()),
+      m_Max(-std::numeric_limits<Real_t>::infinity())
+    {}
+
+    void add(Real_t value)
+    {
+      if(m_Count == 0) { m_Shift = value; }
+      Real_t d = value - m_Shift;
+      m_Sum += d;
+      m_SumSq += d * d;
+      if(value < m_Min) { m_Min = value; }
+      if(value > m_Max) { m_Max = value; }
+      m_Count++;
+    }
+
+    TiltCountStatistics getStatistics() const
+    {
+      TiltCountStatistics stats;
+      stats.Mean = 0;
+      stats.StdDev = 0;
+      stats.Min = m_Min;
+      stats.Max = m_Max;
+      if(m_Count > 0)
+      {
+        Real_t mean = m_Sum / m_Count;
+        Real_t variance = m_SumSq / m_Count - mean * mean;
+        stats.Mean = m_Shift + mean;
+        stats.StdDev = (variance > 0) ? sqrt(variance) : 0;
+      }
+      return stats;
+    }
+
+  private:
+    size_t m_Count;
+    Real_t m_Shift;
+    Real_t m_Sum;
+    Real_t m_SumSq;
+    Real_t m_Min;
+    Real_t m_Max;
+};
+
+
+/**
+ * @class SinogramStatistics SinogramStatistics.h MBIRLib/Reconstruction/SinogramStatistics.h
+ * @brief Single pass, parallel over tilt, kernels that the nuisance parameter
+ * estimators, the noise model and the cost functions share. Each tilt is an
+ * independent contiguous (r,t) slab of the sinogram so one task is run per
+ * tilt and the per tilt results are combined serially by the caller.
+ * @author Michael A. Jackson for BlueQuartz Software
+ * @author Singanallur Venkatakrishnan (Purdue University)
+ * @version 1.0
+ */
+class MBIRLib_EXPORT SinogramStatistics
+{
+  public:
+    virtual ~SinogramStatistics();
+
+    /**
+     * @brief Runs kernel(i_theta) for every tilt, in parallel if available.
+     * The kernel must only touch the data belonging to its own tilt.
+     */
+    template<typename Kernel>
+    static void forEachTilt(uint16_t numTilts, const Kernel& kernel)
+    {
+#if defined (OpenMBIR_USE_PARALLEL_ALGORITHMS)
+      tbb::task_group* g = new tbb::task_group;
+      for (uint16_t i_theta = 0; i_theta < numTilts; i_theta++)
+      {
+        g->run(TiltTask<Kernel>(&kernel, i_theta));
+      }
+      g->wait(); // Wait for all the threads to complete before moving on.
+      delete g;
+#else
+      for (uint16_t i_theta = 0; i_theta < numTilts; i_theta++)
+      {
+        kernel(i_theta);
+      }
+#endif
+    }
+
+    /**
+     * @brief Computes the TiltMoments of every tilt in one pass over the data.
+     * @param sinogram Supplies the counts (y) and dimensions
+     * @param errorSino The error sinogram (e)
+     * @param weight The weights (w). If NULL the implicit weights are used.
+     * @param i_0 The gains. If NULL (or mu is NULL) the p sums are skipped
+     * @param mu The offsets
+     * @param selector The Bragg selector. If NULL the selector sums are skipped
+     * @param moments Resized to N_theta and filled
+     * @param implicitWeight Used when weight is NULL. If this is also NULL all
+     * weights are taken as 1.
+     */
+    static void computeTiltMoments(SinogramPtr sinogram,
+                                   RealVolumeType::Pointer errorSino,
+                                   RealVolumeType::Pointer weight,
+                                   RealArrayType::Pointer i_0,
+                                   RealArrayType::Pointer mu,
+                                   BitVolume::Pointer selector,
+                                   std::vector<TiltMoments>& moments,
+                                   const ImplicitWeight* implicitWeight = NULL);
+
+    /**
+     * @brief Updates the error sinogram in place with a per tilt affine map
+     * e = countsCoeff * y + errorCoeff * e + constant. This covers both the
+     * gain/offset re-projection and the offset only update.
+     */
+    static void affineErrorUpdate(SinogramPtr sinogram,
+                                  RealVolumeType::Pointer errorSino,
+                                  const std::vector<Real_t>& countsCoeff,
+                                  const std::vector<Real_t>& errorCoeff,
+                                  const std::vector<Real_t>& constant);
+
+    /**
+     * @brief Multiplies every entry of each tilt of a sinogram sized volume by scale[i_theta]
+     */
+    static void scaleTilts(RealVolumeType::Pointer volume, const std::vector<Real_t>& scale);
+
+    /**
+     * @brief Sets every entry of each tilt of a sinogram sized volume to value[i_theta]
+     */
+    static void fillTilts(RealVolumeType::Pointer volume, const std::vector<Real_t>& value);
+
+    /**
+     * @brief Computes the Poisson weights w = 1 / (y * alpha[i_theta]). Entries
+     * where y or alpha is zero are set to zeroCountWeight.
+     */
+    static void inverseCountWeights(SinogramPtr sinogram,
+                                    RealVolumeType::Pointer weight,
+                                    const std::vector<Real_t>& alpha,
+                                    Real_t zeroCountWeight);
+
+    /**
+     * @brief The bright field log transform of a single raw count
+     */
+    static inline Real_t logCount(Real_t counts, Real_t offset, Real_t normalization)
+    {
+      return -log((counts + offset) / normalization);
+    }
+
+    /**
+     * @brief Replaces the counts by logCount(y, offset, normalization) in one
+     * parallel pass and fills sinogram->logStatistics. sinogram->rawStatistics
+     * is filled in the same pass if the reader did not already do so.
+     * @return The number of entries where y + offset was negative
+     */
+    static size_t logTransformCounts(SinogramPtr sinogram, Real_t offset, Real_t normalization);
+
+    /**
+     * @brief Bins the detector of a sinogram (log transformed bright field or
+     * HAADF counts) by factor x factor pixels in (r,t). A binned measurement is
+     * the mean of its n = factor^2 measurements so that it is still modelled by
+     * the mean of their projections.
+     * Its weight is the inverse variance of that mean, n^2 / sum(1/w_i), where
+     * w_i = weightFunction(y_i). The weights are stored in the returned
+     * sinogram's weights volume. The angles and raw statistics are copied and
+     * the log statistics are recomputed for the binned counts.
+     * @param sinogram The sinogram to bin. N_r and N_t must be multiples of factor
+     * @param factor The number of detector pixels binned along r and along t
+     * @param weightFunction Computes the weight of a single measurement. If NULL
+     * the binned sinogram does not carry weights
+     * @return The binned sinogram
+     */
+    static SinogramPtr binDetector(SinogramPtr sinogram, unsigned int factor, Real_t (*weightFunction)(Real_t counts));
+
+  protected:
+    SinogramStatistics();
+
+  private:
+    template<typename Kernel>
+    class TiltTask
+    {
+      public:
+        TiltTask(const Kernel* kernel, uint16_t tilt) : m_Kernel(kernel), m_Tilt(tilt) {}
+        void operator()() const { (*m_Kernel)(m_Tilt); }
+      private:
+        const Kernel* m_Kernel;
+        uint16_t m_Tilt;
+    };
+
+    SinogramStatistics(const SinogramStatistics&); // Copy Constructor Not Implemented
+    void operator=(const SinogramStatistics&); // Operator '=' Not Implemented
+};
+
+#endif /* _SinogramStatistics_H_ */
@@ -13,6 +13,7 @@
 set(MBIRLib_Reconstruction_SRCS
     ${MBIRLib_SOURCE_DIR}/Reconstruction/ReconstructionInputs.cpp
     ${MBIRLib_SOURCE_DIR}/Reconstruction/QGGMRF_Functions.cpp
+    ${MBIRLib_SOURCE_DIR}/Reconstruction/SinogramStatistics.cpp
 )
 
 set(MBIRLib_Reconstruction_HDRS
@@ -20,6 +21,7 @@ set(MBIRLib_Reconstruction_HDRS
     ${MBIRLib_SOURCE_DIR}/Reconstruction/ReconstructionStructures.h
     ${MBIRLib_SOURCE_DIR}/Reconstruction/ReconstructionConstants.h
     ${MBIRLib_SOURCE_DIR}/Reconstruction/QGGMRF_Functions.h
+    ${MBIRLib_SOURCE_DIR}/Reconstruction/SinogramStatistics.h
 )
 
 cmp_IDE_SOURCE_PROPERTIES( "MBIRLib/Reconstruction" "${MBIRLib_Reconstruction_HDRS}" "${MBIRLib_Reconstruction_SRCS}" "${CMP_INSTALL_FILES}")
@@ -56,6 +56,7 @@
 #include "MBIRLib/MBIRLibVersion.h"
 #include "MBIRLib/IOFilters/MRCHeader.h"
 #include "MBIRLib/IOFilters/MRCReader.h"
+#include "MBIRLib/IOFilters/MRCStatisticsIndex.h"
 
 #define GRAY_SCALE 1
 
@@ -391,6 +392,8 @@ void QMRCDisplayWidget::loadMRCFile(QString mrcFilePath)
     return;
   }
   resetImageScaling();
+  // Loading a file always rereads its header in case it changed on disk
+  m_MRCFile = MRCFile::NullPointer();
   loadMRCTiltImage(m_CurrentMRCFilePath, 0);
   on_fitToWindow_clicked();
 }
@@ -420,18 +423,15 @@ void QMRCDisplayWidget::loadMRCTiltImage(QString mrcFilePath, int tiltIndex)
 
   QImage image;
 
-  MRCHeader header;
-  ::memset(&header, 0, sizeof(MRCHeader));
-  MRCReader::Pointer reader = MRCReader::New(true);
-  // Read the header from the file
-  int err = reader->readHeader(mrcFilePath.toStdString(), &header);
-  if(err < 0)
+  // The header is only read when a different file is opened
+  MRCFile::Pointer mrcFile = getMRCFile(mrcFilePath);
+  if(NULL == mrcFile.get())
   {
     QString str = QString("The MRC file could not be loaded. ") + QString(mrcFilePath) + QString("\nThe file path may not have been written correctly, or the file path does not exist. ");
     QMessageBox::critical(this, tr("MRC File Load Error"), str , QMessageBox::Ok);
-    FREE_FEI_HEADERS( header.feiHeaders)
     return;
   }
+  MRCHeader& header = *(mrcFile->getHeader());
 
   QDoubleValidator* validator = NULL;
   switch(header.mode)
@@ -464,24 +464,21 @@ void QMRCDisplayWidget::loadMRCTiltImage(QString mrcFilePath, int tiltIndex)
   currentTiltIndex->setValue(tiltIndex);
   currentTiltIndex->blockSignals(false);
 
-  m_HeaderMinimum = header.amin;
-  m_HeaderMaximum = header.amax;
-
   if (minimumField->text() == "")
   {
-    minimumField->setText(QString::number(header.amin));
+    minimumField->setText(QString::number(m_HeaderMinimum));
   }
   if (maximumField->text() == "")
   {
-    maximumField->setText(QString::number(header.amax));
+    maximumField->setText(QString::number(m_HeaderMaximum));
   }
 
   if (minimumField->text().toFloat() > maximumField->text().toFloat())
   {
     QString str = QString("The image could not be updated.\nThe minimum and maximum bounds have exceeded each other. ");
     QMessageBox::critical(this, tr("MRC Image Update Error"), str , QMessageBox::Ok);
-    minimumField->setText(QString::number(header.amin));
-    maximumField->setText(QString::number(header.amax));
+    minimumField->setText(QString::number(m_HeaderMinimum));
+    maximumField->setText(QString::number(m_HeaderMaximum));
     return;
   }
 
@@ -507,13 +504,9 @@ void QMRCDisplayWidget::loadMRCTiltImage(QString mrcFilePath, int tiltIndex)
   }
   */
 
-  // Read the first image from the file
-  int voxelMin[3] =
-  { 0, 0, tiltIndex };
-  int voxelMax[3] =
-  { header.nx - 1, header.ny - 1, tiltIndex };
-
-  err = reader->read(mrcFilePath.toStdString(), voxelMin, voxelMax);
+  // Read the requested tilt into the reused section buffer
+  m_SectionBuffer.resize(mrcFile->getSectionSize());
+  int err = mrcFile->readSection(tiltIndex, &(m_SectionBuffer.front()));
 
   if(err >= 0)
   {
@@ -522,21 +515,19 @@ void QMRCDisplayWidget::loadMRCTiltImage(QString mrcFilePath, int tiltIndex)
       case 0:
         break;
       case 1:
-        image = signed16Image(reinterpret_cast<qint16*>(reader->getDataPointer()), header, true);
+        image = signed16Image(reinterpret_cast<qint16*>(&(m_SectionBuffer.front())), header, true);
         break;
       case 2:
-        image = floatImage(reinterpret_cast<float*>(reader->getDataPointer()), header, true);
+        image = floatImage(reinterpret_cast<float*>(&(m_SectionBuffer.front())), header, true);
         break;
       case 6:
-        image = unsigned16Image(reinterpret_cast<quint16*>(reader->getDataPointer()), header, true);
+        image = unsigned16Image(reinterpret_cast<quint16*>(&(m_SectionBuffer.front())), header, true);
         break;
       default:
         break;
     }
   }
 
-  FREE_FEI_HEADERS( header.feiHeaders)
-
   drawOrigin(image);
 
   // This will display the image in the graphics scene
@@ -553,6 +544,44 @@ void QMRCDisplayWidget::loadMRCTiltImage(QString mrcFilePath, int tiltIndex)
   if (m_MovieWidgetsEnabled == true) { showWidgets(true, m_MovieWidgets); }
 }
 
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+MRCFile::Pointer QMRCDisplayWidget::getMRCFile(QString mrcFilePath)
+{
+  std::string path = mrcFilePath.toStdString();
+  if (NULL != m_MRCFile.get() && m_MRCFile->isOpen() && m_MRCFile->getFilePath() == path)
+  {
+    return m_MRCFile;
+  }
+  m_MRCFile = MRCFile::New();
+  // Stepping through the tilts is the common case so have the next ones ready
+  m_MRCFile->setReadAheadSections(2);
+  if (m_MRCFile->open(path) < 0)
+  {
+    m_MRCFile = MRCFile::NullPointer();
+    return m_MRCFile;
+  }
+  // The range in the header is often not filled in so the display range comes
+  // from the statistics sidecar, which is only computed the first time a file is opened
+  MRCHeader* header = m_MRCFile->getHeader();
+  m_HeaderMinimum = header->amin;
+  m_HeaderMaximum = header->amax;
+  std::vector<MRCSectionStatistics> stats;
+  MRCStatisticsIndex::Pointer index = MRCStatisticsIndex::New();
+  if (index->getStatistics(m_MRCFile, NULL, NULL, stats) >= 0 && stats.size() > 0)
+  {
+    m_HeaderMinimum = stats[0].Min;
+    m_HeaderMaximum = stats[0].Max;
+    for (size_t z = 1; z < stats.size(); ++z)
+    {
+      if (stats[z].Min < m_HeaderMinimum) { m_HeaderMinimum = stats[z].Min; }
+      if (stats[z].Max > m_HeaderMaximum) { m_HeaderMaximum = stats[z].Max; }
+    }
+  }
+  return m_MRCFile;
+}
+
 // -----------------------------------------------------------------------------
 //
 // -----------------------------------------------------------------------------
@@ -1092,16 +1121,13 @@ void QMRCDisplayWidget::loadXZSliceReconstruction(QString reconMRCFilePath)
     }
   }
 
-  m_HeaderMinimum = header.amin;
-  m_HeaderMaximum = header.amax;
-
   if (minimumField->text() == "")
   {
-    minimumField->setText(QString::number(header.amin));
+    minimumField->setText(QString::number(m_HeaderMinimum));
   }
   if (maximumField->text() == "")
   {
-    maximumField->setText(QString::number(header.amax));
+    maximumField->setText(QString::number(m_HeaderMaximum));
   }
 
 
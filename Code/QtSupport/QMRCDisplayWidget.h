@@ -49,6 +49,7 @@
 #include "ui_QMRCDisplayWidget.h"
 #include "MBIRLib/MBIRLib.h"
 #include "MBIRLib/IOFilters/MRCHeader.h"
+#include "MBIRLib/IOFilters/MRCFile.h"
 
 
 class QTimer;
@@ -83,6 +84,12 @@ class QMRCDisplayWidget : public QWidget, private Ui::QMRCDisplayWidget
 
     QString getMRCFilePath();
 
+    /**
+     * @brief Returns the open session for the given file, opening it only if it
+     * is not the file that is already open. Returns a NULL pointer on error.
+     */
+    MRCFile::Pointer getMRCFile(QString mrcFilePath);
+
     QSpinBox* getCurrentTiltIndexBox();
 
     QTabWidget* getControlsTab();
@@ -165,6 +172,8 @@ class QMRCDisplayWidget : public QWidget, private Ui::QMRCDisplayWidget
     bool                  m_DrawOrigin;
     bool                  m_BackgroundSelection;
     RectangleCreator*     m_BackgroundRectangle;
+    MRCFile::Pointer      m_MRCFile;           // Stays open while tilts of the same file are displayed
+    std::vector<uint8_t>  m_SectionBuffer;
 
 
 
@@ -0,0 +1,215 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <vector>
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/IOFilters/MRCHeader.h"
+#include "MBIRLib/IOFilters/MRCReader.h"
+
+#include "UnitTestSupport.h"
+
+namespace Detail
+{
+  /* FEI files are padded to this many extended header records */
+  const int NumPaddedRecords = 1024;
+
+  void InitHeader(MRCHeader& header, int nz, const char* label)
+  {
+    ::memset(&header, 0, 1024);
+    header.feiHeaders = NULL;
+    header.nx = 8;
+    header.ny = 8;
+    header.nz = nz;
+    header.mode = 1;
+    header.nLabels = 1;
+    ::strncpy(header.labels[0], label, 79);
+  }
+
+  /**
+   * @brief An extended header of NumPaddedRecords records where record i has
+   * a_tilt = i. The records past the sections are not zero to show that they
+   * are not copied.
+   */
+  std::vector<uint8_t> CreatePaddedExtendedHeader(MRCHeader& header)
+  {
+    std::vector<uint8_t> extendedHeader(sizeof(FEIHeader) * NumPaddedRecords, 0);
+    for (int i = 0; i < NumPaddedRecords; ++i)
+    {
+      FEIHeader fei;
+      ::memset(&fei, 0, sizeof(FEIHeader));
+      fei.a_tilt = static_cast<float>(i);
+      fei.pixelsize = 1.5f;
+      ::memcpy(&(extendedHeader[sizeof(FEIHeader) * i]), &fei, sizeof(FEIHeader));
+    }
+    header.next = static_cast<int>(extendedHeader.size());
+    return extendedHeader;
+  }
+
+  FEIHeader GetRecord(const std::vector<uint8_t>& extendedHeader, size_t index)
+  {
+    FEIHeader fei;
+    ::memcpy(&fei, &(extendedHeader[sizeof(FEIHeader) * index]), sizeof(FEIHeader));
+    return fei;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestHasFEIHeaders()
+{
+  int failures = 0;
+  MRCHeader header;
+  Detail::InitHeader(header, 5, "Fei Company (C) Copyright 2003");
+  TEST_CHECK(MRCReader::hasFEIHeaders(&header));
+  Detail::InitHeader(header, 5, "MCAP project, MDG, Copyright 2013");
+  TEST_CHECK(MRCReader::hasFEIHeaders(&header));
+  Detail::InitHeader(header, 5, "tif2mrc: Converted to MRC format.");
+  TEST_CHECK(MRCReader::hasFEIHeaders(&header) == false);
+  Detail::InitHeader(header, 5, "Some other writer");
+  TEST_CHECK(MRCReader::hasFEIHeaders(&header) == false);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestParsePaddedFEIHeaders()
+{
+  int failures = 0;
+  MRCHeader header;
+  Detail::InitHeader(header, 5, "Fei Company (C) Copyright 2003");
+  std::vector<uint8_t> extendedHeader = Detail::CreatePaddedExtendedHeader(header);
+  MRCReader::parseFEIHeaders(&header, extendedHeader);
+  TEST_CHECK(NULL != header.feiHeaders);
+  if(NULL != header.feiHeaders)
+  {
+    TEST_CHECK(header.feiHeaders[4].a_tilt == 4.0f);
+  }
+
+  // Too short an extended header is not read past its end
+  extendedHeader.resize(sizeof(FEIHeader) * 4);
+  MRCReader::parseFEIHeaders(&header, extendedHeader);
+  TEST_CHECK(NULL == header.feiHeaders);
+  FREE_FEI_HEADERS(header.feiHeaders)
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestSubsetPaddedFEIHeaders()
+{
+  int failures = 0;
+  MRCHeader header;
+  Detail::InitHeader(header, 5, "Fei Company (C) Copyright 2003");
+  std::vector<uint8_t> extendedHeader = Detail::CreatePaddedExtendedHeader(header);
+
+  // Views 1 and 3 are excluded and the pixels are binned by 2
+  std::vector<int> sections;
+  sections.push_back(0);
+  sections.push_back(2);
+  sections.push_back(4);
+  std::vector<uint8_t> output;
+  TEST_CHECK(MRCReader::subsetFEIHeaders(&header, extendedHeader, sections, 2.0f, output) == 0);
+  TEST_CHECK(output.size() == extendedHeader.size());
+  if(failures > 0)
+  {
+    return failures;
+  }
+  for (size_t i = 0; i < sections.size(); ++i)
+  {
+    FEIHeader fei = Detail::GetRecord(output, i);
+    TEST_CHECK(fei.a_tilt == static_cast<float>(sections[i]));
+    TEST_CHECK(fei.pixelsize == 3.0f);
+  }
+  FEIHeader padding = Detail::GetRecord(output, 3);
+  TEST_CHECK(padding.a_tilt == 0.0f && padding.pixelsize == 0.0f);
+  padding = Detail::GetRecord(output, Detail::NumPaddedRecords - 1);
+  TEST_CHECK(padding.a_tilt == 0.0f && padding.pixelsize == 0.0f);
+
+  // A file whose extended header is exactly one record per section
+  extendedHeader.resize(sizeof(FEIHeader) * 5);
+  header.next = static_cast<int>(extendedHeader.size());
+  TEST_CHECK(MRCReader::subsetFEIHeaders(&header, extendedHeader, sections, 1.0f, output) == 0);
+  TEST_CHECK(output.size() == sizeof(FEIHeader) * 5);
+  TEST_CHECK(Detail::GetRecord(output, 2).pixelsize == 1.5f);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestSubsetInvalidFEIHeaders()
+{
+  int failures = 0;
+  MRCHeader header;
+  Detail::InitHeader(header, 5, "Fei Company (C) Copyright 2003");
+  std::vector<uint8_t> extendedHeader = Detail::CreatePaddedExtendedHeader(header);
+  std::vector<int> sections(1, 5);
+  std::vector<uint8_t> output;
+  TEST_CHECK(MRCReader::subsetFEIHeaders(&header, extendedHeader, sections, 1.0f, output) < 0);
+
+  // Fewer records than sections
+  sections[0] = 0;
+  extendedHeader.resize(sizeof(FEIHeader) * 4);
+  header.next = static_cast<int>(extendedHeader.size());
+  TEST_CHECK(MRCReader::subsetFEIHeaders(&header, extendedHeader, sections, 1.0f, output) < 0);
+
+  // Not an FEI file
+  Detail::InitHeader(header, 5, "tif2mrc: Converted to MRC format.");
+  extendedHeader = Detail::CreatePaddedExtendedHeader(header);
+  TEST_CHECK(MRCReader::subsetFEIHeaders(&header, extendedHeader, sections, 1.0f, output) < 0);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int failures = 0;
+  TEST_RUN(TestHasFEIHeaders)
+  TEST_RUN(TestParsePaddedFEIHeaders)
+  TEST_RUN(TestSubsetPaddedFEIHeaders)
+  TEST_RUN(TestSubsetInvalidFEIHeaders)
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
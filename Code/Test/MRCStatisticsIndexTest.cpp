@@ -0,0 +1,222 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MXA/Utilities/MXADir.h"
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/IOFilters/MRCHeader.h"
+#include "MBIRLib/IOFilters/MRCFile.h"
+#include "MBIRLib/IOFilters/MRCStatisticsIndex.h"
+
+#include "UnitTestSupport.h"
+
+namespace Detail
+{
+  const std::string MRCTestFile("MRCStatisticsIndexTest.mrc");
+
+  /**
+   * @brief Writes a float MRC file with nz sections of nx * ny values where
+   * value = 100 * z + nx * y + x
+   */
+  bool WriteMRCFile(const std::string& path, int nx, int ny, int nz)
+  {
+    MRCHeader header;
+    ::memset(&header, 0, sizeof(MRCHeader));
+    header.nx = nx;
+    header.ny = ny;
+    header.nz = nz;
+    header.mode = 2;
+    header.mx = nx;
+    header.my = ny;
+    header.mz = nz;
+    header.mapc = 1;
+    header.mapr = 2;
+    header.maps = 3;
+    FILE* f = fopen(path.c_str(), "wb");
+    if(NULL == f)
+    {
+      return false;
+    }
+    bool ok = fwrite(&header, 1, 1024, f) == 1024;
+    std::vector<float> values(static_cast<size_t>(nx) * ny * nz);
+    for (size_t i = 0; i < values.size(); i++)
+    {
+      size_t z = i / (nx * ny);
+      values[i] = static_cast<float>(100 * z + i % (nx * ny));
+    }
+    ok = ok && fwrite(&(values.front()), sizeof(float), values.size(), f) == values.size();
+    fclose(f);
+    return ok;
+  }
+
+  void RemoveTestFiles()
+  {
+    MXADir::remove(MRCTestFile);
+    MXADir::remove(MRCStatisticsIndex::SidecarPath(MRCTestFile));
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestComputeSectionStatistics()
+{
+  int failures = 0;
+  MRCSectionStatistics stats;
+  const float floats[4] = { 1.0f, 2.0f, 3.0f, 6.0f };
+  TEST_CHECK(MRCStatisticsIndex::ComputeSectionStatistics(floats, 4, 2, false, false, 0.0, stats) == 0);
+  TEST_CHECK(stats.Min == 1.0f);
+  TEST_CHECK(stats.Max == 6.0f);
+  TEST_CHECK_CLOSE(stats.Mean, 3.0, 1e-12);
+  TEST_CHECK_CLOSE(stats.AbsDeviation, 1.5, 1e-12);
+  TEST_CHECK(stats.Histogram.size() == MRCStatisticsIndex::NumBins);
+  if(failures > 0)
+  {
+    return failures;
+  }
+  TEST_CHECK(stats.Histogram.front() == 1);
+  TEST_CHECK(stats.Histogram.back() == 1);
+
+  const int16_t shorts[3] = { -4, 0, 10 };
+  TEST_CHECK(MRCStatisticsIndex::ComputeSectionStatistics(shorts, 3, 1, false, false, 0.0, stats) == 0);
+  TEST_CHECK(stats.Min == -4.0f);
+  TEST_CHECK(stats.Max == 10.0f);
+  TEST_CHECK_CLOSE(stats.Mean, 2.0, 1e-12);
+
+  // Values where value + offset is not positive are skipped but still count
+  const float counts[4] = { -3.0f, 0.0f, 1.0f, 2.0f };
+  TEST_CHECK(MRCStatisticsIndex::ComputeSectionStatistics(counts, 4, 2, false, true, 1.0, stats) == 0);
+  TEST_CHECK_CLOSE(stats.Min, log(1.0), 1e-6);
+  TEST_CHECK_CLOSE(stats.Max, log(3.0), 1e-6);
+  TEST_CHECK_CLOSE(stats.Mean, (log(1.0) + log(2.0) + log(3.0)) / 4, 1e-12);
+
+  TEST_CHECK(MRCStatisticsIndex::ComputeSectionStatistics(floats, 4, 4, false, false, 0.0, stats) < 0);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestSidecar()
+{
+  int failures = 0;
+  Detail::RemoveTestFiles();
+  TEST_CHECK(Detail::WriteMRCFile(Detail::MRCTestFile, 4, 3, 2));
+  MRCFile::Pointer mrcFile = MRCFile::New();
+  TEST_CHECK(mrcFile->open(Detail::MRCTestFile) >= 0);
+  if(failures > 0)
+  {
+    Detail::RemoveTestFiles();
+    return failures;
+  }
+
+  // The whole section, which creates the sidecar
+  std::vector<MRCSectionStatistics> stats;
+  MRCStatisticsIndex::Pointer index = MRCStatisticsIndex::New();
+  TEST_CHECK(index->getStatistics(mrcFile, NULL, NULL, stats) == 0);
+  TEST_CHECK(stats.size() == 2);
+  TEST_CHECK(MXADir::exists(MRCStatisticsIndex::SidecarPath(Detail::MRCTestFile)));
+  if(stats.size() == 2)
+  {
+    TEST_CHECK(stats[0].Min == 0.0f);
+    TEST_CHECK(stats[0].Max == 11.0f);
+    TEST_CHECK_CLOSE(stats[1].Mean, 105.5, 1e-9);
+  }
+
+  // A region is a separate entry
+  int xyMin[2] = { 1, 1 };
+  int xyMax[2] = { 2, 2 };
+  TEST_CHECK(index->getStatistics(mrcFile, xyMin, xyMax, stats) == 0);
+  if(stats.size() == 2)
+  {
+    TEST_CHECK(stats[1].Min == 105.0f);
+    TEST_CHECK(stats[1].Max == 110.0f);
+    TEST_CHECK_CLOSE(stats[1].Mean, 107.5, 1e-9);
+  }
+
+  // Both entries come back from the sidecar without touching the data
+  MRCStatisticsIndex::Pointer reloaded = MRCStatisticsIndex::New();
+  TEST_CHECK(reloaded->load(Detail::MRCTestFile) >= 0);
+  int wholeMin[2] = { 0, 0 };
+  int wholeMax[2] = { 3, 2 };
+  const std::vector<MRCSectionStatistics>* whole = reloaded->find(wholeMin, wholeMax);
+  const std::vector<MRCSectionStatistics>* region = reloaded->find(xyMin, xyMax);
+  TEST_CHECK(NULL != whole && whole->size() == 2);
+  TEST_CHECK(NULL != region && region->size() == 2);
+  TEST_CHECK(NULL == reloaded->find(xyMin, xyMax, true, 1.0));
+  if(NULL != whole && whole->size() == 2)
+  {
+    TEST_CHECK_CLOSE((*whole)[1].Mean, 105.5, 1e-9);
+    TEST_CHECK((*whole)[0].Histogram.size() == MRCStatisticsIndex::NumBins);
+  }
+  mrcFile->close();
+
+  // Growing the file invalidates the sidecar
+  FILE* f = fopen(Detail::MRCTestFile.c_str(), "ab");
+  TEST_CHECK(NULL != f);
+  if(NULL != f)
+  {
+    const float extra = 0.0f;
+    fwrite(&extra, sizeof(float), 1, f);
+    fclose(f);
+  }
+  MRCStatisticsIndex::Pointer stale = MRCStatisticsIndex::New();
+  TEST_CHECK(stale->load(Detail::MRCTestFile) < 0);
+  TEST_CHECK(NULL == stale->find(wholeMin, wholeMax));
+
+  Detail::RemoveTestFiles();
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int failures = 0;
+  TEST_RUN(TestComputeSectionStatistics)
+  TEST_RUN(TestSidecar)
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
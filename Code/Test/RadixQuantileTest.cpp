@@ -0,0 +1,154 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/RadixQuantile.h"
+
+#include "UnitTestSupport.h"
+
+namespace Detail
+{
+  class VectorSource
+  {
+    public:
+      explicit VectorSource(const std::vector<double>* values) : m_Values(values) {}
+      double operator()(size_t index) const { return (*m_Values)[index]; }
+    private:
+      const std::vector<double>* m_Values;
+  };
+
+  double NthElement(std::vector<double> values, size_t rank)
+  {
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    return values[rank];
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestEncodeOrdering()
+{
+  int failures = 0;
+  const double values[9] = { -1.0e300, -2.5, -1.0, -1.0e-300, 0.0, 1.0e-300, 1.0, 2.5, 1.0e300 };
+  for (int i = 0; i < 9; i++)
+  {
+    TEST_CHECK(RadixQuantile::decode(RadixQuantile::encode(values[i])) == values[i]);
+    if(i > 0)
+    {
+      TEST_CHECK(RadixQuantile::encode(values[i - 1]) < RadixQuantile::encode(values[i]));
+    }
+  }
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestSelectMatchesNthElement()
+{
+  int failures = 0;
+  // Enough values to need more than one pass, with many duplicates
+  std::vector<double> values(200000);
+  srand(42);
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    values[i] = static_cast<double>(rand() % 5000) - 2500.0 + ((i % 3 == 0) ? 0.25 : 0.0);
+  }
+  Detail::VectorSource source(&values);
+  const size_t ranks[6] = { 0, 1, 777, 100000, 199998, 199999 };
+  for (int i = 0; i < 6; i++)
+  {
+    TEST_CHECK(RadixQuantile::select(source, values.size(), ranks[i]) == Detail::NthElement(values, ranks[i]));
+  }
+  TEST_CHECK(RadixQuantile::quantile(source, values.size(), 0.5) == Detail::NthElement(values, 100000));
+  TEST_CHECK(RadixQuantile::quantile(source, values.size(), 0.99) == Detail::NthElement(values, 198000));
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestSelectEqualValues()
+{
+  int failures = 0;
+  // More equal values than k_MaxCandidates resolve through every digit
+  std::vector<double> values(RadixQuantile::k_MaxCandidates + 1000, 3.75);
+  values.back() = -1.0;
+  Detail::VectorSource source(&values);
+  TEST_CHECK(RadixQuantile::select(source, values.size(), 0) == -1.0);
+  TEST_CHECK(RadixQuantile::select(source, values.size(), 1) == 3.75);
+  TEST_CHECK(RadixQuantile::select(source, values.size(), values.size() - 1) == 3.75);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestSelectLimits()
+{
+  int failures = 0;
+  std::vector<double> values(5);
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    values[i] = 10.0 - static_cast<double>(i);
+  }
+  Detail::VectorSource source(&values);
+  TEST_CHECK(RadixQuantile::select(source, 0, 3) == 0.0);
+  TEST_CHECK(RadixQuantile::select(source, values.size(), 100) == 10.0);
+  TEST_CHECK(RadixQuantile::quantile(source, values.size(), -1.0) == 6.0);
+  TEST_CHECK(RadixQuantile::quantile(source, values.size(), 2.0) == 10.0);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int failures = 0;
+  TEST_RUN(TestEncodeOrdering)
+  TEST_RUN(TestSelectMatchesNthElement)
+  TEST_RUN(TestSelectEqualValues)
+  TEST_RUN(TestSelectLimits)
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
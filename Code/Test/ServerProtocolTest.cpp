@@ -0,0 +1,258 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined (_MSC_VER)
+#include <unistd.h>
+#include <sys/socket.h>
+#endif
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/ServerProtocol.h"
+
+#include "UnitTestSupport.h"
+
+namespace Detail
+{
+  /**
+   * @brief A message with every type of value and strings that need escaping
+   */
+  ServerMessage CreateMessage()
+  {
+    ServerMessage message;
+    message.setString("command", "submit");
+    message.setString("path", "C:\\data\\tilt \"series\".mrc");
+    message.setString("control", std::string("line\nbreak\ttab\x01" "end"));
+    message.setNumber("sigma_x", 0.00125);
+    message.setNumber("count", -42);
+    message.setBool("verbose", true);
+    message.setBool("dry_run", false);
+    std::vector<std::string> args;
+    args.push_back("--in");
+    args.push_back("a,b");
+    args.push_back("");
+    message.setStrings("args", args);
+    return message;
+  }
+
+  int CheckMessage(const ServerMessage& message)
+  {
+    int failures = 0;
+    TEST_CHECK(message.getString("command") == "submit");
+    TEST_CHECK(message.getString("path") == "C:\\data\\tilt \"series\".mrc");
+    TEST_CHECK(message.getString("control") == std::string("line\nbreak\ttab\x01" "end"));
+    TEST_CHECK(message.getNumber("sigma_x") == 0.00125);
+    TEST_CHECK(message.getNumber("count") == -42.0);
+    TEST_CHECK(message.getBool("verbose") == true);
+    TEST_CHECK(message.getBool("dry_run", true) == false);
+    std::vector<std::string> args = message.getStrings("args");
+    TEST_CHECK(args.size() == 3);
+    if(args.size() == 3)
+    {
+      TEST_CHECK(args[0] == "--in");
+      TEST_CHECK(args[1] == "a,b");
+      TEST_CHECK(args[2].empty() == true);
+    }
+    return failures;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestRoundTrip()
+{
+  int failures = 0;
+  ServerMessage message = Detail::CreateMessage();
+  failures += Detail::CheckMessage(message);
+
+  std::string json = message.toJson();
+  // One line with the keys in the order they were set
+  TEST_CHECK(json.find('\n') == std::string::npos);
+  TEST_CHECK(json.compare(0, 20, "{\"command\":\"submit\",") == 0);
+  TEST_CHECK(json.find("\\u0001") != std::string::npos);
+
+  ServerMessage parsed;
+  TEST_CHECK(ServerMessage::FromJson(json, parsed) == 0);
+  failures += Detail::CheckMessage(parsed);
+  TEST_CHECK(parsed.toJson() == json);
+
+  // Setting a key again replaces its value and keeps its place
+  message.setNumber("command", 3);
+  TEST_CHECK(message.getNumber("command") == 3.0);
+  TEST_CHECK(message.toJson().compare(0, 12, "{\"command\":3") == 0);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestParse()
+{
+  int failures = 0;
+  ServerMessage message;
+  TEST_CHECK(ServerMessage::FromJson(" { \"a\" : \"caf\\u00e9 \\/\" , \"b\" : [ 1 , 2.5e1 , \"x\" ] , \"c\" : null , \"d\":1e-3 }\r", message) == 0);
+  TEST_CHECK(message.getString("a") == "caf\xC3\xA9 /");
+  std::vector<std::string> b = message.getStrings("b");
+  TEST_CHECK(b.size() == 3);
+  if(b.size() == 3)
+  {
+    TEST_CHECK(b[0] == "1");
+    TEST_CHECK(b[1] == "25");
+    TEST_CHECK(b[2] == "x");
+  }
+  TEST_CHECK(message.has("c") == false);
+  TEST_CHECK_CLOSE(message.getNumber("d"), 0.001, 1e-15);
+
+  // The getters fall back on missing keys and on values of another type
+  TEST_CHECK(message.getString("d", "fallback") == "fallback");
+  TEST_CHECK(message.getNumber("a", 7.0) == 7.0);
+  TEST_CHECK(message.getBool("missing", true) == true);
+  TEST_CHECK(message.getStrings("a").empty() == true);
+
+  // Parsing replaces whatever the message held
+  TEST_CHECK(ServerMessage::FromJson("{}", message) == 0);
+  TEST_CHECK(message.has("a") == false);
+  TEST_CHECK(message.toJson() == "{}");
+  TEST_CHECK(ServerMessage::FromJson("{\"e\":[]}", message) == 0);
+  TEST_CHECK(message.has("e") == true);
+  TEST_CHECK(message.getStrings("e").empty() == true);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestInvalid()
+{
+  int failures = 0;
+  const char* lines[] = {
+    "",
+    "[]",
+    "{",
+    "{\"a\":1",
+    "{\"a\":}",
+    "{\"a\" 1}",
+    "{a:1}",
+    "{\"a\":1,}",
+    "{\"a\":1} trailing",
+    "{\"a\":{\"b\":1}}",
+    "{\"a\":[true]}",
+    "{\"a\":\"\\q\"}",
+    "{\"a\":\"unterminated}",
+    "{\"a\":\"\\u12\"}",
+    "{\"a\":nope}"
+  };
+  for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); ++i)
+  {
+    ServerMessage message;
+    int err = ServerMessage::FromJson(lines[i], message);
+    if(err >= 0)
+    {
+      std::cout << "Parsed an invalid line: " << lines[i] << std::endl;
+    }
+    TEST_CHECK(err < 0);
+  }
+  return failures;
+}
+
+#if !defined (_MSC_VER)
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestConnection()
+{
+  int failures = 0;
+  int sockets[2];
+  TEST_CHECK(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0);
+  if(failures > 0)
+  {
+    return failures;
+  }
+  ServerConnection::Pointer writer = ServerConnection::New();
+  ServerConnection::Pointer reader = ServerConnection::New();
+  writer->attach(sockets[0]);
+  reader->attach(sockets[1]);
+
+  TEST_CHECK(writer->writeMessage(Detail::CreateMessage()) == 0);
+  ServerMessage second;
+  second.setString("command", "status");
+  TEST_CHECK(writer->writeMessage(second) == 0);
+
+  ServerMessage message;
+  TEST_CHECK(reader->readMessage(message) == 1);
+  failures += Detail::CheckMessage(message);
+  TEST_CHECK(reader->readMessage(message) == 1);
+  TEST_CHECK(message.getString("command") == "status");
+  TEST_CHECK(message.has("path") == false);
+
+  // Blank lines are skipped, a line that is not a message is reported and
+  // the next one is still read
+  const char* raw = "\n  \nnot json\n{\"command\":\"cancel\"}\n";
+  TEST_CHECK(::send(sockets[0], raw, strlen(raw), 0) == static_cast<ssize_t>(strlen(raw)));
+  TEST_CHECK(reader->readMessage(message) == -2);
+  TEST_CHECK(reader->getErrorMessage().empty() == false);
+  TEST_CHECK(reader->readMessage(message) == 1);
+  TEST_CHECK(message.getString("command") == "cancel");
+
+  // The peer hanging up ends the stream
+  writer->close();
+  TEST_CHECK(reader->readMessage(message) == 0);
+  TEST_CHECK(writer->writeMessage(second) < 0);
+  return failures;
+}
+#endif
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int failures = 0;
+  TEST_RUN(TestRoundTrip)
+  TEST_RUN(TestParse)
+  TEST_RUN(TestInvalid)
+#if !defined (_MSC_VER)
+  TEST_RUN(TestConnection)
+#endif
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,370 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <iostream>
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Reconstruction/ReconstructionStructures.h"
+#include "MBIRLib/Reconstruction/SinogramStatistics.h"
+
+#include "UnitTestSupport.h"
+
+namespace Detail
+{
+  Real_t InverseCount(Real_t counts)
+  {
+    return 1.0 / counts;
+  }
+
+  SinogramPtr CreateSinogram(uint16_t N_theta, uint16_t N_r, uint16_t N_t)
+  {
+    SinogramPtr sinogram = SinogramPtr(new Sinogram);
+    sinogram->N_theta = N_theta;
+    sinogram->N_r = N_r;
+    sinogram->N_t = N_t;
+    sinogram->delta_r = 1.0;
+    sinogram->delta_t = 1.0;
+    sinogram->R0 = -N_r / 2.0;
+    sinogram->RMax = N_r / 2.0;
+    sinogram->T0 = -N_t / 2.0;
+    sinogram->TMax = N_t / 2.0;
+    size_t dims[3] = { N_theta, N_r, N_t };
+    sinogram->counts = RealVolumeType::New(dims, "Test Sinogram");
+    for (uint16_t i_theta = 0; i_theta < N_theta; i_theta++)
+    {
+      sinogram->angles.push_back(i_theta * 2.0);
+      for (uint16_t i_r = 0; i_r < N_r; i_r++)
+      {
+        for (uint16_t i_t = 0; i_t < N_t; i_t++)
+        {
+          sinogram->counts->setValue(1 + i_theta * 100 + i_r * 10 + i_t, i_theta, i_r, i_t);
+        }
+      }
+    }
+    return sinogram;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestTiltCountAccumulator()
+{
+  int failures = 0;
+  // A large mean with a small spread must not lose the variance
+  TiltCountAccumulator accumulator;
+  const Real_t values[4] = { 1.0e9 + 1, 1.0e9 + 2, 1.0e9 + 3, 1.0e9 + 4 };
+  for (int i = 0; i < 4; i++)
+  {
+    accumulator.add(values[i]);
+  }
+  TiltCountStatistics stats = accumulator.getStatistics();
+  TEST_CHECK_CLOSE(stats.Mean, 1.0e9 + 2.5, 1e-6);
+  TEST_CHECK_CLOSE(stats.StdDev, sqrt(1.25), 1e-9);
+  TEST_CHECK_CLOSE(stats.Min, 1.0e9 + 1, 1e-6);
+  TEST_CHECK_CLOSE(stats.Max, 1.0e9 + 4, 1e-6);
+
+  TiltCountStatistics empty = TiltCountAccumulator().getStatistics();
+  TEST_CHECK(empty.Mean == 0);
+  TEST_CHECK(empty.StdDev == 0);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestComputeTiltMoments()
+{
+  int failures = 0;
+  SinogramPtr sinogram = Detail::CreateSinogram(3, 5, 7);
+  // One zero count to exercise the e*e fallback of SumEEOverY
+  sinogram->counts->setValue(0.0, 1, 2, 3);
+  size_t dims[3] = { 3, 5, 7 };
+  RealVolumeType::Pointer error = RealVolumeType::New(dims, "Test Error");
+  RealVolumeType::Pointer weight = RealVolumeType::New(dims, "Test Weight");
+  for (size_t i = 0; i < error->numElements(); i++)
+  {
+    error->d[i] = 0.5 - static_cast<Real_t>(i % 11) / 10.0;
+    weight->d[i] = 0.25 + static_cast<Real_t>(i % 5);
+  }
+  size_t numDims[1] = { 3 };
+  RealArrayType::Pointer i_0 = RealArrayType::New(numDims, "Test I_0");
+  RealArrayType::Pointer mu = RealArrayType::New(numDims, "Test Mu");
+  for (uint16_t i_theta = 0; i_theta < 3; i_theta++)
+  {
+    i_0->d[i_theta] = 2.0 + i_theta;
+    mu->d[i_theta] = 0.1 * i_theta;
+  }
+
+  std::vector<TiltMoments> moments;
+  SinogramStatistics::computeTiltMoments(sinogram, error, weight, i_0, mu, BitVolume::NullPointer(), moments);
+  TEST_CHECK(moments.size() == 3);
+  if(failures > 0)
+  {
+    return failures;
+  }
+
+  for (uint16_t i_theta = 0; i_theta < 3; i_theta++)
+  {
+    Real_t sumW = 0, sumWY = 0, sumWYY = 0, sumWE = 0, sumWEE = 0, sumEE = 0, sumEEOverY = 0;
+    Real_t sumWP = 0, sumWPY = 0, sumWPP = 0;
+    for (uint16_t i_r = 0; i_r < 5; i_r++)
+    {
+      for (uint16_t i_t = 0; i_t < 7; i_t++)
+      {
+        Real_t y = sinogram->counts->getValue(i_theta, i_r, i_t);
+        Real_t e = error->getValue(i_theta, i_r, i_t);
+        Real_t w = weight->getValue(i_theta, i_r, i_t);
+        Real_t p = (y - e - mu->d[i_theta]) / i_0->d[i_theta];
+        sumW += w;
+        sumWY += w * y;
+        sumWYY += w * y * y;
+        sumWE += w * e;
+        sumWEE += w * e * e;
+        sumEE += e * e;
+        sumEEOverY += (y != 0) ? e * e / y : e * e;
+        sumWP += w * p;
+        sumWPY += w * p * y;
+        sumWPP += w * p * p;
+      }
+    }
+    const TiltMoments& m = moments[i_theta];
+    TEST_CHECK_CLOSE(m.SumW, sumW, 1e-9);
+    TEST_CHECK_CLOSE(m.SumWY, sumWY, 1e-6);
+    TEST_CHECK_CLOSE(m.SumWYY, sumWYY, 1e-3);
+    TEST_CHECK_CLOSE(m.SumWE, sumWE, 1e-9);
+    TEST_CHECK_CLOSE(m.SumWEE, sumWEE, 1e-9);
+    TEST_CHECK_CLOSE(m.SumEE, sumEE, 1e-9);
+    TEST_CHECK_CLOSE(m.SumEEOverY, sumEEOverY, 1e-9);
+    TEST_CHECK_CLOSE(m.SumWP, sumWP, 1e-6);
+    TEST_CHECK_CLOSE(m.SumWPY, sumWPY, 1e-3);
+    TEST_CHECK_CLOSE(m.SumWPP, sumWPP, 1e-3);
+    TEST_CHECK(m.NumRejected == 0);
+  }
+
+  // Without weights every weight is 1 and without I_0 the p sums stay zero
+  SinogramStatistics::computeTiltMoments(sinogram, error, RealVolumeType::NullPointer(), RealArrayType::NullPointer(),
+                                         RealArrayType::NullPointer(), BitVolume::NullPointer(), moments);
+  TEST_CHECK_CLOSE(moments[0].SumW, 35, 1e-12);
+  TEST_CHECK_CLOSE(moments[0].SumWEE, moments[0].SumEE, 1e-12);
+  TEST_CHECK(moments[0].SumWP == 0);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestTiltUpdates()
+{
+  int failures = 0;
+  SinogramPtr sinogram = Detail::CreateSinogram(2, 3, 4);
+  sinogram->counts->setValue(0.0, 1, 0, 0);
+  size_t dims[3] = { 2, 3, 4 };
+  RealVolumeType::Pointer error = RealVolumeType::New(dims, "Test Error");
+  error->fill(1.0);
+
+  // e = a * y + b * e + c per tilt
+  std::vector<Real_t> a(2), b(2), c(2);
+  a[0] = 1.0;  b[0] = 2.0;  c[0] = -1.0;
+  a[1] = -0.5; b[1] = 0.0;  c[1] = 3.0;
+  SinogramStatistics::affineErrorUpdate(sinogram, error, a, b, c);
+  TEST_CHECK_CLOSE(error->getValue(0, 2, 3), 1 + 20 + 3 + 2.0 - 1.0, 1e-12);
+  TEST_CHECK_CLOSE(error->getValue(1, 1, 1), -0.5 * (1 + 100 + 10 + 1) + 3.0, 1e-12);
+
+  // w = 1 / (y * alpha), zero counts get the fallback weight
+  RealVolumeType::Pointer weight = RealVolumeType::New(dims, "Test Weight");
+  std::vector<Real_t> alpha(2);
+  alpha[0] = 2.0;
+  alpha[1] = 0.5;
+  SinogramStatistics::inverseCountWeights(sinogram, weight, alpha, 1e-10);
+  TEST_CHECK_CLOSE(weight->getValue(0, 1, 2), 1.0 / (13 * 2.0), 1e-12);
+  TEST_CHECK_CLOSE(weight->getValue(1, 2, 3), 1.0 / (124 * 0.5), 1e-12);
+  TEST_CHECK(weight->getValue(1, 0, 0) == 1e-10);
+
+  std::vector<Real_t> scale(2);
+  scale[0] = 3.0;
+  scale[1] = 0.0;
+  SinogramStatistics::scaleTilts(weight, scale);
+  TEST_CHECK_CLOSE(weight->getValue(0, 1, 2), 3.0 / (13 * 2.0), 1e-12);
+  TEST_CHECK(weight->getValue(1, 2, 3) == 0);
+  SinogramStatistics::fillTilts(weight, alpha);
+  TEST_CHECK(weight->getValue(0, 2, 1) == 2.0);
+  TEST_CHECK(weight->getValue(1, 0, 3) == 0.5);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestLogTransformCounts()
+{
+  int failures = 0;
+  SinogramPtr sinogram = Detail::CreateSinogram(2, 2, 3);
+  sinogram->counts->setValue(-5.0, 0, 0, 0);
+  sinogram->counts->setValue(-1.0, 1, 1, 2);
+  const Real_t offset = 2.0;
+  const Real_t normalization = 150.0;
+
+  SinogramPtr expected = Detail::CreateSinogram(2, 2, 3);
+  expected->counts->setValue(-5.0, 0, 0, 0);
+  expected->counts->setValue(-1.0, 1, 1, 2);
+
+  size_t numNegative = SinogramStatistics::logTransformCounts(sinogram, offset, normalization);
+  TEST_CHECK(numNegative == 1);
+  TEST_CHECK(sinogram->rawStatistics.size() == 2);
+  TEST_CHECK(sinogram->logStatistics.size() == 2);
+  if(failures > 0)
+  {
+    return failures;
+  }
+  TEST_CHECK_CLOSE(sinogram->rawStatistics[0].Min, -5.0, 1e-12);
+  TEST_CHECK_CLOSE(sinogram->rawStatistics[1].Max, 1 + 100 + 10 + 1, 1e-12);
+  for (uint16_t i_theta = 0; i_theta < 2; i_theta++)
+  {
+    Real_t logSum = 0;
+    for (uint16_t i_r = 0; i_r < 2; i_r++)
+    {
+      for (uint16_t i_t = 0; i_t < 3; i_t++)
+      {
+        Real_t y = expected->counts->getValue(i_theta, i_r, i_t);
+        if(y + offset <= 0)
+        {
+          continue;
+        }
+        Real_t logY = -log((y + offset) / normalization);
+        TEST_CHECK_CLOSE(sinogram->counts->getValue(i_theta, i_r, i_t), logY, 1e-12);
+        logSum += logY;
+      }
+    }
+    if(i_theta == 1)
+    {
+      TEST_CHECK_CLOSE(sinogram->logStatistics[1].Mean, logSum / 6, 1e-9);
+    }
+  }
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestBinDetector()
+{
+  int failures = 0;
+  const unsigned int factor = 2;
+  SinogramPtr sinogram = Detail::CreateSinogram(2, 4, 6);
+  SinogramPtr binned = SinogramStatistics::binDetector(sinogram, factor, &Detail::InverseCount);
+
+  TEST_CHECK(binned->N_theta == 2);
+  TEST_CHECK(binned->N_r == 2);
+  TEST_CHECK(binned->N_t == 3);
+  TEST_CHECK_CLOSE(binned->delta_r, 2.0, 1e-12);
+  TEST_CHECK_CLOSE(binned->delta_t, 2.0, 1e-12);
+  TEST_CHECK_CLOSE(binned->R0, -2.0, 1e-12);
+  TEST_CHECK_CLOSE(binned->TMax, 3.0, 1e-12);
+  TEST_CHECK(binned->angles == sinogram->angles);
+  TEST_CHECK(NULL != binned->weights.get());
+  TEST_CHECK(binned->logStatistics.size() == 2);
+  if(failures > 0)
+  {
+    return failures;
+  }
+
+  Real_t n = factor * factor;
+  for (uint16_t i_theta = 0; i_theta < binned->N_theta; i_theta++)
+  {
+    Real_t tiltSum = 0;
+    for (uint16_t br = 0; br < binned->N_r; br++)
+    {
+      for (uint16_t bt = 0; bt < binned->N_t; bt++)
+      {
+        // The binned value is the mean and its weight the inverse variance of
+        // the mean of the 1/y weighted measurements, n^2 / sum(y)
+        Real_t sum = 0;
+        for (unsigned int dr = 0; dr < factor; dr++)
+        {
+          for (unsigned int dt = 0; dt < factor; dt++)
+          {
+            sum += sinogram->counts->getValue(i_theta, br * factor + dr, bt * factor + dt);
+          }
+        }
+        TEST_CHECK_CLOSE(binned->counts->getValue(i_theta, br, bt), sum / n, 1e-9);
+        TEST_CHECK_CLOSE(binned->weights->getValue(i_theta, br, bt), n * n / sum, 1e-12);
+        tiltSum += sum / n;
+      }
+    }
+    TEST_CHECK_CLOSE(binned->logStatistics[i_theta].Mean, tiltSum / (binned->N_r * binned->N_t), 1e-9);
+  }
+
+  // The fine sinogram is left untouched
+  TEST_CHECK(sinogram->N_r == 4);
+  TEST_CHECK_CLOSE(sinogram->counts->getValue(1, 3, 5), 1 + 100 + 30 + 5, 1e-12);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestBinDetectorWithoutWeights()
+{
+  int failures = 0;
+  SinogramPtr sinogram = Detail::CreateSinogram(1, 8, 4);
+  SinogramPtr binned = SinogramStatistics::binDetector(sinogram, 4, NULL);
+  TEST_CHECK(binned->N_r == 2);
+  TEST_CHECK(binned->N_t == 1);
+  TEST_CHECK(NULL == binned->weights.get());
+  // Mean of rows 0..3 and columns 0..3: 1 + 15 + 1.5
+  TEST_CHECK_CLOSE(binned->counts->getValue(0, 0, 0), 17.5, 1e-9);
+  TEST_CHECK_CLOSE(binned->counts->getValue(0, 1, 0), 57.5, 1e-9);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int failures = 0;
+  TEST_RUN(TestTiltCountAccumulator)
+  TEST_RUN(TestComputeTiltMoments)
+  TEST_RUN(TestTiltUpdates)
+  TEST_RUN(TestLogTransformCounts)
+  TEST_RUN(TestBinDetector)
+  TEST_RUN(TestBinDetectorWithoutWeights)
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
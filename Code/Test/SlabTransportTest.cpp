@@ -0,0 +1,255 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <iostream>
+#include <vector>
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/SlabTransport.h"
+
+#include "UnitTestSupport.h"
+
+namespace Detail
+{
+  /**
+   * @brief Connects two ranks through one end each of a socket pair
+   */
+  class SocketPairTransport : public SlabTransport
+  {
+    public:
+      SocketPairTransport(int rank, int socket) :
+        m_Rank(rank),
+        m_Socket(socket)
+      {
+      }
+
+      virtual ~SocketPairTransport()
+      {
+        ::close(m_Socket);
+      }
+
+      virtual int getRank() { return m_Rank; }
+      virtual int getSize() { return 2; }
+
+      virtual int send(int peer, const void* data, size_t bytes)
+      {
+        const char* p = static_cast<const char*>(data);
+        while(bytes > 0)
+        {
+          ssize_t n = ::send(m_Socket, p, bytes, 0);
+          if(n <= 0)
+          {
+            setErrorMessage("Could not send to the peer");
+            return -1;
+          }
+          p += n;
+          bytes -= n;
+        }
+        return 0;
+      }
+
+      virtual int receive(int peer, void* data, size_t bytes)
+      {
+        char* p = static_cast<char*>(data);
+        while(bytes > 0)
+        {
+          ssize_t n = ::recv(m_Socket, p, bytes, 0);
+          if(n <= 0)
+          {
+            setErrorMessage("The peer closed the connection");
+            return -1;
+          }
+          p += n;
+          bytes -= n;
+        }
+        return 0;
+      }
+
+    private:
+      int m_Rank;
+      int m_Socket;
+  };
+
+  typedef int (*WorkerFunction)(SlabTransport& transport);
+
+  /**
+   * @brief Runs the worker as rank 1 in a child process and as rank 0 in this one
+   * @return The failed checks of both ranks
+   */
+  int RunPair(WorkerFunction worker)
+  {
+    int sockets[2];
+    if(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) < 0)
+    {
+      std::cout << "Could not create a socket pair" << std::endl;
+      return 1;
+    }
+    std::cout.flush();
+    pid_t pid = ::fork();
+    if(pid < 0)
+    {
+      std::cout << "Could not fork" << std::endl;
+      return 1;
+    }
+    if(pid == 0)
+    {
+      ::close(sockets[0]);
+      int childFailures = 0;
+      {
+        SocketPairTransport transport(1, sockets[1]);
+        childFailures = worker(transport);
+      }
+      std::cout.flush();
+      ::_exit(childFailures);
+    }
+    ::close(sockets[1]);
+    int failures = 0;
+    {
+      SocketPairTransport transport(0, sockets[0]);
+      failures = worker(transport);
+    }
+    int status = 0;
+    if(::waitpid(pid, &status, 0) < 0 || WIFEXITED(status) == 0)
+    {
+      return failures + 1;
+    }
+    return failures + WEXITSTATUS(status);
+  }
+
+  /* Larger than the buffers of the socket so the order of the two sides matters */
+  const size_t NumRows = 200000;
+
+  int SendReceiveWorker(SlabTransport& transport)
+  {
+    int failures = 0;
+    int rank = transport.getRank();
+    std::vector<Real_t> rows(NumRows);
+    for (size_t i = 0; i < NumRows; ++i)
+    {
+      rows[i] = rank * 1000000.0 + i;
+    }
+    std::vector<Real_t> received(NumRows, -1.0);
+    TEST_CHECK(transport.sendReceive(1 - rank, &(rows.front()), &(received.front()), NumRows * sizeof(Real_t)) >= 0);
+    TEST_CHECK(received[0] == (1 - rank) * 1000000.0);
+    TEST_CHECK(received[NumRows - 1] == (1 - rank) * 1000000.0 + NumRows - 1);
+    // Both ranks can swap again right away
+    TEST_CHECK(transport.sendReceive(1 - rank, &(received.front()), &(rows.front()), NumRows * sizeof(Real_t)) >= 0);
+    TEST_CHECK(rows[NumRows / 2] == rank * 1000000.0 + NumRows / 2);
+    return failures;
+  }
+
+  int AllReduceSumWorker(SlabTransport& transport)
+  {
+    int failures = 0;
+    int rank = transport.getRank();
+    std::vector<Real_t> values(3);
+    values[0] = 1.0 + rank;
+    values[1] = 10.0 * (1 + rank);
+    values[2] = -0.5;
+    TEST_CHECK(transport.allReduceSum(values) >= 0);
+    TEST_CHECK_CLOSE(values[0], 3.0, 1e-12);
+    TEST_CHECK_CLOSE(values[1], 30.0, 1e-12);
+    TEST_CHECK_CLOSE(values[2], -1.0, 1e-12);
+    TEST_CHECK(transport.barrier() >= 0);
+    std::vector<Real_t> nothing;
+    TEST_CHECK(transport.allReduceSum(nothing) >= 0);
+    return failures;
+  }
+
+  /* Rank 1 leaves right away, rank 0 must see that and keep its values */
+  int PeerGoneWorker(SlabTransport& transport)
+  {
+    int failures = 0;
+    if(transport.getRank() == 1)
+    {
+      return failures;
+    }
+    std::vector<Real_t> values(2);
+    values[0] = 4.0;
+    values[1] = 5.0;
+    TEST_CHECK(transport.allReduceSum(values) < 0);
+    TEST_CHECK(values[0] == 4.0);
+    TEST_CHECK(values[1] == 5.0);
+    TEST_CHECK(transport.getErrorMessage().empty() == false);
+    TEST_CHECK(transport.barrier() < 0);
+    return failures;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestSendReceive()
+{
+  return Detail::RunPair(Detail::SendReceiveWorker);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestAllReduceSum()
+{
+  return Detail::RunPair(Detail::AllReduceSumWorker);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestPeerGone()
+{
+  return Detail::RunPair(Detail::PeerGoneWorker);
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  // A peer that is gone shows up as an error instead of ending the test
+  ::signal(SIGPIPE, SIG_IGN);
+  int failures = 0;
+  TEST_RUN(TestSendReceive)
+  TEST_RUN(TestAllReduceSum)
+  TEST_RUN(TestPeerGone)
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
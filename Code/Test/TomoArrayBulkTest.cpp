@@ -0,0 +1,243 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <iostream>
+#include <vector>
+
+#include "MBIRLib/MBIRLib.h"
+#include "MBIRLib/Common/TomoArray.hpp"
+
+#include "UnitTestSupport.h"
+
+typedef TomoArray<float, float*, 1> FloatArrayType;
+
+namespace Detail
+{
+  /* Lengths around the four way unrolled sum and the 64 byte alignment */
+  const size_t NumLengths = 11;
+  const size_t Lengths[NumLengths] = { 1, 2, 3, 4, 5, 7, 8, 9, 15, 63, 65 };
+
+  /* Starts past the aligned start of an array, so the ranges are not aligned */
+  const size_t NumOffsets = 3;
+  const size_t Offsets[NumOffsets] = { 0, 1, 3 };
+
+  template<typename T>
+  T Value(size_t i)
+  {
+    // Small integers so every sum is exact
+    return static_cast<T>(static_cast<int>((i * 37) % 101) - 50);
+  }
+
+  /**
+   * @brief Checks the element kernels on every length and start offset against
+   * plain loops
+   */
+  template<typename T>
+  int CheckKernels(T* d, T* x)
+  {
+    int failures = 0;
+    for (size_t o = 0; o < NumOffsets; ++o)
+    {
+      for (size_t l = 0; l < NumLengths; ++l)
+      {
+        T* dRange = d + Offsets[o];
+        T* xRange = x + Offsets[o];
+        size_t n = Lengths[l];
+        double expectedSum = 0.0;
+        T expectedMin = Value<T>(0);
+        T expectedMax = Value<T>(0);
+        for (size_t i = 0; i < n; ++i)
+        {
+          dRange[i] = Value<T>(i);
+          xRange[i] = Value<T>(i + 7);
+          expectedSum += Value<T>(i);
+          expectedMin = (Value<T>(i) < expectedMin) ? Value<T>(i) : expectedMin;
+          expectedMax = (Value<T>(i) > expectedMax) ? Value<T>(i) : expectedMax;
+        }
+        // The element past the range must not be touched
+        dRange[n] = static_cast<T>(1000);
+
+        TEST_CHECK(TomoArrayBulk::sum(dRange, n) == expectedSum);
+        TEST_CHECK(TomoArrayBulk::minValue(dRange, n) == expectedMin);
+        TEST_CHECK(TomoArrayBulk::maxValue(dRange, n) == expectedMax);
+
+        TomoArrayBulk::axpy(dRange, xRange, n, static_cast<T>(2));
+        for (size_t i = 0; i < n; ++i)
+        {
+          TEST_CHECK(dRange[i] == Value<T>(i) + 2 * Value<T>(i + 7));
+        }
+        TomoArrayBulk::scale(dRange, n, static_cast<T>(-3));
+        for (size_t i = 0; i < n; ++i)
+        {
+          TEST_CHECK(dRange[i] == -3 * (Value<T>(i) + 2 * Value<T>(i + 7)));
+        }
+        TEST_CHECK(dRange[n] == static_cast<T>(1000));
+      }
+    }
+    return failures;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestAlignedStorage()
+{
+  int failures = 0;
+  size_t dims[3] = { 3, 5, 7 };
+  RealVolumeType::Pointer volume = RealVolumeType::New(dims, "TestAlignedStorage Volume");
+  TEST_CHECK(volume->numElements() == 105);
+  TEST_CHECK(reinterpret_cast<uintptr_t>(volume->d) % MBIR_ALIGNMENT == 0);
+  size_t length = 13;
+  FloatArrayType::Pointer array = FloatArrayType::New(&length, "TestAlignedStorage Array");
+  TEST_CHECK(reinterpret_cast<uintptr_t>(array->d) % MBIR_ALIGNMENT == 0);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestKernelTails()
+{
+  int failures = 0;
+  size_t length = 128;
+  RealArrayType::Pointer d = RealArrayType::New(&length, "TestKernelTails D");
+  RealArrayType::Pointer x = RealArrayType::New(&length, "TestKernelTails X");
+  failures += Detail::CheckKernels<Real_t>(d->d, x->d);
+
+  FloatArrayType::Pointer fd = FloatArrayType::New(&length, "TestKernelTails Float D");
+  FloatArrayType::Pointer fx = FloatArrayType::New(&length, "TestKernelTails Float X");
+  failures += Detail::CheckKernels<float>(fd->d, fx->d);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestBlockedRun()
+{
+  int failures = 0;
+  // Several blocks, the last one short, starting one element past the alignment
+  size_t n = 2 * TomoArrayBulk::k_BlockSize + 5;
+  size_t length = n + 1;
+  RealArrayType::Pointer d = RealArrayType::New(&length, "TestBlockedRun D");
+  RealArrayType::Pointer x = RealArrayType::New(&length, "TestBlockedRun X");
+  Real_t* dRange = d->d + 1;
+  Real_t* xRange = x->d + 1;
+  // The element before the range must not be touched
+  d->d[0] = 1000.0;
+  x->d[0] = 1000.0;
+  double expectedSum = 0.0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    dRange[i] = Detail::Value<Real_t>(i);
+    xRange[i] = 1.0;
+    expectedSum += dRange[i];
+  }
+  // The extremes sit in the short last block
+  dRange[n - 1] = -500.0;
+  dRange[n - 2] = 700.0;
+  expectedSum += -500.0 + 700.0 - Detail::Value<Real_t>(n - 1) - Detail::Value<Real_t>(n - 2);
+
+  TEST_CHECK(TomoArrayBulk::run<Real_t>(TomoArrayBulk::Sum, dRange, NULL, 0.0, n) == expectedSum);
+  TEST_CHECK(TomoArrayBulk::run<Real_t>(TomoArrayBulk::Min, dRange, NULL, 0.0, n) == -500.0);
+  TEST_CHECK(TomoArrayBulk::run<Real_t>(TomoArrayBulk::Max, dRange, NULL, 0.0, n) == 700.0);
+
+  TomoArrayBulk::run<Real_t>(TomoArrayBulk::Axpy, dRange, xRange, 4.0, n);
+  TEST_CHECK(dRange[0] == Detail::Value<Real_t>(0) + 4.0);
+  TEST_CHECK(dRange[TomoArrayBulk::k_BlockSize - 1] == Detail::Value<Real_t>(TomoArrayBulk::k_BlockSize - 1) + 4.0);
+  TEST_CHECK(dRange[TomoArrayBulk::k_BlockSize] == Detail::Value<Real_t>(TomoArrayBulk::k_BlockSize) + 4.0);
+  TEST_CHECK(dRange[n - 1] == -496.0);
+
+  TomoArrayBulk::run<Real_t>(TomoArrayBulk::Scale, dRange, NULL, 0.5, n);
+  TEST_CHECK(dRange[2 * TomoArrayBulk::k_BlockSize] == 0.5 * (Detail::Value<Real_t>(2 * TomoArrayBulk::k_BlockSize) + 4.0));
+  TEST_CHECK(dRange[n - 1] == -248.0);
+  TEST_CHECK(d->d[0] == 1000.0);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int TestArrayMembers()
+{
+  int failures = 0;
+  size_t dims[3] = { 3, 5, 7 };
+  RealVolumeType::Pointer volume = RealVolumeType::New(dims, "TestArrayMembers Volume");
+  RealVolumeType::Pointer other = RealVolumeType::New(dims, "TestArrayMembers Other");
+  volume->fill(2.0);
+  TEST_CHECK(volume->sum() == 210.0);
+  TEST_CHECK(volume->getValue(2, 4, 6) == 2.0);
+
+  for (size_t i = 0; i < other->numElements(); ++i)
+  {
+    other->d[i] = Detail::Value<Real_t>(i);
+  }
+  TEST_CHECK(volume->axpy(-1.0, other) == true);
+  TEST_CHECK(volume->d[104] == 2.0 - Detail::Value<Real_t>(104));
+  volume->scale(3.0);
+  TEST_CHECK(volume->d[103] == 3.0 * (2.0 - Detail::Value<Real_t>(103)));
+
+  TEST_CHECK(volume->copyFrom(other) == true);
+  TEST_CHECK(volume->minValue() == other->minValue());
+  TEST_CHECK(volume->maxValue() == 50.0);
+  TEST_CHECK(volume->minValue() == -50.0);
+
+  // Arrays of a different size are refused and left alone
+  size_t smallDims[3] = { 1, 5, 7 };
+  RealVolumeType::Pointer small = RealVolumeType::New(smallDims, "TestArrayMembers Small");
+  small->fill(1.0);
+  TEST_CHECK(volume->axpy(1.0, small) == false);
+  TEST_CHECK(volume->copyFrom(small) == false);
+  TEST_CHECK(volume->maxValue() == 50.0);
+  return failures;
+}
+
+// -----------------------------------------------------------------------------
+//
+// -----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  int failures = 0;
+  TEST_RUN(TestAlignedStorage)
+  TEST_RUN(TestKernelTails)
+  TEST_RUN(TestBlockedRun)
+  TEST_RUN(TestArrayMembers)
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
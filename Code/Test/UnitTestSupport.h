@@ -0,0 +1,69 @@
+/* ============================================================================
+ * Copyright (c) 2011 Michael A. Jackson (BlueQuartz Software)
+ * Copyright (c) 2011 Singanallur Venkatakrishnan (Purdue University)
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ *
+ * Redistributions in binary form must reproduce the above copyright notice, this
+ * list of conditions and the following disclaimer in the documentation and/or
+ * other materials provided with the distribution.
+ *
+ * Neither the name of Singanallur Venkatakrishnan, Michael A. Jackson, the Pudue
+ * Univeristy, BlueQuartz Software nor the names of its contributors may be used
+ * to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *  This code was written under United States Air Force Contract number
+ *                           FA8650-07-D-5800
+ *
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ */
+
+#ifndef _UnitTestSupport_H_
+#define _UnitTestSupport_H_
+
+#include <math.h>
+
+#include <iostream>
+
+/*
+ * Minimal checks for the test executables. Each test returns the number of
+ * failed checks and main() returns the sum, so ctest fails if any check did.
+ */
+
+#define TEST_CHECK(condition)\
+  if(!(condition)) {\
+    std::cout << __FILE__ << "(" << __LINE__ << "): Check failed: " << #condition << std::endl;\
+    failures++;\
+  }
+
+#define TEST_CHECK_CLOSE(value, expected, tolerance)\
+  if(fabs(static_cast<double>(value) - static_cast<double>(expected)) > (tolerance)) {\
+    std::cout << __FILE__ << "(" << __LINE__ << "): " << #value << " = " << (value)\
+              << " expected " << (expected) << std::endl;\
+    failures++;\
+  }
+
+#define TEST_RUN(test)\
+  {\
+    int testFailures = test();\
+    std::cout << #test << ": " << ((testFailures == 0) ? "passed" : "FAILED") << std::endl;\
+    failures += testFailures;\
+  }
+
+#endif /* _UnitTestSupport_H_ */